@@ -0,0 +1,521 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2026 dhpoware. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include <atomic>
+#include <cfloat>
+#include <cstdlib>
+#include <cstring>
+
+#include "batch.h"
+#include "batch_kernels.h"
+
+#if defined(BATCH_KERNELS_X86)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+// The kernels reinterpret arrays of these classes as arrays of floats.
+static_assert(sizeof(Vector3) == 3 * sizeof(float), "Vector3 must be 3 packed floats");
+static_assert(sizeof(Vector3d) == 3 * sizeof(double), "Vector3d must be 3 packed doubles");
+static_assert(sizeof(Matrix4) == 16 * sizeof(float), "Matrix4 must be 16 packed floats");
+static_assert(sizeof(Matrix4d) == 16 * sizeof(double), "Matrix4d must be 16 packed doubles");
+static_assert(sizeof(Plane) == 4 * sizeof(float), "Plane must be 4 packed floats");
+static_assert(sizeof(BoundingBox) == 6 * sizeof(float), "BoundingBox must be 6 packed floats");
+static_assert(sizeof(BoundingSphere) == 4 * sizeof(float), "BoundingSphere must be 4 packed floats");
+static_assert(sizeof(Frustum) == 6 * sizeof(Plane), "Frustum must be 6 packed planes");
+static_assert(sizeof(Vector4) == 4 * sizeof(float), "Vector4 must be 4 packed floats");
+static_assert(sizeof(Ray) == 6 * sizeof(float), "Ray must be 6 packed floats");
+static_assert(Batch::MAX_CULL_FRUSTUMS == BATCH_MAX_CULL_FRUSTUMS, "The kernels must allow as many frustums as Batch");
+
+static std::atomic<const BatchKernels *> g_pBatchKernels(0);
+
+#if defined(BATCH_KERNELS_X86)
+static void cpuid(unsigned int leaf, unsigned int subleaf, unsigned int regs[4])
+{
+#if defined(_MSC_VER)
+    int info[4];
+
+    __cpuidex(info, static_cast<int>(leaf), static_cast<int>(subleaf));
+
+    for (int i = 0; i < 4; ++i)
+        regs[i] = static_cast<unsigned int>(info[i]);
+#else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+static unsigned long long xgetbv0()
+{
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    unsigned int lo = 0, hi = 0;
+
+    __asm__ __volatile__ ("xgetbv" : "=a" (lo), "=d" (hi) : "c" (0));
+    return (static_cast<unsigned long long>(hi) << 32) | lo;
+#endif
+}
+#endif
+
+static Batch::Isa detectIsa()
+{
+    // References:
+    //  Intel 64 and IA-32 Architectures Software Developer's Manual,
+    //  Volume 1, Section 14.3, "Detection of Intel AVX Instructions".
+    //
+    // AVX2 needs more than the CPUID feature bit: the operating system must
+    // also save the YMM registers on a context switch (XCR0 bits 1 and 2).
+
+#if defined(BATCH_KERNELS_X86)
+    unsigned int regs[4];
+
+    cpuid(0, 0, regs);
+
+    unsigned int maxLeaf = regs[0];
+
+    if (maxLeaf < 1)
+        return Batch::ISA_SCALAR;
+
+    cpuid(1, 0, regs);
+
+    bool sse2 = (regs[3] & (1u << 26)) != 0;
+    bool fma = (regs[2] & (1u << 12)) != 0;
+    bool osxsave = (regs[2] & (1u << 27)) != 0;
+    bool avx = (regs[2] & (1u << 28)) != 0;
+
+    if (!sse2)
+        return Batch::ISA_SCALAR;
+
+    if (maxLeaf < 7 || !fma || !osxsave || !avx || (xgetbv0() & 6) != 6)
+        return Batch::ISA_SSE2;
+
+    cpuid(7, 0, regs);
+
+    return (regs[1] & (1u << 5)) ? Batch::ISA_AVX2 : Batch::ISA_SSE2;
+#else
+    return Batch::ISA_SCALAR;
+#endif
+}
+
+static const BatchKernels *kernelsFor(Batch::Isa isa)
+{
+    switch (isa)
+    {
+#if defined(BATCH_KERNELS_X86)
+    case Batch::ISA_AVX2:
+        return &g_batchKernelsAvx2;
+
+    case Batch::ISA_SSE2:
+        return &g_batchKernelsSse2;
+#endif
+
+    default:
+        return &g_batchKernelsScalar;
+    }
+}
+
+static const BatchKernels *kernels()
+{
+    // Picks the kernels on first use. Threads racing here all store the
+    // same pointer, so no further synchronization is needed.
+
+    const BatchKernels *pKernels = g_pBatchKernels.load(std::memory_order_acquire);
+
+    if (!pKernels)
+    {
+        Batch::Isa isa = Batch::supportedIsa();
+        const char *pRequested = getenv("MATHLIB_ISA");
+
+        if (pRequested)
+        {
+            for (int i = Batch::ISA_SCALAR; i <= isa; ++i)
+            {
+                if (strcmp(pRequested, Batch::isaName(static_cast<Batch::Isa>(i))) == 0)
+                {
+                    isa = static_cast<Batch::Isa>(i);
+                    break;
+                }
+            }
+        }
+
+        pKernels = kernelsFor(isa);
+        g_pBatchKernels.store(pKernels, std::memory_order_release);
+    }
+
+    return pKernels;
+}
+
+const BatchKernels *batchKernels()
+{
+    return kernels();
+}
+
+//-----------------------------------------------------------------------------
+// Batch.
+
+void Batch::capsuleIntersectsCapsules(const Capsule &capsule, const CapsuleArrays &capsules, bool *hit, unsigned int count)
+{
+    const float segment[8] =
+    {
+        capsule.a.x, capsule.a.y, capsule.a.z,
+        capsule.b.x - capsule.a.x, capsule.b.y - capsule.a.y, capsule.b.z - capsule.a.z,
+        capsule.radius, 1.0f
+    };
+
+    kernels()->segmentIntersectsCapsules(segment, reinterpret_cast<const float *const *>(&capsules), hit, count);
+}
+
+unsigned int Batch::clipTriangles(const Frustum &frustum, const Vector3 *triangles, unsigned int triangleCount, Vector3 *result, unsigned int maxTriangles, unsigned int *consumed)
+{
+    // The vertices are classified a block of triangles at a time, so the
+    // codes stay in a small local array.
+
+    const unsigned int BLOCK_SIZE = 64;
+    unsigned char codes[BLOCK_SIZE * 3];
+    Vector3 polygon[2][9];
+    unsigned int written = 0;
+    unsigned int done = 0;
+    bool full = false;
+
+    while (done < triangleCount && !full)
+    {
+        unsigned int block = (triangleCount - done < BLOCK_SIZE) ? triangleCount - done : BLOCK_SIZE;
+
+        kernels()->classifyPoints(&frustum.planes[0].n.x, 6, &triangles[done * 3].x, codes, block * 3);
+
+        for (unsigned int i = 0; i < block; ++i)
+        {
+            const Vector3 *triangle = &triangles[(done + i) * 3];
+            unsigned int outside = codes[i * 3] & codes[i * 3 + 1] & codes[i * 3 + 2];
+            unsigned int crossed = codes[i * 3] | codes[i * 3 + 1] | codes[i * 3 + 2];
+
+            if (outside != 0)
+                continue;
+
+            if (crossed == 0)
+            {
+                if (written == maxTriangles)
+                {
+                    full = true;
+                    done += i;
+                    break;
+                }
+
+                result[written * 3 + 0] = triangle[0];
+                result[written * 3 + 1] = triangle[1];
+                result[written * 3 + 2] = triangle[2];
+                ++written;
+                continue;
+            }
+
+            const Vector3 *in = triangle;
+            unsigned int n = 3;
+            unsigned int buffer = 0;
+
+            for (unsigned int p = 0; p < 6 && n >= 3; ++p)
+            {
+                if (crossed & (1u << p))
+                {
+                    n = Plane::clipPolygon(frustum.planes[p], in, n, polygon[buffer]);
+                    in = polygon[buffer];
+                    buffer ^= 1;
+                }
+            }
+
+            if (n < 3)
+                continue;
+
+            if (written + n - 2 > maxTriangles)
+            {
+                full = true;
+                done += i;
+                break;
+            }
+
+            for (unsigned int k = 1; k + 1 < n; ++k, ++written)
+            {
+                result[written * 3 + 0] = in[0];
+                result[written * 3 + 1] = in[k];
+                result[written * 3 + 2] = in[k + 1];
+            }
+        }
+
+        if (!full)
+            done += block;
+    }
+
+    if (consumed)
+        *consumed = done;
+
+    return written;
+}
+
+void Batch::cullBoxes(const Frustum &frustum, const BoundingBox *boxes, bool *visible, unsigned int count)
+{
+    kernels()->cullBoxes(reinterpret_cast<const float *>(frustum.planes),
+        reinterpret_cast<const float *>(boxes), visible, count);
+}
+
+void Batch::cullBoxes(const ConvexVolume &volume, const BoundingBox *boxes, bool *visible, unsigned int count)
+{
+    kernels()->cullBoxesVolume(volume.planeData(), ConvexVolume::MAX_PLANES, volume.planeCount(),
+        reinterpret_cast<const float *>(boxes), visible, count);
+}
+
+bool Batch::cullBoxes(const Frustum *frustums, unsigned int frustumCount, const BoundingBox *boxes, unsigned int *masks, unsigned int count)
+{
+    if (frustumCount > MAX_CULL_FRUSTUMS)
+        return false;
+
+    kernels()->cullBoxesMulti(reinterpret_cast<const float *>(frustums), frustumCount,
+        reinterpret_cast<const float *>(boxes), masks, count);
+    return true;
+}
+
+void Batch::cullBoxesClipSpace(const Matrix4 *mvpMatrices, const BoundingBox *boxes, bool *visible, unsigned int count)
+{
+    kernels()->cullBoxesClipSpace(reinterpret_cast<const float *>(mvpMatrices),
+        reinterpret_cast<const float *>(boxes), 6, visible, count);
+}
+
+void Batch::cullBoxesClipSpace(const Matrix4 *mvpMatrices, const BoundingBox &box, bool *visible, unsigned int count)
+{
+    kernels()->cullBoxesClipSpace(reinterpret_cast<const float *>(mvpMatrices),
+        reinterpret_cast<const float *>(&box), 0, visible, count);
+}
+
+void Batch::cullCapsules(const Frustum &frustum, const CapsuleArrays &capsules, bool *visible, unsigned int count)
+{
+    kernels()->cullCapsules(reinterpret_cast<const float *>(frustum.planes),
+        reinterpret_cast<const float *const *>(&capsules), visible, count);
+}
+
+void Batch::cullSpheres(const ConvexVolume &volume, const BoundingSphere *spheres, bool *visible, unsigned int count)
+{
+    kernels()->cullSpheresVolume(volume.planeData(), ConvexVolume::MAX_PLANES, volume.planeCount(),
+        reinterpret_cast<const float *>(spheres), visible, count);
+}
+
+bool Batch::cullSpheres(const Frustum *frustums, unsigned int frustumCount, const BoundingSphere *spheres, unsigned int *masks, unsigned int count)
+{
+    if (frustumCount > MAX_CULL_FRUSTUMS)
+        return false;
+
+    kernels()->cullSpheresMulti(reinterpret_cast<const float *>(frustums), frustumCount,
+        reinterpret_cast<const float *>(spheres), masks, count);
+    return true;
+}
+
+Batch::Isa Batch::isa()
+{
+    const BatchKernels *pKernels = kernels();
+
+#if defined(BATCH_KERNELS_X86)
+    if (pKernels == &g_batchKernelsAvx2)
+        return ISA_AVX2;
+
+    if (pKernels == &g_batchKernelsSse2)
+        return ISA_SSE2;
+#endif
+
+    (void)pKernels;
+    return ISA_SCALAR;
+}
+
+const char *Batch::isaName(Isa isa)
+{
+    switch (isa)
+    {
+    case ISA_SCALAR:
+        return "scalar";
+
+    case ISA_SSE2:
+        return "sse2";
+
+    case ISA_AVX2:
+        return "avx2";
+
+    default:
+        return "unknown";
+    }
+}
+
+void Batch::multiply(const Matrix4 *lhs, const Matrix4 *rhs, Matrix4 *result, unsigned int count)
+{
+    kernels()->multiply(reinterpret_cast<const float *>(lhs),
+        reinterpret_cast<const float *>(rhs),
+        reinterpret_cast<float *>(result), count);
+}
+
+void Batch::multiply(const Matrix4d *lhs, const Matrix4d *rhs, Matrix4d *result, unsigned int count)
+{
+    kernels()->multiplyDoubles(reinterpret_cast<const double *>(lhs),
+        reinterpret_cast<const double *>(rhs),
+        reinterpret_cast<double *>(result), count);
+}
+
+void Batch::projectBoxes(const Matrix4 &viewProjMatrix, const BoundingBox *boxes, Vector4 *rects, float *depths, unsigned int count)
+{
+    kernels()->projectBoxes(&viewProjMatrix[0][0], reinterpret_cast<const float *>(boxes),
+        reinterpret_cast<float *>(rects), depths, count);
+}
+
+void Batch::projectSpheres(const Matrix4 &viewMatrix, const Matrix4 &projMatrix, const BoundingSphere *spheres, float *depths, float *radii, unsigned int count)
+{
+    kernels()->projectSpheres(&viewMatrix[0][0], projMatrix[1][1],
+        reinterpret_cast<const float *>(spheres), depths, radii, count);
+}
+
+void Batch::rayIntersectsBoxes(const Ray &ray, const BoundingBox *boxes, bool *hit, unsigned int count)
+{
+    kernels()->rayIntersectsBoxes(reinterpret_cast<const float *>(&ray),
+        reinterpret_cast<const float *>(boxes), hit, count);
+}
+
+void Batch::rayIntersectsCapsules(const Ray &ray, const CapsuleArrays &capsules, bool *hit, unsigned int count)
+{
+    const float segment[8] =
+    {
+        ray.origin.x, ray.origin.y, ray.origin.z,
+        ray.direction.x, ray.direction.y, ray.direction.z,
+        0.0f, FLT_MAX
+    };
+
+    kernels()->segmentIntersectsCapsules(segment, reinterpret_cast<const float *const *>(&capsules), hit, count);
+}
+
+void Batch::rebaseMatrices(const Vector3d &origin, const Matrix4 *matrices, const Vector3d *positions, Matrix4 *result, unsigned int count)
+{
+    kernels()->rebaseMatrices(&origin.x, reinterpret_cast<const float *>(matrices),
+        reinterpret_cast<const double *>(positions),
+        reinterpret_cast<float *>(result), count);
+}
+
+void Batch::rebasePoints(const Vector3d &origin, const Vector3d *points, Vector3 *result, unsigned int count)
+{
+    kernels()->rebasePoints(&origin.x, reinterpret_cast<const double *>(points),
+        reinterpret_cast<float *>(result), count);
+}
+
+void Batch::selectLods(const float *sizes, const float *thresholds, unsigned int thresholdCount, unsigned int *lods, unsigned int count)
+{
+    kernels()->selectLods(sizes, thresholds, thresholdCount, lods, count);
+}
+
+bool Batch::setIsa(Isa isa)
+{
+    if (isa < ISA_SCALAR || isa > supportedIsa())
+        return false;
+
+    g_pBatchKernels.store(kernelsFor(isa), std::memory_order_release);
+    return true;
+}
+
+void Batch::sphereIntersectsCapsules(const BoundingSphere &sphere, const CapsuleArrays &capsules, bool *hit, unsigned int count)
+{
+    const float segment[8] =
+    {
+        sphere.center.x, sphere.center.y, sphere.center.z,
+        0.0f, 0.0f, 0.0f,
+        sphere.radius, 0.0f
+    };
+
+    kernels()->segmentIntersectsCapsules(segment, reinterpret_cast<const float *const *>(&capsules), hit, count);
+}
+
+Batch::Isa Batch::supportedIsa()
+{
+    static const Isa supported = detectIsa();
+    return supported;
+}
+
+void Batch::sweepBoxes(const BoundingBox &box, const BoundingBox *boxes, const Vector3 *velocities, float *times, Vector3 *normals, unsigned int count)
+{
+    kernels()->sweepBoxesBox(&box.min.x, reinterpret_cast<const float *>(boxes),
+        reinterpret_cast<const float *>(velocities), times, count);
+
+    if (!normals)
+        return;
+
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        if (times[i] == FLT_MAX)
+            continue;
+
+        Vector3 offset = velocities[i] * times[i];
+        normals[i] = Sweep::contactNormal(BoundingBox(boxes[i].min + offset, boxes[i].max + offset), box);
+    }
+}
+
+void Batch::sweepSpheres(const Plane &plane, const BoundingSphere *spheres, const Vector3 *velocities, float *times, Vector3 *normals, unsigned int count)
+{
+    kernels()->sweepSpheresPlane(&plane.n.x, reinterpret_cast<const float *>(spheres),
+        reinterpret_cast<const float *>(velocities), times, count);
+
+    if (!normals)
+        return;
+
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        if (times[i] != FLT_MAX)
+            normals[i] = Sweep::contactNormal(BoundingSphere(spheres[i].center + velocities[i] * times[i], spheres[i].radius), plane);
+    }
+}
+
+void Batch::sweepSpheres(const BoundingSphere &sphere, const BoundingSphere *spheres, const Vector3 *velocities, float *times, Vector3 *normals, unsigned int count)
+{
+    kernels()->sweepSpheresSphere(&sphere.center.x, reinterpret_cast<const float *>(spheres),
+        reinterpret_cast<const float *>(velocities), times, count);
+
+    if (!normals)
+        return;
+
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        if (times[i] != FLT_MAX)
+            normals[i] = Sweep::contactNormal(BoundingSphere(spheres[i].center + velocities[i] * times[i], spheres[i].radius), sphere);
+    }
+}
+
+void Batch::sweepSpheres(const BoundingBox &box, const BoundingSphere *spheres, const Vector3 *velocities, float *times, Vector3 *normals, unsigned int count)
+{
+    kernels()->sweepSpheresBox(&box.min.x, reinterpret_cast<const float *>(spheres),
+        reinterpret_cast<const float *>(velocities), times, count);
+
+    if (!normals)
+        return;
+
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        if (times[i] != FLT_MAX)
+            normals[i] = Sweep::contactNormal(BoundingSphere(spheres[i].center + velocities[i] * times[i], spheres[i].radius), box);
+    }
+}
+
+void Batch::transformPoints(const Matrix4 &m, const Vector3 *points, Vector3 *result, unsigned int count)
+{
+    kernels()->transformPoints(&m[0][0], reinterpret_cast<const float *>(points),
+        reinterpret_cast<float *>(result), count);
+}
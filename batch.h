@@ -0,0 +1,194 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2026 dhpoware. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#if !defined(BATCH_H)
+#define BATCH_H
+
+#include "mathlib.h"
+#include "collision.h"
+
+//-----------------------------------------------------------------------------
+// The Batch utility class runs the library's hot operations over arrays:
+// matrix multiplication, point transformation, frustum culling of bounding
+// boxes, spheres and capsules, screen space projection for LOD selection,
+// ray vs bounding box tests, capsule queries, swept sphere and box queries,
+// and rebasing of double precision world positions onto a local origin.
+//
+// Each operation is compiled several times for different instruction sets
+// (ISAs). The fastest variant the CPU supports is chosen the first time a
+// batch function is called, so the same binary runs AVX2 code on machines
+// that support it and SSE2 code elsewhere. Setting the MATHLIB_ISA
+// environment variable to "scalar", "sse2" or "avx2" picks a different
+// variant, provided the CPU supports it. setIsa() does the same at run time
+// and returns false if the CPU doesn't support the requested variant.
+//
+// multiply() computes result[i] = lhs[i] * rhs[i]. 'result' may be the same
+// array as 'lhs' or 'rhs'. The Matrix4d version is the AVX path for double
+// precision matrix products: a row of a Matrix4d is one AVX register.
+//
+// transformPoints() transforms each point by 'm' as a position (w = 1), so
+// unlike Vector3 * Matrix4 the translation in row 3 of 'm' is applied. The
+// fourth column of 'm' is ignored. 'result' may be the same array as
+// 'points'.
+//
+// cullBoxes() sets visible[i] to the result of frustum.boxInFrustum(boxes[i]).
+// The ConvexVolume versions of cullBoxes() and cullSpheres() do the same for
+// volume.boxInVolume() and sphereInVolume().
+//
+// cullBoxesClipSpace() culls object space boxes against the clip volume of
+// each instance's model-view-projection matrix (mvpMatrices[i], the model
+// matrix times the view-projection matrix), without computing world space
+// boxes or frustum planes. The box center and half extents are transformed
+// to clip space and visible[i] is set unless the result is outside one of
+// the planes -w <= x, y, z <= w of an OpenGL style projection. Like
+// boxInFrustum(), it may report boxes near the corners of the view volume
+// as visible. The second version tests one box shared by all instances.
+//
+// The multi-frustum versions of cullBoxes() and cullSpheres() test every
+// object against up to MAX_CULL_FRUSTUMS frustums in one pass, e.g., the
+// main camera, the shadow cascades and the faces of point light shadow
+// maps. Each object is loaded once instead of once per frustum. Bit f of
+// masks[i] is set if object i is inside frustums[f] (boxInFrustum() or
+// sphereInFrustum()). They return false, and do nothing, if frustumCount is
+// greater than MAX_CULL_FRUSTUMS.
+//
+// The capsule functions take the capsules as a structure of arrays
+// (CapsuleArrays): one array per coordinate of the segment ends and one
+// for the radii, all 'count' long. Each lane of the SIMD variants then
+// loads its capsule with plain vector loads, which suits a crowd of
+// characters whose capsules are updated every frame. cullCapsules() sets
+// visible[i] to the result of frustum.capsuleInFrustum() for capsule i.
+// capsuleIntersectsCapsules(), sphereIntersectsCapsules() and
+// rayIntersectsCapsules() set hit[i] to whether capsule i touches the
+// given capsule, sphere or ray, by the distance between their closest
+// points as in Capsule::hasCollided().
+//
+// clipTriangles() clips a stream of triangles (3 vertices each) to the
+// frustum and writes the pieces to 'result' as triangles, and returns how
+// many it wrote. Each triangle's vertices are classified against the 6
+// planes in one pass; triangles inside every plane are copied, triangles
+// behind any one plane are dropped, and the rest are clipped, only against
+// the planes they cross, with Plane::clipPolygon() and split into a fan.
+// One triangle can become up to 7. When the next triangle's pieces don't
+// fit in 'maxTriangles', clipping stops there, and '*consumed' (if not
+// null) is set to the number of input triangles done, so the rest can be
+// clipped into a new buffer.
+//
+// projectSpheres() and projectBoxes() estimate how large objects appear on
+// screen, e.g., to pick their level of detail. projectSpheres() sets
+// depths[i] to the view space depth of the sphere's center (its distance in
+// front of the camera) and radii[i] to its projected radius in normalized
+// device units (1 is half the height of the viewport), computed from
+// projMatrix[1][1]. Spheres that reach the camera plane get the largest
+// float as their radius. projectBoxes() sets rects[i] to the normalized
+// device rectangle of the box (min x, min y, max x, max y in x, y, z, w) and
+// depths[i] to the smallest clip space w of its corners, which is the depth
+// of its nearest corner for a perspective projection. Boxes that reach the
+// camera plane cover the whole screen, from -1 to 1.
+//
+// selectLods() sets lods[i] to the number of object i's thresholds that
+// sizes[i] is below. Each object has 'thresholdCount' thresholds, stored one
+// object after another in decreasing order, so lods[i] is the index of the
+// first threshold that the object reaches (0 for the most detailed level).
+//
+// rayIntersectsBoxes() sets hit[i] to the result of ray.hasIntersected(boxes[i]).
+// The batch version uses the slab test, so the two may disagree for rays that
+// only graze the edge of a box.
+//
+// rebasePoints() sets result[i] to points[i] - origin. The subtraction is done
+// in double precision and only the difference is rounded to float, so the
+// result keeps full float precision near the origin however far the points
+// are from the world origin. Rebasing an array of BoundingBoxd as 2 * count
+// points yields the matching BoundingBox array.
+//
+// rebaseMatrices() sets result[i] to matrices[i] followed by a translation
+// by positions[i] - origin. The matrices hold each object's rotation, scale
+// and any small local offset, and the positions place the objects in the
+// world. Only the translation in row 3 changes, and it is summed in double
+// precision. 'result' may be the same array as 'matrices'. See
+// CameraRelativeView for how this fits together with culling.
+//
+// sweepSpheres() and sweepBoxes() move each sphere or box by velocities[i]
+// over one time step against a single static plane, sphere or box, e.g., a
+// volley of projectiles against an obstacle, and set times[i] to the time
+// of impact in [0, 1] as in Sweep::timeOfImpact(), or to FLT_MAX if the
+// shapes don't meet. normals[i] is set to the contact normal for each hit
+// and left unchanged for a miss; 'normals' may be null when only the times
+// are needed. The normals are computed by Sweep::contactNormal() on the
+// shapes moved to the time of impact, after the times of the whole batch.
+//
+// The variants may differ in the last bits of their results because the AVX2
+// variant uses fused multiply-add.
+
+class Batch
+{
+public:
+    enum Isa
+    {
+        ISA_SCALAR = 0,
+        ISA_SSE2   = 1,
+        ISA_AVX2   = 2
+    };
+
+    static const unsigned int MAX_CULL_FRUSTUMS = 32;
+
+    struct CapsuleArrays
+    {
+        const float *ax, *ay, *az;
+        const float *bx, *by, *bz;
+        const float *radius;
+    };
+
+    static void capsuleIntersectsCapsules(const Capsule &capsule, const CapsuleArrays &capsules, bool *hit, unsigned int count);
+    static unsigned int clipTriangles(const Frustum &frustum, const Vector3 *triangles, unsigned int triangleCount, Vector3 *result, unsigned int maxTriangles, unsigned int *consumed);
+    static void cullBoxes(const Frustum &frustum, const BoundingBox *boxes, bool *visible, unsigned int count);
+    static bool cullBoxes(const Frustum *frustums, unsigned int frustumCount, const BoundingBox *boxes, unsigned int *masks, unsigned int count);
+    static void cullBoxes(const ConvexVolume &volume, const BoundingBox *boxes, bool *visible, unsigned int count);
+    static void cullBoxesClipSpace(const Matrix4 *mvpMatrices, const BoundingBox *boxes, bool *visible, unsigned int count);
+    static void cullBoxesClipSpace(const Matrix4 *mvpMatrices, const BoundingBox &box, bool *visible, unsigned int count);
+    static void cullCapsules(const Frustum &frustum, const CapsuleArrays &capsules, bool *visible, unsigned int count);
+    static void cullSpheres(const ConvexVolume &volume, const BoundingSphere *spheres, bool *visible, unsigned int count);
+    static bool cullSpheres(const Frustum *frustums, unsigned int frustumCount, const BoundingSphere *spheres, unsigned int *masks, unsigned int count);
+    static Isa isa();
+    static const char *isaName(Isa isa);
+    static void multiply(const Matrix4 *lhs, const Matrix4 *rhs, Matrix4 *result, unsigned int count);
+    static void multiply(const Matrix4d *lhs, const Matrix4d *rhs, Matrix4d *result, unsigned int count);
+    static void projectBoxes(const Matrix4 &viewProjMatrix, const BoundingBox *boxes, Vector4 *rects, float *depths, unsigned int count);
+    static void projectSpheres(const Matrix4 &viewMatrix, const Matrix4 &projMatrix, const BoundingSphere *spheres, float *depths, float *radii, unsigned int count);
+    static void rayIntersectsBoxes(const Ray &ray, const BoundingBox *boxes, bool *hit, unsigned int count);
+    static void rayIntersectsCapsules(const Ray &ray, const CapsuleArrays &capsules, bool *hit, unsigned int count);
+    static void rebaseMatrices(const Vector3d &origin, const Matrix4 *matrices, const Vector3d *positions, Matrix4 *result, unsigned int count);
+    static void rebasePoints(const Vector3d &origin, const Vector3d *points, Vector3 *result, unsigned int count);
+    static void selectLods(const float *sizes, const float *thresholds, unsigned int thresholdCount, unsigned int *lods, unsigned int count);
+    static bool setIsa(Isa isa);
+    static void sphereIntersectsCapsules(const BoundingSphere &sphere, const CapsuleArrays &capsules, bool *hit, unsigned int count);
+    static Isa supportedIsa();
+    static void sweepBoxes(const BoundingBox &box, const BoundingBox *boxes, const Vector3 *velocities, float *times, Vector3 *normals, unsigned int count);
+    static void sweepSpheres(const Plane &plane, const BoundingSphere *spheres, const Vector3 *velocities, float *times, Vector3 *normals, unsigned int count);
+    static void sweepSpheres(const BoundingSphere &sphere, const BoundingSphere *spheres, const Vector3 *velocities, float *times, Vector3 *normals, unsigned int count);
+    static void sweepSpheres(const BoundingBox &box, const BoundingSphere *spheres, const Vector3 *velocities, float *times, Vector3 *normals, unsigned int count);
+    static void transformPoints(const Matrix4 &m, const Vector3 *points, Vector3 *result, unsigned int count);
+};
+
+//-----------------------------------------------------------------------------
+
+#endif
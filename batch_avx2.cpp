@@ -0,0 +1,39 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2026 dhpoware. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+// AVX2 kernels. This file must be compiled with AVX2 and FMA enabled
+// (-mavx2 -mfma, or /arch:AVX2 with MSVC). Nothing else in the library may
+// be compiled with those flags unless the whole program requires AVX2.
+
+#include "batch_kernels.h"
+
+#if defined(BATCH_KERNELS_X86)
+
+#if !defined(__AVX2__) || !(defined(__FMA__) || defined(_MSC_VER))
+#error batch_avx2.cpp must be compiled with AVX2 and FMA enabled
+#endif
+
+#define BATCH_KERNELS_AVX2
+#define BATCH_KERNELS_TABLE g_batchKernelsAvx2
+#include "batch_kernels.inl"
+
+#endif
@@ -0,0 +1,107 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2026 dhpoware. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#if !defined(BATCH_KERNELS_H)
+#define BATCH_KERNELS_H
+
+//-----------------------------------------------------------------------------
+// Internal interface between the Batch class and its per instruction set
+// kernels. The kernels are compiled several times with different compiler
+// flags (batch_scalar.cpp, batch_sse2.cpp and batch_avx2.cpp), so they work
+// on raw float arrays and don't include mathlib.h. Otherwise an inline
+// function from mathlib.h compiled with AVX2 enabled could be picked by the
+// linker for the rest of the program.
+//
+// Data layouts:
+//  matrix  16 floats, row major
+//  dmatrix 16 doubles, row major
+//  point   3 floats (x, y, z)
+//  box     6 floats (min x, y, z, max x, y, z)
+//  sphere  4 floats (center x, y, z, radius)
+//  plane   4 floats (a, b, c, d)
+//  frustum 6 planes (24 floats)
+//  volume  4 rows of planeStride floats: the a, b, c and d of each plane
+//  rect    4 floats (min x, y, max x, y)
+//  ray     6 floats (origin x, y, z, direction x, y, z)
+//  dpoint  3 doubles (x, y, z), for world space origins and positions
+//  capsules 7 arrays of count floats: a x, y, z, b x, y, z and radius
+//  segment 8 floats (start x, y, z, direction x, y, z, radius, t max)
+//  velocity 3 floats (x, y, z), the motion over a time step
+//  time    1 float, 0 when the shapes start overlapping and 3.402823466e+38
+//          (FLT_MAX) when they don't meet during the time step
+
+// BATCH_KERNELS_X86 is defined when the SSE2 and AVX2 kernels are built. It
+// depends only on the target architecture, not on the instruction set the
+// rest of the program is compiled for, so that a baseline build can still
+// use the faster kernels when the CPU supports them.
+
+#if !defined(MATHLIB_NO_SIMD) && (defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86))
+#define BATCH_KERNELS_X86
+#endif
+
+// The most frustums passed to the multi-frustum kernels at once
+// (Batch::MAX_CULL_FRUSTUMS).
+static const unsigned int BATCH_MAX_CULL_FRUSTUMS = 32;
+
+struct BatchKernels
+{
+    void (*multiply)(const float *lhs, const float *rhs, float *result, unsigned int count);
+    void (*multiplyDoubles)(const double *lhs, const double *rhs, double *result, unsigned int count);
+    void (*transformPoints)(const float *m, const float *points, float *result, unsigned int count);
+    void (*cullBoxes)(const float *planes, const float *boxes, bool *visible, unsigned int count);
+    void (*cullBoxesClipSpace)(const float *matrices, const float *boxes, unsigned int boxStride, bool *visible, unsigned int count);
+    void (*cullBoxesMulti)(const float *frustums, unsigned int frustumCount, const float *boxes, unsigned int *masks, unsigned int count);
+    void (*cullSpheresMulti)(const float *frustums, unsigned int frustumCount, const float *spheres, unsigned int *masks, unsigned int count);
+    void (*cullBoxesVolume)(const float *planes, unsigned int planeStride, unsigned int planeCount, const float *boxes, bool *visible, unsigned int count);
+    void (*cullSpheresVolume)(const float *planes, unsigned int planeStride, unsigned int planeCount, const float *spheres, bool *visible, unsigned int count);
+    void (*classifyPoints)(const float *planes, unsigned int planeCount, const float *points, unsigned char *codes, unsigned int count);
+    void (*projectBoxes)(const float *m, const float *boxes, float *rects, float *depths, unsigned int count);
+    void (*projectSpheres)(const float *view, float projScale, const float *spheres, float *depths, float *radii, unsigned int count);
+    void (*selectLods)(const float *sizes, const float *thresholds, unsigned int thresholdCount, unsigned int *lods, unsigned int count);
+    void (*rayIntersectsBoxes)(const float *ray, const float *boxes, bool *hit, unsigned int count);
+    void (*rebasePoints)(const double *origin, const double *points, float *result, unsigned int count);
+    void (*rebaseMatrices)(const double *origin, const float *matrices, const double *positions, float *result, unsigned int count);
+    void (*cullCapsules)(const float *planes, const float *const *capsules, bool *visible, unsigned int count);
+    void (*segmentIntersectsCapsules)(const float *segment, const float *const *capsules, bool *hit, unsigned int count);
+    void (*sweepSpheresPlane)(const float *plane, const float *spheres, const float *velocities, float *times, unsigned int count);
+    void (*sweepSpheresSphere)(const float *sphere, const float *spheres, const float *velocities, float *times, unsigned int count);
+    void (*sweepSpheresBox)(const float *box, const float *spheres, const float *velocities, float *times, unsigned int count);
+    void (*sweepBoxesBox)(const float *box, const float *boxes, const float *velocities, float *times, unsigned int count);
+    void (*fastAcos)(const float *x, float *result, unsigned int count);
+    void (*fastAtan2)(const float *y, const float *x, float *result, unsigned int count);
+    void (*fastCos)(const float *x, float *result, unsigned int count);
+    void (*fastExp)(const float *x, float *result, unsigned int count);
+    void (*fastLog)(const float *x, float *result, unsigned int count);
+    void (*fastRsqrt)(const float *x, float *result, unsigned int count);
+    void (*fastSin)(const float *x, float *result, unsigned int count);
+    void (*fastSinCos)(const float *x, float *s, float *c, unsigned int count);
+};
+
+extern const BatchKernels g_batchKernelsScalar;
+extern const BatchKernels g_batchKernelsSse2;
+extern const BatchKernels g_batchKernelsAvx2;
+
+// Returns the kernels the Batch class uses, picking them on first use. The
+// fast math entries are null in the scalar table (see batch_kernels.inl).
+const BatchKernels *batchKernels();
+
+#endif
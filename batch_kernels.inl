@@ -0,0 +1,3056 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2026 dhpoware. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Batch kernel implementations. This file is included by batch_scalar.cpp,
+// batch_sse2.cpp and batch_avx2.cpp. Each of those defines
+// BATCH_KERNELS_TABLE (the name of its BatchKernels table) and one of
+// BATCH_KERNELS_SCALAR, BATCH_KERNELS_SSE2 or BATCH_KERNELS_AVX2 before
+// including it, and is compiled with the matching instruction set enabled.
+//
+// Every variant computes the same results up to floating point rounding.
+// The AVX2 variant uses fused multiply-add. The rebasing kernels round only
+// once, so their results are the same in every variant. Rebasing a matrix
+// is bound by memory traffic, so the AVX2 table reuses the SSE2 kernel for
+// it.
+
+#include <cmath>
+#include <cstring>
+
+#if defined(BATCH_KERNELS_SSE2) || defined(BATCH_KERNELS_AVX2)
+#include <emmintrin.h>
+#endif
+
+#if defined(BATCH_KERNELS_AVX2)
+#include <immintrin.h>
+#endif
+
+#include "batch_kernels.h"
+
+// Segments with a squared length below this are treated as points, as in
+// Capsule::closestPoints().
+static const float SEGMENT_EPSILON = 1e-12f;
+
+// The time of impact written for shapes that don't touch during the step.
+static const float SWEEP_MISS = 3.402823466e+38f;
+
+static inline float clampUnit(float x)
+{
+    return (x < 0.0f) ? 0.0f : ((x > 1.0f) ? 1.0f : x);
+}
+
+//-----------------------------------------------------------------------------
+// Scalar kernels. Culling and ray tests also finish off the remainders of the
+// SIMD kernels.
+
+#if defined(BATCH_KERNELS_SCALAR)
+
+static void multiplyScalar(const float *lhs, const float *rhs, float *result, unsigned int count)
+{
+    for (unsigned int n = 0; n < count; ++n, lhs += 16, rhs += 16, result += 16)
+    {
+        float tmp[16];
+
+        for (int i = 0; i < 4; ++i)
+        {
+            for (int j = 0; j < 4; ++j)
+            {
+                tmp[i * 4 + j] = lhs[i * 4 + 0] * rhs[j]
+                    + lhs[i * 4 + 1] * rhs[4 + j]
+                    + lhs[i * 4 + 2] * rhs[8 + j]
+                    + lhs[i * 4 + 3] * rhs[12 + j];
+            }
+        }
+
+        memcpy(result, tmp, sizeof(tmp));
+    }
+}
+
+static void multiplyDoublesScalar(const double *lhs, const double *rhs, double *result, unsigned int count)
+{
+    for (unsigned int n = 0; n < count; ++n, lhs += 16, rhs += 16, result += 16)
+    {
+        double tmp[16];
+
+        for (int i = 0; i < 4; ++i)
+        {
+            for (int j = 0; j < 4; ++j)
+            {
+                tmp[i * 4 + j] = lhs[i * 4 + 0] * rhs[j]
+                    + lhs[i * 4 + 1] * rhs[4 + j]
+                    + lhs[i * 4 + 2] * rhs[8 + j]
+                    + lhs[i * 4 + 3] * rhs[12 + j];
+            }
+        }
+
+        memcpy(result, tmp, sizeof(tmp));
+    }
+}
+
+static void transformPointsScalar(const float *m, const float *points, float *result, unsigned int count)
+{
+    for (unsigned int n = 0; n < count; ++n, points += 3, result += 3)
+    {
+        float x = points[0], y = points[1], z = points[2];
+
+        result[0] = x * m[0] + y * m[4] + z * m[8] + m[12];
+        result[1] = x * m[1] + y * m[5] + z * m[9] + m[13];
+        result[2] = x * m[2] + y * m[6] + z * m[10] + m[14];
+    }
+}
+
+static void rebasePointsScalar(const double *origin, const double *points, float *result, unsigned int count)
+{
+    for (unsigned int n = 0; n < count; ++n, points += 3, result += 3)
+    {
+        result[0] = static_cast<float>(points[0] - origin[0]);
+        result[1] = static_cast<float>(points[1] - origin[1]);
+        result[2] = static_cast<float>(points[2] - origin[2]);
+    }
+}
+
+static void rebaseMatricesScalar(const double *origin, const float *matrices, const double *positions, float *result, unsigned int count)
+{
+    for (unsigned int n = 0; n < count; ++n, matrices += 16, positions += 3, result += 16)
+    {
+        double x = matrices[12] + (positions[0] - origin[0]);
+        double y = matrices[13] + (positions[1] - origin[1]);
+        double z = matrices[14] + (positions[2] - origin[2]);
+
+        for (int i = 0; i < 12; ++i)
+            result[i] = matrices[i];
+
+        result[12] = static_cast<float>(x);
+        result[13] = static_cast<float>(y);
+        result[14] = static_cast<float>(z);
+        result[15] = matrices[15];
+    }
+}
+
+static void cullBoxesClipSpaceScalar(const float *matrices, const float *boxes, unsigned int boxStride, bool *visible, unsigned int count)
+{
+    // The box center c and half extents e are transformed to clip space as
+    // c * M and e * |M| (e is transformed by the absolute values of M's
+    // rows). The clip space box then bounds every point of the box, and
+    // with W = c.w + e.w bounding w from above, the box is outside the clip
+    // volume -w <= x, y, z <= w if c + e <= -W or c - e >= W on any
+    // axis. The box stride is 0 when every instance shares the box.
+
+    for (unsigned int n = 0; n < count; ++n, matrices += 16, boxes += boxStride)
+    {
+        const float *m = matrices;
+        float cx = (boxes[0] + boxes[3]) * 0.5f, ex = (boxes[3] - boxes[0]) * 0.5f;
+        float cy = (boxes[1] + boxes[4]) * 0.5f, ey = (boxes[4] - boxes[1]) * 0.5f;
+        float cz = (boxes[2] + boxes[5]) * 0.5f, ez = (boxes[5] - boxes[2]) * 0.5f;
+        float c[4], e[4];
+
+        for (int k = 0; k < 4; ++k)
+        {
+            c[k] = cx * m[k] + cy * m[4 + k] + cz * m[8 + k] + m[12 + k];
+            e[k] = ex * fabsf(m[k]) + ey * fabsf(m[4 + k]) + ez * fabsf(m[8 + k]);
+        }
+
+        float w = c[3] + e[3];
+        bool inside = true;
+
+        for (int k = 0; k < 3; ++k)
+            inside = inside && c[k] + e[k] + w > 0.0f && w + e[k] - c[k] > 0.0f;
+
+        visible[n] = inside;
+    }
+}
+
+#endif
+
+static void cullBoxesScalar(const float *planes, const float *boxes, bool *visible, unsigned int count)
+{
+    // A box is outside the frustum if its corner furthest along a plane's
+    // normal (the positive vertex) is behind that plane.
+
+    for (unsigned int n = 0; n < count; ++n, boxes += 6)
+    {
+        bool inside = true;
+
+        for (int i = 0; i < 6 && inside; ++i)
+        {
+            const float *p = planes + i * 4;
+            float x = boxes[(p[0] > 0.0f) ? 3 : 0];
+            float y = boxes[(p[1] > 0.0f) ? 4 : 1];
+            float z = boxes[(p[2] > 0.0f) ? 5 : 2];
+
+            inside = p[0] * x + p[1] * y + p[2] * z + p[3] > 0.0f;
+        }
+
+        visible[n] = inside;
+    }
+}
+
+static void cullBoxesMultiScalar(const float *frustums, unsigned int frustumCount, const float *boxes, unsigned int *masks, unsigned int count)
+{
+    // Each box is read once and tested against every frustum (24 floats,
+    // 6 planes each). Bit f of the mask is set if the box is inside
+    // frustum f.
+
+    for (unsigned int n = 0; n < count; ++n, boxes += 6)
+    {
+        unsigned int mask = 0;
+
+        for (unsigned int f = 0; f < frustumCount; ++f)
+        {
+            bool inside = true;
+
+            for (int i = 0; i < 6 && inside; ++i)
+            {
+                const float *p = frustums + f * 24 + i * 4;
+                float x = boxes[(p[0] > 0.0f) ? 3 : 0];
+                float y = boxes[(p[1] > 0.0f) ? 4 : 1];
+                float z = boxes[(p[2] > 0.0f) ? 5 : 2];
+
+                inside = p[0] * x + p[1] * y + p[2] * z + p[3] > 0.0f;
+            }
+
+            mask |= static_cast<unsigned int>(inside) << f;
+        }
+
+        masks[n] = mask;
+    }
+}
+
+static void cullSpheresMultiScalar(const float *frustums, unsigned int frustumCount, const float *spheres, unsigned int *masks, unsigned int count)
+{
+    // A sphere is outside a frustum if its center is at least its radius
+    // behind one of the planes.
+
+    for (unsigned int n = 0; n < count; ++n, spheres += 4)
+    {
+        unsigned int mask = 0;
+
+        for (unsigned int f = 0; f < frustumCount; ++f)
+        {
+            bool inside = true;
+
+            for (int i = 0; i < 6 && inside; ++i)
+            {
+                const float *p = frustums + f * 24 + i * 4;
+                inside = p[0] * spheres[0] + p[1] * spheres[1] + p[2] * spheres[2] + p[3] > -spheres[3];
+            }
+
+            mask |= static_cast<unsigned int>(inside) << f;
+        }
+
+        masks[n] = mask;
+    }
+}
+
+static void cullBoxesVolumeScalar(const float *planes, unsigned int planeStride, unsigned int planeCount, const float *boxes, bool *visible, unsigned int count)
+{
+    // Tests each box against the planes of a volume, stored as rows of a's,
+    // b's, c's and d's 'planeStride' floats apart, with the positive vertex
+    // test of cullBoxesScalar().
+
+    const float *a = planes;
+    const float *b = planes + planeStride;
+    const float *c = planes + 2 * planeStride;
+    const float *d = planes + 3 * planeStride;
+
+    for (unsigned int n = 0; n < count; ++n, boxes += 6)
+    {
+        bool inside = true;
+
+        for (unsigned int i = 0; i < planeCount && inside; ++i)
+        {
+            float x = boxes[(a[i] > 0.0f) ? 3 : 0];
+            float y = boxes[(b[i] > 0.0f) ? 4 : 1];
+            float z = boxes[(c[i] > 0.0f) ? 5 : 2];
+
+            inside = a[i] * x + d[i] + b[i] * y + c[i] * z > 0.0f;
+        }
+
+        visible[n] = inside;
+    }
+}
+
+static void cullSpheresVolumeScalar(const float *planes, unsigned int planeStride, unsigned int planeCount, const float *spheres, bool *visible, unsigned int count)
+{
+    const float *a = planes;
+    const float *b = planes + planeStride;
+    const float *c = planes + 2 * planeStride;
+    const float *d = planes + 3 * planeStride;
+
+    for (unsigned int n = 0; n < count; ++n, spheres += 4)
+    {
+        bool inside = true;
+
+        for (unsigned int i = 0; i < planeCount && inside; ++i)
+            inside = a[i] * spheres[0] + d[i] + b[i] * spheres[1] + c[i] * spheres[2] > -spheres[3];
+
+        visible[n] = inside;
+    }
+}
+
+static void classifyPointsScalar(const float *planes, unsigned int planeCount, const float *points, unsigned char *codes, unsigned int count)
+{
+    // Sets bit i of each point's code if the point is behind plane i, with
+    // the plane evaluated as in Plane::dot().
+
+    for (unsigned int n = 0; n < count; ++n, points += 3)
+    {
+        unsigned int code = 0;
+
+        for (unsigned int i = 0; i < planeCount; ++i)
+        {
+            const float *p = planes + i * 4;
+
+            if (points[0] * p[0] + points[1] * p[1] + points[2] * p[2] + p[3] < 0.0f)
+                code |= 1u << i;
+        }
+
+        codes[n] = static_cast<unsigned char>(code);
+    }
+}
+
+static void projectBoxesScalar(const float *m, const float *boxes, float *rects, float *depths, unsigned int count)
+{
+    // Projects the 8 corners of each box and keeps the bounds of their
+    // normalized device x and y and their nearest clip space w. A box that
+    // reaches the camera plane (w <= 0) covers the whole screen.
+
+    for (unsigned int n = 0; n < count; ++n, boxes += 6, rects += 4)
+    {
+        float minX = 3.402823466e+38f, minY = 3.402823466e+38f, minW = 3.402823466e+38f;
+        float maxX = -3.402823466e+38f, maxY = -3.402823466e+38f;
+
+        for (int i = 0; i < 8; ++i)
+        {
+            float x = boxes[(i & 1) ? 3 : 0];
+            float y = boxes[(i & 2) ? 4 : 1];
+            float z = boxes[(i & 4) ? 5 : 2];
+            float cx = x * m[0] + y * m[4] + z * m[8] + m[12];
+            float cy = x * m[1] + y * m[5] + z * m[9] + m[13];
+            float cw = x * m[3] + y * m[7] + z * m[11] + m[15];
+
+            minW = (cw < minW) ? cw : minW;
+            cx /= cw;
+            cy /= cw;
+            minX = (cx < minX) ? cx : minX;
+            maxX = (cx > maxX) ? cx : maxX;
+            minY = (cy < minY) ? cy : minY;
+            maxY = (cy > maxY) ? cy : maxY;
+        }
+
+        if (minW <= 0.0f)
+            minX = -1.0f, minY = -1.0f, maxX = 1.0f, maxY = 1.0f;
+
+        rects[0] = minX;
+        rects[1] = minY;
+        rects[2] = maxX;
+        rects[3] = maxY;
+        depths[n] = minW;
+    }
+}
+
+static void projectSpheresScalar(const float *view, float projScale, const float *spheres, float *depths, float *radii, unsigned int count)
+{
+    // The depth of a sphere is the view space distance of its center in
+    // front of the camera (-z). Its projected radius r * s / sqrt(d^2 - r^2)
+    // is exact for a sphere centered on the view axis. A sphere that
+    // reaches the camera plane gets the largest float as its radius.
+
+    for (unsigned int n = 0; n < count; ++n, spheres += 4)
+    {
+        float r = spheres[3];
+        float d = -(spheres[0] * view[2] + spheres[1] * view[6] + spheres[2] * view[10] + view[14]);
+
+        depths[n] = d;
+        radii[n] = (d > r) ? r * projScale / sqrtf(d * d - r * r) : 3.402823466e+38f;
+    }
+}
+
+static void selectLodsScalar(const float *sizes, const float *thresholds, unsigned int thresholdCount, unsigned int *lods, unsigned int count)
+{
+    // The LOD is the number of the object's thresholds that its size is
+    // below. With decreasing thresholds that is the index of the first
+    // threshold the size reaches.
+
+    for (unsigned int n = 0; n < count; ++n, thresholds += thresholdCount)
+    {
+        unsigned int lod = 0;
+
+        for (unsigned int k = 0; k < thresholdCount; ++k)
+            lod += (sizes[n] < thresholds[k]) ? 1 : 0;
+
+        lods[n] = lod;
+    }
+}
+
+static void rayIntersectsBoxesScalar(const float *ray, const float *boxes, bool *hit, unsigned int count)
+{
+    // Slab test. The ray hits the box if the parameter ranges where the
+    // ray is between each pair of slabs overlap somewhere at t >= 0.
+
+    float ix = 1.0f / ray[3], iy = 1.0f / ray[4], iz = 1.0f / ray[5];
+
+    for (unsigned int n = 0; n < count; ++n, boxes += 6)
+    {
+        float t1 = (boxes[0] - ray[0]) * ix, t2 = (boxes[3] - ray[0]) * ix;
+        float tmin = (t1 < t2) ? t1 : t2, tmax = (t1 < t2) ? t2 : t1;
+
+        t1 = (boxes[1] - ray[1]) * iy, t2 = (boxes[4] - ray[1]) * iy;
+        tmin = (((t1 < t2) ? t1 : t2) > tmin) ? ((t1 < t2) ? t1 : t2) : tmin;
+        tmax = (((t1 < t2) ? t2 : t1) < tmax) ? ((t1 < t2) ? t2 : t1) : tmax;
+
+        t1 = (boxes[2] - ray[2]) * iz, t2 = (boxes[5] - ray[2]) * iz;
+        tmin = (((t1 < t2) ? t1 : t2) > tmin) ? ((t1 < t2) ? t1 : t2) : tmin;
+        tmax = (((t1 < t2) ? t2 : t1) < tmax) ? ((t1 < t2) ? t2 : t1) : tmax;
+
+        hit[n] = tmax >= ((tmin > 0.0f) ? tmin : 0.0f);
+    }
+}
+
+static void cullCapsulesScalar(const float *planes, const float *const *capsules, bool *visible, unsigned int count)
+{
+    // A capsule is outside the frustum if both ends of its segment are more
+    // than its radius behind one plane.
+
+    for (unsigned int n = 0; n < count; ++n)
+    {
+        bool inside = true;
+
+        for (int i = 0; i < 6 && inside; ++i)
+        {
+            const float *p = planes + i * 4;
+            float da = p[0] * capsules[0][n] + p[1] * capsules[1][n] + p[2] * capsules[2][n] + p[3];
+            float db = p[0] * capsules[3][n] + p[1] * capsules[4][n] + p[2] * capsules[5][n] + p[3];
+
+            inside = ((da > db) ? da : db) + capsules[6][n] > 0.0f;
+        }
+
+        visible[n] = inside;
+    }
+}
+
+static void segmentIntersectsCapsulesScalar(const float *segment, const float *const *capsules, bool *hit, unsigned int count)
+{
+    // The closest points of the capsule's segment a + s * (b - a), s in
+    // [0, 1], and the query segment p + t * d, t in [0, tMax], as in
+    // Capsule::closestPoints(), then a test of their distance against the
+    // sum of the radii.
+
+    const float px = segment[0], py = segment[1], pz = segment[2];
+    const float dx = segment[3], dy = segment[4], dz = segment[5];
+    const float radius = segment[6], tMax = segment[7];
+    const float e = dx * dx + dy * dy + dz * dz;
+
+    for (unsigned int n = 0; n < count; ++n)
+    {
+        float ux = capsules[3][n] - capsules[0][n];
+        float uy = capsules[4][n] - capsules[1][n];
+        float uz = capsules[5][n] - capsules[2][n];
+        float rx = capsules[0][n] - px, ry = capsules[1][n] - py, rz = capsules[2][n] - pz;
+        float a = ux * ux + uy * uy + uz * uz;
+        float c = ux * rx + uy * ry + uz * rz;
+        float s = 0.0f, t = 0.0f;
+
+        if (e <= SEGMENT_EPSILON)
+        {
+            if (a > SEGMENT_EPSILON)
+                s = clampUnit(-c / a);
+        }
+        else
+        {
+            float b = ux * dx + uy * dy + uz * dz;
+            float f = dx * rx + dy * ry + dz * rz;
+            float denom = a * e - b * b;
+
+            if (a <= SEGMENT_EPSILON)
+            {
+                t = f / e;
+                t = (t < 0.0f) ? 0.0f : ((t > tMax) ? tMax : t);
+            }
+            else
+            {
+                s = (denom > 0.0f) ? clampUnit((b * f - c * e) / denom) : 0.0f;
+                t = (b * s + f) / e;
+
+                if (t < 0.0f || t > tMax)
+                {
+                    t = (t < 0.0f) ? 0.0f : tMax;
+                    s = clampUnit((b * t - c) / a);
+                }
+            }
+        }
+
+        float x = rx + ux * s - dx * t;
+        float y = ry + uy * s - dy * t;
+        float z = rz + uz * s - dz * t;
+        float radii = radius + capsules[6][n];
+
+        hit[n] = x * x + y * y + z * z <= radii * radii;
+    }
+}
+
+static float sweepSphereEdgeScalar(const float *sphere, const float *velocity, const float *corner, int axis, float lo, float hi)
+{
+    // The time the center of a sphere that starts outside the capsule of
+    // the box edge through 'corner' along 'axis', from 'lo' to 'hi', enters
+    // it. The edge is axis aligned, so the side of the capsule is a circle
+    // in the other two axes. A center that passes the side beyond an end
+    // can only enter through the sphere at that end.
+
+    int u = (axis + 1) % 3, w = (axis + 2) % 3;
+    float r = sphere[3];
+    float du = sphere[u] - corner[u], dw = sphere[w] - corner[w];
+    float a = velocity[u] * velocity[u] + velocity[w] * velocity[w];
+    float b = du * velocity[u] + dw * velocity[w];
+    float c = du * du + dw * dw - r * r;
+    float time = 0.0f;
+
+    if (c > 0.0f)
+    {
+        float disc = b * b - a * c;
+
+        if (b >= 0.0f || disc < 0.0f)
+            return SWEEP_MISS;
+
+        time = c / (sqrtf(disc) - b);
+    }
+
+    float along = sphere[axis] + velocity[axis] * time;
+
+    if (along >= lo && along <= hi)
+        return time;
+
+    float end[3] = { corner[0], corner[1], corner[2] };
+    end[axis] = (along < lo) ? lo : hi;
+
+    float e[3] = { sphere[0] - end[0], sphere[1] - end[1], sphere[2] - end[2] };
+    float ev = e[0] * velocity[0] + e[1] * velocity[1] + e[2] * velocity[2];
+    float vv = a + velocity[axis] * velocity[axis];
+    float ec = e[0] * e[0] + e[1] * e[1] + e[2] * e[2] - r * r;
+    float disc = ev * ev - vv * ec;
+
+    if (ev >= 0.0f || disc < 0.0f)
+        return SWEEP_MISS;
+
+    return ec / (sqrtf(disc) - ev);
+}
+
+static float sweepSphereCornerScalar(const float *box, const float *sphere, const float *velocity, float time)
+{
+    // Given the time the center enters the box grown by the radius, the
+    // time it enters the rounded box: where the entry point is beyond two
+    // or three faces of the box, the time it enters the capsule of the
+    // nearest edge, or of one of the three edges at the nearest corner.
+
+    const float *lo = box, *hi = box + 3;
+    float corner[3];
+    int outside = 0, edge = 0;
+
+    for (int i = 0; i < 3; ++i)
+    {
+        float p = sphere[i] + velocity[i] * time;
+
+        if (p < lo[i])
+            corner[i] = lo[i], ++outside;
+        else if (p > hi[i])
+            corner[i] = hi[i], ++outside;
+        else
+            corner[i] = lo[i], edge = i;
+    }
+
+    if (outside < 2)
+        return time;
+
+    float best = SWEEP_MISS;
+
+    for (int i = 0; i < 3; ++i)
+    {
+        if (outside == 2 && i != edge)
+            continue;
+
+        float tc = sweepSphereEdgeScalar(sphere, velocity, corner, i, lo[i], hi[i]);
+        best = (tc < best) ? tc : best;
+    }
+
+    return (best <= 1.0f) ? best : SWEEP_MISS;
+}
+
+static float sweepSphereBoxScalar(const float *box, const float *sphere, const float *velocity)
+{
+    // Sweep::timeOfImpact(const BoundingSphere &, const Vector3 &,
+    // const BoundingBox &, ...).
+
+    const float *lo = box, *hi = box + 3;
+    float r = sphere[3];
+    float distanceSq = 0.0f;
+    float enter = -SWEEP_MISS, exit = SWEEP_MISS;
+
+    for (int i = 0; i < 3; ++i)
+    {
+        float below = lo[i] - sphere[i], above = sphere[i] - hi[i];
+        float outside = (below > 0.0f) ? below : ((above > 0.0f) ? above : 0.0f);
+
+        distanceSq += outside * outside;
+    }
+
+    if (distanceSq <= r * r)
+        return 0.0f;
+
+    for (int i = 0; i < 3; ++i)
+    {
+        if (velocity[i] == 0.0f)
+        {
+            if (sphere[i] < lo[i] - r || sphere[i] > hi[i] + r)
+                return SWEEP_MISS;
+
+            continue;
+        }
+
+        float t1 = (lo[i] - r - sphere[i]) / velocity[i];
+        float t2 = (hi[i] + r - sphere[i]) / velocity[i];
+
+        enter = (((t1 < t2) ? t1 : t2) > enter) ? ((t1 < t2) ? t1 : t2) : enter;
+        exit = (((t1 < t2) ? t2 : t1) < exit) ? ((t1 < t2) ? t2 : t1) : exit;
+    }
+
+    if (enter > exit || enter > 1.0f || exit < 0.0f)
+        return SWEEP_MISS;
+
+    return sweepSphereCornerScalar(box, sphere, velocity, (enter > 0.0f) ? enter : 0.0f);
+}
+
+static void sweepSpheresBoxScalar(const float *box, const float *spheres, const float *velocities, float *times, unsigned int count)
+{
+    for (unsigned int n = 0; n < count; ++n, spheres += 4, velocities += 3)
+        times[n] = sweepSphereBoxScalar(box, spheres, velocities);
+}
+
+static void sweepSpheresPlaneScalar(const float *plane, const float *spheres, const float *velocities, float *times, unsigned int count)
+{
+    // The sphere touches the plane when its center is 'radius' from it, on
+    // the side it starts on.
+
+    for (unsigned int n = 0; n < count; ++n, spheres += 4, velocities += 3)
+    {
+        float d = plane[0] * spheres[0] + plane[1] * spheres[1] + plane[2] * spheres[2] + plane[3];
+        float speed = plane[0] * velocities[0] + plane[1] * velocities[1] + plane[2] * velocities[2];
+        float time = (fabsf(d) - spheres[3]) / fabsf(speed);
+
+        if (fabsf(d) <= spheres[3])
+            times[n] = 0.0f;
+        else
+            times[n] = (d * speed < 0.0f && time <= 1.0f) ? time : SWEEP_MISS;
+    }
+}
+
+static void sweepSpheresSphereScalar(const float *sphere, const float *spheres, const float *velocities, float *times, unsigned int count)
+{
+    // The first root of |s + v * t| = radii, s being the offset between
+    // the centers, as in Sweep::timeOfImpact().
+
+    for (unsigned int n = 0; n < count; ++n, spheres += 4, velocities += 3)
+    {
+        float sx = spheres[0] - sphere[0], sy = spheres[1] - sphere[1], sz = spheres[2] - sphere[2];
+        float radii = spheres[3] + sphere[3];
+        float c = sx * sx + sy * sy + sz * sz - radii * radii;
+        float b = sx * velocities[0] + sy * velocities[1] + sz * velocities[2];
+        float a = velocities[0] * velocities[0] + velocities[1] * velocities[1] + velocities[2] * velocities[2];
+        float disc = b * b - a * c;
+        float time = SWEEP_MISS;
+
+        if (c <= 0.0f)
+            time = 0.0f;
+        else if (b < 0.0f && disc >= 0.0f)
+            time = c / (sqrtf(disc) - b);
+
+        times[n] = (time <= 1.0f) ? time : SWEEP_MISS;
+    }
+}
+
+static void sweepBoxesBoxScalar(const float *box, const float *boxes, const float *velocities, float *times, unsigned int count)
+{
+    // The slab test on the intervals of time during which the boxes
+    // overlap on each axis.
+
+    for (unsigned int n = 0; n < count; ++n, boxes += 6, velocities += 3)
+    {
+        float enter = -SWEEP_MISS, exit = SWEEP_MISS;
+
+        for (int i = 0; i < 3; ++i)
+        {
+            if (velocities[i] == 0.0f)
+            {
+                if (boxes[3 + i] < box[i] || boxes[i] > box[3 + i])
+                    exit = -SWEEP_MISS;
+
+                continue;
+            }
+
+            float t1 = (box[i] - boxes[3 + i]) / velocities[i];
+            float t2 = (box[3 + i] - boxes[i]) / velocities[i];
+
+            enter = (((t1 < t2) ? t1 : t2) > enter) ? ((t1 < t2) ? t1 : t2) : enter;
+            exit = (((t1 < t2) ? t2 : t1) < exit) ? ((t1 < t2) ? t2 : t1) : exit;
+        }
+
+        if (enter > exit || enter > 1.0f || exit < 0.0f)
+            times[n] = SWEEP_MISS;
+        else
+            times[n] = (enter > 0.0f) ? enter : 0.0f;
+    }
+}
+
+//-----------------------------------------------------------------------------
+// SSE2 kernels. Point transformation, culling and ray tests also finish off
+// the remainders of the AVX2 kernels.
+
+#if defined(BATCH_KERNELS_SSE2) || defined(BATCH_KERNELS_AVX2)
+
+#if defined(BATCH_KERNELS_SSE2)
+
+static void multiplySse2(const float *lhs, const float *rhs, float *result, unsigned int count)
+{
+    // Each row of the result is a linear combination of the rows of 'rhs'.
+    // Both inputs are loaded before the result is stored, so 'result' may
+    // alias either input.
+
+    for (unsigned int n = 0; n < count; ++n, lhs += 16, rhs += 16, result += 16)
+    {
+        __m128 r0 = _mm_loadu_ps(rhs + 0);
+        __m128 r1 = _mm_loadu_ps(rhs + 4);
+        __m128 r2 = _mm_loadu_ps(rhs + 8);
+        __m128 r3 = _mm_loadu_ps(rhs + 12);
+
+        __m128 l[4] =
+        {
+            _mm_loadu_ps(lhs + 0), _mm_loadu_ps(lhs + 4), _mm_loadu_ps(lhs + 8), _mm_loadu_ps(lhs + 12)
+        };
+
+        for (int i = 0; i < 4; ++i)
+        {
+            __m128 v = _mm_mul_ps(_mm_shuffle_ps(l[i], l[i], 0x00), r0);
+
+            v = _mm_add_ps(v, _mm_mul_ps(_mm_shuffle_ps(l[i], l[i], 0x55), r1));
+            v = _mm_add_ps(v, _mm_mul_ps(_mm_shuffle_ps(l[i], l[i], 0xaa), r2));
+            v = _mm_add_ps(v, _mm_mul_ps(_mm_shuffle_ps(l[i], l[i], 0xff), r3));
+            _mm_storeu_ps(result + i * 4, v);
+        }
+    }
+}
+
+static void multiplyDoublesSse2(const double *lhs, const double *rhs, double *result, unsigned int count)
+{
+    // As multiplySse2(), with each row of 'rhs' split into two registers.
+    // Both inputs are loaded before the result is stored, so 'result' may
+    // alias either input.
+
+    for (unsigned int n = 0; n < count; ++n, lhs += 16, rhs += 16, result += 16)
+    {
+        __m128d r[8];
+        double l[16];
+
+        for (int k = 0; k < 8; ++k)
+            r[k] = _mm_loadu_pd(rhs + k * 2);
+
+        memcpy(l, lhs, sizeof(l));
+
+        for (int i = 0; i < 4; ++i)
+        {
+            __m128d a = _mm_set1_pd(l[i * 4 + 0]), b = _mm_set1_pd(l[i * 4 + 1]);
+            __m128d c = _mm_set1_pd(l[i * 4 + 2]), d = _mm_set1_pd(l[i * 4 + 3]);
+            __m128d lo = _mm_mul_pd(a, r[0]), hi = _mm_mul_pd(a, r[1]);
+
+            lo = _mm_add_pd(lo, _mm_mul_pd(b, r[2])), hi = _mm_add_pd(hi, _mm_mul_pd(b, r[3]));
+            lo = _mm_add_pd(lo, _mm_mul_pd(c, r[4])), hi = _mm_add_pd(hi, _mm_mul_pd(c, r[5]));
+            lo = _mm_add_pd(lo, _mm_mul_pd(d, r[6])), hi = _mm_add_pd(hi, _mm_mul_pd(d, r[7]));
+            _mm_storeu_pd(result + i * 4, lo);
+            _mm_storeu_pd(result + i * 4 + 2, hi);
+        }
+    }
+}
+
+#endif
+
+static void transformPointsSse2(const float *m, const float *points, float *result, unsigned int count)
+{
+    __m128 r0 = _mm_loadu_ps(m + 0);
+    __m128 r1 = _mm_loadu_ps(m + 4);
+    __m128 r2 = _mm_loadu_ps(m + 8);
+    __m128 r3 = _mm_loadu_ps(m + 12);
+
+    for (unsigned int n = 0; n < count; ++n, points += 3, result += 3)
+    {
+        __m128 v = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(points[0]), r0), r3);
+
+        v = _mm_add_ps(v, _mm_mul_ps(_mm_set1_ps(points[1]), r1));
+        v = _mm_add_ps(v, _mm_mul_ps(_mm_set1_ps(points[2]), r2));
+
+        // Store only x, y and z so that the next point isn't overwritten.
+        _mm_storel_pi(reinterpret_cast<__m64 *>(result), v);
+        _mm_store_ss(result + 2, _mm_movehl_ps(v, v));
+    }
+}
+
+static void rebasePointsSse2(const double *origin, const double *points, float *result, unsigned int count)
+{
+    // Works on four points (twelve doubles) at a time. The differences are
+    // computed in double precision and only then rounded to float.
+
+    __m128d oxy = _mm_loadu_pd(origin);
+    __m128d ozx = _mm_set_pd(origin[0], origin[2]);
+    __m128d oyz = _mm_loadu_pd(origin + 1);
+    unsigned int n = 0;
+
+    for (; n + 4 <= count; n += 4, points += 12, result += 12)
+    {
+        __m128 a = _mm_cvtpd_ps(_mm_sub_pd(_mm_loadu_pd(points + 0), oxy));
+        __m128 b = _mm_cvtpd_ps(_mm_sub_pd(_mm_loadu_pd(points + 2), ozx));
+        __m128 c = _mm_cvtpd_ps(_mm_sub_pd(_mm_loadu_pd(points + 4), oyz));
+        __m128 d = _mm_cvtpd_ps(_mm_sub_pd(_mm_loadu_pd(points + 6), oxy));
+        __m128 e = _mm_cvtpd_ps(_mm_sub_pd(_mm_loadu_pd(points + 8), ozx));
+        __m128 f = _mm_cvtpd_ps(_mm_sub_pd(_mm_loadu_pd(points + 10), oyz));
+
+        _mm_storeu_ps(result + 0, _mm_movelh_ps(a, b));
+        _mm_storeu_ps(result + 4, _mm_movelh_ps(c, d));
+        _mm_storeu_ps(result + 8, _mm_movelh_ps(e, f));
+    }
+
+    for (; n < count; ++n, points += 3, result += 3)
+    {
+        __m128 a = _mm_cvtpd_ps(_mm_sub_pd(_mm_loadu_pd(points), oxy));
+        __m128 b = _mm_cvtpd_ps(_mm_sub_sd(_mm_load_sd(points + 2), ozx));
+
+        _mm_storel_pi(reinterpret_cast<__m64 *>(result), a);
+        _mm_store_ss(result + 2, b);
+    }
+}
+
+static void rebaseMatricesSse2(const double *origin, const float *matrices, const double *positions, float *result, unsigned int count)
+{
+    // Rows 0 to 2 are copied. Row 3 is widened to double, offset by the
+    // position relative to the origin, and narrowed again. The w component
+    // gets a zero offset and so comes through unchanged.
+
+    __m128d oxy = _mm_loadu_pd(origin);
+    __m128d oz = _mm_load_sd(origin + 2);
+
+    for (unsigned int n = 0; n < count; ++n, matrices += 16, positions += 3, result += 16)
+    {
+        __m128 r0 = _mm_loadu_ps(matrices + 0);
+        __m128 r1 = _mm_loadu_ps(matrices + 4);
+        __m128 r2 = _mm_loadu_ps(matrices + 8);
+        __m128 r3 = _mm_loadu_ps(matrices + 12);
+        __m128d xy = _mm_add_pd(_mm_cvtps_pd(r3), _mm_sub_pd(_mm_loadu_pd(positions), oxy));
+        __m128d zw = _mm_add_pd(_mm_cvtps_pd(_mm_movehl_ps(r3, r3)), _mm_sub_pd(_mm_load_sd(positions + 2), oz));
+
+        _mm_storeu_ps(result + 0, r0);
+        _mm_storeu_ps(result + 4, r1);
+        _mm_storeu_ps(result + 8, r2);
+        _mm_storeu_ps(result + 12, _mm_movelh_ps(_mm_cvtpd_ps(xy), _mm_cvtpd_ps(zw)));
+    }
+}
+
+static void cullBoxesSse2(const float *planes, const float *boxes, bool *visible, unsigned int count)
+{
+    // Tests 4 boxes at a time, one box per lane.
+
+    unsigned int n = 0;
+
+    for (; n + 4 <= count; n += 4, boxes += 24)
+    {
+        __m128 bounds[6];
+
+        for (int k = 0; k < 6; ++k)
+            bounds[k] = _mm_set_ps(boxes[18 + k], boxes[12 + k], boxes[6 + k], boxes[k]);
+
+        __m128 inside = _mm_cmpeq_ps(bounds[0], bounds[0]);
+
+        for (int i = 0; i < 6; ++i)
+        {
+            const float *p = planes + i * 4;
+            __m128 x = bounds[(p[0] > 0.0f) ? 3 : 0];
+            __m128 y = bounds[(p[1] > 0.0f) ? 4 : 1];
+            __m128 z = bounds[(p[2] > 0.0f) ? 5 : 2];
+            __m128 d = _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(p[0])), _mm_set1_ps(p[3]));
+
+            d = _mm_add_ps(d, _mm_mul_ps(y, _mm_set1_ps(p[1])));
+            d = _mm_add_ps(d, _mm_mul_ps(z, _mm_set1_ps(p[2])));
+            inside = _mm_and_ps(inside, _mm_cmpgt_ps(d, _mm_setzero_ps()));
+        }
+
+        int mask = _mm_movemask_ps(inside);
+
+        for (int k = 0; k < 4; ++k)
+            visible[n + k] = ((mask >> k) & 1) != 0;
+    }
+
+    cullBoxesScalar(planes, boxes, visible + n, count - n);
+}
+
+static void cullBoxesClipSpaceSse2(const float *matrices, const float *boxes, unsigned int boxStride, bool *visible, unsigned int count)
+{
+    // One box per iteration, with the clip space x, y, z and w in the 4
+    // lanes. See cullBoxesClipSpaceScalar().
+
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    const __m128 half = _mm_set1_ps(0.5f);
+
+    for (unsigned int n = 0; n < count; ++n, matrices += 16, boxes += boxStride)
+    {
+        __m128 r0 = _mm_loadu_ps(matrices + 0);
+        __m128 r1 = _mm_loadu_ps(matrices + 4);
+        __m128 r2 = _mm_loadu_ps(matrices + 8);
+        __m128 r3 = _mm_loadu_ps(matrices + 12);
+        __m128 lo = _mm_set_ps(0.0f, boxes[2], boxes[1], boxes[0]);
+        __m128 hi = _mm_set_ps(0.0f, boxes[5], boxes[4], boxes[3]);
+        __m128 center = _mm_mul_ps(_mm_add_ps(lo, hi), half);
+        __m128 extent = _mm_mul_ps(_mm_sub_ps(hi, lo), half);
+
+        __m128 c = _mm_add_ps(_mm_mul_ps(_mm_shuffle_ps(center, center, 0x00), r0), r3);
+        c = _mm_add_ps(c, _mm_mul_ps(_mm_shuffle_ps(center, center, 0x55), r1));
+        c = _mm_add_ps(c, _mm_mul_ps(_mm_shuffle_ps(center, center, 0xaa), r2));
+
+        __m128 e = _mm_mul_ps(_mm_shuffle_ps(extent, extent, 0x00), _mm_and_ps(r0, absMask));
+        e = _mm_add_ps(e, _mm_mul_ps(_mm_shuffle_ps(extent, extent, 0x55), _mm_and_ps(r1, absMask)));
+        e = _mm_add_ps(e, _mm_mul_ps(_mm_shuffle_ps(extent, extent, 0xaa), _mm_and_ps(r2, absMask)));
+
+        __m128 ce = _mm_add_ps(c, e);
+        __m128 w = _mm_shuffle_ps(ce, ce, 0xff);
+        __m128 inside = _mm_and_ps(_mm_cmpgt_ps(_mm_add_ps(ce, w), _mm_setzero_ps()),
+            _mm_cmpgt_ps(_mm_sub_ps(_mm_add_ps(w, e), c), _mm_setzero_ps()));
+
+        visible[n] = (_mm_movemask_ps(inside) & 7) == 7;
+    }
+}
+
+static void cullBoxesMultiSse2(const float *frustums, unsigned int frustumCount, const float *boxes, unsigned int *masks, unsigned int count)
+{
+    // Tests 4 boxes at a time against every frustum, one box per lane. A
+    // frustum's remaining planes are skipped once all 4 boxes are outside.
+    // The broadcast plane coefficients and the corner of the box each plane
+    // is tested against are set up once, not for every 4 boxes.
+
+    __m128 coefficients[BATCH_MAX_CULL_FRUSTUMS * 6][4];
+    int corners[BATCH_MAX_CULL_FRUSTUMS * 6][3];
+    unsigned int planeCount = frustumCount * 6;
+
+    for (unsigned int i = 0; i < planeCount; ++i)
+    {
+        const float *p = frustums + i * 4;
+
+        for (int j = 0; j < 4; ++j)
+            coefficients[i][j] = _mm_set1_ps(p[j]);
+
+        for (int j = 0; j < 3; ++j)
+            corners[i][j] = (p[j] > 0.0f) ? j + 3 : j;
+    }
+
+    unsigned int n = 0;
+
+    for (; n + 4 <= count; n += 4, boxes += 24)
+    {
+        __m128 bounds[6];
+
+        for (int k = 0; k < 6; ++k)
+            bounds[k] = _mm_set_ps(boxes[18 + k], boxes[12 + k], boxes[6 + k], boxes[k]);
+
+        __m128i mask = _mm_setzero_si128();
+
+        for (unsigned int f = 0; f < frustumCount; ++f)
+        {
+            __m128 inside = _mm_cmpeq_ps(bounds[0], bounds[0]);
+
+            for (unsigned int i = f * 6; i < f * 6 + 6; ++i)
+            {
+                const __m128 *p = coefficients[i];
+                __m128 d = _mm_add_ps(_mm_mul_ps(bounds[corners[i][0]], p[0]), p[3]);
+
+                d = _mm_add_ps(d, _mm_mul_ps(bounds[corners[i][1]], p[1]));
+                d = _mm_add_ps(d, _mm_mul_ps(bounds[corners[i][2]], p[2]));
+                inside = _mm_and_ps(inside, _mm_cmpgt_ps(d, _mm_setzero_ps()));
+
+                if (_mm_movemask_ps(inside) == 0)
+                    break;
+            }
+
+            __m128i bit = _mm_set1_epi32(static_cast<int>(1u << f));
+            mask = _mm_or_si128(mask, _mm_and_si128(_mm_castps_si128(inside), bit));
+        }
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(masks + n), mask);
+    }
+
+    cullBoxesMultiScalar(frustums, frustumCount, boxes, masks + n, count - n);
+}
+
+static void cullSpheresMultiSse2(const float *frustums, unsigned int frustumCount, const float *spheres, unsigned int *masks, unsigned int count)
+{
+    // Tests 4 spheres at a time against every frustum, one sphere per lane.
+
+    unsigned int n = 0;
+
+    for (; n + 4 <= count; n += 4, spheres += 16)
+    {
+        __m128 x = _mm_loadu_ps(spheres);
+        __m128 y = _mm_loadu_ps(spheres + 4);
+        __m128 z = _mm_loadu_ps(spheres + 8);
+        __m128 r = _mm_loadu_ps(spheres + 12);
+
+        _MM_TRANSPOSE4_PS(x, y, z, r);
+
+        __m128 negRadius = _mm_sub_ps(_mm_setzero_ps(), r);
+        __m128i mask = _mm_setzero_si128();
+
+        for (unsigned int f = 0; f < frustumCount; ++f)
+        {
+            __m128 inside = _mm_cmpeq_ps(x, x);
+
+            for (int i = 0; i < 6; ++i)
+            {
+                const float *p = frustums + f * 24 + i * 4;
+                __m128 d = _mm_mul_ps(x, _mm_set1_ps(p[0]));
+
+                d = _mm_add_ps(d, _mm_mul_ps(y, _mm_set1_ps(p[1])));
+                d = _mm_add_ps(d, _mm_mul_ps(z, _mm_set1_ps(p[2])));
+                d = _mm_add_ps(d, _mm_set1_ps(p[3]));
+                inside = _mm_and_ps(inside, _mm_cmpgt_ps(d, negRadius));
+
+                if (_mm_movemask_ps(inside) == 0)
+                    break;
+            }
+
+            __m128i bit = _mm_set1_epi32(static_cast<int>(1u << f));
+            mask = _mm_or_si128(mask, _mm_and_si128(_mm_castps_si128(inside), bit));
+        }
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(masks + n), mask);
+    }
+
+    cullSpheresMultiScalar(frustums, frustumCount, spheres, masks + n, count - n);
+}
+
+static void cullBoxesVolumeSse2(const float *planes, unsigned int planeStride, unsigned int planeCount, const float *boxes, bool *visible, unsigned int count)
+{
+    // Tests 4 boxes at a time, one box per lane. The remaining planes are
+    // skipped once all 4 boxes are outside.
+
+    const float *a = planes;
+    const float *b = planes + planeStride;
+    const float *c = planes + 2 * planeStride;
+    const float *d = planes + 3 * planeStride;
+    unsigned int n = 0;
+
+    for (; n + 4 <= count; n += 4, boxes += 24)
+    {
+        // Boxes 0 and 2 start on a 4 float boundary, boxes 1 and 3 halfway
+        // through a load.
+        __m128 r0 = _mm_loadu_ps(boxes + 0);
+        __m128 r1 = _mm_loadu_ps(boxes + 4);
+        __m128 r2 = _mm_loadu_ps(boxes + 8);
+        __m128 r3 = _mm_loadu_ps(boxes + 12);
+        __m128 r4 = _mm_loadu_ps(boxes + 16);
+        __m128 r5 = _mm_loadu_ps(boxes + 20);
+        __m128 bounds[6];
+
+        bounds[0] = r0;
+        bounds[1] = _mm_shuffle_ps(r1, r2, _MM_SHUFFLE(1, 0, 3, 2));
+        bounds[2] = r3;
+        bounds[3] = _mm_shuffle_ps(r4, r5, _MM_SHUFFLE(1, 0, 3, 2));
+
+        _MM_TRANSPOSE4_PS(bounds[0], bounds[1], bounds[2], bounds[3]);
+
+        __m128 t0 = _mm_unpacklo_ps(r1, _mm_movehl_ps(r2, r2));
+        __m128 t1 = _mm_unpacklo_ps(r4, _mm_movehl_ps(r5, r5));
+
+        bounds[4] = _mm_movelh_ps(t0, t1);
+        bounds[5] = _mm_movehl_ps(t1, t0);
+
+        __m128 inside = _mm_cmpeq_ps(bounds[0], bounds[0]);
+
+        for (unsigned int i = 0; i < planeCount; ++i)
+        {
+            __m128 x = bounds[(a[i] > 0.0f) ? 3 : 0];
+            __m128 y = bounds[(b[i] > 0.0f) ? 4 : 1];
+            __m128 z = bounds[(c[i] > 0.0f) ? 5 : 2];
+            __m128 dist = _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(a[i])), _mm_set1_ps(d[i]));
+
+            dist = _mm_add_ps(dist, _mm_mul_ps(y, _mm_set1_ps(b[i])));
+            dist = _mm_add_ps(dist, _mm_mul_ps(z, _mm_set1_ps(c[i])));
+            inside = _mm_and_ps(inside, _mm_cmpgt_ps(dist, _mm_setzero_ps()));
+
+            if (_mm_movemask_ps(inside) == 0)
+                break;
+        }
+
+        int mask = _mm_movemask_ps(inside);
+
+        for (int k = 0; k < 4; ++k)
+            visible[n + k] = ((mask >> k) & 1) != 0;
+    }
+
+    cullBoxesVolumeScalar(planes, planeStride, planeCount, boxes, visible + n, count - n);
+}
+
+static void cullSpheresVolumeSse2(const float *planes, unsigned int planeStride, unsigned int planeCount, const float *spheres, bool *visible, unsigned int count)
+{
+    // Tests 4 spheres at a time, one sphere per lane.
+
+    const float *a = planes;
+    const float *b = planes + planeStride;
+    const float *c = planes + 2 * planeStride;
+    const float *d = planes + 3 * planeStride;
+    unsigned int n = 0;
+
+    for (; n + 4 <= count; n += 4, spheres += 16)
+    {
+        __m128 x = _mm_loadu_ps(spheres);
+        __m128 y = _mm_loadu_ps(spheres + 4);
+        __m128 z = _mm_loadu_ps(spheres + 8);
+        __m128 r = _mm_loadu_ps(spheres + 12);
+
+        _MM_TRANSPOSE4_PS(x, y, z, r);
+
+        __m128 negRadius = _mm_sub_ps(_mm_setzero_ps(), r);
+        __m128 inside = _mm_cmpeq_ps(x, x);
+
+        for (unsigned int i = 0; i < planeCount; ++i)
+        {
+            __m128 dist = _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(a[i])), _mm_set1_ps(d[i]));
+
+            dist = _mm_add_ps(dist, _mm_mul_ps(y, _mm_set1_ps(b[i])));
+            dist = _mm_add_ps(dist, _mm_mul_ps(z, _mm_set1_ps(c[i])));
+            inside = _mm_and_ps(inside, _mm_cmpgt_ps(dist, negRadius));
+
+            if (_mm_movemask_ps(inside) == 0)
+                break;
+        }
+
+        int mask = _mm_movemask_ps(inside);
+
+        for (int k = 0; k < 4; ++k)
+            visible[n + k] = ((mask >> k) & 1) != 0;
+    }
+
+    cullSpheresVolumeScalar(planes, planeStride, planeCount, spheres, visible + n, count - n);
+}
+
+static void classifyPointsSse2(const float *planes, unsigned int planeCount, const float *points, unsigned char *codes, unsigned int count)
+{
+    // Works on 4 points (12 floats) at a time, shuffled into vectors of x,
+    // y and z. Each plane's bit is ORed into the lanes of the points behind
+    // it.
+
+    unsigned int n = 0;
+
+    for (; n + 4 <= count; n += 4, points += 12)
+    {
+        __m128 v0 = _mm_loadu_ps(points + 0);
+        __m128 v1 = _mm_loadu_ps(points + 4);
+        __m128 v2 = _mm_loadu_ps(points + 8);
+        __m128 t0 = _mm_shuffle_ps(v1, v2, _MM_SHUFFLE(1, 1, 2, 2));
+        __m128 t1 = _mm_shuffle_ps(v0, v1, _MM_SHUFFLE(0, 0, 1, 1));
+        __m128 t2 = _mm_shuffle_ps(v1, v2, _MM_SHUFFLE(2, 2, 3, 3));
+        __m128 t3 = _mm_shuffle_ps(v0, v1, _MM_SHUFFLE(1, 1, 2, 2));
+        __m128 t4 = _mm_shuffle_ps(v2, v2, _MM_SHUFFLE(3, 3, 0, 0));
+        __m128 x = _mm_shuffle_ps(v0, t0, _MM_SHUFFLE(2, 0, 3, 0));
+        __m128 y = _mm_shuffle_ps(t1, t2, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 z = _mm_shuffle_ps(t3, t4, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128i code = _mm_setzero_si128();
+
+        for (unsigned int i = 0; i < planeCount; ++i)
+        {
+            const float *p = planes + i * 4;
+            __m128 d = _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(p[0])), _mm_mul_ps(y, _mm_set1_ps(p[1])));
+
+            d = _mm_add_ps(_mm_add_ps(d, _mm_mul_ps(z, _mm_set1_ps(p[2]))), _mm_set1_ps(p[3]));
+
+            __m128i behind = _mm_castps_si128(_mm_cmplt_ps(d, _mm_setzero_ps()));
+            code = _mm_or_si128(code, _mm_and_si128(behind, _mm_set1_epi32(1 << i)));
+        }
+
+        // The codes fit in the low byte of each lane.
+        code = _mm_packs_epi32(code, code);
+        code = _mm_packus_epi16(code, code);
+
+        int packed = _mm_cvtsi128_si32(code);
+        memcpy(codes + n, &packed, 4);
+    }
+
+    classifyPointsScalar(planes, planeCount, points, codes + n, count - n);
+}
+
+static void projectBoxesSse2(const float *m, const float *boxes, float *rects, float *depths, unsigned int count)
+{
+    // Projects 4 boxes at a time, one box per lane. Each corner's clip
+    // space x, y and w are sums of one of two scaled matrix elements per
+    // axis, so the 8 corners need only 18 products. The rectangles are
+    // transposed back to one box per register for the stores.
+
+    unsigned int n = 0;
+
+    for (; n + 4 <= count; n += 4, boxes += 24, rects += 16)
+    {
+        __m128 bounds[6];
+
+        for (int k = 0; k < 6; ++k)
+            bounds[k] = _mm_set_ps(boxes[18 + k], boxes[12 + k], boxes[6 + k], boxes[k]);
+
+        // terms[axis][min or max][x, y or w]
+        __m128 terms[3][2][3];
+
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            for (int side = 0; side < 2; ++side)
+            {
+                __m128 v = bounds[side * 3 + axis];
+
+                terms[axis][side][0] = _mm_mul_ps(v, _mm_set1_ps(m[axis * 4 + 0]));
+                terms[axis][side][1] = _mm_mul_ps(v, _mm_set1_ps(m[axis * 4 + 1]));
+                terms[axis][side][2] = _mm_mul_ps(v, _mm_set1_ps(m[axis * 4 + 3]));
+
+                if (axis == 2)
+                {
+                    terms[2][side][0] = _mm_add_ps(terms[2][side][0], _mm_set1_ps(m[12]));
+                    terms[2][side][1] = _mm_add_ps(terms[2][side][1], _mm_set1_ps(m[13]));
+                    terms[2][side][2] = _mm_add_ps(terms[2][side][2], _mm_set1_ps(m[15]));
+                }
+            }
+        }
+
+        __m128 minX = _mm_set1_ps(3.402823466e+38f), minY = minX, minW = minX;
+        __m128 maxX = _mm_set1_ps(-3.402823466e+38f), maxY = maxX;
+
+        for (int i = 0; i < 8; ++i)
+        {
+            int sx = i & 1, sy = (i >> 1) & 1, sz = i >> 2;
+            __m128 cx = _mm_add_ps(_mm_add_ps(terms[0][sx][0], terms[1][sy][0]), terms[2][sz][0]);
+            __m128 cy = _mm_add_ps(_mm_add_ps(terms[0][sx][1], terms[1][sy][1]), terms[2][sz][1]);
+            __m128 cw = _mm_add_ps(_mm_add_ps(terms[0][sx][2], terms[1][sy][2]), terms[2][sz][2]);
+
+            minW = _mm_min_ps(minW, cw);
+            cx = _mm_div_ps(cx, cw);
+            cy = _mm_div_ps(cy, cw);
+            minX = _mm_min_ps(minX, cx);
+            maxX = _mm_max_ps(maxX, cx);
+            minY = _mm_min_ps(minY, cy);
+            maxY = _mm_max_ps(maxY, cy);
+        }
+
+        // Boxes that reach the camera plane cover the whole screen.
+        __m128 behind = _mm_cmple_ps(minW, _mm_setzero_ps());
+        __m128 one = _mm_set1_ps(1.0f);
+        __m128 negOne = _mm_set1_ps(-1.0f);
+
+        minX = _mm_or_ps(_mm_andnot_ps(behind, minX), _mm_and_ps(behind, negOne));
+        minY = _mm_or_ps(_mm_andnot_ps(behind, minY), _mm_and_ps(behind, negOne));
+        maxX = _mm_or_ps(_mm_andnot_ps(behind, maxX), _mm_and_ps(behind, one));
+        maxY = _mm_or_ps(_mm_andnot_ps(behind, maxY), _mm_and_ps(behind, one));
+
+        _MM_TRANSPOSE4_PS(minX, minY, maxX, maxY);
+        _mm_storeu_ps(rects + 0, minX);
+        _mm_storeu_ps(rects + 4, minY);
+        _mm_storeu_ps(rects + 8, maxX);
+        _mm_storeu_ps(rects + 12, maxY);
+        _mm_storeu_ps(depths + n, minW);
+    }
+
+    projectBoxesScalar(m, boxes, rects, depths + n, count - n);
+}
+
+static void projectSpheresSse2(const float *view, float projScale, const float *spheres, float *depths, float *radii, unsigned int count)
+{
+    // Projects 4 spheres at a time. Four spheres are exactly 4 registers,
+    // which are transposed to one register each of x, y, z and radius.
+
+    __m128 v2 = _mm_set1_ps(view[2]);
+    __m128 v6 = _mm_set1_ps(view[6]);
+    __m128 v10 = _mm_set1_ps(view[10]);
+    __m128 v14 = _mm_set1_ps(view[14]);
+    __m128 s = _mm_set1_ps(projScale);
+    unsigned int n = 0;
+
+    for (; n + 4 <= count; n += 4, spheres += 16)
+    {
+        __m128 x = _mm_loadu_ps(spheres + 0);
+        __m128 y = _mm_loadu_ps(spheres + 4);
+        __m128 z = _mm_loadu_ps(spheres + 8);
+        __m128 r = _mm_loadu_ps(spheres + 12);
+
+        _MM_TRANSPOSE4_PS(x, y, z, r);
+
+        __m128 d = _mm_add_ps(_mm_mul_ps(x, v2), v14);
+
+        d = _mm_add_ps(d, _mm_mul_ps(y, v6));
+        d = _mm_add_ps(d, _mm_mul_ps(z, v10));
+        d = _mm_sub_ps(_mm_setzero_ps(), d);
+
+        __m128 front = _mm_cmpgt_ps(d, r);
+        __m128 projected = _mm_div_ps(_mm_mul_ps(r, s), _mm_sqrt_ps(_mm_sub_ps(_mm_mul_ps(d, d), _mm_mul_ps(r, r))));
+
+        _mm_storeu_ps(depths + n, d);
+        _mm_storeu_ps(radii + n, _mm_or_ps(_mm_and_ps(front, projected),
+            _mm_andnot_ps(front, _mm_set1_ps(3.402823466e+38f))));
+    }
+
+    projectSpheresScalar(view, projScale, spheres, depths + n, radii + n, count - n);
+}
+
+static void selectLodsSse2(const float *sizes, const float *thresholds, unsigned int thresholdCount, unsigned int *lods, unsigned int count)
+{
+    // Selects 4 LODs at a time. A comparison is all ones (-1 as an integer)
+    // where the size is below the threshold, so subtracting it counts.
+
+    const float *t1 = thresholds + thresholdCount;
+    const float *t2 = thresholds + 2 * thresholdCount;
+    const float *t3 = thresholds + 3 * thresholdCount;
+    unsigned int n = 0;
+
+    for (; n + 4 <= count; n += 4)
+    {
+        __m128 size = _mm_loadu_ps(sizes + n);
+        __m128i lod = _mm_setzero_si128();
+        unsigned int base = n * thresholdCount;
+
+        for (unsigned int k = 0; k < thresholdCount; ++k)
+        {
+            __m128 t = _mm_set_ps(t3[base + k], t2[base + k], t1[base + k], thresholds[base + k]);
+            lod = _mm_sub_epi32(lod, _mm_castps_si128(_mm_cmplt_ps(size, t)));
+        }
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(lods + n), lod);
+    }
+
+    selectLodsScalar(sizes + n, thresholds + n * thresholdCount, thresholdCount, lods + n, count - n);
+}
+
+static void rayIntersectsBoxesSse2(const float *ray, const float *boxes, bool *hit, unsigned int count)
+{
+    // Tests 4 boxes at a time, one box per lane.
+
+    __m128 o[3], inv[3];
+    unsigned int n = 0;
+
+    for (int k = 0; k < 3; ++k)
+        o[k] = _mm_set1_ps(ray[k]), inv[k] = _mm_set1_ps(1.0f / ray[3 + k]);
+
+    for (; n + 4 <= count; n += 4, boxes += 24)
+    {
+        __m128 tmin = _mm_setzero_ps();
+        __m128 tmax = _mm_set1_ps(3.402823466e+38f);
+
+        for (int k = 0; k < 3; ++k)
+        {
+            __m128 lo = _mm_set_ps(boxes[18 + k], boxes[12 + k], boxes[6 + k], boxes[k]);
+            __m128 hi = _mm_set_ps(boxes[21 + k], boxes[15 + k], boxes[9 + k], boxes[3 + k]);
+            __m128 t1 = _mm_mul_ps(_mm_sub_ps(lo, o[k]), inv[k]);
+            __m128 t2 = _mm_mul_ps(_mm_sub_ps(hi, o[k]), inv[k]);
+
+            tmin = _mm_max_ps(tmin, _mm_min_ps(t1, t2));
+            tmax = _mm_min_ps(tmax, _mm_max_ps(t1, t2));
+        }
+
+        int mask = _mm_movemask_ps(_mm_cmpge_ps(tmax, tmin));
+
+        for (int k = 0; k < 4; ++k)
+            hit[n + k] = ((mask >> k) & 1) != 0;
+    }
+
+    rayIntersectsBoxesScalar(ray, boxes, hit + n, count - n);
+}
+
+static void cullCapsulesSse2(const float *planes, const float *const *capsules, bool *visible, unsigned int count)
+{
+    // Tests 4 capsules at a time, one capsule per lane, loaded straight
+    // from the coordinate arrays.
+
+    unsigned int n = 0;
+
+    for (; n + 4 <= count; n += 4)
+    {
+        __m128 c[7];
+
+        for (int k = 0; k < 7; ++k)
+            c[k] = _mm_loadu_ps(capsules[k] + n);
+
+        __m128 inside = _mm_cmpeq_ps(c[0], c[0]);
+
+        for (int i = 0; i < 6; ++i)
+        {
+            const float *p = planes + i * 4;
+            __m128 a = _mm_set1_ps(p[0]), b = _mm_set1_ps(p[1]), cc = _mm_set1_ps(p[2]), d = _mm_set1_ps(p[3]);
+            __m128 da = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c[0], a), _mm_mul_ps(c[1], b)), _mm_add_ps(_mm_mul_ps(c[2], cc), d));
+            __m128 db = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c[3], a), _mm_mul_ps(c[4], b)), _mm_add_ps(_mm_mul_ps(c[5], cc), d));
+
+            inside = _mm_and_ps(inside, _mm_cmpgt_ps(_mm_add_ps(_mm_max_ps(da, db), c[6]), _mm_setzero_ps()));
+        }
+
+        int mask = _mm_movemask_ps(inside);
+
+        for (int k = 0; k < 4; ++k)
+            visible[n + k] = ((mask >> k) & 1) != 0;
+    }
+
+    const float *rest[7];
+
+    for (int k = 0; k < 7; ++k)
+        rest[k] = capsules[k] + n;
+
+    cullCapsulesScalar(planes, rest, visible + n, count - n);
+}
+
+static inline __m128 selectSse2(__m128 mask, __m128 a, __m128 b)
+{
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+static void segmentIntersectsCapsulesSse2(const float *segment, const float *const *capsules, bool *hit, unsigned int count)
+{
+    // Tests 4 capsules at a time, one capsule per lane. The branches of the
+    // scalar kernel become selects; the divisions by zero they guard
+    // against produce values that are thrown away.
+
+    const float e = segment[3] * segment[3] + segment[4] * segment[4] + segment[5] * segment[5];
+    const bool point = e <= SEGMENT_EPSILON;
+    const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+    const __m128 ve = _mm_set1_ps(e), vtMax = _mm_set1_ps(segment[7]);
+    const __m128 epsilon = _mm_set1_ps(SEGMENT_EPSILON);
+    __m128 p[3], d[3];
+    unsigned int n = 0;
+
+    for (int k = 0; k < 3; ++k)
+        p[k] = _mm_set1_ps(segment[k]), d[k] = _mm_set1_ps(segment[3 + k]);
+
+    for (; n + 4 <= count; n += 4)
+    {
+        __m128 u[3], r[3];
+
+        for (int k = 0; k < 3; ++k)
+        {
+            __m128 start = _mm_loadu_ps(capsules[k] + n);
+
+            u[k] = _mm_sub_ps(_mm_loadu_ps(capsules[3 + k] + n), start);
+            r[k] = _mm_sub_ps(start, p[k]);
+        }
+
+        __m128 a = _mm_add_ps(_mm_add_ps(_mm_mul_ps(u[0], u[0]), _mm_mul_ps(u[1], u[1])), _mm_mul_ps(u[2], u[2]));
+        __m128 c = _mm_add_ps(_mm_add_ps(_mm_mul_ps(u[0], r[0]), _mm_mul_ps(u[1], r[1])), _mm_mul_ps(u[2], r[2]));
+        __m128 line = _mm_cmpgt_ps(a, epsilon);
+        __m128 s, t;
+
+        if (point)
+        {
+            s = _mm_and_ps(line, _mm_min_ps(_mm_max_ps(_mm_div_ps(_mm_sub_ps(zero, c), a), zero), one));
+            t = zero;
+        }
+        else
+        {
+            __m128 b = _mm_add_ps(_mm_add_ps(_mm_mul_ps(u[0], d[0]), _mm_mul_ps(u[1], d[1])), _mm_mul_ps(u[2], d[2]));
+            __m128 f = _mm_add_ps(_mm_add_ps(_mm_mul_ps(d[0], r[0]), _mm_mul_ps(d[1], r[1])), _mm_mul_ps(d[2], r[2]));
+            __m128 denom = _mm_sub_ps(_mm_mul_ps(a, ve), _mm_mul_ps(b, b));
+
+            s = _mm_div_ps(_mm_sub_ps(_mm_mul_ps(b, f), _mm_mul_ps(c, ve)), denom);
+            s = _mm_and_ps(_mm_cmpgt_ps(denom, zero), _mm_min_ps(_mm_max_ps(s, zero), one));
+            s = _mm_and_ps(line, s);
+            t = _mm_div_ps(_mm_add_ps(_mm_mul_ps(b, s), f), ve);
+
+            __m128 clamped = _mm_min_ps(_mm_max_ps(t, zero), vtMax);
+            __m128 again = _mm_div_ps(_mm_sub_ps(_mm_mul_ps(b, clamped), c), a);
+
+            again = _mm_and_ps(line, _mm_min_ps(_mm_max_ps(again, zero), one));
+            s = selectSse2(_mm_cmpneq_ps(t, clamped), again, s);
+            t = clamped;
+        }
+
+        __m128 distanceSq = zero;
+
+        for (int k = 0; k < 3; ++k)
+        {
+            __m128 w = _mm_sub_ps(_mm_add_ps(r[k], _mm_mul_ps(u[k], s)), _mm_mul_ps(d[k], t));
+
+            distanceSq = _mm_add_ps(distanceSq, _mm_mul_ps(w, w));
+        }
+
+        __m128 radii = _mm_add_ps(_mm_set1_ps(segment[6]), _mm_loadu_ps(capsules[6] + n));
+        int mask = _mm_movemask_ps(_mm_cmple_ps(distanceSq, _mm_mul_ps(radii, radii)));
+
+        for (int k = 0; k < 4; ++k)
+            hit[n + k] = ((mask >> k) & 1) != 0;
+    }
+
+    const float *rest[7];
+
+    for (int k = 0; k < 7; ++k)
+        rest[k] = capsules[k] + n;
+
+    segmentIntersectsCapsulesScalar(segment, rest, hit + n, count - n);
+}
+
+static void sweepSpheresPlaneSse2(const float *plane, const float *spheres, const float *velocities, float *times, unsigned int count)
+{
+    // Sweeps 4 spheres at a time, one sphere per lane.
+
+    const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f), miss = _mm_set1_ps(SWEEP_MISS);
+    const __m128 signBit = _mm_set1_ps(-0.0f);
+    unsigned int n = 0;
+
+    for (; n + 4 <= count; n += 4, spheres += 16, velocities += 12)
+    {
+        __m128 x = _mm_loadu_ps(spheres);
+        __m128 y = _mm_loadu_ps(spheres + 4);
+        __m128 z = _mm_loadu_ps(spheres + 8);
+        __m128 r = _mm_loadu_ps(spheres + 12);
+
+        _MM_TRANSPOSE4_PS(x, y, z, r);
+
+        __m128 vx = _mm_set_ps(velocities[9], velocities[6], velocities[3], velocities[0]);
+        __m128 vy = _mm_set_ps(velocities[10], velocities[7], velocities[4], velocities[1]);
+        __m128 vz = _mm_set_ps(velocities[11], velocities[8], velocities[5], velocities[2]);
+        __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(plane[0])), _mm_mul_ps(y, _mm_set1_ps(plane[1]))),
+            _mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(plane[2])), _mm_set1_ps(plane[3])));
+        __m128 speed = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, _mm_set1_ps(plane[0])), _mm_mul_ps(vy, _mm_set1_ps(plane[1]))),
+            _mm_mul_ps(vz, _mm_set1_ps(plane[2])));
+        __m128 absD = _mm_andnot_ps(signBit, d);
+        __m128 time = _mm_div_ps(_mm_sub_ps(absD, r), _mm_andnot_ps(signBit, speed));
+        __m128 hit = _mm_and_ps(_mm_cmplt_ps(_mm_mul_ps(d, speed), zero), _mm_cmple_ps(time, one));
+
+        time = selectSse2(hit, time, miss);
+        _mm_storeu_ps(times + n, _mm_andnot_ps(_mm_cmple_ps(absD, r), time));
+    }
+
+    sweepSpheresPlaneScalar(plane, spheres, velocities, times + n, count - n);
+}
+
+static void sweepSpheresSphereSse2(const float *sphere, const float *spheres, const float *velocities, float *times, unsigned int count)
+{
+    // Sweeps 4 spheres at a time, one sphere per lane.
+
+    const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f), miss = _mm_set1_ps(SWEEP_MISS);
+    unsigned int n = 0;
+
+    for (; n + 4 <= count; n += 4, spheres += 16, velocities += 12)
+    {
+        __m128 x = _mm_loadu_ps(spheres);
+        __m128 y = _mm_loadu_ps(spheres + 4);
+        __m128 z = _mm_loadu_ps(spheres + 8);
+        __m128 r = _mm_loadu_ps(spheres + 12);
+
+        _MM_TRANSPOSE4_PS(x, y, z, r);
+
+        __m128 vx = _mm_set_ps(velocities[9], velocities[6], velocities[3], velocities[0]);
+        __m128 vy = _mm_set_ps(velocities[10], velocities[7], velocities[4], velocities[1]);
+        __m128 vz = _mm_set_ps(velocities[11], velocities[8], velocities[5], velocities[2]);
+        __m128 sx = _mm_sub_ps(x, _mm_set1_ps(sphere[0]));
+        __m128 sy = _mm_sub_ps(y, _mm_set1_ps(sphere[1]));
+        __m128 sz = _mm_sub_ps(z, _mm_set1_ps(sphere[2]));
+        __m128 radii = _mm_add_ps(r, _mm_set1_ps(sphere[3]));
+        __m128 c = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, sx), _mm_mul_ps(sy, sy)), _mm_mul_ps(sz, sz)), _mm_mul_ps(radii, radii));
+        __m128 b = _mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, vx), _mm_mul_ps(sy, vy)), _mm_mul_ps(sz, vz));
+        __m128 a = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)), _mm_mul_ps(vz, vz));
+        __m128 disc = _mm_sub_ps(_mm_mul_ps(b, b), _mm_mul_ps(a, c));
+        __m128 time = _mm_div_ps(c, _mm_sub_ps(_mm_sqrt_ps(_mm_max_ps(disc, zero)), b));
+        __m128 hit = _mm_and_ps(_mm_and_ps(_mm_cmplt_ps(b, zero), _mm_cmpge_ps(disc, zero)), _mm_cmple_ps(time, one));
+
+        time = selectSse2(hit, time, miss);
+        _mm_storeu_ps(times + n, _mm_andnot_ps(_mm_cmple_ps(c, zero), time));
+    }
+
+    sweepSpheresSphereScalar(sphere, spheres, velocities, times + n, count - n);
+}
+
+static void sweepBoxesBoxSse2(const float *box, const float *boxes, const float *velocities, float *times, unsigned int count)
+{
+    // Sweeps 4 boxes at a time, one box per lane. Lanes that don't move
+    // along an axis take the whole or none of the time line for it.
+
+    const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f), miss = _mm_set1_ps(SWEEP_MISS);
+    const __m128 never = _mm_set1_ps(-SWEEP_MISS);
+    unsigned int n = 0;
+
+    for (; n + 4 <= count; n += 4, boxes += 24, velocities += 12)
+    {
+        __m128 enter = never, exit = miss;
+
+        for (int k = 0; k < 3; ++k)
+        {
+            __m128 lo = _mm_set_ps(boxes[18 + k], boxes[12 + k], boxes[6 + k], boxes[k]);
+            __m128 hi = _mm_set_ps(boxes[21 + k], boxes[15 + k], boxes[9 + k], boxes[3 + k]);
+            __m128 v = _mm_set_ps(velocities[9 + k], velocities[6 + k], velocities[3 + k], velocities[k]);
+            __m128 otherLo = _mm_set1_ps(box[k]), otherHi = _mm_set1_ps(box[3 + k]);
+            __m128 t1 = _mm_div_ps(_mm_sub_ps(otherLo, hi), v);
+            __m128 t2 = _mm_div_ps(_mm_sub_ps(otherHi, lo), v);
+            __m128 still = _mm_cmpeq_ps(v, zero);
+            __m128 overlap = _mm_and_ps(_mm_cmpge_ps(hi, otherLo), _mm_cmple_ps(lo, otherHi));
+
+            enter = _mm_max_ps(enter, selectSse2(still, never, _mm_min_ps(t1, t2)));
+            exit = _mm_min_ps(exit, selectSse2(still, selectSse2(overlap, miss, never), _mm_max_ps(t1, t2)));
+        }
+
+        __m128 hit = _mm_and_ps(_mm_and_ps(_mm_cmple_ps(enter, exit), _mm_cmple_ps(enter, one)), _mm_cmpge_ps(exit, zero));
+
+        _mm_storeu_ps(times + n, selectSse2(hit, _mm_max_ps(enter, zero), miss));
+    }
+
+    sweepBoxesBoxScalar(box, boxes, velocities, times + n, count - n);
+}
+
+static void sweepSpheresBoxSse2(const float *box, const float *spheres, const float *velocities, float *times, unsigned int count)
+{
+    // Sweeps 4 spheres at a time, one sphere per lane, against the box
+    // grown by each radius. The lanes that enter it beyond two or three
+    // faces, where the grown box is rounded, are finished by the scalar
+    // kernel.
+
+    const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f), miss = _mm_set1_ps(SWEEP_MISS);
+    const __m128 never = _mm_set1_ps(-SWEEP_MISS);
+    unsigned int n = 0;
+
+    for (; n + 4 <= count; n += 4, spheres += 16, velocities += 12)
+    {
+        __m128 c[4];
+
+        for (int k = 0; k < 4; ++k)
+            c[k] = _mm_loadu_ps(spheres + k * 4);
+
+        _MM_TRANSPOSE4_PS(c[0], c[1], c[2], c[3]);
+
+        __m128 r = c[3];
+        __m128 v[3], distanceSq = zero, enter = never, exit = miss;
+
+        for (int k = 0; k < 3; ++k)
+        {
+            __m128 lo = _mm_set1_ps(box[k]), hi = _mm_set1_ps(box[3 + k]);
+            __m128 outside = _mm_max_ps(_mm_max_ps(_mm_sub_ps(lo, c[k]), _mm_sub_ps(c[k], hi)), zero);
+            __m128 grownLo = _mm_sub_ps(lo, r), grownHi = _mm_add_ps(hi, r);
+
+            v[k] = _mm_set_ps(velocities[9 + k], velocities[6 + k], velocities[3 + k], velocities[k]);
+
+            __m128 t1 = _mm_div_ps(_mm_sub_ps(grownLo, c[k]), v[k]);
+            __m128 t2 = _mm_div_ps(_mm_sub_ps(grownHi, c[k]), v[k]);
+            __m128 still = _mm_cmpeq_ps(v[k], zero);
+            __m128 overlap = _mm_and_ps(_mm_cmpge_ps(c[k], grownLo), _mm_cmple_ps(c[k], grownHi));
+
+            distanceSq = _mm_add_ps(distanceSq, _mm_mul_ps(outside, outside));
+            enter = _mm_max_ps(enter, selectSse2(still, never, _mm_min_ps(t1, t2)));
+            exit = _mm_min_ps(exit, selectSse2(still, selectSse2(overlap, miss, never), _mm_max_ps(t1, t2)));
+        }
+
+        __m128 touching = _mm_cmple_ps(distanceSq, _mm_mul_ps(r, r));
+        __m128 hit = _mm_and_ps(_mm_and_ps(_mm_cmple_ps(enter, exit), _mm_cmple_ps(enter, one)), _mm_cmpge_ps(exit, zero));
+        __m128 time = _mm_max_ps(enter, zero);
+        __m128 corners = zero;
+
+        for (int k = 0; k < 3; ++k)
+        {
+            __m128 p = _mm_add_ps(c[k], _mm_mul_ps(v[k], time));
+            __m128 outside = _mm_or_ps(_mm_cmplt_ps(p, _mm_set1_ps(box[k])), _mm_cmpgt_ps(p, _mm_set1_ps(box[3 + k])));
+
+            corners = _mm_add_ps(corners, _mm_and_ps(outside, one));
+        }
+
+        time = _mm_andnot_ps(touching, selectSse2(hit, time, miss));
+        _mm_storeu_ps(times + n, time);
+
+        int rounded = _mm_movemask_ps(_mm_andnot_ps(touching, _mm_and_ps(hit, _mm_cmpge_ps(corners, _mm_set1_ps(2.0f)))));
+
+        for (int k = 0; k < 4; ++k)
+        {
+            if ((rounded >> k) & 1)
+                times[n + k] = sweepSphereCornerScalar(box, spheres + k * 4, velocities + k * 3, times[n + k]);
+        }
+    }
+
+    sweepSpheresBoxScalar(box, spheres, velocities, times + n, count - n);
+}
+
+#endif
+
+//-----------------------------------------------------------------------------
+// AVX2 kernels.
+
+#if defined(BATCH_KERNELS_AVX2)
+
+static void multiplyAvx2(const float *lhs, const float *rhs, float *result, unsigned int count)
+{
+    // Works on two rows of the result at a time. Each 128-bit half of the
+    // registers holds one row, and the rows of 'rhs' are broadcast to both
+    // halves.
+
+    for (unsigned int n = 0; n < count; ++n, lhs += 16, rhs += 16, result += 16)
+    {
+        __m256 r0 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(rhs + 0));
+        __m256 r1 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(rhs + 4));
+        __m256 r2 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(rhs + 8));
+        __m256 r3 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(rhs + 12));
+
+        for (int i = 0; i < 16; i += 8)
+        {
+            __m256 l = _mm256_loadu_ps(lhs + i);
+            __m256 v = _mm256_mul_ps(_mm256_permute_ps(l, 0x00), r0);
+
+            v = _mm256_fmadd_ps(_mm256_permute_ps(l, 0x55), r1, v);
+            v = _mm256_fmadd_ps(_mm256_permute_ps(l, 0xaa), r2, v);
+            v = _mm256_fmadd_ps(_mm256_permute_ps(l, 0xff), r3, v);
+            _mm256_storeu_ps(result + i, v);
+        }
+    }
+}
+
+static void multiplyDoublesAvx2(const double *lhs, const double *rhs, double *result, unsigned int count)
+{
+    // A row of a double precision matrix is exactly one register, so each
+    // row of the result is a linear combination of the rows of 'rhs'.
+
+    for (unsigned int n = 0; n < count; ++n, lhs += 16, rhs += 16, result += 16)
+    {
+        __m256d r0 = _mm256_loadu_pd(rhs + 0);
+        __m256d r1 = _mm256_loadu_pd(rhs + 4);
+        __m256d r2 = _mm256_loadu_pd(rhs + 8);
+        __m256d r3 = _mm256_loadu_pd(rhs + 12);
+        double l[16];
+
+        memcpy(l, lhs, sizeof(l));
+
+        for (int i = 0; i < 4; ++i)
+        {
+            __m256d v = _mm256_mul_pd(_mm256_set1_pd(l[i * 4 + 0]), r0);
+
+            v = _mm256_fmadd_pd(_mm256_set1_pd(l[i * 4 + 1]), r1, v);
+            v = _mm256_fmadd_pd(_mm256_set1_pd(l[i * 4 + 2]), r2, v);
+            v = _mm256_fmadd_pd(_mm256_set1_pd(l[i * 4 + 3]), r3, v);
+            _mm256_storeu_pd(result + i * 4, v);
+        }
+    }
+}
+
+static void transformPointsAvx2(const float *m, const float *points, float *result, unsigned int count)
+{
+    // Works on two points at a time, one per 128-bit half.
+
+    __m256 r0 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(m + 0));
+    __m256 r1 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(m + 4));
+    __m256 r2 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(m + 8));
+    __m256 r3 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(m + 12));
+    unsigned int n = 0;
+
+    for (; n + 2 <= count; n += 2, points += 6, result += 6)
+    {
+        __m256 x = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_set1_ps(points[0])), _mm_set1_ps(points[3]), 1);
+        __m256 y = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_set1_ps(points[1])), _mm_set1_ps(points[4]), 1);
+        __m256 z = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_set1_ps(points[2])), _mm_set1_ps(points[5]), 1);
+        __m256 v = _mm256_fmadd_ps(x, r0, r3);
+
+        v = _mm256_fmadd_ps(y, r1, v);
+        v = _mm256_fmadd_ps(z, r2, v);
+
+        __m128 a = _mm256_castps256_ps128(v);
+        __m128 b = _mm256_extractf128_ps(v, 1);
+
+        _mm_storel_pi(reinterpret_cast<__m64 *>(result), a);
+        _mm_store_ss(result + 2, _mm_movehl_ps(a, a));
+        _mm_storel_pi(reinterpret_cast<__m64 *>(result + 3), b);
+        _mm_store_ss(result + 5, _mm_movehl_ps(b, b));
+    }
+
+    transformPointsSse2(m, points, result, count - n);
+}
+
+static void rebasePointsAvx2(const double *origin, const double *points, float *result, unsigned int count)
+{
+    // Works on four points (twelve doubles) at a time. The origin is
+    // repeated in the three rotations that line up with the packed x, y, z
+    // components.
+
+    __m256d o0 = _mm256_setr_pd(origin[0], origin[1], origin[2], origin[0]);
+    __m256d o1 = _mm256_setr_pd(origin[1], origin[2], origin[0], origin[1]);
+    __m256d o2 = _mm256_setr_pd(origin[2], origin[0], origin[1], origin[2]);
+    unsigned int n = 0;
+
+    for (; n + 4 <= count; n += 4, points += 12, result += 12)
+    {
+        _mm_storeu_ps(result + 0, _mm256_cvtpd_ps(_mm256_sub_pd(_mm256_loadu_pd(points + 0), o0)));
+        _mm_storeu_ps(result + 4, _mm256_cvtpd_ps(_mm256_sub_pd(_mm256_loadu_pd(points + 4), o1)));
+        _mm_storeu_ps(result + 8, _mm256_cvtpd_ps(_mm256_sub_pd(_mm256_loadu_pd(points + 8), o2)));
+    }
+
+    rebasePointsSse2(origin, points, result, count - n);
+}
+
+static void cullBoxesAvx2(const float *planes, const float *boxes, bool *visible, unsigned int count)
+{
+    // Tests 8 boxes at a time, one box per lane. The box bounds are
+    // gathered straight from the array of boxes.
+
+    const __m256i offsets = _mm256_setr_epi32(0, 6, 12, 18, 24, 30, 36, 42);
+    unsigned int n = 0;
+
+    for (; n + 8 <= count; n += 8, boxes += 48)
+    {
+        __m256 bounds[6];
+
+        for (int k = 0; k < 6; ++k)
+            bounds[k] = _mm256_i32gather_ps(boxes + k, offsets, 4);
+
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+        for (int i = 0; i < 6; ++i)
+        {
+            const float *p = planes + i * 4;
+            __m256 x = bounds[(p[0] > 0.0f) ? 3 : 0];
+            __m256 y = bounds[(p[1] > 0.0f) ? 4 : 1];
+            __m256 z = bounds[(p[2] > 0.0f) ? 5 : 2];
+            __m256 d = _mm256_fmadd_ps(x, _mm256_set1_ps(p[0]), _mm256_set1_ps(p[3]));
+
+            d = _mm256_fmadd_ps(y, _mm256_set1_ps(p[1]), d);
+            d = _mm256_fmadd_ps(z, _mm256_set1_ps(p[2]), d);
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(d, _mm256_setzero_ps(), _CMP_GT_OQ));
+        }
+
+        int mask = _mm256_movemask_ps(inside);
+
+        for (int k = 0; k < 8; ++k)
+            visible[n + k] = ((mask >> k) & 1) != 0;
+    }
+
+    cullBoxesSse2(planes, boxes, visible + n, count - n);
+}
+
+static void cullBoxesClipSpaceAvx2(const float *matrices, const float *boxes, unsigned int boxStride, bool *visible, unsigned int count)
+{
+    // Two boxes per iteration, one per 128-bit half, each laid out as in
+    // cullBoxesClipSpaceSse2().
+
+    const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    const __m256 half = _mm256_set1_ps(0.5f);
+    unsigned int n = 0;
+
+    for (; n + 2 <= count; n += 2, matrices += 32, boxes += 2 * boxStride)
+    {
+        const float *m0 = matrices;
+        const float *m1 = matrices + 16;
+        const float *b0 = boxes;
+        const float *b1 = boxes + boxStride;
+        __m256 r0 = _mm256_loadu2_m128(m1 + 0, m0 + 0);
+        __m256 r1 = _mm256_loadu2_m128(m1 + 4, m0 + 4);
+        __m256 r2 = _mm256_loadu2_m128(m1 + 8, m0 + 8);
+        __m256 r3 = _mm256_loadu2_m128(m1 + 12, m0 + 12);
+        __m256 lo = _mm256_setr_ps(b0[0], b0[1], b0[2], 0.0f, b1[0], b1[1], b1[2], 0.0f);
+        __m256 hi = _mm256_setr_ps(b0[3], b0[4], b0[5], 0.0f, b1[3], b1[4], b1[5], 0.0f);
+        __m256 center = _mm256_mul_ps(_mm256_add_ps(lo, hi), half);
+        __m256 extent = _mm256_mul_ps(_mm256_sub_ps(hi, lo), half);
+
+        __m256 c = _mm256_fmadd_ps(_mm256_permute_ps(center, 0x00), r0, r3);
+        c = _mm256_fmadd_ps(_mm256_permute_ps(center, 0x55), r1, c);
+        c = _mm256_fmadd_ps(_mm256_permute_ps(center, 0xaa), r2, c);
+
+        __m256 e = _mm256_mul_ps(_mm256_permute_ps(extent, 0x00), _mm256_and_ps(r0, absMask));
+        e = _mm256_fmadd_ps(_mm256_permute_ps(extent, 0x55), _mm256_and_ps(r1, absMask), e);
+        e = _mm256_fmadd_ps(_mm256_permute_ps(extent, 0xaa), _mm256_and_ps(r2, absMask), e);
+
+        __m256 ce = _mm256_add_ps(c, e);
+        __m256 w = _mm256_permute_ps(ce, 0xff);
+        __m256 inside = _mm256_and_ps(_mm256_cmp_ps(_mm256_add_ps(ce, w), _mm256_setzero_ps(), _CMP_GT_OQ),
+            _mm256_cmp_ps(_mm256_sub_ps(_mm256_add_ps(w, e), c), _mm256_setzero_ps(), _CMP_GT_OQ));
+        int mask = _mm256_movemask_ps(inside);
+
+        visible[n] = (mask & 0x07) == 0x07;
+        visible[n + 1] = (mask & 0x70) == 0x70;
+    }
+
+    cullBoxesClipSpaceSse2(matrices, boxes, boxStride, visible + n, count - n);
+}
+
+static void cullBoxesMultiAvx2(const float *frustums, unsigned int frustumCount, const float *boxes, unsigned int *masks, unsigned int count)
+{
+    // Tests 8 boxes at a time against every frustum, one box per lane. The
+    // planes are set up once, as in cullBoxesMultiSse2().
+
+    __m256 coefficients[BATCH_MAX_CULL_FRUSTUMS * 6][4];
+    int corners[BATCH_MAX_CULL_FRUSTUMS * 6][3];
+    unsigned int planeCount = frustumCount * 6;
+
+    for (unsigned int i = 0; i < planeCount; ++i)
+    {
+        const float *p = frustums + i * 4;
+
+        for (int j = 0; j < 4; ++j)
+            coefficients[i][j] = _mm256_set1_ps(p[j]);
+
+        for (int j = 0; j < 3; ++j)
+            corners[i][j] = (p[j] > 0.0f) ? j + 3 : j;
+    }
+
+    const __m256i offsets = _mm256_setr_epi32(0, 6, 12, 18, 24, 30, 36, 42);
+    unsigned int n = 0;
+
+    for (; n + 8 <= count; n += 8, boxes += 48)
+    {
+        __m256 bounds[6];
+
+        for (int k = 0; k < 6; ++k)
+            bounds[k] = _mm256_i32gather_ps(boxes + k, offsets, 4);
+
+        __m256i mask = _mm256_setzero_si256();
+
+        for (unsigned int f = 0; f < frustumCount; ++f)
+        {
+            __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+            for (unsigned int i = f * 6; i < f * 6 + 6; ++i)
+            {
+                const __m256 *p = coefficients[i];
+                __m256 d = _mm256_fmadd_ps(bounds[corners[i][0]], p[0], p[3]);
+
+                d = _mm256_fmadd_ps(bounds[corners[i][1]], p[1], d);
+                d = _mm256_fmadd_ps(bounds[corners[i][2]], p[2], d);
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(d, _mm256_setzero_ps(), _CMP_GT_OQ));
+
+                if (_mm256_movemask_ps(inside) == 0)
+                    break;
+            }
+
+            __m256i bit = _mm256_set1_epi32(static_cast<int>(1u << f));
+            mask = _mm256_or_si256(mask, _mm256_and_si256(_mm256_castps_si256(inside), bit));
+        }
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(masks + n), mask);
+    }
+
+    cullBoxesMultiSse2(frustums, frustumCount, boxes, masks + n, count - n);
+}
+
+static void cullSpheresMultiAvx2(const float *frustums, unsigned int frustumCount, const float *spheres, unsigned int *masks, unsigned int count)
+{
+    // Tests 8 spheres at a time against every frustum, one sphere per lane.
+
+    const __m256i offsets = _mm256_setr_epi32(0, 4, 8, 12, 16, 20, 24, 28);
+    unsigned int n = 0;
+
+    for (; n + 8 <= count; n += 8, spheres += 32)
+    {
+        __m256 x = _mm256_i32gather_ps(spheres, offsets, 4);
+        __m256 y = _mm256_i32gather_ps(spheres + 1, offsets, 4);
+        __m256 z = _mm256_i32gather_ps(spheres + 2, offsets, 4);
+        __m256 negRadius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_i32gather_ps(spheres + 3, offsets, 4));
+        __m256i mask = _mm256_setzero_si256();
+
+        for (unsigned int f = 0; f < frustumCount; ++f)
+        {
+            __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+            for (int i = 0; i < 6; ++i)
+            {
+                const float *p = frustums + f * 24 + i * 4;
+                __m256 d = _mm256_fmadd_ps(x, _mm256_set1_ps(p[0]), _mm256_set1_ps(p[3]));
+
+                d = _mm256_fmadd_ps(y, _mm256_set1_ps(p[1]), d);
+                d = _mm256_fmadd_ps(z, _mm256_set1_ps(p[2]), d);
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(d, negRadius, _CMP_GT_OQ));
+
+                if (_mm256_movemask_ps(inside) == 0)
+                    break;
+            }
+
+            __m256i bit = _mm256_set1_epi32(static_cast<int>(1u << f));
+            mask = _mm256_or_si256(mask, _mm256_and_si256(_mm256_castps_si256(inside), bit));
+        }
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(masks + n), mask);
+    }
+
+    cullSpheresMultiSse2(frustums, frustumCount, spheres, masks + n, count - n);
+}
+
+static void cullBoxesVolumeAvx2(const float *planes, unsigned int planeStride, unsigned int planeCount, const float *boxes, bool *visible, unsigned int count)
+{
+    // Tests 8 boxes at a time, one box per lane.
+
+    const __m256i offsets = _mm256_setr_epi32(0, 6, 12, 18, 24, 30, 36, 42);
+    const float *a = planes;
+    const float *b = planes + planeStride;
+    const float *c = planes + 2 * planeStride;
+    const float *d = planes + 3 * planeStride;
+    unsigned int n = 0;
+
+    for (; n + 8 <= count; n += 8, boxes += 48)
+    {
+        __m256 bounds[6];
+
+        for (int k = 0; k < 6; ++k)
+            bounds[k] = _mm256_i32gather_ps(boxes + k, offsets, 4);
+
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+        for (unsigned int i = 0; i < planeCount; ++i)
+        {
+            __m256 x = bounds[(a[i] > 0.0f) ? 3 : 0];
+            __m256 y = bounds[(b[i] > 0.0f) ? 4 : 1];
+            __m256 z = bounds[(c[i] > 0.0f) ? 5 : 2];
+            __m256 dist = _mm256_fmadd_ps(x, _mm256_set1_ps(a[i]), _mm256_set1_ps(d[i]));
+
+            dist = _mm256_fmadd_ps(y, _mm256_set1_ps(b[i]), dist);
+            dist = _mm256_fmadd_ps(z, _mm256_set1_ps(c[i]), dist);
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(dist, _mm256_setzero_ps(), _CMP_GT_OQ));
+
+            if (_mm256_movemask_ps(inside) == 0)
+                break;
+        }
+
+        int mask = _mm256_movemask_ps(inside);
+
+        for (int k = 0; k < 8; ++k)
+            visible[n + k] = ((mask >> k) & 1) != 0;
+    }
+
+    cullBoxesVolumeSse2(planes, planeStride, planeCount, boxes, visible + n, count - n);
+}
+
+static void cullSpheresVolumeAvx2(const float *planes, unsigned int planeStride, unsigned int planeCount, const float *spheres, bool *visible, unsigned int count)
+{
+    // Tests 8 spheres at a time, one sphere per lane, transposed as in
+    // projectSpheresAvx2().
+
+    const float *a = planes;
+    const float *b = planes + planeStride;
+    const float *c = planes + 2 * planeStride;
+    const float *d = planes + 3 * planeStride;
+    unsigned int n = 0;
+
+    for (; n + 8 <= count; n += 8, spheres += 32)
+    {
+        __m256 s0 = _mm256_loadu2_m128(spheres + 16, spheres + 0);
+        __m256 s1 = _mm256_loadu2_m128(spheres + 20, spheres + 4);
+        __m256 s2 = _mm256_loadu2_m128(spheres + 24, spheres + 8);
+        __m256 s3 = _mm256_loadu2_m128(spheres + 28, spheres + 12);
+        __m256 t0 = _mm256_unpacklo_ps(s0, s1);
+        __m256 t1 = _mm256_unpackhi_ps(s0, s1);
+        __m256 t2 = _mm256_unpacklo_ps(s2, s3);
+        __m256 t3 = _mm256_unpackhi_ps(s2, s3);
+        __m256 x = _mm256_shuffle_ps(t0, t2, 0x44);
+        __m256 y = _mm256_shuffle_ps(t0, t2, 0xee);
+        __m256 z = _mm256_shuffle_ps(t1, t3, 0x44);
+        __m256 negRadius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_shuffle_ps(t1, t3, 0xee));
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+        for (unsigned int i = 0; i < planeCount; ++i)
+        {
+            __m256 dist = _mm256_fmadd_ps(x, _mm256_set1_ps(a[i]), _mm256_set1_ps(d[i]));
+
+            dist = _mm256_fmadd_ps(y, _mm256_set1_ps(b[i]), dist);
+            dist = _mm256_fmadd_ps(z, _mm256_set1_ps(c[i]), dist);
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(dist, negRadius, _CMP_GT_OQ));
+
+            if (_mm256_movemask_ps(inside) == 0)
+                break;
+        }
+
+        int mask = _mm256_movemask_ps(inside);
+
+        for (int k = 0; k < 8; ++k)
+            visible[n + k] = ((mask >> k) & 1) != 0;
+    }
+
+    cullSpheresVolumeSse2(planes, planeStride, planeCount, spheres, visible + n, count - n);
+}
+
+static void classifyPointsAvx2(const float *planes, unsigned int planeCount, const float *points, unsigned char *codes, unsigned int count)
+{
+    // Works on 8 points at a time, 4 per 128-bit half, shuffled as in
+    // classifyPointsSse2().
+
+    unsigned int n = 0;
+
+    for (; n + 8 <= count; n += 8, points += 24)
+    {
+        __m256 v0 = _mm256_loadu2_m128(points + 12, points + 0);
+        __m256 v1 = _mm256_loadu2_m128(points + 16, points + 4);
+        __m256 v2 = _mm256_loadu2_m128(points + 20, points + 8);
+        __m256 t0 = _mm256_shuffle_ps(v1, v2, _MM_SHUFFLE(1, 1, 2, 2));
+        __m256 t1 = _mm256_shuffle_ps(v0, v1, _MM_SHUFFLE(0, 0, 1, 1));
+        __m256 t2 = _mm256_shuffle_ps(v1, v2, _MM_SHUFFLE(2, 2, 3, 3));
+        __m256 t3 = _mm256_shuffle_ps(v0, v1, _MM_SHUFFLE(1, 1, 2, 2));
+        __m256 t4 = _mm256_shuffle_ps(v2, v2, _MM_SHUFFLE(3, 3, 0, 0));
+        __m256 x = _mm256_shuffle_ps(v0, t0, _MM_SHUFFLE(2, 0, 3, 0));
+        __m256 y = _mm256_shuffle_ps(t1, t2, _MM_SHUFFLE(2, 0, 2, 0));
+        __m256 z = _mm256_shuffle_ps(t3, t4, _MM_SHUFFLE(2, 0, 2, 0));
+        __m256i code = _mm256_setzero_si256();
+
+        for (unsigned int i = 0; i < planeCount; ++i)
+        {
+            const float *p = planes + i * 4;
+            __m256 d = _mm256_fmadd_ps(x, _mm256_set1_ps(p[0]), _mm256_mul_ps(y, _mm256_set1_ps(p[1])));
+
+            d = _mm256_add_ps(_mm256_fmadd_ps(z, _mm256_set1_ps(p[2]), d), _mm256_set1_ps(p[3]));
+
+            __m256i behind = _mm256_castps_si256(_mm256_cmp_ps(d, _mm256_setzero_ps(), _CMP_LT_OQ));
+            code = _mm256_or_si256(code, _mm256_and_si256(behind, _mm256_set1_epi32(1 << i)));
+        }
+
+        __m128i packed = _mm_packs_epi32(_mm256_castsi256_si128(code), _mm256_extracti128_si256(code, 1));
+
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(codes + n), _mm_packus_epi16(packed, packed));
+    }
+
+    classifyPointsSse2(planes, planeCount, points, codes + n, count - n);
+}
+
+static void projectBoxesAvx2(const float *m, const float *boxes, float *rects, float *depths, unsigned int count)
+{
+    // Projects 8 boxes at a time, one box per lane, as projectBoxesSse2()
+    // does. The rectangles are transposed within each 128-bit half and the
+    // halves are then paired up for the stores.
+
+    const __m256i offsets = _mm256_setr_epi32(0, 6, 12, 18, 24, 30, 36, 42);
+    unsigned int n = 0;
+
+    for (; n + 8 <= count; n += 8, boxes += 48, rects += 32)
+    {
+        __m256 bounds[6];
+
+        for (int k = 0; k < 6; ++k)
+            bounds[k] = _mm256_i32gather_ps(boxes + k, offsets, 4);
+
+        __m256 terms[3][2][3];
+
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            for (int side = 0; side < 2; ++side)
+            {
+                __m256 v = bounds[side * 3 + axis];
+
+                if (axis == 2)
+                {
+                    terms[2][side][0] = _mm256_fmadd_ps(v, _mm256_set1_ps(m[8]), _mm256_set1_ps(m[12]));
+                    terms[2][side][1] = _mm256_fmadd_ps(v, _mm256_set1_ps(m[9]), _mm256_set1_ps(m[13]));
+                    terms[2][side][2] = _mm256_fmadd_ps(v, _mm256_set1_ps(m[11]), _mm256_set1_ps(m[15]));
+                }
+                else
+                {
+                    terms[axis][side][0] = _mm256_mul_ps(v, _mm256_set1_ps(m[axis * 4 + 0]));
+                    terms[axis][side][1] = _mm256_mul_ps(v, _mm256_set1_ps(m[axis * 4 + 1]));
+                    terms[axis][side][2] = _mm256_mul_ps(v, _mm256_set1_ps(m[axis * 4 + 3]));
+                }
+            }
+        }
+
+        __m256 minX = _mm256_set1_ps(3.402823466e+38f), minY = minX, minW = minX;
+        __m256 maxX = _mm256_set1_ps(-3.402823466e+38f), maxY = maxX;
+
+        for (int i = 0; i < 8; ++i)
+        {
+            int sx = i & 1, sy = (i >> 1) & 1, sz = i >> 2;
+            __m256 cx = _mm256_add_ps(_mm256_add_ps(terms[0][sx][0], terms[1][sy][0]), terms[2][sz][0]);
+            __m256 cy = _mm256_add_ps(_mm256_add_ps(terms[0][sx][1], terms[1][sy][1]), terms[2][sz][1]);
+            __m256 cw = _mm256_add_ps(_mm256_add_ps(terms[0][sx][2], terms[1][sy][2]), terms[2][sz][2]);
+
+            minW = _mm256_min_ps(minW, cw);
+            cx = _mm256_div_ps(cx, cw);
+            cy = _mm256_div_ps(cy, cw);
+            minX = _mm256_min_ps(minX, cx);
+            maxX = _mm256_max_ps(maxX, cx);
+            minY = _mm256_min_ps(minY, cy);
+            maxY = _mm256_max_ps(maxY, cy);
+        }
+
+        __m256 behind = _mm256_cmp_ps(minW, _mm256_setzero_ps(), _CMP_LE_OQ);
+
+        minX = _mm256_blendv_ps(minX, _mm256_set1_ps(-1.0f), behind);
+        minY = _mm256_blendv_ps(minY, _mm256_set1_ps(-1.0f), behind);
+        maxX = _mm256_blendv_ps(maxX, _mm256_set1_ps(1.0f), behind);
+        maxY = _mm256_blendv_ps(maxY, _mm256_set1_ps(1.0f), behind);
+
+        // After the transpose tK holds box K in its low half and box K + 4
+        // in its high half.
+        __m256 a = _mm256_unpacklo_ps(minX, minY);
+        __m256 b = _mm256_unpackhi_ps(minX, minY);
+        __m256 c = _mm256_unpacklo_ps(maxX, maxY);
+        __m256 d = _mm256_unpackhi_ps(maxX, maxY);
+        __m256 t0 = _mm256_shuffle_ps(a, c, 0x44);
+        __m256 t1 = _mm256_shuffle_ps(a, c, 0xee);
+        __m256 t2 = _mm256_shuffle_ps(b, d, 0x44);
+        __m256 t3 = _mm256_shuffle_ps(b, d, 0xee);
+
+        _mm256_storeu_ps(rects + 0, _mm256_permute2f128_ps(t0, t1, 0x20));
+        _mm256_storeu_ps(rects + 8, _mm256_permute2f128_ps(t2, t3, 0x20));
+        _mm256_storeu_ps(rects + 16, _mm256_permute2f128_ps(t0, t1, 0x31));
+        _mm256_storeu_ps(rects + 24, _mm256_permute2f128_ps(t2, t3, 0x31));
+        _mm256_storeu_ps(depths + n, minW);
+    }
+
+    projectBoxesSse2(m, boxes, rects, depths + n, count - n);
+}
+
+static void projectSpheresAvx2(const float *view, float projScale, const float *spheres, float *depths, float *radii, unsigned int count)
+{
+    // Projects 8 spheres at a time, one sphere per lane. Spheres K and K + 4
+    // are loaded into the two halves of one register, and the 4 registers
+    // are transposed within each half as in projectSpheresSse2(), which is
+    // faster than gathering the components.
+
+    __m256 v2 = _mm256_set1_ps(view[2]);
+    __m256 v6 = _mm256_set1_ps(view[6]);
+    __m256 v10 = _mm256_set1_ps(view[10]);
+    __m256 v14 = _mm256_set1_ps(view[14]);
+    __m256 s = _mm256_set1_ps(projScale);
+    unsigned int n = 0;
+
+    for (; n + 8 <= count; n += 8, spheres += 32)
+    {
+        __m256 a = _mm256_loadu2_m128(spheres + 16, spheres + 0);
+        __m256 b = _mm256_loadu2_m128(spheres + 20, spheres + 4);
+        __m256 c = _mm256_loadu2_m128(spheres + 24, spheres + 8);
+        __m256 e = _mm256_loadu2_m128(spheres + 28, spheres + 12);
+        __m256 t0 = _mm256_unpacklo_ps(a, b);
+        __m256 t1 = _mm256_unpackhi_ps(a, b);
+        __m256 t2 = _mm256_unpacklo_ps(c, e);
+        __m256 t3 = _mm256_unpackhi_ps(c, e);
+        __m256 x = _mm256_shuffle_ps(t0, t2, 0x44);
+        __m256 y = _mm256_shuffle_ps(t0, t2, 0xee);
+        __m256 z = _mm256_shuffle_ps(t1, t3, 0x44);
+        __m256 r = _mm256_shuffle_ps(t1, t3, 0xee);
+        __m256 d = _mm256_fmadd_ps(x, v2, v14);
+
+        d = _mm256_fmadd_ps(y, v6, d);
+        d = _mm256_fmadd_ps(z, v10, d);
+        d = _mm256_sub_ps(_mm256_setzero_ps(), d);
+
+        __m256 front = _mm256_cmp_ps(d, r, _CMP_GT_OQ);
+        __m256 projected = _mm256_div_ps(_mm256_mul_ps(r, s), _mm256_sqrt_ps(_mm256_fmsub_ps(d, d, _mm256_mul_ps(r, r))));
+
+        _mm256_storeu_ps(depths + n, d);
+        _mm256_storeu_ps(radii + n, _mm256_blendv_ps(_mm256_set1_ps(3.402823466e+38f), projected, front));
+    }
+
+    projectSpheresSse2(view, projScale, spheres, depths + n, radii + n, count - n);
+}
+
+static void selectLodsAvx2(const float *sizes, const float *thresholds, unsigned int thresholdCount, unsigned int *lods, unsigned int count)
+{
+    // Selects 8 LODs at a time, gathering the k-th threshold of each object.
+
+    int stride = static_cast<int>(thresholdCount);
+    const __m256i offsets = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(stride));
+    unsigned int n = 0;
+
+    for (; n + 8 <= count; n += 8)
+    {
+        __m256 size = _mm256_loadu_ps(sizes + n);
+        __m256i lod = _mm256_setzero_si256();
+        const float *t = thresholds + n * thresholdCount;
+
+        for (unsigned int k = 0; k < thresholdCount; ++k)
+        {
+            __m256 below = _mm256_cmp_ps(size, _mm256_i32gather_ps(t + k, offsets, 4), _CMP_LT_OQ);
+            lod = _mm256_sub_epi32(lod, _mm256_castps_si256(below));
+        }
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(lods + n), lod);
+    }
+
+    selectLodsSse2(sizes + n, thresholds + n * thresholdCount, thresholdCount, lods + n, count - n);
+}
+
+static void rayIntersectsBoxesAvx2(const float *ray, const float *boxes, bool *hit, unsigned int count)
+{
+    // Tests 8 boxes at a time, one box per lane.
+
+    const __m256i offsets = _mm256_setr_epi32(0, 6, 12, 18, 24, 30, 36, 42);
+    __m256 o[3], inv[3];
+    unsigned int n = 0;
+
+    for (int k = 0; k < 3; ++k)
+        o[k] = _mm256_set1_ps(ray[k]), inv[k] = _mm256_set1_ps(1.0f / ray[3 + k]);
+
+    for (; n + 8 <= count; n += 8, boxes += 48)
+    {
+        __m256 tmin = _mm256_setzero_ps();
+        __m256 tmax = _mm256_set1_ps(3.402823466e+38f);
+
+        for (int k = 0; k < 3; ++k)
+        {
+            __m256 lo = _mm256_i32gather_ps(boxes + k, offsets, 4);
+            __m256 hi = _mm256_i32gather_ps(boxes + 3 + k, offsets, 4);
+            __m256 t1 = _mm256_mul_ps(_mm256_sub_ps(lo, o[k]), inv[k]);
+            __m256 t2 = _mm256_mul_ps(_mm256_sub_ps(hi, o[k]), inv[k]);
+
+            tmin = _mm256_max_ps(tmin, _mm256_min_ps(t1, t2));
+            tmax = _mm256_min_ps(tmax, _mm256_max_ps(t1, t2));
+        }
+
+        int mask = _mm256_movemask_ps(_mm256_cmp_ps(tmax, tmin, _CMP_GE_OQ));
+
+        for (int k = 0; k < 8; ++k)
+            hit[n + k] = ((mask >> k) & 1) != 0;
+    }
+
+    rayIntersectsBoxesSse2(ray, boxes, hit + n, count - n);
+}
+
+static void cullCapsulesAvx2(const float *planes, const float *const *capsules, bool *visible, unsigned int count)
+{
+    // Tests 8 capsules at a time, one capsule per lane.
+
+    unsigned int n = 0;
+
+    for (; n + 8 <= count; n += 8)
+    {
+        __m256 c[7];
+
+        for (int k = 0; k < 7; ++k)
+            c[k] = _mm256_loadu_ps(capsules[k] + n);
+
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+        for (int i = 0; i < 6; ++i)
+        {
+            const float *p = planes + i * 4;
+            __m256 a = _mm256_set1_ps(p[0]), b = _mm256_set1_ps(p[1]), cc = _mm256_set1_ps(p[2]), d = _mm256_set1_ps(p[3]);
+            __m256 da = _mm256_fmadd_ps(c[2], cc, _mm256_fmadd_ps(c[1], b, _mm256_fmadd_ps(c[0], a, d)));
+            __m256 db = _mm256_fmadd_ps(c[5], cc, _mm256_fmadd_ps(c[4], b, _mm256_fmadd_ps(c[3], a, d)));
+
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(_mm256_max_ps(da, db), c[6]), _mm256_setzero_ps(), _CMP_GT_OQ));
+        }
+
+        int mask = _mm256_movemask_ps(inside);
+
+        for (int k = 0; k < 8; ++k)
+            visible[n + k] = ((mask >> k) & 1) != 0;
+    }
+
+    const float *rest[7];
+
+    for (int k = 0; k < 7; ++k)
+        rest[k] = capsules[k] + n;
+
+    cullCapsulesSse2(planes, rest, visible + n, count - n);
+}
+
+static void segmentIntersectsCapsulesAvx2(const float *segment, const float *const *capsules, bool *hit, unsigned int count)
+{
+    // Tests 8 capsules at a time, one capsule per lane, as in the SSE2
+    // kernel.
+
+    const float e = segment[3] * segment[3] + segment[4] * segment[4] + segment[5] * segment[5];
+    const bool point = e <= SEGMENT_EPSILON;
+    const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.0f);
+    const __m256 ve = _mm256_set1_ps(e), vtMax = _mm256_set1_ps(segment[7]);
+    const __m256 epsilon = _mm256_set1_ps(SEGMENT_EPSILON);
+    __m256 p[3], d[3];
+    unsigned int n = 0;
+
+    for (int k = 0; k < 3; ++k)
+        p[k] = _mm256_set1_ps(segment[k]), d[k] = _mm256_set1_ps(segment[3 + k]);
+
+    for (; n + 8 <= count; n += 8)
+    {
+        __m256 u[3], r[3];
+
+        for (int k = 0; k < 3; ++k)
+        {
+            __m256 start = _mm256_loadu_ps(capsules[k] + n);
+
+            u[k] = _mm256_sub_ps(_mm256_loadu_ps(capsules[3 + k] + n), start);
+            r[k] = _mm256_sub_ps(start, p[k]);
+        }
+
+        __m256 a = _mm256_fmadd_ps(u[2], u[2], _mm256_fmadd_ps(u[1], u[1], _mm256_mul_ps(u[0], u[0])));
+        __m256 c = _mm256_fmadd_ps(u[2], r[2], _mm256_fmadd_ps(u[1], r[1], _mm256_mul_ps(u[0], r[0])));
+        __m256 line = _mm256_cmp_ps(a, epsilon, _CMP_GT_OQ);
+        __m256 s, t;
+
+        if (point)
+        {
+            s = _mm256_and_ps(line, _mm256_min_ps(_mm256_max_ps(_mm256_div_ps(_mm256_sub_ps(zero, c), a), zero), one));
+            t = zero;
+        }
+        else
+        {
+            __m256 b = _mm256_fmadd_ps(u[2], d[2], _mm256_fmadd_ps(u[1], d[1], _mm256_mul_ps(u[0], d[0])));
+            __m256 f = _mm256_fmadd_ps(d[2], r[2], _mm256_fmadd_ps(d[1], r[1], _mm256_mul_ps(d[0], r[0])));
+            __m256 denom = _mm256_fmsub_ps(a, ve, _mm256_mul_ps(b, b));
+
+            s = _mm256_div_ps(_mm256_fmsub_ps(b, f, _mm256_mul_ps(c, ve)), denom);
+            s = _mm256_and_ps(_mm256_cmp_ps(denom, zero, _CMP_GT_OQ), _mm256_min_ps(_mm256_max_ps(s, zero), one));
+            s = _mm256_and_ps(line, s);
+            t = _mm256_div_ps(_mm256_fmadd_ps(b, s, f), ve);
+
+            __m256 clamped = _mm256_min_ps(_mm256_max_ps(t, zero), vtMax);
+            __m256 again = _mm256_div_ps(_mm256_fmsub_ps(b, clamped, c), a);
+
+            again = _mm256_and_ps(line, _mm256_min_ps(_mm256_max_ps(again, zero), one));
+            s = _mm256_blendv_ps(s, again, _mm256_cmp_ps(t, clamped, _CMP_NEQ_UQ));
+            t = clamped;
+        }
+
+        __m256 distanceSq = zero;
+
+        for (int k = 0; k < 3; ++k)
+        {
+            __m256 w = _mm256_fnmadd_ps(d[k], t, _mm256_fmadd_ps(u[k], s, r[k]));
+
+            distanceSq = _mm256_fmadd_ps(w, w, distanceSq);
+        }
+
+        __m256 radii = _mm256_add_ps(_mm256_set1_ps(segment[6]), _mm256_loadu_ps(capsules[6] + n));
+        int mask = _mm256_movemask_ps(_mm256_cmp_ps(distanceSq, _mm256_mul_ps(radii, radii), _CMP_LE_OQ));
+
+        for (int k = 0; k < 8; ++k)
+            hit[n + k] = ((mask >> k) & 1) != 0;
+    }
+
+    const float *rest[7];
+
+    for (int k = 0; k < 7; ++k)
+        rest[k] = capsules[k] + n;
+
+    segmentIntersectsCapsulesSse2(segment, rest, hit + n, count - n);
+}
+
+static void sweepSpheresPlaneAvx2(const float *plane, const float *spheres, const float *velocities, float *times, unsigned int count)
+{
+    // Sweeps 8 spheres at a time, one sphere per lane.
+
+    const __m256i sphereOffsets = _mm256_setr_epi32(0, 4, 8, 12, 16, 20, 24, 28);
+    const __m256i velocityOffsets = _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21);
+    const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.0f), miss = _mm256_set1_ps(SWEEP_MISS);
+    const __m256 signBit = _mm256_set1_ps(-0.0f);
+    const __m256 px = _mm256_set1_ps(plane[0]), py = _mm256_set1_ps(plane[1]);
+    const __m256 pz = _mm256_set1_ps(plane[2]), pw = _mm256_set1_ps(plane[3]);
+    unsigned int n = 0;
+
+    for (; n + 8 <= count; n += 8, spheres += 32, velocities += 24)
+    {
+        __m256 x = _mm256_i32gather_ps(spheres, sphereOffsets, 4);
+        __m256 y = _mm256_i32gather_ps(spheres + 1, sphereOffsets, 4);
+        __m256 z = _mm256_i32gather_ps(spheres + 2, sphereOffsets, 4);
+        __m256 r = _mm256_i32gather_ps(spheres + 3, sphereOffsets, 4);
+        __m256 vx = _mm256_i32gather_ps(velocities, velocityOffsets, 4);
+        __m256 vy = _mm256_i32gather_ps(velocities + 1, velocityOffsets, 4);
+        __m256 vz = _mm256_i32gather_ps(velocities + 2, velocityOffsets, 4);
+        __m256 d = _mm256_fmadd_ps(z, pz, _mm256_fmadd_ps(y, py, _mm256_fmadd_ps(x, px, pw)));
+        __m256 speed = _mm256_fmadd_ps(vz, pz, _mm256_fmadd_ps(vy, py, _mm256_mul_ps(vx, px)));
+        __m256 absD = _mm256_andnot_ps(signBit, d);
+        __m256 time = _mm256_div_ps(_mm256_sub_ps(absD, r), _mm256_andnot_ps(signBit, speed));
+        __m256 hit = _mm256_and_ps(_mm256_cmp_ps(_mm256_mul_ps(d, speed), zero, _CMP_LT_OQ), _mm256_cmp_ps(time, one, _CMP_LE_OQ));
+
+        time = _mm256_blendv_ps(miss, time, hit);
+        _mm256_storeu_ps(times + n, _mm256_andnot_ps(_mm256_cmp_ps(absD, r, _CMP_LE_OQ), time));
+    }
+
+    sweepSpheresPlaneSse2(plane, spheres, velocities, times + n, count - n);
+}
+
+static void sweepSpheresSphereAvx2(const float *sphere, const float *spheres, const float *velocities, float *times, unsigned int count)
+{
+    // Sweeps 8 spheres at a time, one sphere per lane.
+
+    const __m256i sphereOffsets = _mm256_setr_epi32(0, 4, 8, 12, 16, 20, 24, 28);
+    const __m256i velocityOffsets = _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21);
+    const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.0f), miss = _mm256_set1_ps(SWEEP_MISS);
+    unsigned int n = 0;
+
+    for (; n + 8 <= count; n += 8, spheres += 32, velocities += 24)
+    {
+        __m256 sx = _mm256_sub_ps(_mm256_i32gather_ps(spheres, sphereOffsets, 4), _mm256_set1_ps(sphere[0]));
+        __m256 sy = _mm256_sub_ps(_mm256_i32gather_ps(spheres + 1, sphereOffsets, 4), _mm256_set1_ps(sphere[1]));
+        __m256 sz = _mm256_sub_ps(_mm256_i32gather_ps(spheres + 2, sphereOffsets, 4), _mm256_set1_ps(sphere[2]));
+        __m256 radii = _mm256_add_ps(_mm256_i32gather_ps(spheres + 3, sphereOffsets, 4), _mm256_set1_ps(sphere[3]));
+        __m256 vx = _mm256_i32gather_ps(velocities, velocityOffsets, 4);
+        __m256 vy = _mm256_i32gather_ps(velocities + 1, velocityOffsets, 4);
+        __m256 vz = _mm256_i32gather_ps(velocities + 2, velocityOffsets, 4);
+        __m256 c = _mm256_fmsub_ps(sz, sz, _mm256_fmsub_ps(radii, radii, _mm256_fmadd_ps(sy, sy, _mm256_mul_ps(sx, sx))));
+        __m256 b = _mm256_fmadd_ps(sz, vz, _mm256_fmadd_ps(sy, vy, _mm256_mul_ps(sx, vx)));
+        __m256 a = _mm256_fmadd_ps(vz, vz, _mm256_fmadd_ps(vy, vy, _mm256_mul_ps(vx, vx)));
+        __m256 disc = _mm256_fmsub_ps(b, b, _mm256_mul_ps(a, c));
+        __m256 time = _mm256_div_ps(c, _mm256_sub_ps(_mm256_sqrt_ps(_mm256_max_ps(disc, zero)), b));
+        __m256 hit = _mm256_and_ps(_mm256_cmp_ps(b, zero, _CMP_LT_OQ), _mm256_cmp_ps(disc, zero, _CMP_GE_OQ));
+
+        hit = _mm256_and_ps(hit, _mm256_cmp_ps(time, one, _CMP_LE_OQ));
+        time = _mm256_blendv_ps(miss, time, hit);
+        _mm256_storeu_ps(times + n, _mm256_andnot_ps(_mm256_cmp_ps(c, zero, _CMP_LE_OQ), time));
+    }
+
+    sweepSpheresSphereSse2(sphere, spheres, velocities, times + n, count - n);
+}
+
+static void sweepBoxesBoxAvx2(const float *box, const float *boxes, const float *velocities, float *times, unsigned int count)
+{
+    // Sweeps 8 boxes at a time, one box per lane, as in the SSE2 kernel.
+
+    const __m256i boxOffsets = _mm256_setr_epi32(0, 6, 12, 18, 24, 30, 36, 42);
+    const __m256i velocityOffsets = _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21);
+    const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.0f), miss = _mm256_set1_ps(SWEEP_MISS);
+    const __m256 never = _mm256_set1_ps(-SWEEP_MISS);
+    unsigned int n = 0;
+
+    for (; n + 8 <= count; n += 8, boxes += 48, velocities += 24)
+    {
+        __m256 enter = never, exit = miss;
+
+        for (int k = 0; k < 3; ++k)
+        {
+            __m256 lo = _mm256_i32gather_ps(boxes + k, boxOffsets, 4);
+            __m256 hi = _mm256_i32gather_ps(boxes + 3 + k, boxOffsets, 4);
+            __m256 v = _mm256_i32gather_ps(velocities + k, velocityOffsets, 4);
+            __m256 otherLo = _mm256_set1_ps(box[k]), otherHi = _mm256_set1_ps(box[3 + k]);
+            __m256 t1 = _mm256_div_ps(_mm256_sub_ps(otherLo, hi), v);
+            __m256 t2 = _mm256_div_ps(_mm256_sub_ps(otherHi, lo), v);
+            __m256 still = _mm256_cmp_ps(v, zero, _CMP_EQ_OQ);
+            __m256 overlap = _mm256_and_ps(_mm256_cmp_ps(hi, otherLo, _CMP_GE_OQ), _mm256_cmp_ps(lo, otherHi, _CMP_LE_OQ));
+
+            enter = _mm256_max_ps(enter, _mm256_blendv_ps(_mm256_min_ps(t1, t2), never, still));
+            exit = _mm256_min_ps(exit, _mm256_blendv_ps(_mm256_max_ps(t1, t2), _mm256_blendv_ps(never, miss, overlap), still));
+        }
+
+        __m256 hit = _mm256_and_ps(_mm256_cmp_ps(enter, exit, _CMP_LE_OQ), _mm256_cmp_ps(enter, one, _CMP_LE_OQ));
+
+        hit = _mm256_and_ps(hit, _mm256_cmp_ps(exit, zero, _CMP_GE_OQ));
+        _mm256_storeu_ps(times + n, _mm256_blendv_ps(miss, _mm256_max_ps(enter, zero), hit));
+    }
+
+    sweepBoxesBoxSse2(box, boxes, velocities, times + n, count - n);
+}
+
+static void sweepSpheresBoxAvx2(const float *box, const float *spheres, const float *velocities, float *times, unsigned int count)
+{
+    // Sweeps 8 spheres at a time, one sphere per lane, as in the SSE2
+    // kernel.
+
+    const __m256i sphereOffsets = _mm256_setr_epi32(0, 4, 8, 12, 16, 20, 24, 28);
+    const __m256i velocityOffsets = _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21);
+    const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.0f), miss = _mm256_set1_ps(SWEEP_MISS);
+    const __m256 never = _mm256_set1_ps(-SWEEP_MISS);
+    unsigned int n = 0;
+
+    for (; n + 8 <= count; n += 8, spheres += 32, velocities += 24)
+    {
+        __m256 r = _mm256_i32gather_ps(spheres + 3, sphereOffsets, 4);
+        __m256 c[3], v[3], distanceSq = zero, enter = never, exit = miss;
+
+        for (int k = 0; k < 3; ++k)
+        {
+            __m256 lo = _mm256_set1_ps(box[k]), hi = _mm256_set1_ps(box[3 + k]);
+
+            c[k] = _mm256_i32gather_ps(spheres + k, sphereOffsets, 4);
+            v[k] = _mm256_i32gather_ps(velocities + k, velocityOffsets, 4);
+
+            __m256 outside = _mm256_max_ps(_mm256_max_ps(_mm256_sub_ps(lo, c[k]), _mm256_sub_ps(c[k], hi)), zero);
+            __m256 grownLo = _mm256_sub_ps(lo, r), grownHi = _mm256_add_ps(hi, r);
+            __m256 t1 = _mm256_div_ps(_mm256_sub_ps(grownLo, c[k]), v[k]);
+            __m256 t2 = _mm256_div_ps(_mm256_sub_ps(grownHi, c[k]), v[k]);
+            __m256 still = _mm256_cmp_ps(v[k], zero, _CMP_EQ_OQ);
+            __m256 overlap = _mm256_and_ps(_mm256_cmp_ps(c[k], grownLo, _CMP_GE_OQ), _mm256_cmp_ps(c[k], grownHi, _CMP_LE_OQ));
+
+            distanceSq = _mm256_fmadd_ps(outside, outside, distanceSq);
+            enter = _mm256_max_ps(enter, _mm256_blendv_ps(_mm256_min_ps(t1, t2), never, still));
+            exit = _mm256_min_ps(exit, _mm256_blendv_ps(_mm256_max_ps(t1, t2), _mm256_blendv_ps(never, miss, overlap), still));
+        }
+
+        __m256 touching = _mm256_cmp_ps(distanceSq, _mm256_mul_ps(r, r), _CMP_LE_OQ);
+        __m256 hit = _mm256_and_ps(_mm256_cmp_ps(enter, exit, _CMP_LE_OQ), _mm256_cmp_ps(enter, one, _CMP_LE_OQ));
+        __m256 time = _mm256_max_ps(enter, zero);
+        __m256 corners = zero;
+
+        hit = _mm256_and_ps(hit, _mm256_cmp_ps(exit, zero, _CMP_GE_OQ));
+
+        for (int k = 0; k < 3; ++k)
+        {
+            __m256 p = _mm256_fmadd_ps(v[k], time, c[k]);
+            __m256 outside = _mm256_or_ps(_mm256_cmp_ps(p, _mm256_set1_ps(box[k]), _CMP_LT_OQ),
+                _mm256_cmp_ps(p, _mm256_set1_ps(box[3 + k]), _CMP_GT_OQ));
+
+            corners = _mm256_add_ps(corners, _mm256_and_ps(outside, one));
+        }
+
+        time = _mm256_andnot_ps(touching, _mm256_blendv_ps(miss, time, hit));
+        _mm256_storeu_ps(times + n, time);
+
+        __m256 rounded = _mm256_and_ps(hit, _mm256_cmp_ps(corners, _mm256_set1_ps(2.0f), _CMP_GE_OQ));
+        int mask = _mm256_movemask_ps(_mm256_andnot_ps(touching, rounded));
+
+        for (int k = 0; k < 8; ++k)
+        {
+            if ((mask >> k) & 1)
+                times[n + k] = sweepSphereCornerScalar(box, spheres + k * 4, velocities + k * 3, times[n + k]);
+        }
+    }
+
+    sweepSpheresBoxSse2(box, spheres, velocities, times + n, count - n);
+}
+
+#endif
+
+//-----------------------------------------------------------------------------
+// Fast math kernels, for the array forms of the Math::fast* functions.
+//
+// The kernels are written once against a small set of vector operations and
+// instantiated for SSE2 (4 floats) and AVX2 (8 floats). They follow the
+// scalar fast* functions in mathlib.h step for step, with branches replaced
+// by selects. The scalar table has no fast math kernels: the scalar
+// functions are inline in mathlib.h, which this file can't include, so the
+// Math class loops over them itself. The floats left over after the last
+// full vector are copied to a padded vector so that the whole array is
+// computed by the same kernel.
+
+#if defined(BATCH_KERNELS_SSE2) || defined(BATCH_KERNELS_AVX2)
+
+#if defined(BATCH_KERNELS_SSE2)
+
+struct FastMathSse2
+{
+    typedef __m128 F;
+    typedef __m128i I;
+
+    static const unsigned int WIDTH = 4;
+
+    static F load(const float *p)           { return _mm_loadu_ps(p); }
+    static void store(float *p, F a)        { _mm_storeu_ps(p, a); }
+    static F set1(float f)                  { return _mm_set1_ps(f); }
+    static F add(F a, F b)                  { return _mm_add_ps(a, b); }
+    static F sub(F a, F b)                  { return _mm_sub_ps(a, b); }
+    static F mul(F a, F b)                  { return _mm_mul_ps(a, b); }
+    static F div(F a, F b)                  { return _mm_div_ps(a, b); }
+    static F min(F a, F b)                  { return _mm_min_ps(a, b); }
+    static F max(F a, F b)                  { return _mm_max_ps(a, b); }
+    static F sqrt(F a)                      { return _mm_sqrt_ps(a); }
+    static F rsqrt(F a)                     { return _mm_rsqrt_ps(a); }
+    static F bitAnd(F a, F b)               { return _mm_and_ps(a, b); }
+    static F bitAndNot(F a, F b)            { return _mm_andnot_ps(a, b); }
+    static F bitOr(F a, F b)                { return _mm_or_ps(a, b); }
+    static F bitXor(F a, F b)               { return _mm_xor_ps(a, b); }
+    static F cmpGreater(F a, F b)           { return _mm_cmpgt_ps(a, b); }
+    static F cmpLess(F a, F b)              { return _mm_cmplt_ps(a, b); }
+    static F cmpNotLessEqual(F a, F b)      { return _mm_cmpnle_ps(a, b); }
+    static int moveMask(F a)                { return _mm_movemask_ps(a); }
+    static I roundToInt(F a)                { return _mm_cvtps_epi32(a); }
+    static F toFloat(I a)                   { return _mm_cvtepi32_ps(a); }
+    static I intAdd(I a, int b)             { return _mm_add_epi32(a, _mm_set1_epi32(b)); }
+    static I intAnd(I a, int b)             { return _mm_and_si128(a, _mm_set1_epi32(b)); }
+    static I intOr(I a, int b)              { return _mm_or_si128(a, _mm_set1_epi32(b)); }
+    static I intShiftLeft23(I a)            { return _mm_slli_epi32(a, 23); }
+    static I intShiftRight23(I a)           { return _mm_srli_epi32(a, 23); }
+    static I intSub(I a, I b)               { return _mm_sub_epi32(a, b); }
+    static F intEqual(I a, int b)           { return _mm_castsi128_ps(_mm_cmpeq_epi32(a, _mm_set1_epi32(b))); }
+    static F asFloat(I a)                   { return _mm_castsi128_ps(a); }
+    static I asInt(F a)                     { return _mm_castps_si128(a); }
+};
+
+#else
+
+struct FastMathAvx2
+{
+    typedef __m256 F;
+    typedef __m256i I;
+
+    static const unsigned int WIDTH = 8;
+
+    static F load(const float *p)           { return _mm256_loadu_ps(p); }
+    static void store(float *p, F a)        { _mm256_storeu_ps(p, a); }
+    static F set1(float f)                  { return _mm256_set1_ps(f); }
+    static F add(F a, F b)                  { return _mm256_add_ps(a, b); }
+    static F sub(F a, F b)                  { return _mm256_sub_ps(a, b); }
+    static F mul(F a, F b)                  { return _mm256_mul_ps(a, b); }
+    static F div(F a, F b)                  { return _mm256_div_ps(a, b); }
+    static F min(F a, F b)                  { return _mm256_min_ps(a, b); }
+    static F max(F a, F b)                  { return _mm256_max_ps(a, b); }
+    static F sqrt(F a)                      { return _mm256_sqrt_ps(a); }
+    static F rsqrt(F a)                     { return _mm256_rsqrt_ps(a); }
+    static F bitAnd(F a, F b)               { return _mm256_and_ps(a, b); }
+    static F bitAndNot(F a, F b)            { return _mm256_andnot_ps(a, b); }
+    static F bitOr(F a, F b)                { return _mm256_or_ps(a, b); }
+    static F bitXor(F a, F b)               { return _mm256_xor_ps(a, b); }
+    static F cmpGreater(F a, F b)           { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+    static F cmpLess(F a, F b)              { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+    static F cmpNotLessEqual(F a, F b)      { return _mm256_cmp_ps(a, b, _CMP_NLE_UQ); }
+    static int moveMask(F a)                { return _mm256_movemask_ps(a); }
+    static I roundToInt(F a)                { return _mm256_cvtps_epi32(a); }
+    static F toFloat(I a)                   { return _mm256_cvtepi32_ps(a); }
+    static I intAdd(I a, int b)             { return _mm256_add_epi32(a, _mm256_set1_epi32(b)); }
+    static I intAnd(I a, int b)             { return _mm256_and_si256(a, _mm256_set1_epi32(b)); }
+    static I intOr(I a, int b)              { return _mm256_or_si256(a, _mm256_set1_epi32(b)); }
+    static I intShiftLeft23(I a)            { return _mm256_slli_epi32(a, 23); }
+    static I intShiftRight23(I a)           { return _mm256_srli_epi32(a, 23); }
+    static I intSub(I a, I b)               { return _mm256_sub_epi32(a, b); }
+    static F intEqual(I a, int b)           { return _mm256_castsi256_ps(_mm256_cmpeq_epi32(a, _mm256_set1_epi32(b))); }
+    static F asFloat(I a)                   { return _mm256_castsi256_ps(a); }
+    static I asInt(F a)                     { return _mm256_castps_si256(a); }
+};
+
+#endif
+
+template <typename V>
+static typename V::F select(typename V::F mask, typename V::F a, typename V::F b)
+{
+    // Returns 'a' where 'mask' is set and 'b' elsewhere.
+    return V::bitOr(V::bitAnd(mask, a), V::bitAndNot(mask, b));
+}
+
+template <typename V>
+static typename V::F negateIf(typename V::F mask, typename V::F a)
+{
+    return V::bitXor(a, V::bitAnd(mask, V::set1(-0.0f)));
+}
+
+template <typename V>
+static typename V::F madd(typename V::F a, float b, float c)
+{
+    // Returns a * b + c. Used to evaluate the polynomials in Horner form.
+    return V::add(V::mul(a, V::set1(b)), V::set1(c));
+}
+
+template <typename V>
+static typename V::F acosKernel(typename V::F x)
+{
+    typedef typename V::F F;
+
+    F a = V::min(V::bitAndNot(V::set1(-0.0f), x), V::set1(1.0f));
+    F big = V::cmpGreater(a, V::set1(0.5f));
+    F z = select<V>(big, V::mul(V::set1(0.5f), V::sub(V::set1(1.0f), a)), V::mul(a, a));
+    F s = select<V>(big, V::sqrt(z), a);
+
+    F p = madd<V>(z, 4.2163199048e-2f, 2.4181311049e-2f);
+    p = V::add(V::mul(p, z), V::set1(4.5470025998e-2f));
+    p = V::add(V::mul(p, z), V::set1(7.4953002686e-2f));
+    p = V::add(V::mul(p, z), V::set1(1.6666752422e-1f));
+    p = V::add(V::mul(V::mul(p, z), s), s);
+
+    F negative = V::cmpLess(x, V::set1(0.0f));
+    F twoP = V::add(p, p);
+    F rBig = select<V>(negative, V::sub(V::set1(3.14159265f), twoP), twoP);
+    F rSmall = V::sub(V::set1(1.57079633f), negateIf<V>(negative, p));
+
+    return select<V>(big, rBig, rSmall);
+}
+
+template <typename V>
+static typename V::F atan2Kernel(typename V::F y, typename V::F x)
+{
+    typedef typename V::F F;
+
+    F ax = V::bitAndNot(V::set1(-0.0f), x);
+    F ay = V::bitAndNot(V::set1(-0.0f), y);
+    F mx = V::max(ax, ay);
+    F t = V::bitAnd(V::cmpGreater(mx, V::set1(0.0f)), V::div(V::min(ax, ay), mx));
+
+    F big = V::cmpGreater(t, V::set1(0.41421356f));
+    t = select<V>(big, V::div(V::sub(t, V::set1(1.0f)), V::add(t, V::set1(1.0f))), t);
+
+    F z = V::mul(t, t);
+    F p = madd<V>(z, 8.05374449538e-2f, -1.38776856032e-1f);
+    p = V::add(V::mul(p, z), V::set1(1.99777106478e-1f));
+    p = V::add(V::mul(p, z), V::set1(-3.33329491539e-1f));
+    p = V::add(V::mul(V::mul(p, z), t), t);
+
+    F r = V::add(V::bitAnd(big, V::set1(0.78539816f)), p);
+    r = select<V>(V::cmpGreater(ay, ax), V::sub(V::set1(1.57079633f), r), r);
+    r = select<V>(V::cmpLess(x, V::set1(0.0f)), V::sub(V::set1(3.14159265f), r), r);
+
+    return negateIf<V>(V::cmpLess(y, V::set1(0.0f)), r);
+}
+
+template <typename V>
+static typename V::F expKernel(typename V::F x)
+{
+    typedef typename V::F F;
+    typedef typename V::I I;
+
+    x = V::min(V::max(x, V::set1(-87.3f)), V::set1(88.0f));
+
+    I n = V::roundToInt(V::mul(x, V::set1(1.44269504f)));
+    F fn = V::toFloat(n);
+    F r = V::sub(x, V::mul(fn, V::set1(0.693359375f)));
+    r = V::add(r, V::mul(fn, V::set1(2.12194440e-4f)));
+
+    F p = madd<V>(r, 1.9875691500e-4f, 1.3981999507e-3f);
+    p = V::add(V::mul(p, r), V::set1(8.3334519073e-3f));
+    p = V::add(V::mul(p, r), V::set1(4.1665795894e-2f));
+    p = V::add(V::mul(p, r), V::set1(1.6666665459e-1f));
+    p = V::add(V::mul(p, r), V::set1(5.0000001201e-1f));
+    p = V::add(V::add(V::mul(V::mul(p, r), r), r), V::set1(1.0f));
+
+    return V::mul(p, V::asFloat(V::intShiftLeft23(V::intAdd(n, 127))));
+}
+
+template <typename V>
+static typename V::F logKernel(typename V::F x)
+{
+    typedef typename V::F F;
+    typedef typename V::I I;
+
+    F denormal = V::cmpLess(x, V::set1(1.17549435e-38f));
+    x = select<V>(denormal, V::mul(x, V::set1(8388608.0f)), x);
+
+    I bits = V::asInt(x);
+    I e = V::intAdd(V::intAnd(V::intShiftRight23(bits), 0xff), -126);
+    F m = V::asFloat(V::intOr(V::intAnd(bits, static_cast<int>(0x807fffff)), 0x3f000000));
+
+    F small = V::cmpLess(m, V::set1(0.70710678f));
+    F fe = V::sub(V::toFloat(e), V::bitAnd(small, V::set1(1.0f)));
+    fe = V::sub(fe, V::bitAnd(denormal, V::set1(23.0f)));
+    m = V::add(V::sub(m, V::set1(1.0f)), V::bitAnd(small, m));
+
+    F z = V::mul(m, m);
+    F y = madd<V>(m, 7.0376836292e-2f, -1.1514610310e-1f);
+    y = V::add(V::mul(y, m), V::set1(1.1676998740e-1f));
+    y = V::add(V::mul(y, m), V::set1(-1.2420140846e-1f));
+    y = V::add(V::mul(y, m), V::set1(1.4249322787e-1f));
+    y = V::add(V::mul(y, m), V::set1(-1.6668057665e-1f));
+    y = V::add(V::mul(y, m), V::set1(2.0000714765e-1f));
+    y = V::add(V::mul(y, m), V::set1(-2.4999993993e-1f));
+    y = V::add(V::mul(y, m), V::set1(3.3333331174e-1f));
+    y = V::mul(V::mul(y, m), z);
+
+    y = V::add(y, V::sub(V::mul(fe, V::set1(-2.12194440e-4f)), V::mul(V::set1(0.5f), z)));
+    return V::add(V::add(m, y), V::mul(fe, V::set1(0.693359375f)));
+}
+
+template <typename V>
+static typename V::F rsqrtKernel(typename V::F x)
+{
+    typedef typename V::F F;
+
+    F denormal = V::cmpLess(x, V::set1(1.17549435e-38f));
+    x = select<V>(denormal, V::mul(x, V::set1(16777216.0f)), x);
+
+    F y = V::rsqrt(x);
+    F yyx = V::mul(V::mul(x, y), y);
+    y = V::mul(y, V::sub(V::set1(1.5f), V::mul(V::set1(0.5f), yyx)));
+    return select<V>(denormal, V::mul(y, V::set1(4096.0f)), y);
+}
+
+template <typename V>
+static void sinCosKernel(typename V::F x, typename V::F &s, typename V::F &c)
+{
+    typedef typename V::F F;
+    typedef typename V::I I;
+
+    I k = V::roundToInt(V::mul(x, V::set1(0.63661977f)));
+    F fk = V::toFloat(k);
+    F r = V::sub(x, V::mul(fk, V::set1(1.5703125f)));
+    r = V::sub(r, V::mul(fk, V::set1(4.837512969970703125e-4f)));
+    r = V::sub(r, V::mul(fk, V::set1(7.54978995489188216e-8f)));
+
+    F z = V::mul(r, r);
+    F sr = madd<V>(z, -1.9515295891e-4f, 8.3321608736e-3f);
+    sr = V::add(V::mul(sr, z), V::set1(-1.6666654611e-1f));
+    sr = V::add(V::mul(V::mul(sr, z), r), r);
+
+    F cr = madd<V>(z, 2.443315711809948e-5f, -1.388731625493765e-3f);
+    cr = V::add(V::mul(cr, z), V::set1(4.166664568298827e-2f));
+    cr = V::sub(V::mul(V::mul(cr, z), z), V::mul(V::set1(0.5f), z));
+    cr = V::add(cr, V::set1(1.0f));
+
+    F swap = V::intEqual(V::intAnd(k, 1), 1);
+    s = negateIf<V>(V::intEqual(V::intAnd(k, 2), 2), select<V>(swap, cr, sr));
+    c = negateIf<V>(V::intEqual(V::intAnd(V::intAdd(k, 1), 2), 2), select<V>(swap, sr, cr));
+}
+
+template <typename V, typename V::F (*Kernel)(typename V::F)>
+static void fastMathArray(const float *x, float *result, unsigned int count)
+{
+    unsigned int i = 0;
+
+    for (; i + V::WIDTH <= count; i += V::WIDTH)
+        V::store(result + i, Kernel(V::load(x + i)));
+
+    if (i < count)
+    {
+        float pad[V::WIDTH] = {};
+
+        memcpy(pad, x + i, (count - i) * sizeof(float));
+        V::store(pad, Kernel(V::load(pad)));
+        memcpy(result + i, pad, (count - i) * sizeof(float));
+    }
+}
+
+template <typename V>
+static void fastAtan2Array(const float *y, const float *x, float *result, unsigned int count)
+{
+    unsigned int i = 0;
+
+    for (; i + V::WIDTH <= count; i += V::WIDTH)
+        V::store(result + i, atan2Kernel<V>(V::load(y + i), V::load(x + i)));
+
+    if (i < count)
+    {
+        float padY[V::WIDTH] = {};
+        float padX[V::WIDTH] = {};
+
+        memcpy(padY, y + i, (count - i) * sizeof(float));
+        memcpy(padX, x + i, (count - i) * sizeof(float));
+        V::store(padY, atan2Kernel<V>(V::load(padY), V::load(padX)));
+        memcpy(result + i, padY, (count - i) * sizeof(float));
+    }
+}
+
+template <typename V>
+static void sinCosWide(typename V::F x, int wide, float *s, float *c)
+{
+    // Recomputes the lanes set in the mask 'wide' with sinf() and cosf().
+    float xs[V::WIDTH];
+
+    V::store(xs, x);
+
+    for (unsigned int i = 0; i < V::WIDTH; ++i)
+    {
+        if ((wide >> i) & 1)
+        {
+            if (s)
+                s[i] = sinf(xs[i]);
+
+            if (c)
+                c[i] = cosf(xs[i]);
+        }
+    }
+}
+
+template <typename V>
+static void fastSinCosArray(const float *x, float *s, float *c, unsigned int count)
+{
+    // Either 's' or 'c' may be null, for the sines or cosines alone. As in
+    // the scalar form, |x| > 8192, infinities and NaNs are passed to sinf()
+    // and cosf(); their quadrant doesn't fit in an int. That is done
+    // outside the kernel so that the kernel stays small enough to inline,
+    // and the inner loop leaves for vectors that need it so that the
+    // common case stays free of the calls.
+
+    typedef typename V::F F;
+
+    F limit = V::set1(8192.0f);
+    unsigned int i = 0;
+
+    while (i + V::WIDTH <= count)
+    {
+        F vx, vs, vc;
+        int wide = 0;
+
+        for (; i + V::WIDTH <= count; i += V::WIDTH)
+        {
+            vx = V::load(x + i);
+            wide = V::moveMask(V::cmpNotLessEqual(V::bitAndNot(V::set1(-0.0f), vx), limit));
+
+            if (wide)
+                break;
+
+            sinCosKernel<V>(vx, vs, vc);
+
+            if (s)
+                V::store(s + i, vs);
+
+            if (c)
+                V::store(c + i, vc);
+        }
+
+        if (!wide)
+            break;
+
+        sinCosKernel<V>(vx, vs, vc);
+
+        if (s)
+            V::store(s + i, vs);
+
+        if (c)
+            V::store(c + i, vc);
+
+        sinCosWide<V>(vx, wide, s ? s + i : 0, c ? c + i : 0);
+        i += V::WIDTH;
+    }
+
+    if (i < count)
+    {
+        float padX[V::WIDTH] = {};
+        float padS[V::WIDTH], padC[V::WIDTH];
+
+        memcpy(padX, x + i, (count - i) * sizeof(float));
+        fastSinCosArray<V>(padX, padS, padC, V::WIDTH);
+
+        if (s)
+            memcpy(s + i, padS, (count - i) * sizeof(float));
+
+        if (c)
+            memcpy(c + i, padC, (count - i) * sizeof(float));
+    }
+}
+
+// Names the fast math kernels of one variant, e.g., fastAcosSse2.
+#define FAST_MATH_KERNELS(V, suffix) \
+    static void fastAcos##suffix(const float *x, float *result, unsigned int count) \
+        { fastMathArray<V, acosKernel<V> >(x, result, count); } \
+    static void fastCos##suffix(const float *x, float *result, unsigned int count) \
+        { fastSinCosArray<V>(x, 0, result, count); } \
+    static void fastExp##suffix(const float *x, float *result, unsigned int count) \
+        { fastMathArray<V, expKernel<V> >(x, result, count); } \
+    static void fastLog##suffix(const float *x, float *result, unsigned int count) \
+        { fastMathArray<V, logKernel<V> >(x, result, count); } \
+    static void fastRsqrt##suffix(const float *x, float *result, unsigned int count) \
+        { fastMathArray<V, rsqrtKernel<V> >(x, result, count); } \
+    static void fastSin##suffix(const float *x, float *result, unsigned int count) \
+        { fastSinCosArray<V>(x, result, 0, count); }
+
+#if defined(BATCH_KERNELS_SSE2)
+FAST_MATH_KERNELS(FastMathSse2, Sse2)
+#else
+FAST_MATH_KERNELS(FastMathAvx2, Avx2)
+#endif
+
+#undef FAST_MATH_KERNELS
+
+#endif
+
+//-----------------------------------------------------------------------------
+// Kernel table.
+
+#if defined(BATCH_KERNELS_AVX2)
+const BatchKernels BATCH_KERNELS_TABLE =
+{
+    multiplyAvx2, multiplyDoublesAvx2, transformPointsAvx2, cullBoxesAvx2, cullBoxesClipSpaceAvx2,
+    cullBoxesMultiAvx2, cullSpheresMultiAvx2, cullBoxesVolumeAvx2, cullSpheresVolumeAvx2,
+    classifyPointsAvx2, projectBoxesAvx2, projectSpheresAvx2, selectLodsAvx2,
+    rayIntersectsBoxesAvx2, rebasePointsAvx2, rebaseMatricesSse2,
+    cullCapsulesAvx2, segmentIntersectsCapsulesAvx2,
+    sweepSpheresPlaneAvx2, sweepSpheresSphereAvx2, sweepSpheresBoxAvx2, sweepBoxesBoxAvx2,
+    fastAcosAvx2, fastAtan2Array<FastMathAvx2>, fastCosAvx2, fastExpAvx2, fastLogAvx2,
+    fastRsqrtAvx2, fastSinAvx2, fastSinCosArray<FastMathAvx2>
+};
+#elif defined(BATCH_KERNELS_SSE2)
+const BatchKernels BATCH_KERNELS_TABLE =
+{
+    multiplySse2, multiplyDoublesSse2, transformPointsSse2, cullBoxesSse2, cullBoxesClipSpaceSse2,
+    cullBoxesMultiSse2, cullSpheresMultiSse2, cullBoxesVolumeSse2, cullSpheresVolumeSse2,
+    classifyPointsSse2, projectBoxesSse2, projectSpheresSse2, selectLodsSse2,
+    rayIntersectsBoxesSse2, rebasePointsSse2, rebaseMatricesSse2,
+    cullCapsulesSse2, segmentIntersectsCapsulesSse2,
+    sweepSpheresPlaneSse2, sweepSpheresSphereSse2, sweepSpheresBoxSse2, sweepBoxesBoxSse2,
+    fastAcosSse2, fastAtan2Array<FastMathSse2>, fastCosSse2, fastExpSse2, fastLogSse2,
+    fastRsqrtSse2, fastSinSse2, fastSinCosArray<FastMathSse2>
+};
+#else
+const BatchKernels BATCH_KERNELS_TABLE =
+{
+    multiplyScalar, multiplyDoublesScalar, transformPointsScalar, cullBoxesScalar, cullBoxesClipSpaceScalar,
+    cullBoxesMultiScalar, cullSpheresMultiScalar, cullBoxesVolumeScalar, cullSpheresVolumeScalar,
+    classifyPointsScalar, projectBoxesScalar, projectSpheresScalar, selectLodsScalar,
+    rayIntersectsBoxesScalar, rebasePointsScalar, rebaseMatricesScalar,
+    cullCapsulesScalar, segmentIntersectsCapsulesScalar,
+    sweepSpheresPlaneScalar, sweepSpheresSphereScalar, sweepSpheresBoxScalar, sweepBoxesBoxScalar,
+    0, 0, 0, 0, 0, 0, 0, 0
+};
+#endif
@@ -0,0 +1,621 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2026 dhpoware. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include <cfloat>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "bench_main.h"
+#include "batch.h"
+
+void BenchMathBatch();
+
+//-----------------------------------------------------------------------------
+// Each benchmark processes INPUT_COUNT objects per iteration, and reports
+// them as items/sec (triangles/sec for clipTriangles). Every variant the CPU supports is
+// benchmarked; the variant is appended to the benchmark name. The x1M
+// culling benchmarks process LARGE_COUNT boxes, more than most last level
+// caches hold, where reading the boxes once for all frustums pays off.
+//-----------------------------------------------------------------------------
+
+static const unsigned int INPUT_COUNT = 256;
+static const unsigned int LARGE_COUNT = 1 << 20;
+
+static Matrix4 g_lhs[INPUT_COUNT];
+static Matrix4 g_rhs[INPUT_COUNT];
+static Matrix4 g_products[INPUT_COUNT];
+static Matrix4d g_lhsd[INPUT_COUNT];
+static Matrix4d g_rhsd[INPUT_COUNT];
+static Matrix4d g_productsd[INPUT_COUNT];
+static Vector3 g_points[INPUT_COUNT];
+static Vector3 g_transformed[INPUT_COUNT];
+static Frustum g_frustum;
+static Frustum g_frustums[5];
+static ConvexVolume g_volume;
+static BoundingBox g_boxes[INPUT_COUNT];
+static BoundingSphere g_spheres[INPUT_COUNT];
+static Ray g_ray;
+static bool g_results[INPUT_COUNT];
+static unsigned int g_masks[INPUT_COUNT];
+static Vector3d g_origin(12345678.125, -23456789.5, 34567890.25);
+static Vector3d g_positions[INPUT_COUNT];
+static Matrix4 g_models[INPUT_COUNT];
+static Matrix4 g_mvps[INPUT_COUNT];
+static Frustum g_viewFrustum;
+static BoundingBox g_localBox(Vector3(-1.0f, -2.0f, -1.0f), Vector3(1.0f, 2.0f, 1.0f));
+static BoundingBox g_worldBoxes[INPUT_COUNT];
+static Matrix4 g_proj;
+static Vector4 g_rects[INPUT_COUNT];
+static float g_depths[INPUT_COUNT];
+static float g_radii[INPUT_COUNT];
+static float g_lodThresholds[INPUT_COUNT * 3];
+static unsigned int g_lods[INPUT_COUNT];
+static Vector3 g_triangles[INPUT_COUNT * 3];
+static Vector3 g_clipped[INPUT_COUNT * 7 * 3];
+static Capsule g_capsules[INPUT_COUNT];
+static float g_capsuleCoords[INPUT_COUNT * 7];
+static Batch::CapsuleArrays g_capsuleArrays;
+static Capsule g_capsule;
+static Vector3 g_velocities[INPUT_COUNT];
+static float g_times[INPUT_COUNT];
+static Vector3 g_normals[INPUT_COUNT];
+static BoundingBox g_obstacle(Vector3(-10.0f, -30.0f, -10.0f), Vector3(10.0f, 30.0f, 10.0f));
+static float g_angles[INPUT_COUNT];
+static std::vector<BoundingBox> g_largeBoxes;
+static bool g_largeResults[LARGE_COUNT];
+static unsigned int g_largeMasks[LARGE_COUNT];
+static float g_sines[INPUT_COUNT];
+static float g_cosines[INPUT_COUNT];
+
+static void InitInputs()
+{
+    Random rng(2026);
+
+    for (unsigned int i = 0; i < INPUT_COUNT; ++i)
+    {
+        rng.fill(&g_lhs[i][0][0], 16, -1.0f, 1.0f);
+        rng.fill(&g_rhs[i][0][0], 16, -1.0f, 1.0f);
+        g_lhsd[i] = Matrix4d(g_lhs[i]);
+        g_rhsd[i] = Matrix4d(g_rhs[i]);
+
+        Vector3 center = rng.inBox(Vector3(-50.0f, -50.0f, -50.0f), Vector3(50.0f, 50.0f, 50.0f));
+        Vector3 extent = rng.inBox(Vector3(0.5f, 0.5f, 0.5f), Vector3(5.0f, 5.0f, 5.0f));
+
+        g_points[i] = center;
+        g_positions[i] = g_origin + Vector3d(center);
+        g_boxes[i] = BoundingBox(center - extent, center + extent);
+        g_spheres[i] = BoundingSphere(center, extent.magnitude());
+        g_angles[i] = rng.nextFloat(-Math::PI, Math::PI);
+    }
+
+    // A frustum-like volume around the origin that keeps roughly half of
+    // the boxes.
+    for (int i = 0; i < 6; ++i)
+    {
+        Vector3 n = rng.onSphere(1.0f);
+        g_frustum.planes[i] = Plane(n * -40.0f, n);
+    }
+
+    // The same volume narrowed by 4 more planes, like a view through a
+    // portal.
+    g_volume.fromFrustum(g_frustum);
+
+    for (int i = 0; i < 4; ++i)
+    {
+        Vector3 n = rng.onSphere(1.0f);
+        g_volume.addPlane(Plane(n * -40.0f, n));
+    }
+
+    // The main view plus 4 more, like the cascades of a shadow map.
+    for (int f = 0; f < 5; ++f)
+    {
+        for (int i = 0; i < 6; ++i)
+        {
+            Vector3 n = rng.onSphere(1.0f);
+            g_frustums[f].planes[i] = Plane(n * -40.0f, n);
+        }
+    }
+
+    g_largeBoxes.resize(LARGE_COUNT);
+
+    for (unsigned int i = 0; i < LARGE_COUNT; ++i)
+    {
+        Vector3 center = rng.inBox(Vector3(-50.0f, -50.0f, -50.0f), Vector3(50.0f, 50.0f, 50.0f));
+        Vector3 extent = rng.inBox(Vector3(0.5f, 0.5f, 0.5f), Vector3(5.0f, 5.0f, 5.0f));
+
+        g_largeBoxes[i] = BoundingBox(center - extent, center + extent);
+    }
+
+    // Instances of one mesh in front of a camera at the origin looking
+    // down -z, and their model-view-projection matrices.
+    Matrix4 proj = Matrix4::createPerspective(60.0f, 16.0f / 9.0f, 0.1f, 100.0f);
+
+    g_viewFrustum.extractPlanes(proj);
+    g_proj = proj;
+
+    for (unsigned int i = 0; i < INPUT_COUNT; ++i)
+    {
+        Vector3 position = rng.inBox(Vector3(-60.0f, -60.0f, -110.0f), Vector3(60.0f, 60.0f, 10.0f));
+
+        g_models[i] = rng.unitQuaternion().toMatrix4() * Matrix4::createTranslate(position.x, position.y, position.z);
+        g_mvps[i] = g_models[i] * proj;
+    }
+
+    for (unsigned int i = 0; i < INPUT_COUNT; ++i)
+    {
+        g_lodThresholds[i * 3 + 0] = 0.2f;
+        g_lodThresholds[i * 3 + 1] = 0.05f;
+        g_lodThresholds[i * 3 + 2] = 0.01f;
+    }
+
+    g_ray = Ray(Vector3(-60.0f, -2.0f, 1.0f), Vector3(1.0f, 0.05f, -0.02f));
+
+    // Triangles up to 20 units across around the box centers, so that many
+    // of them cross the planes of g_frustum.
+    for (unsigned int i = 0; i < INPUT_COUNT * 3; ++i)
+        g_triangles[i] = g_points[i / 3] + rng.inSphere(10.0f);
+
+    // Character sized capsules at the box centers, in the structure of
+    // arrays layout the Batch capsule functions take.
+    for (unsigned int i = 0; i < INPUT_COUNT; ++i)
+    {
+        Vector3 half = Vector3(0.0f, 1.0f, 0.0f) + rng.inSphere(0.5f);
+        Vector3 a = g_points[i] - half, b = g_points[i] + half;
+        const float values[7] = { a.x, a.y, a.z, b.x, b.y, b.z, rng.nextFloat(0.3f, 2.0f) };
+
+        g_capsules[i] = Capsule(a, b, values[6]);
+
+        for (int k = 0; k < 7; ++k)
+            g_capsuleCoords[k * INPUT_COUNT + i] = values[k];
+    }
+
+    g_capsuleArrays.ax = &g_capsuleCoords[0];
+    g_capsuleArrays.ay = &g_capsuleCoords[INPUT_COUNT];
+    g_capsuleArrays.az = &g_capsuleCoords[INPUT_COUNT * 2];
+    g_capsuleArrays.bx = &g_capsuleCoords[INPUT_COUNT * 3];
+    g_capsuleArrays.by = &g_capsuleCoords[INPUT_COUNT * 4];
+    g_capsuleArrays.bz = &g_capsuleCoords[INPUT_COUNT * 5];
+    g_capsuleArrays.radius = &g_capsuleCoords[INPUT_COUNT * 6];
+    g_capsule = Capsule(Vector3(-20.0f, -3.0f, 0.0f), Vector3(20.0f, 3.0f, 0.0f), 8.0f);
+
+    // One step of motion towards a point near the origin, so that about
+    // half of the shapes hit g_obstacle.
+    for (unsigned int i = 0; i < INPUT_COUNT; ++i)
+        g_velocities[i] = rng.inSphere(30.0f) - g_points[i];
+}
+
+static void BenchMultiply(unsigned int iterations)
+{
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        Batch::multiply(g_lhs, g_rhs, g_products, INPUT_COUNT);
+        DoNotOptimize(g_products);
+    }
+}
+
+static void BenchMultiplyDoubles(unsigned int iterations)
+{
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        Batch::multiply(g_lhsd, g_rhsd, g_productsd, INPUT_COUNT);
+        DoNotOptimize(g_productsd);
+    }
+}
+
+static void BenchTransformPoints(unsigned int iterations)
+{
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        Batch::transformPoints(g_lhs[i & (INPUT_COUNT - 1)], g_points, g_transformed, INPUT_COUNT);
+        DoNotOptimize(g_transformed);
+    }
+}
+
+static void BenchCullBoxes(unsigned int iterations)
+{
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        Batch::cullBoxes(g_frustum, g_boxes, g_results, INPUT_COUNT);
+        DoNotOptimize(g_results);
+    }
+}
+
+static void BenchCullBoxesClipSpace(unsigned int iterations)
+{
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        Batch::cullBoxesClipSpace(g_mvps, g_localBox, g_results, INPUT_COUNT);
+        DoNotOptimize(g_results);
+    }
+}
+
+static void BenchCullBoxesWorldSpace(unsigned int iterations)
+{
+    // The alternative to cullBoxesClipSpace(): the world space box of each
+    // instance is computed from its model matrix, then frustum culled.
+
+    Vector3 center = g_localBox.getCenter();
+    Vector3 extent = (g_localBox.max - g_localBox.min) * 0.5f;
+
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        for (unsigned int n = 0; n < INPUT_COUNT; ++n)
+        {
+            const Matrix4 &m = g_models[n];
+            Vector3 c = center * m + Vector3(m[3][0], m[3][1], m[3][2]);
+            Vector3 e(extent.x * fabsf(m[0][0]) + extent.y * fabsf(m[1][0]) + extent.z * fabsf(m[2][0]),
+                extent.x * fabsf(m[0][1]) + extent.y * fabsf(m[1][1]) + extent.z * fabsf(m[2][1]),
+                extent.x * fabsf(m[0][2]) + extent.y * fabsf(m[1][2]) + extent.z * fabsf(m[2][2]));
+
+            g_worldBoxes[n] = BoundingBox(c - e, c + e);
+        }
+
+        Batch::cullBoxes(g_viewFrustum, g_worldBoxes, g_results, INPUT_COUNT);
+        DoNotOptimize(g_results);
+    }
+}
+
+static void BenchCullBoxesSeparate(unsigned int iterations)
+{
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        for (int f = 0; f < 5; ++f)
+        {
+            Batch::cullBoxes(g_frustums[f], g_boxes, g_results, INPUT_COUNT);
+            DoNotOptimize(g_results);
+        }
+    }
+}
+
+static void BenchCullBoxesMulti(unsigned int iterations)
+{
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        Batch::cullBoxes(g_frustums, 5, g_boxes, g_masks, INPUT_COUNT);
+        DoNotOptimize(g_masks);
+    }
+}
+
+static void BenchCullBoxesSeparateLarge(unsigned int iterations)
+{
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        for (int f = 0; f < 5; ++f)
+        {
+            Batch::cullBoxes(g_frustums[f], &g_largeBoxes[0], g_largeResults, LARGE_COUNT);
+            DoNotOptimize(g_largeResults);
+        }
+    }
+}
+
+static void BenchCullBoxesMultiLarge(unsigned int iterations)
+{
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        Batch::cullBoxes(g_frustums, 5, &g_largeBoxes[0], g_largeMasks, LARGE_COUNT);
+        DoNotOptimize(g_largeMasks);
+    }
+}
+
+static void BenchCullSpheresMulti(unsigned int iterations)
+{
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        Batch::cullSpheres(g_frustums, 5, g_spheres, g_masks, INPUT_COUNT);
+        DoNotOptimize(g_masks);
+    }
+}
+
+static void BenchCullBoxesVolume(unsigned int iterations)
+{
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        Batch::cullBoxes(g_volume, g_boxes, g_results, INPUT_COUNT);
+        DoNotOptimize(g_results);
+    }
+}
+
+static void BenchCullSpheresVolume(unsigned int iterations)
+{
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        Batch::cullSpheres(g_volume, g_spheres, g_results, INPUT_COUNT);
+        DoNotOptimize(g_results);
+    }
+}
+
+static void BenchClipTriangles(unsigned int iterations)
+{
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        unsigned int written = Batch::clipTriangles(g_frustum, g_triangles, INPUT_COUNT, g_clipped, INPUT_COUNT * 7, 0);
+        DoNotOptimize(written);
+        DoNotOptimize(g_clipped);
+    }
+}
+
+static void BenchClipTrianglesPerTriangle(unsigned int iterations)
+{
+    // The per-triangle version of BenchClipTriangles(): each triangle is
+    // clipped against all 6 planes with Frustum::clipPolygon().
+
+    Vector3 polygon[Frustum::MAX_CLIP_VERTICES];
+
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        unsigned int written = 0;
+
+        for (unsigned int n = 0; n < INPUT_COUNT; ++n)
+        {
+            unsigned int count = g_frustum.clipPolygon(&g_triangles[n * 3], 3, polygon);
+
+            for (unsigned int k = 1; k + 1 < count; ++k, ++written)
+            {
+                g_clipped[written * 3 + 0] = polygon[0];
+                g_clipped[written * 3 + 1] = polygon[k];
+                g_clipped[written * 3 + 2] = polygon[k + 1];
+            }
+        }
+
+        DoNotOptimize(written);
+        DoNotOptimize(g_clipped);
+    }
+}
+
+static void BenchProjectSpheres(unsigned int iterations)
+{
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        Batch::projectSpheres(g_models[i & (INPUT_COUNT - 1)], g_proj, g_spheres, g_depths, g_radii, INPUT_COUNT);
+        DoNotOptimize(g_radii);
+    }
+}
+
+static void BenchProjectBoxes(unsigned int iterations)
+{
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        Batch::projectBoxes(g_mvps[i & (INPUT_COUNT - 1)], g_boxes, g_rects, g_depths, INPUT_COUNT);
+        DoNotOptimize(g_rects);
+    }
+}
+
+static void BenchSelectLods(unsigned int iterations)
+{
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        Batch::projectSpheres(g_models[i & (INPUT_COUNT - 1)], g_proj, g_spheres, g_depths, g_radii, INPUT_COUNT);
+        Batch::selectLods(g_radii, g_lodThresholds, 3, g_lods, INPUT_COUNT);
+        DoNotOptimize(g_lods);
+    }
+}
+
+static void BenchSelectLodsPerObject(unsigned int iterations)
+{
+    // The per-object version of BenchSelectLods(): each sphere is projected
+    // with Vector4 * Matrix4 and its LOD picked with branches.
+
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        const Matrix4 &view = g_models[i & (INPUT_COUNT - 1)];
+
+        for (unsigned int n = 0; n < INPUT_COUNT; ++n)
+        {
+            const BoundingSphere &sphere = g_spheres[n];
+            Vector4 center = Vector4(sphere.center, 1.0f) * view;
+            float d = -center.z;
+            float r = sphere.radius;
+            float size = (d > r) ? r * g_proj[1][1] / sqrtf(d * d - r * r) : 3.402823466e+38f;
+            const float *t = &g_lodThresholds[n * 3];
+
+            g_lods[n] = (size >= t[0]) ? 0 : (size >= t[1]) ? 1 : (size >= t[2]) ? 2 : 3;
+        }
+
+        DoNotOptimize(g_lods);
+    }
+}
+
+static void BenchRayIntersectsBoxes(unsigned int iterations)
+{
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        Batch::rayIntersectsBoxes(g_ray, g_boxes, g_results, INPUT_COUNT);
+        DoNotOptimize(g_results);
+    }
+}
+
+static void BenchCullCapsules(unsigned int iterations)
+{
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        Batch::cullCapsules(g_frustum, g_capsuleArrays, g_results, INPUT_COUNT);
+        DoNotOptimize(g_results);
+    }
+}
+
+static void BenchCapsuleIntersectsCapsules(unsigned int iterations)
+{
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        Batch::capsuleIntersectsCapsules(g_capsule, g_capsuleArrays, g_results, INPUT_COUNT);
+        DoNotOptimize(g_results);
+    }
+}
+
+static void BenchCapsuleIntersectsCapsulesPerCapsule(unsigned int iterations)
+{
+    // The per-object version of BenchCapsuleIntersectsCapsules().
+
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        for (unsigned int n = 0; n < INPUT_COUNT; ++n)
+            g_results[n] = g_capsule.hasCollided(g_capsules[n]);
+
+        DoNotOptimize(g_results);
+    }
+}
+
+static void BenchRayIntersectsCapsules(unsigned int iterations)
+{
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        Batch::rayIntersectsCapsules(g_ray, g_capsuleArrays, g_results, INPUT_COUNT);
+        DoNotOptimize(g_results);
+    }
+}
+
+static void BenchSweepSpheresBox(unsigned int iterations)
+{
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        Batch::sweepSpheres(g_obstacle, g_spheres, g_velocities, g_times, g_normals, INPUT_COUNT);
+        DoNotOptimize(g_times);
+        DoNotOptimize(g_normals);
+    }
+}
+
+static void BenchSweepSpheresBoxTimes(unsigned int iterations)
+{
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        Batch::sweepSpheres(g_obstacle, g_spheres, g_velocities, g_times, 0, INPUT_COUNT);
+        DoNotOptimize(g_times);
+    }
+}
+
+static void BenchSweepSpheresBoxPerSphere(unsigned int iterations)
+{
+    // The per-object version of BenchSweepSpheresBox().
+
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        for (unsigned int n = 0; n < INPUT_COUNT; ++n)
+        {
+            if (!Sweep::timeOfImpact(g_spheres[n], g_velocities[n], g_obstacle, g_times[n], g_normals[n]))
+                g_times[n] = FLT_MAX;
+        }
+
+        DoNotOptimize(g_times);
+        DoNotOptimize(g_normals);
+    }
+}
+
+static void BenchSweepSpheresSphere(unsigned int iterations)
+{
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        Batch::sweepSpheres(g_spheres[0], g_spheres, g_velocities, g_times, 0, INPUT_COUNT);
+        DoNotOptimize(g_times);
+    }
+}
+
+static void BenchSweepBoxes(unsigned int iterations)
+{
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        Batch::sweepBoxes(g_obstacle, g_boxes, g_velocities, g_times, 0, INPUT_COUNT);
+        DoNotOptimize(g_times);
+    }
+}
+
+static void BenchRebasePoints(unsigned int iterations)
+{
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        Batch::rebasePoints(g_origin, g_positions, g_transformed, INPUT_COUNT);
+        DoNotOptimize(g_transformed);
+    }
+}
+
+static void BenchRebaseMatrices(unsigned int iterations)
+{
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        Batch::rebaseMatrices(g_origin, g_lhs, g_positions, g_products, INPUT_COUNT);
+        DoNotOptimize(g_products);
+    }
+}
+
+static void BenchFastSinCos(unsigned int iterations)
+{
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        Math::fastSinCos(g_angles, g_sines, g_cosines, INPUT_COUNT);
+        DoNotOptimize(g_sines);
+        DoNotOptimize(g_cosines);
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Benchmarks every supported variant of the Batch functions.
+//-----------------------------------------------------------------------------
+
+void BenchMathBatch()
+{
+    InitInputs();
+
+    Batch::Isa original = Batch::isa();
+
+    RunBenchmark("Batch::clipTriangles per triangle x256", BenchClipTrianglesPerTriangle, INPUT_COUNT);
+    RunBenchmark("Batch::selectLods per object x256", BenchSelectLodsPerObject, INPUT_COUNT);
+    RunBenchmark("Batch::capsuleIntersectsCapsules per capsule x256", BenchCapsuleIntersectsCapsulesPerCapsule, INPUT_COUNT);
+    RunBenchmark("Batch::sweepSpheres(box) per sphere x256", BenchSweepSpheresBoxPerSphere, INPUT_COUNT);
+
+    for (int i = Batch::ISA_SCALAR; i <= Batch::supportedIsa(); ++i)
+    {
+        Batch::Isa isa = static_cast<Batch::Isa>(i);
+        std::string suffix = std::string(" x256 [") + Batch::isaName(isa) + "]";
+
+        Batch::setIsa(isa);
+        RunBenchmark(("Batch::multiply" + suffix).c_str(), BenchMultiply, INPUT_COUNT);
+        RunBenchmark(("Batch::multiply Matrix4d" + suffix).c_str(), BenchMultiplyDoubles, INPUT_COUNT);
+        RunBenchmark(("Batch::transformPoints" + suffix).c_str(), BenchTransformPoints, INPUT_COUNT);
+        RunBenchmark(("Batch::cullBoxes" + suffix).c_str(), BenchCullBoxes, INPUT_COUNT);
+        RunBenchmark(("Batch::cullBoxesClipSpace" + suffix).c_str(), BenchCullBoxesClipSpace, INPUT_COUNT);
+        RunBenchmark(("Batch::cullBoxes world space boxes" + suffix).c_str(), BenchCullBoxesWorldSpace, INPUT_COUNT);
+        RunBenchmark(("Batch::cullBoxes 5 frustums separately" + suffix).c_str(), BenchCullBoxesSeparate, INPUT_COUNT);
+        RunBenchmark(("Batch::cullBoxes 5 frustums" + suffix).c_str(), BenchCullBoxesMulti, INPUT_COUNT);
+        RunBenchmark((std::string("Batch::cullBoxes 5 frustums separately x1M [") + Batch::isaName(isa) + "]").c_str(), BenchCullBoxesSeparateLarge, LARGE_COUNT);
+        RunBenchmark((std::string("Batch::cullBoxes 5 frustums x1M [") + Batch::isaName(isa) + "]").c_str(), BenchCullBoxesMultiLarge, LARGE_COUNT);
+        RunBenchmark(("Batch::cullSpheres 5 frustums" + suffix).c_str(), BenchCullSpheresMulti, INPUT_COUNT);
+        RunBenchmark(("Batch::cullBoxes 10 plane volume" + suffix).c_str(), BenchCullBoxesVolume, INPUT_COUNT);
+        RunBenchmark(("Batch::cullSpheres 10 plane volume" + suffix).c_str(), BenchCullSpheresVolume, INPUT_COUNT);
+        RunBenchmark(("Batch::clipTriangles" + suffix).c_str(), BenchClipTriangles, INPUT_COUNT);
+        RunBenchmark(("Batch::projectSpheres" + suffix).c_str(), BenchProjectSpheres, INPUT_COUNT);
+        RunBenchmark(("Batch::projectBoxes" + suffix).c_str(), BenchProjectBoxes, INPUT_COUNT);
+        RunBenchmark(("Batch::projectSpheres + selectLods" + suffix).c_str(), BenchSelectLods, INPUT_COUNT);
+        RunBenchmark(("Batch::rayIntersectsBoxes" + suffix).c_str(), BenchRayIntersectsBoxes, INPUT_COUNT);
+        RunBenchmark(("Batch::cullCapsules" + suffix).c_str(), BenchCullCapsules, INPUT_COUNT);
+        RunBenchmark(("Batch::capsuleIntersectsCapsules" + suffix).c_str(), BenchCapsuleIntersectsCapsules, INPUT_COUNT);
+        RunBenchmark(("Batch::rayIntersectsCapsules" + suffix).c_str(), BenchRayIntersectsCapsules, INPUT_COUNT);
+        RunBenchmark(("Batch::sweepSpheres(box)" + suffix).c_str(), BenchSweepSpheresBox, INPUT_COUNT);
+        RunBenchmark(("Batch::sweepSpheres(box) times only" + suffix).c_str(), BenchSweepSpheresBoxTimes, INPUT_COUNT);
+        RunBenchmark(("Batch::sweepSpheres(sphere) times only" + suffix).c_str(), BenchSweepSpheresSphere, INPUT_COUNT);
+        RunBenchmark(("Batch::sweepBoxes times only" + suffix).c_str(), BenchSweepBoxes, INPUT_COUNT);
+        RunBenchmark(("Batch::rebasePoints" + suffix).c_str(), BenchRebasePoints, INPUT_COUNT);
+        RunBenchmark(("Batch::rebaseMatrices" + suffix).c_str(), BenchRebaseMatrices, INPUT_COUNT);
+        RunBenchmark(("Math::fastSinCos" + suffix).c_str(), BenchFastSinCos, INPUT_COUNT);
+    }
+
+    Batch::setIsa(original);
+}
@@ -0,0 +1,676 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2026 dhpoware. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include <algorithm>
+#include <vector>
+
+#include "bench_main.h"
+#include "bsptree.h"
+#include "occlusion.h"
+#include "threadpool.h"
+
+void BenchMathCollision();
+
+//-----------------------------------------------------------------------------
+// The inputs are generated once with a fixed seed. The boxes and spheres are
+// scattered around the camera so that the tests take both their early-out
+// and their full paths.
+//-----------------------------------------------------------------------------
+
+static const unsigned int INPUT_COUNT = 256;
+static const unsigned int INPUT_MASK = INPUT_COUNT - 1;
+
+static Frustum g_frustum;
+static Frustum g_viewSpaceFrustum;
+static ConvexVolume g_portalVolume;
+static Vector3 g_portal[4];
+static Matrix4 g_proj;
+static Matrix4 g_views[INPUT_COUNT];
+static Matrix4 g_viewProjs[INPUT_COUNT];
+static BoundingBox g_boxes[INPUT_COUNT];
+static BoundingSphere g_spheres[INPUT_COUNT];
+static BoundingVolume g_volumes[INPUT_COUNT];
+static Plane g_planes[INPUT_COUNT];
+static Ray g_rays[INPUT_COUNT];
+static Capsule g_capsules[INPUT_COUNT];
+static Vector3 g_velocities[INPUT_COUNT];
+static Vector3 g_triangles[INPUT_COUNT * 3];
+static const unsigned int OCCLUDER_TRIANGLES = 512;
+static Vector3 g_occluderVertices[OCCLUDER_TRIANGLES * 3];
+static unsigned int g_occluderIndices[OCCLUDER_TRIANGLES * 3];
+
+static void InitInputs()
+{
+    Random rng(2026);
+
+    g_proj = Matrix4::createPerspective(60.0f, 16.0f / 9.0f, 0.1f, 100.0f);
+    g_frustum.extractPlanes(Matrix4::IDENTITY, g_proj);
+    g_viewSpaceFrustum.fromPerspective(60.0f, 16.0f / 9.0f, 0.1f, 100.0f, Matrix4::IDENTITY);
+
+    for (unsigned int i = 0; i < INPUT_COUNT; ++i)
+    {
+        Vector3 center = rng.inBox(Vector3(-50.0f, -50.0f, -50.0f), Vector3(50.0f, 50.0f, 50.0f));
+        Vector3 extent = rng.inBox(Vector3(0.5f, 0.5f, 0.5f), Vector3(5.0f, 5.0f, 5.0f));
+
+        g_boxes[i] = BoundingBox(center - extent, center + extent);
+        g_spheres[i] = BoundingSphere(center, extent.magnitude());
+        g_volumes[i].box = g_boxes[i];
+        g_volumes[i].sphere = g_spheres[i];
+        g_planes[i] = Plane(center, rng.onSphere(1.0f));
+        g_views[i] = rng.unitQuaternion().toMatrix4() * Matrix4::createTranslate(center.x, center.y, center.z);
+        g_viewProjs[i] = g_views[i] * g_proj;
+        g_rays[i] = Ray(rng.inBox(Vector3(-10.0f, -10.0f, -10.0f), Vector3(10.0f, 10.0f, 10.0f)),
+            rng.onSphere(1.0f));
+    }
+
+    // A doorway 10 units in front of the camera.
+    g_portal[0] = Vector3(-1.0f, -2.0f, -10.0f);
+    g_portal[1] = Vector3(1.0f, -2.0f, -10.0f);
+    g_portal[2] = Vector3(1.0f, 2.0f, -10.0f);
+    g_portal[3] = Vector3(-1.0f, 2.0f, -10.0f);
+    g_portalVolume.fromPortal(g_frustum, Vector3(0.0f, 0.0f, 0.0f), g_portal, 4);
+
+    // Occluders in front of the camera, 2 to 10 units across.
+    for (unsigned int i = 0; i < OCCLUDER_TRIANGLES; ++i)
+    {
+        Vector3 center = rng.inBox(Vector3(-30.0f, -15.0f, -60.0f), Vector3(30.0f, 15.0f, -5.0f));
+
+        for (unsigned int k = 0; k < 3; ++k)
+        {
+            g_occluderIndices[i * 3 + k] = i * 3 + k;
+            g_occluderVertices[i * 3 + k] = center + rng.inSphere(5.0f);
+        }
+    }
+
+    // Character sized capsules, standing or tilted, at the box centers.
+    for (unsigned int i = 0; i < INPUT_COUNT; ++i)
+    {
+        Vector3 center = g_spheres[i].center;
+        Vector3 half = Vector3(0.0f, 1.0f, 0.0f) + rng.inSphere(0.5f);
+
+        g_capsules[i] = Capsule(center - half, center + half, rng.nextFloat(0.3f, 2.0f));
+    }
+
+    // One step of motion for each object, long enough to cross the box
+    // field, and triangles at the box centers for it to sweep against.
+    for (unsigned int i = 0; i < INPUT_COUNT; ++i)
+    {
+        g_velocities[i] = rng.inSphere(60.0f);
+
+        for (unsigned int k = 0; k < 3; ++k)
+            g_triangles[i * 3 + k] = g_spheres[i].center + rng.inSphere(5.0f);
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Capsule.
+//-----------------------------------------------------------------------------
+
+static void BenchCapsuleBox(unsigned int iterations)
+{
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        bool hit = g_capsules[i & INPUT_MASK].hasCollided(g_boxes[(i >> 8) & INPUT_MASK]);
+        DoNotOptimize(hit);
+    }
+}
+
+static void BenchCapsuleCapsule(unsigned int iterations)
+{
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        bool hit = g_capsules[i & INPUT_MASK].hasCollided(g_capsules[(i >> 8) & INPUT_MASK]);
+        DoNotOptimize(hit);
+    }
+}
+
+static void BenchCapsuleSphere(unsigned int iterations)
+{
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        bool hit = g_capsules[i & INPUT_MASK].hasCollided(g_spheres[(i >> 8) & INPUT_MASK]);
+        DoNotOptimize(hit);
+    }
+}
+
+//-----------------------------------------------------------------------------
+// ConvexVolume.
+//-----------------------------------------------------------------------------
+
+static void BenchConvexVolumeBoxInVolume(unsigned int iterations)
+{
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        bool visible = g_portalVolume.boxInVolume(g_boxes[i & INPUT_MASK]);
+        DoNotOptimize(visible);
+    }
+}
+
+static void BenchConvexVolumeFromPortal(unsigned int iterations)
+{
+    ConvexVolume volume;
+
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        volume.fromPortal(g_frustum, g_rays[i & INPUT_MASK].origin * 0.1f, g_portal, 4);
+        DoNotOptimize(volume);
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Frustum.
+//-----------------------------------------------------------------------------
+
+static void BenchFrustumBoxInFrustum(unsigned int iterations)
+{
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        bool visible = g_frustum.boxInFrustum(g_boxes[i & INPUT_MASK]);
+        DoNotOptimize(visible);
+    }
+}
+
+static void BenchFrustumCapsuleInFrustum(unsigned int iterations)
+{
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        bool visible = g_frustum.capsuleInFrustum(g_capsules[i & INPUT_MASK]);
+        DoNotOptimize(visible);
+    }
+}
+
+static void BenchFrustumExtractPlanes(unsigned int iterations)
+{
+    Frustum frustum;
+
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        frustum.extractPlanes(g_views[i & INPUT_MASK], g_proj);
+        DoNotOptimize(frustum);
+    }
+}
+
+static void BenchFrustumExtractPlanesViewProj(unsigned int iterations)
+{
+    Frustum frustum;
+
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        frustum.extractPlanes(g_viewProjs[i & INPUT_MASK]);
+        DoNotOptimize(frustum);
+    }
+}
+
+static void BenchFrustumFromPerspective(unsigned int iterations)
+{
+    Frustum frustum;
+
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        frustum.fromPerspective(60.0f, 16.0f / 9.0f, 0.1f, 100.0f, g_views[i & INPUT_MASK]);
+        DoNotOptimize(frustum);
+    }
+}
+
+static void BenchFrustumFromViewSpace(unsigned int iterations)
+{
+    Frustum frustum;
+
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        frustum.fromViewSpace(g_viewSpaceFrustum, g_views[i & INPUT_MASK]);
+        DoNotOptimize(frustum);
+    }
+}
+
+//-----------------------------------------------------------------------------
+// OcclusionCuller. The rasterize benchmarks draw OCCLUDER_TRIANGLES
+// triangles into a 256 x 128 depth buffer per iteration.
+//-----------------------------------------------------------------------------
+
+static void BenchOcclusionRasterize(unsigned int iterations)
+{
+    static OcclusionCuller s_culler;
+
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        s_culler.beginFrame(g_proj);
+        s_culler.addOccluder(g_occluderVertices, g_occluderIndices, OCCLUDER_TRIANGLES);
+        s_culler.rasterize();
+        DoNotOptimize(s_culler);
+    }
+}
+
+static void BenchOcclusionRasterizeParallel(unsigned int iterations)
+{
+    static OcclusionCuller s_culler;
+    static ThreadPool s_pool;
+
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        s_culler.beginFrame(g_proj);
+        s_culler.addOccluder(g_occluderVertices, g_occluderIndices, OCCLUDER_TRIANGLES);
+        s_culler.rasterize(s_pool);
+        DoNotOptimize(s_culler);
+    }
+}
+
+static void BenchOcclusionIsVisible(unsigned int iterations)
+{
+    static OcclusionCuller s_culler;
+
+    s_culler.beginFrame(g_proj);
+    s_culler.addOccluder(g_occluderVertices, g_occluderIndices, OCCLUDER_TRIANGLES);
+    s_culler.rasterize();
+
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        bool visible = s_culler.isVisible(g_boxes[i & INPUT_MASK]);
+        DoNotOptimize(visible);
+    }
+}
+
+static void BenchHiZBuild(unsigned int iterations)
+{
+    static OcclusionCuller s_culler;
+    static HiZPyramid s_pyramid;
+
+    s_culler.beginFrame(g_proj);
+    s_culler.addOccluder(g_occluderVertices, g_occluderIndices, OCCLUDER_TRIANGLES);
+    s_culler.rasterize();
+
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        s_pyramid.build(s_culler);
+        DoNotOptimize(s_pyramid);
+    }
+}
+
+static void BenchHiZTestBoxes(unsigned int iterations)
+{
+    static OcclusionCuller s_culler;
+    static HiZPyramid s_pyramid;
+    static bool s_visible[INPUT_COUNT];
+
+    s_culler.beginFrame(g_proj);
+    s_culler.addOccluder(g_occluderVertices, g_occluderIndices, OCCLUDER_TRIANGLES);
+    s_culler.rasterize();
+    s_pyramid.build(s_culler);
+
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        std::fill(s_visible, s_visible + INPUT_COUNT, true);
+        s_pyramid.testBoxes(g_proj, g_boxes, s_visible, INPUT_COUNT);
+        DoNotOptimize(s_visible);
+    }
+}
+
+//-----------------------------------------------------------------------------
+// PortalGraph. The level is a grid of PORTAL_GRID x PORTAL_GRID rooms 10
+// units across, with a doorway in every wall between two rooms. The camera
+// is in a corner room looking diagonally across the grid.
+//-----------------------------------------------------------------------------
+
+static const int PORTAL_GRID = 8;
+
+static void BuildPortalGrid(PortalGraph &graph)
+{
+    for (int z = 0; z < PORTAL_GRID; ++z)
+    {
+        for (int x = 0; x < PORTAL_GRID; ++x)
+        {
+            Vector3 min(x * 10.0f, 0.0f, z * -10.0f - 10.0f);
+            graph.addCell(BoundingBox(min, min + Vector3(10.0f, 4.0f, 10.0f)));
+        }
+    }
+
+    for (int z = 0; z < PORTAL_GRID; ++z)
+    {
+        for (int x = 0; x < PORTAL_GRID; ++x)
+        {
+            int cell = z * PORTAL_GRID + x;
+            float cx = x * 10.0f + 5.0f;
+            float cz = z * -10.0f - 5.0f;
+
+            if (x + 1 < PORTAL_GRID)
+            {
+                Vector3 door[4] =
+                {
+                    Vector3(cx + 5.0f, 0.0f, cz - 1.0f),
+                    Vector3(cx + 5.0f, 0.0f, cz + 1.0f),
+                    Vector3(cx + 5.0f, 3.0f, cz + 1.0f),
+                    Vector3(cx + 5.0f, 3.0f, cz - 1.0f)
+                };
+
+                graph.addPortal(cell, cell + 1, door, 4);
+            }
+
+            if (z + 1 < PORTAL_GRID)
+            {
+                Vector3 door[4] =
+                {
+                    Vector3(cx - 1.0f, 0.0f, cz - 5.0f),
+                    Vector3(cx + 1.0f, 0.0f, cz - 5.0f),
+                    Vector3(cx + 1.0f, 3.0f, cz - 5.0f),
+                    Vector3(cx - 1.0f, 3.0f, cz - 5.0f)
+                };
+
+                graph.addPortal(cell, cell + PORTAL_GRID, door, 4);
+            }
+        }
+    }
+}
+
+static void BenchPortalGraphFindVisibleCells(unsigned int iterations)
+{
+    static PortalGraph s_graph;
+    static PortalQuery s_query(1024, PortalQuery::DEFAULT_MAX_DEPTH);
+
+    if (s_graph.cellCount() == 0)
+        BuildPortalGrid(s_graph);
+
+    Vector3 eye(4.0f, 1.5f, -4.0f);
+    Matrix4 rotation = Matrix4::createRotate(Vector3(0.0f, 1.0f, 0.0f), -45.0f);
+    Frustum frustum(Matrix4::createTranslate(-eye.x, -eye.y, -eye.z) * rotation.transpose(), g_proj);
+
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        bool complete = s_graph.findVisibleCells(s_query, eye, frustum, 0);
+        DoNotOptimize(complete);
+    }
+}
+
+//-----------------------------------------------------------------------------
+// BspTree. The trees are built from BSP_TRIANGLES triangles up to 6 units
+// across, scattered through a 100 unit box.
+//-----------------------------------------------------------------------------
+
+static const unsigned int BSP_TRIANGLES = 2000;
+
+static void BuildBspSoup(std::vector<Vector3> &vertices, std::vector<unsigned int> &counts)
+{
+    Random rng(48);
+
+    vertices.resize(BSP_TRIANGLES * 3);
+    counts.assign(BSP_TRIANGLES, 3);
+
+    for (unsigned int i = 0; i < BSP_TRIANGLES; ++i)
+    {
+        Vector3 center = rng.inBox(Vector3(-50.0f, -50.0f, -50.0f), Vector3(50.0f, 50.0f, 50.0f));
+
+        for (unsigned int k = 0; k < 3; ++k)
+            vertices[i * 3 + k] = center + rng.inSphere(3.0f);
+    }
+}
+
+static void BenchBspTreeBuild(unsigned int iterations)
+{
+    static std::vector<Vector3> s_vertices;
+    static std::vector<unsigned int> s_counts;
+    static BspTree s_tree;
+
+    if (s_vertices.empty())
+        BuildBspSoup(s_vertices, s_counts);
+
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        s_tree.build(&s_vertices[0], &s_counts[0], BSP_TRIANGLES);
+        DoNotOptimize(s_tree);
+    }
+}
+
+static void BenchBspTreeBuildParallel(unsigned int iterations)
+{
+    static std::vector<Vector3> s_vertices;
+    static std::vector<unsigned int> s_counts;
+    static BspTree s_tree;
+    static ThreadPool s_pool;
+
+    if (s_vertices.empty())
+        BuildBspSoup(s_vertices, s_counts);
+
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        s_tree.build(&s_vertices[0], &s_counts[0], BSP_TRIANGLES, s_pool);
+        DoNotOptimize(s_tree);
+    }
+}
+
+static void BenchBspTreeIntersectRay(unsigned int iterations)
+{
+    static std::vector<Vector3> s_vertices;
+    static std::vector<unsigned int> s_counts;
+    static BspTree s_tree;
+
+    if (s_vertices.empty())
+    {
+        BuildBspSoup(s_vertices, s_counts);
+        s_tree.build(&s_vertices[0], &s_counts[0], BSP_TRIANGLES);
+    }
+
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        float t = 0.0f;
+        int polygon = BspTree::NO_POLYGON;
+        bool hit = s_tree.intersectRay(g_rays[i & INPUT_MASK], t, polygon);
+        DoNotOptimize(hit);
+        DoNotOptimize(t);
+    }
+}
+
+static void BenchBspTreeSortFrontToBack(unsigned int iterations)
+{
+    static std::vector<Vector3> s_vertices;
+    static std::vector<unsigned int> s_counts;
+    static std::vector<int> s_order;
+    static BspTree s_tree;
+
+    if (s_vertices.empty())
+    {
+        BuildBspSoup(s_vertices, s_counts);
+        s_tree.build(&s_vertices[0], &s_counts[0], BSP_TRIANGLES);
+        s_order.resize(s_tree.polygonCount());
+    }
+
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        unsigned int count = s_tree.sortFrontToBack(g_rays[i & INPUT_MASK].origin, &s_order[0], s_tree.polygonCount());
+        DoNotOptimize(count);
+        DoNotOptimize(s_order[0]);
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Ray.
+//-----------------------------------------------------------------------------
+
+static void BenchRaySphere(unsigned int iterations)
+{
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        bool hit = g_rays[i & INPUT_MASK].hasIntersected(g_spheres[(i >> 8) & INPUT_MASK]);
+        DoNotOptimize(hit);
+    }
+}
+
+static void BenchRayBox(unsigned int iterations)
+{
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        bool hit = g_rays[i & INPUT_MASK].hasIntersected(g_boxes[(i >> 8) & INPUT_MASK]);
+        DoNotOptimize(hit);
+    }
+}
+
+static void BenchRayVolume(unsigned int iterations)
+{
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        bool hit = g_rays[i & INPUT_MASK].hasIntersected(g_volumes[(i >> 8) & INPUT_MASK]);
+        DoNotOptimize(hit);
+    }
+}
+
+static void BenchRayCapsule(unsigned int iterations)
+{
+    float t = 0.0f;
+
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        bool hit = g_rays[i & INPUT_MASK].hasIntersected(g_capsules[(i >> 8) & INPUT_MASK], t);
+        DoNotOptimize(hit);
+        DoNotOptimize(t);
+    }
+}
+
+static void BenchRayPlane(unsigned int iterations)
+{
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        bool hit = g_rays[i & INPUT_MASK].hasIntersected(g_planes[(i >> 8) & INPUT_MASK]);
+        DoNotOptimize(hit);
+    }
+}
+
+static void BenchRayPlaneIntersection(unsigned int iterations)
+{
+    float t;
+    Vector3 intersection;
+
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        bool hit = g_rays[i & INPUT_MASK].hasIntersected(g_planes[(i >> 8) & INPUT_MASK], t, intersection);
+        DoNotOptimize(hit);
+        DoNotOptimize(intersection);
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Sweep.
+//-----------------------------------------------------------------------------
+
+static void BenchSweepBoxBox(unsigned int iterations)
+{
+    float t = 0.0f;
+    Vector3 normal;
+
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        bool hit = Sweep::timeOfImpact(g_boxes[i & INPUT_MASK], g_velocities[i & INPUT_MASK], g_boxes[(i >> 8) & INPUT_MASK], t, normal);
+        DoNotOptimize(hit);
+        DoNotOptimize(t);
+    }
+}
+
+static void BenchSweepCapsuleCapsule(unsigned int iterations)
+{
+    float t = 0.0f;
+    Vector3 normal;
+
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        bool hit = Sweep::timeOfImpact(g_capsules[i & INPUT_MASK], g_velocities[i & INPUT_MASK], g_capsules[(i >> 8) & INPUT_MASK], t, normal);
+        DoNotOptimize(hit);
+        DoNotOptimize(t);
+    }
+}
+
+static void BenchSweepSphereBox(unsigned int iterations)
+{
+    float t = 0.0f;
+    Vector3 normal;
+
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        bool hit = Sweep::timeOfImpact(g_spheres[i & INPUT_MASK], g_velocities[i & INPUT_MASK], g_boxes[(i >> 8) & INPUT_MASK], t, normal);
+        DoNotOptimize(hit);
+        DoNotOptimize(t);
+    }
+}
+
+static void BenchSweepSphereSphere(unsigned int iterations)
+{
+    float t = 0.0f;
+    Vector3 normal;
+
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        bool hit = Sweep::timeOfImpact(g_spheres[i & INPUT_MASK], g_velocities[i & INPUT_MASK], g_spheres[(i >> 8) & INPUT_MASK], t, normal);
+        DoNotOptimize(hit);
+        DoNotOptimize(t);
+    }
+}
+
+static void BenchSweepSphereTriangle(unsigned int iterations)
+{
+    float t = 0.0f;
+    Vector3 normal;
+
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        bool hit = Sweep::timeOfImpact(g_spheres[i & INPUT_MASK], g_velocities[i & INPUT_MASK], &g_triangles[((i >> 8) & INPUT_MASK) * 3], t, normal);
+        DoNotOptimize(hit);
+        DoNotOptimize(t);
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Benchmarks all of the collision classes.
+//-----------------------------------------------------------------------------
+
+void BenchMathCollision()
+{
+    InitInputs();
+
+    RunBenchmark("Capsule::hasCollided(BoundingBox)", BenchCapsuleBox);
+    RunBenchmark("Capsule::hasCollided(Capsule)", BenchCapsuleCapsule);
+    RunBenchmark("Capsule::hasCollided(BoundingSphere)", BenchCapsuleSphere);
+    RunBenchmark("ConvexVolume::boxInVolume (11 planes)", BenchConvexVolumeBoxInVolume);
+    RunBenchmark("ConvexVolume::fromPortal", BenchConvexVolumeFromPortal);
+    RunBenchmark("Frustum::boxInFrustum", BenchFrustumBoxInFrustum);
+    RunBenchmark("Frustum::capsuleInFrustum", BenchFrustumCapsuleInFrustum);
+    RunBenchmark("Frustum::extractPlanes(view,proj)", BenchFrustumExtractPlanes);
+    RunBenchmark("Frustum::extractPlanes(viewProj)", BenchFrustumExtractPlanesViewProj);
+    RunBenchmark("Frustum::fromPerspective", BenchFrustumFromPerspective);
+    RunBenchmark("Frustum::fromViewSpace", BenchFrustumFromViewSpace);
+    RunBenchmark("OcclusionCuller::rasterize x512", BenchOcclusionRasterize, OCCLUDER_TRIANGLES);
+    RunBenchmark("OcclusionCuller::rasterize(pool) x512", BenchOcclusionRasterizeParallel, OCCLUDER_TRIANGLES);
+    RunBenchmark("OcclusionCuller::isVisible", BenchOcclusionIsVisible);
+    RunBenchmark("HiZPyramid::build(OcclusionCuller)", BenchHiZBuild);
+    RunBenchmark("HiZPyramid::testBoxes x256", BenchHiZTestBoxes, INPUT_COUNT);
+    RunBenchmark("PortalGraph::findVisibleCells 8x8 rooms", BenchPortalGraphFindVisibleCells);
+    RunBenchmark("BspTree::build 2000 triangles", BenchBspTreeBuild, BSP_TRIANGLES);
+    RunBenchmark("BspTree::build(pool) 2000 triangles", BenchBspTreeBuildParallel, BSP_TRIANGLES);
+    RunBenchmark("BspTree::intersectRay 2000 triangles", BenchBspTreeIntersectRay);
+    RunBenchmark("BspTree::sortFrontToBack 2000 triangles", BenchBspTreeSortFrontToBack);
+    RunBenchmark("Ray::hasIntersected(BoundingSphere)", BenchRaySphere);
+    RunBenchmark("Ray::hasIntersected(BoundingBox)", BenchRayBox);
+    RunBenchmark("Ray::hasIntersected(Capsule)", BenchRayCapsule);
+    RunBenchmark("Ray::hasIntersected(BoundingVolume)", BenchRayVolume);
+    RunBenchmark("Ray::hasIntersected(Plane)", BenchRayPlane);
+    RunBenchmark("Ray::hasIntersected(Plane,t,pt)", BenchRayPlaneIntersection);
+    RunBenchmark("Sweep::timeOfImpact(BoundingBox,BoundingBox)", BenchSweepBoxBox);
+    RunBenchmark("Sweep::timeOfImpact(Capsule,Capsule)", BenchSweepCapsuleCapsule);
+    RunBenchmark("Sweep::timeOfImpact(BoundingSphere,BoundingBox)", BenchSweepSphereBox);
+    RunBenchmark("Sweep::timeOfImpact(BoundingSphere,BoundingSphere)", BenchSweepSphereSphere);
+    RunBenchmark("Sweep::timeOfImpact(BoundingSphere,triangle)", BenchSweepSphereTriangle);
+}
@@ -0,0 +1,293 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2026 dhpoware. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include <vector>
+
+#include "bench_main.h"
+#include "vecexpr.h"
+
+void BenchMathCore();
+
+//-----------------------------------------------------------------------------
+// The inputs are generated once with a fixed seed. Benchmarks cycle through
+// them so that the compiler can't fold the work into constants.
+//-----------------------------------------------------------------------------
+
+static const unsigned int INPUT_COUNT = 256;
+static const unsigned int INPUT_MASK = INPUT_COUNT - 1;
+
+static Matrix4 g_matrices[INPUT_COUNT];
+static Matrix4 g_rigidMatrices[INPUT_COUNT];
+static Matrix4d g_matricesd[INPUT_COUNT];
+static Quaternion g_quaternions[INPUT_COUNT];
+static Vector3 g_vectors[INPUT_COUNT];
+static Vector3 g_targets[INPUT_COUNT];
+static float g_weights[INPUT_COUNT];
+static float g_angles[INPUT_COUNT];
+
+static void InitInputs()
+{
+    Random rng(2026);
+
+    for (unsigned int i = 0; i < INPUT_COUNT; ++i)
+    {
+        for (int r = 0; r < 4; ++r)
+        {
+            for (int c = 0; c < 4; ++c)
+                g_matrices[i][r][c] = rng.nextFloat(-1.0f, 1.0f);
+        }
+
+        g_matricesd[i] = Matrix4d(g_matrices[i]);
+
+        Vector3 t = rng.inBox(Vector3(-100.0f, -100.0f, -100.0f), Vector3(100.0f, 100.0f, 100.0f));
+
+        g_quaternions[i] = rng.unitQuaternion();
+        g_rigidMatrices[i] = g_quaternions[i].toMatrix4() * Matrix4::createTranslate(t.x, t.y, t.z);
+        g_vectors[i] = rng.inSphere(10.0f);
+        g_targets[i] = rng.inSphere(10.0f);
+        g_weights[i] = rng.nextFloat();
+        g_angles[i] = rng.nextFloat(-Math::PI, Math::PI);
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Vector3, Matrix4, Matrix4d and Quaternion.
+//-----------------------------------------------------------------------------
+
+static void BenchVector3Normalize(unsigned int iterations)
+{
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        Vector3 v = g_vectors[i & INPUT_MASK];
+        v.normalize();
+        DoNotOptimize(v);
+    }
+}
+
+static void BenchMatrix4Multiply(unsigned int iterations)
+{
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        Matrix4 m = g_matrices[i & INPUT_MASK] * g_matrices[(i + 1) & INPUT_MASK];
+        DoNotOptimize(m);
+    }
+}
+
+static void BenchMatrix4dMultiply(unsigned int iterations)
+{
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        Matrix4d m = g_matricesd[i & INPUT_MASK] * g_matricesd[(i + 1) & INPUT_MASK];
+        DoNotOptimize(m);
+    }
+}
+
+static void BenchMatrix4Inverse(unsigned int iterations)
+{
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        Matrix4 m = g_matrices[i & INPUT_MASK].inverse();
+        DoNotOptimize(m);
+    }
+}
+
+static void BenchMatrix4InverseGeneral(unsigned int iterations)
+{
+    Matrix4 m;
+
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        g_matrices[i & INPUT_MASK].inverseGeneral(m);
+        DoNotOptimize(m);
+    }
+}
+
+static void BenchMatrix4InverseAffine(unsigned int iterations)
+{
+    Matrix4 m;
+
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        g_rigidMatrices[i & INPUT_MASK].inverseAffine(m);
+        DoNotOptimize(m);
+    }
+}
+
+static void BenchMatrix4InverseRigid(unsigned int iterations)
+{
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        Matrix4 m = g_rigidMatrices[i & INPUT_MASK].inverseRigid();
+        DoNotOptimize(m);
+    }
+}
+
+static void BenchQuaternionSlerp(unsigned int iterations)
+{
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        Quaternion q = Quaternion::slerp(g_quaternions[i & INPUT_MASK],
+            g_quaternions[(i + 1) & INPUT_MASK], 0.3f);
+        DoNotOptimize(q);
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Matrix stacks. Each iteration is one push, multiply and pop.
+//-----------------------------------------------------------------------------
+
+static void BenchMatrixStack(unsigned int iterations)
+{
+    MatrixStack stack;
+
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        stack.pushMatrix();
+        stack.multMatrix(g_rigidMatrices[i & INPUT_MASK]);
+        DoNotOptimize(stack.currentMatrix());
+        stack.popMatrix();
+    }
+}
+
+static void BenchInlineMatrixStack(unsigned int iterations)
+{
+    InlineMatrixStack<16> stack;
+
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        stack.pushMatrix();
+        stack.multMatrix(g_rigidMatrices[i & INPUT_MASK]);
+        DoNotOptimize(stack.currentMatrix());
+        stack.popMatrix();
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Vector3 array expressions. Each iteration blends INPUT_COUNT vectors, so
+// divide by INPUT_COUNT for the time per vector. The first version applies
+// one Vector3 operator to the whole array at a time, the second evaluates
+// the same expression in a single pass with vecexpr.h.
+//-----------------------------------------------------------------------------
+
+static void BenchVector3BlendPerOperator(unsigned int iterations)
+{
+    Vector3 lhs[INPUT_COUNT], rhs[INPUT_COUNT], result[INPUT_COUNT];
+
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        for (unsigned int j = 0; j < INPUT_COUNT; ++j)
+            lhs[j] = g_vectors[j] * g_weights[j];
+
+        for (unsigned int j = 0; j < INPUT_COUNT; ++j)
+            rhs[j] = g_targets[j] * (1.0f - g_weights[j]);
+
+        for (unsigned int j = 0; j < INPUT_COUNT; ++j)
+            result[j] = lhs[j] + rhs[j];
+
+        DoNotOptimize(result);
+    }
+}
+
+static void BenchVector3BlendExpr(unsigned int iterations)
+{
+    static float s_inverseWeights[INPUT_COUNT];
+    Vector3 result[INPUT_COUNT];
+    Vector3Array<float> r(result, INPUT_COUNT);
+    ScalarArray<float> w0(g_weights), w1(s_inverseWeights);
+
+    for (unsigned int j = 0; j < INPUT_COUNT; ++j)
+        s_inverseWeights[j] = 1.0f - g_weights[j];
+
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        r = ConstVector3Array<float>(g_vectors) * w0 + ConstVector3Array<float>(g_targets) * w1;
+        DoNotOptimize(result);
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Math functions. Each iteration processes INPUT_COUNT values, so divide by
+// INPUT_COUNT for the time per value.
+//-----------------------------------------------------------------------------
+
+static void BenchSinCos(unsigned int iterations)
+{
+    float s[INPUT_COUNT], c[INPUT_COUNT];
+
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        for (unsigned int j = 0; j < INPUT_COUNT; ++j)
+            s[j] = sinf(g_angles[j]), c[j] = cosf(g_angles[j]);
+
+        DoNotOptimize(s);
+        DoNotOptimize(c);
+    }
+}
+
+static void BenchFastSinCos(unsigned int iterations)
+{
+    float s[INPUT_COUNT], c[INPUT_COUNT];
+
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        Math::fastSinCos(g_angles, s, c, INPUT_COUNT);
+        DoNotOptimize(s);
+        DoNotOptimize(c);
+    }
+}
+
+static void BenchRandomFill(unsigned int iterations)
+{
+    Random rng;
+    float values[INPUT_COUNT];
+
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        rng.fill(values, INPUT_COUNT);
+        DoNotOptimize(values);
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Benchmarks all of the core math classes.
+//-----------------------------------------------------------------------------
+
+void BenchMathCore()
+{
+    InitInputs();
+
+    RunBenchmark("Vector3::normalize", BenchVector3Normalize);
+    RunBenchmark("Matrix4::operator*", BenchMatrix4Multiply);
+    RunBenchmark("Matrix4d::operator*", BenchMatrix4dMultiply);
+    RunBenchmark("Matrix4::inverse", BenchMatrix4Inverse);
+    RunBenchmark("Matrix4::inverseGeneral", BenchMatrix4InverseGeneral);
+    RunBenchmark("Matrix4::inverseAffine", BenchMatrix4InverseAffine);
+    RunBenchmark("Matrix4::inverseRigid", BenchMatrix4InverseRigid);
+    RunBenchmark("Quaternion::slerp", BenchQuaternionSlerp);
+    RunBenchmark("MatrixStack push/mult/pop", BenchMatrixStack);
+    RunBenchmark("InlineMatrixStack push/mult/pop", BenchInlineMatrixStack);
+    RunBenchmark("Vector3 blend per operator x256", BenchVector3BlendPerOperator, INPUT_COUNT);
+    RunBenchmark("Vector3Array blend expression x256", BenchVector3BlendExpr, INPUT_COUNT);
+    RunBenchmark("sinf/cosf x256", BenchSinCos, INPUT_COUNT);
+    RunBenchmark("Math::fastSinCos x256", BenchFastSinCos, INPUT_COUNT);
+    RunBenchmark("Random::fill x256", BenchRandomFill, INPUT_COUNT);
+}
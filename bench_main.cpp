@@ -0,0 +1,374 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2026 dhpoware. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define BENCH_HAS_CYCLE_COUNTER
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_HAS_CYCLE_COUNTER
+#endif
+
+#include "bench_main.h"
+
+struct BenchmarkResult
+{
+    std::string name;
+    unsigned int iterations;
+    unsigned int repetitions;
+    double minNs;
+    double medianNs;
+    double meanNs;
+    double stddevNs;
+    double opsPerSec;
+    double cyclesPerOp;
+    unsigned int itemsPerOp;
+    double itemsPerSec;
+};
+
+struct BenchmarkOptions
+{
+    std::string filter;
+    std::string jsonFile;
+    std::string csvFile;
+    std::string baselineFile;
+    unsigned int repetitions;
+    double minTimeMs;
+    double threshold;
+};
+
+static BenchmarkOptions g_options;
+static std::vector<BenchmarkResult> g_results;
+
+static unsigned long long ReadCycleCounter();
+static bool ParseOptions(int argc, char *argv[]);
+static void PrintResult(const BenchmarkResult &r);
+static void WriteCsv(const std::string &filename);
+static void WriteJson(const std::string &filename);
+static int CompareWithBaseline(const std::string &filename);
+
+//-----------------------------------------------------------------------------
+// This application will benchmark the math library.
+//
+// Usage: bench [options]
+//  --filter <text>         only run benchmarks whose name contains <text>
+//  --repetitions <n>       number of timed repetitions (default 10)
+//  --min-time <ms>         minimum duration of one repetition (default 20)
+//  --csv <file>            write the results as CSV
+//  --json <file>           write the results as JSON
+//  --baseline <file>       compare against a CSV file written by --csv
+//  --threshold <fraction>  slowdown that counts as a regression (default 0.1)
+//
+// The exit code is 1 if the comparison with the baseline found a
+// regression, and 0 otherwise.
+//-----------------------------------------------------------------------------
+
+int main(int argc, char *argv[])
+{
+    if (!ParseOptions(argc, argv))
+        return 2;
+
+    std::cout << std::left << std::setw(44) << "benchmark" << std::right
+        << std::setw(12) << "ns/op" << std::setw(10) << "+/-"
+        << std::setw(16) << "ops/sec" << std::setw(12) << "cycles/op"
+        << std::setw(16) << "items/sec" << std::endl;
+
+    BenchMathCore();
+    BenchMathCollision();
+    BenchMathBatch();
+
+    if (!g_options.csvFile.empty())
+        WriteCsv(g_options.csvFile);
+
+    if (!g_options.jsonFile.empty())
+        WriteJson(g_options.jsonFile);
+
+    if (!g_options.baselineFile.empty())
+        return CompareWithBaseline(g_options.baselineFile);
+
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
+// Benchmark functions.
+//-----------------------------------------------------------------------------
+
+void BenchmarkUse(const volatile void *)
+{
+}
+
+void RunBenchmark(const char *name, BenchmarkFunction fn, unsigned int itemsPerOp)
+{
+    typedef std::chrono::steady_clock Clock;
+
+    if (!g_options.filter.empty() && std::strstr(name, g_options.filter.c_str()) == 0)
+        return;
+
+    // Double the iteration count until a single run takes at least the
+    // minimum repetition time. This also warms up the caches and the
+    // branch predictors. One more untimed run follows as the warm-up.
+
+    unsigned int iterations = 1;
+
+    for (;;)
+    {
+        Clock::time_point start = Clock::now();
+        fn(iterations);
+        double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+        if (ms >= g_options.minTimeMs || iterations >= (1u << 30))
+            break;
+
+        iterations *= 2;
+    }
+
+    fn(iterations);
+
+    std::vector<double> samples;
+    unsigned long long totalCycles = 0;
+
+    for (unsigned int i = 0; i < g_options.repetitions; ++i)
+    {
+        unsigned long long startCycles = ReadCycleCounter();
+        Clock::time_point start = Clock::now();
+
+        fn(iterations);
+
+        Clock::time_point end = Clock::now();
+        totalCycles += ReadCycleCounter() - startCycles;
+
+        double ns = std::chrono::duration<double, std::nano>(end - start).count();
+        samples.push_back(ns / iterations);
+    }
+
+    std::vector<double> sorted(samples);
+    std::sort(sorted.begin(), sorted.end());
+
+    size_t n = sorted.size();
+    double sum = 0.0;
+    double sumSq = 0.0;
+
+    for (size_t i = 0; i < n; ++i)
+        sum += sorted[i];
+
+    double mean = sum / n;
+
+    for (size_t i = 0; i < n; ++i)
+        sumSq += (sorted[i] - mean) * (sorted[i] - mean);
+
+    BenchmarkResult r;
+
+    r.name = name;
+    r.iterations = iterations;
+    r.repetitions = static_cast<unsigned int>(n);
+    r.minNs = sorted[0];
+    r.medianNs = (n % 2) ? sorted[n / 2] : 0.5 * (sorted[n / 2 - 1] + sorted[n / 2]);
+    r.meanNs = mean;
+    r.stddevNs = (n > 1) ? sqrt(sumSq / (n - 1)) : 0.0;
+    r.opsPerSec = (r.medianNs > 0.0) ? 1e9 / r.medianNs : 0.0;
+    r.cyclesPerOp = static_cast<double>(totalCycles) / (static_cast<double>(iterations) * n);
+    r.itemsPerOp = itemsPerOp;
+    r.itemsPerSec = r.opsPerSec * itemsPerOp;
+
+    g_results.push_back(r);
+    PrintResult(r);
+}
+
+//-----------------------------------------------------------------------------
+// Helper functions.
+//-----------------------------------------------------------------------------
+
+static unsigned long long ReadCycleCounter()
+{
+    // Returns the time stamp counter. On processors with an invariant TSC
+    // this counts at a constant rate rather than at the core clock, so the
+    // cycle counts are only comparable on the same machine.
+
+#if defined(BENCH_HAS_CYCLE_COUNTER)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+static bool ParseOptions(int argc, char *argv[])
+{
+    g_options.repetitions = 10;
+    g_options.minTimeMs = 20.0;
+    g_options.threshold = 0.1;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string option = argv[i];
+
+        if (i + 1 >= argc)
+        {
+            std::cerr << "bench: missing value for " << option << std::endl;
+            return false;
+        }
+
+        std::string value = argv[++i];
+
+        if (option == "--filter")
+            g_options.filter = value;
+        else if (option == "--repetitions")
+            g_options.repetitions = std::max(1, atoi(value.c_str()));
+        else if (option == "--min-time")
+            g_options.minTimeMs = atof(value.c_str());
+        else if (option == "--csv")
+            g_options.csvFile = value;
+        else if (option == "--json")
+            g_options.jsonFile = value;
+        else if (option == "--baseline")
+            g_options.baselineFile = value;
+        else if (option == "--threshold")
+            g_options.threshold = atof(value.c_str());
+        else
+        {
+            std::cerr << "bench: unknown option " << option << std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void PrintResult(const BenchmarkResult &r)
+{
+    std::cout << std::left << std::setw(44) << r.name << std::right << std::fixed
+        << std::setprecision(2) << std::setw(12) << r.medianNs
+        << std::setw(10) << r.stddevNs
+        << std::setprecision(0) << std::setw(16) << r.opsPerSec
+        << std::setprecision(1) << std::setw(12) << r.cyclesPerOp
+        << std::setprecision(0) << std::setw(16) << r.itemsPerSec << std::endl;
+}
+
+static void WriteCsv(const std::string &filename)
+{
+    std::ofstream out(filename.c_str());
+
+    out << "name,iterations,repetitions,min_ns,median_ns,mean_ns,stddev_ns,ops_per_sec,cycles_per_op,items_per_op,items_per_sec\n";
+    out << std::setprecision(6);
+
+    for (size_t i = 0; i < g_results.size(); ++i)
+    {
+        const BenchmarkResult &r = g_results[i];
+
+        out << r.name << ',' << r.iterations << ',' << r.repetitions << ','
+            << r.minNs << ',' << r.medianNs << ',' << r.meanNs << ','
+            << r.stddevNs << ',' << r.opsPerSec << ',' << r.cyclesPerOp << ','
+            << r.itemsPerOp << ',' << r.itemsPerSec << '\n';
+    }
+}
+
+static void WriteJson(const std::string &filename)
+{
+    std::ofstream out(filename.c_str());
+
+    out << "{\n  \"benchmarks\": [\n" << std::setprecision(6);
+
+    for (size_t i = 0; i < g_results.size(); ++i)
+    {
+        const BenchmarkResult &r = g_results[i];
+
+        out << "    { \"name\": \"" << r.name << "\""
+            << ", \"iterations\": " << r.iterations
+            << ", \"repetitions\": " << r.repetitions
+            << ", \"min_ns\": " << r.minNs
+            << ", \"median_ns\": " << r.medianNs
+            << ", \"mean_ns\": " << r.meanNs
+            << ", \"stddev_ns\": " << r.stddevNs
+            << ", \"ops_per_sec\": " << r.opsPerSec
+            << ", \"cycles_per_op\": " << r.cyclesPerOp
+            << ", \"items_per_op\": " << r.itemsPerOp
+            << ", \"items_per_sec\": " << r.itemsPerSec << " }"
+            << ((i + 1 < g_results.size()) ? ",\n" : "\n");
+    }
+
+    out << "  ]\n}\n";
+}
+
+static int CompareWithBaseline(const std::string &filename)
+{
+    // Compares the median of each benchmark with the median recorded in
+    // the baseline CSV file. A benchmark regressed if its median is more
+    // than 'threshold' slower than the baseline. Benchmarks that are not
+    // in the baseline are skipped.
+
+    std::ifstream in(filename.c_str());
+    std::string line;
+    int regressions = 0;
+
+    if (!in)
+    {
+        std::cerr << "bench: cannot open baseline " << filename << std::endl;
+        return 2;
+    }
+
+    std::cout << "\ncomparison with " << filename << ":" << std::endl;
+    std::getline(in, line);
+
+    while (std::getline(in, line))
+    {
+        std::stringstream fields(line);
+        std::string name, iterations, repetitions, minNs, medianNs;
+
+        std::getline(fields, name, ',');
+        std::getline(fields, iterations, ',');
+        std::getline(fields, repetitions, ',');
+        std::getline(fields, minNs, ',');
+        std::getline(fields, medianNs, ',');
+
+        double baseline = atof(medianNs.c_str());
+
+        for (size_t i = 0; i < g_results.size(); ++i)
+        {
+            if (g_results[i].name != name || baseline <= 0.0)
+                continue;
+
+            double change = g_results[i].medianNs / baseline - 1.0;
+            bool regressed = change > g_options.threshold;
+
+            if (regressed)
+                ++regressions;
+
+            std::cout << std::left << std::setw(44) << name << std::right
+                << std::fixed << std::setprecision(1) << std::setw(8)
+                << (change * 100.0) << "%" << (regressed ? "  REGRESSION" : "")
+                << std::endl;
+        }
+    }
+
+    std::cout << regressions << " regression(s)" << std::endl;
+    return (regressions > 0) ? 1 : 0;
+}
@@ -0,0 +1,59 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2026 dhpoware. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#if !defined(BENCH_MAIN_H)
+#define BENCH_MAIN_H
+
+#include "mathlib.h"
+#include "collision.h"
+
+//-----------------------------------------------------------------------------
+// A benchmark function performs the operation being measured 'iterations'
+// times. RunBenchmark() picks an iteration count that makes each timed
+// repetition last long enough to measure, warms up, times several
+// repetitions and records the statistics. 'itemsPerOp' is the number of
+// objects one operation processes (the 256 boxes of a batched cull, say);
+// it is only used to report items/sec next to ops/sec.
+//
+// Benchmark functions should pass each result to DoNotOptimize() so that the
+// compiler can't remove the work being measured.
+
+typedef void (*BenchmarkFunction)(unsigned int iterations);
+
+extern void RunBenchmark(const char *name, BenchmarkFunction fn, unsigned int itemsPerOp = 1);
+extern void BenchmarkUse(const volatile void *p);
+
+template <typename T>
+inline void DoNotOptimize(const T &value)
+{
+#if defined(__GNUC__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    BenchmarkUse(&value);
+#endif
+}
+
+extern void BenchMathCore();
+extern void BenchMathCollision();
+extern void BenchMathBatch();
+
+#endif
@@ -0,0 +1,616 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2026 dhpoware. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cfloat>
+#include <cstdlib>
+
+#include "bsptree.h"
+#include "threadpool.h"
+
+// Vertices closer than this to a plane are taken to lie in it.
+static const float BSP_EPSILON = 1e-4f;
+
+enum BspSide
+{
+    BSP_COPLANAR,
+    BSP_FRONT,
+    BSP_BACK,
+    BSP_SPANNING
+};
+
+static BspSide classifyPolygon(const Plane &plane, const Vector3 *vertices, unsigned int count)
+{
+    bool front = false;
+    bool back = false;
+
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        float d = Vector3::dot(plane.n, vertices[i]) + plane.d;
+
+        if (d > BSP_EPSILON)
+            front = true;
+        else if (d < -BSP_EPSILON)
+            back = true;
+    }
+
+    if (front)
+        return back ? BSP_SPANNING : BSP_FRONT;
+
+    return back ? BSP_BACK : BSP_COPLANAR;
+}
+
+// Builds one tree, or one subtree when the ThreadPool version of build()
+// hands out the subtrees below 'm_parallelDepth' as tasks. The polygons
+// being split refer to 'm_work'; the finished ones are copied to
+// 'm_vertices'.
+class BspTree::Builder
+{
+public:
+    struct Task
+    {
+        std::vector<Polygon> polygons;
+        std::vector<Vector3> vertices;
+        unsigned int depth;
+        int parent;
+        bool front;
+    };
+
+    Builder();
+
+    void append(const Builder &subtree, int parent, bool front);
+    int build(std::vector<Polygon> &polygons, unsigned int depth, bool solid);
+
+    std::vector<Node> m_nodes;
+    std::vector<Polygon> m_polygons;
+    std::vector<Vector3> m_vertices;
+    std::vector<unsigned char> m_solidLeaves;
+    std::vector<Vector3> m_work;
+    std::vector<Task> m_tasks;
+    int m_root;
+    unsigned int m_depth;
+    unsigned int m_parallelDepth;
+    float m_splitWeight;
+
+private:
+    int buildChild(std::vector<Polygon> &polygons, unsigned int depth, bool solid, int parent, bool front);
+    unsigned int chooseSplitter(const std::vector<Polygon> &polygons) const;
+    void split(const Plane &plane, const Polygon &polygon, std::vector<Polygon> &front, std::vector<Polygon> &back);
+
+    std::vector<Vector3> m_clipped;
+};
+
+BspTree::Builder::Builder() : m_root(~0), m_depth(0), m_parallelDepth(~0u), m_splitWeight(8.0f)
+{
+}
+
+void BspTree::Builder::append(const Builder &subtree, int parent, bool front)
+{
+    // Moves the subtree's arrays to the end of ours, offsetting its indices,
+    // and links its root to the parent node it was handed out from.
+
+    int nodeOffset = static_cast<int>(m_nodes.size());
+    int leafOffset = static_cast<int>(m_solidLeaves.size());
+    unsigned int polygonOffset = static_cast<unsigned int>(m_polygons.size());
+    unsigned int vertexOffset = static_cast<unsigned int>(m_vertices.size());
+
+    for (size_t i = 0; i < subtree.m_nodes.size(); ++i)
+    {
+        Node node = subtree.m_nodes[i];
+
+        node.front = (node.front >= 0) ? node.front + nodeOffset : ~(~node.front + leafOffset);
+        node.back = (node.back >= 0) ? node.back + nodeOffset : ~(~node.back + leafOffset);
+        node.firstPolygon += polygonOffset;
+        m_nodes.push_back(node);
+    }
+
+    for (size_t i = 0; i < subtree.m_polygons.size(); ++i)
+    {
+        Polygon polygon = subtree.m_polygons[i];
+
+        polygon.firstVertex += vertexOffset;
+        m_polygons.push_back(polygon);
+    }
+
+    m_vertices.insert(m_vertices.end(), subtree.m_vertices.begin(), subtree.m_vertices.end());
+    m_solidLeaves.insert(m_solidLeaves.end(), subtree.m_solidLeaves.begin(), subtree.m_solidLeaves.end());
+    m_depth = std::max(m_depth, subtree.m_depth);
+
+    int root = (subtree.m_root >= 0) ? subtree.m_root + nodeOffset : ~(~subtree.m_root + leafOffset);
+
+    if (front)
+        m_nodes[parent].front = root;
+    else
+        m_nodes[parent].back = root;
+}
+
+int BspTree::Builder::build(std::vector<Polygon> &polygons, unsigned int depth, bool solid)
+{
+    // Returns the index of the new node, or ~leaf if there are no polygons.
+    // The polygons are consumed.
+
+    if (polygons.empty())
+    {
+        m_solidLeaves.push_back(solid ? 1 : 0);
+        return ~static_cast<int>(m_solidLeaves.size() - 1);
+    }
+
+    m_depth = std::max(m_depth, depth + 1);
+
+    int index = static_cast<int>(m_nodes.size());
+    unsigned int splitter = chooseSplitter(polygons);
+    Node node;
+
+    node.plane = polygons[splitter].plane;
+    node.front = ~0;
+    node.back = ~0;
+    node.firstPolygon = static_cast<unsigned int>(m_polygons.size());
+    node.polygonCount = 0;
+
+    std::vector<Polygon> front;
+    std::vector<Polygon> back;
+
+    for (size_t i = 0; i < polygons.size(); ++i)
+    {
+        const Polygon &polygon = polygons[i];
+        BspSide side = classifyPolygon(node.plane, &m_work[polygon.firstVertex], polygon.vertexCount);
+
+        // The splitter stays in the node even if rounding puts one of its
+        // vertices just outside the tolerance, so every node makes progress.
+        if (i == splitter)
+            side = BSP_COPLANAR;
+
+        switch (side)
+        {
+        case BSP_COPLANAR:
+        {
+            Polygon kept = polygon;
+
+            kept.firstVertex = static_cast<unsigned int>(m_vertices.size());
+            m_vertices.insert(m_vertices.end(), m_work.begin() + polygon.firstVertex,
+                m_work.begin() + polygon.firstVertex + polygon.vertexCount);
+            m_polygons.push_back(kept);
+            ++node.polygonCount;
+            break;
+        }
+
+        case BSP_FRONT:
+            front.push_back(polygon);
+            break;
+
+        case BSP_BACK:
+            back.push_back(polygon);
+            break;
+
+        case BSP_SPANNING:
+            split(node.plane, polygon, front, back);
+            break;
+        }
+    }
+
+    // The polygons aren't needed while the subtrees are built.
+    std::vector<Polygon>().swap(polygons);
+    m_nodes.push_back(node);
+
+    int frontChild = buildChild(front, depth + 1, false, index, true);
+    m_nodes[index].front = frontChild;
+
+    int backChild = buildChild(back, depth + 1, true, index, false);
+    m_nodes[index].back = backChild;
+
+    return index;
+}
+
+int BspTree::Builder::buildChild(std::vector<Polygon> &polygons, unsigned int depth, bool solid, int parent, bool front)
+{
+    // Below the parallel depth the subtree is handed out as a task with its
+    // own copy of the vertices, and linked in by append() once it is built.
+
+    if (depth < m_parallelDepth || polygons.empty())
+        return build(polygons, depth, solid);
+
+    m_tasks.push_back(Task());
+
+    Task &task = m_tasks.back();
+
+    task.depth = depth;
+    task.parent = parent;
+    task.front = front;
+    task.polygons.swap(polygons);
+
+    for (size_t i = 0; i < task.polygons.size(); ++i)
+    {
+        Polygon &polygon = task.polygons[i];
+        unsigned int first = polygon.firstVertex;
+
+        polygon.firstVertex = static_cast<unsigned int>(task.vertices.size());
+        task.vertices.insert(task.vertices.end(), m_work.begin() + first, m_work.begin() + first + polygon.vertexCount);
+    }
+
+    return ~0;
+}
+
+unsigned int BspTree::Builder::chooseSplitter(const std::vector<Polygon> &polygons) const
+{
+    // Tries the planes of up to MAX_SPLIT_CANDIDATES polygons, spread evenly
+    // over the list, against all of the polygons.
+
+    unsigned int count = static_cast<unsigned int>(polygons.size());
+    unsigned int step = (count > MAX_SPLIT_CANDIDATES) ? count / MAX_SPLIT_CANDIDATES : 1;
+    unsigned int best = 0;
+    float bestCost = 0.0f;
+
+    for (unsigned int c = 0, tried = 0; c < count && tried < MAX_SPLIT_CANDIDATES; c += step, ++tried)
+    {
+        const Plane &plane = polygons[c].plane;
+        int front = 0;
+        int back = 0;
+        int splits = 0;
+
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            switch (classifyPolygon(plane, &m_work[polygons[i].firstVertex], polygons[i].vertexCount))
+            {
+            case BSP_COPLANAR:
+                break;
+
+            case BSP_FRONT:
+                ++front;
+                break;
+
+            case BSP_BACK:
+                ++back;
+                break;
+
+            case BSP_SPANNING:
+                ++front;
+                ++back;
+                ++splits;
+                break;
+            }
+        }
+
+        float cost = static_cast<float>(abs(front - back)) + m_splitWeight * static_cast<float>(splits);
+
+        if (tried == 0 || cost < bestCost)
+        {
+            best = c;
+            bestCost = cost;
+        }
+    }
+
+    return best;
+}
+
+void BspTree::Builder::split(const Plane &plane, const Polygon &polygon, std::vector<Polygon> &front, std::vector<Polygon> &back)
+{
+    // Each half of a convex polygon has at most one more vertex than it.
+
+    Plane flipped(-plane.n.x, -plane.n.y, -plane.n.z, -plane.d);
+
+    m_clipped.resize(polygon.vertexCount + 1);
+
+    for (int side = 0; side < 2; ++side)
+    {
+        unsigned int count = Plane::clipPolygon((side == 0) ? plane : flipped,
+            &m_work[polygon.firstVertex], polygon.vertexCount, &m_clipped[0]);
+
+        if (count < 3)
+            continue;
+
+        Polygon half = polygon;
+
+        half.firstVertex = static_cast<unsigned int>(m_work.size());
+        half.vertexCount = count;
+        m_work.insert(m_work.end(), m_clipped.begin(), m_clipped.begin() + count);
+
+        if (side == 0)
+            front.push_back(half);
+        else
+            back.push_back(half);
+    }
+}
+
+BspTree::BspTree() : m_root(~0), m_depth(0), m_splitWeight(8.0f)
+{
+    clear();
+}
+
+BspTree::~BspTree()
+{
+}
+
+bool BspTree::build(const Vector3 *vertices, const unsigned int *vertexCounts, unsigned int polygonCount)
+{
+    return buildTree(vertices, vertexCounts, polygonCount, 0);
+}
+
+bool BspTree::build(const Vector3 *vertices, const unsigned int *vertexCounts, unsigned int polygonCount, ThreadPool &pool)
+{
+    return buildTree(vertices, vertexCounts, polygonCount, &pool);
+}
+
+void BspTree::clear()
+{
+    // An empty tree is a single empty leaf.
+
+    m_nodes.clear();
+    m_polygons.clear();
+    m_vertices.clear();
+    m_solidLeaves.assign(1, 0);
+    m_root = ~0;
+    m_depth = 0;
+}
+
+unsigned int BspTree::depth() const
+{
+    return m_depth;
+}
+
+int BspTree::findLeaf(const Vector3 &point) const
+{
+    int child = m_root;
+
+    while (child >= 0)
+    {
+        const Node &node = m_nodes[child];
+
+        child = (Vector3::dot(node.plane.n, point) + node.plane.d >= 0.0f) ? node.front : node.back;
+    }
+
+    return ~child;
+}
+
+bool BspTree::intersectRay(const Ray &ray, float &t, int &polygon) const
+{
+    return intersectNode(m_root, ray, 0.0f, FLT_MAX, t, polygon);
+}
+
+bool BspTree::isLeafSolid(int leaf) const
+{
+    return m_solidLeaves[leaf] != 0;
+}
+
+unsigned int BspTree::leafCount() const
+{
+    return static_cast<unsigned int>(m_solidLeaves.size());
+}
+
+unsigned int BspTree::nodeCount() const
+{
+    return static_cast<unsigned int>(m_nodes.size());
+}
+
+unsigned int BspTree::polygonCount() const
+{
+    return static_cast<unsigned int>(m_polygons.size());
+}
+
+int BspTree::polygonSource(int polygon) const
+{
+    return m_polygons[polygon].source;
+}
+
+unsigned int BspTree::polygonVertexCount(int polygon) const
+{
+    return m_polygons[polygon].vertexCount;
+}
+
+const Vector3 *BspTree::polygonVertices(int polygon) const
+{
+    return &m_vertices[m_polygons[polygon].firstVertex];
+}
+
+void BspTree::setSplitWeight(float weight)
+{
+    m_splitWeight = weight;
+}
+
+unsigned int BspTree::sortFrontToBack(const Vector3 &eye, int *polygons, unsigned int maxPolygons) const
+{
+    unsigned int count = 0;
+
+    sortNode(m_root, eye, polygons, maxPolygons, count);
+    return count;
+}
+
+float BspTree::splitWeight() const
+{
+    return m_splitWeight;
+}
+
+bool BspTree::buildTree(const Vector3 *vertices, const unsigned int *vertexCounts, unsigned int polygonCount, ThreadPool *pPool)
+{
+    Builder builder;
+    std::vector<Polygon> polygons;
+    unsigned int firstVertex = 0;
+
+    clear();
+    polygons.reserve(polygonCount);
+
+    for (unsigned int i = 0; i < polygonCount; ++i)
+    {
+        unsigned int count = vertexCounts[i];
+        const Vector3 *pVertices = vertices + firstVertex;
+
+        if (count < 3)
+            return false;
+
+        // The polygon's plane, with its normal found by Newell's method.
+        // The vertices are taken relative to the centroid, which keeps the
+        // normals of thin polygons far from the origin accurate.
+        Vector3 centroid(0.0f, 0.0f, 0.0f);
+        Vector3 normal(0.0f, 0.0f, 0.0f);
+
+        for (unsigned int k = 0; k < count; ++k)
+            centroid += pVertices[k];
+
+        centroid /= static_cast<float>(count);
+
+        for (unsigned int k = 0; k < count; ++k)
+            normal += Vector3::cross(pVertices[k] - centroid, pVertices[(k + 1) % count] - centroid);
+
+        float length = normal.magnitude();
+
+        if (length > Math::EPSILON)
+        {
+            Polygon polygon;
+
+            polygon.plane = Plane(centroid, normal / length);
+            polygon.firstVertex = firstVertex;
+            polygon.vertexCount = count;
+            polygon.source = static_cast<int>(i);
+            polygons.push_back(polygon);
+        }
+
+        firstVertex += count;
+    }
+
+    builder.m_work.assign(vertices, vertices + firstVertex);
+    builder.m_splitWeight = m_splitWeight;
+
+    // Enough levels on this thread to give every thread about 4 subtrees.
+    if (pPool)
+    {
+        builder.m_parallelDepth = 0;
+
+        while ((1u << builder.m_parallelDepth) < pPool->threadCount() * 4 && builder.m_parallelDepth < 16)
+            ++builder.m_parallelDepth;
+    }
+
+    builder.m_root = builder.build(polygons, 0, false);
+
+    if (!builder.m_tasks.empty())
+    {
+        std::vector<Builder> subtrees(builder.m_tasks.size());
+
+        pPool->parallelFor(static_cast<unsigned int>(subtrees.size()), 1,
+            [&builder, &subtrees](unsigned int begin, unsigned int end)
+            {
+                for (unsigned int i = begin; i < end; ++i)
+                {
+                    Builder::Task &task = builder.m_tasks[i];
+                    Builder &subtree = subtrees[i];
+
+                    subtree.m_splitWeight = builder.m_splitWeight;
+                    subtree.m_work.swap(task.vertices);
+                    subtree.m_root = subtree.build(task.polygons, task.depth, false);
+                }
+            });
+
+        for (size_t i = 0; i < subtrees.size(); ++i)
+            builder.append(subtrees[i], builder.m_tasks[i].parent, builder.m_tasks[i].front);
+    }
+
+    m_nodes.swap(builder.m_nodes);
+    m_polygons.swap(builder.m_polygons);
+    m_vertices.swap(builder.m_vertices);
+    m_solidLeaves.swap(builder.m_solidLeaves);
+    m_root = builder.m_root;
+    m_depth = builder.m_depth;
+    return true;
+}
+
+bool BspTree::intersectNode(int child, const Ray &ray, float tMin, float tMax, float &t, int &polygon) const
+{
+    // Walks the side of each plane that the segment [tMin, tMax] of the ray
+    // starts on, then the node's own polygons where the ray crosses the
+    // plane, then the other side. So the first hit found is the nearest.
+
+    while (child >= 0)
+    {
+        const Node &node = m_nodes[child];
+        float start = Vector3::dot(node.plane.n, ray.origin) + node.plane.d;
+        float speed = Vector3::dot(node.plane.n, ray.direction);
+        bool frontFirst = (start + speed * tMin >= 0.0f);
+        int nearChild = frontFirst ? node.front : node.back;
+        int farChild = frontFirst ? node.back : node.front;
+
+        if (speed == 0.0f)
+        {
+            child = nearChild;
+            continue;
+        }
+
+        float tPlane = -start / speed;
+
+        if (tPlane < tMin || tPlane > tMax)
+        {
+            child = nearChild;
+            continue;
+        }
+
+        if (intersectNode(nearChild, ray, tMin, tPlane, t, polygon))
+            return true;
+
+        Vector3 point = ray.origin + ray.direction * tPlane;
+
+        for (unsigned int i = 0; i < node.polygonCount; ++i)
+        {
+            const Polygon &p = m_polygons[node.firstPolygon + i];
+            const Vector3 *pVertices = &m_vertices[p.firstVertex];
+            unsigned int k = 0;
+
+            // Inside every edge, with the same tolerance as the planes so
+            // that rays don't slip between the pieces of a split polygon.
+            for (; k < p.vertexCount; ++k)
+            {
+                const Vector3 &a = pVertices[k];
+                Vector3 edge = pVertices[(k + 1 == p.vertexCount) ? 0 : k + 1] - a;
+
+                if (Vector3::dot(Vector3::cross(edge, point - a), p.plane.n) < -BSP_EPSILON * edge.magnitude())
+                    break;
+            }
+
+            if (k == p.vertexCount)
+            {
+                t = tPlane;
+                polygon = static_cast<int>(node.firstPolygon + i);
+                return true;
+            }
+        }
+
+        child = farChild;
+        tMin = tPlane;
+    }
+
+    return false;
+}
+
+void BspTree::sortNode(int child, const Vector3 &eye, int *polygons, unsigned int maxPolygons, unsigned int &count) const
+{
+    // The subtree on the eye's side of the plane first, then the polygons in
+    // the plane, then the subtree on the far side.
+
+    while (child >= 0 && count < maxPolygons)
+    {
+        const Node &node = m_nodes[child];
+        bool frontFirst = (Vector3::dot(node.plane.n, eye) + node.plane.d >= 0.0f);
+
+        sortNode(frontFirst ? node.front : node.back, eye, polygons, maxPolygons, count);
+
+        for (unsigned int i = 0; i < node.polygonCount && count < maxPolygons; ++i)
+            polygons[count++] = static_cast<int>(node.firstPolygon + i);
+
+        child = frontFirst ? node.back : node.front;
+    }
+}
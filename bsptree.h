@@ -0,0 +1,136 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2026 dhpoware. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#if !defined(BSPTREE_H)
+#define BSPTREE_H
+
+#include <vector>
+
+#include "mathlib.h"
+#include "collision.h"
+
+class ThreadPool;
+
+//-----------------------------------------------------------------------------
+// The BspTree class is a binary space partitioning tree built from a polygon
+// soup: convex, planar polygons given as runs of vertices. Each node splits
+// space by the plane of one of its polygons and keeps the polygons lying in
+// that plane. The other polygons go to the front or back subtree, and those
+// crossing the plane are split in two with Plane::clipPolygon(), so the tree
+// usually holds more polygons than were passed in; polygonSource() gives the
+// input polygon each one came from. The empty subtrees are the leaves,
+// numbered from 0, each a convex region of space. A leaf behind its
+// parent's plane is solid: for a closed mesh with its polygons facing out,
+// those are the leaves inside the mesh.
+//
+// The plane of each node is picked from up to MAX_SPLIT_CANDIDATES of its
+// polygons, spread evenly over them, by the cost
+//
+//      |front polygons - back polygons| + splitWeight * split polygons
+//
+// A weight of 0 builds the most balanced tree, and larger weights build
+// deeper trees with fewer split polygons. The default weight is 8.
+//
+// The nodes, polygons and vertices are stored in flat arrays. The nodes of
+// each subtree are contiguous, with the front child following its parent,
+// and the polygons of each node are next to each other. The ThreadPool
+// version of build() builds the top levels on the calling thread and the
+// subtrees below them in parallel. It builds the same tree as the serial
+// version, but numbers the nodes, leaves and polygons differently.
+//
+// findLeaf() returns the leaf containing a point; points on a plane are in
+// front of it. sortFrontToBack() lists the polygons in order from the eye,
+// so that no polygon is listed after one it can hide. intersectRay() finds
+// the nearest polygon hit by a ray, with 't' measured in units of the ray's
+// direction as in Ray::hasIntersected().
+//
+// build() returns false, and leaves the tree empty, if a polygon has fewer
+// than 3 vertices. Polygons without area are skipped. Vertices closer than
+// 1e-4 to a plane are taken to lie in it, so the input should be in units
+// of the size of a level (meters, say) rather than much smaller ones.
+
+class BspTree
+{
+public:
+    static const int NO_POLYGON = -1;
+    static const unsigned int MAX_SPLIT_CANDIDATES = 32;
+
+    BspTree();
+    ~BspTree();
+
+    bool build(const Vector3 *vertices, const unsigned int *vertexCounts, unsigned int polygonCount);
+    bool build(const Vector3 *vertices, const unsigned int *vertexCounts, unsigned int polygonCount, ThreadPool &pool);
+    void clear();
+    unsigned int depth() const;
+    int findLeaf(const Vector3 &point) const;
+    bool intersectRay(const Ray &ray, float &t, int &polygon) const;
+    bool isLeafSolid(int leaf) const;
+    unsigned int leafCount() const;
+    unsigned int nodeCount() const;
+    unsigned int polygonCount() const;
+    int polygonSource(int polygon) const;
+    unsigned int polygonVertexCount(int polygon) const;
+    const Vector3 *polygonVertices(int polygon) const;
+    void setSplitWeight(float weight);
+    unsigned int sortFrontToBack(const Vector3 &eye, int *polygons, unsigned int maxPolygons) const;
+    float splitWeight() const;
+
+private:
+    class Builder;
+
+    // A child index >= 0 is a node, and ~leaf is a leaf.
+    struct Node
+    {
+        Plane plane;
+        int front;
+        int back;
+        unsigned int firstPolygon;
+        unsigned int polygonCount;
+    };
+
+    struct Polygon
+    {
+        Plane plane;
+        unsigned int firstVertex;
+        unsigned int vertexCount;
+        int source;
+    };
+
+    BspTree(const BspTree &);
+    BspTree &operator=(const BspTree &);
+
+    bool buildTree(const Vector3 *vertices, const unsigned int *vertexCounts, unsigned int polygonCount, ThreadPool *pPool);
+    bool intersectNode(int child, const Ray &ray, float tMin, float tMax, float &t, int &polygon) const;
+    void sortNode(int child, const Vector3 &eye, int *polygons, unsigned int maxPolygons, unsigned int &count) const;
+
+    std::vector<Node> m_nodes;
+    std::vector<Polygon> m_polygons;
+    std::vector<Vector3> m_vertices;
+    std::vector<unsigned char> m_solidLeaves;
+    int m_root;
+    unsigned int m_depth;
+    float m_splitWeight;
+};
+
+//-----------------------------------------------------------------------------
+
+#endif
@@ -20,42 +20,234 @@
 // IN THE SOFTWARE.
 //-----------------------------------------------------------------------------
 
+#include <algorithm>
+#include <cfloat>
+
+#if defined(MATHLIB_COLLISION_STATS)
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define COLLISION_STATS_TSC
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define COLLISION_STATS_TSC
+#endif
+#endif
+
 #include "collision.h"
 
+//-----------------------------------------------------------------------------
+// Collision query instrumentation. The macros compile to nothing unless
+// MATHLIB_COLLISION_STATS is defined.
+
+#if defined(MATHLIB_COLLISION_STATS)
+
+enum
+{
+    COUNTER_CALLS            = 0,
+    COUNTER_TICKS            = COUNTER_CALLS + CollisionStats::QUERY_COUNT,
+    COUNTER_PLANE_REJECTIONS = COUNTER_TICKS + CollisionStats::QUERY_COUNT,
+    COUNTER_RAY_BOX_OCTANTS  = COUNTER_PLANE_REJECTIONS + 6,
+    COUNTER_COUNT            = COUNTER_RAY_BOX_OCTANTS + 8
+};
+
+class CollisionCounters
+{
+public:
+    CollisionCounters();
+    ~CollisionCounters();
+
+    void add(int counter, unsigned long long amount)
+    {
+        // Only the owning thread writes to its counters, so a relaxed load
+        // and store is enough. It avoids the cost of an atomic
+        // read-modify-write while still letting snapshot() read the
+        // counters from another thread.
+
+        std::atomic<unsigned long long> &value = m_values[counter];
+        value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    unsigned long long get(int counter) const
+    {
+        return m_values[counter].load(std::memory_order_relaxed);
+    }
+
+    void reset()
+    {
+        for (int i = 0; i < COUNTER_COUNT; ++i)
+            m_values[i].store(0, std::memory_order_relaxed);
+    }
+
+private:
+    CollisionCounters(const CollisionCounters &);
+    CollisionCounters &operator=(const CollisionCounters &);
+
+    std::atomic<unsigned long long> m_values[COUNTER_COUNT];
+};
+
+static unsigned long long readTicks()
+{
+    // The query times are measured with the time stamp counter where there
+    // is one, because reading a std::chrono clock can cost more than the
+    // query being timed. snapshot() converts the ticks to nanoseconds.
+
+#if defined(COLLISION_STATS_TSC)
+    return __rdtsc();
+#else
+    return static_cast<unsigned long long>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+struct CollisionCounterRegistry
+{
+    CollisionCounterRegistry()
+        : startTime(std::chrono::steady_clock::now()), startTicks(readTicks())
+    {
+        for (int i = 0; i < COUNTER_COUNT; ++i)
+            retired[i] = 0;
+    }
+
+    double nanosecondsPerTick() const
+    {
+        // Calibrates the ticks against the steady clock over the whole time
+        // the counters have existed.
+
+#if defined(COLLISION_STATS_TSC)
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - startTime).count();
+        unsigned long long ticks = readTicks() - startTicks;
+
+        return (ticks > 0) ? ns / static_cast<double>(ticks) : 0.0;
+#else
+        return 1.0;
+#endif
+    }
+
+    std::mutex mutex;
+    std::vector<CollisionCounters *> live;
+    unsigned long long retired[COUNTER_COUNT];
+    std::chrono::steady_clock::time_point startTime;
+    unsigned long long startTicks;
+};
+
+static CollisionCounterRegistry &counterRegistry()
+{
+    // Constructed on first use so that it outlives every thread's counters.
+    static CollisionCounterRegistry registry;
+    return registry;
+}
+
+static thread_local CollisionCounters g_threadCounters;
+
+CollisionCounters::CollisionCounters()
+{
+    CollisionCounterRegistry &registry = counterRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+
+    reset();
+    registry.live.push_back(this);
+}
+
+CollisionCounters::~CollisionCounters()
+{
+    // Keep the counts of threads that have exited.
+
+    CollisionCounterRegistry &registry = counterRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+
+    for (int i = 0; i < COUNTER_COUNT; ++i)
+        registry.retired[i] += get(i);
+
+    for (size_t i = 0; i < registry.live.size(); ++i)
+    {
+        if (registry.live[i] == this)
+        {
+            registry.live[i] = registry.live.back();
+            registry.live.pop_back();
+            break;
+        }
+    }
+}
+
+class CollisionQueryTimer
+{
+public:
+    explicit CollisionQueryTimer(CollisionStats::Query query)
+        : m_query(query), m_start(readTicks())
+    {
+    }
+
+    ~CollisionQueryTimer()
+    {
+        g_threadCounters.add(COUNTER_CALLS + m_query, 1);
+        g_threadCounters.add(COUNTER_TICKS + m_query, readTicks() - m_start);
+    }
+
+private:
+    CollisionStats::Query m_query;
+    unsigned long long m_start;
+};
+
+#define COLLISION_STATS_QUERY(query) CollisionQueryTimer collisionQueryTimer(CollisionStats::query)
+#define COLLISION_STATS_PLANE_REJECTION(plane) g_threadCounters.add(COUNTER_PLANE_REJECTIONS + (plane), 1)
+#define COLLISION_STATS_RAY_BOX_OCTANT(octant) g_threadCounters.add(COUNTER_RAY_BOX_OCTANTS + (octant), 1)
+
+#else
+
+#define COLLISION_STATS_QUERY(query)
+#define COLLISION_STATS_PLANE_REJECTION(plane)
+#define COLLISION_STATS_RAY_BOX_OCTANT(octant)
+
+#endif
+
 //-----------------------------------------------------------------------------
 // BoundingBox.
 
-BoundingBox::BoundingBox()
+template <typename T>
+BoundingBoxT<T>::BoundingBoxT()
 {
-    min.set(0.0f, 0.0f, 0.0f);
-    max.set(0.0f, 0.0f, 0.0f);
+    min.set(T(0), T(0), T(0));
+    max.set(T(0), T(0), T(0));
 }
 
-BoundingBox::BoundingBox(const Vector3 &min_, const Vector3 &max_)
+template <typename T>
+BoundingBoxT<T>::BoundingBoxT(const Vector3T<T> &min_, const Vector3T<T> &max_)
 {
     min = min_;
     max = max_;
 }
 
-BoundingBox::~BoundingBox()
+template <typename T>
+BoundingBoxT<T>::~BoundingBoxT()
 {
 }
 
-Vector3 BoundingBox::getCenter() const
+template <typename T>
+Vector3T<T> BoundingBoxT<T>::getCenter() const
 {
-    return (min + max) * 0.5f;
+    return (min + max) * T(0.5);
 }
 
-float BoundingBox::getRadius() const
+template <typename T>
+T BoundingBoxT<T>::getRadius() const
 {
-    return getSize() * 0.5f;
+    return getSize() * T(0.5);
 }
 
-float BoundingBox::getSize() const
+template <typename T>
+T BoundingBoxT<T>::getSize() const
 {
     return (max - min).magnitude();
 }
 
+template class BoundingBoxT<float>;
+template class BoundingBoxT<double>;
+
 //-----------------------------------------------------------------------------
 // BoundingSphere.
 
@@ -102,29 +294,78 @@ BoundingVolume::~BoundingVolume()
 // The plane's normal (a, b, c) in stored in a Vector3 so that functionality
 // from the Vector3 class can be used.
 
-Plane::Plane() : n{}, d{}
+template <typename T>
+PlaneT<T>::PlaneT() : n{}, d{}
 {
 }
 
-Plane::Plane(float a_, float b_, float c_, float d_) : n(a_, b_, c_), d(d_)
+template <typename T>
+PlaneT<T>::PlaneT(T a_, T b_, T c_, T d_) : n(a_, b_, c_), d(d_)
 {
 }
 
-Plane::Plane(const Vector3 &pt, const Vector3 &normal)
+template <typename T>
+PlaneT<T>::PlaneT(const Vector3T<T> &pt, const Vector3T<T> &normal)
 {
     fromPointNormal(pt, normal);
 }
 
-Plane::Plane(const Vector3 &pt1, const Vector3 &pt2, const Vector3 &pt3)
+template <typename T>
+PlaneT<T>::PlaneT(const Vector3T<T> &pt1, const Vector3T<T> &pt2, const Vector3T<T> &pt3)
 {
     fromPoints(pt1, pt2, pt3);
 }
 
-Plane::~Plane()
+template <typename T>
+PlaneT<T>::~PlaneT()
+{
+}
+
+template <typename T>
+unsigned int PlaneT<T>::clipPolygon(const PlaneT<T> &p, const Vector3T<T> *polygon, unsigned int count, Vector3T<T> *result)
 {
+    // Walks the edges (prev, curr), keeping the vertices in front of the
+    // plane and adding the crossing point of every edge that crosses it.
+    // The distances are evaluated a block of vertices at a time with the
+    // array version of dot().
+
+    const unsigned int BLOCK_SIZE = 16;
+    T dist[BLOCK_SIZE];
+    unsigned int n = 0;
+
+    if (count == 0)
+        return 0;
+
+    const Vector3T<T> *prev = &polygon[count - 1];
+    T prevDist = dot(p, *prev);
+
+    for (unsigned int first = 0; first < count; first += BLOCK_SIZE)
+    {
+        unsigned int block = (count - first < BLOCK_SIZE) ? count - first : BLOCK_SIZE;
+
+        dot(p, polygon + first, dist, block);
+
+        for (unsigned int i = 0; i < block; ++i)
+        {
+            const Vector3T<T> *curr = &polygon[first + i];
+            T currDist = dist[i];
+
+            if ((currDist >= T(0)) != (prevDist >= T(0)))
+                result[n++] = *prev + (*curr - *prev) * (prevDist / (prevDist - currDist));
+
+            if (currDist >= T(0))
+                result[n++] = *curr;
+
+            prev = curr;
+            prevDist = currDist;
+        }
+    }
+
+    return n;
 }
 
-float Plane::dot(const Plane &p, const Vector3 &pt)
+template <typename T>
+T PlaneT<T>::dot(const PlaneT<T> &p, const Vector3T<T> &pt)
 {
     // Returns:
     //  > 0 if the point 'pt' lies in front of the plane 'p'
@@ -133,59 +374,405 @@ float Plane::dot(const Plane &p, const Vector3 &pt)
     //
     // The signed distance from the point 'pt' to the plane 'p' is returned.
 
-    return Vector3::dot(p.n, pt) + p.d;
+    return Vector3T<T>::dot(p.n, pt) + p.d;
+}
+
+template <typename T>
+void PlaneT<T>::dot(const PlaneT<T> &p, const Vector3T<T> *points, T *distances, unsigned int count)
+{
+    for (unsigned int i = 0; i < count; ++i)
+        distances[i] = Vector3T<T>::dot(p.n, points[i]) + p.d;
+}
+
+template <>
+void PlaneT<float>::dot(const PlaneT<float> &p, const Vector3 *points, float *distances, unsigned int count)
+{
+    // Works on 4 points (12 floats) at a time, shuffled into vectors of x,
+    // y and z, in the same order of operations as the scalar dot().
+
+    unsigned int i = 0;
+
+#if defined(MATHLIB_SSE)
+    __m128 a = _mm_set1_ps(p.n.x);
+    __m128 b = _mm_set1_ps(p.n.y);
+    __m128 c = _mm_set1_ps(p.n.z);
+    __m128 d = _mm_set1_ps(p.d);
+
+    for (; i + 4 <= count; i += 4)
+    {
+        const float *f = &points[i].x;
+        __m128 v0 = _mm_loadu_ps(f + 0);    // x0 y0 z0 x1
+        __m128 v1 = _mm_loadu_ps(f + 4);    // y1 z1 x2 y2
+        __m128 v2 = _mm_loadu_ps(f + 8);    // z2 x3 y3 z3
+        __m128 t0 = _mm_shuffle_ps(v1, v2, _MM_SHUFFLE(1, 1, 2, 2));
+        __m128 t1 = _mm_shuffle_ps(v0, v1, _MM_SHUFFLE(0, 0, 1, 1));
+        __m128 t2 = _mm_shuffle_ps(v1, v2, _MM_SHUFFLE(2, 2, 3, 3));
+        __m128 t3 = _mm_shuffle_ps(v0, v1, _MM_SHUFFLE(1, 1, 2, 2));
+        __m128 t4 = _mm_shuffle_ps(v2, v2, _MM_SHUFFLE(3, 3, 0, 0));
+        __m128 x = _mm_shuffle_ps(v0, t0, _MM_SHUFFLE(2, 0, 3, 0));
+        __m128 y = _mm_shuffle_ps(t1, t2, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 z = _mm_shuffle_ps(t3, t4, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 dist = _mm_add_ps(_mm_mul_ps(x, a), _mm_mul_ps(y, b));
+
+        dist = _mm_add_ps(_mm_add_ps(dist, _mm_mul_ps(z, c)), d);
+        _mm_storeu_ps(distances + i, dist);
+    }
+#endif
+
+    for (; i < count; ++i)
+        distances[i] = Vector3::dot(p.n, points[i]) + p.d;
 }
 
-bool Plane::operator==(const Plane &rhs) const
+template <typename T>
+bool PlaneT<T>::operator==(const PlaneT<T> &rhs) const
 {
-    return (n == rhs.n) && Math::closeEnough(d, rhs.d);
+    return (n == rhs.n) && ScalarMath<T>::closeEnough(d, rhs.d);
 }
 
-bool Plane::operator!=(const Plane &rhs) const
+template <typename T>
+bool PlaneT<T>::operator!=(const PlaneT<T> &rhs) const
 {
     return !(*this == rhs);
 }
 
-void Plane::fromPointNormal(const Vector3 &pt, const Vector3 &normal)
+template <typename T>
+void PlaneT<T>::fromPointNormal(const Vector3T<T> &pt, const Vector3T<T> &normal)
 {
-    set(normal.x, normal.y, normal.z, -Vector3::dot(normal, pt));
+    set(normal.x, normal.y, normal.z, -Vector3T<T>::dot(normal, pt));
     normalize();
 }
 
-void Plane::fromPoints(const Vector3 &pt1, const Vector3 &pt2, const Vector3 &pt3)
+template <typename T>
+void PlaneT<T>::fromPoints(const Vector3T<T> &pt1, const Vector3T<T> &pt2, const Vector3T<T> &pt3)
 {
-    n = Vector3::cross(pt2 - pt1, pt3 - pt1);
-    d = -Vector3::dot(n, pt1);
+    n = Vector3T<T>::cross(pt2 - pt1, pt3 - pt1);
+    d = -Vector3T<T>::dot(n, pt1);
     normalize();
 }
 
-const Vector3 &Plane::normal() const
+template <typename T>
+const Vector3T<T> &PlaneT<T>::normal() const
 {
     return n;
 }
 
-Vector3 &Plane::normal()
+template <typename T>
+Vector3T<T> &PlaneT<T>::normal()
 {
     return n;
 }
 
-void Plane::normalize()
+template <typename T>
+void PlaneT<T>::normalize()
 {
-    float length = 1.0f / n.magnitude();
+    T length = T(1) / n.magnitude();
     n *= length;
     d *= length;
 }
 
-void Plane::set(float a_, float b_, float c_, float d_)
+template <typename T>
+void PlaneT<T>::set(T a_, T b_, T c_, T d_)
 {
     n.set(a_, b_, c_);
     d = d_;
 }
 
+template class PlaneT<float>;
+template class PlaneT<double>;
+
+//-----------------------------------------------------------------------------
+// Capsule.
+
+// Segments with a squared length below this are treated as points.
+static const float SEGMENT_EPSILON = 1e-12f;
+
+static float clampUnit(float x)
+{
+    return (x < 0.0f) ? 0.0f : ((x > 1.0f) ? 1.0f : x);
+}
+
+static float pointBoxDistanceSq(const Vector3 &point, const BoundingBox &box)
+{
+    const float *p = &point.x;
+    const float *lo = &box.min.x;
+    const float *hi = &box.max.x;
+    float distanceSq = 0.0f;
+
+    for (int i = 0; i < 3; ++i)
+    {
+        float below = lo[i] - p[i];
+        float above = p[i] - hi[i];
+
+        if (below > 0.0f)
+            distanceSq += below * below;
+        else if (above > 0.0f)
+            distanceSq += above * above;
+    }
+
+    return distanceSq;
+}
+
+Capsule::Capsule() : radius(0.0f)
+{
+}
+
+Capsule::Capsule(const Vector3 &a_, const Vector3 &b_, float radius_) : a(a_), b(b_), radius(radius_)
+{
+}
+
+Capsule::~Capsule()
+{
+}
+
+float Capsule::closestPoints(const Vector3 &p1, const Vector3 &q1, const Vector3 &p2, const Vector3 &q2, float &s, float &t)
+{
+    // References:
+    //  Christer Ericson, "Real-Time Collision Detection", Morgan Kaufmann,
+    //  2005, section 5.1.9.
+    //
+    // The closest points of the two lines are found first. If s is outside
+    // [0, 1] it is clamped, t is found for that s, and if t is then outside
+    // [0, 1] it is clamped and s is found again for that t.
+
+    Vector3 d1(q1 - p1);
+    Vector3 d2(q2 - p2);
+    Vector3 r(p1 - p2);
+    float a = Vector3::dot(d1, d1);
+    float e = Vector3::dot(d2, d2);
+    float f = Vector3::dot(d2, r);
+
+    if (a <= SEGMENT_EPSILON)
+    {
+        s = 0.0f;
+        t = (e <= SEGMENT_EPSILON) ? 0.0f : clampUnit(f / e);
+    }
+    else
+    {
+        float c = Vector3::dot(d1, r);
+
+        if (e <= SEGMENT_EPSILON)
+        {
+            t = 0.0f;
+            s = clampUnit(-c / a);
+        }
+        else
+        {
+            float b = Vector3::dot(d1, d2);
+            float denom = a * e - b * b;
+
+            // Parallel segments have no single pair of closest points, so
+            // any s will do.
+            s = (denom > 0.0f) ? clampUnit((b * f - c * e) / denom) : 0.0f;
+            t = (b * s + f) / e;
+
+            if (t < 0.0f)
+            {
+                t = 0.0f;
+                s = clampUnit(-c / a);
+            }
+            else if (t > 1.0f)
+            {
+                t = 1.0f;
+                s = clampUnit((b - c) / a);
+            }
+        }
+    }
+
+    Vector3 diff(r + d1 * s - d2 * t);
+    return Vector3::dot(diff, diff);
+}
+
+bool Capsule::hasCollided(const BoundingBox &box) const
+{
+    // If the segment doesn't pass through the box, its closest point to the
+    // box is one of its ends or lies opposite one of the box's 12 edges.
+    // Most pairs are rejected first by the capsule's bounding box.
+
+    Vector3 d(b - a);
+    const float *pa = &a.x;
+    const float *pb = &b.x;
+    const float *pd = &d.x;
+    const float *lo = &box.min.x;
+    const float *hi = &box.max.x;
+    float tMin = 0.0f;
+    float tMax = 1.0f;
+
+    for (int i = 0; i < 3; ++i)
+    {
+        if (std::min(pa[i], pb[i]) - radius > hi[i] || std::max(pa[i], pb[i]) + radius < lo[i])
+            return false;
+    }
+
+    for (int i = 0; i < 3 && tMin <= tMax; ++i)
+    {
+        if (pd[i] == 0.0f)
+        {
+            if (pa[i] < lo[i] || pa[i] > hi[i])
+                tMax = -1.0f;
+        }
+        else
+        {
+            float t1 = (lo[i] - pa[i]) / pd[i];
+            float t2 = (hi[i] - pa[i]) / pd[i];
+
+            tMin = std::max(tMin, std::min(t1, t2));
+            tMax = std::min(tMax, std::max(t1, t2));
+        }
+    }
+
+    if (tMin <= tMax)
+        return true;
+
+    float rsq = radius * radius;
+
+    if (pointBoxDistanceSq(a, box) <= rsq || pointBoxDistanceSq(b, box) <= rsq)
+        return true;
+
+    // Edge 'corner' along 'axis' starts at the corner with the max of the
+    // other two axes where bits 0 and 1 of 'corner' are set.
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        int u = (axis + 1) % 3;
+        int v = (axis + 2) % 3;
+
+        for (int corner = 0; corner < 4; ++corner)
+        {
+            float p[3], q[3];
+            float s, t;
+
+            p[axis] = lo[axis];
+            p[u] = (corner & 1) ? hi[u] : lo[u];
+            p[v] = (corner & 2) ? hi[v] : lo[v];
+            q[axis] = hi[axis];
+            q[u] = p[u];
+            q[v] = p[v];
+
+            if (closestPoints(a, b, Vector3(p[0], p[1], p[2]), Vector3(q[0], q[1], q[2]), s, t) <= rsq)
+                return true;
+        }
+    }
+
+    return false;
+}
+
+bool Capsule::hasCollided(const BoundingSphere &sphere) const
+{
+    float s, t;
+    float radii = radius + sphere.radius;
+
+    return closestPoints(a, b, sphere.center, sphere.center, s, t) <= radii * radii;
+}
+
+bool Capsule::hasCollided(const Capsule &other) const
+{
+    float s, t;
+    float radii = radius + other.radius;
+
+    return closestPoints(a, b, other.a, other.b, s, t) <= radii * radii;
+}
+
+bool Capsule::hasCollided(const Plane &plane) const
+{
+    float da = Vector3::dot(plane.n, a) + plane.d;
+    float db = Vector3::dot(plane.n, b) + plane.d;
+
+    return std::min(da, db) <= radius && std::max(da, db) >= -radius;
+}
+
+bool Capsule::pointInCapsule(const Vector3 &point) const
+{
+    float s, t;
+
+    return closestPoints(a, b, point, point, s, t) <= radius * radius;
+}
+
+//-----------------------------------------------------------------------------
+// Cylinder.
+
+Cylinder::Cylinder() : radius(0.0f)
+{
+}
+
+Cylinder::Cylinder(const Vector3 &a_, const Vector3 &b_, float radius_) : a(a_), b(b_), radius(radius_)
+{
+}
+
+Cylinder::~Cylinder()
+{
+}
+
+bool Cylinder::hasCollided(const BoundingSphere &sphere) const
+{
+    // The point of the cylinder closest to the sphere's center is found in
+    // the center's axial and radial coordinates, each clamped to the
+    // cylinder.
+
+    Vector3 axis(b - a);
+    float length = axis.magnitude();
+    Vector3 w(sphere.center - a);
+    float along = Vector3::dot(w, axis) / length;
+    float across = sqrtf(std::max(Vector3::dot(w, w) - along * along, 0.0f));
+    float da = along - std::min(std::max(along, 0.0f), length);
+    float dr = across - std::min(across, radius);
+
+    return da * da + dr * dr <= sphere.radius * sphere.radius;
+}
+
+bool Cylinder::hasCollided(const Plane &plane) const
+{
+    // Along the plane's normal the caps reach radius * sin(angle) past the
+    // axis, where 'angle' is the angle between the normal and the axis.
+
+    Vector3 axis(b - a);
+    float cosine = Vector3::dot(plane.n, axis) / axis.magnitude();
+    float reach = radius * sqrtf(std::max(1.0f - cosine * cosine, 0.0f));
+    float da = Vector3::dot(plane.n, a) + plane.d;
+    float db = Vector3::dot(plane.n, b) + plane.d;
+
+    return std::min(da, db) <= reach && std::max(da, db) >= -reach;
+}
+
+bool Cylinder::pointInCylinder(const Vector3 &point) const
+{
+    Vector3 axis(b - a);
+    Vector3 w(point - a);
+    float lengthSq = Vector3::dot(axis, axis);
+    float along = Vector3::dot(w, axis);
+
+    if (along < 0.0f || along > lengthSq)
+        return false;
+
+    return Vector3::dot(w, w) * lengthSq - along * along <= radius * radius * lengthSq;
+}
+
 //-----------------------------------------------------------------------------
 // Frustum.
 
+Frustum::Frustum()
+{
+}
+
+Frustum::Frustum(const Matrix4 &viewProjMatrix)
+{
+    extractPlanes(viewProjMatrix);
+}
+
+Frustum::Frustum(const Matrix4 &viewMatrix, const Matrix4 &projMatrix)
+{
+    extractPlanes(viewMatrix, projMatrix);
+}
+
+Frustum::Frustum(float fovy, float aspect, float znear, float zfar, const Matrix4 &viewMatrix)
+{
+    fromPerspective(fovy, aspect, znear, zfar, viewMatrix);
+}
+
 void Frustum::extractPlanes(const Matrix4 &viewMatrix, const Matrix4 &projMatrix)
+{
+    extractPlanes(viewMatrix * projMatrix);
+}
+
+void Frustum::extractPlanes(const Matrix4 &m)
 {
     // Extracts the view frustum clipping planes from the combined
     // view-projection matrix in world space. The extracted planes will
@@ -196,7 +783,6 @@ void Frustum::extractPlanes(const Matrix4 &viewMatrix, const Matrix4 &projMatrix
     //  Planes from the World-View-Projection Matrix,"
     //  http://www2.ravensoft.com/users/ggribb/plane%20extraction.pdf
 
-    Matrix4 m(viewMatrix * projMatrix);
     Plane *pPlane = 0;
 
     // Left clipping plane.
@@ -250,8 +836,56 @@ void Frustum::extractPlanes(const Matrix4 &viewMatrix, const Matrix4 &projMatrix
     pPlane->normalize();
 }
 
+void Frustum::fromPerspective(float fovy, float aspect, float znear, float zfar, const Matrix4 &viewMatrix)
+{
+    // Builds the planes in view space, where the camera is at the origin
+    // looking down the -z axis, and then moves them into world space. The
+    // side planes pass through the origin, so only their normals depend on
+    // the field of view: the left plane's normal is (1, 0, -tan(fovx / 2))
+    // normalized, and so on.
+
+    float tanY = tanf(Math::degreesToRadians(fovy) * 0.5f);
+    float tanX = tanY * aspect;
+    float invLenX = 1.0f / sqrtf(1.0f + tanX * tanX);
+    float invLenY = 1.0f / sqrtf(1.0f + tanY * tanY);
+    Frustum viewSpace;
+
+    viewSpace.planes[FRUSTUM_PLANE_LEFT].set(invLenX, 0.0f, -tanX * invLenX, 0.0f);
+    viewSpace.planes[FRUSTUM_PLANE_RIGHT].set(-invLenX, 0.0f, -tanX * invLenX, 0.0f);
+    viewSpace.planes[FRUSTUM_PLANE_BOTTOM].set(0.0f, invLenY, -tanY * invLenY, 0.0f);
+    viewSpace.planes[FRUSTUM_PLANE_TOP].set(0.0f, -invLenY, -tanY * invLenY, 0.0f);
+    viewSpace.planes[FRUSTUM_PLANE_NEAR].set(0.0f, 0.0f, -1.0f, -znear);
+    viewSpace.planes[FRUSTUM_PLANE_FAR].set(0.0f, 0.0f, 1.0f, zfar);
+
+    fromViewSpace(viewSpace, viewMatrix);
+}
+
+void Frustum::fromViewSpace(const Frustum &viewSpaceFrustum, const Matrix4 &viewMatrix)
+{
+    // A world space point p is at p * viewMatrix in view space, so the
+    // view space plane (a, b, c, d) becomes the world space plane
+    // viewMatrix * (a, b, c, d), treating the plane as a column vector.
+    // This assumes the fourth column of 'viewMatrix' is (0, 0, 0, 1).
+
+    const Matrix4 &m = viewMatrix;
+
+    for (int i = 0; i < 6; ++i)
+    {
+        // Copy first, since 'viewSpaceFrustum' may be this frustum.
+        Plane p(viewSpaceFrustum.planes[i]);
+
+        planes[i].set(
+            m[0][0] * p.n.x + m[0][1] * p.n.y + m[0][2] * p.n.z,
+            m[1][0] * p.n.x + m[1][1] * p.n.y + m[1][2] * p.n.z,
+            m[2][0] * p.n.x + m[2][1] * p.n.y + m[2][2] * p.n.z,
+            m[3][0] * p.n.x + m[3][1] * p.n.y + m[3][2] * p.n.z + p.d);
+    }
+}
+
 bool Frustum::boxInFrustum(const BoundingBox &box) const
 {
+    COLLISION_STATS_QUERY(QUERY_FRUSTUM_BOX);
+
     Vector3 c((box.min + box.max) * 0.5f);
     float sizex = box.max.x - box.min.x;
     float sizey = box.max.y - box.min.y;
@@ -295,46 +929,361 @@ bool Frustum::boxInFrustum(const BoundingBox &box) const
         if (Plane::dot(planes[i], corners[7]) > 0.0f)
             continue;
 
+        COLLISION_STATS_PLANE_REJECTION(i);
         return false;
     }
 
     return true;
 }
 
-bool Frustum::pointInFrustum(const Vector3 &point) const
+bool Frustum::capsuleInFrustum(const Capsule &capsule) const
 {
+    // Outside if both ends are more than the radius behind one plane.
+
     for (int i = 0; i < 6; ++i)
     {
-        if (Plane::dot(planes[i], point) <= 0.0f)
+        const Plane &p = planes[i];
+        float da = Vector3::dot(p.n, capsule.a) + p.d;
+        float db = Vector3::dot(p.n, capsule.b) + p.d;
+
+        if (std::max(da, db) <= -capsule.radius)
             return false;
     }
 
     return true;
 }
 
-bool Frustum::sphereInFrustum(const BoundingSphere &sphere) const
+unsigned int Frustum::clipPolygon(const Vector3 *polygon, unsigned int count, Vector3 *result) const
 {
-    for (int i = 0; i < 6; ++i)
+    // Planes 0, 2 and 4 clip into a local buffer, and planes 1, 3 and 5
+    // back into 'result', so the input is never written to.
+
+    if (count < 3 || count > MAX_CLIP_VERTICES - 6)
+        return 0;
+
+    Vector3 scratch[MAX_CLIP_VERTICES];
+    const Vector3 *in = polygon;
+    unsigned int n = count;
+
+    for (int i = 0; i < 6 && n >= 3; ++i)
     {
-        if (Plane::dot(planes[i], sphere.center) <= -sphere.radius)
-            return false;
+        Vector3 *out = (i & 1) ? result : scratch;
+
+        n = Plane::clipPolygon(planes[i], in, n, out);
+        in = out;
     }
 
-    return true;
+    return (n >= 3) ? n : 0;
 }
 
-bool Frustum::volumeInFrustum(const BoundingVolume &volume) const
+bool Frustum::cylinderInFrustum(const Cylinder &cylinder) const
 {
-    if (sphereInFrustum(volume.sphere))
+    // As Cylinder::hasCollided(const Plane &): the rims of the caps reach
+    // radius * sin(angle) in front of the axis ends.
+
+    Vector3 axis(cylinder.b - cylinder.a);
+    float invLength = 1.0f / axis.magnitude();
+
+    for (int i = 0; i < 6; ++i)
     {
-        if (boxInFrustum(volume.box))
-            return true;
+        const Plane &p = planes[i];
+        float cosine = Vector3::dot(p.n, axis) * invLength;
+        float reach = cylinder.radius * sqrtf(std::max(1.0f - cosine * cosine, 0.0f));
+        float da = Vector3::dot(p.n, cylinder.a) + p.d;
+        float db = Vector3::dot(p.n, cylinder.b) + p.d;
+
+        if (std::max(da, db) <= -reach)
+            return false;
     }
 
-    return false;
+    return true;
 }
 
-//-----------------------------------------------------------------------------
+bool Frustum::pointInFrustum(const Vector3 &point) const
+{
+    COLLISION_STATS_QUERY(QUERY_FRUSTUM_POINT);
+
+    for (int i = 0; i < 6; ++i)
+    {
+        if (Plane::dot(planes[i], point) <= 0.0f)
+        {
+            COLLISION_STATS_PLANE_REJECTION(i);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool Frustum::sphereInFrustum(const BoundingSphere &sphere) const
+{
+    COLLISION_STATS_QUERY(QUERY_FRUSTUM_SPHERE);
+
+    for (int i = 0; i < 6; ++i)
+    {
+        if (Plane::dot(planes[i], sphere.center) <= -sphere.radius)
+        {
+            COLLISION_STATS_PLANE_REJECTION(i);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool Frustum::volumeInFrustum(const BoundingVolume &volume) const
+{
+    COLLISION_STATS_QUERY(QUERY_FRUSTUM_VOLUME);
+
+    if (sphereInFrustum(volume.sphere))
+    {
+        if (boxInFrustum(volume.box))
+            return true;
+    }
+
+    return false;
+}
+
+//-----------------------------------------------------------------------------
+// ConvexVolume.
+
+ConvexVolume::ConvexVolume()
+{
+    clear();
+}
+
+ConvexVolume::ConvexVolume(const Frustum &frustum)
+{
+    fromFrustum(frustum);
+}
+
+bool ConvexVolume::addPlane(const Plane &plane)
+{
+    if (m_count == MAX_PLANES)
+        return false;
+
+    setPlane(m_count++, plane.n.x, plane.n.y, plane.n.z, plane.d);
+    return true;
+}
+
+bool ConvexVolume::addPortal(const Vector3 &eye, const Vector3 *portal, unsigned int vertexCount)
+{
+    // The portal's normal is found with Newell's method, which works for
+    // either winding and is robust to nearly collinear vertices. The edge
+    // planes are oriented so that the portal's centroid is in front of
+    // them, and edges too short to define a plane are skipped.
+
+    if (vertexCount < 3 || m_count + vertexCount + 1 > MAX_PLANES)
+        return false;
+
+    Vector3 centroid(0.0f, 0.0f, 0.0f);
+    Vector3 normal(0.0f, 0.0f, 0.0f);
+
+    for (unsigned int i = 0; i < vertexCount; ++i)
+    {
+        const Vector3 &a = portal[i];
+        const Vector3 &b = portal[(i + 1) % vertexCount];
+
+        centroid += a;
+        normal += Vector3::cross(a, b);
+    }
+
+    centroid /= static_cast<float>(vertexCount);
+
+    float length = normal.magnitude();
+
+    if (length <= Math::EPSILON)
+        return false;
+
+    normal /= length;
+
+    // The eye must be clearly on one side of the portal. The plane faces
+    // away from it, so that only what is beyond the portal is inside.
+    float eyeDistance = Vector3::dot(normal, eye - centroid);
+
+    if (fabsf(eyeDistance) <= Math::EPSILON)
+        return false;
+
+    if (eyeDistance > 0.0f)
+        normal = -normal;
+
+    Plane planes[MAX_PLANES];
+    unsigned int count = 0;
+
+    planes[count++] = Plane(centroid, normal);
+
+    for (unsigned int i = 0; i < vertexCount; ++i)
+    {
+        Vector3 n(Vector3::cross(portal[i] - eye, portal[(i + 1) % vertexCount] - eye));
+        float len = n.magnitude();
+
+        if (len <= Math::EPSILON)
+            continue;
+
+        n /= len;
+
+        if (Vector3::dot(n, centroid - eye) < 0.0f)
+            n = -n;
+
+        planes[count++] = Plane(eye, n);
+    }
+
+    for (unsigned int i = 0; i < count; ++i)
+        addPlane(planes[i]);
+
+    return true;
+}
+
+void ConvexVolume::clear()
+{
+    // Every slot holds the plane 0x + 0y + 0z + 1 = 0, which everything is
+    // in front of, so the padding never rejects anything.
+
+    for (unsigned int i = 0; i < MAX_PLANES; ++i)
+        setPlane(i, 0.0f, 0.0f, 0.0f, 1.0f);
+
+    m_count = 0;
+}
+
+void ConvexVolume::fromFrustum(const Frustum &frustum)
+{
+    clear();
+
+    for (int i = 0; i < 6; ++i)
+        addPlane(frustum.planes[i]);
+}
+
+bool ConvexVolume::fromPortal(const Frustum &frustum, const Vector3 &eye, const Vector3 *portal, unsigned int vertexCount)
+{
+    ConvexVolume volume(frustum);
+
+    if (!volume.addPortal(eye, portal, vertexCount))
+        return false;
+
+    *this = volume;
+    return true;
+}
+
+Plane ConvexVolume::plane(unsigned int i) const
+{
+    return Plane(m_planes[0][i], m_planes[1][i], m_planes[2][i], m_planes[3][i]);
+}
+
+unsigned int ConvexVolume::planeCount() const
+{
+    return m_count;
+}
+
+const float *ConvexVolume::planeData() const
+{
+    return &m_planes[0][0];
+}
+
+bool ConvexVolume::boxInVolume(const BoundingBox &box) const
+{
+    // A box is outside if its corner furthest along a plane's normal (the
+    // positive vertex) is behind that plane. The larger of a * min.x and
+    // a * max.x is the x term of the positive vertex.
+
+#if defined(MATHLIB_SSE)
+    __m128 minX = _mm_set1_ps(box.min.x), maxX = _mm_set1_ps(box.max.x);
+    __m128 minY = _mm_set1_ps(box.min.y), maxY = _mm_set1_ps(box.max.y);
+    __m128 minZ = _mm_set1_ps(box.min.z), maxZ = _mm_set1_ps(box.max.z);
+
+    for (unsigned int i = 0; i < m_count; i += 4)
+    {
+        __m128 a = _mm_loadu_ps(&m_planes[0][i]);
+        __m128 b = _mm_loadu_ps(&m_planes[1][i]);
+        __m128 c = _mm_loadu_ps(&m_planes[2][i]);
+        __m128 d = _mm_add_ps(_mm_max_ps(_mm_mul_ps(a, minX), _mm_mul_ps(a, maxX)), _mm_loadu_ps(&m_planes[3][i]));
+
+        d = _mm_add_ps(d, _mm_max_ps(_mm_mul_ps(b, minY), _mm_mul_ps(b, maxY)));
+        d = _mm_add_ps(d, _mm_max_ps(_mm_mul_ps(c, minZ), _mm_mul_ps(c, maxZ)));
+
+        if (_mm_movemask_ps(_mm_cmple_ps(d, _mm_setzero_ps())) != 0)
+            return false;
+    }
+#else
+    for (unsigned int i = 0; i < m_count; ++i)
+    {
+        float a = m_planes[0][i], b = m_planes[1][i], c = m_planes[2][i];
+        float d = std::max(a * box.min.x, a * box.max.x) + m_planes[3][i];
+
+        d += std::max(b * box.min.y, b * box.max.y);
+        d += std::max(c * box.min.z, c * box.max.z);
+
+        if (d <= 0.0f)
+            return false;
+    }
+#endif
+
+    return true;
+}
+
+bool ConvexVolume::pointInVolume(const Vector3 &point) const
+{
+#if defined(MATHLIB_SSE)
+    __m128 x = _mm_set1_ps(point.x), y = _mm_set1_ps(point.y), z = _mm_set1_ps(point.z);
+
+    for (unsigned int i = 0; i < m_count; i += 4)
+    {
+        __m128 d = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&m_planes[0][i]), x), _mm_loadu_ps(&m_planes[3][i]));
+
+        d = _mm_add_ps(d, _mm_mul_ps(_mm_loadu_ps(&m_planes[1][i]), y));
+        d = _mm_add_ps(d, _mm_mul_ps(_mm_loadu_ps(&m_planes[2][i]), z));
+
+        if (_mm_movemask_ps(_mm_cmple_ps(d, _mm_setzero_ps())) != 0)
+            return false;
+    }
+#else
+    for (unsigned int i = 0; i < m_count; ++i)
+    {
+        if (m_planes[0][i] * point.x + m_planes[3][i] + m_planes[1][i] * point.y + m_planes[2][i] * point.z <= 0.0f)
+            return false;
+    }
+#endif
+
+    return true;
+}
+
+bool ConvexVolume::sphereInVolume(const BoundingSphere &sphere) const
+{
+#if defined(MATHLIB_SSE)
+    __m128 x = _mm_set1_ps(sphere.center.x), y = _mm_set1_ps(sphere.center.y), z = _mm_set1_ps(sphere.center.z);
+    __m128 negRadius = _mm_set1_ps(-sphere.radius);
+
+    for (unsigned int i = 0; i < m_count; i += 4)
+    {
+        __m128 d = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&m_planes[0][i]), x), _mm_loadu_ps(&m_planes[3][i]));
+
+        d = _mm_add_ps(d, _mm_mul_ps(_mm_loadu_ps(&m_planes[1][i]), y));
+        d = _mm_add_ps(d, _mm_mul_ps(_mm_loadu_ps(&m_planes[2][i]), z));
+
+        if (_mm_movemask_ps(_mm_cmple_ps(d, negRadius)) != 0)
+            return false;
+    }
+#else
+    for (unsigned int i = 0; i < m_count; ++i)
+    {
+        const Vector3 &c = sphere.center;
+
+        if (m_planes[0][i] * c.x + m_planes[3][i] + m_planes[1][i] * c.y + m_planes[2][i] * c.z <= -sphere.radius)
+            return false;
+    }
+#endif
+
+    return true;
+}
+
+void ConvexVolume::setPlane(unsigned int i, float a, float b, float c, float d)
+{
+    m_planes[0][i] = a;
+    m_planes[1][i] = b;
+    m_planes[2][i] = c;
+    m_planes[3][i] = d;
+}
+
+//-----------------------------------------------------------------------------
 // Ray.
 
 Ray::Ray()
@@ -353,6 +1302,8 @@ Ray::~Ray()
 
 bool Ray::hasIntersected(const BoundingSphere &sphere) const
 {
+    COLLISION_STATS_QUERY(QUERY_RAY_SPHERE);
+
     Vector3 w(sphere.center - origin);
     float wsq = Vector3::dot(w, w);
     float proj = Vector3::dot(w, direction);
@@ -375,6 +1326,10 @@ bool Ray::hasIntersected(const BoundingBox &box) const
     //  Overlap Tests with Plcker Coordinates", Journal of Graphics Tools,
     //  9(1):35-46.
 
+    COLLISION_STATS_QUERY(QUERY_RAY_BOX);
+    COLLISION_STATS_RAY_BOX_OCTANT(((direction.x < 0.0f) ? 0 : 4)
+        + ((direction.y < 0.0f) ? 0 : 2) + ((direction.z < 0.0f) ? 0 : 1));
+
     if (direction.x < 0.0f)
 	{
 		if (direction.y < 0.0f)
@@ -591,6 +1546,8 @@ bool Ray::hasIntersected(const BoundingBox &box) const
 
 bool Ray::hasIntersected(const BoundingVolume &volume) const
 {
+    COLLISION_STATS_QUERY(QUERY_RAY_VOLUME);
+
     if (hasIntersected(volume.sphere))
     {
         if (hasIntersected(volume.box))
@@ -600,6 +1557,145 @@ bool Ray::hasIntersected(const BoundingVolume &volume) const
     return false;
 }
 
+bool Ray::hasIntersected(const Capsule &capsule) const
+{
+    float t;
+
+    return hasIntersected(capsule, t);
+}
+
+bool Ray::hasIntersected(const Capsule &capsule, float &t) const
+{
+    // The capsule is the union of a cylinder without caps and the spheres
+    // at its ends, so the first point hit is the nearest of the first
+    // points hit on each of them.
+
+    Vector3 axis(capsule.b - capsule.a);
+    Vector3 m(origin - capsule.a);
+    float rsq = capsule.radius * capsule.radius;
+    float s, u;
+
+    if (Capsule::closestPoints(capsule.a, capsule.b, origin, origin, s, u) <= rsq)
+    {
+        t = 0.0f;
+        return true;
+    }
+
+    float dd = Vector3::dot(direction, direction);
+    float best = -1.0f;
+
+    // The cylinder: the quadratic in t for the squared distance from the
+    // axis, scaled by the axis' squared length to avoid divisions.
+    float aa = Vector3::dot(axis, axis);
+    float md = Vector3::dot(m, axis);
+    float nd = Vector3::dot(direction, axis);
+    float qa = aa * dd - nd * nd;
+
+    if (aa > SEGMENT_EPSILON && qa > 0.0f)
+    {
+        float qb = aa * Vector3::dot(m, direction) - md * nd;
+        float qc = aa * (Vector3::dot(m, m) - rsq) - md * md;
+        float disc = qb * qb - qa * qc;
+
+        if (disc >= 0.0f)
+        {
+            float tc = (-qb - sqrtf(disc)) / qa;
+            float along = md + tc * nd;
+
+            if (tc >= 0.0f && along >= 0.0f && along <= aa)
+                best = tc;
+        }
+    }
+
+    for (int i = 0; i < 2; ++i)
+    {
+        Vector3 w(origin - ((i == 0) ? capsule.a : capsule.b));
+        float wd = Vector3::dot(w, direction);
+        float disc = wd * wd - dd * (Vector3::dot(w, w) - rsq);
+
+        if (disc >= 0.0f)
+        {
+            float tc = (-wd - sqrtf(disc)) / dd;
+
+            if (tc >= 0.0f && (best < 0.0f || tc < best))
+                best = tc;
+        }
+    }
+
+    if (best < 0.0f)
+        return false;
+
+    t = best;
+    return true;
+}
+
+bool Ray::hasIntersected(const Cylinder &cylinder) const
+{
+    float t;
+
+    return hasIntersected(cylinder, t);
+}
+
+bool Ray::hasIntersected(const Cylinder &cylinder, float &t) const
+{
+    // The nearest of the first point hit on the side and the points hit
+    // on the two caps.
+
+    Vector3 axis(cylinder.b - cylinder.a);
+    Vector3 m(origin - cylinder.a);
+    float rsq = cylinder.radius * cylinder.radius;
+    float aa = Vector3::dot(axis, axis);
+    float md = Vector3::dot(m, axis);
+    float nd = Vector3::dot(direction, axis);
+    float mm = Vector3::dot(m, m);
+
+    if (md >= 0.0f && md <= aa && mm * aa - md * md <= rsq * aa)
+    {
+        t = 0.0f;
+        return true;
+    }
+
+    float dd = Vector3::dot(direction, direction);
+    float qa = aa * dd - nd * nd;
+    float best = -1.0f;
+
+    if (qa > 0.0f)
+    {
+        float qb = aa * Vector3::dot(m, direction) - md * nd;
+        float qc = aa * (mm - rsq) - md * md;
+        float disc = qb * qb - qa * qc;
+
+        if (disc >= 0.0f)
+        {
+            float tc = (-qb - sqrtf(disc)) / qa;
+            float along = md + tc * nd;
+
+            if (tc >= 0.0f && along >= 0.0f && along <= aa)
+                best = tc;
+        }
+    }
+
+    if (nd != 0.0f)
+    {
+        for (int i = 0; i < 2; ++i)
+        {
+            // The cap planes are where the distance along the axis, md +
+            // t * nd, is 0 and aa.
+            float tc = (((i == 0) ? 0.0f : aa) - md) / nd;
+            Vector3 w(m + direction * tc - ((i == 0) ? Vector3(0.0f, 0.0f, 0.0f) : axis));
+
+            if (tc >= 0.0f && Vector3::dot(w, w) <= rsq && (best < 0.0f || tc < best))
+                best = tc;
+        }
+    }
+
+    if (best < 0.0f)
+        return false;
+
+    t = best;
+    return true;
+}
+
 bool Ray::hasIntersected(const Plane &plane) const
 {
     float t;
@@ -610,6 +1706,8 @@ bool Ray::hasIntersected(const Plane &plane) const
 
 bool Ray::hasIntersected(const Plane &plane, float &t, Vector3 &intersection) const
 {
+    COLLISION_STATS_QUERY(QUERY_RAY_PLANE);
+
     float denominator = Vector3::dot(direction, plane.n);
 
     // Early out: if ray is parallel to the plane then no intersection.
@@ -639,4 +1737,652 @@ bool Ray::hasIntersected(const Plane &plane, float &t, Vector3 &intersection) co
     
     intersection = origin + (direction * t);
     return true;
+}
+
+//-----------------------------------------------------------------------------
+// Sweep.
+
+static Vector3 closestPointOnTriangle(const Vector3 &p, const Vector3 &a, const Vector3 &b, const Vector3 &c)
+{
+    // References:
+    //  Christer Ericson, "Real-Time Collision Detection", Morgan Kaufmann,
+    //  2005, section 5.1.5.
+    //
+    // Finds which of the triangle's vertex, edge and face regions the point
+    // is in, from its barycentric coordinates.
+
+    Vector3 ab(b - a);
+    Vector3 ac(c - a);
+    Vector3 ap(p - a);
+    float d1 = Vector3::dot(ab, ap);
+    float d2 = Vector3::dot(ac, ap);
+
+    if (d1 <= 0.0f && d2 <= 0.0f)
+        return a;
+
+    Vector3 bp(p - b);
+    float d3 = Vector3::dot(ab, bp);
+    float d4 = Vector3::dot(ac, bp);
+
+    if (d3 >= 0.0f && d4 <= d3)
+        return b;
+
+    float vc = d1 * d4 - d3 * d2;
+
+    if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+        return a + ab * (d1 / (d1 - d3));
+
+    Vector3 cp(p - c);
+    float d5 = Vector3::dot(ab, cp);
+    float d6 = Vector3::dot(ac, cp);
+
+    if (d6 >= 0.0f && d5 <= d6)
+        return c;
+
+    float vb = d5 * d2 - d1 * d6;
+
+    if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+        return a + ac * (d2 / (d2 - d6));
+
+    float va = d3 * d6 - d5 * d4;
+
+    if (va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f)
+        return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+    float denom = 1.0f / (va + vb + vc);
+    return a + ab * (vb * denom) + ac * (vc * denom);
+}
+
+static Vector3 unitOr(const Vector3 &v, const Vector3 &fallback)
+{
+    float length = v.magnitude();
+    return (length > 0.0f) ? v / length : fallback;
+}
+
+static bool searchContact(const Sweep::DistanceFunction &distance, float tolerance, float time, float &t, Vector3 &normal)
+{
+    // Finds the first time in [time, 1] at which the distance is within
+    // 'tolerance', given that it isn't at 'time'. A golden section search
+    // looks for the closest approach, assuming the distance has a single
+    // minimum in the interval, and stops early at any time within the
+    // tolerance. If there is one, bisection between 'time' and it finds
+    // where the distance first drops to the tolerance.
+
+    const float GOLDEN = 0.618034f;
+    float lo = time;
+    float hi = 1.0f;
+    float x1 = hi - GOLDEN * (hi - lo);
+    float x2 = lo + GOLDEN * (hi - lo);
+    Vector3 n;
+    float d1 = distance(x1, n);
+    float d2 = distance(x2, n);
+    float contact = -1.0f;
+
+    if (d1 <= tolerance)
+        contact = x1;
+    else if (d2 <= tolerance)
+        contact = x2;
+
+    for (int i = 0; i < 40 && contact < 0.0f && hi - lo > 1e-7f; ++i)
+    {
+        if (d1 < d2)
+        {
+            hi = x2, x2 = x1, d2 = d1;
+            x1 = hi - GOLDEN * (hi - lo);
+            d1 = distance(x1, n);
+
+            if (d1 <= tolerance)
+                contact = x1;
+        }
+        else
+        {
+            lo = x1, x1 = x2, d1 = d2;
+            x2 = lo + GOLDEN * (hi - lo);
+            d2 = distance(x2, n);
+
+            if (d2 <= tolerance)
+                contact = x2;
+        }
+    }
+
+    if (contact < 0.0f)
+        return false;
+
+    lo = time;
+    hi = contact;
+
+    for (int i = 0; i < 24; ++i)
+    {
+        float mid = 0.5f * (lo + hi);
+
+        if (distance(mid, n) <= tolerance)
+            hi = mid;
+        else
+            lo = mid;
+    }
+
+    distance(hi, n);
+    t = hi;
+    normal = n;
+    return true;
+}
+
+bool Sweep::advance(const DistanceFunction &distance, float maxSpeed, float tolerance, float &t, Vector3 &normal)
+{
+    float time = 0.0f;
+    Vector3 n;
+
+    for (unsigned int step = 0; ; ++step)
+    {
+        float d = distance(time, n);
+
+        if (d <= tolerance)
+            break;
+
+        if (maxSpeed <= 0.0f)
+            return false;
+
+        // Grazing shapes converge slowly. Whether they touch at all is
+        // left to a search of the rest of the step.
+        if (step + 1 == MAX_ADVANCE_STEPS)
+            return searchContact(distance, tolerance, time, t, normal);
+
+        time += d / maxSpeed;
+
+        if (time > 1.0f)
+            return false;
+    }
+
+    t = time;
+    normal = n;
+    return true;
+}
+
+Vector3 Sweep::contactNormal(const BoundingBox &box, const BoundingBox &other)
+{
+    const float *lo = &box.min.x;
+    const float *hi = &box.max.x;
+    const float *otherLo = &other.min.x;
+    const float *otherHi = &other.max.x;
+    float least = 0.0f;
+    int axis = -1;
+
+    for (int i = 0; i < 3; ++i)
+    {
+        float overlap = std::min(hi[i], otherHi[i]) - std::max(lo[i], otherLo[i]);
+
+        if (axis < 0 || overlap < least)
+        {
+            least = overlap;
+            axis = i;
+        }
+    }
+
+    Vector3 normal(0.0f, 0.0f, 0.0f);
+    (&normal.x)[axis] = (lo[axis] + hi[axis] >= otherLo[axis] + otherHi[axis]) ? 1.0f : -1.0f;
+    return normal;
+}
+
+Vector3 Sweep::contactNormal(const BoundingSphere &sphere, const BoundingBox &box)
+{
+    if (pointBoxDistanceSq(sphere.center, box) > 0.0f)
+    {
+        Vector3 closest(std::min(std::max(sphere.center.x, box.min.x), box.max.x),
+            std::min(std::max(sphere.center.y, box.min.y), box.max.y),
+            std::min(std::max(sphere.center.z, box.min.z), box.max.z));
+
+        return unitOr(sphere.center - closest, Vector3(0.0f, 1.0f, 0.0f));
+    }
+
+    // The center is inside: out through the nearest face.
+    const float *c = &sphere.center.x;
+    const float *lo = &box.min.x;
+    const float *hi = &box.max.x;
+    Vector3 normal(0.0f, 0.0f, 0.0f);
+    float least = 0.0f;
+    int axis = -1;
+
+    for (int i = 0; i < 3; ++i)
+    {
+        if (axis < 0 || c[i] - lo[i] < least)
+            least = c[i] - lo[i], axis = i;
+
+        if (hi[i] - c[i] < least)
+            least = hi[i] - c[i], axis = i + 3;
+    }
+
+    (&normal.x)[axis % 3] = (axis < 3) ? -1.0f : 1.0f;
+    return normal;
+}
+
+Vector3 Sweep::contactNormal(const BoundingSphere &sphere, const BoundingSphere &other)
+{
+    return unitOr(sphere.center - other.center, Vector3(0.0f, 1.0f, 0.0f));
+}
+
+Vector3 Sweep::contactNormal(const BoundingSphere &sphere, const Plane &plane)
+{
+    return (Plane::dot(plane, sphere.center) >= 0.0f) ? plane.n : -plane.n;
+}
+
+Vector3 Sweep::contactNormal(const BoundingSphere &sphere, const Vector3 *triangle)
+{
+    Vector3 closest(closestPointOnTriangle(sphere.center, triangle[0], triangle[1], triangle[2]));
+    Vector3 face(Vector3::cross(triangle[1] - triangle[0], triangle[2] - triangle[0]));
+
+    return unitOr(sphere.center - closest, unitOr(face, Vector3(0.0f, 1.0f, 0.0f)));
+}
+
+bool Sweep::timeOfImpact(const BoundingBox &box, const Vector3 &velocity, const BoundingBox &other, float &t, Vector3 &normal)
+{
+    // The slab test of Ray::hasIntersected(const BoundingBox &) on the
+    // intervals of time during which the boxes overlap on each axis.
+
+    const float *lo = &box.min.x;
+    const float *hi = &box.max.x;
+    const float *otherLo = &other.min.x;
+    const float *otherHi = &other.max.x;
+    const float *v = &velocity.x;
+    float enter = -FLT_MAX;
+    float exit = FLT_MAX;
+    int axis = 0;
+
+    for (int i = 0; i < 3; ++i)
+    {
+        if (v[i] == 0.0f)
+        {
+            if (hi[i] < otherLo[i] || lo[i] > otherHi[i])
+                return false;
+
+            continue;
+        }
+
+        float t1 = (otherLo[i] - hi[i]) / v[i];
+        float t2 = (otherHi[i] - lo[i]) / v[i];
+
+        if (std::min(t1, t2) > enter)
+        {
+            enter = std::min(t1, t2);
+            axis = i;
+        }
+
+        exit = std::min(exit, std::max(t1, t2));
+    }
+
+    if (enter > exit || enter > 1.0f || exit < 0.0f)
+        return false;
+
+    if (enter > 0.0f)
+    {
+        t = enter;
+        normal = Vector3(0.0f, 0.0f, 0.0f);
+        (&normal.x)[axis] = (v[axis] > 0.0f) ? -1.0f : 1.0f;
+    }
+    else
+    {
+        t = 0.0f;
+        normal = contactNormal(box, other);
+    }
+
+    return true;
+}
+
+bool Sweep::timeOfImpact(const BoundingSphere &sphere, const Vector3 &velocity, const BoundingBox &box, float &t, Vector3 &normal)
+{
+    // References:
+    //  Christer Ericson, "Real-Time Collision Detection", Morgan Kaufmann,
+    //  2005, section 5.5.7.
+    //
+    // The sphere's center first touches the box grown by the radius. Where
+    // that point is beyond two or three faces of the box the grown box is
+    // rounded: there it is the capsule of the nearest edge, or of one of
+    // the three edges at the nearest corner.
+
+    float r = sphere.radius;
+
+    if (pointBoxDistanceSq(sphere.center, box) <= r * r)
+    {
+        t = 0.0f;
+        normal = contactNormal(sphere, box);
+        return true;
+    }
+
+    const float *c = &sphere.center.x;
+    const float *v = &velocity.x;
+    const float *lo = &box.min.x;
+    const float *hi = &box.max.x;
+    float enter = -FLT_MAX;
+    float exit = FLT_MAX;
+
+    for (int i = 0; i < 3; ++i)
+    {
+        if (v[i] == 0.0f)
+        {
+            if (c[i] < lo[i] - r || c[i] > hi[i] + r)
+                return false;
+
+            continue;
+        }
+
+        float t1 = (lo[i] - r - c[i]) / v[i];
+        float t2 = (hi[i] + r - c[i]) / v[i];
+
+        enter = std::max(enter, std::min(t1, t2));
+        exit = std::min(exit, std::max(t1, t2));
+    }
+
+    if (enter > exit || enter > 1.0f || exit < 0.0f)
+        return false;
+
+    float time = std::max(enter, 0.0f);
+    float corner[3];
+    int outside = 0;
+    int edge = 0;
+
+    for (int i = 0; i < 3; ++i)
+    {
+        float p = c[i] + v[i] * time;
+
+        if (p < lo[i])
+            corner[i] = lo[i], ++outside;
+        else if (p > hi[i])
+            corner[i] = hi[i], ++outside;
+        else
+            corner[i] = lo[i], edge = i;
+    }
+
+    if (outside >= 2)
+    {
+        Ray ray(sphere.center, velocity);
+        float best = FLT_MAX;
+
+        for (int i = 0; i < 3; ++i)
+        {
+            if (outside == 2 && i != edge)
+                continue;
+
+            float a[3] = { corner[0], corner[1], corner[2] };
+            float b[3] = { corner[0], corner[1], corner[2] };
+            float tc;
+
+            a[i] = lo[i];
+            b[i] = hi[i];
+
+            if (ray.hasIntersected(Capsule(Vector3(a[0], a[1], a[2]), Vector3(b[0], b[1], b[2]), r), tc))
+                best = std::min(best, tc);
+        }
+
+        if (best > 1.0f)
+            return false;
+
+        time = best;
+    }
+
+    t = time;
+    normal = contactNormal(BoundingSphere(sphere.center + velocity * time, r), box);
+    return true;
+}
+
+bool Sweep::timeOfImpact(const BoundingSphere &sphere, const Vector3 &velocity, const BoundingSphere &other, float &t, Vector3 &normal)
+{
+    // The first root of |s + velocity * t| = radii, s being the offset
+    // between the centers, written so that it doesn't divide by the
+    // velocity.
+
+    Vector3 s(sphere.center - other.center);
+    float radii = sphere.radius + other.radius;
+    float c = Vector3::dot(s, s) - radii * radii;
+
+    if (c <= 0.0f)
+    {
+        t = 0.0f;
+        normal = contactNormal(sphere, other);
+        return true;
+    }
+
+    float b = Vector3::dot(s, velocity);
+    float disc = b * b - Vector3::dot(velocity, velocity) * c;
+
+    if (b >= 0.0f || disc < 0.0f)
+        return false;
+
+    float time = c / (sqrtf(disc) - b);
+
+    if (time > 1.0f)
+        return false;
+
+    t = time;
+    normal = contactNormal(BoundingSphere(sphere.center + velocity * time, sphere.radius), other);
+    return true;
+}
+
+bool Sweep::timeOfImpact(const BoundingSphere &sphere, const Vector3 &velocity, const Plane &plane, float &t, Vector3 &normal)
+{
+    // The sphere touches the plane when its center is 'radius' from it, on
+    // the side it starts on.
+
+    float d = Plane::dot(plane, sphere.center);
+    float speed = Vector3::dot(plane.n, velocity);
+
+    if (fabsf(d) > sphere.radius)
+    {
+        if (d * speed >= 0.0f)
+            return false;
+
+        float time = (fabsf(d) - sphere.radius) / fabsf(speed);
+
+        if (time > 1.0f)
+            return false;
+
+        t = time;
+    }
+    else
+    {
+        t = 0.0f;
+    }
+
+    normal = (d >= 0.0f) ? plane.n : -plane.n;
+    return true;
+}
+
+bool Sweep::timeOfImpact(const BoundingSphere &sphere, const Vector3 &velocity, const Vector3 *triangle, float &t, Vector3 &normal)
+{
+    // References:
+    //  Christer Ericson, "Real-Time Collision Detection", Morgan Kaufmann,
+    //  2005, section 5.5.6.
+    //
+    // If the point where the sphere first touches the triangle's plane is
+    // inside the triangle, that's the contact. Otherwise the sphere hits an
+    // edge or a vertex first, i.e., its center hits the capsule of radius
+    // 'radius' around one of the edges.
+
+    const Vector3 &a = triangle[0];
+    const Vector3 &b = triangle[1];
+    const Vector3 &c = triangle[2];
+    float r = sphere.radius;
+    Vector3 closest(closestPointOnTriangle(sphere.center, a, b, c));
+
+    if (Vector3::dot(sphere.center - closest, sphere.center - closest) <= r * r)
+    {
+        t = 0.0f;
+        normal = contactNormal(sphere, triangle);
+        return true;
+    }
+
+    Vector3 face(Vector3::cross(b - a, c - a));
+    Vector3 n(unitOr(face, Vector3(0.0f, 1.0f, 0.0f)));
+    float d = Vector3::dot(n, sphere.center - a);
+    float speed = Vector3::dot(n, velocity);
+
+    if (fabsf(d) > r)
+    {
+        if (d * speed >= 0.0f)
+            return false;
+
+        // The sphere can't touch the triangle before it touches the plane.
+        float time = (fabsf(d) - r) / fabsf(speed);
+
+        if (time > 1.0f)
+            return false;
+
+        Vector3 side((d > 0.0f) ? n : -n);
+        Vector3 p(sphere.center + velocity * time - side * r);
+
+        if (Vector3::dot(Vector3::cross(b - a, p - a), face) >= 0.0f
+            && Vector3::dot(Vector3::cross(c - b, p - b), face) >= 0.0f
+            && Vector3::dot(Vector3::cross(a - c, p - c), face) >= 0.0f)
+        {
+            t = time;
+            normal = side;
+            return true;
+        }
+    }
+
+    Ray ray(sphere.center, velocity);
+    float best = FLT_MAX;
+
+    for (int i = 0; i < 3; ++i)
+    {
+        float tc;
+
+        if (ray.hasIntersected(Capsule(triangle[i], triangle[(i + 1) % 3], r), tc))
+            best = std::min(best, tc);
+    }
+
+    if (best > 1.0f)
+        return false;
+
+    t = best;
+    normal = contactNormal(BoundingSphere(sphere.center + velocity * best, r), triangle);
+    return true;
+}
+
+bool Sweep::timeOfImpact(const Capsule &capsule, const Vector3 &velocity, const Capsule &other, float &t, Vector3 &normal)
+{
+    // Conservative advancement on the distance between the segments. The
+    // distance can shrink no faster than the speed.
+
+    float radii = capsule.radius + other.radius;
+    float speed = velocity.magnitude();
+
+    DistanceFunction distance = [&](float time, Vector3 &n) -> float
+    {
+        Vector3 a(capsule.a + velocity * time);
+        Vector3 b(capsule.b + velocity * time);
+        float s, u;
+        float distanceSq = Capsule::closestPoints(a, b, other.a, other.b, s, u);
+        Vector3 w((a + (b - a) * s) - (other.a + (other.b - other.a) * u));
+
+        n = unitOr(w, unitOr(-velocity, Vector3(0.0f, 1.0f, 0.0f)));
+        return sqrtf(distanceSq) - radii;
+    };
+
+    return advance(distance, speed, 1e-4f * std::max(radii, speed), t, normal);
+}
+
+//-----------------------------------------------------------------------------
+// CollisionStats.
+
+CollisionStats::CollisionStats()
+{
+    for (int i = 0; i < QUERY_COUNT; ++i)
+        calls[i] = nanoseconds[i] = 0;
+
+    for (int i = 0; i < 6; ++i)
+        planeRejections[i] = 0;
+
+    for (int i = 0; i < 8; ++i)
+        rayBoxOctants[i] = 0;
+}
+
+bool CollisionStats::enabled()
+{
+#if defined(MATHLIB_COLLISION_STATS)
+    return true;
+#else
+    return false;
+#endif
+}
+
+const char *CollisionStats::queryName(Query query)
+{
+    switch (query)
+    {
+    case QUERY_FRUSTUM_BOX:
+        return "Frustum::boxInFrustum";
+
+    case QUERY_FRUSTUM_POINT:
+        return "Frustum::pointInFrustum";
+
+    case QUERY_FRUSTUM_SPHERE:
+        return "Frustum::sphereInFrustum";
+
+    case QUERY_FRUSTUM_VOLUME:
+        return "Frustum::volumeInFrustum";
+
+    case QUERY_RAY_BOX:
+        return "Ray::hasIntersected(BoundingBox)";
+
+    case QUERY_RAY_PLANE:
+        return "Ray::hasIntersected(Plane)";
+
+    case QUERY_RAY_SPHERE:
+        return "Ray::hasIntersected(BoundingSphere)";
+
+    case QUERY_RAY_VOLUME:
+        return "Ray::hasIntersected(BoundingVolume)";
+
+    default:
+        return "unknown";
+    }
+}
+
+void CollisionStats::reset()
+{
+#if defined(MATHLIB_COLLISION_STATS)
+    CollisionCounterRegistry &registry = counterRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+
+    for (size_t i = 0; i < registry.live.size(); ++i)
+        registry.live[i]->reset();
+
+    for (int i = 0; i < COUNTER_COUNT; ++i)
+        registry.retired[i] = 0;
+#endif
+}
+
+CollisionStats CollisionStats::snapshot()
+{
+    CollisionStats stats;
+
+#if defined(MATHLIB_COLLISION_STATS)
+    unsigned long long totals[COUNTER_COUNT];
+    CollisionCounterRegistry &registry = counterRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+
+    for (int i = 0; i < COUNTER_COUNT; ++i)
+    {
+        totals[i] = registry.retired[i];
+
+        for (size_t j = 0; j < registry.live.size(); ++j)
+            totals[i] += registry.live[j]->get(i);
+    }
+
+    double nanosecondsPerTick = registry.nanosecondsPerTick();
+
+    for (int i = 0; i < QUERY_COUNT; ++i)
+    {
+        stats.calls[i] = totals[COUNTER_CALLS + i];
+        stats.nanoseconds[i] = static_cast<unsigned long long>(
+            static_cast<double>(totals[COUNTER_TICKS + i]) * nanosecondsPerTick + 0.5);
+    }
+
+    for (int i = 0; i < 6; ++i)
+        stats.planeRejections[i] = totals[COUNTER_PLANE_REJECTIONS + i];
+
+    for (int i = 0; i < 8; ++i)
+        stats.rayBoxOctants[i] = totals[COUNTER_RAY_BOX_OCTANTS + i];
+#endif
+
+    return stats;
 }
\ No newline at end of file
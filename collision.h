@@ -23,26 +23,42 @@
 #if !defined(COLLISION_H)
 #define COLLISION_H
 
+#include <functional>
+
 #include "mathlib.h"
 
 //-----------------------------------------------------------------------------
 // Classes.
 
-class BoundingBox
+template <typename T>
+class BoundingBoxT
 {
 public:
-    Vector3 min;
-    Vector3 max;
+    Vector3T<T> min;
+    Vector3T<T> max;
 
-    BoundingBox();
-    BoundingBox(const Vector3 &min_, const Vector3 &max_);
-    ~BoundingBox();
+    BoundingBoxT();
+    BoundingBoxT(const Vector3T<T> &min_, const Vector3T<T> &max_);
+    template <typename U> explicit BoundingBoxT(const BoundingBoxT<U> &box);
+    ~BoundingBoxT();
 
-    Vector3 getCenter() const;
-    float getRadius() const;
-    float getSize() const;
+    Vector3T<T> getCenter() const;
+    T getRadius() const;
+    T getSize() const;
 };
 
+template <typename T>
+template <typename U>
+inline BoundingBoxT<T>::BoundingBoxT(const BoundingBoxT<U> &box) : min(box.min), max(box.max)
+{
+}
+
+typedef BoundingBoxT<float> BoundingBox;
+typedef BoundingBoxT<double> BoundingBoxd;
+
+extern template class BoundingBoxT<float>;
+extern template class BoundingBoxT<double>;
+
 //-----------------------------------------------------------------------------
 
 class BoundingSphere
@@ -71,33 +87,143 @@ public:
 };
 
 //-----------------------------------------------------------------------------
+// The PlaneT class is the plane ax + by + cz + d = 0, with the normal
+// (a, b, c) in 'n'. Points are in front of the plane when dot() is
+// positive.
+//
+// The array version of dot() evaluates the plane for many points at once,
+// 4 at a time with SSE for float planes. clipPolygon() clips a convex
+// polygon against the plane (Sutherland-Hodgman), keeping the part in
+// front of it. The result has at most count + 1 vertices and must not
+// overlap the input. Vertices on the plane are kept.
 
-class Plane
+template <typename T>
+class PlaneT
 {
 public:
-    Vector3 n;
-    float d;
+    Vector3T<T> n;
+    T d;
 
-    static float dot(const Plane &p, const Vector3 &pt);
+    static unsigned int clipPolygon(const PlaneT &p, const Vector3T<T> *polygon, unsigned int count, Vector3T<T> *result);
+    static T dot(const PlaneT &p, const Vector3T<T> &pt);
+    static void dot(const PlaneT &p, const Vector3T<T> *points, T *distances, unsigned int count);
 
-    Plane();
-    Plane(float a_, float b_, float c_, float d_);
-    Plane(const Vector3 &pt, const Vector3 &normal);
-    Plane(const Vector3 &pt1, const Vector3 &pt2, const Vector3 &pt3);
-    ~Plane();
+    PlaneT();
+    PlaneT(T a_, T b_, T c_, T d_);
+    PlaneT(const Vector3T<T> &pt, const Vector3T<T> &normal);
+    PlaneT(const Vector3T<T> &pt1, const Vector3T<T> &pt2, const Vector3T<T> &pt3);
+    template <typename U> explicit PlaneT(const PlaneT<U> &p);
+    ~PlaneT();
 
-    bool operator==(const Plane &rhs) const;
-    bool operator!=(const Plane &rhs) const;
+    bool operator==(const PlaneT &rhs) const;
+    bool operator!=(const PlaneT &rhs) const;
 
-    void fromPointNormal(const Vector3 &pt, const Vector3 &normal);
-    void fromPoints(const Vector3 &pt1, const Vector3 &pt2, const Vector3 &pt3);
-    const Vector3 &normal() const;
-    Vector3 &normal();
+    void fromPointNormal(const Vector3T<T> &pt, const Vector3T<T> &normal);
+    void fromPoints(const Vector3T<T> &pt1, const Vector3T<T> &pt2, const Vector3T<T> &pt3);
+    const Vector3T<T> &normal() const;
+    Vector3T<T> &normal();
     void normalize();
-    void set(float a_, float b_, float c_, float d_);
+    void set(T a_, T b_, T c_, T d_);
+};
+
+template <typename T>
+template <typename U>
+inline PlaneT<T>::PlaneT(const PlaneT<U> &p) : n(p.n), d(static_cast<T>(p.d))
+{
+}
+
+template <>
+void PlaneT<float>::dot(const PlaneT<float> &p, const Vector3T<float> *points, float *distances, unsigned int count);
+
+typedef PlaneT<float> Plane;
+typedef PlaneT<double> Planed;
+
+extern template class PlaneT<float>;
+extern template class PlaneT<double>;
+
+//-----------------------------------------------------------------------------
+// The Capsule class is a sphere swept along a segment: every point within
+// 'radius' of the segment from 'a' to 'b'. The tests against other shapes
+// find the closest points of the capsule's segment and the other shape and
+// compare their distance with the radius, so they are exact. Shapes that
+// just touch count as colliding.
+//
+// closestPoints() finds the closest points p1 + s * (q1 - p1) and
+// p2 + t * (q2 - p2) of two segments, with s and t in [0, 1], and returns
+// the squared distance between them. Either segment may be a single point.
+//
+// hasCollided(const Plane &) is true when the capsule touches the plane.
+// Frustum::capsuleInFrustum(), Ray::hasIntersected() and the Batch capsule
+// functions cover the other queries.
+
+class Capsule
+{
+public:
+    Vector3 a;
+    Vector3 b;
+    float radius;
+
+    static float closestPoints(const Vector3 &p1, const Vector3 &q1, const Vector3 &p2, const Vector3 &q2, float &s, float &t);
+
+    Capsule();
+    Capsule(const Vector3 &a_, const Vector3 &b_, float radius_);
+    ~Capsule();
+
+    bool hasCollided(const BoundingBox &box) const;
+    bool hasCollided(const BoundingSphere &sphere) const;
+    bool hasCollided(const Capsule &other) const;
+    bool hasCollided(const Plane &plane) const;
+    bool pointInCapsule(const Vector3 &point) const;
 };
 
 //-----------------------------------------------------------------------------
+// The Cylinder class is a solid cylinder with flat caps, its axis running
+// from 'a' to 'b'. 'a' and 'b' must differ. As with Capsule, shapes that
+// just touch count as colliding.
+
+class Cylinder
+{
+public:
+    Vector3 a;
+    Vector3 b;
+    float radius;
+
+    Cylinder();
+    Cylinder(const Vector3 &a_, const Vector3 &b_, float radius_);
+    ~Cylinder();
+
+    bool hasCollided(const BoundingSphere &sphere) const;
+    bool hasCollided(const Plane &plane) const;
+    bool pointInCylinder(const Vector3 &point) const;
+};
+
+//-----------------------------------------------------------------------------
+// The Frustum class holds six planes with their normals pointing into the
+// view volume. There are three ways to set them up:
+//
+//  - extractPlanes() extracts the planes from a projection matrix. Pass the
+//    combined view-projection matrix when it is already known, to skip the
+//    matrix product of the two argument version.
+//  - fromPerspective() builds the planes of an OpenGL style perspective
+//    camera (looking down -z in view space, vertical field of view in
+//    degrees) directly, with one tan and two square roots rather than a
+//    matrix product. The near plane is at exactly 'znear'.
+//  - fromViewSpace() moves a frustum built in view space (e.g., by
+//    fromPerspective() with an identity view matrix) into world space. This
+//    is the cheap update for cameras whose projection doesn't change: the
+//    view space frustum is built once and each frame only transforms its
+//    planes. The view matrix must be rigid (rotation and translation only),
+//    or the planes won't be normalized.
+//
+// capsuleInFrustum() and cylinderInFrustum() test each plane exactly, but
+// like sphereInFrustum() they may report shapes near the corners of the
+// view volume as visible.
+//
+// clipPolygon() clips a convex polygon to the frustum, one plane after the
+// other with Plane::clipPolygon(). The result has at most count + 6
+// vertices. Polygons of more than MAX_CLIP_VERTICES - 6 vertices are not
+// clipped, and 0 is returned. Batch::clipTriangles() clips streams of
+// triangles.
 
 class Frustum
 {
@@ -112,17 +238,83 @@ public:
         FRUSTUM_PLANE_FAR    = 5
     };
 
+    static const unsigned int MAX_CLIP_VERTICES = 64;
+
     Plane planes[6];
 
-    void extractPlanes(const Matrix4 &viewMatrix4, const Matrix4 &projMatrix4);
+    Frustum();
+    explicit Frustum(const Matrix4 &viewProjMatrix);
+    Frustum(const Matrix4 &viewMatrix, const Matrix4 &projMatrix);
+    Frustum(float fovy, float aspect, float znear, float zfar, const Matrix4 &viewMatrix);
+
+    void extractPlanes(const Matrix4 &viewProjMatrix);
+    void extractPlanes(const Matrix4 &viewMatrix, const Matrix4 &projMatrix);
+    void fromPerspective(float fovy, float aspect, float znear, float zfar, const Matrix4 &viewMatrix);
+    void fromViewSpace(const Frustum &viewSpaceFrustum, const Matrix4 &viewMatrix);
 
     bool boxInFrustum(const BoundingBox &box) const;
+    bool capsuleInFrustum(const Capsule &capsule) const;
+    unsigned int clipPolygon(const Vector3 *polygon, unsigned int count, Vector3 *result) const;
+    bool cylinderInFrustum(const Cylinder &cylinder) const;
     bool pointInFrustum(const Vector3 &point) const;
     bool sphereInFrustum(const BoundingSphere &sphere) const;
     bool volumeInFrustum(const BoundingVolume &volume) const;
 };
 
 //-----------------------------------------------------------------------------
+// The ConvexVolume class is a culling volume bounded by up to MAX_PLANES
+// planes, with their normals pointing into the volume: portal views,
+// oblique clip regions, light volumes and so on. It has the same point,
+// sphere and box tests as Frustum, and Batch::cullBoxes() and cullSpheres()
+// test arrays of objects against it.
+//
+// The planes are stored transposed (all the a's, then all the b's, and so
+// on), padded to a multiple of 4 with planes that everything passes, so the
+// tests check 4 planes at a time with SSE. planeData() returns the table,
+// MAX_PLANES floats per row.
+//
+// fromPortal() builds the volume seen through a convex portal polygon: the
+// planes of the frustum, one plane through the eye and each portal edge,
+// and the plane of the portal itself, so that only what is beyond the
+// portal is inside. addPortal() narrows an existing volume in the same way.
+// They return false, and leave the volume unchanged, if the planes don't
+// fit or the portal is degenerate or seen edge on. The portal's vertices
+// may be in either winding order.
+
+class ConvexVolume
+{
+public:
+    static const unsigned int MAX_PLANES = 32;
+
+    ConvexVolume();
+    explicit ConvexVolume(const Frustum &frustum);
+
+    bool addPlane(const Plane &plane);
+    bool addPortal(const Vector3 &eye, const Vector3 *portal, unsigned int vertexCount);
+    void clear();
+    void fromFrustum(const Frustum &frustum);
+    bool fromPortal(const Frustum &frustum, const Vector3 &eye, const Vector3 *portal, unsigned int vertexCount);
+    Plane plane(unsigned int i) const;
+    unsigned int planeCount() const;
+    const float *planeData() const;
+
+    bool boxInVolume(const BoundingBox &box) const;
+    bool pointInVolume(const Vector3 &point) const;
+    bool sphereInVolume(const BoundingSphere &sphere) const;
+
+private:
+    void setPlane(unsigned int i, float a, float b, float c, float d);
+
+    // m_planes[0] holds the a's, m_planes[1] the b's and so on.
+    float m_planes[4][MAX_PLANES];
+    unsigned int m_count;
+};
+
+//-----------------------------------------------------------------------------
+// The Ray class is the half line origin + t * direction, t >= 0. The
+// versions of hasIntersected() with a 't' argument return the distance to
+// the first point hit, in units of the direction's length. A ray starting
+// inside a capsule or cylinder hits it at t = 0.
 
 class Ray
 {
@@ -137,10 +329,124 @@ public:
     bool hasIntersected(const BoundingSphere &sphere) const;
     bool hasIntersected(const BoundingBox &box) const;
     bool hasIntersected(const BoundingVolume &volume) const;
+    bool hasIntersected(const Capsule &capsule) const;
+    bool hasIntersected(const Capsule &capsule, float &t) const;
+    bool hasIntersected(const Cylinder &cylinder) const;
+    bool hasIntersected(const Cylinder &cylinder, float &t) const;
     bool hasIntersected(const Plane &plane) const;
     bool hasIntersected(const Plane &plane, float &t, Vector3 &intersection) const;
 };
 
+//-----------------------------------------------------------------------------
+// The Sweep class finds when a moving shape first touches another
+// (continuous collision detection), so that fast objects can't pass
+// through thin ones between two discrete tests. The moving shape travels
+// by 'velocity' over the time step: at time t in [0, 1] it has moved by
+// velocity * t. The other shape doesn't move; for two moving shapes pass
+// the difference of their velocities.
+//
+// timeOfImpact() returns true if the shapes touch during the step, and sets
+// 't' to the time of first contact and 'normal' to the unit contact normal,
+// pointing from the other shape towards the moving one. Shapes that already
+// overlap at t = 0 hit at t = 0. Shapes that just touch count as hitting.
+// The outputs are unchanged on a miss. Triangles are 3 vertices and are
+// two sided. Planes must have a unit length normal; a sphere hits the side
+// of the plane its center starts on.
+//
+// contactNormal() returns the normal of two shapes that touch or overlap,
+// in the same direction: the direction the first shape is pushed out in.
+// For overlapping boxes, and a sphere whose center is inside a box, that
+// is the axis of least penetration. It is any unit vector for spheres with
+// the same center.
+//
+// advance() is conservative advancement for any pair of convex shapes:
+// 'distance' returns how far apart the shapes are at time t (0 or less if
+// they touch) and sets 'normal' for that time. 'maxSpeed' must bound how
+// fast that distance can shrink per unit of time, e.g., the length of the
+// relative velocity, plus the angular speed times the largest radius for
+// rotating shapes. Each step moves t on by the distance over maxSpeed,
+// which can't go past the first contact, until the shapes are within
+// 'tolerance' of each other. Shapes that graze past each other converge
+// slowly. If they haven't come within the tolerance after
+// MAX_ADVANCE_STEPS steps, the rest of the time step is searched for their
+// closest approach, and they miss if that is farther apart than the
+// tolerance. The search assumes the distance has a single minimum over the
+// rest of the step, as it does for convex shapes that only translate. The
+// Capsule version of timeOfImpact() uses it.
+//
+// Batch::sweepSpheres() and sweepBoxes() run the sphere and box queries
+// for arrays of moving shapes.
+
+class Sweep
+{
+public:
+    typedef std::function<float(float t, Vector3 &normal)> DistanceFunction;
+
+    static const unsigned int MAX_ADVANCE_STEPS = 64;
+
+    static bool advance(const DistanceFunction &distance, float maxSpeed, float tolerance, float &t, Vector3 &normal);
+    static Vector3 contactNormal(const BoundingBox &box, const BoundingBox &other);
+    static Vector3 contactNormal(const BoundingSphere &sphere, const BoundingBox &box);
+    static Vector3 contactNormal(const BoundingSphere &sphere, const BoundingSphere &other);
+    static Vector3 contactNormal(const BoundingSphere &sphere, const Plane &plane);
+    static Vector3 contactNormal(const BoundingSphere &sphere, const Vector3 *triangle);
+    static bool timeOfImpact(const BoundingBox &box, const Vector3 &velocity, const BoundingBox &other, float &t, Vector3 &normal);
+    static bool timeOfImpact(const BoundingSphere &sphere, const Vector3 &velocity, const BoundingBox &box, float &t, Vector3 &normal);
+    static bool timeOfImpact(const BoundingSphere &sphere, const Vector3 &velocity, const BoundingSphere &other, float &t, Vector3 &normal);
+    static bool timeOfImpact(const BoundingSphere &sphere, const Vector3 &velocity, const Plane &plane, float &t, Vector3 &normal);
+    static bool timeOfImpact(const BoundingSphere &sphere, const Vector3 &velocity, const Vector3 *triangle, float &t, Vector3 &normal);
+    static bool timeOfImpact(const Capsule &capsule, const Vector3 &velocity, const Capsule &other, float &t, Vector3 &normal);
+};
+
+//-----------------------------------------------------------------------------
+// The CollisionStats class reports what the collision queries are doing:
+// how often each query is called and the total time spent in it, which
+// frustum plane rejected the object in Frustum::boxInFrustum(),
+// pointInFrustum() and sphereInFrustum(), and which of the eight direction
+// octants (cases MMM to PPP) Ray::hasIntersected(const BoundingBox &) took.
+// Octant index bits 2, 1 and 0 are set when the ray's x, y and z direction
+// components are not negative, so MMM is 0 and PPP is 7.
+//
+// The instrumentation is only compiled in when the library is built with
+// MATHLIB_COLLISION_STATS defined. Otherwise the queries are unchanged,
+// enabled() returns false and snapshot() returns all zeros.
+//
+// Each thread counts into its own thread local counters. snapshot() adds up
+// the counters of all threads, including threads that have exited. reset()
+// zeros them; counts made by other threads while reset() runs may be lost.
+// The times of the volume queries include the box and sphere queries they
+// call, which are counted as well. Timing reads the time stamp counter twice
+// per query, which can cost as much as the cheaper queries themselves.
+
+class CollisionStats
+{
+public:
+    enum Query
+    {
+        QUERY_FRUSTUM_BOX    = 0,
+        QUERY_FRUSTUM_POINT  = 1,
+        QUERY_FRUSTUM_SPHERE = 2,
+        QUERY_FRUSTUM_VOLUME = 3,
+        QUERY_RAY_BOX        = 4,
+        QUERY_RAY_PLANE      = 5,
+        QUERY_RAY_SPHERE     = 6,
+        QUERY_RAY_VOLUME     = 7,
+        QUERY_COUNT          = 8
+    };
+
+    unsigned long long calls[QUERY_COUNT];
+    unsigned long long nanoseconds[QUERY_COUNT];
+    unsigned long long planeRejections[6];
+    unsigned long long rayBoxOctants[8];
+
+    static bool enabled();
+    static const char *queryName(Query query);
+    static void reset();
+    static CollisionStats snapshot();
+
+    CollisionStats();
+};
+
 //-----------------------------------------------------------------------------
 
 #endif
\ No newline at end of file
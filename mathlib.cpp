@@ -20,16 +20,27 @@
 // IN THE SOFTWARE.
 //-----------------------------------------------------------------------------
 
+#include <atomic>
+
 #include "mathlib.h"
+#include "batch_kernels.h"
+
+#if defined(MATHLIB_SSE2)
+#include <emmintrin.h>
+#endif
+
+#if defined(MATHLIB_AVX2)
+#include <immintrin.h>
+#endif
 
 //-----------------------------------------------------------------------------
 // Math.
 
-const float Math::PI = 3.1415926f;
-const float Math::HALF_PI = Math::PI / 2.0f;
-const float Math::QUARTER_PI = Math::PI / 4.0f;
-const float Math::TWO_PI = Math::PI * 2.0f;
-const float Math::EPSILON = 1e-6f;
+constexpr float Math::PI;
+constexpr float Math::HALF_PI;
+constexpr float Math::QUARTER_PI;
+constexpr float Math::TWO_PI;
+constexpr float Math::EPSILON;
 
 int Math::nextPower2(int x)
 {
@@ -41,45 +52,131 @@ int Math::nextPower2(int x)
     return i;
 }
 
+float Math::random(float min, float max)
+{
+    // Returns a random number in range [min,max). Each thread has its own
+    // generator, so this is thread safe and never takes a lock. Each new
+    // thread's generator is given the next seed in sequence. Use a Random
+    // object directly for reproducible sequences.
+
+    static std::atomic<unsigned long long> nextSeed(Random::DEFAULT_SEED);
+    static thread_local Random generator(nextSeed++);
+
+    return generator.nextFloat(min, max);
+}
+
 //-----------------------------------------------------------------------------
-// Matrix3.
+// Fast math array forms. The SIMD kernels are in batch_kernels.inl, so that
+// the AVX2 kernels are compiled with AVX2 enabled and picked at run time
+// like the Batch functions. Without SIMD kernels the scalar forms are used.
+
+#define FAST_MATH_ARRAY(function) \
+    const BatchKernels *pKernels = batchKernels(); \
+    if (pKernels->function) \
+    { \
+        pKernels->function(x, result, count); \
+        return; \
+    } \
+    for (unsigned int i = 0; i < count; ++i) \
+        result[i] = function(x[i]);
+
+void Math::fastAcos(const float *x, float *result, unsigned int count)
+{
+    FAST_MATH_ARRAY(fastAcos)
+}
+
+void Math::fastAtan2(const float *y, const float *x, float *result, unsigned int count)
+{
+    const BatchKernels *pKernels = batchKernels();
+
+    if (pKernels->fastAtan2)
+    {
+        pKernels->fastAtan2(y, x, result, count);
+        return;
+    }
+
+    for (unsigned int i = 0; i < count; ++i)
+        result[i] = fastAtan2(y[i], x[i]);
+}
+
+void Math::fastCos(const float *x, float *result, unsigned int count)
+{
+    FAST_MATH_ARRAY(fastCos)
+}
+
+void Math::fastExp(const float *x, float *result, unsigned int count)
+{
+    FAST_MATH_ARRAY(fastExp)
+}
+
+void Math::fastLog(const float *x, float *result, unsigned int count)
+{
+    FAST_MATH_ARRAY(fastLog)
+}
+
+void Math::fastRsqrt(const float *x, float *result, unsigned int count)
+{
+    FAST_MATH_ARRAY(fastRsqrt)
+}
+
+void Math::fastSin(const float *x, float *result, unsigned int count)
+{
+    FAST_MATH_ARRAY(fastSin)
+}
+
+void Math::fastSinCos(const float *x, float *s, float *c, unsigned int count)
+{
+    const BatchKernels *pKernels = batchKernels();
+
+    if (pKernels->fastSinCos)
+    {
+        pKernels->fastSinCos(x, s, c, count);
+        return;
+    }
+
+    for (unsigned int i = 0; i < count; ++i)
+        fastSinCos(x[i], s[i], c[i]);
+}
+
+#undef FAST_MATH_ARRAY
 
-const Matrix3 Matrix3::IDENTITY(1.0f, 0.0f, 0.0f,
-                                0.0f, 1.0f, 0.0f,
-                                0.0f, 0.0f, 1.0f);
+//-----------------------------------------------------------------------------
+// Matrix3.
 
-Matrix3 Matrix3::createMirror(const Vector3 &planeNormal)
+template <typename T>
+Matrix3T<T> Matrix3T<T>::createMirror(const Vector3T<T> &planeNormal)
 {
     // Constructs a reflection (or mirror) matrix given an arbitrary plane
     // that passes through the origin.
     //
     // Ronald Goldman, "Matrices and Transformation," Graphics Gems, 1990.
 
-    float x = planeNormal.x;
-    float y = planeNormal.y;
-    float z = planeNormal.z;
+    T x = planeNormal.x;
+    T y = planeNormal.y;
+    T z = planeNormal.z;
 
-    return Matrix3( 1.0f - 2.0f * x * x, -2.0f * y * x,        -2.0f * z * x,
-                   -2.0f * x * y,         1.0f - 2.0f * y * y, -2.0f * z * y,
-                   -2.0f * x * z,        -2.0f * y * z,         1.0f - 2.0f * z * z);
+    return Matrix3T<T>( T(1) - T(2) * x * x, -T(2) * y * x,        -T(2) * z * x,
+                   -T(2) * x * y,         T(1) - T(2) * y * y, -T(2) * z * y,
+                   -T(2) * x * z,        -T(2) * y * z,         T(1) - T(2) * z * z);
 }
 
-void Matrix3::fromHeadPitchRoll(float headDegrees, float pitchDegrees, float rollDegrees)
+template <typename T>
+void Matrix3T<T>::fromHeadPitchRoll(T headDegrees, T pitchDegrees, T rollDegrees)
 {
     // Constructs a rotation matrix based on a Euler Transform.
     // We use the popular NASA standard airplane convention of 
     // heading-pitch-roll (i.e., RzRxRy).
 
-    headDegrees = Math::degreesToRadians(headDegrees);
-    pitchDegrees = Math::degreesToRadians(pitchDegrees);
-    rollDegrees = Math::degreesToRadians(rollDegrees);
+    headDegrees = ScalarMath<T>::degreesToRadians(headDegrees);
+    pitchDegrees = ScalarMath<T>::degreesToRadians(pitchDegrees);
+    rollDegrees = ScalarMath<T>::degreesToRadians(rollDegrees);
 
-    float cosH = cosf(headDegrees);
-    float cosP = cosf(pitchDegrees);
-    float cosR = cosf(rollDegrees);
-    float sinH = sinf(headDegrees);
-    float sinP = sinf(pitchDegrees);
-    float sinR = sinf(rollDegrees);
+    T cosH, cosP, cosR;
+    T sinH, sinP, sinR;
+
+    ScalarMath<T>::sinCos(headDegrees, sinH, cosH);
+    ScalarMath<T>::sinCos(pitchDegrees, sinP, cosP);
+    ScalarMath<T>::sinCos(rollDegrees, sinR, cosR);
 
     mtx[0][0] = cosR * cosH - sinR * sinP * sinH;
     mtx[0][1] = sinR * cosH + cosR * sinP * sinH;
@@ -94,21 +191,22 @@ void Matrix3::fromHeadPitchRoll(float headDegrees, float pitchDegrees, float rol
     mtx[2][2] = cosP * cosH;
 }
 
-Matrix3 Matrix3::inverse() const
+template <typename T>
+Matrix3T<T> Matrix3T<T>::inverse() const
 {
     // If the inverse doesn't exist for this matrix, then the identity
     // matrix will be returned.
 
-    Matrix3 tmp;
-    float d = determinant();
+    Matrix3T<T> tmp;
+    T d = determinant();
 
-    if (Math::closeEnough(d, 0.0f))
+    if (ScalarMath<T>::closeEnough(d, T(0)))
     {
         tmp.identity();
     }
     else
     {
-        d = 1.0f / d;
+        d = T(1) / d;
 
         tmp.mtx[0][0] = d * (mtx[1][1] * mtx[2][2] - mtx[1][2] * mtx[2][1]);
         tmp.mtx[0][1] = d * (mtx[0][2] * mtx[2][1] - mtx[0][1] * mtx[2][2]);
@@ -126,7 +224,8 @@ Matrix3 Matrix3::inverse() const
     return tmp;
 }
 
-void Matrix3::orient(const Vector3 &from, const Vector3 &to)
+template <typename T>
+void Matrix3T<T>::orient(const Vector3T<T> &from, const Vector3T<T> &to)
 {
     // Creates an orientation matrix that will rotate the vector 'from' 
     // into the vector 'to'. For this method to work correctly, vector
@@ -137,9 +236,9 @@ void Matrix3::orient(const Vector3 &from, const Vector3 &to)
     //   to rotate one vector to another," Journal of Graphics Tools,
     //   4(4):1-4, 1999.
 
-    float e = Vector3::dot(from, to);
+    T e = Vector3T<T>::dot(from, to);
 
-    if (Math::closeEnough(e, 1.0f))
+    if (ScalarMath<T>::closeEnough(e, T(1)))
     {
         // Special case where 'from' is equal to 'to'. In other words,
         // the angle between vector 'from' and vector 'to' is zero 
@@ -147,7 +246,7 @@ void Matrix3::orient(const Vector3 &from, const Vector3 &to)
 
         identity();
     }
-    else if (Math::closeEnough(e, -1.0f))
+    else if (ScalarMath<T>::closeEnough(e, -T(1)))
     {
         // Special case where 'from' is directly opposite to 'to'. In
         // other words, the angle between vector 'from' and vector 'to'
@@ -164,14 +263,14 @@ void Matrix3::orient(const Vector3 &from, const Vector3 &to)
         // | -FxFy+UxUy-SxSy  -FyFy+UyUy-SySy  -FyFz+UyUz-SySz |
         // | -FxFz+UxUz-SxSz  -FyFz+UyUz-SySz  -FzFz+UzUz-SzSz |
         
-        Vector3 side(0.0f, from.z, -from.y);
+        Vector3T<T> side(T(0), from.z, -from.y);
 
-        if (Math::closeEnough(Vector3::dot(side, side), 0.0f))
-            side.set(-from.z, 0.0f, from.x);
+        if (ScalarMath<T>::closeEnough(Vector3T<T>::dot(side, side), T(0)))
+            side.set(-from.z, T(0), from.x);
 
         side.normalize();
 
-        Vector3 up = Vector3::cross(side, from);
+        Vector3T<T> up = Vector3T<T>::cross(side, from);
         up.normalize();
 
         mtx[0][0] = -(from.x * from.x) + (up.x * up.x) - (side.x * side.x);
@@ -197,10 +296,10 @@ void Matrix3::orient(const Vector3 &from, const Vector3 &to)
         //   E = from.dot(to)
         //   H = (1 - E) / V.dot(V)
 
-        Vector3 v = Vector3::cross(from, to);
+        Vector3T<T> v = Vector3T<T>::cross(from, to);
         v.normalize();
 
-        float h = (1.0f - e) / Vector3::dot(v, v);
+        T h = (T(1) - e) / Vector3T<T>::dot(v, v);
 
         mtx[0][0] = e + h * v.x * v.x;
         mtx[0][1] = h * v.x * v.y + v.z;
@@ -216,7 +315,8 @@ void Matrix3::orient(const Vector3 &from, const Vector3 &to)
     }
 }
 
-void Matrix3::rotate(const Vector3 &axis, float degrees)
+template <typename T>
+void Matrix3T<T>::rotate(const Vector3T<T> &axis, T degrees)
 {
     // Creates a rotation matrix about the specified axis.
     // The axis must be a unit vector. The angle must be in degrees.
@@ -231,28 +331,30 @@ void Matrix3::rotate(const Vector3 &axis, float degrees)
     //	c = cos(angle)
     //  s = sin(angle)
 
-    degrees = Math::degreesToRadians(degrees);
+    degrees = ScalarMath<T>::degreesToRadians(degrees);
+
+    T x = axis.x;
+    T y = axis.y;
+    T z = axis.z;
+    T c, s;
 
-    float x = axis.x;
-    float y = axis.y;
-    float z = axis.z;
-    float c = cosf(degrees);
-    float s = sinf(degrees);
+    ScalarMath<T>::sinCos(degrees, s, c);
 
-    mtx[0][0] = (x * x) * (1.0f - c) + c;
-    mtx[0][1] = (x * y) * (1.0f - c) + (z * s);
-    mtx[0][2] = (x * z) * (1.0f - c) - (y * s);
+    mtx[0][0] = (x * x) * (T(1) - c) + c;
+    mtx[0][1] = (x * y) * (T(1) - c) + (z * s);
+    mtx[0][2] = (x * z) * (T(1) - c) - (y * s);
 
-    mtx[1][0] = (y * x) * (1.0f - c) - (z * s);
-    mtx[1][1] = (y * y) * (1.0f - c) + c;
-    mtx[1][2] = (y * z) * (1.0f - c) + (x * s);
+    mtx[1][0] = (y * x) * (T(1) - c) - (z * s);
+    mtx[1][1] = (y * y) * (T(1) - c) + c;
+    mtx[1][2] = (y * z) * (T(1) - c) + (x * s);
 
-    mtx[2][0] = (z * x) * (1.0f - c) + (y * s);
-    mtx[2][1] = (z * y) * (1.0f - c) - (x * s);
-    mtx[2][2] = (z * z) * (1.0f - c) + c;
+    mtx[2][0] = (z * x) * (T(1) - c) + (y * s);
+    mtx[2][1] = (z * y) * (T(1) - c) - (x * s);
+    mtx[2][2] = (z * z) * (T(1) - c) + c;
 }
 
-void Matrix3::scale(float sx, float sy, float sz)
+template <typename T>
+void Matrix3T<T>::scale(T sx, T sy, T sz)
 {
     // Creates a scaling matrix.
     //
@@ -260,12 +362,13 @@ void Matrix3::scale(float sx, float sy, float sz)
     // S(sx, sy, sz) = | 0    sy   0  |
     //                 | 0    0    sz |
     
-    mtx[0][0] = sx,   mtx[0][1] = 0.0f, mtx[0][2] = 0.0f;
-    mtx[1][0] = 0.0f, mtx[1][1] = sy,   mtx[1][2] = 0.0f;
-    mtx[2][0] = 0.0f, mtx[2][1] = 0.0f, mtx[2][2] = sz;
+    mtx[0][0] = sx,   mtx[0][1] = T(0), mtx[0][2] = T(0);
+    mtx[1][0] = T(0), mtx[1][1] = sy,   mtx[1][2] = T(0);
+    mtx[2][0] = T(0), mtx[2][1] = T(0), mtx[2][2] = sz;
 }
 
-void Matrix3::toHeadPitchRoll(float &headDegrees, float &pitchDegrees, float &rollDegrees) const
+template <typename T>
+void Matrix3T<T>::toHeadPitchRoll(T &headDegrees, T &pitchDegrees, T &rollDegrees) const
 {
     // Extracts the Euler angles from a rotation matrix. The returned
     // angles are in degrees. This method might suffer from numerical
@@ -279,101 +382,116 @@ void Matrix3::toHeadPitchRoll(float &headDegrees, float &pitchDegrees, float &ro
     //  David Eberly, "Euler Angle Formulas", Geometric Tools web site,
     //  http://www.geometrictools.com/Documentation/EulerAngles.pdf.
 
-    float thetaX = asinf(mtx[1][2]);
-    float thetaY = 0.0f;
-    float thetaZ = 0.0f;
+    T thetaX = ScalarMath<T>::asin(mtx[1][2]);
+    T thetaY = T(0);
+    T thetaZ = T(0);
 
-    if (thetaX < Math::HALF_PI)
+    if (thetaX < ScalarMath<T>::halfPi())
     {
-        if (thetaX > -Math::HALF_PI)
+        if (thetaX > -ScalarMath<T>::halfPi())
         {
-            thetaZ = atan2f(-mtx[1][0], mtx[1][1]);
-            thetaY = atan2f(-mtx[0][2], mtx[2][2]);
+            thetaZ = ScalarMath<T>::atan2(-mtx[1][0], mtx[1][1]);
+            thetaY = ScalarMath<T>::atan2(-mtx[0][2], mtx[2][2]);
         }
         else
         {
             // Not a unique solution.
-            thetaZ = -atan2f(mtx[2][0], mtx[0][0]);
-            thetaY = 0.0f;
+            thetaZ = -ScalarMath<T>::atan2(mtx[2][0], mtx[0][0]);
+            thetaY = T(0);
         }
     }
     else
     {
         // Not a unique solution.
-        thetaZ = atan2f(mtx[2][0], mtx[0][0]);
-        thetaY = 0.0f;
+        thetaZ = ScalarMath<T>::atan2(mtx[2][0], mtx[0][0]);
+        thetaY = T(0);
     }
 
-    headDegrees = Math::radiansToDegrees(thetaY);
-    pitchDegrees = Math::radiansToDegrees(thetaX);
-    rollDegrees = Math::radiansToDegrees(thetaZ);
+    headDegrees = ScalarMath<T>::radiansToDegrees(thetaY);
+    pitchDegrees = ScalarMath<T>::radiansToDegrees(thetaX);
+    rollDegrees = ScalarMath<T>::radiansToDegrees(thetaZ);
 }
 
+template class Matrix3T<float>;
+template class Matrix3T<double>;
+
 //-----------------------------------------------------------------------------
 // Matrix4.
 
-const Matrix4 Matrix4::IDENTITY(1.0f, 0.0f, 0.0f, 0.0f,
-                              0.0f, 1.0f, 0.0f, 0.0f,
-                              0.0f, 0.0f, 1.0f, 0.0f,
-                              0.0f, 0.0f, 0.0f, 1.0f);
-
-Matrix4 Matrix4::createMirror(const Vector3 &planeNormal, const Vector3 &pointOnPlane)
+template <typename T>
+Matrix4T<T> Matrix4T<T>::createMirror(const Vector3T<T> &planeNormal, const Vector3T<T> &pointOnPlane)
 {
     // Constructs a reflection (or mirror) matrix given an arbitrary plane
     // that passes through the specified position.
     //
     // Ronald Goldman, "Matrices and Transformation," Graphics Gems, 1990.
 
-    float x = planeNormal.x;
-    float y = planeNormal.y;
-    float z = planeNormal.z;
-    float dot = Vector3::dot(planeNormal, pointOnPlane);
+    T x = planeNormal.x;
+    T y = planeNormal.y;
+    T z = planeNormal.z;
+    T dot = Vector3T<T>::dot(planeNormal, pointOnPlane);
 
-    return Matrix4( 1.0f - 2.0f * x * x, -2.0f * y * x,        -2.0f * z * x,        0.0f,    
-                   -2.0f * x * y,         1.0f - 2.0f * y * y, -2.0f * z * y,        0.0f,
-                   -2.0f * x * z,        -2.0f * y * z,         1.0f - 2.0f * z * z, 0.0f,
-                    2.0f * dot * x,       2.0f * dot * y,       2.0f * dot * z,      1.0f);
+    return Matrix4T<T>( T(1) - T(2) * x * x, -T(2) * y * x,        -T(2) * z * x,        T(0),    
+                   -T(2) * x * y,         T(1) - T(2) * y * y, -T(2) * z * y,        T(0),
+                   -T(2) * x * z,        -T(2) * y * z,         T(1) - T(2) * z * z, T(0),
+                    T(2) * dot * x,       T(2) * dot * y,       T(2) * dot * z,      T(1));
 }
 
-void Matrix4::fromHeadPitchRoll(float headDegrees, float pitchDegrees, float rollDegrees)
+template <typename T>
+Matrix4T<T> Matrix4T<T>::createPerspective(T fovyDegrees, T aspect, T znear, T zfar)
+{
+    // Constructs an OpenGL style perspective projection matrix for row
+    // vectors (the transpose of the gluPerspective() matrix).
+
+    T f = T(1) / std::tan(ScalarMath<T>::degreesToRadians(fovyDegrees) * T(0.5));
+
+    return Matrix4T<T>(f / aspect, T(0), T(0), T(0),
+                       T(0), f, T(0), T(0),
+                       T(0), T(0), (zfar + znear) / (znear - zfar), T(-1),
+                       T(0), T(0), (T(2) * zfar * znear) / (znear - zfar), T(0));
+}
+
+template <typename T>
+void Matrix4T<T>::fromHeadPitchRoll(T headDegrees, T pitchDegrees, T rollDegrees)
 {
     // Constructs a rotation matrix based on a Euler Transform.
     // We use the popular NASA standard airplane convention of 
     // heading-pitch-roll (i.e., RzRxRy).
 
-    headDegrees = Math::degreesToRadians(headDegrees);
-    pitchDegrees = Math::degreesToRadians(pitchDegrees);
-    rollDegrees = Math::degreesToRadians(rollDegrees);
+    headDegrees = ScalarMath<T>::degreesToRadians(headDegrees);
+    pitchDegrees = ScalarMath<T>::degreesToRadians(pitchDegrees);
+    rollDegrees = ScalarMath<T>::degreesToRadians(rollDegrees);
+
+    T cosH, cosP, cosR;
+    T sinH, sinP, sinR;
 
-    float cosH = cosf(headDegrees);
-    float cosP = cosf(pitchDegrees);
-    float cosR = cosf(rollDegrees);
-    float sinH = sinf(headDegrees);
-    float sinP = sinf(pitchDegrees);
-    float sinR = sinf(rollDegrees);
+    ScalarMath<T>::sinCos(headDegrees, sinH, cosH);
+    ScalarMath<T>::sinCos(pitchDegrees, sinP, cosP);
+    ScalarMath<T>::sinCos(rollDegrees, sinR, cosR);
 
     mtx[0][0] = cosR * cosH - sinR * sinP * sinH;
     mtx[0][1] = sinR * cosH + cosR * sinP * sinH;
     mtx[0][2] = -cosP * sinH;
-    mtx[0][3] = 0.0f;
+    mtx[0][3] = T(0);
 
     mtx[1][0] = -sinR * cosP;
     mtx[1][1] = cosR * cosP;
     mtx[1][2] = sinP;
-    mtx[1][3] = 0.0f;
+    mtx[1][3] = T(0);
 
     mtx[2][0] = cosR * sinH + sinR * sinP * cosH;
     mtx[2][1] = sinR * sinH - cosR * sinP * cosH;
     mtx[2][2] = cosP * cosH;
-    mtx[2][3] = 0.0f;
+    mtx[2][3] = T(0);
 
-    mtx[3][0] = 0.0f;
-    mtx[3][1] = 0.0f;
-    mtx[3][2] = 0.0f;
-    mtx[3][3] = 1.0f;
+    mtx[3][0] = T(0);
+    mtx[3][1] = T(0);
+    mtx[3][2] = T(0);
+    mtx[3][3] = T(1);
 }
 
-Matrix4 Matrix4::inverse() const
+template <typename T>
+Matrix4T<T> Matrix4T<T>::inverse() const
 {
     // This method of computing the inverse of a 4x4 matrix is based
     // on a similar function found in Paul Nettle's matrix template
@@ -382,16 +500,16 @@ Matrix4 Matrix4::inverse() const
     // If the inverse doesn't exist for this matrix, then the identity
     // matrix will be returned.
 
-    Matrix4 tmp;
-    float d = determinant();
+    Matrix4T<T> tmp;
+    T d = determinant();
 
-    if (Math::closeEnough(d, 0.0f))
+    if (ScalarMath<T>::closeEnough(d, T(0)))
     {
         tmp.identity();
     }
     else
     {
-        d = 1.0f / d;
+        d = T(1) / d;
 
         tmp.mtx[0][0] = d * (mtx[1][1] * (mtx[2][2] * mtx[3][3] - mtx[3][2] * mtx[2][3]) + mtx[2][1] * (mtx[3][2] * mtx[1][3] - mtx[1][2] * mtx[3][3]) + mtx[3][1] * (mtx[1][2] * mtx[2][3] - mtx[2][2] * mtx[1][3]));
         tmp.mtx[1][0] = d * (mtx[1][2] * (mtx[2][0] * mtx[3][3] - mtx[3][0] * mtx[2][3]) + mtx[2][2] * (mtx[3][0] * mtx[1][3] - mtx[1][0] * mtx[3][3]) + mtx[3][2] * (mtx[1][0] * mtx[2][3] - mtx[2][0] * mtx[1][3]));
@@ -417,7 +535,207 @@ Matrix4 Matrix4::inverse() const
     return tmp;
 }
 
-void Matrix4::orient(const Vector3 &from, const Vector3 &to)
+template <typename T>
+bool Matrix4T<T>::inverseAffine(Matrix4T<T> &result) const
+{
+    // Inverts an affine transform matrix. The matrix must be of the form:
+    //
+    //     | A  0 |
+    // M = |      |
+    //     | t  1 |
+    //
+    // where A is any invertible 3x3 matrix (rotation, scale, shear) and t
+    // is the translation row vector. The inverse is then:
+    //
+    //          | A^-1      0 |
+    // M^-1 =   |             |
+    //          | -tA^-1    1 |
+    //
+    // Returns false and leaves 'result' unmodified if A is singular.
+
+    T c00 = mtx[1][1] * mtx[2][2] - mtx[1][2] * mtx[2][1];
+    T c01 = mtx[1][2] * mtx[2][0] - mtx[1][0] * mtx[2][2];
+    T c02 = mtx[1][0] * mtx[2][1] - mtx[1][1] * mtx[2][0];
+    T d = mtx[0][0] * c00 + mtx[0][1] * c01 + mtx[0][2] * c02;
+
+    if (ScalarMath<T>::closeEnough(d, T(0)))
+        return false;
+
+    d = T(1) / d;
+
+    T a00 = d * c00;
+    T a01 = d * (mtx[0][2] * mtx[2][1] - mtx[0][1] * mtx[2][2]);
+    T a02 = d * (mtx[0][1] * mtx[1][2] - mtx[0][2] * mtx[1][1]);
+    T a10 = d * c01;
+    T a11 = d * (mtx[0][0] * mtx[2][2] - mtx[0][2] * mtx[2][0]);
+    T a12 = d * (mtx[0][2] * mtx[1][0] - mtx[0][0] * mtx[1][2]);
+    T a20 = d * c02;
+    T a21 = d * (mtx[0][1] * mtx[2][0] - mtx[0][0] * mtx[2][1]);
+    T a22 = d * (mtx[0][0] * mtx[1][1] - mtx[0][1] * mtx[1][0]);
+
+    T tx = mtx[3][0];
+    T ty = mtx[3][1];
+    T tz = mtx[3][2];
+
+    result.mtx[0][0] = a00, result.mtx[0][1] = a01, result.mtx[0][2] = a02, result.mtx[0][3] = T(0);
+    result.mtx[1][0] = a10, result.mtx[1][1] = a11, result.mtx[1][2] = a12, result.mtx[1][3] = T(0);
+    result.mtx[2][0] = a20, result.mtx[2][1] = a21, result.mtx[2][2] = a22, result.mtx[2][3] = T(0);
+    result.mtx[3][0] = -(tx * a00 + ty * a10 + tz * a20);
+    result.mtx[3][1] = -(tx * a01 + ty * a11 + tz * a21);
+    result.mtx[3][2] = -(tx * a02 + ty * a12 + tz * a22);
+    result.mtx[3][3] = T(1);
+
+    return true;
+}
+
+#if defined(MATHLIB_SSE)
+static bool inverseGeneral(const Matrix4 &m, Matrix4 &result)
+{
+    // SSE version of Matrix4T<float>::inverseGeneral(). It is adapted from:
+    //  Intel Corporation, "Streaming SIMD Extensions - Inverse of 4x4
+    //  Matrix," Application Note AP-928, 1999.
+
+    const float *src = &m[0][0];
+    __m128 minor0, minor1, minor2, minor3;
+    __m128 row0, row1, row2, row3;
+    __m128 det, tmp1;
+
+    // Transpose the matrix into row0..row3 (with rows 1 and 3 having their
+    // halves swapped, which the cofactor expansion below relies on).
+    tmp1 = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(src)), reinterpret_cast<const __m64*>(src + 4));
+    row1 = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(src + 8)), reinterpret_cast<const __m64*>(src + 12));
+    row0 = _mm_shuffle_ps(tmp1, row1, 0x88);
+    row1 = _mm_shuffle_ps(row1, tmp1, 0xDD);
+    tmp1 = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(src + 2)), reinterpret_cast<const __m64*>(src + 6));
+    row3 = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(src + 10)), reinterpret_cast<const __m64*>(src + 14));
+    row2 = _mm_shuffle_ps(tmp1, row3, 0x88);
+    row3 = _mm_shuffle_ps(row3, tmp1, 0xDD);
+
+    tmp1 = _mm_mul_ps(row2, row3);
+    tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0xB1);
+    minor0 = _mm_mul_ps(row1, tmp1);
+    minor1 = _mm_mul_ps(row0, tmp1);
+    tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0x4E);
+    minor0 = _mm_sub_ps(_mm_mul_ps(row1, tmp1), minor0);
+    minor1 = _mm_sub_ps(_mm_mul_ps(row0, tmp1), minor1);
+    minor1 = _mm_shuffle_ps(minor1, minor1, 0x4E);
+
+    tmp1 = _mm_mul_ps(row1, row2);
+    tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0xB1);
+    minor0 = _mm_add_ps(_mm_mul_ps(row3, tmp1), minor0);
+    minor3 = _mm_mul_ps(row0, tmp1);
+    tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0x4E);
+    minor0 = _mm_sub_ps(minor0, _mm_mul_ps(row3, tmp1));
+    minor3 = _mm_sub_ps(_mm_mul_ps(row0, tmp1), minor3);
+    minor3 = _mm_shuffle_ps(minor3, minor3, 0x4E);
+
+    tmp1 = _mm_mul_ps(_mm_shuffle_ps(row1, row1, 0x4E), row3);
+    tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0xB1);
+    row2 = _mm_shuffle_ps(row2, row2, 0x4E);
+    minor0 = _mm_add_ps(_mm_mul_ps(row2, tmp1), minor0);
+    minor2 = _mm_mul_ps(row0, tmp1);
+    tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0x4E);
+    minor0 = _mm_sub_ps(minor0, _mm_mul_ps(row2, tmp1));
+    minor2 = _mm_sub_ps(_mm_mul_ps(row0, tmp1), minor2);
+    minor2 = _mm_shuffle_ps(minor2, minor2, 0x4E);
+
+    tmp1 = _mm_mul_ps(row0, row1);
+    tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0xB1);
+    minor2 = _mm_add_ps(_mm_mul_ps(row3, tmp1), minor2);
+    minor3 = _mm_sub_ps(_mm_mul_ps(row2, tmp1), minor3);
+    tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0x4E);
+    minor2 = _mm_sub_ps(_mm_mul_ps(row3, tmp1), minor2);
+    minor3 = _mm_sub_ps(minor3, _mm_mul_ps(row2, tmp1));
+
+    tmp1 = _mm_mul_ps(row0, row3);
+    tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0xB1);
+    minor1 = _mm_sub_ps(minor1, _mm_mul_ps(row2, tmp1));
+    minor2 = _mm_add_ps(_mm_mul_ps(row1, tmp1), minor2);
+    tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0x4E);
+    minor1 = _mm_add_ps(_mm_mul_ps(row2, tmp1), minor1);
+    minor2 = _mm_sub_ps(minor2, _mm_mul_ps(row1, tmp1));
+
+    tmp1 = _mm_mul_ps(row0, row2);
+    tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0xB1);
+    minor1 = _mm_add_ps(_mm_mul_ps(row3, tmp1), minor1);
+    minor3 = _mm_sub_ps(minor3, _mm_mul_ps(row1, tmp1));
+    tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0x4E);
+    minor1 = _mm_sub_ps(minor1, _mm_mul_ps(row3, tmp1));
+    minor3 = _mm_add_ps(_mm_mul_ps(row1, tmp1), minor3);
+
+    // Determinant. A full precision divide is used instead of the
+    // reciprocal approximation in the original application note.
+    det = _mm_mul_ps(row0, minor0);
+    det = _mm_add_ps(_mm_shuffle_ps(det, det, 0x4E), det);
+    det = _mm_add_ss(_mm_shuffle_ps(det, det, 0xB1), det);
+
+    float d = _mm_cvtss_f32(det);
+
+    if (Math::closeEnough(d, 0.0f))
+        return false;
+
+    det = _mm_set1_ps(1.0f / d);
+
+    _mm_storeu_ps(result[0], _mm_mul_ps(det, minor0));
+    _mm_storeu_ps(result[1], _mm_mul_ps(det, minor1));
+    _mm_storeu_ps(result[2], _mm_mul_ps(det, minor2));
+    _mm_storeu_ps(result[3], _mm_mul_ps(det, minor3));
+
+    return true;
+}
+#endif
+
+template <typename T>
+static bool inverseGeneral(const Matrix4T<T> &m, Matrix4T<T> &result)
+{
+    if (ScalarMath<T>::closeEnough(m.determinant(), T(0)))
+        return false;
+
+    result = m.inverse();
+    return true;
+}
+
+template <typename T>
+bool Matrix4T<T>::inverseGeneral(Matrix4T<T> &result) const
+{
+    // Inverts an arbitrary 4x4 matrix using Cramer's rule. Unlike
+    // inverse(), a singular matrix is reported by returning false rather
+    // than by returning the identity matrix. 'result' is left unmodified
+    // when the matrix is singular. 'result' may alias this matrix.
+    //
+    // An SSE version is used for float when SSE is available.
+
+    return ::inverseGeneral(*this, result);
+}
+
+template <typename T>
+Matrix4T<T> Matrix4T<T>::inverseRigid() const
+{
+    // Inverts a rigid body transform matrix. The upper 3x3 part of the
+    // matrix must be orthonormal (i.e., a pure rotation) and the last
+    // column must be (0, 0, 0, 1). This is the common case for view and
+    // model matrices. The inverse of such a matrix always exists:
+    //
+    //     | R  0 |            | R^T      0 |
+    // M = |      |     M^-1 = |            |
+    //     | t  1 |            | -tR^T    1 |
+
+    T tx = mtx[3][0];
+    T ty = mtx[3][1];
+    T tz = mtx[3][2];
+
+    return Matrix4T<T>(
+        mtx[0][0], mtx[1][0], mtx[2][0], T(0),
+        mtx[0][1], mtx[1][1], mtx[2][1], T(0),
+        mtx[0][2], mtx[1][2], mtx[2][2], T(0),
+        -(tx * mtx[0][0] + ty * mtx[0][1] + tz * mtx[0][2]),
+        -(tx * mtx[1][0] + ty * mtx[1][1] + tz * mtx[1][2]),
+        -(tx * mtx[2][0] + ty * mtx[2][1] + tz * mtx[2][2]),
+        T(1));
+}
+
+template <typename T>
+void Matrix4T<T>::orient(const Vector3T<T> &from, const Vector3T<T> &to)
 {
     // Creates an orientation matrix that will rotate the vector 'from' 
     // into the vector 'to'. For this method to work correctly, vector
@@ -428,9 +746,9 @@ void Matrix4::orient(const Vector3 &from, const Vector3 &to)
     //   to rotate one vector to another," Journal of Graphics Tools,
     //   4(4):1-4, 1999.
 
-    float e = Vector3::dot(from, to);
+    T e = Vector3T<T>::dot(from, to);
 
-    if (Math::closeEnough(e, 1.0f))
+    if (ScalarMath<T>::closeEnough(e, T(1)))
     {
         // Special case where 'from' is equal to 'to'. In other words,
         // the angle between vector 'from' and vector 'to' is zero 
@@ -438,7 +756,7 @@ void Matrix4::orient(const Vector3 &from, const Vector3 &to)
 
         identity();
     }
-    else if (Math::closeEnough(e, -1.0f))
+    else if (ScalarMath<T>::closeEnough(e, -T(1)))
     {
         // Special case where 'from' is directly opposite to 'to'. In
         // other words, the angle between vector 'from' and vector 'to'
@@ -456,32 +774,32 @@ void Matrix4::orient(const Vector3 &from, const Vector3 &to)
         // | -FxFz+UxUz-SxSz  -FyFz+UyUz-SySz  -FzFz+UzUz-SzSz  0 |
         // |       0                 0                0         1 |
 
-        Vector3 side(0.0f, from.z, -from.y);
+        Vector3T<T> side(T(0), from.z, -from.y);
 
-        if (Math::closeEnough(Vector3::dot(side, side), 0.0f))
-            side.set(-from.z, 0.0f, from.x);
+        if (ScalarMath<T>::closeEnough(Vector3T<T>::dot(side, side), T(0)))
+            side.set(-from.z, T(0), from.x);
 
         side.normalize();
 
-        Vector3 up = Vector3::cross(side, from);
+        Vector3T<T> up = Vector3T<T>::cross(side, from);
         up.normalize();
 
         mtx[0][0] = -(from.x * from.x) + (up.x * up.x) - (side.x * side.x);
         mtx[0][1] = -(from.x * from.y) + (up.x * up.y) - (side.x * side.y);
         mtx[0][2] = -(from.x * from.z) + (up.x * up.z) - (side.x * side.z);
-        mtx[0][3] = 0.0f;
+        mtx[0][3] = T(0);
         mtx[1][0] = -(from.x * from.y) + (up.x * up.y) - (side.x * side.y);
         mtx[1][1] = -(from.y * from.y) + (up.y * up.y) - (side.y * side.y);
         mtx[1][2] = -(from.y * from.z) + (up.y * up.z) - (side.y * side.z);
-        mtx[1][3] = 0.0f;
+        mtx[1][3] = T(0);
         mtx[2][0] = -(from.x * from.z) + (up.x * up.z) - (side.x * side.z);
         mtx[2][1] = -(from.y * from.z) + (up.y * up.z) - (side.y * side.z);
         mtx[2][2] = -(from.z * from.z) + (up.z * up.z) - (side.z * side.z);
-        mtx[2][3] = 0.0f;
-        mtx[3][0] = 0.0f;
-        mtx[3][1] = 0.0f;
-        mtx[3][2] = 0.0f;
-        mtx[3][3] = 1.0f;
+        mtx[2][3] = T(0);
+        mtx[3][0] = T(0);
+        mtx[3][1] = T(0);
+        mtx[3][2] = T(0);
+        mtx[3][3] = T(1);
     }
     else
     {
@@ -497,34 +815,35 @@ void Matrix4::orient(const Vector3 &from, const Vector3 &to)
         //   E = from.dot(to)
         //   H = (1 - E) / V.dot(V)
 
-        Vector3 v = Vector3::cross(from, to);
+        Vector3T<T> v = Vector3T<T>::cross(from, to);
         v.normalize();
 
-        float h = (1.0f - e) / Vector3::dot(v, v);
+        T h = (T(1) - e) / Vector3T<T>::dot(v, v);
 
         mtx[0][0] = e + h * v.x * v.x;
         mtx[0][1] = h * v.x * v.y + v.z;
         mtx[0][2] = h * v.x * v.z - v.y;
-        mtx[0][3] = 0.0f;
+        mtx[0][3] = T(0);
 
         mtx[1][0] = h * v.x * v.y - v.z;
         mtx[1][1] = e + h * v.y * v.y;
         mtx[1][2] = h * v.x * v.z + v.x;
-        mtx[1][3] = 0.0f;
+        mtx[1][3] = T(0);
 
         mtx[2][0] = h * v.x * v.z + v.y;
         mtx[2][1] = h * v.y * v.z - v.x;
         mtx[2][2] = e + h * v.z * v.z;
-        mtx[2][3] = 0.0f;
+        mtx[2][3] = T(0);
 
-        mtx[3][0] = 0.0f;
-        mtx[3][1] = 0.0f;
-        mtx[3][2] = 0.0f;
-        mtx[3][3] = 1.0f;
+        mtx[3][0] = T(0);
+        mtx[3][1] = T(0);
+        mtx[3][2] = T(0);
+        mtx[3][3] = T(1);
     }
 }
 
-void Matrix4::rotate(const Vector3 &axis, float degrees)
+template <typename T>
+void Matrix4T<T>::rotate(const Vector3T<T> &axis, T degrees)
 {
     // Creates a rotation matrix about the specified axis.
     // The axis must be a unit vector. The angle must be in degrees.
@@ -540,36 +859,38 @@ void Matrix4::rotate(const Vector3 &axis, float degrees)
     //	c = cos(angle)
     //  s = sin(angle)
 
-    degrees = Math::degreesToRadians(degrees);
+    degrees = ScalarMath<T>::degreesToRadians(degrees);
+
+    T x = axis.x;
+    T y = axis.y;
+    T z = axis.z;
+    T c, s;
 
-    float x = axis.x;
-    float y = axis.y;
-    float z = axis.z;
-    float c = cosf(degrees);
-    float s = sinf(degrees);
+    ScalarMath<T>::sinCos(degrees, s, c);
 
-    mtx[0][0] = (x * x) * (1.0f - c) + c;
-    mtx[0][1] = (x * y) * (1.0f - c) + (z * s);
-    mtx[0][2] = (x * z) * (1.0f - c) - (y * s);
-    mtx[0][3] = 0.0f;
+    mtx[0][0] = (x * x) * (T(1) - c) + c;
+    mtx[0][1] = (x * y) * (T(1) - c) + (z * s);
+    mtx[0][2] = (x * z) * (T(1) - c) - (y * s);
+    mtx[0][3] = T(0);
 
-    mtx[1][0] = (y * x) * (1.0f - c) - (z * s);
-    mtx[1][1] = (y * y) * (1.0f - c) + c;
-    mtx[1][2] = (y * z) * (1.0f - c) + (x * s);
-    mtx[1][3] = 0.0f;
+    mtx[1][0] = (y * x) * (T(1) - c) - (z * s);
+    mtx[1][1] = (y * y) * (T(1) - c) + c;
+    mtx[1][2] = (y * z) * (T(1) - c) + (x * s);
+    mtx[1][3] = T(0);
 
-    mtx[2][0] = (z * x) * (1.0f - c) + (y * s);
-    mtx[2][1] = (z * y) * (1.0f - c) - (x * s);
-    mtx[2][2] = (z * z) * (1.0f - c) + c;
-    mtx[2][3] = 0.0f;
+    mtx[2][0] = (z * x) * (T(1) - c) + (y * s);
+    mtx[2][1] = (z * y) * (T(1) - c) - (x * s);
+    mtx[2][2] = (z * z) * (T(1) - c) + c;
+    mtx[2][3] = T(0);
 
-    mtx[3][0] = 0.0f;
-    mtx[3][1] = 0.0f;
-    mtx[3][2] = 0.0f;
-    mtx[3][3] = 1.0f;
+    mtx[3][0] = T(0);
+    mtx[3][1] = T(0);
+    mtx[3][2] = T(0);
+    mtx[3][3] = T(1);
 }
 
-void Matrix4::scale(float sx, float sy, float sz)
+template <typename T>
+void Matrix4T<T>::scale(T sx, T sy, T sz)
 {
     // Creates a scaling matrix.
     //
@@ -578,13 +899,14 @@ void Matrix4::scale(float sx, float sy, float sz)
     //                 | 0    0    sz   0 |
     //                 | 0    0    0    1 |
 
-    mtx[0][0] = sx,   mtx[0][1] = 0.0f, mtx[0][2] = 0.0f, mtx[0][3] = 0.0f;
-    mtx[1][0] = 0.0f, mtx[1][1] = sy,   mtx[1][2] = 0.0f, mtx[1][3] = 0.0f;
-    mtx[2][0] = 0.0f, mtx[2][1] = 0.0f, mtx[2][2] = sz,   mtx[2][3] = 0.0f;
-    mtx[3][0] = 0.0f, mtx[3][1] = 0.0f, mtx[3][2] = 0.0f, mtx[3][3] = 1.0f;
+    mtx[0][0] = sx,   mtx[0][1] = T(0), mtx[0][2] = T(0), mtx[0][3] = T(0);
+    mtx[1][0] = T(0), mtx[1][1] = sy,   mtx[1][2] = T(0), mtx[1][3] = T(0);
+    mtx[2][0] = T(0), mtx[2][1] = T(0), mtx[2][2] = sz,   mtx[2][3] = T(0);
+    mtx[3][0] = T(0), mtx[3][1] = T(0), mtx[3][2] = T(0), mtx[3][3] = T(1);
 }
 
-void Matrix4::toHeadPitchRoll(float &headDegrees, float &pitchDegrees, float &rollDegrees) const
+template <typename T>
+void Matrix4T<T>::toHeadPitchRoll(T &headDegrees, T &pitchDegrees, T &rollDegrees) const
 {
     // Extracts the Euler angles from a rotation matrix. The returned
     // angles are in degrees. This method might suffer from numerical
@@ -598,37 +920,38 @@ void Matrix4::toHeadPitchRoll(float &headDegrees, float &pitchDegrees, float &ro
     //  David Eberly, "Euler Angle Formulas", Geometric Tools web site,
     //  http://www.geometrictools.com/Documentation/EulerAngles.pdf.
 
-    float thetaX = asinf(mtx[1][2]);
-    float thetaY = 0.0f;
-    float thetaZ = 0.0f;
+    T thetaX = ScalarMath<T>::asin(mtx[1][2]);
+    T thetaY = T(0);
+    T thetaZ = T(0);
 
-    if (thetaX < Math::HALF_PI)
+    if (thetaX < ScalarMath<T>::halfPi())
     {
-        if (thetaX > -Math::HALF_PI)
+        if (thetaX > -ScalarMath<T>::halfPi())
         {
-            thetaZ = atan2f(-mtx[1][0], mtx[1][1]);
-            thetaY = atan2f(-mtx[0][2], mtx[2][2]);
+            thetaZ = ScalarMath<T>::atan2(-mtx[1][0], mtx[1][1]);
+            thetaY = ScalarMath<T>::atan2(-mtx[0][2], mtx[2][2]);
         }
         else
         {
             // Not a unique solution.
-            thetaZ = -atan2f(mtx[2][0], mtx[0][0]);
-            thetaY = 0.0f;
+            thetaZ = -ScalarMath<T>::atan2(mtx[2][0], mtx[0][0]);
+            thetaY = T(0);
         }
     }
     else
     {
         // Not a unique solution.
-        thetaZ = atan2f(mtx[2][0], mtx[0][0]);
-        thetaY = 0.0f;
+        thetaZ = ScalarMath<T>::atan2(mtx[2][0], mtx[0][0]);
+        thetaY = T(0);
     }
 
-    headDegrees = Math::radiansToDegrees(thetaY);
-    pitchDegrees = Math::radiansToDegrees(thetaX);
-    rollDegrees = Math::radiansToDegrees(thetaZ);
+    headDegrees = ScalarMath<T>::radiansToDegrees(thetaY);
+    pitchDegrees = ScalarMath<T>::radiansToDegrees(thetaX);
+    rollDegrees = ScalarMath<T>::radiansToDegrees(thetaZ);
 }
 
-void Matrix4::translate(float tx, float ty, float tz)
+template <typename T>
+void Matrix4T<T>::translate(T tx, T ty, T tz)
 {
     // Creates a translation matrix.
     //
@@ -637,18 +960,20 @@ void Matrix4::translate(float tx, float ty, float tz)
     //                 | 0    0    1    0 |
     //                 | tx   ty   tz   1 |
 
-    mtx[0][0] = 1.0f, mtx[0][1] = 0.0f, mtx[0][2] = 0.0f, mtx[0][3] = 0.0f;
-    mtx[1][0] = 0.0f, mtx[1][1] = 1.0f, mtx[1][2] = 0.0f, mtx[1][3] = 0.0f;
-    mtx[2][0] = 0.0f, mtx[2][1] = 0.0f, mtx[2][2] = 1.0f, mtx[2][3] = 0.0f;
-    mtx[3][0] = tx,   mtx[3][1] = ty,   mtx[3][2] = tz,   mtx[3][3] = 1.0f;
+    mtx[0][0] = T(1), mtx[0][1] = T(0), mtx[0][2] = T(0), mtx[0][3] = T(0);
+    mtx[1][0] = T(0), mtx[1][1] = T(1), mtx[1][2] = T(0), mtx[1][3] = T(0);
+    mtx[2][0] = T(0), mtx[2][1] = T(0), mtx[2][2] = T(1), mtx[2][3] = T(0);
+    mtx[3][0] = tx,   mtx[3][1] = ty,   mtx[3][2] = tz,   mtx[3][3] = T(1);
 }
 
+template class Matrix4T<float>;
+template class Matrix4T<double>;
+
 //-----------------------------------------------------------------------------
 // Quaternion.
 
-const Quaternion Quaternion::IDENTITY(1.0f, 0.0f, 0.0f, 0.0f);
-
-Quaternion Quaternion::slerp(const Quaternion &a, const Quaternion &b, float t)
+template <typename T>
+QuaternionT<T> QuaternionT<T>::slerp(const QuaternionT<T> &a, const QuaternionT<T> &b, T t)
 {
     // Smoothly interpolates from quaternion 'a' to quaternion 'b' using
     // spherical linear interpolation.
@@ -664,29 +989,29 @@ Quaternion Quaternion::slerp(const Quaternion &a, const Quaternion &b, float t)
     // The algorithm used is adapted from Allan and Mark Watt's "Advanced
     // Animation and Rendering Techniques" (ACM Press 1992).
 
-    Quaternion result;
-    float omega = 0.0f;
-    float cosom = (a.x * b.x) + (a.y * b.y) + (a.z * b.z) + (a.w * b.w);
-    float sinom = 0.0f;
-    float scale0 = 0.0f;
-    float scale1 = 0.0f;
+    QuaternionT<T> result;
+    T omega = T(0);
+    T cosom = (a.x * b.x) + (a.y * b.y) + (a.z * b.z) + (a.w * b.w);
+    T sinom = T(0);
+    T scale0 = T(0);
+    T scale1 = T(0);
         
-    if ((1.0f + cosom) > Math::EPSILON)
+    if ((T(1) + cosom) > ScalarMath<T>::epsilon())
     {
         // 'a' and 'b' quaternions are not opposite each other.
 
-        if ((1.0f - cosom) > Math::EPSILON)
+        if ((T(1) - cosom) > ScalarMath<T>::epsilon())
         {
             // Standard case - slerp.
-            omega = acosf(cosom);
-            sinom = sinf(omega);
-            scale0 = sinf((1.0f - t) * omega) / sinom;
-            scale1 = sinf(t * omega) / sinom;
+            omega = ScalarMath<T>::acos(cosom);
+            sinom = ScalarMath<T>::sin(omega);
+            scale0 = ScalarMath<T>::sin((T(1) - t) * omega) / sinom;
+            scale1 = ScalarMath<T>::sin(t * omega) / sinom;
         }
         else
         {
             // 'a' and 'b' quaternions are very close so lerp instead.
-            scale0 = 1.0f - t;
+            scale0 = T(1) - t;
             scale1 = t;
         }
 
@@ -704,8 +1029,8 @@ Quaternion Quaternion::slerp(const Quaternion &a, const Quaternion &b, float t)
         result.z = -b.w;
         result.w = b.z;
         
-        scale0 = sinf((1.0f - t) - Math::HALF_PI);
-        scale1 = sinf(t * Math::HALF_PI);
+        scale0 = ScalarMath<T>::sin((T(1) - t) - ScalarMath<T>::halfPi());
+        scale1 = ScalarMath<T>::sin(t * ScalarMath<T>::halfPi());
 
         result.x = scale0 * a.x + scale1 * result.x;
         result.y = scale0 * a.y + scale1 * result.y;
@@ -716,21 +1041,22 @@ Quaternion Quaternion::slerp(const Quaternion &a, const Quaternion &b, float t)
     return result;
 }
 
-void Quaternion::fromMatrix(const Matrix3 &m)
+template <typename T>
+void QuaternionT<T>::fromMatrix(const Matrix3T<T> &m)
 {
     // Creates a quaternion from a rotation matrix. 
     // The algorithm used is from Allan and Mark Watt's "Advanced 
     // Animation and Rendering Techniques" (ACM Press 1992).
 
-    float s = 0.0f;
-    float q[4] = {0.0f};
-    float trace = m[0][0] + m[1][1] + m[2][2];
+    T s = T(0);
+    T q[4] = {T(0)};
+    T trace = m[0][0] + m[1][1] + m[2][2];
 
-    if (trace > 0.0f)
+    if (trace > T(0))
     {
-        s = sqrtf(trace + 1.0f);
-        q[3] = s * 0.5f;
-        s = 0.5f / s;
+        s = ScalarMath<T>::sqrt(trace + T(1));
+        q[3] = s * T(0.5);
+        s = T(0.5) / s;
         q[0] = (m[1][2] - m[2][1]) * s;
         q[1] = (m[2][0] - m[0][2]) * s;
         q[2] = (m[0][1] - m[1][0]) * s;
@@ -748,10 +1074,10 @@ void Quaternion::fromMatrix(const Matrix3 &m)
 
         j = nxt[i];
         k = nxt[j];
-        s = sqrtf((m[i][i] - (m[j][j] + m[k][k])) + 1.0f);
+        s = ScalarMath<T>::sqrt((m[i][i] - (m[j][j] + m[k][k])) + T(1));
 
-        q[i] = s * 0.5f;
-        s = 0.5f / s;
+        q[i] = s * T(0.5);
+        s = T(0.5) / s;
         q[3] = (m[j][k] - m[k][j]) * s;
         q[j] = (m[i][j] + m[j][i]) * s;
         q[k] = (m[i][k] + m[k][i]) * s;
@@ -760,21 +1086,22 @@ void Quaternion::fromMatrix(const Matrix3 &m)
     x = q[0], y = q[1], z = q[2], w = q[3];
 }
 
-void Quaternion::fromMatrix(const Matrix4 &m)
+template <typename T>
+void QuaternionT<T>::fromMatrix(const Matrix4T<T> &m)
 {
     // Creates a quaternion from a rotation matrix. 
     // The algorithm used is from Allan and Mark Watt's "Advanced 
     // Animation and Rendering Techniques" (ACM Press 1992).
 
-    float s = 0.0f;
-    float q[4] = {0.0f};
-    float trace = m[0][0] + m[1][1] + m[2][2];
+    T s = T(0);
+    T q[4] = {T(0)};
+    T trace = m[0][0] + m[1][1] + m[2][2];
 
-    if (trace > 0.0f)
+    if (trace > T(0))
     {
-        s = sqrtf(trace + 1.0f);
-        q[3] = s * 0.5f;
-        s = 0.5f / s;
+        s = ScalarMath<T>::sqrt(trace + T(1));
+        q[3] = s * T(0.5);
+        s = T(0.5) / s;
         q[0] = (m[1][2] - m[2][1]) * s;
         q[1] = (m[2][0] - m[0][2]) * s;
         q[2] = (m[0][1] - m[1][0]) * s;
@@ -792,10 +1119,10 @@ void Quaternion::fromMatrix(const Matrix4 &m)
 
         j = nxt[i];
         k = nxt[j];
-        s = sqrtf((m[i][i] - (m[j][j] + m[k][k])) + 1.0f);
+        s = ScalarMath<T>::sqrt((m[i][i] - (m[j][j] + m[k][k])) + T(1));
 
-        q[i] = s * 0.5f;
-        s = 0.5f / s;
+        q[i] = s * T(0.5);
+        s = T(0.5) / s;
         q[3] = (m[j][k] - m[k][j]) * s;
         q[j] = (m[i][j] + m[j][i]) * s;
         q[k] = (m[i][k] + m[k][i]) * s;
@@ -804,30 +1131,32 @@ void Quaternion::fromMatrix(const Matrix4 &m)
     x = q[0], y = q[1], z = q[2], w = q[3];
 }
 
-void Quaternion::toAxisAngle(Vector3 &axis, float &degrees) const
+template <typename T>
+void QuaternionT<T>::toAxisAngle(Vector3T<T> &axis, T &degrees) const
 {
     // Converts this quaternion to an axis and an angle.
 
-    float sinHalfThetaSq = 1.0f - w * w;
+    T sinHalfThetaSq = T(1) - w * w;
 
     // Guard against numerical imprecision and identity quaternions.
-    if (sinHalfThetaSq <= 0.0f)
+    if (sinHalfThetaSq <= T(0))
     {
-        axis.x = 1.0f, axis.y = axis.z = 0.0f;
-        degrees = 0.0f;
+        axis.x = T(1), axis.y = axis.z = T(0);
+        degrees = T(0);
     }
     else
     {
-        float invSinHalfTheta = 1.0f / sqrtf(sinHalfThetaSq);
+        T invSinHalfTheta = ScalarMath<T>::rsqrt(sinHalfThetaSq);
 
         axis.x = x * invSinHalfTheta;
         axis.y = y * invSinHalfTheta;
         axis.z = z * invSinHalfTheta;
-        degrees = Math::radiansToDegrees(2.0f * acosf(w));
+        degrees = ScalarMath<T>::radiansToDegrees(T(2) * ScalarMath<T>::acos(w));
     }
 }
 
-Matrix3 Quaternion::toMatrix3() const
+template <typename T>
+Matrix3T<T> QuaternionT<T>::toMatrix3() const
 {
     // Converts this quaternion to a rotation matrix.
     //
@@ -835,37 +1164,38 @@ Matrix3 Quaternion::toMatrix3() const
     //  | 2(xy - wz)		1 - 2(x^2 + z^2)	2(yz + wx)		 |
     //  | 2(xz + wy)		2(yz - wx)			1 - 2(x^2 + y^2) |
 
-    float x2 = x + x;
-    float y2 = y + y;
-    float z2 = z + z;
-    float xx = x * x2;
-    float xy = x * y2;
-    float xz = x * z2;
-    float yy = y * y2;
-    float yz = y * z2;
-    float zz = z * z2;
-    float wx = w * x2;
-    float wy = w * y2;
-    float wz = w * z2;
-
-    Matrix3 m;
-
-    m[0][0] = 1.0f - (yy + zz);
+    T x2 = x + x;
+    T y2 = y + y;
+    T z2 = z + z;
+    T xx = x * x2;
+    T xy = x * y2;
+    T xz = x * z2;
+    T yy = y * y2;
+    T yz = y * z2;
+    T zz = z * z2;
+    T wx = w * x2;
+    T wy = w * y2;
+    T wz = w * z2;
+
+    Matrix3T<T> m;
+
+    m[0][0] = T(1) - (yy + zz);
     m[0][1] = xy + wz;
     m[0][2] = xz - wy;
 
     m[1][0] = xy - wz;
-    m[1][1] = 1.0f - (xx + zz);
+    m[1][1] = T(1) - (xx + zz);
     m[1][2] = yz + wx;
 
     m[2][0] = xz + wy;
     m[2][1] = yz - wx;
-    m[2][2] = 1.0f - (xx + yy);
+    m[2][2] = T(1) - (xx + yy);
 
     return m;
 }
 
-Matrix4 Quaternion::toMatrix4() const
+template <typename T>
+Matrix4T<T> QuaternionT<T>::toMatrix4() const
 {
     // Converts this quaternion to a rotation matrix.
     //
@@ -874,44 +1204,47 @@ Matrix4 Quaternion::toMatrix4() const
     //  | 2(xz + wy)		2(yz - wx)			1 - 2(x^2 + y^2)	0  |
     //  | 0					0					0					1  |
 
-    float x2 = x + x; 
-    float y2 = y + y; 
-    float z2 = z + z;
-    float xx = x * x2;
-    float xy = x * y2;
-    float xz = x * z2;
-    float yy = y * y2;
-    float yz = y * z2;
-    float zz = z * z2;
-    float wx = w * x2;
-    float wy = w * y2;
-    float wz = w * z2;
-
-    Matrix4 m;
-
-    m[0][0] = 1.0f - (yy + zz);
+    T x2 = x + x; 
+    T y2 = y + y; 
+    T z2 = z + z;
+    T xx = x * x2;
+    T xy = x * y2;
+    T xz = x * z2;
+    T yy = y * y2;
+    T yz = y * z2;
+    T zz = z * z2;
+    T wx = w * x2;
+    T wy = w * y2;
+    T wz = w * z2;
+
+    Matrix4T<T> m;
+
+    m[0][0] = T(1) - (yy + zz);
     m[0][1] = xy + wz;
     m[0][2] = xz - wy;
-    m[0][3] = 0.0f;
+    m[0][3] = T(0);
 
     m[1][0] = xy - wz;
-    m[1][1] = 1.0f - (xx + zz);
+    m[1][1] = T(1) - (xx + zz);
     m[1][2] = yz + wx;
-    m[1][3] = 0.0f;
+    m[1][3] = T(0);
 
     m[2][0] = xz + wy;
     m[2][1] = yz - wx;
-    m[2][2] = 1.0f - (xx + yy);
-    m[2][3] = 0.0f;
+    m[2][2] = T(1) - (xx + yy);
+    m[2][3] = T(0);
 
-    m[3][0] = 0.0f;
-    m[3][1] = 0.0f;
-    m[3][2] = 0.0f;
-    m[3][3] = 1.0f;
+    m[3][0] = T(0);
+    m[3][1] = T(0);
+    m[3][2] = T(0);
+    m[3][3] = T(1);
 
     return m;
 }
 
+template class QuaternionT<float>;
+template class QuaternionT<double>;
+
 //-----------------------------------------------------------------------------
 // MatrixStack.
 
@@ -1011,4 +1344,307 @@ void MatrixStack::init(unsigned int maxDepth)
 	{
 		m_lastError = ERROR_INVALID_VALUE;
 	}
-}
\ No newline at end of file
+}
+
+//-----------------------------------------------------------------------------
+// MatrixArena.
+
+MatrixArena::MatrixArena(unsigned int maxMatrices)
+{
+    m_pBlock = static_cast<Matrix4 *>(::operator new(maxMatrices * sizeof(Matrix4), std::nothrow));
+    m_capacity = m_pBlock ? maxMatrices : 0;
+    m_used = 0;
+}
+
+MatrixArena::~MatrixArena()
+{
+    ::operator delete(m_pBlock);
+    m_pBlock = 0;
+}
+
+Matrix4 *MatrixArena::allocate(unsigned int count)
+{
+    if (count > m_capacity - m_used)
+        return 0;
+
+    Matrix4 *p = m_pBlock + m_used;
+    m_used += count;
+    return p;
+}
+
+void MatrixArena::deallocate(Matrix4 *p, unsigned int count)
+{
+    // Only the most recent allocation can be handed back. Anything else is
+    // reclaimed by reset().
+
+    if (p + count == m_pBlock + m_used)
+        m_used -= count;
+}
+
+unsigned int MatrixArena::capacity() const
+{
+    return m_capacity;
+}
+
+void MatrixArena::reset()
+{
+    m_used = 0;
+}
+
+unsigned int MatrixArena::used() const
+{
+    return m_used;
+}
+
+//-----------------------------------------------------------------------------
+// Random.
+
+static unsigned long long splitMix64(unsigned long long &x)
+{
+    // SplitMix64 expands a single 64-bit seed into well mixed state words,
+    // as recommended by the xoshiro authors.
+
+    unsigned long long z = (x += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+static void jumpState(unsigned int s[4])
+{
+    // Advances one xoshiro128 state by 2^64 steps.
+
+    static const unsigned int JUMP[4] =
+    {
+        0x8764000b, 0xf542d2d3, 0x6fa035c3, 0x77f2db5b
+    };
+
+    unsigned int j[4] = { 0, 0, 0, 0 };
+
+    for (int i = 0; i < 4; ++i)
+    {
+        for (int b = 0; b < 32; ++b)
+        {
+            if (JUMP[i] & (1u << b))
+                j[0] ^= s[0], j[1] ^= s[1], j[2] ^= s[2], j[3] ^= s[3];
+
+            unsigned int t = s[1] << 9;
+
+            s[2] ^= s[0];
+            s[3] ^= s[1];
+            s[1] ^= s[2];
+            s[0] ^= s[3];
+            s[2] ^= t;
+            s[3] = (s[3] << 11) | (s[3] >> 21);
+        }
+    }
+
+    s[0] = j[0], s[1] = j[1], s[2] = j[2], s[3] = j[3];
+}
+
+Random::Random()
+{
+    seed(DEFAULT_SEED);
+}
+
+Random::Random(unsigned long long seed_)
+{
+    seed(seed_);
+}
+
+void Random::fill(float *values, unsigned int count)
+{
+    fill(values, count, 0.0f, 1.0f);
+}
+
+void Random::fill(float *values, unsigned int count, float min, float max)
+{
+    // Fills 'values' with random numbers in range [min,max). Each step of
+    // the loop advances all 8 xoshiro128+ lanes and produces 8 values in
+    // lane order. The top 24 bits of each lane's output are converted to a
+    // float in range [0,1) the same way as nextFloat().
+
+    const float scale = (max - min) * (1.0f / 16777216.0f);
+    unsigned int (*s)[LANES] = m_lanes;
+    float tail[LANES];
+    unsigned int i = 0;
+
+    while (i < count)
+    {
+        float *pOut = (count - i >= LANES) ? values + i : tail;
+
+#if defined(MATHLIB_AVX2)
+        __m256i s0 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s[0]));
+        __m256i s1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s[1]));
+        __m256i s2 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s[2]));
+        __m256i s3 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s[3]));
+        __m256i bits = _mm256_srli_epi32(_mm256_add_epi32(s0, s3), 8);
+        __m256i t = _mm256_slli_epi32(s1, 9);
+
+        s2 = _mm256_xor_si256(s2, s0);
+        s3 = _mm256_xor_si256(s3, s1);
+        s1 = _mm256_xor_si256(s1, s2);
+        s0 = _mm256_xor_si256(s0, s3);
+        s2 = _mm256_xor_si256(s2, t);
+        s3 = _mm256_or_si256(_mm256_slli_epi32(s3, 11), _mm256_srli_epi32(s3, 21));
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(s[0]), s0);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(s[1]), s1);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(s[2]), s2);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(s[3]), s3);
+
+        __m256 v = _mm256_mul_ps(_mm256_cvtepi32_ps(bits), _mm256_set1_ps(scale));
+        _mm256_storeu_ps(pOut, _mm256_add_ps(v, _mm256_set1_ps(min)));
+#elif defined(MATHLIB_SSE2)
+        for (int half = 0; half < LANES; half += 4)
+        {
+            __m128i s0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s[0] + half));
+            __m128i s1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s[1] + half));
+            __m128i s2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s[2] + half));
+            __m128i s3 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s[3] + half));
+            __m128i bits = _mm_srli_epi32(_mm_add_epi32(s0, s3), 8);
+            __m128i t = _mm_slli_epi32(s1, 9);
+
+            s2 = _mm_xor_si128(s2, s0);
+            s3 = _mm_xor_si128(s3, s1);
+            s1 = _mm_xor_si128(s1, s2);
+            s0 = _mm_xor_si128(s0, s3);
+            s2 = _mm_xor_si128(s2, t);
+            s3 = _mm_or_si128(_mm_slli_epi32(s3, 11), _mm_srli_epi32(s3, 21));
+
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(s[0] + half), s0);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(s[1] + half), s1);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(s[2] + half), s2);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(s[3] + half), s3);
+
+            __m128 v = _mm_mul_ps(_mm_cvtepi32_ps(bits), _mm_set1_ps(scale));
+            _mm_storeu_ps(pOut + half, _mm_add_ps(v, _mm_set1_ps(min)));
+        }
+#else
+        for (int lane = 0; lane < LANES; ++lane)
+        {
+            unsigned int bits = (s[0][lane] + s[3][lane]) >> 8;
+            unsigned int t = s[1][lane] << 9;
+
+            s[2][lane] ^= s[0][lane];
+            s[3][lane] ^= s[1][lane];
+            s[1][lane] ^= s[2][lane];
+            s[0][lane] ^= s[3][lane];
+            s[2][lane] ^= t;
+            s[3][lane] = (s[3][lane] << 11) | (s[3][lane] >> 21);
+
+            pOut[lane] = static_cast<float>(static_cast<int>(bits)) * scale + min;
+        }
+#endif
+
+        if (pOut == tail)
+        {
+            for (unsigned int j = 0; i < count; ++i, ++j)
+                values[i] = tail[j];
+        }
+        else
+        {
+            i += LANES;
+        }
+    }
+}
+
+Vector3 Random::inBox(const Vector3 &min, const Vector3 &max)
+{
+    // Returns a point uniformly distributed inside the axis aligned box
+    // [min,max).
+
+    float x = nextFloat(min.x, max.x);
+    float y = nextFloat(min.y, max.y);
+    float z = nextFloat(min.z, max.z);
+
+    return Vector3(x, y, z);
+}
+
+Vector3 Random::inSphere(float radius)
+{
+    // Returns a point uniformly distributed inside the sphere of the given
+    // radius centered at the origin. Points are drawn from the enclosing
+    // cube until one lands inside the sphere, which takes 1.9 tries on
+    // average.
+
+    Vector3 p;
+
+    do
+    {
+        p.x = nextFloat(-1.0f, 1.0f);
+        p.y = nextFloat(-1.0f, 1.0f);
+        p.z = nextFloat(-1.0f, 1.0f);
+    } while (p.magnitudeSq() > 1.0f);
+
+    return p * radius;
+}
+
+void Random::jump()
+{
+    // Jumps the nextUInt() generator and every fill() lane.
+
+    jumpState(m_state);
+
+    for (int lane = 0; lane < LANES; ++lane)
+    {
+        unsigned int s[4] = { m_lanes[0][lane], m_lanes[1][lane], m_lanes[2][lane], m_lanes[3][lane] };
+
+        jumpState(s);
+
+        for (int i = 0; i < 4; ++i)
+            m_lanes[i][lane] = s[i];
+    }
+}
+
+Vector3 Random::onSphere(float radius)
+{
+    // Returns a point uniformly distributed on the surface of the sphere
+    // of the given radius centered at the origin. By Archimedes' hat-box
+    // theorem 'z' is uniform in range [-1,1].
+
+    float z = nextFloat(-1.0f, 1.0f);
+    float r = sqrtf(1.0f - z * z);
+    float s, c;
+
+    Math::fastSinCos(nextFloat() * 6.28318531f, s, c);
+    return Vector3(r * c, r * s, z) * radius;
+}
+
+void Random::seed(unsigned long long seed)
+{
+    for (int i = 0; i < 4; i += 2)
+    {
+        unsigned long long z = splitMix64(seed);
+
+        m_state[i] = static_cast<unsigned int>(z);
+        m_state[i + 1] = static_cast<unsigned int>(z >> 32);
+    }
+
+    for (int lane = 0; lane < LANES; ++lane)
+    {
+        for (int i = 0; i < 4; i += 2)
+        {
+            unsigned long long z = splitMix64(seed);
+
+            m_lanes[i][lane] = static_cast<unsigned int>(z);
+            m_lanes[i + 1][lane] = static_cast<unsigned int>(z >> 32);
+        }
+    }
+}
+
+Quaternion Random::unitQuaternion()
+{
+    // Returns a uniformly distributed random rotation using Shoemake's
+    // subgroup algorithm [2].
+
+    float u1 = nextFloat();
+    float a = sqrtf(1.0f - u1);
+    float b = sqrtf(u1);
+    float s1, c1, s2, c2;
+
+    Math::fastSinCos(nextFloat() * 6.28318531f, s1, c1);
+    Math::fastSinCos(nextFloat() * 6.28318531f, s2, c2);
+
+    return Quaternion(b * c2, a * s1, a * c1, b * s2);
+}
@@ -25,6 +25,56 @@
 
 #include <cmath>
 #include <cstdlib>
+#include <cstring>
+#include <new>
+
+//-----------------------------------------------------------------------------
+// SIMD support.
+//
+// The SSE code paths are enabled whenever the compiler targets a processor
+// with SSE. The header has no AVX code of its own, so every translation unit
+// sees the same inline functions whatever it is compiled for; AVX versions
+// of hot loops, e.g., of Matrix4d products, are in Batch, which picks them
+// at run time. Define MATHLIB_NO_SIMD to force the portable scalar code
+// paths.
+
+#if !defined(MATHLIB_NO_SIMD)
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define MATHLIB_SSE
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MATHLIB_SSE2
+#endif
+#if defined(MATHLIB_SSE2) && defined(__AVX2__)
+#define MATHLIB_AVX2
+#endif
+#endif
+
+#if defined(MATHLIB_SSE)
+#include <xmmintrin.h>
+#endif
+
+//-----------------------------------------------------------------------------
+// Fast math support.
+//
+// Define MATHLIB_FAST_MATH to route the library's own trigonometry and
+// vector normalization through the fast approximations in the Math class
+// (see Math::fastSin() and friends). By default the C runtime functions are
+// used.
+
+#if defined(MATHLIB_FAST_MATH)
+#define MATHLIB_ACOSF(x)            Math::fastAcos(x)
+#define MATHLIB_ATAN2F(y, x)        Math::fastAtan2(y, x)
+#define MATHLIB_RSQRTF(x)           Math::fastRsqrt(x)
+#define MATHLIB_SINCOSF(x, s, c)    Math::fastSinCos(x, s, c)
+#define MATHLIB_SINF(x)             Math::fastSin(x)
+#else
+#define MATHLIB_ACOSF(x)            acosf(x)
+#define MATHLIB_ATAN2F(y, x)        atan2f(y, x)
+#define MATHLIB_RSQRTF(x)           (1.0f / sqrtf(x))
+#define MATHLIB_SINCOSF(x, s, c)    ((s) = sinf(x), (c) = cosf(x))
+#define MATHLIB_SINF(x)             sinf(x)
+#endif
 
 //-----------------------------------------------------------------------------
 // Classes.
@@ -32,11 +82,11 @@
 class Math
 {
 public:
-    static const float PI;
-    static const float HALF_PI;
-    static const float QUARTER_PI;
-    static const float TWO_PI;
-    static const float EPSILON;
+    static constexpr float PI = 3.1415926f;
+    static constexpr float HALF_PI = PI / 2.0f;
+    static constexpr float QUARTER_PI = PI / 4.0f;
+    static constexpr float TWO_PI = PI * 2.0f;
+    static constexpr float EPSILON = 1e-6f;
 
     template <typename T>
     static T bilerp(const T &a, const T &b, const T &c, const T &d, float u, float v)
@@ -65,7 +115,7 @@ public:
 
         rho = sqrtf((x * x) + (y * y) + (z * z));
         phi = asinf(y / rho);
-        theta = atan2f(z, x);
+        theta = MATHLIB_ATAN2F(z, x);
     }
 
     static bool closeEnough(float f1, float f2)
@@ -76,11 +126,258 @@ public:
         return fabsf((f1 - f2) / ((f2 == 0.0f) ? 1.0f : f2)) < EPSILON;
     }
 
-    static float degreesToRadians(float degrees)
+    static constexpr float degreesToRadians(float degrees)
     {
         return (degrees * PI) / 180.0f;
     }
 
+    // The fast* functions are polynomial approximations of the C runtime
+    // functions of the same name. The polynomials are the single precision
+    // minimax approximations from the Cephes math library by Stephen L.
+    // Moshier. Each function documents its input domain and its maximum
+    // error over that domain, measured against double precision results.
+    //
+    // The array forms apply the function to 'count' values. They process
+    // 8 values at a time with AVX2 and 4 values at a time with SSE2, and
+    // fall back to the scalar forms otherwise. The variant is picked at run
+    // time like the Batch functions (see batch.h), so it follows the CPU,
+    // MATHLIB_ISA and Batch::setIsa(). The AVX2 variant uses fused
+    // multiply-add, so its results may differ from the scalar forms in the
+    // last bits. The input and output arrays may be the same array.
+
+    static float fastAcos(float x)
+    {
+        // Approximates acosf(x). 'x' is clamped to the range [-1,1].
+        // Max absolute error: 3e-7 radians.
+        //
+        //  acos(x) = PI/2 - asin(x)              for |x| <= 0.5
+        //  acos(x) = 2 asin(sqrt((1 - x) / 2))   for x > 0.5
+        //  acos(x) = PI - acos(-x)               for x < -0.5
+
+        float a = fabsf(x);
+        float z, s;
+
+        if (a > 1.0f)
+            a = 1.0f;
+
+        if (a > 0.5f)
+            z = 0.5f * (1.0f - a), s = sqrtf(z);
+        else
+            z = a * a, s = a;
+
+        float p = ((((4.2163199048e-2f * z + 2.4181311049e-2f) * z
+            + 4.5470025998e-2f) * z + 7.4953002686e-2f) * z
+            + 1.6666752422e-1f) * z * s + s;
+
+        if (a > 0.5f)
+            return (x < 0.0f) ? 3.14159265f - 2.0f * p : 2.0f * p;
+        else
+            return 1.57079633f - ((x < 0.0f) ? -p : p);
+    }
+
+    static float fastAtan2(float y, float x)
+    {
+        // Approximates atan2f(y, x) for all finite 'y' and 'x'.
+        // fastAtan2(0, 0) returns 0.
+        // Max absolute error: 3e-7 radians.
+        //
+        // The ratio of the smaller to the larger of |x| and |y| is reduced
+        // to the range [0,tan(PI/8)] using atan(t) = PI/4 + atan((t-1)/(t+1)).
+
+        float ax = fabsf(x);
+        float ay = fabsf(y);
+        float t = (ax > ay) ? ay / ax : ((ay > 0.0f) ? ax / ay : 0.0f);
+        float r = 0.0f;
+
+        if (t > 0.41421356f)
+            t = (t - 1.0f) / (t + 1.0f), r = 0.78539816f;
+
+        float z = t * t;
+
+        r += (((8.05374449538e-2f * z - 1.38776856032e-1f) * z
+            + 1.99777106478e-1f) * z - 3.33329491539e-1f) * z * t + t;
+
+        if (ay > ax)
+            r = 1.57079633f - r;
+
+        if (x < 0.0f)
+            r = 3.14159265f - r;
+
+        return (y < 0.0f) ? -r : r;
+    }
+
+    static float fastCos(float x)
+    {
+        // Approximates cosf(x). See fastSinCos().
+
+        float s, c;
+        fastSinCos(x, s, c);
+        return c;
+    }
+
+    static float fastExp(float x)
+    {
+        // Approximates expf(x). 'x' is clamped to the range [-87.3,88].
+        // Max relative error: 1e-7.
+        //
+        // exp(x) = 2^n exp(r) where n = round(x / ln 2) and |r| <= ln(2)/2.
+        // ln 2 is split in two so that x - n ln 2 is computed exactly.
+
+        if (x > 88.0f)
+            x = 88.0f;
+        else if (x < -87.3f)
+            x = -87.3f;
+
+        float fn = x * 1.44269504f;
+        int n = static_cast<int>(fn + ((fn >= 0.0f) ? 0.5f : -0.5f));
+
+        fn = static_cast<float>(n);
+
+        float r = (x - fn * 0.693359375f) + fn * 2.12194440e-4f;
+        float p = (((((1.9875691500e-4f * r + 1.3981999507e-3f) * r
+            + 8.3334519073e-3f) * r + 4.1665795894e-2f) * r
+            + 1.6666665459e-1f) * r + 5.0000001201e-1f) * r * r + r + 1.0f;
+
+        int bits = (n + 127) << 23;
+        float scale;
+
+        memcpy(&scale, &bits, sizeof(scale));
+        return p * scale;
+    }
+
+    static float fastLog(float x)
+    {
+        // Approximates logf(x). 'x' must be positive and finite.
+        // Max error: 1e-7. The error is absolute where |logf(x)| <= 1
+        // and relative elsewhere.
+        //
+        // x = m 2^e where m is in the range [sqrt(1/2),sqrt(2)), and
+        // log(x) = log(m) + e ln 2. Denormals are scaled by 2^23 first.
+
+        int bias = 126;
+
+        if (x < 1.17549435e-38f)
+            x *= 8388608.0f, bias += 23;
+
+        int bits;
+        memcpy(&bits, &x, sizeof(bits));
+
+        int e = ((bits >> 23) & 0xff) - bias;
+        bits = (bits & 0x807fffff) | 0x3f000000;
+
+        float m;
+        memcpy(&m, &bits, sizeof(m));
+
+        if (m < 0.70710678f)
+            --e, m = m + m - 1.0f;
+        else
+            m = m - 1.0f;
+
+        float fe = static_cast<float>(e);
+        float z = m * m;
+        float y = ((((((((7.0376836292e-2f * m - 1.1514610310e-1f) * m
+            + 1.1676998740e-1f) * m - 1.2420140846e-1f) * m
+            + 1.4249322787e-1f) * m - 1.6668057665e-1f) * m
+            + 2.0000714765e-1f) * m - 2.4999993993e-1f) * m
+            + 3.3333331174e-1f) * m * z;
+
+        y += fe * -2.12194440e-4f - 0.5f * z;
+        return (m + y) + fe * 0.693359375f;
+    }
+
+    static float fastRsqrt(float x)
+    {
+        // Approximates 1 / sqrtf(x). 'x' must be positive and finite.
+        // Max relative error: 3e-7.
+        //
+        // The initial estimate comes from the SSE rsqrtss instruction (or
+        // the integer shift trick from Quake III on other processors) and
+        // is refined using the Newton-Raphson iteration:
+        //  y' = y (1.5 - 0.5 x y^2)
+        //
+        // rsqrtss reads denormals as 0, so they are scaled by 2^24 first
+        // and the result by 2^12.
+
+        float scale = 1.0f;
+
+        if (x < 1.17549435e-38f)
+            x *= 16777216.0f, scale = 4096.0f;
+
+#if defined(MATHLIB_SSE)
+        float y = _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(x)));
+        return y * (1.5f - 0.5f * x * y * y) * scale;
+#else
+        int bits;
+        memcpy(&bits, &x, sizeof(bits));
+        bits = 0x5f375a86 - (bits >> 1);
+
+        float y;
+        memcpy(&y, &bits, sizeof(y));
+        y = y * (1.5f - 0.5f * x * y * y);
+        y = y * (1.5f - 0.5f * x * y * y);
+        return y * (1.5f - 0.5f * x * y * y) * scale;
+#endif
+    }
+
+    static float fastSin(float x)
+    {
+        // Approximates sinf(x). See fastSinCos().
+
+        float s, c;
+        fastSinCos(x, s, c);
+        return s;
+    }
+
+    static void fastSinCos(float x, float &s, float &c)
+    {
+        // Approximates sinf(x) and cosf(x) together. The range reduction
+        // is accurate for |x| <= 8192. Larger values, infinities and NaNs
+        // are passed to sinf() and cosf().
+        // Max absolute error: 1e-7.
+        //
+        // x = k PI/2 + r where |r| <= PI/4. PI/2 is split in three so that
+        // x - k PI/2 stays accurate. The quadrant k selects and negates the
+        // sin(r) and cos(r) polynomials.
+
+        if (!(fabsf(x) <= 8192.0f))
+        {
+            s = sinf(x);
+            c = cosf(x);
+            return;
+        }
+
+        float fk = x * 0.63661977f;
+        int k = static_cast<int>(fk + ((fk >= 0.0f) ? 0.5f : -0.5f));
+
+        fk = static_cast<float>(k);
+
+        float r = ((x - fk * 1.5703125f) - fk * 4.837512969970703125e-4f)
+            - fk * 7.54978995489188216e-8f;
+        float z = r * r;
+        float sr = ((-1.9515295891e-4f * z + 8.3321608736e-3f) * z
+            - 1.6666654611e-1f) * z * r + r;
+        float cr = ((2.443315711809948e-5f * z - 1.388731625493765e-3f) * z
+            + 4.166664568298827e-2f) * z * z - 0.5f * z + 1.0f;
+
+        s = (k & 1) ? cr : sr;
+        c = (k & 1) ? sr : cr;
+
+        if (k & 2)
+            s = -s;
+
+        if ((k + 1) & 2)
+            c = -c;
+    }
+
+    static void fastAcos(const float *x, float *result, unsigned int count);
+    static void fastAtan2(const float *y, const float *x, float *result, unsigned int count);
+    static void fastCos(const float *x, float *result, unsigned int count);
+    static void fastExp(const float *x, float *result, unsigned int count);
+    static void fastLog(const float *x, float *result, unsigned int count);
+    static void fastRsqrt(const float *x, float *result, unsigned int count);
+    static void fastSin(const float *x, float *result, unsigned int count);
+    static void fastSinCos(const float *x, float *s, float *c, unsigned int count);
+
     static long floatToLong(float f)
     {
         // Converts a floating point number into an integer.
@@ -124,18 +421,12 @@ public:
 
     static int nextPower2(int x);
     
-    static float radiansToDegrees(float radians)
+    static constexpr float radiansToDegrees(float radians)
     {
         return (radians * 180.0f) / PI;
     }
 
-    static float random(float min, float max)
-    {
-        // Returns a random number in range [min,max].
-
-        return min + (max - min)
-            * (static_cast<float>(rand()) / static_cast<float>(RAND_MAX));
-    }
+    static float random(float min, float max);
 
     static float smoothstep(float a, float b, float x)
     {
@@ -171,91 +462,267 @@ public:
         // phi = angle between OP and the XZ plane
         // theta = angle between X-axis and OP projected onto XZ plane
 
-        x = rho * cosf(phi) * cosf(theta);
-        y = rho * sinf(phi);
-        z = rho * cosf(phi) * sinf(theta);
+        float sinPhi, cosPhi, sinTheta, cosTheta;
+
+        MATHLIB_SINCOSF(phi, sinPhi, cosPhi);
+        MATHLIB_SINCOSF(theta, sinTheta, cosTheta);
+
+        x = rho * cosPhi * cosTheta;
+        y = rho * sinPhi;
+        z = rho * cosPhi * sinTheta;
     }
 };
 
 //-----------------------------------------------------------------------------
-// A 2-component vector class that represents a row vector.
+// The ScalarMath class template supplies the scalar functions and constants
+// used by the core types below, which are templates on their scalar type.
+//
+// The float version forwards to the Math class and the MATHLIB_*F macros, so
+// the float core types behave exactly as they did before they were templated
+// (MATHLIB_FAST_MATH included). The double version always uses the double
+// precision C runtime functions, and its closeEnough() tolerance is scaled
+// to double precision.
+
+template <typename T>
+class ScalarMath;
+
+template <>
+class ScalarMath<float>
+{
+public:
+    static float acos(float x)
+    {
+        return MATHLIB_ACOSF(x);
+    }
+
+    static float asin(float x)
+    {
+        return asinf(x);
+    }
+
+    static float atan2(float y, float x)
+    {
+        return MATHLIB_ATAN2F(y, x);
+    }
+
+    static bool closeEnough(float f1, float f2)
+    {
+        return Math::closeEnough(f1, f2);
+    }
 
-class Vector2
+    static constexpr float degreesToRadians(float degrees)
+    {
+        return Math::degreesToRadians(degrees);
+    }
+
+    static constexpr float epsilon()
+    {
+        return Math::EPSILON;
+    }
+
+    static constexpr float halfPi()
+    {
+        return Math::HALF_PI;
+    }
+
+    static constexpr float pi()
+    {
+        return Math::PI;
+    }
+
+    static constexpr float radiansToDegrees(float radians)
+    {
+        return Math::radiansToDegrees(radians);
+    }
+
+    static float rsqrt(float x)
+    {
+        return MATHLIB_RSQRTF(x);
+    }
+
+    static float sin(float x)
+    {
+        return MATHLIB_SINF(x);
+    }
+
+    static void sinCos(float x, float &s, float &c)
+    {
+        MATHLIB_SINCOSF(x, s, c);
+    }
+
+    static float sqrt(float x)
+    {
+        return sqrtf(x);
+    }
+};
+
+template <>
+class ScalarMath<double>
 {
-    friend Vector2 operator*(float lhs, const Vector2 &rhs);
-    friend Vector2 operator-(const Vector2 &v);
+public:
+    static double acos(double x)
+    {
+        return std::acos(x);
+    }
 
+    static double asin(double x)
+    {
+        return std::asin(x);
+    }
+
+    static double atan2(double y, double x)
+    {
+        return std::atan2(y, x);
+    }
+
+    static bool closeEnough(double f1, double f2)
+    {
+        // Same relative test as Math::closeEnough().
+        return std::fabs((f1 - f2) / ((f2 == 0.0) ? 1.0 : f2)) < epsilon();
+    }
+
+    static constexpr double degreesToRadians(double degrees)
+    {
+        return (degrees * pi()) / 180.0;
+    }
+
+    static constexpr double epsilon()
+    {
+        return 1e-12;
+    }
+
+    static constexpr double halfPi()
+    {
+        return pi() * 0.5;
+    }
+
+    static constexpr double pi()
+    {
+        return 3.14159265358979323846;
+    }
+
+    static constexpr double radiansToDegrees(double radians)
+    {
+        return (radians * 180.0) / pi();
+    }
+
+    static double rsqrt(double x)
+    {
+        return 1.0 / std::sqrt(x);
+    }
+
+    static double sin(double x)
+    {
+        return std::sin(x);
+    }
+
+    static void sinCos(double x, double &s, double &c)
+    {
+        s = std::sin(x), c = std::cos(x);
+    }
+
+    static double sqrt(double x)
+    {
+        return std::sqrt(x);
+    }
+};
+
+//-----------------------------------------------------------------------------
+// Identity<T>::type is T in a context where T isn't deduced. The scalar
+// parameter of the scalar * vector operators uses it, so that T is deduced
+// from the vector alone and 2 * v or 0.5 * v converts the scalar to the
+// vector's scalar type, as v * 2 does.
+
+template <typename T>
+struct Identity
+{
+    typedef T type;
+};
+
+//-----------------------------------------------------------------------------
+// A 2-component vector class that represents a row vector.
+
+template <typename T>
+class Vector2T
+{
 public:
-    float x, y;
-
-    static float distance(const Vector2 &pt1, const Vector2 &pt2);
-    static float distanceSq(const Vector2 &pt1, const Vector2 &pt2);  
-    static float dot(const Vector2 &p, const Vector2 &q);
-    static Vector2 lerp(const Vector2 &p, const Vector2 &q, float t);
-    static void orthogonalize(Vector2 &v1, Vector2 &v2);
-    static Vector2 proj(const Vector2 &p, const Vector2 &q);
-    static Vector2 perp(const Vector2 &p, const Vector2 &q);
-    static Vector2 reflect(const Vector2 &i, const Vector2 &n);
-
-    Vector2() : x{}, y{} {}
-    Vector2(float x_, float y_);
-    ~Vector2() {}
-
-    bool operator==(const Vector2 &rhs) const;
-    bool operator!=(const Vector2 &rhs) const;
-
-    Vector2 &operator+=(const Vector2 &rhs);
-    Vector2 &operator-=(const Vector2 &rhs);
-    Vector2 &operator*=(float scalar);
-    Vector2 &operator/=(float scalar);
-
-    Vector2 operator+(const Vector2 &rhs) const;
-    Vector2 operator-(const Vector2 &rhs) const;
-    Vector2 operator*(float scalar) const;
-    Vector2 operator/(float scalar) const;
-
-    float magnitude() const;
-    float magnitudeSq() const;
-    Vector2 inverse() const;
+    T x, y;
+
+    static T distance(const Vector2T &pt1, const Vector2T &pt2);
+    static constexpr T distanceSq(const Vector2T &pt1, const Vector2T &pt2);
+    static constexpr T dot(const Vector2T &p, const Vector2T &q);
+    static constexpr Vector2T lerp(const Vector2T &p, const Vector2T &q, T t);
+    static void orthogonalize(Vector2T &v1, Vector2T &v2);
+    static Vector2T proj(const Vector2T &p, const Vector2T &q);
+    static Vector2T perp(const Vector2T &p, const Vector2T &q);
+    static Vector2T reflect(const Vector2T &i, const Vector2T &n);
+
+    constexpr Vector2T() : x{}, y{} {}
+    constexpr Vector2T(T x_, T y_);
+    template <typename U> constexpr explicit Vector2T(const Vector2T<U> &v);
+
+    bool operator==(const Vector2T &rhs) const;
+    bool operator!=(const Vector2T &rhs) const;
+
+    Vector2T &operator+=(const Vector2T &rhs);
+    Vector2T &operator-=(const Vector2T &rhs);
+    Vector2T &operator*=(T scalar);
+    Vector2T &operator/=(T scalar);
+
+    constexpr Vector2T operator+(const Vector2T &rhs) const;
+    constexpr Vector2T operator-(const Vector2T &rhs) const;
+    constexpr Vector2T operator*(T scalar) const;
+    constexpr Vector2T operator/(T scalar) const;
+
+    T magnitude() const;
+    constexpr T magnitudeSq() const;
+    constexpr Vector2T inverse() const;
     void normalize();
-    void set(float x_, float y_);
+    void set(T x_, T y_);
 };
 
-inline Vector2 operator*(float lhs, const Vector2 &rhs)
+template <typename T>
+constexpr Vector2T<T> operator*(typename Identity<T>::type lhs, const Vector2T<T> &rhs)
 {
-    return Vector2(lhs * rhs.x, lhs * rhs.y);
+    return Vector2T<T>(lhs * rhs.x, lhs * rhs.y);
 }
 
-inline Vector2 operator-(const Vector2 &v)
+template <typename T>
+constexpr Vector2T<T> operator-(const Vector2T<T> &v)
 {
-    return Vector2(-v.x, -v.y);
+    return Vector2T<T>(-v.x, -v.y);
 }
 
-inline float Vector2::distance(const Vector2 &pt1, const Vector2 &pt2)
+template <typename T>
+inline T Vector2T<T>::distance(const Vector2T<T> &pt1, const Vector2T<T> &pt2)
 {
     // Calculates the distance between 2 points.
-    return sqrtf(distanceSq(pt1, pt2));
+    return ScalarMath<T>::sqrt(distanceSq(pt1, pt2));
 }
 
-inline float Vector2::distanceSq(const Vector2 &pt1, const Vector2 &pt2)
+template <typename T>
+constexpr T Vector2T<T>::distanceSq(const Vector2T<T> &pt1, const Vector2T<T> &pt2)
 {
     // Calculates the squared distance between 2 points.
     return ((pt1.x - pt2.x) * (pt1.x - pt2.x))
         + ((pt1.y - pt2.y) * (pt1.y - pt2.y));
 }
 
-inline float Vector2::dot(const Vector2 &p, const Vector2 &q)
+template <typename T>
+constexpr T Vector2T<T>::dot(const Vector2T<T> &p, const Vector2T<T> &q)
 {
     return (p.x * q.x) + (p.y * q.y);
 }
 
-inline Vector2 Vector2::lerp(const Vector2 &p, const Vector2 &q, float t)
+template <typename T>
+constexpr Vector2T<T> Vector2T<T>::lerp(const Vector2T<T> &p, const Vector2T<T> &q, T t)
 {
     // Linearly interpolates from 'p' to 'q' as t varies from 0 to 1.
     return p + t * (q - p);
 }
 
-inline void Vector2::orthogonalize(Vector2 &v1, Vector2 &v2)
+template <typename T>
+inline void Vector2T<T>::orthogonalize(Vector2T<T> &v1, Vector2T<T> &v2)
 {
     // Performs Gram-Schmidt Orthogonalization on the 2 basis vectors to
     // turn them into orthonormal basis vectors.
@@ -263,109 +730,128 @@ inline void Vector2::orthogonalize(Vector2 &v1, Vector2 &v2)
     v2.normalize();
 }
 
-inline Vector2 Vector2::proj(const Vector2 &p, const Vector2 &q)
+template <typename T>
+inline Vector2T<T> Vector2T<T>::proj(const Vector2T<T> &p, const Vector2T<T> &q)
 {
     // Calculates the projection of 'p' onto 'q'.
-    float length =  q.magnitude();
-    return (Vector2::dot(p, q) / (length * length)) * q;
+    T length =  q.magnitude();
+    return (Vector2T<T>::dot(p, q) / (length * length)) * q;
 }
 
-inline Vector2 Vector2::perp(const Vector2 &p, const Vector2 &q)
+template <typename T>
+inline Vector2T<T> Vector2T<T>::perp(const Vector2T<T> &p, const Vector2T<T> &q)
 {
     // Calculates the component of 'p' perpendicular to 'q'.
-    float length = q.magnitude();
-    return p - ((Vector2::dot(p, q) / (length * length)) * q);
+    T length = q.magnitude();
+    return p - ((Vector2T<T>::dot(p, q) / (length * length)) * q);
 }
 
-inline Vector2 Vector2::reflect(const Vector2 &i, const Vector2 &n)
+template <typename T>
+inline Vector2T<T> Vector2T<T>::reflect(const Vector2T<T> &i, const Vector2T<T> &n)
 {
     // Calculates reflection vector from entering ray direction 'i'
     // and surface normal 'n'.
-    return i - 2.0f * Vector2::proj(i, n);
+    return i - T(2) * Vector2T<T>::proj(i, n);
 }
 
-inline Vector2::Vector2(float x_, float y_) : x{x_}, y{y_} {}
+template <typename T>
+constexpr Vector2T<T>::Vector2T(T x_, T y_) : x{x_}, y{y_} {}
+
+template <typename T>
+template <typename U>
+constexpr Vector2T<T>::Vector2T(const Vector2T<U> &v) : x{static_cast<T>(v.x)}, y{static_cast<T>(v.y)} {}
 
-inline bool Vector2::operator==(const Vector2 &rhs) const
+template <typename T>
+inline bool Vector2T<T>::operator==(const Vector2T<T> &rhs) const
 {
-    return Math::closeEnough(x, rhs.x) && Math::closeEnough(y, rhs.y);
+    return ScalarMath<T>::closeEnough(x, rhs.x) && ScalarMath<T>::closeEnough(y, rhs.y);
 }
 
-inline bool Vector2::operator!=(const Vector2 &rhs) const
+template <typename T>
+inline bool Vector2T<T>::operator!=(const Vector2T<T> &rhs) const
 {
     return !(*this == rhs);
 }
 
-inline Vector2 &Vector2::operator+=(const Vector2 &rhs)
+template <typename T>
+inline Vector2T<T> &Vector2T<T>::operator+=(const Vector2T<T> &rhs)
 {
     x += rhs.x, y += rhs.y;
     return *this;
 }
 
-inline Vector2 &Vector2::operator-=(const Vector2 &rhs)
+template <typename T>
+inline Vector2T<T> &Vector2T<T>::operator-=(const Vector2T<T> &rhs)
 {
     x -= rhs.x, y -= rhs.y;
     return *this;
 }
 
-inline Vector2 &Vector2::operator*=(float scalar)
+template <typename T>
+inline Vector2T<T> &Vector2T<T>::operator*=(T scalar)
 {
     x *= scalar, y *= scalar;
     return *this;
 }
 
-inline Vector2 &Vector2::operator/=(float scalar)
+template <typename T>
+inline Vector2T<T> &Vector2T<T>::operator/=(T scalar)
 {
     x /= scalar, y /= scalar;
     return *this;
 }
 
-inline Vector2 Vector2::operator+(const Vector2 &rhs) const
+template <typename T>
+constexpr Vector2T<T> Vector2T<T>::operator+(const Vector2T<T> &rhs) const
 {
-    Vector2 tmp(*this);
-    tmp += rhs;
-    return tmp;
+    return Vector2T<T>(x + rhs.x, y + rhs.y);
 }
 
-inline Vector2 Vector2::operator-(const Vector2 &rhs) const
+template <typename T>
+constexpr Vector2T<T> Vector2T<T>::operator-(const Vector2T<T> &rhs) const
 {
-    Vector2 tmp(*this);
-    tmp -= rhs;
-    return tmp;
+    return Vector2T<T>(x - rhs.x, y - rhs.y);
 }
 
-inline Vector2 Vector2::operator*(float scalar) const
+template <typename T>
+constexpr Vector2T<T> Vector2T<T>::operator*(T scalar) const
 {
-    return Vector2(x * scalar, y * scalar);
+    return Vector2T<T>(x * scalar, y * scalar);
 }
 
-inline Vector2 Vector2::operator/(float scalar) const
+template <typename T>
+constexpr Vector2T<T> Vector2T<T>::operator/(T scalar) const
 {
-    return Vector2(x / scalar, y / scalar);
+    return Vector2T<T>(x / scalar, y / scalar);
 }
 
-inline float Vector2::magnitude() const
+template <typename T>
+inline T Vector2T<T>::magnitude() const
 {
-    return sqrtf((x * x) + (y * y));
+    return ScalarMath<T>::sqrt((x * x) + (y * y));
 }
 
-inline float Vector2::magnitudeSq() const
+template <typename T>
+constexpr T Vector2T<T>::magnitudeSq() const
 {
     return (x * x) + (y * y);
 }
 
-inline Vector2 Vector2::inverse() const
+template <typename T>
+constexpr Vector2T<T> Vector2T<T>::inverse() const
 {
-    return Vector2(-x, -y);
+    return Vector2T<T>(-x, -y);
 }
 
-inline void Vector2::normalize()
+template <typename T>
+inline void Vector2T<T>::normalize()
 {
-    float invMag = 1.0f / magnitude();
+    T invMag = ScalarMath<T>::rsqrt(magnitudeSq());
     x *= invMag, y *= invMag;
 }
 
-inline void Vector2::set(float x_, float y_)
+template <typename T>
+inline void Vector2T<T>::set(T x_, T y_)
 {
     x = x_, y = y_;
 }
@@ -373,73 +859,76 @@ inline void Vector2::set(float x_, float y_)
 //-----------------------------------------------------------------------------
 // A 3-component vector class that represents a row vector.
 
-class Vector3
+template <typename T>
+class Vector3T
 {
-    friend Vector3 operator*(float lhs, const Vector3 &rhs);
-    friend Vector3 operator-(const Vector3 &v);
-
 public:
-    float x, y, z;
-
-    static Vector3 cross(const Vector3 &p, const Vector3 &q);
-    static float distance(const Vector3 &pt1, const Vector3 &pt2);
-    static float distanceSq(const Vector3 &pt1, const Vector3 &pt2);  
-    static float dot(const Vector3 &p, const Vector3 &q);
-    static Vector3 lerp(const Vector3 &p, const Vector3 &q, float t);
-    static void orthogonalize(Vector3 &v1, Vector3 &v2);
-    static void orthogonalize(Vector3 &v1, Vector3 &v2, Vector3 &v3);
-    static Vector3 proj(const Vector3 &p, const Vector3 &q);
-    static Vector3 perp(const Vector3 &p, const Vector3 &q);
-    static Vector3 reflect(const Vector3 &i, const Vector3 &n);
-
-    Vector3() : x{}, y{}, z{} {}
-    Vector3(float x_, float y_, float z_);
-    ~Vector3() {}
-
-    bool operator==(const Vector3 &rhs) const;
-    bool operator!=(const Vector3 &rhs) const;
-
-    Vector3 &operator+=(const Vector3 &rhs);
-    Vector3 &operator-=(const Vector3 &rhs);
-    Vector3 &operator*=(float scalar);
-    Vector3 &operator/=(float scalar);
-
-    Vector3 operator+(const Vector3 &rhs) const;
-    Vector3 operator-(const Vector3 &rhs) const;
-    Vector3 operator*(float scalar) const;
-    Vector3 operator/(float scalar) const;
-
-    float magnitude() const;
-    float magnitudeSq() const;
-    Vector3 inverse() const;
+    T x, y, z;
+
+    static constexpr Vector3T cross(const Vector3T &p, const Vector3T &q);
+    static T distance(const Vector3T &pt1, const Vector3T &pt2);
+    static constexpr T distanceSq(const Vector3T &pt1, const Vector3T &pt2);
+    static constexpr T dot(const Vector3T &p, const Vector3T &q);
+    static constexpr Vector3T lerp(const Vector3T &p, const Vector3T &q, T t);
+    static void orthogonalize(Vector3T &v1, Vector3T &v2);
+    static void orthogonalize(Vector3T &v1, Vector3T &v2, Vector3T &v3);
+    static Vector3T proj(const Vector3T &p, const Vector3T &q);
+    static Vector3T perp(const Vector3T &p, const Vector3T &q);
+    static Vector3T reflect(const Vector3T &i, const Vector3T &n);
+
+    constexpr Vector3T() : x{}, y{}, z{} {}
+    constexpr Vector3T(T x_, T y_, T z_);
+    template <typename U> constexpr explicit Vector3T(const Vector3T<U> &v);
+
+    bool operator==(const Vector3T &rhs) const;
+    bool operator!=(const Vector3T &rhs) const;
+
+    Vector3T &operator+=(const Vector3T &rhs);
+    Vector3T &operator-=(const Vector3T &rhs);
+    Vector3T &operator*=(T scalar);
+    Vector3T &operator/=(T scalar);
+
+    constexpr Vector3T operator+(const Vector3T &rhs) const;
+    constexpr Vector3T operator-(const Vector3T &rhs) const;
+    constexpr Vector3T operator*(T scalar) const;
+    constexpr Vector3T operator/(T scalar) const;
+
+    T magnitude() const;
+    constexpr T magnitudeSq() const;
+    constexpr Vector3T inverse() const;
     void normalize();
-    void set(float x_, float y_, float z_);
+    void set(T x_, T y_, T z_);
 };
 
-inline Vector3 operator*(float lhs, const Vector3 &rhs)
+template <typename T>
+constexpr Vector3T<T> operator*(typename Identity<T>::type lhs, const Vector3T<T> &rhs)
 {
-    return Vector3(lhs * rhs.x, lhs * rhs.y, lhs * rhs.z);
+    return Vector3T<T>(lhs * rhs.x, lhs * rhs.y, lhs * rhs.z);
 }
 
-inline Vector3 operator-(const Vector3 &v)
+template <typename T>
+constexpr Vector3T<T> operator-(const Vector3T<T> &v)
 {
-    return Vector3(-v.x, -v.y, -v.z);
+    return Vector3T<T>(-v.x, -v.y, -v.z);
 }
 
-inline Vector3 Vector3::cross(const Vector3 &p, const Vector3 &q)
+template <typename T>
+constexpr Vector3T<T> Vector3T<T>::cross(const Vector3T<T> &p, const Vector3T<T> &q)
 {
-    return Vector3((p.y * q.z) - (p.z * q.y),
+    return Vector3T<T>((p.y * q.z) - (p.z * q.y),
         (p.z * q.x) - (p.x * q.z),
         (p.x * q.y) - (p.y * q.x));
 }
 
-inline float Vector3::distance(const Vector3 &pt1, const Vector3 &pt2)
+template <typename T>
+inline T Vector3T<T>::distance(const Vector3T<T> &pt1, const Vector3T<T> &pt2)
 {
     // Calculates the distance between 2 points.
-    return sqrtf(distanceSq(pt1, pt2));
+    return ScalarMath<T>::sqrt(distanceSq(pt1, pt2));
 }
 
-inline float Vector3::distanceSq(const Vector3 &pt1, const Vector3 &pt2)
+template <typename T>
+constexpr T Vector3T<T>::distanceSq(const Vector3T<T> &pt1, const Vector3T<T> &pt2)
 {
     // Calculates the squared distance between 2 points.
     return ((pt1.x - pt2.x) * (pt1.x - pt2.x))
@@ -447,18 +936,21 @@ inline float Vector3::distanceSq(const Vector3 &pt1, const Vector3 &pt2)
         + ((pt1.z - pt2.z) * (pt1.z - pt2.z));
 }
 
-inline float Vector3::dot(const Vector3 &p, const Vector3 &q)
+template <typename T>
+constexpr T Vector3T<T>::dot(const Vector3T<T> &p, const Vector3T<T> &q)
 {
     return (p.x * q.x) + (p.y * q.y) + (p.z * q.z);
 }
 
-inline Vector3 Vector3::lerp(const Vector3 &p, const Vector3 &q, float t)
+template <typename T>
+constexpr Vector3T<T> Vector3T<T>::lerp(const Vector3T<T> &p, const Vector3T<T> &q, T t)
 {
     // Linearly interpolates from 'p' to 'q' as t varies from 0 to 1.
     return p + t * (q - p);
 }
 
-inline void Vector3::orthogonalize(Vector3 &v1, Vector3 &v2)
+template <typename T>
+inline void Vector3T<T>::orthogonalize(Vector3T<T> &v1, Vector3T<T> &v2)
 {
     // Performs Gram-Schmidt Orthogonalization on the 2 basis vectors to
     // turn them into orthonormal basis vectors.
@@ -466,7 +958,8 @@ inline void Vector3::orthogonalize(Vector3 &v1, Vector3 &v2)
     v2.normalize();
 }
 
-inline void Vector3::orthogonalize(Vector3 &v1, Vector3 &v2, Vector3 &v3)
+template <typename T>
+inline void Vector3T<T>::orthogonalize(Vector3T<T> &v1, Vector3T<T> &v2, Vector3T<T> &v3)
 {
     // Performs Gram-Schmidt Orthogonalization on the 3 basis vectors to
     // turn them into orthonormal basis vectors.
@@ -478,110 +971,130 @@ inline void Vector3::orthogonalize(Vector3 &v1, Vector3 &v2, Vector3 &v3)
     v3.normalize();
 }
 
-inline Vector3 Vector3::proj(const Vector3 &p, const Vector3 &q)
+template <typename T>
+inline Vector3T<T> Vector3T<T>::proj(const Vector3T<T> &p, const Vector3T<T> &q)
 {
     // Calculates the projection of 'p' onto 'q'.
-    float length =  q.magnitude();
-    return (Vector3::dot(p, q) / (length * length)) * q;
+    T length =  q.magnitude();
+    return (Vector3T<T>::dot(p, q) / (length * length)) * q;
 }
 
-inline Vector3 Vector3::perp(const Vector3 &p, const Vector3 &q)
+template <typename T>
+inline Vector3T<T> Vector3T<T>::perp(const Vector3T<T> &p, const Vector3T<T> &q)
 {
     // Calculates the component of 'p' perpendicular to 'q'.
-    float length = q.magnitude();
-    return p - ((Vector3::dot(p, q) / (length * length)) * q);
+    T length = q.magnitude();
+    return p - ((Vector3T<T>::dot(p, q) / (length * length)) * q);
 }
 
-inline Vector3 Vector3::reflect(const Vector3 &i, const Vector3 &n)
+template <typename T>
+inline Vector3T<T> Vector3T<T>::reflect(const Vector3T<T> &i, const Vector3T<T> &n)
 {
     // Calculates reflection vector from entering ray direction 'i'
     // and surface normal 'n'.
-    return i - 2.0f * Vector3::proj(i, n);
+    return i - T(2) * Vector3T<T>::proj(i, n);
 }
 
-inline Vector3::Vector3(float x_, float y_, float z_) : x{x_}, y{y_}, z{z_} {}
+template <typename T>
+constexpr Vector3T<T>::Vector3T(T x_, T y_, T z_) : x{x_}, y{y_}, z{z_} {}
 
-inline Vector3 &Vector3::operator+=(const Vector3 &rhs)
+template <typename T>
+template <typename U>
+constexpr Vector3T<T>::Vector3T(const Vector3T<U> &v)
+    : x{static_cast<T>(v.x)}, y{static_cast<T>(v.y)}, z{static_cast<T>(v.z)} {}
+
+template <typename T>
+inline Vector3T<T> &Vector3T<T>::operator+=(const Vector3T<T> &rhs)
 {
     x += rhs.x, y += rhs.y, z += rhs.z;
     return *this;
 }
 
-inline bool Vector3::operator==(const Vector3 &rhs) const
+template <typename T>
+inline bool Vector3T<T>::operator==(const Vector3T<T> &rhs) const
 {
-    return Math::closeEnough(x, rhs.x) && Math::closeEnough(y, rhs.y)
-        && Math::closeEnough(z, rhs.z);
+    return ScalarMath<T>::closeEnough(x, rhs.x) && ScalarMath<T>::closeEnough(y, rhs.y)
+        && ScalarMath<T>::closeEnough(z, rhs.z);
 }
 
-inline bool Vector3::operator!=(const Vector3 &rhs) const
+template <typename T>
+inline bool Vector3T<T>::operator!=(const Vector3T<T> &rhs) const
 {
     return !(*this == rhs);
 }
 
-inline Vector3 &Vector3::operator-=(const Vector3 &rhs)
+template <typename T>
+inline Vector3T<T> &Vector3T<T>::operator-=(const Vector3T<T> &rhs)
 {
     x -= rhs.x, y -= rhs.y, z -= rhs.z;
     return *this;
 }
 
-inline Vector3 &Vector3::operator*=(float scalar)
+template <typename T>
+inline Vector3T<T> &Vector3T<T>::operator*=(T scalar)
 {
     x *= scalar, y *= scalar, z *= scalar;
     return *this;
 }
 
-inline Vector3 &Vector3::operator/=(float scalar)
+template <typename T>
+inline Vector3T<T> &Vector3T<T>::operator/=(T scalar)
 {
     x /= scalar, y /= scalar, z /= scalar;
     return *this;
 }
 
-inline Vector3 Vector3::operator+(const Vector3 &rhs) const
+template <typename T>
+constexpr Vector3T<T> Vector3T<T>::operator+(const Vector3T<T> &rhs) const
 {
-    Vector3 tmp(*this);
-    tmp += rhs;
-    return tmp;
+    return Vector3T<T>(x + rhs.x, y + rhs.y, z + rhs.z);
 }
 
-inline Vector3 Vector3::operator-(const Vector3 &rhs) const
+template <typename T>
+constexpr Vector3T<T> Vector3T<T>::operator-(const Vector3T<T> &rhs) const
 {
-    Vector3 tmp(*this);
-    tmp -= rhs;
-    return tmp;
+    return Vector3T<T>(x - rhs.x, y - rhs.y, z - rhs.z);
 }
 
-inline Vector3 Vector3::operator*(float scalar) const
+template <typename T>
+constexpr Vector3T<T> Vector3T<T>::operator*(T scalar) const
 {
-    return Vector3(x * scalar, y * scalar, z * scalar);    
+    return Vector3T<T>(x * scalar, y * scalar, z * scalar);    
 }
 
-inline Vector3 Vector3::operator/(float scalar) const
+template <typename T>
+constexpr Vector3T<T> Vector3T<T>::operator/(T scalar) const
 {
-    return Vector3(x / scalar, y / scalar, z / scalar);
+    return Vector3T<T>(x / scalar, y / scalar, z / scalar);
 }
 
-inline float Vector3::magnitude() const
+template <typename T>
+inline T Vector3T<T>::magnitude() const
 {
-    return sqrtf((x * x) + (y * y) + (z * z));
+    return ScalarMath<T>::sqrt((x * x) + (y * y) + (z * z));
 }
 
-inline float Vector3::magnitudeSq() const
+template <typename T>
+constexpr T Vector3T<T>::magnitudeSq() const
 {
     return (x * x) + (y * y) + (z * z);
 }
 
-inline Vector3 Vector3::inverse() const
+template <typename T>
+constexpr Vector3T<T> Vector3T<T>::inverse() const
 {
-    return Vector3(-x, -y, -z);
+    return Vector3T<T>(-x, -y, -z);
 }
 
-inline void Vector3::normalize()
+template <typename T>
+inline void Vector3T<T>::normalize()
 {
-    float invMag = 1.0f / magnitude();
+    T invMag = ScalarMath<T>::rsqrt(magnitudeSq());
     x *= invMag, y *= invMag, z *= invMag;
 }
 
-inline void Vector3::set(float x_, float y_, float z_)
+template <typename T>
+inline void Vector3T<T>::set(T x_, T y_, T z_)
 {
     x = x_, y = y_, z = z_;
 }
@@ -590,62 +1103,64 @@ inline void Vector3::set(float x_, float y_, float z_)
 // A 4-component row vector class that represents a point or vector in 
 // homogeneous coordinates.
 
-class Vector4
+template <typename T>
+class Vector4T
 {
-    friend Vector4 operator*(float lhs, const Vector4 &rhs);
-    friend Vector4 operator-(const Vector4 &v);
-
 public:
-    float x, y, z, w;
-
-    static float distance(const Vector4 &pt1, const Vector4 &pt2);
-    static float distanceSq(const Vector4 &pt1, const Vector4 &pt2);
-    static float dot(const Vector4 &p, const Vector4 &q);
-    static Vector4 lerp(const Vector4 &p, const Vector4 &q, float t);
-
-    Vector4() : x{}, y{}, z{}, w{} {}
-    Vector4(float x_, float y_, float z_, float w_);
-    Vector4(const Vector3 &v, float w_);
-    ~Vector4() {}
-
-    bool operator==(const Vector4 &rhs) const;
-    bool operator!=(const Vector4 &rhs) const;
-
-    Vector4 &operator+=(const Vector4 &rhs);
-    Vector4 &operator-=(const Vector4 &rhs);
-    Vector4 &operator*=(float scalar);
-    Vector4 &operator/=(float scalar);
-
-    Vector4 operator+(const Vector4 &rhs) const;
-    Vector4 operator-(const Vector4 &rhs) const;
-    Vector4 operator*(float scalar) const;
-    Vector4 operator/(float scalar) const;
-
-    float magnitude() const;
-    float magnitudeSq() const;
-    Vector4 inverse() const;
+    T x, y, z, w;
+
+    static T distance(const Vector4T &pt1, const Vector4T &pt2);
+    static constexpr T distanceSq(const Vector4T &pt1, const Vector4T &pt2);
+    static constexpr T dot(const Vector4T &p, const Vector4T &q);
+    static constexpr Vector4T lerp(const Vector4T &p, const Vector4T &q, T t);
+
+    constexpr Vector4T() : x{}, y{}, z{}, w{} {}
+    constexpr Vector4T(T x_, T y_, T z_, T w_);
+    constexpr Vector4T(const Vector3T<T> &v, T w_);
+    template <typename U> constexpr explicit Vector4T(const Vector4T<U> &v);
+
+    bool operator==(const Vector4T &rhs) const;
+    bool operator!=(const Vector4T &rhs) const;
+
+    Vector4T &operator+=(const Vector4T &rhs);
+    Vector4T &operator-=(const Vector4T &rhs);
+    Vector4T &operator*=(T scalar);
+    Vector4T &operator/=(T scalar);
+
+    constexpr Vector4T operator+(const Vector4T &rhs) const;
+    constexpr Vector4T operator-(const Vector4T &rhs) const;
+    constexpr Vector4T operator*(T scalar) const;
+    constexpr Vector4T operator/(T scalar) const;
+
+    T magnitude() const;
+    constexpr T magnitudeSq() const;
+    constexpr Vector4T inverse() const;
     void normalize();
-    void set(float x_, float y_, float z_, float w_);
-    Vector3 toVector3() const;
+    void set(T x_, T y_, T z_, T w_);
+    constexpr Vector3T<T> toVector3() const;
 };
 
-inline Vector4 operator*(float lhs, const Vector4 &rhs)
+template <typename T>
+constexpr Vector4T<T> operator*(typename Identity<T>::type lhs, const Vector4T<T> &rhs)
 {
-    return Vector4(lhs * rhs.x, lhs * rhs.y, lhs * rhs.z, lhs * rhs.w);
+    return Vector4T<T>(lhs * rhs.x, lhs * rhs.y, lhs * rhs.z, lhs * rhs.w);
 }
 
-inline Vector4 operator-(const Vector4 &v)
+template <typename T>
+constexpr Vector4T<T> operator-(const Vector4T<T> &v)
 {
-    return Vector4(-v.x, -v.y, -v.z, -v.w);
+    return Vector4T<T>(-v.x, -v.y, -v.z, -v.w);
 }
 
-inline float Vector4::distance(const Vector4 &pt1, const Vector4 &pt2)
+template <typename T>
+inline T Vector4T<T>::distance(const Vector4T<T> &pt1, const Vector4T<T> &pt2)
 {
     // Calculates the distance between 2 points.
-    return sqrtf(distanceSq(pt1, pt2));
+    return ScalarMath<T>::sqrt(distanceSq(pt1, pt2));
 }
 
-inline float Vector4::distanceSq(const Vector4 &pt1, const Vector4 &pt2)
+template <typename T>
+constexpr T Vector4T<T>::distanceSq(const Vector4T<T> &pt1, const Vector4T<T> &pt2)
 {
     // Calculates the squared distance between 2 points.
     return ((pt1.x - pt2.x) * (pt1.x - pt2.x))
@@ -654,109 +1169,130 @@ inline float Vector4::distanceSq(const Vector4 &pt1, const Vector4 &pt2)
         + ((pt1.w - pt2.w) * (pt1.w - pt2.w));
 }
 
-inline float Vector4::dot(const Vector4 &p, const Vector4 &q)
+template <typename T>
+constexpr T Vector4T<T>::dot(const Vector4T<T> &p, const Vector4T<T> &q)
 {
     return (p.x * q.x) + (p.y * q.y) + (p.z * q.z) + (p.w * q.w);
 }
 
-inline Vector4 Vector4::lerp(const Vector4 &p, const Vector4 &q, float t)
+template <typename T>
+constexpr Vector4T<T> Vector4T<T>::lerp(const Vector4T<T> &p, const Vector4T<T> &q, T t)
 {
     // Linearly interpolates from 'p' to 'q' as t varies from 0 to 1.
     return p + t * (q - p);
 }
 
-inline Vector4::Vector4(float x_, float y_, float z_, float w_) : x{x_}, y{y_}, z{z_}, w{w_} {}
+template <typename T>
+constexpr Vector4T<T>::Vector4T(T x_, T y_, T z_, T w_) : x{x_}, y{y_}, z{z_}, w{w_} {}
+
+template <typename T>
+constexpr Vector4T<T>::Vector4T(const Vector3T<T> &v, T w_) : x{v.x}, y{v.y}, z{v.z}, w{w_} {}
 
-inline Vector4::Vector4(const Vector3 &v, float w_) : x{v.x}, y{v.y}, z{v.z}, w{w_} {}
+template <typename T>
+template <typename U>
+constexpr Vector4T<T>::Vector4T(const Vector4T<U> &v)
+    : x{static_cast<T>(v.x)}, y{static_cast<T>(v.y)}, z{static_cast<T>(v.z)}, w{static_cast<T>(v.w)} {}
 
-inline Vector4 &Vector4::operator+=(const Vector4 &rhs)
+template <typename T>
+inline Vector4T<T> &Vector4T<T>::operator+=(const Vector4T<T> &rhs)
 {
     x += rhs.x, y += rhs.y, z += rhs.z, w += rhs.w;
     return *this;
 }
 
-inline bool Vector4::operator==(const Vector4 &rhs) const
+template <typename T>
+inline bool Vector4T<T>::operator==(const Vector4T<T> &rhs) const
 {
-    return Math::closeEnough(x, rhs.x) && Math::closeEnough(y, rhs.y)
-        && Math::closeEnough(z, rhs.z) && Math::closeEnough(w, rhs.w);
+    return ScalarMath<T>::closeEnough(x, rhs.x) && ScalarMath<T>::closeEnough(y, rhs.y)
+        && ScalarMath<T>::closeEnough(z, rhs.z) && ScalarMath<T>::closeEnough(w, rhs.w);
 }
 
-inline bool Vector4::operator!=(const Vector4 &rhs) const
+template <typename T>
+inline bool Vector4T<T>::operator!=(const Vector4T<T> &rhs) const
 {
     return !(*this == rhs);
 }
 
-inline Vector4 &Vector4::operator-=(const Vector4 &rhs)
+template <typename T>
+inline Vector4T<T> &Vector4T<T>::operator-=(const Vector4T<T> &rhs)
 {
     x -= rhs.x, y -= rhs.y, z -= rhs.z, w -= rhs.w;
     return *this;
 }
 
-inline Vector4 &Vector4::operator*=(float scalar)
+template <typename T>
+inline Vector4T<T> &Vector4T<T>::operator*=(T scalar)
 {
     x *= scalar, y *= scalar, z *= scalar, w *= scalar;
     return *this;
 }
 
-inline Vector4 &Vector4::operator/=(float scalar)
+template <typename T>
+inline Vector4T<T> &Vector4T<T>::operator/=(T scalar)
 {
     x /= scalar, y /= scalar, z /= scalar, w /= scalar;
     return *this;
 }
 
-inline Vector4 Vector4::operator+(const Vector4 &rhs) const
+template <typename T>
+constexpr Vector4T<T> Vector4T<T>::operator+(const Vector4T<T> &rhs) const
 {
-    Vector4 tmp(*this);
-    tmp += rhs;
-    return tmp;
+    return Vector4T<T>(x + rhs.x, y + rhs.y, z + rhs.z, w + rhs.w);
 }
 
-inline Vector4 Vector4::operator-(const Vector4 &rhs) const
+template <typename T>
+constexpr Vector4T<T> Vector4T<T>::operator-(const Vector4T<T> &rhs) const
 {
-    Vector4 tmp(*this);
-    tmp -= rhs;
-    return tmp;
+    return Vector4T<T>(x - rhs.x, y - rhs.y, z - rhs.z, w - rhs.w);
 }
 
-inline Vector4 Vector4::operator*(float scalar) const
+template <typename T>
+constexpr Vector4T<T> Vector4T<T>::operator*(T scalar) const
 {
-    return Vector4(x * scalar, y * scalar, z * scalar, w * scalar);
+    return Vector4T<T>(x * scalar, y * scalar, z * scalar, w * scalar);
 }
 
-inline Vector4 Vector4::operator/(float scalar) const
+template <typename T>
+constexpr Vector4T<T> Vector4T<T>::operator/(T scalar) const
 {
-    return Vector4(x / scalar, y / scalar, z / scalar, w / scalar);
+    return Vector4T<T>(x / scalar, y / scalar, z / scalar, w / scalar);
 }
 
-inline float Vector4::magnitude() const
+template <typename T>
+inline T Vector4T<T>::magnitude() const
 {
-    return sqrtf((x * x) + (y * y) + (z * z) + (w * w));
+    return ScalarMath<T>::sqrt((x * x) + (y * y) + (z * z) + (w * w));
 }
 
-inline float Vector4::magnitudeSq() const
+template <typename T>
+constexpr T Vector4T<T>::magnitudeSq() const
 {
     return (x * x) + (y * y) + (z * z) + (w * w);
 }
 
-inline Vector4 Vector4::inverse() const
+template <typename T>
+constexpr Vector4T<T> Vector4T<T>::inverse() const
 {
-    return Vector4(-x, -y, -z, -w);
+    return Vector4T<T>(-x, -y, -z, -w);
 }
 
-inline void Vector4::normalize()
+template <typename T>
+inline void Vector4T<T>::normalize()
 {
-    float invMag = 1.0f / magnitude();
+    T invMag = ScalarMath<T>::rsqrt(magnitudeSq());
     x *= invMag, y *= invMag, z *= invMag, w *= invMag;
 }
 
-inline void Vector4::set(float x_, float y_, float z_, float w_)
+template <typename T>
+inline void Vector4T<T>::set(T x_, T y_, T z_, T w_)
 {
     x = x_, y = y_, z = z_, w = w_;
 }
 
-inline Vector3 Vector4::toVector3() const
+template <typename T>
+constexpr Vector3T<T> Vector4T<T>::toVector3() const
 {
-    return (w != 0.0f) ? Vector3(x / w, y / w, z / w) : Vector3(x, y, z);
+    return (w != T(0)) ? Vector3T<T>(x / w, y / w, z / w) : Vector3T<T>(x, y, z);
 }
 
 //-----------------------------------------------------------------------------
@@ -765,156 +1301,173 @@ inline Vector3 Vector4::toVector3() const
 // Matrices are concatenated in a left to right order.
 // Multiplies vectors to the left of the matrix.
 
-class Matrix3
+template <typename T>
+class Matrix3T
 {
-    friend Vector3 operator*(const Vector3 &lhs, const Matrix3 &rhs);
-    friend Matrix3 operator*(float scalar, const Matrix3 &rhs);
+    template <typename U> friend constexpr Vector3T<U> operator*(const Vector3T<U> &lhs, const Matrix3T<U> &rhs);
 
 public:
-    static const Matrix3 IDENTITY;
-    static Matrix3 createFromAxes(const Vector3 &x, const Vector3 &y, const Vector3 &z);
-    static Matrix3 createFromAxesTransposed(const Vector3 &x, const Vector3 &y, const Vector3 &z);
-    static Matrix3 createFromHeadPitchRoll(float headDegrees, float pitchDegrees, float rollDegrees);
-    static Matrix3 createMirror(const Vector3 &planeNormal);
-    static Matrix3 createOrient(const Vector3 &from, const Vector3 &to);
-    static Matrix3 createRotate(const Vector3 &axis, float degrees);
-    static Matrix3 createScale(float sx, float sy, float sz);
-
-    Matrix3() : mtx{{0.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 0.0f}} {}
-    Matrix3(float m11, float m12, float m13,
-            float m21, float m22, float m23,
-            float m31, float m32, float m33);
-    ~Matrix3() {}
-
-    float *operator[](int row);
-    const float *operator[](int row) const;
-
-    bool operator==(const Matrix3 &rhs) const;
-    bool operator!=(const Matrix3 &rhs) const;
-
-    Matrix3 &operator+=(const Matrix3 &rhs);
-    Matrix3 &operator-=(const Matrix3 &rhs);
-    Matrix3 &operator*=(const Matrix3 &rhs);
-    Matrix3 &operator*=(float scalar);
-    Matrix3 &operator/=(float scalar);
-
-    Matrix3 operator+(const Matrix3 &rhs) const;
-    Matrix3 operator-(const Matrix3 &rhs) const;
-    Matrix3 operator*(const Matrix3 &rhs) const;
-    Matrix3 operator*(float scalar) const;
-    Matrix3 operator/(float scalar) const;
-
-    float determinant() const;
-    void fromAxes(const Vector3 &x, const Vector3 &y, const Vector3 &z);
-    void fromAxesTransposed(const Vector3 &x, const Vector3 &y, const Vector3 &z);
-    void fromHeadPitchRoll(float headDegrees, float pitchDegrees, float rollDegrees);
+    static const Matrix3T IDENTITY;
+    static Matrix3T createFromAxes(const Vector3T<T> &x, const Vector3T<T> &y, const Vector3T<T> &z);
+    static Matrix3T createFromAxesTransposed(const Vector3T<T> &x, const Vector3T<T> &y, const Vector3T<T> &z);
+    static Matrix3T createFromHeadPitchRoll(T headDegrees, T pitchDegrees, T rollDegrees);
+    static Matrix3T createMirror(const Vector3T<T> &planeNormal);
+    static Matrix3T createOrient(const Vector3T<T> &from, const Vector3T<T> &to);
+    static Matrix3T createRotate(const Vector3T<T> &axis, T degrees);
+    static constexpr Matrix3T createScale(T sx, T sy, T sz);
+
+    constexpr Matrix3T() : mtx{} {}
+    constexpr Matrix3T(T m11, T m12, T m13,
+            T m21, T m22, T m23,
+            T m31, T m32, T m33);
+    template <typename U> constexpr explicit Matrix3T(const Matrix3T<U> &m);
+
+    T *operator[](int row);
+    constexpr const T *operator[](int row) const;
+
+    bool operator==(const Matrix3T &rhs) const;
+    bool operator!=(const Matrix3T &rhs) const;
+
+    Matrix3T &operator+=(const Matrix3T &rhs);
+    Matrix3T &operator-=(const Matrix3T &rhs);
+    Matrix3T &operator*=(const Matrix3T &rhs);
+    Matrix3T &operator*=(T scalar);
+    Matrix3T &operator/=(T scalar);
+
+    constexpr Matrix3T operator+(const Matrix3T &rhs) const;
+    constexpr Matrix3T operator-(const Matrix3T &rhs) const;
+    constexpr Matrix3T operator*(const Matrix3T &rhs) const;
+    constexpr Matrix3T operator*(T scalar) const;
+    constexpr Matrix3T operator/(T scalar) const;
+
+    constexpr T determinant() const;
+    void fromAxes(const Vector3T<T> &x, const Vector3T<T> &y, const Vector3T<T> &z);
+    void fromAxesTransposed(const Vector3T<T> &x, const Vector3T<T> &y, const Vector3T<T> &z);
+    void fromHeadPitchRoll(T headDegrees, T pitchDegrees, T rollDegrees);
     void identity();
-    Matrix3 inverse() const;
-    void orient(const Vector3 &from, const Vector3 &to);
-    void rotate(const Vector3 &axis, float degrees);
-    void scale(float sx, float sy, float sz);
-    void toAxes(Vector3 &x, Vector3 &y, Vector3 &z) const;
-    void toAxesTransposed(Vector3 &x, Vector3 &y, Vector3 &z) const;
-    void toHeadPitchRoll(float &headDegrees, float &pitchDegrees, float &rollDegrees) const;
-    Matrix3 transpose() const;
+    Matrix3T inverse() const;
+    void orient(const Vector3T<T> &from, const Vector3T<T> &to);
+    void rotate(const Vector3T<T> &axis, T degrees);
+    void scale(T sx, T sy, T sz);
+    void toAxes(Vector3T<T> &x, Vector3T<T> &y, Vector3T<T> &z) const;
+    void toAxesTransposed(Vector3T<T> &x, Vector3T<T> &y, Vector3T<T> &z) const;
+    void toHeadPitchRoll(T &headDegrees, T &pitchDegrees, T &rollDegrees) const;
+    constexpr Matrix3T transpose() const;
 
 private:
-    float mtx[3][3];
+    T mtx[3][3];
 };
 
-inline Vector3 operator*(const Vector3 &lhs, const Matrix3 &rhs)
+template <typename T>
+constexpr Vector3T<T> operator*(const Vector3T<T> &lhs, const Matrix3T<T> &rhs)
 {
-    return Vector3(
+    return Vector3T<T>(
         (lhs.x * rhs.mtx[0][0]) + (lhs.y * rhs.mtx[1][0]) + (lhs.z * rhs.mtx[2][0]),
         (lhs.x * rhs.mtx[0][1]) + (lhs.y * rhs.mtx[1][1]) + (lhs.z * rhs.mtx[2][1]),
         (lhs.x * rhs.mtx[0][2]) + (lhs.y * rhs.mtx[1][2]) + (lhs.z * rhs.mtx[2][2]));
 }
 
-inline Matrix3 operator*(float scalar, const Matrix3 &rhs)
+template <typename T>
+constexpr Matrix3T<T> operator*(T scalar, const Matrix3T<T> &rhs)
 {
     return rhs * scalar;
 }
 
-inline Matrix3 Matrix3::createFromAxes(const Vector3 &x, const Vector3 &y, const Vector3 &z)
+template <typename T>
+inline Matrix3T<T> Matrix3T<T>::createFromAxes(const Vector3T<T> &x, const Vector3T<T> &y, const Vector3T<T> &z)
 {
-    Matrix3 tmp;
-    tmp.createFromAxes(x, y, z);
+    Matrix3T<T> tmp;
+    tmp.fromAxes(x, y, z);
     return tmp;
 }
 
-inline Matrix3 Matrix3::createFromAxesTransposed(const Vector3 &x, const Vector3 &y, const Vector3 &z)
+template <typename T>
+inline Matrix3T<T> Matrix3T<T>::createFromAxesTransposed(const Vector3T<T> &x, const Vector3T<T> &y, const Vector3T<T> &z)
 {
-    Matrix3 tmp;
+    Matrix3T<T> tmp;
     tmp.fromAxesTransposed(x, y, z);
     return tmp;
 }
 
-inline Matrix3 Matrix3::createFromHeadPitchRoll(float headDegrees, float pitchDegrees, float rollDegrees)
+template <typename T>
+inline Matrix3T<T> Matrix3T<T>::createFromHeadPitchRoll(T headDegrees, T pitchDegrees, T rollDegrees)
 {
-    Matrix3 tmp;
+    Matrix3T<T> tmp;
     tmp.fromHeadPitchRoll(headDegrees, pitchDegrees, rollDegrees);
     return tmp;
 }
 
-inline Matrix3 Matrix3::createOrient(const Vector3 &from, const Vector3 &to)
+template <typename T>
+inline Matrix3T<T> Matrix3T<T>::createOrient(const Vector3T<T> &from, const Vector3T<T> &to)
 {
-    Matrix3 tmp;
+    Matrix3T<T> tmp;
     tmp.orient(from, to);
     return tmp;
 }
 
-inline Matrix3 Matrix3::createRotate(const Vector3 &axis, float degrees)
+template <typename T>
+inline Matrix3T<T> Matrix3T<T>::createRotate(const Vector3T<T> &axis, T degrees)
 {
-    Matrix3 tmp;
+    Matrix3T<T> tmp;
     tmp.rotate(axis, degrees);
     return tmp;
 }
 
-inline Matrix3 Matrix3::createScale(float sx, float sy, float sz)
+template <typename T>
+constexpr Matrix3T<T> Matrix3T<T>::createScale(T sx, T sy, T sz)
 {
-    Matrix3 tmp;
-    tmp.scale(sx, sy, sz);
-    return tmp;
+    return Matrix3T<T>(sx, T(0), T(0),
+                       T(0), sy, T(0),
+                       T(0), T(0), sz);
 }
 
-inline Matrix3::Matrix3(float m11, float m12, float m13,
-                        float m21, float m22, float m23,
-                        float m31, float m32, float m33)
-{
-    mtx[0][0] = m11, mtx[0][1] = m12, mtx[0][2] = m13;
-    mtx[1][0] = m21, mtx[1][1] = m22, mtx[1][2] = m23;
-    mtx[2][0] = m31, mtx[2][1] = m32, mtx[2][2] = m33;
-}
+template <typename T>
+constexpr Matrix3T<T>::Matrix3T(T m11, T m12, T m13,
+                        T m21, T m22, T m23,
+                        T m31, T m32, T m33)
+    : mtx{{m11, m12, m13}, {m21, m22, m23}, {m31, m32, m33}} {}
+
+template <typename T>
+template <typename U>
+constexpr Matrix3T<T>::Matrix3T(const Matrix3T<U> &m)
+    : mtx{{static_cast<T>(m[0][0]), static_cast<T>(m[0][1]), static_cast<T>(m[0][2])},
+          {static_cast<T>(m[1][0]), static_cast<T>(m[1][1]), static_cast<T>(m[1][2])},
+          {static_cast<T>(m[2][0]), static_cast<T>(m[2][1]), static_cast<T>(m[2][2])}} {}
 
-inline float *Matrix3::operator[](int row)
+template <typename T>
+inline T *Matrix3T<T>::operator[](int row)
 {
     return mtx[row];
 }
 
-inline const float *Matrix3::operator[](int row) const
+template <typename T>
+constexpr const T *Matrix3T<T>::operator[](int row) const
 {
     return mtx[row];
 }
 
-inline bool Matrix3::operator==(const Matrix3 &rhs) const
+template <typename T>
+inline bool Matrix3T<T>::operator==(const Matrix3T<T> &rhs) const
 {
-    return Math::closeEnough(mtx[0][0], rhs.mtx[0][0])
-        && Math::closeEnough(mtx[0][1], rhs.mtx[0][1])
-        && Math::closeEnough(mtx[0][2], rhs.mtx[0][2])
-        && Math::closeEnough(mtx[1][0], rhs.mtx[1][0])
-        && Math::closeEnough(mtx[1][1], rhs.mtx[1][1])
-        && Math::closeEnough(mtx[1][2], rhs.mtx[1][2])
-        && Math::closeEnough(mtx[2][0], rhs.mtx[2][0])
-        && Math::closeEnough(mtx[2][1], rhs.mtx[2][1])
-        && Math::closeEnough(mtx[2][2], rhs.mtx[2][2]);
+    return ScalarMath<T>::closeEnough(mtx[0][0], rhs.mtx[0][0])
+        && ScalarMath<T>::closeEnough(mtx[0][1], rhs.mtx[0][1])
+        && ScalarMath<T>::closeEnough(mtx[0][2], rhs.mtx[0][2])
+        && ScalarMath<T>::closeEnough(mtx[1][0], rhs.mtx[1][0])
+        && ScalarMath<T>::closeEnough(mtx[1][1], rhs.mtx[1][1])
+        && ScalarMath<T>::closeEnough(mtx[1][2], rhs.mtx[1][2])
+        && ScalarMath<T>::closeEnough(mtx[2][0], rhs.mtx[2][0])
+        && ScalarMath<T>::closeEnough(mtx[2][1], rhs.mtx[2][1])
+        && ScalarMath<T>::closeEnough(mtx[2][2], rhs.mtx[2][2]);
 }
 
-inline bool Matrix3::operator!=(const Matrix3 &rhs) const
+template <typename T>
+inline bool Matrix3T<T>::operator!=(const Matrix3T<T> &rhs) const
 {
     return !(*this == rhs);
 }
 
-inline Matrix3 &Matrix3::operator+=(const Matrix3 &rhs)
+template <typename T>
+inline Matrix3T<T> &Matrix3T<T>::operator+=(const Matrix3T<T> &rhs)
 {
     mtx[0][0] += rhs.mtx[0][0], mtx[0][1] += rhs.mtx[0][1], mtx[0][2] += rhs.mtx[0][2];
     mtx[1][0] += rhs.mtx[1][0], mtx[1][1] += rhs.mtx[1][1], mtx[1][2] += rhs.mtx[1][2];
@@ -922,7 +1475,8 @@ inline Matrix3 &Matrix3::operator+=(const Matrix3 &rhs)
     return *this;
 }
 
-inline Matrix3 &Matrix3::operator-=(const Matrix3 &rhs)
+template <typename T>
+inline Matrix3T<T> &Matrix3T<T>::operator-=(const Matrix3T<T> &rhs)
 {
     mtx[0][0] -= rhs.mtx[0][0], mtx[0][1] -= rhs.mtx[0][1], mtx[0][2] -= rhs.mtx[0][2];
     mtx[1][0] -= rhs.mtx[1][0], mtx[1][1] -= rhs.mtx[1][1], mtx[1][2] -= rhs.mtx[1][2];
@@ -930,30 +1484,15 @@ inline Matrix3 &Matrix3::operator-=(const Matrix3 &rhs)
     return *this;
 }
 
-inline Matrix3 &Matrix3::operator*=(const Matrix3 &rhs)
+template <typename T>
+inline Matrix3T<T> &Matrix3T<T>::operator*=(const Matrix3T<T> &rhs)
 {
-    Matrix3 tmp;
-
-    // Row 1.
-    tmp.mtx[0][0] = (mtx[0][0] * rhs.mtx[0][0]) + (mtx[0][1] * rhs.mtx[1][0]) + (mtx[0][2] * rhs.mtx[2][0]);
-    tmp.mtx[0][1] = (mtx[0][0] * rhs.mtx[0][1]) + (mtx[0][1] * rhs.mtx[1][1]) + (mtx[0][2] * rhs.mtx[2][1]);
-    tmp.mtx[0][2] = (mtx[0][0] * rhs.mtx[0][2]) + (mtx[0][1] * rhs.mtx[1][2]) + (mtx[0][2] * rhs.mtx[2][2]);
-
-    // Row 2.
-    tmp.mtx[1][0] = (mtx[1][0] * rhs.mtx[0][0]) + (mtx[1][1] * rhs.mtx[1][0]) + (mtx[1][2] * rhs.mtx[2][0]);
-    tmp.mtx[1][1] = (mtx[1][0] * rhs.mtx[0][1]) + (mtx[1][1] * rhs.mtx[1][1]) + (mtx[1][2] * rhs.mtx[2][1]);
-    tmp.mtx[1][2] = (mtx[1][0] * rhs.mtx[0][2]) + (mtx[1][1] * rhs.mtx[1][2]) + (mtx[1][2] * rhs.mtx[2][2]);
-
-    // Row 3.
-    tmp.mtx[2][0] = (mtx[2][0] * rhs.mtx[0][0]) + (mtx[2][1] * rhs.mtx[1][0]) + (mtx[2][2] * rhs.mtx[2][0]);
-    tmp.mtx[2][1] = (mtx[2][0] * rhs.mtx[0][1]) + (mtx[2][1] * rhs.mtx[1][1]) + (mtx[2][2] * rhs.mtx[2][1]);
-    tmp.mtx[2][2] = (mtx[2][0] * rhs.mtx[0][2]) + (mtx[2][1] * rhs.mtx[1][2]) + (mtx[2][2] * rhs.mtx[2][2]);
-
-    *this = tmp;
+    *this = *this * rhs;
     return *this;
 }
 
-inline Matrix3 &Matrix3::operator*=(float scalar)
+template <typename T>
+inline Matrix3T<T> &Matrix3T<T>::operator*=(T scalar)
 {
     mtx[0][0] *= scalar, mtx[0][1] *= scalar, mtx[0][2] *= scalar;
     mtx[1][0] *= scalar, mtx[1][1] *= scalar, mtx[1][2] *= scalar;
@@ -961,7 +1500,8 @@ inline Matrix3 &Matrix3::operator*=(float scalar)
     return *this;
 }
 
-inline Matrix3 &Matrix3::operator/=(float scalar)
+template <typename T>
+inline Matrix3T<T> &Matrix3T<T>::operator/=(T scalar)
 {
     mtx[0][0] /= scalar, mtx[0][1] /= scalar, mtx[0][2] /= scalar;
     mtx[1][0] /= scalar, mtx[1][1] /= scalar, mtx[1][2] /= scalar;
@@ -969,279 +1509,334 @@ inline Matrix3 &Matrix3::operator/=(float scalar)
     return *this;
 }
 
-inline Matrix3 Matrix3::operator+(const Matrix3 &rhs) const
+template <typename T>
+constexpr Matrix3T<T> Matrix3T<T>::operator+(const Matrix3T<T> &rhs) const
 {
-    Matrix3 tmp(*this);
-    tmp += rhs;
-    return tmp;
+    return Matrix3T<T>(mtx[0][0] + rhs.mtx[0][0], mtx[0][1] + rhs.mtx[0][1], mtx[0][2] + rhs.mtx[0][2],
+                       mtx[1][0] + rhs.mtx[1][0], mtx[1][1] + rhs.mtx[1][1], mtx[1][2] + rhs.mtx[1][2],
+                       mtx[2][0] + rhs.mtx[2][0], mtx[2][1] + rhs.mtx[2][1], mtx[2][2] + rhs.mtx[2][2]);
 }
 
-inline Matrix3 Matrix3::operator-(const Matrix3 &rhs) const
+template <typename T>
+constexpr Matrix3T<T> Matrix3T<T>::operator-(const Matrix3T<T> &rhs) const
 {
-    Matrix3 tmp(*this);
-    tmp -= rhs;
-    return tmp;
+    return Matrix3T<T>(mtx[0][0] - rhs.mtx[0][0], mtx[0][1] - rhs.mtx[0][1], mtx[0][2] - rhs.mtx[0][2],
+                       mtx[1][0] - rhs.mtx[1][0], mtx[1][1] - rhs.mtx[1][1], mtx[1][2] - rhs.mtx[1][2],
+                       mtx[2][0] - rhs.mtx[2][0], mtx[2][1] - rhs.mtx[2][1], mtx[2][2] - rhs.mtx[2][2]);
 }
 
-inline Matrix3 Matrix3::operator*(const Matrix3 &rhs) const
+template <typename T>
+constexpr Matrix3T<T> Matrix3T<T>::operator*(const Matrix3T<T> &rhs) const
 {
-    Matrix3 tmp(*this);
-    tmp *= rhs;
-    return tmp;
+    return Matrix3T<T>(
+        // Row 1.
+        (mtx[0][0] * rhs.mtx[0][0]) + (mtx[0][1] * rhs.mtx[1][0]) + (mtx[0][2] * rhs.mtx[2][0]),
+        (mtx[0][0] * rhs.mtx[0][1]) + (mtx[0][1] * rhs.mtx[1][1]) + (mtx[0][2] * rhs.mtx[2][1]),
+        (mtx[0][0] * rhs.mtx[0][2]) + (mtx[0][1] * rhs.mtx[1][2]) + (mtx[0][2] * rhs.mtx[2][2]),
+
+        // Row 2.
+        (mtx[1][0] * rhs.mtx[0][0]) + (mtx[1][1] * rhs.mtx[1][0]) + (mtx[1][2] * rhs.mtx[2][0]),
+        (mtx[1][0] * rhs.mtx[0][1]) + (mtx[1][1] * rhs.mtx[1][1]) + (mtx[1][2] * rhs.mtx[2][1]),
+        (mtx[1][0] * rhs.mtx[0][2]) + (mtx[1][1] * rhs.mtx[1][2]) + (mtx[1][2] * rhs.mtx[2][2]),
+
+        // Row 3.
+        (mtx[2][0] * rhs.mtx[0][0]) + (mtx[2][1] * rhs.mtx[1][0]) + (mtx[2][2] * rhs.mtx[2][0]),
+        (mtx[2][0] * rhs.mtx[0][1]) + (mtx[2][1] * rhs.mtx[1][1]) + (mtx[2][2] * rhs.mtx[2][1]),
+        (mtx[2][0] * rhs.mtx[0][2]) + (mtx[2][1] * rhs.mtx[1][2]) + (mtx[2][2] * rhs.mtx[2][2]));
 }
 
-inline Matrix3 Matrix3::operator*(float scalar) const
+template <typename T>
+constexpr Matrix3T<T> Matrix3T<T>::operator*(T scalar) const
 {
-    Matrix3 tmp(*this);
-    tmp *= scalar;
-    return tmp;
+    return Matrix3T<T>(mtx[0][0] * scalar, mtx[0][1] * scalar, mtx[0][2] * scalar,
+                       mtx[1][0] * scalar, mtx[1][1] * scalar, mtx[1][2] * scalar,
+                       mtx[2][0] * scalar, mtx[2][1] * scalar, mtx[2][2] * scalar);
 }
 
-inline Matrix3 Matrix3::operator/(float scalar) const
+template <typename T>
+constexpr Matrix3T<T> Matrix3T<T>::operator/(T scalar) const
 {
-    Matrix3 tmp(*this);
-    tmp /= scalar;
-    return tmp;
+    return Matrix3T<T>(mtx[0][0] / scalar, mtx[0][1] / scalar, mtx[0][2] / scalar,
+                       mtx[1][0] / scalar, mtx[1][1] / scalar, mtx[1][2] / scalar,
+                       mtx[2][0] / scalar, mtx[2][1] / scalar, mtx[2][2] / scalar);
 }
 
-inline float Matrix3::determinant() const
+template <typename T>
+constexpr T Matrix3T<T>::determinant() const
 {
     return (mtx[0][0] * (mtx[1][1] * mtx[2][2] - mtx[1][2] * mtx[2][1]))
         - (mtx[0][1] * (mtx[1][0] * mtx[2][2] - mtx[1][2] * mtx[2][0]))
         + (mtx[0][2] * (mtx[1][0] * mtx[2][1] - mtx[1][1] * mtx[2][0]));
 }
 
-inline void Matrix3::fromAxes(const Vector3 &x, const Vector3 &y, const Vector3 &z)
+template <typename T>
+inline void Matrix3T<T>::fromAxes(const Vector3T<T> &x, const Vector3T<T> &y, const Vector3T<T> &z)
 {
     mtx[0][0] = x.x,  mtx[0][1] = x.y,  mtx[0][2] = x.z;
     mtx[1][0] = y.x,  mtx[1][1] = y.y,  mtx[1][2] = y.z;
     mtx[2][0] = z.x,  mtx[2][1] = z.y,  mtx[2][2] = z.z;
 }
 
-inline void Matrix3::fromAxesTransposed(const Vector3 &x, const Vector3 &y, const Vector3 &z)
+template <typename T>
+inline void Matrix3T<T>::fromAxesTransposed(const Vector3T<T> &x, const Vector3T<T> &y, const Vector3T<T> &z)
 {
     mtx[0][0] = x.x,  mtx[0][1] = y.x,  mtx[0][2] = z.x;
     mtx[1][0] = x.y,  mtx[1][1] = y.y,  mtx[1][2] = z.y;
     mtx[2][0] = x.z,  mtx[2][1] = y.z,  mtx[2][2] = z.z;
 }
 
-inline void Matrix3::identity()
+template <typename T>
+inline void Matrix3T<T>::identity()
 {
-    mtx[0][0] = 1.0f, mtx[0][1] = 0.0f, mtx[0][2] = 0.0f;
-    mtx[1][0] = 0.0f, mtx[1][1] = 1.0f, mtx[1][2] = 0.0f;
-    mtx[2][0] = 0.0f, mtx[2][1] = 0.0f, mtx[2][2] = 1.0f;
+    mtx[0][0] = T(1), mtx[0][1] = T(0), mtx[0][2] = T(0);
+    mtx[1][0] = T(0), mtx[1][1] = T(1), mtx[1][2] = T(0);
+    mtx[2][0] = T(0), mtx[2][1] = T(0), mtx[2][2] = T(1);
 }
 
-inline void Matrix3::toAxes(Vector3 &x, Vector3 &y, Vector3 &z) const
+template <typename T>
+inline void Matrix3T<T>::toAxes(Vector3T<T> &x, Vector3T<T> &y, Vector3T<T> &z) const
 {
     x.set(mtx[0][0], mtx[0][1], mtx[0][2]);
     y.set(mtx[1][0], mtx[1][1], mtx[1][2]);
     z.set(mtx[2][0], mtx[2][1], mtx[2][2]);
 }
 
-inline void Matrix3::toAxesTransposed(Vector3 &x, Vector3 &y, Vector3 &z) const
+template <typename T>
+inline void Matrix3T<T>::toAxesTransposed(Vector3T<T> &x, Vector3T<T> &y, Vector3T<T> &z) const
 {
     x.set(mtx[0][0], mtx[1][0], mtx[2][0]);
     y.set(mtx[0][1], mtx[1][1], mtx[2][1]);
     z.set(mtx[0][2], mtx[1][2], mtx[2][2]);
 }
 
-inline Matrix3 Matrix3::transpose() const
+template <typename T>
+constexpr Matrix3T<T> Matrix3T<T>::transpose() const
 {
-    Matrix3 tmp;
-
-    tmp[0][0] = mtx[0][0], tmp[0][1] = mtx[1][0], tmp[0][2] = mtx[2][0];
-    tmp[1][0] = mtx[0][1], tmp[1][1] = mtx[1][1], tmp[1][2] = mtx[2][1];
-    tmp[2][0] = mtx[0][2], tmp[2][1] = mtx[1][2], tmp[2][2] = mtx[2][2];
-
-    return tmp;
+    return Matrix3T<T>(mtx[0][0], mtx[1][0], mtx[2][0],
+                       mtx[0][1], mtx[1][1], mtx[2][1],
+                       mtx[0][2], mtx[1][2], mtx[2][2]);
 }
 
+template <typename T>
+constexpr Matrix3T<T> Matrix3T<T>::IDENTITY(T(1), T(0), T(0),
+                                            T(0), T(1), T(0),
+                                            T(0), T(0), T(1));
+
 //-----------------------------------------------------------------------------
 // A homogeneous row-major 4x4 matrix class.
 //
 // Matrices are concatenated in a left to right order.
 // Multiplies vectors to the left of the matrix.
+//
+// createPerspective() builds an OpenGL style perspective projection: the
+// camera looks down -z in view space, 'fovyDegrees' is the vertical field of
+// view, and depths from 'znear' to 'zfar' map to -1 to 1. Its planes are the
+// ones Frustum::fromPerspective() builds.
 
-class Matrix4
+template <typename T>
+class Matrix4T
 {
-    friend Vector4 operator*(const Vector4 &lhs, const Matrix4 &rhs);
-    friend Vector3 operator*(const Vector3 &lhs, const Matrix4 &rhs);
-    friend Matrix4 operator*(float scalar, const Matrix4 &rhs);
+    template <typename U> friend constexpr Vector4T<U> operator*(const Vector4T<U> &lhs, const Matrix4T<U> &rhs);
+    template <typename U> friend constexpr Vector3T<U> operator*(const Vector3T<U> &lhs, const Matrix4T<U> &rhs);
 
 public:
-    static const Matrix4 IDENTITY;
-    static Matrix4 createFromAxes(const Vector3 &x, const Vector3 &y, const Vector3 &z);
-    static Matrix4 createFromAxesTransposed(const Vector3 &x, const Vector3 &y, const Vector3 &z);
-    static Matrix4 createFromHeadPitchRoll(float headDegrees, float pitchDegrees, float rollDegrees);
-    static Matrix4 createMirror(const Vector3 &planeNormal, const Vector3 &pointOnPlane);
-    static Matrix4 createOrient(const Vector3 &from, const Vector3 &to);
-    static Matrix4 createRotate(const Vector3 &axis, float degrees);
-    static Matrix4 createScale(float sx, float sy, float sz);
-    static Matrix4 createTranslate(float tx, float ty, float tz);
-
-    Matrix4() : mtx{{0.0f, 0.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 0.0f, 0.0f}} {}
-    Matrix4(float m11, float m12, float m13, float m14,
-            float m21, float m22, float m23, float m24,
-            float m31, float m32, float m33, float m34,
-            float m41, float m42, float m43, float m44);
-    ~Matrix4() {}
-
-    float *operator[](int row);
-    const float *operator[](int row) const;
-
-    bool operator==(const Matrix4 &rhs) const;
-    bool operator!=(const Matrix4 &rhs) const;
-
-    Matrix4 &operator+=(const Matrix4 &rhs);
-    Matrix4 &operator-=(const Matrix4 &rhs);
-    Matrix4 &operator*=(const Matrix4 &rhs);
-    Matrix4 &operator*=(float scalar);
-    Matrix4 &operator/=(float scalar);
-
-    Matrix4 operator+(const Matrix4 &rhs) const;
-    Matrix4 operator-(const Matrix4 &rhs) const;
-    Matrix4 operator*(const Matrix4 &rhs) const;
-    Matrix4 operator*(float scalar) const;
-    Matrix4 operator/(float scalar) const;
-
-    float determinant() const;
-    void fromAxes(const Vector3 &x, const Vector3 &y, const Vector3 &z);
-    void fromAxesTransposed(const Vector3 &x, const Vector3 &y, const Vector3 &z);
-    void fromHeadPitchRoll(float headDegrees, float pitchDegrees, float rollDegrees);
+    static const Matrix4T IDENTITY;
+    static Matrix4T createFromAxes(const Vector3T<T> &x, const Vector3T<T> &y, const Vector3T<T> &z);
+    static Matrix4T createFromAxesTransposed(const Vector3T<T> &x, const Vector3T<T> &y, const Vector3T<T> &z);
+    static Matrix4T createFromHeadPitchRoll(T headDegrees, T pitchDegrees, T rollDegrees);
+    static Matrix4T createMirror(const Vector3T<T> &planeNormal, const Vector3T<T> &pointOnPlane);
+    static Matrix4T createOrient(const Vector3T<T> &from, const Vector3T<T> &to);
+    static Matrix4T createPerspective(T fovyDegrees, T aspect, T znear, T zfar);
+    static Matrix4T createRotate(const Vector3T<T> &axis, T degrees);
+    static constexpr Matrix4T createScale(T sx, T sy, T sz);
+    static constexpr Matrix4T createTranslate(T tx, T ty, T tz);
+
+    constexpr Matrix4T() : mtx{} {}
+    constexpr Matrix4T(T m11, T m12, T m13, T m14,
+            T m21, T m22, T m23, T m24,
+            T m31, T m32, T m33, T m34,
+            T m41, T m42, T m43, T m44);
+    template <typename U> constexpr explicit Matrix4T(const Matrix4T<U> &m);
+
+    T *operator[](int row);
+    constexpr const T *operator[](int row) const;
+
+    bool operator==(const Matrix4T &rhs) const;
+    bool operator!=(const Matrix4T &rhs) const;
+
+    Matrix4T &operator+=(const Matrix4T &rhs);
+    Matrix4T &operator-=(const Matrix4T &rhs);
+    Matrix4T &operator*=(const Matrix4T &rhs);
+    Matrix4T &operator*=(T scalar);
+    Matrix4T &operator/=(T scalar);
+
+    constexpr Matrix4T operator+(const Matrix4T &rhs) const;
+    constexpr Matrix4T operator-(const Matrix4T &rhs) const;
+    constexpr Matrix4T operator*(const Matrix4T &rhs) const;
+    constexpr Matrix4T operator*(T scalar) const;
+    constexpr Matrix4T operator/(T scalar) const;
+
+    constexpr T determinant() const;
+    void fromAxes(const Vector3T<T> &x, const Vector3T<T> &y, const Vector3T<T> &z);
+    void fromAxesTransposed(const Vector3T<T> &x, const Vector3T<T> &y, const Vector3T<T> &z);
+    void fromHeadPitchRoll(T headDegrees, T pitchDegrees, T rollDegrees);
     void identity();
-    Matrix4 inverse() const;
-    void orient(const Vector3 &from, const Vector3 &to);
-    void rotate(const Vector3 &axis, float degrees);
-    void scale(float sx, float sy, float sz);
-    void toAxes(Vector3 &x, Vector3 &y, Vector3 &z) const;
-    void toAxesTransposed(Vector3 &x, Vector3 &y, Vector3 &z) const;
-    void toHeadPitchRoll(float &headDegrees, float &pitchDegrees, float &rollDegrees) const;
-    void translate(float tx, float ty, float tz);
-    Matrix4 transpose() const;
+    Matrix4T inverse() const;
+    bool inverseAffine(Matrix4T &result) const;
+    bool inverseGeneral(Matrix4T &result) const;
+    Matrix4T inverseRigid() const;
+    void orient(const Vector3T<T> &from, const Vector3T<T> &to);
+    void rotate(const Vector3T<T> &axis, T degrees);
+    void scale(T sx, T sy, T sz);
+    void toAxes(Vector3T<T> &x, Vector3T<T> &y, Vector3T<T> &z) const;
+    void toAxesTransposed(Vector3T<T> &x, Vector3T<T> &y, Vector3T<T> &z) const;
+    void toHeadPitchRoll(T &headDegrees, T &pitchDegrees, T &rollDegrees) const;
+    void translate(T tx, T ty, T tz);
+    constexpr Matrix4T transpose() const;
 
 private:
-    float mtx[4][4];
+    T mtx[4][4];
 };
 
-inline Vector4 operator*(const Vector4 &lhs, const Matrix4 &rhs)
+template <typename T>
+constexpr Vector4T<T> operator*(const Vector4T<T> &lhs, const Matrix4T<T> &rhs)
 {
-    return Vector4(
+    return Vector4T<T>(
         (lhs.x * rhs.mtx[0][0]) + (lhs.y * rhs.mtx[1][0]) + (lhs.z * rhs.mtx[2][0]) + (lhs.w * rhs.mtx[3][0]),
         (lhs.x * rhs.mtx[0][1]) + (lhs.y * rhs.mtx[1][1]) + (lhs.z * rhs.mtx[2][1]) + (lhs.w * rhs.mtx[3][1]),
         (lhs.x * rhs.mtx[0][2]) + (lhs.y * rhs.mtx[1][2]) + (lhs.z * rhs.mtx[2][2]) + (lhs.w * rhs.mtx[3][2]),
         (lhs.x * rhs.mtx[0][3]) + (lhs.y * rhs.mtx[1][3]) + (lhs.z * rhs.mtx[2][3]) + (lhs.w * rhs.mtx[3][3]));
 }
 
-inline Vector3 operator*(const Vector3 &lhs, const Matrix4 &rhs)
+template <typename T>
+constexpr Vector3T<T> operator*(const Vector3T<T> &lhs, const Matrix4T<T> &rhs)
 {
-    return Vector3(
+    return Vector3T<T>(
         (lhs.x * rhs.mtx[0][0]) + (lhs.y * rhs.mtx[1][0]) + (lhs.z * rhs.mtx[2][0]),
         (lhs.x * rhs.mtx[0][1]) + (lhs.y * rhs.mtx[1][1]) + (lhs.z * rhs.mtx[2][1]),
         (lhs.x * rhs.mtx[0][2]) + (lhs.y * rhs.mtx[1][2]) + (lhs.z * rhs.mtx[2][2]));
 }
 
-inline Matrix4 operator*(float scalar, const Matrix4 &rhs)
+template <typename T>
+constexpr Matrix4T<T> operator*(T scalar, const Matrix4T<T> &rhs)
 {
     return rhs * scalar;
 }
 
-inline Matrix4 Matrix4::createFromAxes(const Vector3 &x, const Vector3 &y, const Vector3 &z)
+template <typename T>
+inline Matrix4T<T> Matrix4T<T>::createFromAxes(const Vector3T<T> &x, const Vector3T<T> &y, const Vector3T<T> &z)
 {
-    Matrix4 tmp;
+    Matrix4T<T> tmp;
     tmp.fromAxes(x, y, z);
     return tmp;
 }
 
-inline Matrix4 Matrix4::createFromAxesTransposed(const Vector3 &x, const Vector3 &y, const Vector3 &z)
+template <typename T>
+inline Matrix4T<T> Matrix4T<T>::createFromAxesTransposed(const Vector3T<T> &x, const Vector3T<T> &y, const Vector3T<T> &z)
 {
-    Matrix4 tmp;
+    Matrix4T<T> tmp;
     tmp.fromAxesTransposed(x, y, z);
     return tmp;
 }
 
-inline Matrix4 Matrix4::createFromHeadPitchRoll(float headDegrees, float pitchDegrees, float rollDegrees)
+template <typename T>
+inline Matrix4T<T> Matrix4T<T>::createFromHeadPitchRoll(T headDegrees, T pitchDegrees, T rollDegrees)
 {
-    Matrix4 tmp;
+    Matrix4T<T> tmp;
     tmp.fromHeadPitchRoll(headDegrees, pitchDegrees, rollDegrees);
     return tmp;
 }
 
-inline Matrix4 Matrix4::createOrient(const Vector3 &from, const Vector3 &to)
+template <typename T>
+inline Matrix4T<T> Matrix4T<T>::createOrient(const Vector3T<T> &from, const Vector3T<T> &to)
 {
-    Matrix4 tmp;
+    Matrix4T<T> tmp;
     tmp.orient(from, to);
     return tmp;
 }
 
-inline Matrix4 Matrix4::createRotate(const Vector3 &axis, float degrees)
+template <typename T>
+inline Matrix4T<T> Matrix4T<T>::createRotate(const Vector3T<T> &axis, T degrees)
 {
-    Matrix4 tmp;
+    Matrix4T<T> tmp;
     tmp.rotate(axis, degrees);
     return tmp;
 }
 
-inline Matrix4 Matrix4::createScale(float sx, float sy, float sz)
+template <typename T>
+constexpr Matrix4T<T> Matrix4T<T>::createScale(T sx, T sy, T sz)
 {
-    Matrix4 tmp;
-    tmp.scale(sx, sy, sz);
-    return tmp;
+    return Matrix4T<T>(sx, T(0), T(0), T(0),
+                       T(0), sy, T(0), T(0),
+                       T(0), T(0), sz, T(0),
+                       T(0), T(0), T(0), T(1));
 }
 
-inline Matrix4 Matrix4::createTranslate(float tx, float ty, float tz)
+template <typename T>
+constexpr Matrix4T<T> Matrix4T<T>::createTranslate(T tx, T ty, T tz)
 {
-    Matrix4 tmp;
-    tmp.translate(tx, ty, tz);
-    return tmp;
+    return Matrix4T<T>(T(1), T(0), T(0), T(0),
+                       T(0), T(1), T(0), T(0),
+                       T(0), T(0), T(1), T(0),
+                       tx, ty, tz, T(1));
 }
 
-inline Matrix4::Matrix4(float m11, float m12, float m13, float m14,
-                      float m21, float m22, float m23, float m24,
-                      float m31, float m32, float m33, float m34,
-                      float m41, float m42, float m43, float m44)
-{
-    mtx[0][0] = m11, mtx[0][1] = m12, mtx[0][2] = m13, mtx[0][3] = m14;
-    mtx[1][0] = m21, mtx[1][1] = m22, mtx[1][2] = m23, mtx[1][3] = m24;
-    mtx[2][0] = m31, mtx[2][1] = m32, mtx[2][2] = m33, mtx[2][3] = m34;
-    mtx[3][0] = m41, mtx[3][1] = m42, mtx[3][2] = m43, mtx[3][3] = m44;
-}
+template <typename T>
+constexpr Matrix4T<T>::Matrix4T(T m11, T m12, T m13, T m14,
+                      T m21, T m22, T m23, T m24,
+                      T m31, T m32, T m33, T m34,
+                      T m41, T m42, T m43, T m44)
+    : mtx{{m11, m12, m13, m14}, {m21, m22, m23, m24}, {m31, m32, m33, m34}, {m41, m42, m43, m44}} {}
+
+template <typename T>
+template <typename U>
+constexpr Matrix4T<T>::Matrix4T(const Matrix4T<U> &m)
+    : mtx{{static_cast<T>(m[0][0]), static_cast<T>(m[0][1]), static_cast<T>(m[0][2]), static_cast<T>(m[0][3])},
+          {static_cast<T>(m[1][0]), static_cast<T>(m[1][1]), static_cast<T>(m[1][2]), static_cast<T>(m[1][3])},
+          {static_cast<T>(m[2][0]), static_cast<T>(m[2][1]), static_cast<T>(m[2][2]), static_cast<T>(m[2][3])},
+          {static_cast<T>(m[3][0]), static_cast<T>(m[3][1]), static_cast<T>(m[3][2]), static_cast<T>(m[3][3])}} {}
 
-inline float *Matrix4::operator[](int row)
+template <typename T>
+inline T *Matrix4T<T>::operator[](int row)
 {
     return mtx[row];
 }
 
-inline const float *Matrix4::operator[](int row) const
+template <typename T>
+constexpr const T *Matrix4T<T>::operator[](int row) const
 {
     return mtx[row];
 }
 
-inline bool Matrix4::operator==(const Matrix4 &rhs) const
+template <typename T>
+inline bool Matrix4T<T>::operator==(const Matrix4T<T> &rhs) const
 {
-    return Math::closeEnough(mtx[0][0], rhs.mtx[0][0])
-        && Math::closeEnough(mtx[0][1], rhs.mtx[0][1])
-        && Math::closeEnough(mtx[0][2], rhs.mtx[0][2])
-        && Math::closeEnough(mtx[0][3], rhs.mtx[0][3])
-        && Math::closeEnough(mtx[1][0], rhs.mtx[1][0])
-        && Math::closeEnough(mtx[1][1], rhs.mtx[1][1])
-        && Math::closeEnough(mtx[1][2], rhs.mtx[1][2])
-        && Math::closeEnough(mtx[1][3], rhs.mtx[1][3])
-        && Math::closeEnough(mtx[2][0], rhs.mtx[2][0])
-        && Math::closeEnough(mtx[2][1], rhs.mtx[2][1])
-        && Math::closeEnough(mtx[2][2], rhs.mtx[2][2])
-        && Math::closeEnough(mtx[2][3], rhs.mtx[2][3])
-        && Math::closeEnough(mtx[3][0], rhs.mtx[3][0])
-        && Math::closeEnough(mtx[3][1], rhs.mtx[3][1])
-        && Math::closeEnough(mtx[3][2], rhs.mtx[3][2])
-        && Math::closeEnough(mtx[3][3], rhs.mtx[3][3]);
+    return ScalarMath<T>::closeEnough(mtx[0][0], rhs.mtx[0][0])
+        && ScalarMath<T>::closeEnough(mtx[0][1], rhs.mtx[0][1])
+        && ScalarMath<T>::closeEnough(mtx[0][2], rhs.mtx[0][2])
+        && ScalarMath<T>::closeEnough(mtx[0][3], rhs.mtx[0][3])
+        && ScalarMath<T>::closeEnough(mtx[1][0], rhs.mtx[1][0])
+        && ScalarMath<T>::closeEnough(mtx[1][1], rhs.mtx[1][1])
+        && ScalarMath<T>::closeEnough(mtx[1][2], rhs.mtx[1][2])
+        && ScalarMath<T>::closeEnough(mtx[1][3], rhs.mtx[1][3])
+        && ScalarMath<T>::closeEnough(mtx[2][0], rhs.mtx[2][0])
+        && ScalarMath<T>::closeEnough(mtx[2][1], rhs.mtx[2][1])
+        && ScalarMath<T>::closeEnough(mtx[2][2], rhs.mtx[2][2])
+        && ScalarMath<T>::closeEnough(mtx[2][3], rhs.mtx[2][3])
+        && ScalarMath<T>::closeEnough(mtx[3][0], rhs.mtx[3][0])
+        && ScalarMath<T>::closeEnough(mtx[3][1], rhs.mtx[3][1])
+        && ScalarMath<T>::closeEnough(mtx[3][2], rhs.mtx[3][2])
+        && ScalarMath<T>::closeEnough(mtx[3][3], rhs.mtx[3][3]);
 }
 
-inline bool Matrix4::operator!=(const Matrix4 &rhs) const
+template <typename T>
+inline bool Matrix4T<T>::operator!=(const Matrix4T<T> &rhs) const
 {
     return !(*this == rhs);
 }
 
-inline Matrix4 &Matrix4::operator+=(const Matrix4 &rhs)
+template <typename T>
+inline Matrix4T<T> &Matrix4T<T>::operator+=(const Matrix4T<T> &rhs)
 {
     mtx[0][0] += rhs.mtx[0][0], mtx[0][1] += rhs.mtx[0][1], mtx[0][2] += rhs.mtx[0][2], mtx[0][3] += rhs.mtx[0][3];
     mtx[1][0] += rhs.mtx[1][0], mtx[1][1] += rhs.mtx[1][1], mtx[1][2] += rhs.mtx[1][2], mtx[1][3] += rhs.mtx[1][3];
@@ -1250,7 +1845,8 @@ inline Matrix4 &Matrix4::operator+=(const Matrix4 &rhs)
     return *this;
 }
 
-inline Matrix4 &Matrix4::operator-=(const Matrix4 &rhs)
+template <typename T>
+inline Matrix4T<T> &Matrix4T<T>::operator-=(const Matrix4T<T> &rhs)
 {
     mtx[0][0] -= rhs.mtx[0][0], mtx[0][1] -= rhs.mtx[0][1], mtx[0][2] -= rhs.mtx[0][2], mtx[0][3] -= rhs.mtx[0][3];
     mtx[1][0] -= rhs.mtx[1][0], mtx[1][1] -= rhs.mtx[1][1], mtx[1][2] -= rhs.mtx[1][2], mtx[1][3] -= rhs.mtx[1][3];
@@ -1259,39 +1855,15 @@ inline Matrix4 &Matrix4::operator-=(const Matrix4 &rhs)
     return *this;
 }
 
-inline Matrix4 &Matrix4::operator*=(const Matrix4 &rhs)
+template <typename T>
+inline Matrix4T<T> &Matrix4T<T>::operator*=(const Matrix4T<T> &rhs)
 {
-    Matrix4 tmp;
-
-    // Row 1.
-    tmp.mtx[0][0] = (mtx[0][0] * rhs.mtx[0][0]) + (mtx[0][1] * rhs.mtx[1][0]) + (mtx[0][2] * rhs.mtx[2][0]) + (mtx[0][3] * rhs.mtx[3][0]);
-    tmp.mtx[0][1] = (mtx[0][0] * rhs.mtx[0][1]) + (mtx[0][1] * rhs.mtx[1][1]) + (mtx[0][2] * rhs.mtx[2][1]) + (mtx[0][3] * rhs.mtx[3][1]);
-    tmp.mtx[0][2] = (mtx[0][0] * rhs.mtx[0][2]) + (mtx[0][1] * rhs.mtx[1][2]) + (mtx[0][2] * rhs.mtx[2][2]) + (mtx[0][3] * rhs.mtx[3][2]);
-    tmp.mtx[0][3] = (mtx[0][0] * rhs.mtx[0][3]) + (mtx[0][1] * rhs.mtx[1][3]) + (mtx[0][2] * rhs.mtx[2][3]) + (mtx[0][3] * rhs.mtx[3][3]);
-
-    // Row 2.
-    tmp.mtx[1][0] = (mtx[1][0] * rhs.mtx[0][0]) + (mtx[1][1] * rhs.mtx[1][0]) + (mtx[1][2] * rhs.mtx[2][0]) + (mtx[1][3] * rhs.mtx[3][0]);
-    tmp.mtx[1][1] = (mtx[1][0] * rhs.mtx[0][1]) + (mtx[1][1] * rhs.mtx[1][1]) + (mtx[1][2] * rhs.mtx[2][1]) + (mtx[1][3] * rhs.mtx[3][1]);
-    tmp.mtx[1][2] = (mtx[1][0] * rhs.mtx[0][2]) + (mtx[1][1] * rhs.mtx[1][2]) + (mtx[1][2] * rhs.mtx[2][2]) + (mtx[1][3] * rhs.mtx[3][2]);
-    tmp.mtx[1][3] = (mtx[1][0] * rhs.mtx[0][3]) + (mtx[1][1] * rhs.mtx[1][3]) + (mtx[1][2] * rhs.mtx[2][3]) + (mtx[1][3] * rhs.mtx[3][3]);
-
-    // Row 3.
-    tmp.mtx[2][0] = (mtx[2][0] * rhs.mtx[0][0]) + (mtx[2][1] * rhs.mtx[1][0]) + (mtx[2][2] * rhs.mtx[2][0]) + (mtx[2][3] * rhs.mtx[3][0]);
-    tmp.mtx[2][1] = (mtx[2][0] * rhs.mtx[0][1]) + (mtx[2][1] * rhs.mtx[1][1]) + (mtx[2][2] * rhs.mtx[2][1]) + (mtx[2][3] * rhs.mtx[3][1]);
-    tmp.mtx[2][2] = (mtx[2][0] * rhs.mtx[0][2]) + (mtx[2][1] * rhs.mtx[1][2]) + (mtx[2][2] * rhs.mtx[2][2]) + (mtx[2][3] * rhs.mtx[3][2]);
-    tmp.mtx[2][3] = (mtx[2][0] * rhs.mtx[0][3]) + (mtx[2][1] * rhs.mtx[1][3]) + (mtx[2][2] * rhs.mtx[2][3]) + (mtx[2][3] * rhs.mtx[3][3]);
-
-    // Row 4.
-    tmp.mtx[3][0] = (mtx[3][0] * rhs.mtx[0][0]) + (mtx[3][1] * rhs.mtx[1][0]) + (mtx[3][2] * rhs.mtx[2][0]) + (mtx[3][3] * rhs.mtx[3][0]);
-    tmp.mtx[3][1] = (mtx[3][0] * rhs.mtx[0][1]) + (mtx[3][1] * rhs.mtx[1][1]) + (mtx[3][2] * rhs.mtx[2][1]) + (mtx[3][3] * rhs.mtx[3][1]);
-    tmp.mtx[3][2] = (mtx[3][0] * rhs.mtx[0][2]) + (mtx[3][1] * rhs.mtx[1][2]) + (mtx[3][2] * rhs.mtx[2][2]) + (mtx[3][3] * rhs.mtx[3][2]);
-    tmp.mtx[3][3] = (mtx[3][0] * rhs.mtx[0][3]) + (mtx[3][1] * rhs.mtx[1][3]) + (mtx[3][2] * rhs.mtx[2][3]) + (mtx[3][3] * rhs.mtx[3][3]);
-
-    *this = tmp;
+    *this = *this * rhs;
     return *this;
 }
 
-inline Matrix4 &Matrix4::operator*=(float scalar)
+template <typename T>
+inline Matrix4T<T> &Matrix4T<T>::operator*=(T scalar)
 {
     mtx[0][0] *= scalar, mtx[0][1] *= scalar, mtx[0][2] *= scalar, mtx[0][3] *= scalar;
     mtx[1][0] *= scalar, mtx[1][1] *= scalar, mtx[1][2] *= scalar, mtx[1][3] *= scalar;
@@ -1300,7 +1872,8 @@ inline Matrix4 &Matrix4::operator*=(float scalar)
     return *this;
 }
 
-inline Matrix4 &Matrix4::operator/=(float scalar)
+template <typename T>
+inline Matrix4T<T> &Matrix4T<T>::operator/=(T scalar)
 {
     mtx[0][0] /= scalar, mtx[0][1] /= scalar, mtx[0][2] /= scalar, mtx[0][3] /= scalar;
     mtx[1][0] /= scalar, mtx[1][1] /= scalar, mtx[1][2] /= scalar, mtx[1][3] /= scalar;
@@ -1309,42 +1882,73 @@ inline Matrix4 &Matrix4::operator/=(float scalar)
     return *this;
 }
 
-inline Matrix4 Matrix4::operator+(const Matrix4 &rhs) const
+template <typename T>
+constexpr Matrix4T<T> Matrix4T<T>::operator+(const Matrix4T<T> &rhs) const
 {
-    Matrix4 tmp(*this);
-    tmp += rhs;
-    return tmp;
+    return Matrix4T<T>(mtx[0][0] + rhs.mtx[0][0], mtx[0][1] + rhs.mtx[0][1], mtx[0][2] + rhs.mtx[0][2], mtx[0][3] + rhs.mtx[0][3],
+                       mtx[1][0] + rhs.mtx[1][0], mtx[1][1] + rhs.mtx[1][1], mtx[1][2] + rhs.mtx[1][2], mtx[1][3] + rhs.mtx[1][3],
+                       mtx[2][0] + rhs.mtx[2][0], mtx[2][1] + rhs.mtx[2][1], mtx[2][2] + rhs.mtx[2][2], mtx[2][3] + rhs.mtx[2][3],
+                       mtx[3][0] + rhs.mtx[3][0], mtx[3][1] + rhs.mtx[3][1], mtx[3][2] + rhs.mtx[3][2], mtx[3][3] + rhs.mtx[3][3]);
 }
 
-inline Matrix4 Matrix4::operator-(const Matrix4 &rhs) const
+template <typename T>
+constexpr Matrix4T<T> Matrix4T<T>::operator-(const Matrix4T<T> &rhs) const
 {
-    Matrix4 tmp(*this);
-    tmp -= rhs;
-    return tmp;
+    return Matrix4T<T>(mtx[0][0] - rhs.mtx[0][0], mtx[0][1] - rhs.mtx[0][1], mtx[0][2] - rhs.mtx[0][2], mtx[0][3] - rhs.mtx[0][3],
+                       mtx[1][0] - rhs.mtx[1][0], mtx[1][1] - rhs.mtx[1][1], mtx[1][2] - rhs.mtx[1][2], mtx[1][3] - rhs.mtx[1][3],
+                       mtx[2][0] - rhs.mtx[2][0], mtx[2][1] - rhs.mtx[2][1], mtx[2][2] - rhs.mtx[2][2], mtx[2][3] - rhs.mtx[2][3],
+                       mtx[3][0] - rhs.mtx[3][0], mtx[3][1] - rhs.mtx[3][1], mtx[3][2] - rhs.mtx[3][2], mtx[3][3] - rhs.mtx[3][3]);
 }
 
-inline Matrix4 Matrix4::operator*(const Matrix4 &rhs) const
+template <typename T>
+constexpr Matrix4T<T> Matrix4T<T>::operator*(const Matrix4T<T> &rhs) const
 {
-    Matrix4 tmp(*this);
-    tmp *= rhs;
-    return tmp;
+    return Matrix4T<T>(
+        // Row 1.
+        (mtx[0][0] * rhs.mtx[0][0]) + (mtx[0][1] * rhs.mtx[1][0]) + (mtx[0][2] * rhs.mtx[2][0]) + (mtx[0][3] * rhs.mtx[3][0]),
+        (mtx[0][0] * rhs.mtx[0][1]) + (mtx[0][1] * rhs.mtx[1][1]) + (mtx[0][2] * rhs.mtx[2][1]) + (mtx[0][3] * rhs.mtx[3][1]),
+        (mtx[0][0] * rhs.mtx[0][2]) + (mtx[0][1] * rhs.mtx[1][2]) + (mtx[0][2] * rhs.mtx[2][2]) + (mtx[0][3] * rhs.mtx[3][2]),
+        (mtx[0][0] * rhs.mtx[0][3]) + (mtx[0][1] * rhs.mtx[1][3]) + (mtx[0][2] * rhs.mtx[2][3]) + (mtx[0][3] * rhs.mtx[3][3]),
+
+        // Row 2.
+        (mtx[1][0] * rhs.mtx[0][0]) + (mtx[1][1] * rhs.mtx[1][0]) + (mtx[1][2] * rhs.mtx[2][0]) + (mtx[1][3] * rhs.mtx[3][0]),
+        (mtx[1][0] * rhs.mtx[0][1]) + (mtx[1][1] * rhs.mtx[1][1]) + (mtx[1][2] * rhs.mtx[2][1]) + (mtx[1][3] * rhs.mtx[3][1]),
+        (mtx[1][0] * rhs.mtx[0][2]) + (mtx[1][1] * rhs.mtx[1][2]) + (mtx[1][2] * rhs.mtx[2][2]) + (mtx[1][3] * rhs.mtx[3][2]),
+        (mtx[1][0] * rhs.mtx[0][3]) + (mtx[1][1] * rhs.mtx[1][3]) + (mtx[1][2] * rhs.mtx[2][3]) + (mtx[1][3] * rhs.mtx[3][3]),
+
+        // Row 3.
+        (mtx[2][0] * rhs.mtx[0][0]) + (mtx[2][1] * rhs.mtx[1][0]) + (mtx[2][2] * rhs.mtx[2][0]) + (mtx[2][3] * rhs.mtx[3][0]),
+        (mtx[2][0] * rhs.mtx[0][1]) + (mtx[2][1] * rhs.mtx[1][1]) + (mtx[2][2] * rhs.mtx[2][1]) + (mtx[2][3] * rhs.mtx[3][1]),
+        (mtx[2][0] * rhs.mtx[0][2]) + (mtx[2][1] * rhs.mtx[1][2]) + (mtx[2][2] * rhs.mtx[2][2]) + (mtx[2][3] * rhs.mtx[3][2]),
+        (mtx[2][0] * rhs.mtx[0][3]) + (mtx[2][1] * rhs.mtx[1][3]) + (mtx[2][2] * rhs.mtx[2][3]) + (mtx[2][3] * rhs.mtx[3][3]),
+
+        // Row 4.
+        (mtx[3][0] * rhs.mtx[0][0]) + (mtx[3][1] * rhs.mtx[1][0]) + (mtx[3][2] * rhs.mtx[2][0]) + (mtx[3][3] * rhs.mtx[3][0]),
+        (mtx[3][0] * rhs.mtx[0][1]) + (mtx[3][1] * rhs.mtx[1][1]) + (mtx[3][2] * rhs.mtx[2][1]) + (mtx[3][3] * rhs.mtx[3][1]),
+        (mtx[3][0] * rhs.mtx[0][2]) + (mtx[3][1] * rhs.mtx[1][2]) + (mtx[3][2] * rhs.mtx[2][2]) + (mtx[3][3] * rhs.mtx[3][2]),
+        (mtx[3][0] * rhs.mtx[0][3]) + (mtx[3][1] * rhs.mtx[1][3]) + (mtx[3][2] * rhs.mtx[2][3]) + (mtx[3][3] * rhs.mtx[3][3]));
 }
 
-inline Matrix4 Matrix4::operator*(float scalar) const
+template <typename T>
+constexpr Matrix4T<T> Matrix4T<T>::operator*(T scalar) const
 {
-    Matrix4 tmp(*this);
-    tmp *= scalar;
-    return tmp;
+    return Matrix4T<T>(mtx[0][0] * scalar, mtx[0][1] * scalar, mtx[0][2] * scalar, mtx[0][3] * scalar,
+                       mtx[1][0] * scalar, mtx[1][1] * scalar, mtx[1][2] * scalar, mtx[1][3] * scalar,
+                       mtx[2][0] * scalar, mtx[2][1] * scalar, mtx[2][2] * scalar, mtx[2][3] * scalar,
+                       mtx[3][0] * scalar, mtx[3][1] * scalar, mtx[3][2] * scalar, mtx[3][3] * scalar);
 }
 
-inline Matrix4 Matrix4::operator/(float scalar) const
+template <typename T>
+constexpr Matrix4T<T> Matrix4T<T>::operator/(T scalar) const
 {
-    Matrix4 tmp(*this);
-    tmp /= scalar;
-    return tmp;
+    return Matrix4T<T>(mtx[0][0] / scalar, mtx[0][1] / scalar, mtx[0][2] / scalar, mtx[0][3] / scalar,
+                       mtx[1][0] / scalar, mtx[1][1] / scalar, mtx[1][2] / scalar, mtx[1][3] / scalar,
+                       mtx[2][0] / scalar, mtx[2][1] / scalar, mtx[2][2] / scalar, mtx[2][3] / scalar,
+                       mtx[3][0] / scalar, mtx[3][1] / scalar, mtx[3][2] / scalar, mtx[3][3] / scalar);
 }
 
-inline float Matrix4::determinant() const
+template <typename T>
+constexpr T Matrix4T<T>::determinant() const
 {
     return (mtx[0][0] * mtx[1][1] - mtx[1][0] * mtx[0][1])
         * (mtx[2][2] * mtx[3][3] - mtx[3][2] * mtx[2][3])
@@ -1360,283 +1964,340 @@ inline float Matrix4::determinant() const
         * (mtx[0][2] * mtx[1][3] - mtx[1][2] * mtx[0][3]);
 }
 
-inline void Matrix4::fromAxes(const Vector3 &x, const Vector3 &y, const Vector3 &z)
+template <typename T>
+inline void Matrix4T<T>::fromAxes(const Vector3T<T> &x, const Vector3T<T> &y, const Vector3T<T> &z)
 {
-    mtx[0][0] = x.x,  mtx[0][1] = x.y,  mtx[0][2] = x.z,  mtx[0][3] = 0.0f;
-    mtx[1][0] = y.x,  mtx[1][1] = y.y,  mtx[1][2] = y.z,  mtx[1][3] = 0.0f;
-    mtx[2][0] = z.x,  mtx[2][1] = z.y,  mtx[2][2] = z.z,  mtx[2][3] = 0.0f;
-    mtx[3][0] = 0.0f, mtx[3][1] = 0.0f, mtx[3][2] = 0.0f, mtx[3][3] = 1.0f;
+    mtx[0][0] = x.x,  mtx[0][1] = x.y,  mtx[0][2] = x.z,  mtx[0][3] = T(0);
+    mtx[1][0] = y.x,  mtx[1][1] = y.y,  mtx[1][2] = y.z,  mtx[1][3] = T(0);
+    mtx[2][0] = z.x,  mtx[2][1] = z.y,  mtx[2][2] = z.z,  mtx[2][3] = T(0);
+    mtx[3][0] = T(0), mtx[3][1] = T(0), mtx[3][2] = T(0), mtx[3][3] = T(1);
 }
 
-inline void Matrix4::fromAxesTransposed(const Vector3 &x, const Vector3 &y, const Vector3 &z)
+template <typename T>
+inline void Matrix4T<T>::fromAxesTransposed(const Vector3T<T> &x, const Vector3T<T> &y, const Vector3T<T> &z)
 {
-    mtx[0][0] = x.x,  mtx[0][1] = y.x,  mtx[0][2] = z.x,  mtx[0][3] = 0.0f;
-    mtx[1][0] = x.y,  mtx[1][1] = y.y,  mtx[1][2] = z.y,  mtx[1][3] = 0.0f;
-    mtx[2][0] = x.z,  mtx[2][1] = y.z,  mtx[2][2] = z.z,  mtx[2][3] = 0.0f;
-    mtx[3][0] = 0.0f, mtx[3][1] = 0.0f, mtx[3][2] = 0.0f, mtx[3][3] = 1.0f;
+    mtx[0][0] = x.x,  mtx[0][1] = y.x,  mtx[0][2] = z.x,  mtx[0][3] = T(0);
+    mtx[1][0] = x.y,  mtx[1][1] = y.y,  mtx[1][2] = z.y,  mtx[1][3] = T(0);
+    mtx[2][0] = x.z,  mtx[2][1] = y.z,  mtx[2][2] = z.z,  mtx[2][3] = T(0);
+    mtx[3][0] = T(0), mtx[3][1] = T(0), mtx[3][2] = T(0), mtx[3][3] = T(1);
 }
 
-inline void Matrix4::identity()
+template <typename T>
+inline void Matrix4T<T>::identity()
 {
-    mtx[0][0] = 1.0f, mtx[0][1] = 0.0f, mtx[0][2] = 0.0f, mtx[0][3] = 0.0f;
-    mtx[1][0] = 0.0f, mtx[1][1] = 1.0f, mtx[1][2] = 0.0f, mtx[1][3] = 0.0f;
-    mtx[2][0] = 0.0f, mtx[2][1] = 0.0f, mtx[2][2] = 1.0f, mtx[2][3] = 0.0f;
-    mtx[3][0] = 0.0f, mtx[3][1] = 0.0f, mtx[3][2] = 0.0f, mtx[3][3] = 1.0f;
+    mtx[0][0] = T(1), mtx[0][1] = T(0), mtx[0][2] = T(0), mtx[0][3] = T(0);
+    mtx[1][0] = T(0), mtx[1][1] = T(1), mtx[1][2] = T(0), mtx[1][3] = T(0);
+    mtx[2][0] = T(0), mtx[2][1] = T(0), mtx[2][2] = T(1), mtx[2][3] = T(0);
+    mtx[3][0] = T(0), mtx[3][1] = T(0), mtx[3][2] = T(0), mtx[3][3] = T(1);
 }
 
-inline void Matrix4::toAxes(Vector3 &x, Vector3 &y, Vector3 &z) const
+template <typename T>
+inline void Matrix4T<T>::toAxes(Vector3T<T> &x, Vector3T<T> &y, Vector3T<T> &z) const
 {
     x.set(mtx[0][0], mtx[0][1], mtx[0][2]);
     y.set(mtx[1][0], mtx[1][1], mtx[1][2]);
     z.set(mtx[2][0], mtx[2][1], mtx[2][2]);
 }
 
-inline void Matrix4::toAxesTransposed(Vector3 &x, Vector3 &y, Vector3 &z) const
+template <typename T>
+inline void Matrix4T<T>::toAxesTransposed(Vector3T<T> &x, Vector3T<T> &y, Vector3T<T> &z) const
 {
     x.set(mtx[0][0], mtx[1][0], mtx[2][0]);
     y.set(mtx[0][1], mtx[1][1], mtx[2][1]);
     z.set(mtx[0][2], mtx[1][2], mtx[2][2]);
 }
 
-inline Matrix4 Matrix4::transpose() const
+template <typename T>
+constexpr Matrix4T<T> Matrix4T<T>::transpose() const
 {
-    Matrix4 tmp;
-
-    tmp[0][0] = mtx[0][0], tmp[0][1] = mtx[1][0], tmp[0][2] = mtx[2][0], tmp[0][3] = mtx[3][0];
-    tmp[1][0] = mtx[0][1], tmp[1][1] = mtx[1][1], tmp[1][2] = mtx[2][1], tmp[1][3] = mtx[3][1];
-    tmp[2][0] = mtx[0][2], tmp[2][1] = mtx[1][2], tmp[2][2] = mtx[2][2], tmp[2][3] = mtx[3][2];
-    tmp[3][0] = mtx[0][3], tmp[3][1] = mtx[1][3], tmp[3][2] = mtx[2][3], tmp[3][3] = mtx[3][3];
-
-    return tmp;
+    return Matrix4T<T>(mtx[0][0], mtx[1][0], mtx[2][0], mtx[3][0],
+                       mtx[0][1], mtx[1][1], mtx[2][1], mtx[3][1],
+                       mtx[0][2], mtx[1][2], mtx[2][2], mtx[3][2],
+                       mtx[0][3], mtx[1][3], mtx[2][3], mtx[3][3]);
 }
 
+template <typename T>
+constexpr Matrix4T<T> Matrix4T<T>::IDENTITY(T(1), T(0), T(0), T(0),
+                                            T(0), T(1), T(0), T(0),
+                                            T(0), T(0), T(1), T(0),
+                                            T(0), T(0), T(0), T(1));
+
 //-----------------------------------------------------------------------------
 // This Quaternion class will concatenate quaternions in a left to right order.
 // The reason for this is to maintain the same multiplication semantics as the
 // Matrix3 and Matrix4 classes.
 
-class Quaternion
+template <typename T>
+class QuaternionT
 {
-    friend Quaternion operator*(float lhs, const Quaternion &rhs);
-
 public:
-    static const Quaternion IDENTITY;
-
-    float w, x, y, z;
-
-    static Quaternion slerp(const Quaternion &a, const Quaternion &b, float t);
-
-    Quaternion() : w{}, x{}, y{}, z{} {}
-    Quaternion(float w_, float x_, float y_, float z_);
-    Quaternion(float headDegrees, float pitchDegrees, float rollDegrees);
-    Quaternion(const Vector3 &axis, float degrees);
-    explicit Quaternion(const Matrix3 &m);
-    explicit Quaternion(const Matrix4 &m);
-    ~Quaternion() {}
-
-    bool operator==(const Quaternion &rhs) const;
-    bool operator!=(const Quaternion &rhs) const;
-
-    Quaternion &operator+=(const Quaternion &rhs);
-    Quaternion &operator-=(const Quaternion &rhs);
-    Quaternion &operator*=(const Quaternion &rhs);
-    Quaternion &operator*=(float scalar);
-    Quaternion &operator/=(float scalar);
-
-    Quaternion operator+(const Quaternion &rhs) const;
-    Quaternion operator-(const Quaternion &rhs) const;
-    Quaternion operator*(const Quaternion &rhs) const;
-    Quaternion operator*(float scalar) const;
-    Quaternion operator/(float scalar) const;
-
-    Quaternion conjugate() const;
-    void fromAxisAngle(const Vector3 &axis, float degrees);
-    void fromHeadPitchRoll(float headDegrees, float pitchDegrees, float rollDegrees);
-    void fromMatrix(const Matrix3 &m);
-    void fromMatrix(const Matrix4 &m);
+    static const QuaternionT IDENTITY;
+
+    T w, x, y, z;
+
+    static QuaternionT slerp(const QuaternionT &a, const QuaternionT &b, T t);
+
+    constexpr QuaternionT() : w{}, x{}, y{}, z{} {}
+    constexpr QuaternionT(T w_, T x_, T y_, T z_);
+    QuaternionT(T headDegrees, T pitchDegrees, T rollDegrees);
+    QuaternionT(const Vector3T<T> &axis, T degrees);
+    explicit QuaternionT(const Matrix3T<T> &m);
+    explicit QuaternionT(const Matrix4T<T> &m);
+    template <typename U> constexpr explicit QuaternionT(const QuaternionT<U> &q);
+
+    bool operator==(const QuaternionT &rhs) const;
+    bool operator!=(const QuaternionT &rhs) const;
+
+    QuaternionT &operator+=(const QuaternionT &rhs);
+    QuaternionT &operator-=(const QuaternionT &rhs);
+    QuaternionT &operator*=(const QuaternionT &rhs);
+    QuaternionT &operator*=(T scalar);
+    QuaternionT &operator/=(T scalar);
+
+    constexpr QuaternionT operator+(const QuaternionT &rhs) const;
+    constexpr QuaternionT operator-(const QuaternionT &rhs) const;
+    constexpr QuaternionT operator*(const QuaternionT &rhs) const;
+    constexpr QuaternionT operator*(T scalar) const;
+    constexpr QuaternionT operator/(T scalar) const;
+
+    constexpr QuaternionT conjugate() const;
+    void fromAxisAngle(const Vector3T<T> &axis, T degrees);
+    void fromHeadPitchRoll(T headDegrees, T pitchDegrees, T rollDegrees);
+    void fromMatrix(const Matrix3T<T> &m);
+    void fromMatrix(const Matrix4T<T> &m);
     void identity();
-    Quaternion inverse() const;
-    float magnitude() const;
+    QuaternionT inverse() const;
+    T magnitude() const;
     void normalize();
-    void set(float w_, float x_, float y_, float z_);
-    void toAxisAngle(Vector3 &axis, float &degrees) const;
-    void toHeadPitchRoll(float &headDegrees, float &pitchDegrees, float &rollDegrees) const;
-    Matrix3 toMatrix3() const;
-    Matrix4 toMatrix4() const;
+    void set(T w_, T x_, T y_, T z_);
+    void toAxisAngle(Vector3T<T> &axis, T &degrees) const;
+    void toHeadPitchRoll(T &headDegrees, T &pitchDegrees, T &rollDegrees) const;
+    Matrix3T<T> toMatrix3() const;
+    Matrix4T<T> toMatrix4() const;
 };
 
-inline Quaternion operator*(float lhs, const Quaternion &rhs)
+template <typename T>
+constexpr QuaternionT<T> operator*(typename Identity<T>::type lhs, const QuaternionT<T> &rhs)
 {
     return rhs * lhs;
 }
 
-inline Quaternion::Quaternion(float w_, float x_, float y_, float z_) : w{w_}, x{x_}, y{y_}, z{z_} {}
+template <typename T>
+constexpr QuaternionT<T>::QuaternionT(T w_, T x_, T y_, T z_) : w{w_}, x{x_}, y{y_}, z{z_} {}
 
-inline Quaternion::Quaternion(float headDegrees, float pitchDegrees, float rollDegrees)
+template <typename T>
+inline QuaternionT<T>::QuaternionT(T headDegrees, T pitchDegrees, T rollDegrees)
 {
     fromHeadPitchRoll(headDegrees, pitchDegrees, rollDegrees);
 }
 
-inline Quaternion::Quaternion(const Vector3 &axis, float degrees)
+template <typename T>
+inline QuaternionT<T>::QuaternionT(const Vector3T<T> &axis, T degrees)
 {
     fromAxisAngle(axis, degrees);
 }
 
-inline Quaternion::Quaternion(const Matrix3 &m)
+template <typename T>
+inline QuaternionT<T>::QuaternionT(const Matrix3T<T> &m)
 {
     fromMatrix(m);
 }
 
-inline Quaternion::Quaternion(const Matrix4 &m)
+template <typename T>
+inline QuaternionT<T>::QuaternionT(const Matrix4T<T> &m)
 {
     fromMatrix(m);
 }
 
-inline bool Quaternion::operator==(const Quaternion &rhs) const
+template <typename T>
+template <typename U>
+constexpr QuaternionT<T>::QuaternionT(const QuaternionT<U> &q)
+    : w{static_cast<T>(q.w)}, x{static_cast<T>(q.x)}, y{static_cast<T>(q.y)}, z{static_cast<T>(q.z)} {}
+
+template <typename T>
+inline bool QuaternionT<T>::operator==(const QuaternionT<T> &rhs) const
 {
-    return Math::closeEnough(w, rhs.w) && Math::closeEnough(x, rhs.x)
-        && Math::closeEnough(y, rhs.y) && Math::closeEnough(z, rhs.z);
+    return ScalarMath<T>::closeEnough(w, rhs.w) && ScalarMath<T>::closeEnough(x, rhs.x)
+        && ScalarMath<T>::closeEnough(y, rhs.y) && ScalarMath<T>::closeEnough(z, rhs.z);
 }
 
-inline bool Quaternion::operator!=(const Quaternion &rhs) const
+template <typename T>
+inline bool QuaternionT<T>::operator!=(const QuaternionT<T> &rhs) const
 {
     return !(*this == rhs);
 }
 
-inline Quaternion &Quaternion::operator+=(const Quaternion &rhs)
+template <typename T>
+inline QuaternionT<T> &QuaternionT<T>::operator+=(const QuaternionT<T> &rhs)
 {
     w += rhs.w, x += rhs.x, y += rhs.y, z += rhs.z;
     return *this;
 }
 
-inline Quaternion &Quaternion::operator-=(const Quaternion &rhs)
+template <typename T>
+inline QuaternionT<T> &QuaternionT<T>::operator-=(const QuaternionT<T> &rhs)
 {
     w -= rhs.w, x -= rhs.x, y -= rhs.y, z -= rhs.z;
     return *this;
 }
 
-inline Quaternion &Quaternion::operator*=(const Quaternion &rhs)
+template <typename T>
+inline QuaternionT<T> &QuaternionT<T>::operator*=(const QuaternionT<T> &rhs)
 {
-    // Multiply so that rotations are applied in a left to right order.
-    Quaternion tmp(
-        (w * rhs.w) - (x * rhs.x) - (y * rhs.y) - (z * rhs.z),
-        (w * rhs.x) + (x * rhs.w) - (y * rhs.z) + (z * rhs.y),
-        (w * rhs.y) + (x * rhs.z) + (y * rhs.w) - (z * rhs.x),
-        (w * rhs.z) - (x * rhs.y) + (y * rhs.x) + (z * rhs.w));
-
-    /*
-    // Multiply so that rotations are applied in a right to left order.
-    Quaternion tmp(
-    (w * rhs.w) - (x * rhs.x) - (y * rhs.y) - (z * rhs.z),
-    (w * rhs.x) + (x * rhs.w) + (y * rhs.z) - (z * rhs.y),
-    (w * rhs.y) - (x * rhs.z) + (y * rhs.w) + (z * rhs.x),
-    (w * rhs.z) + (x * rhs.y) - (y * rhs.x) + (z * rhs.w));
-    */
-
-    *this = tmp;
+    *this = *this * rhs;
     return *this;
 }
 
-inline Quaternion &Quaternion::operator*=(float scalar)
+template <typename T>
+inline QuaternionT<T> &QuaternionT<T>::operator*=(T scalar)
 {
     w *= scalar, x *= scalar, y *= scalar, z *= scalar;
     return *this;
 }
 
-inline Quaternion &Quaternion::operator/=(float scalar)
+template <typename T>
+inline QuaternionT<T> &QuaternionT<T>::operator/=(T scalar)
 {
     w /= scalar, x /= scalar, y /= scalar, z /= scalar;
     return *this;
 }
 
-inline Quaternion Quaternion::operator+(const Quaternion &rhs) const
+template <typename T>
+constexpr QuaternionT<T> QuaternionT<T>::operator+(const QuaternionT<T> &rhs) const
 {
-    Quaternion tmp(*this);
-    tmp += rhs;
-    return tmp;
+    return QuaternionT<T>(w + rhs.w, x + rhs.x, y + rhs.y, z + rhs.z);
 }
 
-inline Quaternion Quaternion::operator-(const Quaternion &rhs) const
+template <typename T>
+constexpr QuaternionT<T> QuaternionT<T>::operator-(const QuaternionT<T> &rhs) const
 {
-    Quaternion tmp(*this);
-    tmp -= rhs;
-    return tmp;
+    return QuaternionT<T>(w - rhs.w, x - rhs.x, y - rhs.y, z - rhs.z);
 }
 
-inline Quaternion Quaternion::operator*(const Quaternion &rhs) const
+template <typename T>
+constexpr QuaternionT<T> QuaternionT<T>::operator*(const QuaternionT<T> &rhs) const
 {
-    Quaternion tmp(*this);
-    tmp *= rhs;
-    return tmp;
+    // Multiply so that rotations are applied in a left to right order.
+    return QuaternionT<T>(
+        (w * rhs.w) - (x * rhs.x) - (y * rhs.y) - (z * rhs.z),
+        (w * rhs.x) + (x * rhs.w) - (y * rhs.z) + (z * rhs.y),
+        (w * rhs.y) + (x * rhs.z) + (y * rhs.w) - (z * rhs.x),
+        (w * rhs.z) - (x * rhs.y) + (y * rhs.x) + (z * rhs.w));
+
+    /*
+    // Multiply so that rotations are applied in a right to left order.
+    return QuaternionT<T>(
+        (w * rhs.w) - (x * rhs.x) - (y * rhs.y) - (z * rhs.z),
+        (w * rhs.x) + (x * rhs.w) + (y * rhs.z) - (z * rhs.y),
+        (w * rhs.y) - (x * rhs.z) + (y * rhs.w) + (z * rhs.x),
+        (w * rhs.z) + (x * rhs.y) - (y * rhs.x) + (z * rhs.w));
+    */
 }
 
-inline Quaternion Quaternion::operator*(float scalar) const
+template <typename T>
+constexpr QuaternionT<T> QuaternionT<T>::operator*(T scalar) const
 {
-    Quaternion tmp(*this);
-    tmp *= scalar;
-    return tmp;
+    return QuaternionT<T>(w * scalar, x * scalar, y * scalar, z * scalar);
 }
 
-inline Quaternion Quaternion::operator/(float scalar) const
+template <typename T>
+constexpr QuaternionT<T> QuaternionT<T>::operator/(T scalar) const
 {
-    Quaternion tmp(*this);
-    tmp /= scalar;
-    return tmp;
+    return QuaternionT<T>(w / scalar, x / scalar, y / scalar, z / scalar);
 }
 
-inline Quaternion Quaternion::conjugate() const
+template <typename T>
+constexpr QuaternionT<T> QuaternionT<T>::conjugate() const
 {
-    Quaternion tmp(w, -x, -y, -z);
-    return tmp;
+    return QuaternionT<T>(w, -x, -y, -z);
 }
 
-inline void Quaternion::fromAxisAngle(const Vector3 &axis, float degrees)
+template <typename T>
+inline void QuaternionT<T>::fromAxisAngle(const Vector3T<T> &axis, T degrees)
 {
-    float halfTheta = Math::degreesToRadians(degrees) * 0.5f;
-    float s = sinf(halfTheta);
-    w = cosf(halfTheta), x = axis.x * s, y = axis.y * s, z = axis.z * s;
+    T halfTheta = ScalarMath<T>::degreesToRadians(degrees) * T(0.5);
+    T s, c;
+
+    ScalarMath<T>::sinCos(halfTheta, s, c);
+    w = c, x = axis.x * s, y = axis.y * s, z = axis.z * s;
 }
 
-inline void Quaternion::fromHeadPitchRoll(float headDegrees, float pitchDegrees, float rollDegrees)
+template <typename T>
+inline void QuaternionT<T>::fromHeadPitchRoll(T headDegrees, T pitchDegrees, T rollDegrees)
 {
-    Matrix3 m;
+    Matrix3T<T> m;
     m.fromHeadPitchRoll(headDegrees, pitchDegrees, rollDegrees);
     fromMatrix(m);
 }
 
-inline void Quaternion::identity()
+template <typename T>
+inline void QuaternionT<T>::identity()
 {
-    w = 1.0f, x = y = z = 0.0f;
+    w = T(1), x = y = z = T(0);
 }
 
-inline Quaternion Quaternion::inverse() const
+template <typename T>
+inline QuaternionT<T> QuaternionT<T>::inverse() const
 {
-    float invMag = 1.0f / magnitude();
+    T invMag = T(1) / magnitude();
     return conjugate() * invMag;
 }
 
-inline float Quaternion::magnitude() const
+template <typename T>
+inline T QuaternionT<T>::magnitude() const
 {
-    return sqrtf(w * w + x * x + y * y + z * z);
+    return ScalarMath<T>::sqrt(w * w + x * x + y * y + z * z);
 }
 
-inline void Quaternion::normalize()
+template <typename T>
+inline void QuaternionT<T>::normalize()
 {
-    float invMag = 1.0f / magnitude();
+    T invMag = ScalarMath<T>::rsqrt(w * w + x * x + y * y + z * z);
     w *= invMag, x *= invMag, y *= invMag, z *= invMag;
 }
 
-inline void Quaternion::set(float w_, float x_, float y_, float z_)
+template <typename T>
+inline void QuaternionT<T>::set(T w_, T x_, T y_, T z_)
 {
     w = w_, x = x_, y = y_, z = z_;
 }
 
-inline void Quaternion::toHeadPitchRoll(float &headDegrees, float &pitchDegrees, float &rollDegrees) const
+template <typename T>
+inline void QuaternionT<T>::toHeadPitchRoll(T &headDegrees, T &pitchDegrees, T &rollDegrees) const
 {
-    Matrix3 m = toMatrix3();
+    Matrix3T<T> m = toMatrix3();
     m.toHeadPitchRoll(headDegrees, pitchDegrees, rollDegrees);
 }
 
+template <typename T>
+constexpr QuaternionT<T> QuaternionT<T>::IDENTITY(T(1), T(0), T(0), T(0));
+
+//-----------------------------------------------------------------------------
+// Scalar type aliases.
+//
+// The float versions of the core types keep their original names. The double
+// versions have a 'd' suffix. Converting between the two is always explicit,
+// for example: Vector3 v(Vector3d(1.0, 2.0, 3.0)).
+//
+// The out of line members of Matrix3T, Matrix4T and QuaternionT are compiled
+// into the library for float and double only. There are no extern template
+// declarations for them: GCC then skips the constexpr members when the
+// library instantiates the classes, which breaks unoptimized builds.
+
+typedef Vector2T<float> Vector2;
+typedef Vector3T<float> Vector3;
+typedef Vector4T<float> Vector4;
+typedef Matrix3T<float> Matrix3;
+typedef Matrix4T<float> Matrix4;
+typedef QuaternionT<float> Quaternion;
+
+typedef Vector2T<double> Vector2d;
+typedef Vector3T<double> Vector3d;
+typedef Vector4T<double> Vector4d;
+typedef Matrix3T<double> Matrix3d;
+typedef Matrix4T<double> Matrix4d;
+typedef QuaternionT<double> Quaterniond;
+
 //-----------------------------------------------------------------------------
 // The MatrixStack utility class is used to maintain a stack of Matrix objects.
 // pushMatrix() copies the current matrix and adds the copy to the top of
@@ -1686,6 +2347,371 @@ private:
 	Error m_lastError;
 };
 
+//-----------------------------------------------------------------------------
+// The MatrixAllocator interface supplies raw storage for matrices. It is used
+// by InlineMatrixStack once a stack outgrows its inline storage. allocate()
+// returns uninitialized storage for 'count' matrices, or null if the request
+// can't be satisfied.
+//
+// The MatrixArena class is a MatrixAllocator that carves allocations out of a
+// single block allocated up front. deallocate() only reclaims the most recent
+// allocation; everything else is reclaimed at once by reset(). An arena is
+// not thread safe, so give each worker thread its own arena.
+
+class MatrixAllocator
+{
+public:
+    virtual ~MatrixAllocator() {}
+
+    virtual Matrix4 *allocate(unsigned int count) = 0;
+    virtual void deallocate(Matrix4 *p, unsigned int count) = 0;
+};
+
+class MatrixArena : public MatrixAllocator
+{
+public:
+    MatrixArena(unsigned int maxMatrices);
+    ~MatrixArena();
+
+    Matrix4 *allocate(unsigned int count);
+    void deallocate(Matrix4 *p, unsigned int count);
+    unsigned int capacity() const;
+    void reset();
+    unsigned int used() const;
+
+private:
+    MatrixArena(const MatrixArena &);
+    MatrixArena &operator=(const MatrixArena &);
+
+    Matrix4 *m_pBlock;
+    unsigned int m_capacity;
+    unsigned int m_used;
+};
+
+//-----------------------------------------------------------------------------
+// The InlineMatrixStack class template is a MatrixStack that stores the first
+// N matrices inside the object itself. Creating a stack and pushing up to N
+// matrices never touches the heap. Pushing beyond N doubles the capacity,
+// taking the new storage from the MatrixAllocator supplied at construction
+// (or from the heap if none was supplied). ERROR_MATRIX_STACK_OVERFLOW is
+// only reported when that allocation fails.
+//
+// Unlike MatrixStack the initial top most matrix is the identity matrix.
+//
+// inverseMatrix() and inverseTransposeMatrix() return the inverse and the
+// inverse-transpose (for transforming normals) of the top most matrix. Both
+// are computed on first use and cached until the top most matrix changes.
+// The identity matrix is returned for a singular top most matrix.
+
+template <unsigned int N>
+class InlineMatrixStack
+{
+public:
+    InlineMatrixStack();
+    explicit InlineMatrixStack(MatrixAllocator *pAllocator);
+    ~InlineMatrixStack();
+
+    unsigned int capacity() const;
+    unsigned int currentDepth() const;
+    const Matrix4 &currentMatrix() const;
+    const Matrix4 &inverseMatrix() const;
+    const Matrix4 &inverseTransposeMatrix() const;
+    bool isInline() const;
+    MatrixStack::Error lastError() const;
+    void loadIdentity();
+    void loadMatrix(const Matrix4 &m);
+    void multMatrix(const Matrix4 &m);
+    void popMatrix();
+    void pushMatrix();
+
+private:
+    static_assert(N > 0, "InlineMatrixStack requires an inline capacity of at least 1");
+
+    enum
+    {
+        CACHE_INVERSE           = 1,
+        CACHE_INVERSE_TRANSPOSE = 2
+    };
+
+    InlineMatrixStack(const InlineMatrixStack &);
+    InlineMatrixStack &operator=(const InlineMatrixStack &);
+
+    bool grow();
+    void init(MatrixAllocator *pAllocator);
+    Matrix4 *inlineStorage();
+    void releaseStorage();
+
+    alignas(16) unsigned char m_inline[N * sizeof(Matrix4)];
+    Matrix4 *m_pStack;
+    MatrixAllocator *m_pAllocator;
+    unsigned int m_depth;
+    unsigned int m_capacity;
+    MatrixStack::Error m_lastError;
+    mutable Matrix4 m_inverse;
+    mutable Matrix4 m_inverseTranspose;
+    mutable unsigned int m_cached;
+};
+
+template <unsigned int N>
+inline InlineMatrixStack<N>::InlineMatrixStack()
+{
+    init(0);
+}
+
+template <unsigned int N>
+inline InlineMatrixStack<N>::InlineMatrixStack(MatrixAllocator *pAllocator)
+{
+    init(pAllocator);
+}
+
+template <unsigned int N>
+inline InlineMatrixStack<N>::~InlineMatrixStack()
+{
+    releaseStorage();
+}
+
+template <unsigned int N>
+inline unsigned int InlineMatrixStack<N>::capacity() const
+{
+    return m_capacity;
+}
+
+template <unsigned int N>
+inline unsigned int InlineMatrixStack<N>::currentDepth() const
+{
+    return m_depth;
+}
+
+template <unsigned int N>
+inline const Matrix4 &InlineMatrixStack<N>::currentMatrix() const
+{
+    return m_pStack[m_depth];
+}
+
+template <unsigned int N>
+inline const Matrix4 &InlineMatrixStack<N>::inverseMatrix() const
+{
+    if (!(m_cached & CACHE_INVERSE))
+    {
+        if (!m_pStack[m_depth].inverseGeneral(m_inverse))
+            m_inverse.identity();
+
+        m_cached |= CACHE_INVERSE;
+    }
+
+    return m_inverse;
+}
+
+template <unsigned int N>
+inline const Matrix4 &InlineMatrixStack<N>::inverseTransposeMatrix() const
+{
+    if (!(m_cached & CACHE_INVERSE_TRANSPOSE))
+    {
+        m_inverseTranspose = inverseMatrix().transpose();
+        m_cached |= CACHE_INVERSE_TRANSPOSE;
+    }
+
+    return m_inverseTranspose;
+}
+
+template <unsigned int N>
+inline bool InlineMatrixStack<N>::isInline() const
+{
+    return m_pStack == reinterpret_cast<const Matrix4 *>(m_inline);
+}
+
+template <unsigned int N>
+inline MatrixStack::Error InlineMatrixStack<N>::lastError() const
+{
+    return m_lastError;
+}
+
+template <unsigned int N>
+inline void InlineMatrixStack<N>::loadIdentity()
+{
+    m_pStack[m_depth].identity();
+    m_cached = 0;
+}
+
+template <unsigned int N>
+inline void InlineMatrixStack<N>::loadMatrix(const Matrix4 &m)
+{
+    m_pStack[m_depth] = m;
+    m_cached = 0;
+}
+
+template <unsigned int N>
+inline void InlineMatrixStack<N>::multMatrix(const Matrix4 &m)
+{
+    m_pStack[m_depth] *= m;
+    m_cached = 0;
+}
+
+template <unsigned int N>
+inline void InlineMatrixStack<N>::popMatrix()
+{
+    if (m_depth == 0)
+    {
+        m_lastError = MatrixStack::ERROR_MATRIX_STACK_UNDERFLOW;
+    }
+    else
+    {
+        --m_depth;
+        m_cached = 0;
+        m_lastError = MatrixStack::ERROR_OK;
+    }
+}
+
+template <unsigned int N>
+inline void InlineMatrixStack<N>::pushMatrix()
+{
+    // The copy has the same inverse so the cache stays valid.
+
+    if (m_depth + 1 >= m_capacity && !grow())
+    {
+        m_lastError = MatrixStack::ERROR_MATRIX_STACK_OVERFLOW;
+    }
+    else
+    {
+        new (&m_pStack[m_depth + 1]) Matrix4(m_pStack[m_depth]);
+        ++m_depth;
+        m_lastError = MatrixStack::ERROR_OK;
+    }
+}
+
+template <unsigned int N>
+inline bool InlineMatrixStack<N>::grow()
+{
+    unsigned int capacity = m_capacity * 2;
+    Matrix4 *pStack = 0;
+
+    if (m_pAllocator)
+        pStack = m_pAllocator->allocate(capacity);
+    else
+        pStack = static_cast<Matrix4 *>(::operator new(capacity * sizeof(Matrix4), std::nothrow));
+
+    if (!pStack)
+        return false;
+
+    for (unsigned int i = 0; i <= m_depth; ++i)
+        new (&pStack[i]) Matrix4(m_pStack[i]);
+
+    releaseStorage();
+    m_pStack = pStack;
+    m_capacity = capacity;
+    return true;
+}
+
+template <unsigned int N>
+inline void InlineMatrixStack<N>::init(MatrixAllocator *pAllocator)
+{
+    m_pStack = inlineStorage();
+    m_pAllocator = pAllocator;
+    m_depth = 0;
+    m_capacity = N;
+    m_lastError = MatrixStack::ERROR_OK;
+    m_cached = 0;
+
+    new (&m_pStack[0]) Matrix4();
+    m_pStack[0].identity();
+}
+
+template <unsigned int N>
+inline Matrix4 *InlineMatrixStack<N>::inlineStorage()
+{
+    return reinterpret_cast<Matrix4 *>(m_inline);
+}
+
+template <unsigned int N>
+inline void InlineMatrixStack<N>::releaseStorage()
+{
+    if (isInline())
+        return;
+
+    if (m_pAllocator)
+        m_pAllocator->deallocate(m_pStack, m_capacity);
+    else
+        ::operator delete(m_pStack);
+}
+
+//-----------------------------------------------------------------------------
+// The Random class is a seedable pseudo random number generator. Unlike
+// rand() each Random object has its own state, so threads can each use
+// their own generator without locking and get reproducible results.
+//
+// nextUInt() and the functions built on it use the xoshiro128** generator.
+// fill() uses 8 interleaved xoshiro128+ generators, so large buffers can
+// be filled 4 (SSE2) or 8 (AVX2) values at a time. The values produced by
+// fill() are the same with or without SIMD.
+//
+// jump() advances the generator by 2^64 steps. Seeding one generator per
+// thread with the same seed and calling jump() 0, 1, 2, ... times gives
+// each thread a non-overlapping stream.
+//
+// References:
+//  [1] David Blackman and Sebastiano Vigna, "Scrambled Linear Pseudorandom
+//      Number Generators", ACM Transactions on Mathematical Software, 2021.
+//  [2] Ken Shoemake, "Uniform Random Rotations", Graphics Gems III, 1992.
+
+class Random
+{
+public:
+    static const unsigned long long DEFAULT_SEED = 0x853c49e6748fea9bULL;
+
+    Random();
+    explicit Random(unsigned long long seed);
+
+    void fill(float *values, unsigned int count);
+    void fill(float *values, unsigned int count, float min, float max);
+    Vector3 inBox(const Vector3 &min, const Vector3 &max);
+    Vector3 inSphere(float radius);
+    void jump();
+    float nextFloat();
+    float nextFloat(float min, float max);
+    unsigned int nextUInt();
+    Vector3 onSphere(float radius);
+    void seed(unsigned long long seed);
+    Quaternion unitQuaternion();
+
+private:
+    enum { LANES = 8 };
+
+    unsigned int m_state[4];
+    unsigned int m_lanes[4][LANES];
+};
+
+inline float Random::nextFloat()
+{
+    // Returns a random number in range [0,1). The top 24 bits fill the
+    // float's mantissa exactly.
+
+    return static_cast<float>(nextUInt() >> 8) * (1.0f / 16777216.0f);
+}
+
+inline float Random::nextFloat(float min, float max)
+{
+    // Returns a random number in range [min,max).
+
+    return min + (max - min) * nextFloat();
+}
+
+inline unsigned int Random::nextUInt()
+{
+    unsigned int *s = m_state;
+    unsigned int x = s[1] * 5;
+    unsigned int result = ((x << 7) | (x >> 25)) * 9;
+    unsigned int t = s[1] << 9;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = (s[3] << 11) | (s[3] >> 21);
+
+    return result;
+}
+
 //-----------------------------------------------------------------------------
 
 #endif
\ No newline at end of file
@@ -0,0 +1,1127 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2026 dhpoware. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include <algorithm>
+
+#include "occlusion.h"
+#include "threadpool.h"
+
+#if defined(MATHLIB_SSE)
+#include <xmmintrin.h>
+#endif
+
+// Triangles are clipped against the plane w = CLIP_W, just in front of the
+// camera, so that 1 / w stays finite. Boxes that reach past it are visible.
+static const float CLIP_W = 1e-4f;
+
+// Triangles are also clipped to a guard band GUARD_BAND times the size of
+// the screen, centered on it, so that the screen coordinates stay small
+// enough for the edge functions to be precise and to convert to int.
+static const float GUARD_BAND = 4.0f;
+
+//-----------------------------------------------------------------------------
+// OcclusionCuller.
+
+OcclusionCuller::OcclusionCuller() : m_tested(0), m_culled(0)
+{
+    init(DEFAULT_WIDTH, DEFAULT_HEIGHT);
+}
+
+OcclusionCuller::OcclusionCuller(unsigned int width, unsigned int height) : m_tested(0), m_culled(0)
+{
+    init((width > 0) ? width : 1, (height > 0) ? height : 1);
+}
+
+OcclusionCuller::~OcclusionCuller()
+{
+}
+
+void OcclusionCuller::addOccluder(const Vector3 *vertices, const unsigned int *indices, unsigned int triangleCount)
+{
+    addOccluder(Matrix4::IDENTITY, vertices, indices, triangleCount);
+}
+
+void OcclusionCuller::addOccluder(const Matrix4 &modelMatrix, const Vector3 *vertices, const unsigned int *indices, unsigned int triangleCount)
+{
+    // Transforms the triangles to clip space and queues them for
+    // rasterize(). 'indices' holds 3 vertex indices per triangle.
+
+    Matrix4 m(modelMatrix * m_viewProjMatrix);
+    Vector4 clip[3];
+
+    for (unsigned int i = 0; i < triangleCount; ++i, indices += 3)
+    {
+        for (int k = 0; k < 3; ++k)
+        {
+            const Vector3 &v = vertices[indices[k]];
+            clip[k] = Vector4(v, 1.0f) * m;
+        }
+
+        addClippedTriangle(clip);
+    }
+}
+
+void OcclusionCuller::beginFrame(const Matrix4 &viewProjMatrix)
+{
+    m_viewProjMatrix = viewProjMatrix;
+    std::fill(m_depth.begin(), m_depth.end(), 0.0f);
+    m_triangles.clear();
+    m_tested.store(0, std::memory_order_relaxed);
+    m_culled.store(0, std::memory_order_relaxed);
+}
+
+unsigned int OcclusionCuller::culledCount() const
+{
+    return m_culled.load(std::memory_order_relaxed);
+}
+
+float OcclusionCuller::depth(unsigned int x, unsigned int y) const
+{
+    // Returns the 1 / w value stored for pixel (x, y). Row 0 is the top of
+    // the screen.
+    return m_depth[pixelIndex(x, y)];
+}
+
+unsigned int OcclusionCuller::height() const
+{
+    return m_height;
+}
+
+bool OcclusionCuller::isVisible(const BoundingBox &box) const
+{
+    // Each corner's clip space position is the sum of one of two scaled
+    // rows of the matrix for each axis, plus row 3, so the 8 corners only
+    // need 6 row scalings.
+
+    const Matrix4 &m = m_viewProjMatrix;
+    Vector4 r0(m[0][0], m[0][1], m[0][2], m[0][3]);
+    Vector4 r1(m[1][0], m[1][1], m[1][2], m[1][3]);
+    Vector4 r2(m[2][0], m[2][1], m[2][2], m[2][3]);
+    Vector4 r3(m[3][0], m[3][1], m[3][2], m[3][3]);
+    Vector4 xs[2] = { r0 * box.min.x, r0 * box.max.x };
+    Vector4 ys[2] = { r1 * box.min.y, r1 * box.max.y };
+    Vector4 zs[2] = { r2 * box.min.z + r3, r2 * box.max.z + r3 };
+
+    float minX = 1e30f, minY = 1e30f, maxX = -1e30f, maxY = -1e30f;
+    float nearest = 0.0f;
+
+    for (int i = 0; i < 8; ++i)
+    {
+        Vector4 c(xs[i & 1] + ys[(i >> 1) & 1] + zs[i >> 2]);
+
+        if (c.w <= CLIP_W)
+        {
+            m_tested.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        float invW = 1.0f / c.w;
+        float sx = (c.x * invW * 0.5f + 0.5f) * m_width;
+        float sy = (0.5f - c.y * invW * 0.5f) * m_height;
+
+        minX = std::min(minX, sx), maxX = std::max(maxX, sx);
+        minY = std::min(minY, sy), maxY = std::max(maxY, sy);
+        nearest = std::max(nearest, invW);
+    }
+
+    // Boxes off screen can't be seen whatever the occluders are, and are
+    // left to frustum culling rather than counted.
+    float w = static_cast<float>(m_width);
+    float h = static_cast<float>(m_height);
+
+    if (maxX < 0.0f || minX > w || maxY < 0.0f || minY > h)
+        return false;
+
+    m_tested.fetch_add(1, std::memory_order_relaxed);
+
+    // Every pixel that the screen rectangle touches is tested, and at least
+    // one when the rectangle has no area. The bounds are clamped to the
+    // buffer before the conversion to int, since corners close to the
+    // camera plane project far off screen.
+    int x0 = std::min(static_cast<int>(floorf(std::max(minX, 0.0f))), static_cast<int>(m_width) - 1);
+    int y0 = std::min(static_cast<int>(floorf(std::max(minY, 0.0f))), static_cast<int>(m_height) - 1);
+    int x1 = std::max(static_cast<int>(ceilf(std::min(maxX, w))) - 1, x0);
+    int y1 = std::max(static_cast<int>(ceilf(std::min(maxY, h))) - 1, y0);
+
+    if (testRect(x0, y0, x1, y1, nearest))
+        return true;
+
+    m_culled.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+void OcclusionCuller::rasterize()
+{
+    binTriangles();
+
+    for (unsigned int tile = 0; tile < m_tilesX * m_tilesY; ++tile)
+        rasterizeTile(tile);
+}
+
+void OcclusionCuller::rasterize(ThreadPool &pool)
+{
+    // Every tile has its own block of the depth buffer and only reads the
+    // shared triangle list, so the tiles can be drawn on any thread.
+
+    binTriangles();
+
+    pool.parallelFor(m_tilesX * m_tilesY, 1,
+        [this](unsigned int begin, unsigned int end)
+        {
+            for (unsigned int tile = begin; tile < end; ++tile)
+                rasterizeTile(tile);
+        });
+}
+
+void OcclusionCuller::readDepth(float *depth) const
+{
+    // Copies the depth buffer to 'depth' as width() x height() floats, row
+    // by row from the top of the screen, one tile row at a time.
+
+    for (unsigned int y = 0; y < m_height; ++y)
+    {
+        const float *pTileRow = &m_depth[pixelIndex(0, y)];
+        float *pDst = depth + y * m_width;
+
+        for (unsigned int x = 0; x < m_width; x += TILE_WIDTH)
+        {
+            unsigned int n = (m_width - x < TILE_WIDTH) ? m_width - x : TILE_WIDTH;
+
+            std::copy(pTileRow, pTileRow + n, pDst + x);
+            pTileRow += TILE_WIDTH * TILE_HEIGHT;
+        }
+    }
+}
+
+unsigned int OcclusionCuller::testedCount() const
+{
+    return m_tested.load(std::memory_order_relaxed);
+}
+
+void OcclusionCuller::testBoxes(const BoundingBox *boxes, bool *visible, unsigned int count) const
+{
+    for (unsigned int i = 0; i < count; ++i)
+        visible[i] = isVisible(boxes[i]);
+}
+
+unsigned int OcclusionCuller::triangleCount() const
+{
+    return static_cast<unsigned int>(m_triangles.size());
+}
+
+const Matrix4 &OcclusionCuller::viewProjMatrix() const
+{
+    return m_viewProjMatrix;
+}
+
+unsigned int OcclusionCuller::width() const
+{
+    return m_width;
+}
+
+void OcclusionCuller::addClippedTriangle(const Vector4 *clip)
+{
+    // Clips the triangle against the plane w = CLIP_W and the four planes
+    // of the guard band, |x| <= GUARD_BAND * w and |y| <= GUARD_BAND * w
+    // (Sutherland-Hodgman, one plane after the other). Clipping in clip
+    // space keeps 1 / w linear across the result, which is stored in
+    // screen space as a fan of up to 6 triangles. Most triangles are inside
+    // every plane and skip the clipping.
+
+    static const float PLANES[5][4] =
+    {
+        { 0.0f, 0.0f, 1.0f, -CLIP_W },
+        { 1.0f, 0.0f, GUARD_BAND, 0.0f },
+        { -1.0f, 0.0f, GUARD_BAND, 0.0f },
+        { 0.0f, 1.0f, GUARD_BAND, 0.0f },
+        { 0.0f, -1.0f, GUARD_BAND, 0.0f }
+    };
+
+    Vector4 poly[2][8];
+    const Vector4 *pPoly = clip;
+    int count = 3;
+    bool inside = true;
+
+    for (int i = 0; i < 3; ++i)
+    {
+        float band = GUARD_BAND * clip[i].w;
+        inside = inside && clip[i].w >= CLIP_W && fabsf(clip[i].x) <= band && fabsf(clip[i].y) <= band;
+    }
+
+    for (int plane = 0; plane < 5 && !inside; ++plane)
+    {
+        const float *p = PLANES[plane];
+        float d[8];
+        bool outside = false;
+
+        for (int i = 0; i < count; ++i)
+        {
+            d[i] = p[0] * pPoly[i].x + p[1] * pPoly[i].y + p[2] * pPoly[i].w + p[3];
+            outside = outside || (d[i] < 0.0f);
+        }
+
+        if (!outside)
+            continue;
+
+        Vector4 *pDst = (pPoly == poly[0]) ? poly[1] : poly[0];
+        int clipped = 0;
+
+        for (int i = 0; i < count; ++i)
+        {
+            int j = (i + 1 < count) ? i + 1 : 0;
+
+            if (d[i] >= 0.0f)
+                pDst[clipped++] = pPoly[i];
+
+            if ((d[i] >= 0.0f) != (d[j] >= 0.0f))
+                pDst[clipped++] = pPoly[i] + (pPoly[j] - pPoly[i]) * (d[i] / (d[i] - d[j]));
+        }
+
+        pPoly = pDst;
+        count = clipped;
+
+        if (count < 3)
+            return;
+    }
+
+    float sx[8], sy[8], invW[8];
+
+    for (int i = 0; i < count; ++i)
+    {
+        invW[i] = 1.0f / pPoly[i].w;
+        sx[i] = (pPoly[i].x * invW[i] * 0.5f + 0.5f) * m_width;
+        sy[i] = (0.5f - pPoly[i].y * invW[i] * 0.5f) * m_height;
+    }
+
+    for (int i = 1; i + 1 < count; ++i)
+    {
+        Triangle t;
+        const int v[3] = { 0, i, i + 1 };
+
+        for (int k = 0; k < 3; ++k)
+            t.x[k] = sx[v[k]], t.y[k] = sy[v[k]], t.invW[k] = invW[v[k]];
+
+        m_triangles.push_back(t);
+    }
+}
+
+void OcclusionCuller::binTriangles()
+{
+    // Adds each triangle to the bins of the tiles that its bounding
+    // rectangle overlaps. Triangles that cover no pixel centers are
+    // dropped here.
+
+    for (size_t i = 0; i < m_bins.size(); ++i)
+        m_bins[i].clear();
+
+    for (unsigned int i = 0; i < m_triangles.size(); ++i)
+    {
+        const Triangle &t = m_triangles[i];
+        float minX = std::min(t.x[0], std::min(t.x[1], t.x[2]));
+        float maxX = std::max(t.x[0], std::max(t.x[1], t.x[2]));
+        float minY = std::min(t.y[0], std::min(t.y[1], t.y[2]));
+        float maxY = std::max(t.y[0], std::max(t.y[1], t.y[2]));
+
+        // Pixel x covers the center x + 0.5.
+        float x0 = std::max(ceilf(minX - 0.5f), 0.0f);
+        float y0 = std::max(ceilf(minY - 0.5f), 0.0f);
+        float x1 = std::min(floorf(maxX - 0.5f), static_cast<float>(m_width - 1));
+        float y1 = std::min(floorf(maxY - 0.5f), static_cast<float>(m_height - 1));
+
+        if (x0 > x1 || y0 > y1)
+            continue;
+
+        unsigned int tx0 = static_cast<unsigned int>(x0) / TILE_WIDTH;
+        unsigned int ty0 = static_cast<unsigned int>(y0) / TILE_HEIGHT;
+        unsigned int tx1 = static_cast<unsigned int>(x1) / TILE_WIDTH;
+        unsigned int ty1 = static_cast<unsigned int>(y1) / TILE_HEIGHT;
+
+        for (unsigned int ty = ty0; ty <= ty1; ++ty)
+        {
+            for (unsigned int tx = tx0; tx <= tx1; ++tx)
+                m_bins[ty * m_tilesX + tx].push_back(i);
+        }
+    }
+}
+
+void OcclusionCuller::init(unsigned int width, unsigned int height)
+{
+    m_width = width;
+    m_height = height;
+    m_tilesX = (width + TILE_WIDTH - 1) / TILE_WIDTH;
+    m_tilesY = (height + TILE_HEIGHT - 1) / TILE_HEIGHT;
+    m_depth.assign(m_tilesX * m_tilesY * TILE_WIDTH * TILE_HEIGHT, 0.0f);
+    m_bins.resize(m_tilesX * m_tilesY);
+    m_viewProjMatrix = Matrix4::IDENTITY;
+}
+
+unsigned int OcclusionCuller::pixelIndex(unsigned int x, unsigned int y) const
+{
+    // The tiles are stored one after another, and the pixels of a tile row
+    // by row.
+
+    unsigned int tile = (y / TILE_HEIGHT) * m_tilesX + x / TILE_WIDTH;
+    return tile * (TILE_WIDTH * TILE_HEIGHT) + (y % TILE_HEIGHT) * TILE_WIDTH + (x % TILE_WIDTH);
+}
+
+void OcclusionCuller::rasterizeTile(unsigned int tile)
+{
+    // Draws the triangles of the tile's bin using edge functions evaluated
+    // at the pixel centers, 4 pixels at a time. A pixel is inside when all
+    // three edge functions are non-negative, and its depth is the 1 / w
+    // plane of the triangle evaluated at its center.
+
+    const std::vector<unsigned int> &bin = m_bins[tile];
+    float *pTile = &m_depth[tile * TILE_WIDTH * TILE_HEIGHT];
+    int originX = static_cast<int>((tile % m_tilesX) * TILE_WIDTH);
+    int originY = static_cast<int>((tile / m_tilesX) * TILE_HEIGHT);
+
+    for (size_t i = 0; i < bin.size(); ++i)
+    {
+        const Triangle &t = m_triangles[bin[i]];
+        int v1 = 1, v2 = 2;
+        float area = (t.x[1] - t.x[0]) * (t.y[2] - t.y[0]) - (t.x[2] - t.x[0]) * (t.y[1] - t.y[0]);
+
+        if (area == 0.0f)
+            continue;
+
+        // Both windings are drawn: swapping two vertices of a clockwise
+        // triangle makes it counterclockwise.
+        if (area < 0.0f)
+            std::swap(v1, v2), area = -area;
+
+        const int v[3] = { 0, v1, v2 };
+        float a[3], b[3], c[3];
+
+        // Edge k is opposite vertex k, so it is 0 at that vertex's two
+        // neighbours and its value divided by 'area' is the barycentric
+        // weight of vertex k.
+        for (int k = 0; k < 3; ++k)
+        {
+            int p = v[(k + 1) % 3], q = v[(k + 2) % 3];
+
+            a[k] = t.y[p] - t.y[q];
+            b[k] = t.x[q] - t.x[p];
+            c[k] = -(a[k] * t.x[p] + b[k] * t.y[p]);
+        }
+
+        float invArea = 1.0f / area;
+        float za = (a[0] * t.invW[v[0]] + a[1] * t.invW[v[1]] + a[2] * t.invW[v[2]]) * invArea;
+        float zb = (b[0] * t.invW[v[0]] + b[1] * t.invW[v[1]] + b[2] * t.invW[v[2]]) * invArea;
+        float zc = (c[0] * t.invW[v[0]] + c[1] * t.invW[v[1]] + c[2] * t.invW[v[2]]) * invArea;
+
+        // The pixels of the tile whose centers are inside the bounding
+        // rectangle. As in binTriangles(), the bounds are clamped to the
+        // tile before the conversion to int; the rectangle overlaps the
+        // tile, so one side of each is enough. x0 is rounded down to a
+        // multiple of 4 so that the groups of 4 pixels stay aligned within
+        // the tile row.
+        float minX = std::min(t.x[0], std::min(t.x[1], t.x[2]));
+        float maxX = std::max(t.x[0], std::max(t.x[1], t.x[2]));
+        float minY = std::min(t.y[0], std::min(t.y[1], t.y[2]));
+        float maxY = std::max(t.y[0], std::max(t.y[1], t.y[2]));
+        int x0 = (static_cast<int>(std::max(ceilf(minX - 0.5f), static_cast<float>(originX))) - originX) & ~3;
+        int y0 = static_cast<int>(std::max(ceilf(minY - 0.5f), static_cast<float>(originY))) - originY;
+        int x1 = static_cast<int>(std::min(floorf(maxX - 0.5f), static_cast<float>(originX + TILE_WIDTH - 1))) - originX;
+        int y1 = static_cast<int>(std::min(floorf(maxY - 0.5f), static_cast<float>(originY + TILE_HEIGHT - 1))) - originY;
+
+        for (int y = y0; y <= y1; ++y)
+        {
+            float *pRow = pTile + y * TILE_WIDTH;
+            float fy = static_cast<float>(originY + y) + 0.5f;
+
+#if defined(MATHLIB_SSE)
+            __m128 e0y = _mm_set1_ps(b[0] * fy + c[0]);
+            __m128 e1y = _mm_set1_ps(b[1] * fy + c[1]);
+            __m128 e2y = _mm_set1_ps(b[2] * fy + c[2]);
+            __m128 zy = _mm_set1_ps(zb * fy + zc);
+            __m128 zero = _mm_setzero_ps();
+
+            for (int x = x0; x <= x1; x += 4)
+            {
+                float fx = static_cast<float>(originX + x) + 0.5f;
+                __m128 px = _mm_add_ps(_mm_set1_ps(fx), _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f));
+                __m128 e0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a[0]), px), e0y);
+                __m128 e1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a[1]), px), e1y);
+                __m128 e2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a[2]), px), e2y);
+                __m128 inside = _mm_and_ps(_mm_cmpge_ps(e0, zero),
+                    _mm_and_ps(_mm_cmpge_ps(e1, zero), _mm_cmpge_ps(e2, zero)));
+
+                if (_mm_movemask_ps(inside) == 0)
+                    continue;
+
+                __m128 z = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(za), px), zy);
+                __m128 d = _mm_loadu_ps(pRow + x);
+
+                _mm_storeu_ps(pRow + x, _mm_max_ps(d, _mm_and_ps(inside, z)));
+            }
+#else
+            for (int x = x0; x <= x1; ++x)
+            {
+                float fx = static_cast<float>(originX + x) + 0.5f;
+
+                if (a[0] * fx + (b[0] * fy + c[0]) >= 0.0f
+                    && a[1] * fx + (b[1] * fy + c[1]) >= 0.0f
+                    && a[2] * fx + (b[2] * fy + c[2]) >= 0.0f)
+                {
+                    pRow[x] = std::max(pRow[x], za * fx + (zb * fy + zc));
+                }
+            }
+#endif
+        }
+    }
+}
+
+bool OcclusionCuller::testRect(int x0, int y0, int x1, int y1, float invW) const
+{
+    // Returns true if any pixel in the rectangle is farther away than
+    // 'invW' (has a smaller 1 / w), so the object may be visible there.
+
+    for (int y = y0; y <= y1; ++y)
+    {
+#if defined(MATHLIB_SSE)
+        __m128 nearest = _mm_set1_ps(invW);
+        __m128 first = _mm_set1_ps(static_cast<float>(x0));
+        __m128 last = _mm_set1_ps(static_cast<float>(x1));
+
+        for (int x = x0 & ~3; x <= x1; x += 4)
+        {
+            // The groups of 4 are aligned within the tile rows, and the
+            // lanes outside the rectangle are masked off.
+            const float *pDepth = &m_depth[pixelIndex(x, y)];
+            __m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f));
+            __m128 lanes = _mm_and_ps(_mm_cmpge_ps(px, first), _mm_cmple_ps(px, last));
+            __m128 farther = _mm_cmplt_ps(_mm_loadu_ps(pDepth), nearest);
+
+            if (_mm_movemask_ps(_mm_and_ps(lanes, farther)) != 0)
+                return true;
+        }
+#else
+        for (int x = x0; x <= x1; ++x)
+        {
+            if (m_depth[pixelIndex(x, y)] < invW)
+                return true;
+        }
+#endif
+    }
+
+    return false;
+}
+
+//-----------------------------------------------------------------------------
+// HiZPyramid.
+
+HiZPyramid::HiZPyramid() : m_convention(DEPTH_NEG_ONE_TO_ONE)
+{
+}
+
+HiZPyramid::~HiZPyramid()
+{
+}
+
+void HiZPyramid::build(const float *depth, unsigned int width, unsigned int height, DepthConvention convention)
+{
+    // Copies the depth buffer into level 0 as keys and builds the coarser
+    // levels from it. An empty buffer leaves the pyramid empty, and every
+    // object visible.
+
+    m_convention = convention;
+    buildLevels(width, height);
+
+    float sign = (convention == DEPTH_REVERSED || convention == DEPTH_INVERSE_W) ? -1.0f : 1.0f;
+
+    for (unsigned int i = 0; i < width * height; ++i)
+        m_depth[i] = depth[i] * sign;
+
+    reduceLevels();
+}
+
+void HiZPyramid::build(const OcclusionCuller &culler)
+{
+    m_convention = DEPTH_INVERSE_W;
+    buildLevels(culler.width(), culler.height());
+
+    culler.readDepth(&m_depth[0]);
+
+    for (unsigned int i = 0; i < culler.width() * culler.height(); ++i)
+        m_depth[i] = -m_depth[i];
+
+    reduceLevels();
+}
+
+HiZPyramid::DepthConvention HiZPyramid::convention() const
+{
+    return m_convention;
+}
+
+float HiZPyramid::farthestDepth(unsigned int level, unsigned int x, unsigned int y) const
+{
+    // Returns the farthest depth of the level 0 texels under texel (x, y)
+    // of 'level', in the convention the pyramid was built with.
+
+    const Level &l = m_levels[level];
+    float key = m_depth[l.offset + y * l.width + x];
+
+    return (m_convention == DEPTH_REVERSED || m_convention == DEPTH_INVERSE_W) ? -key : key;
+}
+
+unsigned int HiZPyramid::height(unsigned int level) const
+{
+    return m_levels[level].height;
+}
+
+bool HiZPyramid::isVisible(const Matrix4 &viewProjMatrix, const BoundingBox &box) const
+{
+    return testBox(viewProjMatrix, box.min, box.max);
+}
+
+bool HiZPyramid::isVisible(const Matrix4 &viewProjMatrix, const BoundingSphere &sphere) const
+{
+    Vector3 extent(sphere.radius, sphere.radius, sphere.radius);
+    return testBox(viewProjMatrix, sphere.center - extent, sphere.center + extent);
+}
+
+unsigned int HiZPyramid::levelCount() const
+{
+    return static_cast<unsigned int>(m_levels.size());
+}
+
+void HiZPyramid::testBoxes(const Matrix4 &viewProjMatrix, const BoundingBox *boxes, bool *visible, unsigned int count) const
+{
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        if (visible[i])
+            visible[i] = testBox(viewProjMatrix, boxes[i].min, boxes[i].max);
+    }
+}
+
+void HiZPyramid::testBoxes(const Matrix4 &viewProjMatrix, const BoundingBox *boxes, unsigned int *masks, unsigned int bit, unsigned int count) const
+{
+    unsigned int mask = 1u << bit;
+
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        if ((masks[i] & mask) && !testBox(viewProjMatrix, boxes[i].min, boxes[i].max))
+            masks[i] &= ~mask;
+    }
+}
+
+void HiZPyramid::testSpheres(const Matrix4 &viewProjMatrix, const BoundingSphere *spheres, bool *visible, unsigned int count) const
+{
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        if (visible[i])
+            visible[i] = isVisible(viewProjMatrix, spheres[i]);
+    }
+}
+
+void HiZPyramid::testSpheres(const Matrix4 &viewProjMatrix, const BoundingSphere *spheres, unsigned int *masks, unsigned int bit, unsigned int count) const
+{
+    unsigned int mask = 1u << bit;
+
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        if ((masks[i] & mask) && !isVisible(viewProjMatrix, spheres[i]))
+            masks[i] &= ~mask;
+    }
+}
+
+unsigned int HiZPyramid::width(unsigned int level) const
+{
+    return m_levels[level].width;
+}
+
+void HiZPyramid::buildLevels(unsigned int width, unsigned int height)
+{
+    // Lays out the levels: each is half the size of the one below, rounded
+    // up so that every texel below has a parent, down to 1 x 1.
+
+    m_levels.clear();
+
+    if (width == 0 || height == 0)
+    {
+        m_depth.clear();
+        return;
+    }
+
+    Level level = { 0, width, height };
+
+    for (;;)
+    {
+        m_levels.push_back(level);
+        level.offset += level.width * level.height;
+
+        if (level.width == 1 && level.height == 1)
+            break;
+
+        level.width = (level.width + 1) / 2;
+        level.height = (level.height + 1) / 2;
+    }
+
+    m_depth.resize(level.offset);
+}
+
+void HiZPyramid::reduceLevels()
+{
+    // Each texel is the maximum (farthest) key of its 2 x 2 children. At
+    // the right and bottom edges of odd sized levels a texel has only 1 or
+    // 2 children (the last row is read twice).
+
+    for (size_t i = 1; i < m_levels.size(); ++i)
+    {
+        const Level &src = m_levels[i - 1];
+        const Level &dst = m_levels[i];
+        const float *pSrc = &m_depth[src.offset];
+        float *pDst = &m_depth[dst.offset];
+
+        for (unsigned int y = 0; y < dst.height; ++y)
+        {
+            const float *pRow0 = pSrc + (y * 2) * src.width;
+            const float *pRow1 = pSrc + std::min(y * 2 + 1, src.height - 1) * src.width;
+
+            float *pDstRow = pDst + y * dst.width;
+            unsigned int pairs = src.width / 2;
+
+            for (unsigned int x = 0; x < pairs; ++x)
+                pDstRow[x] = std::max(std::max(pRow0[x * 2], pRow0[x * 2 + 1]), std::max(pRow1[x * 2], pRow1[x * 2 + 1]));
+
+            if (pairs < dst.width)
+                pDstRow[pairs] = std::max(pRow0[src.width - 1], pRow1[src.width - 1]);
+        }
+    }
+}
+
+bool HiZPyramid::testBox(const Matrix4 &m, const Vector3 &min, const Vector3 &max) const
+{
+    // Projects the corners as OcclusionCuller::isVisible() does. The key of
+    // a corner is (a * z + c) / w + b, with the constants picked for the
+    // convention, and the nearest corner has the smallest key.
+
+    if (m_levels.empty())
+        return true;
+
+    static const float KEY_CONSTANTS[4][3] =
+    {
+        { 0.5f, 0.5f, 0.0f },   // DEPTH_NEG_ONE_TO_ONE
+        { 1.0f, 0.0f, 0.0f },   // DEPTH_ZERO_TO_ONE
+        { -1.0f, 0.0f, 0.0f },  // DEPTH_REVERSED
+        { 0.0f, 0.0f, -1.0f }   // DEPTH_INVERSE_W
+    };
+
+    const float *k = KEY_CONSTANTS[m_convention];
+    const Level &base = m_levels[0];
+
+    Vector4 r0(m[0][0], m[0][1], m[0][2], m[0][3]);
+    Vector4 r1(m[1][0], m[1][1], m[1][2], m[1][3]);
+    Vector4 r2(m[2][0], m[2][1], m[2][2], m[2][3]);
+    Vector4 r3(m[3][0], m[3][1], m[3][2], m[3][3]);
+    Vector4 xs[2] = { r0 * min.x, r0 * max.x };
+    Vector4 ys[2] = { r1 * min.y, r1 * max.y };
+    Vector4 zs[2] = { r2 * min.z + r3, r2 * max.z + r3 };
+
+    float minX = 1e30f, minY = 1e30f, maxX = -1e30f, maxY = -1e30f;
+    float nearest = 1e30f;
+
+    for (int i = 0; i < 8; ++i)
+    {
+        Vector4 c(xs[i & 1] + ys[(i >> 1) & 1] + zs[i >> 2]);
+
+        if (c.w <= CLIP_W)
+            return true;
+
+        float invW = 1.0f / c.w;
+        float sx = (c.x * invW * 0.5f + 0.5f) * base.width;
+        float sy = (0.5f - c.y * invW * 0.5f) * base.height;
+
+        minX = std::min(minX, sx), maxX = std::max(maxX, sx);
+        minY = std::min(minY, sy), maxY = std::max(maxY, sy);
+        nearest = std::min(nearest, (k[0] * c.z + k[2]) * invW + k[1]);
+    }
+
+    // The bounds are clamped to the buffer before the conversion to int,
+    // since corners close to the camera plane project far off screen.
+    float w = static_cast<float>(base.width);
+    float h = static_cast<float>(base.height);
+    int x0 = static_cast<int>(floorf(std::min(std::max(minX, 0.0f), w)));
+    int y0 = static_cast<int>(floorf(std::min(std::max(minY, 0.0f), h)));
+    int x1 = static_cast<int>(ceilf(std::min(std::max(maxX, 0.0f), w))) - 1;
+    int y1 = static_cast<int>(ceilf(std::min(std::max(maxY, 0.0f), h))) - 1;
+
+    if (x0 > x1 || y0 > y1)
+        return false;
+
+    // The finest level at which the rectangle touches at most 2 texels in
+    // each direction. The 1 x 1 top level always qualifies.
+    unsigned int l = 0;
+
+    while (((x1 >> l) - (x0 >> l)) > 1 || ((y1 >> l) - (y0 >> l)) > 1)
+        ++l;
+
+    const Level &level = m_levels[l];
+    const float *pRow0 = &m_depth[level.offset + (y0 >> l) * level.width];
+    const float *pRow1 = &m_depth[level.offset + (y1 >> l) * level.width];
+    float farthest = std::max(std::max(pRow0[x0 >> l], pRow0[x1 >> l]), std::max(pRow1[x0 >> l], pRow1[x1 >> l]));
+
+    return nearest <= farthest;
+}
+
+//-----------------------------------------------------------------------------
+// PortalGraph.
+
+static bool isInPortal(const Vector3 &eye, const Plane &plane, const Vector3 *vertices, unsigned int count, float tolerance)
+{
+    // Returns true if the eye is within 'tolerance' of the portal's plane
+    // and inside the prism swept by its outline along the normal.
+
+    if (fabsf(Plane::dot(plane, eye)) > tolerance)
+        return false;
+
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        const Vector3 &a = vertices[i];
+        const Vector3 &b = vertices[(i + 1) % count];
+        const Vector3 &c = vertices[(i + 2) % count];
+        Vector3 edgeNormal(Vector3::cross(plane.n, b - a));
+
+        if (Vector3::dot(edgeNormal, c - a) * Vector3::dot(edgeNormal, eye - a) < 0.0f)
+            return false;
+    }
+
+    return true;
+}
+
+PortalGraph::PortalGraph()
+{
+}
+
+PortalGraph::~PortalGraph()
+{
+}
+
+int PortalGraph::addCell(const BoundingBox &bounds)
+{
+    Cell cell;
+
+    cell.bounds = bounds;
+    cell.firstLink = -1;
+    m_cells.push_back(cell);
+
+    return static_cast<int>(m_cells.size()) - 1;
+}
+
+int PortalGraph::addPortal(int cellA, int cellB, const Vector3 *vertices, unsigned int vertexCount)
+{
+    // Links the portal into the lists of both cells.
+
+    int cellCount = static_cast<int>(m_cells.size());
+
+    if (cellA < 0 || cellA >= cellCount || cellB < 0 || cellB >= cellCount || cellA == cellB)
+        return NO_PORTAL;
+
+    if (vertexCount < 3 || vertexCount > MAX_PORTAL_VERTICES)
+        return NO_PORTAL;
+
+    int index = static_cast<int>(m_portals.size());
+    Portal portal;
+
+    // The portal's plane, with its normal found by Newell's method.
+    Vector3 centroid(0.0f, 0.0f, 0.0f);
+    Vector3 normal(0.0f, 0.0f, 0.0f);
+
+    for (unsigned int i = 0; i < vertexCount; ++i)
+    {
+        centroid += vertices[i];
+        normal += Vector3::cross(vertices[i], vertices[(i + 1) % vertexCount]);
+    }
+
+    float length = normal.magnitude();
+
+    if (length <= Math::EPSILON)
+        return NO_PORTAL;
+
+    portal.plane = Plane(centroid / static_cast<float>(vertexCount), normal / length);
+    portal.firstVertex = static_cast<unsigned int>(m_vertices.size());
+    portal.vertexCount = vertexCount;
+    m_portals.push_back(portal);
+    m_vertices.insert(m_vertices.end(), vertices, vertices + vertexCount);
+
+    int cells[2] = { cellA, cellB };
+
+    for (int i = 0; i < 2; ++i)
+    {
+        Link link;
+
+        link.portal = index;
+        link.cell = cells[1 - i];
+        link.next = m_cells[cells[i]].firstLink;
+        m_cells[cells[i]].firstLink = static_cast<int>(m_links.size());
+        m_links.push_back(link);
+    }
+
+    return index;
+}
+
+const BoundingBox &PortalGraph::cellBounds(int cell) const
+{
+    return m_cells[cell].bounds;
+}
+
+unsigned int PortalGraph::cellCount() const
+{
+    return static_cast<unsigned int>(m_cells.size());
+}
+
+void PortalGraph::clear()
+{
+    m_cells.clear();
+    m_links.clear();
+    m_portals.clear();
+    m_vertices.clear();
+}
+
+int PortalGraph::findCell(const Vector3 &point) const
+{
+    // Returns the first cell whose bounds contain the point.
+
+    for (size_t i = 0; i < m_cells.size(); ++i)
+    {
+        const BoundingBox &b = m_cells[i].bounds;
+
+        if (point.x >= b.min.x && point.x <= b.max.x
+            && point.y >= b.min.y && point.y <= b.max.y
+            && point.z >= b.min.z && point.z <= b.max.z)
+            return static_cast<int>(i);
+    }
+
+    return NO_CELL;
+}
+
+bool PortalGraph::findVisibleCells(PortalQuery &query, const Vector3 &eye, const Frustum &frustum, int cell) const
+{
+    // Walks the graph depth first with an explicit stack of frames in the
+    // query, one per cell on the current path. Each frame remembers the
+    // next link of its cell to follow and the view its cell was seen in.
+
+    query.m_viewCount = 0;
+    query.m_visibleCells.clear();
+
+    if (query.m_visitStamps.size() < m_cells.size())
+        query.m_visitStamps.resize(m_cells.size(), 0);
+
+    // The visited flags are stamps, so they don't need clearing per query.
+    if (++query.m_stamp == 0)
+    {
+        std::fill(query.m_visitStamps.begin(), query.m_visitStamps.end(), 0u);
+        query.m_stamp = 1;
+    }
+
+    if (cell < 0 || cell >= static_cast<int>(m_cells.size()))
+        return false;
+
+    PortalQuery::Frame *frames = &query.m_frames[0];
+    unsigned int maxFrames = static_cast<unsigned int>(query.m_frames.size());
+    unsigned int maxViews = static_cast<unsigned int>(query.m_volumes.size());
+    float nearDistance = fabsf(Plane::dot(frustum.planes[Frustum::FRUSTUM_PLANE_NEAR], eye));
+    unsigned int depth = 1;
+    bool complete = true;
+
+    query.m_volumes[0].fromFrustum(frustum);
+    query.m_viewCells[0] = cell;
+    query.m_viewCount = 1;
+    query.m_visitStamps[cell] = query.m_stamp;
+    query.m_visibleCells.push_back(cell);
+
+    frames[0].cell = cell;
+    frames[0].nextLink = m_cells[cell].firstLink;
+    frames[0].view = 0;
+
+    while (depth > 0)
+    {
+        PortalQuery::Frame &frame = frames[depth - 1];
+
+        if (frame.nextLink < 0)
+        {
+            --depth;
+            continue;
+        }
+
+        const Link &link = m_links[frame.nextLink];
+        bool onPath = false;
+
+        frame.nextLink = link.next;
+
+        for (unsigned int i = 0; i < depth && !onPath; ++i)
+            onPath = (frames[i].cell == link.cell);
+
+        if (onPath)
+            continue;
+
+        // Clip the portal against the volume it is seen through. Every
+        // volume starts with the frustum's planes, in order, so the near
+        // plane is skipped by its index. Most planes don't cross the
+        // portal, so they are checked before clipping.
+        const Portal &portal = m_portals[link.portal];
+        const ConvexVolume &volume = query.m_volumes[frame.view];
+        const Vector3 *clipped = &m_vertices[portal.firstVertex];
+        unsigned int n = portal.vertexCount;
+        bool inPortal = isInPortal(eye, portal.plane, clipped, n, nearDistance);
+
+        for (unsigned int i = 0; i < volume.planeCount() && n >= 3 && !inPortal; ++i)
+        {
+            if (i == Frustum::FRUSTUM_PLANE_NEAR)
+                continue;
+
+            Plane plane = volume.plane(i);
+            unsigned int behind = 0;
+
+            for (unsigned int k = 0; k < n; ++k)
+                behind += (Vector3::dot(plane.n, clipped[k]) + plane.d < 0.0f) ? 1 : 0;
+
+            if (behind == 0)
+                continue;
+
+            Vector3 *out = (clipped == &query.m_clip[0][0]) ? &query.m_clip[1][0] : &query.m_clip[0][0];
+
+            n = (behind < n) ? Plane::clipPolygon(plane, clipped, n, out) : 0;
+            clipped = out;
+        }
+
+        if (n < 3)
+            continue;
+
+        if (query.m_viewCount == maxViews || depth == maxFrames)
+        {
+            complete = false;
+            continue;
+        }
+
+        unsigned int view = query.m_viewCount++;
+        ConvexVolume &narrowed = query.m_volumes[view];
+
+        // addPortal() leaves the volume unchanged when it fails.
+        narrowed.fromFrustum(frustum);
+
+        if (inPortal || !narrowed.addPortal(eye, clipped, n))
+            narrowed = volume;
+
+        query.m_viewCells[view] = link.cell;
+
+        if (query.m_visitStamps[link.cell] != query.m_stamp)
+        {
+            query.m_visitStamps[link.cell] = query.m_stamp;
+            query.m_visibleCells.push_back(link.cell);
+        }
+
+        frames[depth].cell = link.cell;
+        frames[depth].nextLink = m_cells[link.cell].firstLink;
+        frames[depth].view = view;
+        ++depth;
+    }
+
+    return complete;
+}
+
+unsigned int PortalGraph::portalCount() const
+{
+    return static_cast<unsigned int>(m_portals.size());
+}
+
+const Vector3 *PortalGraph::portalVertices(int portal) const
+{
+    return &m_vertices[m_portals[portal].firstVertex];
+}
+
+unsigned int PortalGraph::portalVertexCount(int portal) const
+{
+    return m_portals[portal].vertexCount;
+}
+
+//-----------------------------------------------------------------------------
+// PortalQuery.
+
+PortalQuery::PortalQuery()
+{
+    init(DEFAULT_MAX_VIEWS, DEFAULT_MAX_DEPTH);
+}
+
+PortalQuery::PortalQuery(unsigned int maxViews, unsigned int maxDepth)
+{
+    init((maxViews > 0) ? maxViews : 1, maxDepth);
+}
+
+PortalQuery::~PortalQuery()
+{
+}
+
+bool PortalQuery::isCellVisible(int cell) const
+{
+    return m_stamp != 0 && cell >= 0 && cell < static_cast<int>(m_visitStamps.size()) && m_visitStamps[cell] == m_stamp;
+}
+
+unsigned int PortalQuery::maxDepth() const
+{
+    return static_cast<unsigned int>(m_frames.size()) - 1;
+}
+
+unsigned int PortalQuery::maxViews() const
+{
+    return static_cast<unsigned int>(m_volumes.size());
+}
+
+int PortalQuery::viewCell(unsigned int view) const
+{
+    return m_viewCells[view];
+}
+
+unsigned int PortalQuery::viewCount() const
+{
+    return m_viewCount;
+}
+
+const ConvexVolume &PortalQuery::viewVolume(unsigned int view) const
+{
+    return m_volumes[view];
+}
+
+int PortalQuery::visibleCell(unsigned int i) const
+{
+    return m_visibleCells[i];
+}
+
+unsigned int PortalQuery::visibleCellCount() const
+{
+    return static_cast<unsigned int>(m_visibleCells.size());
+}
+
+void PortalQuery::init(unsigned int maxViews, unsigned int maxDepth)
+{
+    // One frame for the camera's cell plus one per portal on the path.
+
+    m_volumes.resize(maxViews);
+    m_viewCells.resize(maxViews);
+    m_frames.resize(maxDepth + 1);
+    m_visibleCells.reserve(maxViews);
+    m_clip[0].resize(MAX_CLIP_VERTICES);
+    m_clip[1].resize(MAX_CLIP_VERTICES);
+    m_viewCount = 0;
+    m_stamp = 0;
+}
@@ -0,0 +1,363 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2026 dhpoware. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#if !defined(OCCLUSION_H)
+#define OCCLUSION_H
+
+#include <atomic>
+#include <vector>
+
+#include "mathlib.h"
+#include "collision.h"
+
+class ThreadPool;
+
+//-----------------------------------------------------------------------------
+// The OcclusionCuller class culls objects hidden behind large occluders
+// (buildings, terrain, walls) using a small software rasterized depth
+// buffer. Frustum culling keeps everything inside the view volume; this
+// removes what is inside but can't be seen.
+//
+// Each frame:
+//
+//  1. beginFrame() clears the depth buffer and sets the view-projection
+//     matrix (world space to clip space, as passed to Frustum).
+//  2. addOccluder() queues the triangles of the occluders. Pick a few large,
+//     simple meshes; the occluder geometry must lie inside the real
+//     geometry, or objects that are actually visible will be culled.
+//  3. rasterize() draws the queued triangles into the depth buffer. The
+//     buffer is split into TILE_WIDTH x TILE_HEIGHT pixel tiles, each stored
+//     contiguously, and the ThreadPool version rasterizes the tiles in
+//     parallel. Each tile only visits the triangles that overlap it.
+//  4. isVisible() and testBoxes() test the objects' world space bounding
+//     boxes. A box is tested by its screen rectangle and its nearest depth:
+//     it is hidden if that depth is behind the depth buffer at every pixel
+//     of the rectangle. Boxes that cross the camera plane are visible.
+//
+// The depth buffer stores 1 / w (w is the clip space w, the distance along
+// the view direction for a perspective projection), which is linear in
+// screen space and works with any perspective projection convention.
+// Larger values are nearer, and the cleared buffer is 0 (infinitely far).
+// Only perspective projections are supported.
+//
+// Triangles are drawn double sided and clipped against the plane just in
+// front of the camera and against a guard band a few times the size of the
+// screen, so occluders of any size (a ground plane kilometers across under
+// the camera, say) are drawn. A pixel is covered when its center is inside a
+// triangle. The tests are conservative at the resolution of the buffer,
+// except that an object smaller than a pixel can be hidden by an occluder
+// that only covers the pixel's center.
+//
+// The queries are const and thread safe, so they can run in parallel once
+// rasterize() has returned. testedCount() and culledCount() count the boxes
+// tested and found hidden since the last beginFrame(). Boxes entirely off
+// screen are reported as not visible without being counted in either.
+
+class OcclusionCuller
+{
+public:
+    static const unsigned int DEFAULT_WIDTH = 256;
+    static const unsigned int DEFAULT_HEIGHT = 128;
+    static const unsigned int TILE_WIDTH = 32;
+    static const unsigned int TILE_HEIGHT = 16;
+
+    OcclusionCuller();
+    OcclusionCuller(unsigned int width, unsigned int height);
+    ~OcclusionCuller();
+
+    void addOccluder(const Vector3 *vertices, const unsigned int *indices, unsigned int triangleCount);
+    void addOccluder(const Matrix4 &modelMatrix, const Vector3 *vertices, const unsigned int *indices, unsigned int triangleCount);
+    void beginFrame(const Matrix4 &viewProjMatrix);
+    unsigned int culledCount() const;
+    float depth(unsigned int x, unsigned int y) const;
+    unsigned int height() const;
+    bool isVisible(const BoundingBox &box) const;
+    void rasterize();
+    void rasterize(ThreadPool &pool);
+    void readDepth(float *depth) const;
+    unsigned int testedCount() const;
+    void testBoxes(const BoundingBox *boxes, bool *visible, unsigned int count) const;
+    unsigned int triangleCount() const;
+    const Matrix4 &viewProjMatrix() const;
+    unsigned int width() const;
+
+private:
+    struct Triangle
+    {
+        float x[3];
+        float y[3];
+        float invW[3];
+    };
+
+    OcclusionCuller(const OcclusionCuller &);
+    OcclusionCuller &operator=(const OcclusionCuller &);
+
+    void addClippedTriangle(const Vector4 *clip);
+    void binTriangles();
+    void init(unsigned int width, unsigned int height);
+    unsigned int pixelIndex(unsigned int x, unsigned int y) const;
+    void rasterizeTile(unsigned int tile);
+    bool testRect(int x0, int y0, int x1, int y1, float invW) const;
+
+    std::vector<float> m_depth;
+    std::vector<Triangle> m_triangles;
+    std::vector<std::vector<unsigned int> > m_bins;
+    Matrix4 m_viewProjMatrix;
+    unsigned int m_width;
+    unsigned int m_height;
+    unsigned int m_tilesX;
+    unsigned int m_tilesY;
+    mutable std::atomic<unsigned int> m_tested;
+    mutable std::atomic<unsigned int> m_culled;
+};
+
+//-----------------------------------------------------------------------------
+// The HiZPyramid class is a hierarchical depth (Hi-Z) buffer: a mip chain
+// of a depth buffer in which each texel holds the farthest depth of the
+// 2 x 2 texels below it. It answers occlusion queries for bounding boxes
+// and spheres with at most 4 texel reads each, whatever their size on
+// screen, so it suits large batches of small objects.
+//
+// build() takes any depth buffer: the previous frame's depth from the
+// renderer (read back, usually at reduced resolution) or the buffer drawn
+// by an OcclusionCuller. The buffer is 'width' x 'height' floats, row by
+// row, and row 0 is the top of the screen (flip buffers read back from
+// OpenGL). The DepthConvention says how to read the values:
+//
+//  - DEPTH_NEG_ONE_TO_ONE: window depth in [0, 1] from an OpenGL style
+//    projection (clip space z in [-w, w]). Larger values are farther.
+//  - DEPTH_ZERO_TO_ONE: window depth in [0, 1] from a Direct3D style
+//    projection (clip space z in [0, w]). Larger values are farther.
+//  - DEPTH_REVERSED: reversed Z, window depth equal to clip space z / w.
+//    Larger values are nearer.
+//  - DEPTH_INVERSE_W: 1 / w, as stored by OcclusionCuller. Larger values
+//    are nearer.
+//
+// The queries take the view-projection matrix that produced the depth
+// buffer, so that the objects are projected the same way. An object is
+// hidden if the nearest depth of its bounding box is behind the farthest
+// depth in the texels that its screen rectangle touches, at the level
+// where that rectangle spans at most 2 x 2 texels. Spheres are tested by
+// their bounding boxes. Objects that cross the camera plane are visible.
+//
+// The batch versions chain with frustum culling: they only test the
+// objects still marked visible by Batch::cullBoxes() (visible[i] true), or
+// by the multi-frustum Batch::cullBoxes() and cullSpheres() (bit 'bit' of
+// masks[i] set), and clear the flag or bit of the objects that are hidden.
+// Objects rejected by the frustum test are not read again.
+
+class HiZPyramid
+{
+public:
+    enum DepthConvention
+    {
+        DEPTH_NEG_ONE_TO_ONE,
+        DEPTH_ZERO_TO_ONE,
+        DEPTH_REVERSED,
+        DEPTH_INVERSE_W
+    };
+
+    HiZPyramid();
+    ~HiZPyramid();
+
+    void build(const float *depth, unsigned int width, unsigned int height, DepthConvention convention);
+    void build(const OcclusionCuller &culler);
+    DepthConvention convention() const;
+    float farthestDepth(unsigned int level, unsigned int x, unsigned int y) const;
+    unsigned int height(unsigned int level) const;
+    bool isVisible(const Matrix4 &viewProjMatrix, const BoundingBox &box) const;
+    bool isVisible(const Matrix4 &viewProjMatrix, const BoundingSphere &sphere) const;
+    unsigned int levelCount() const;
+    void testBoxes(const Matrix4 &viewProjMatrix, const BoundingBox *boxes, bool *visible, unsigned int count) const;
+    void testBoxes(const Matrix4 &viewProjMatrix, const BoundingBox *boxes, unsigned int *masks, unsigned int bit, unsigned int count) const;
+    void testSpheres(const Matrix4 &viewProjMatrix, const BoundingSphere *spheres, bool *visible, unsigned int count) const;
+    void testSpheres(const Matrix4 &viewProjMatrix, const BoundingSphere *spheres, unsigned int *masks, unsigned int bit, unsigned int count) const;
+    unsigned int width(unsigned int level) const;
+
+private:
+    struct Level
+    {
+        unsigned int offset;
+        unsigned int width;
+        unsigned int height;
+    };
+
+    HiZPyramid(const HiZPyramid &);
+    HiZPyramid &operator=(const HiZPyramid &);
+
+    void buildLevels(unsigned int width, unsigned int height);
+    void reduceLevels();
+    bool testBox(const Matrix4 &m, const Vector3 &min, const Vector3 &max) const;
+
+    // Every level is stored in m_depth, finest first, as "larger is
+    // farther" keys: the values of the farther-is-larger conventions, and
+    // the negated values of the others.
+    std::vector<float> m_depth;
+    std::vector<Level> m_levels;
+    DepthConvention m_convention;
+};
+
+//-----------------------------------------------------------------------------
+// The PortalGraph class finds the cells (rooms) of an indoor level that can
+// be seen from the camera. The level is divided into cells, each with a
+// BoundingBox, and connected by portals: convex polygons (doorways and
+// windows) that join two cells and can be seen through from either side.
+//
+// findVisibleCells() starts in the camera's cell with a ConvexVolume built
+// from the view frustum, and walks the graph depth first. Each portal of
+// the current cell is clipped against the current volume; if anything is
+// left, the cell behind it is visible and is walked with a volume narrowed
+// to the clipped portal (ConvexVolume::fromPortal()). A cell can be reached
+// along several paths, but never twice on the same path, so loops in the
+// graph are fine. When a portal can't narrow the volume (the clipped
+// polygon is too thin or has too many vertices), the cell behind it is
+// walked with the current volume, which is conservative. The same goes for
+// a portal the camera is standing in: closer to its plane than the near
+// plane and inside its outline. Portals are not clipped against the near
+// plane, so that a doorway just in front of the camera still counts.
+//
+// Every visit of a cell is a "view": the cell and the volume it was seen
+// through. The objects of a cell are visible if they are inside any of its
+// views' volumes, which cull much more than the frustum alone.
+//
+// The queries are const and use no memory of their own. All of the scratch
+// memory and the results live in the PortalQuery passed in, which is sized
+// when it is constructed, so each thread can run its own queries and no
+// memory is allocated per frame (apart from the visited flags growing with
+// the number of cells).
+//
+// addCell() and addPortal() return the index of the new cell or portal, or
+// NO_CELL / NO_PORTAL if the input is invalid. Portals are planar, with at
+// least 3 and at most MAX_PORTAL_VERTICES vertices in either winding.
+
+class PortalQuery;
+
+class PortalGraph
+{
+public:
+    static const int NO_CELL = -1;
+    static const int NO_PORTAL = -1;
+    static const unsigned int MAX_PORTAL_VERTICES = 16;
+
+    PortalGraph();
+    ~PortalGraph();
+
+    int addCell(const BoundingBox &bounds);
+    int addPortal(int cellA, int cellB, const Vector3 *vertices, unsigned int vertexCount);
+    const BoundingBox &cellBounds(int cell) const;
+    unsigned int cellCount() const;
+    void clear();
+    int findCell(const Vector3 &point) const;
+    bool findVisibleCells(PortalQuery &query, const Vector3 &eye, const Frustum &frustum, int cell) const;
+    unsigned int portalCount() const;
+    const Vector3 *portalVertices(int portal) const;
+    unsigned int portalVertexCount(int portal) const;
+
+private:
+    struct Cell
+    {
+        BoundingBox bounds;
+        int firstLink;
+    };
+
+    struct Link
+    {
+        int portal;
+        int cell;
+        int next;
+    };
+
+    struct Portal
+    {
+        Plane plane;
+        unsigned int firstVertex;
+        unsigned int vertexCount;
+    };
+
+    PortalGraph(const PortalGraph &);
+    PortalGraph &operator=(const PortalGraph &);
+
+    // Each cell's links (one per portal, to the cell on the other side)
+    // form a list through Link::next.
+    std::vector<Cell> m_cells;
+    std::vector<Link> m_links;
+    std::vector<Portal> m_portals;
+    std::vector<Vector3> m_vertices;
+};
+
+//-----------------------------------------------------------------------------
+// The PortalQuery class holds the scratch memory and the results of
+// PortalGraph::findVisibleCells(). It holds up to 'maxViews' views and walks
+// paths of up to 'maxDepth' portals. findVisibleCells() returns false if
+// either limit was reached, in which case the results are incomplete.
+//
+// visibleCell() lists each visible cell once, in the order they were found.
+
+class PortalQuery
+{
+public:
+    static const unsigned int DEFAULT_MAX_VIEWS = 256;
+    static const unsigned int DEFAULT_MAX_DEPTH = 32;
+
+    PortalQuery();
+    PortalQuery(unsigned int maxViews, unsigned int maxDepth);
+    ~PortalQuery();
+
+    bool isCellVisible(int cell) const;
+    unsigned int maxDepth() const;
+    unsigned int maxViews() const;
+    int viewCell(unsigned int view) const;
+    unsigned int viewCount() const;
+    const ConvexVolume &viewVolume(unsigned int view) const;
+    int visibleCell(unsigned int i) const;
+    unsigned int visibleCellCount() const;
+
+private:
+    friend class PortalGraph;
+
+    static const unsigned int MAX_CLIP_VERTICES = PortalGraph::MAX_PORTAL_VERTICES + ConvexVolume::MAX_PLANES;
+
+    struct Frame
+    {
+        int cell;
+        int nextLink;
+        unsigned int view;
+    };
+
+    PortalQuery(const PortalQuery &);
+    PortalQuery &operator=(const PortalQuery &);
+
+    void init(unsigned int maxViews, unsigned int maxDepth);
+
+    std::vector<ConvexVolume> m_volumes;
+    std::vector<int> m_viewCells;
+    std::vector<Frame> m_frames;
+    std::vector<int> m_visibleCells;
+    std::vector<unsigned int> m_visitStamps;
+    std::vector<Vector3> m_clip[2];
+    unsigned int m_viewCount;
+    unsigned int m_stamp;
+};
+
+//-----------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,992 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2026 dhpoware. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include "test_main.h"
+#include "batch.h"
+
+void TestMathBatch();
+void DoBatchTest(Batch::Isa isa);
+
+//-----------------------------------------------------------------------------
+// Tests every variant of the Batch functions that the CPU supports.
+//-----------------------------------------------------------------------------
+
+void TestMathBatch()
+{
+    Batch::Isa original = Batch::isa();
+
+    for (int i = Batch::ISA_SCALAR; i <= Batch::supportedIsa(); ++i)
+        DoBatchTest(static_cast<Batch::Isa>(i));
+
+    Batch::setIsa(original);
+}
+
+//-----------------------------------------------------------------------------
+// Unit test the Batch class. Each function is compared against the
+// equivalent single object function in the library. The array sizes are not
+// multiples of the SIMD widths so that the remainder loops are tested too.
+//-----------------------------------------------------------------------------
+
+static bool isClose(float result, float expected)
+{
+    // The AVX2 variant uses fused multiply-add, so the results can differ
+    // in the last bits even when the expected value is close to zero.
+    return fabsf(result - expected) <= 1e-5f * (1.0f + fabsf(expected));
+}
+
+void DoBatchTest(Batch::Isa isa)
+{
+    const unsigned int count = 1003;
+    Random rng(static_cast<unsigned long long>(isa) + 1);
+
+    // Test 1: Selecting the variant.
+    {
+        if (!Batch::setIsa(isa) || Batch::isa() != isa)
+            throw std::runtime_error("DoBatchTest() : Test 1 Part A failed");
+
+        if (Batch::setIsa(static_cast<Batch::Isa>(Batch::ISA_AVX2 + 1)))
+            throw std::runtime_error("DoBatchTest() : Test 1 Part B failed");
+
+        if (Batch::isa() != isa)
+            throw std::runtime_error("DoBatchTest() : Test 1 Part C failed");
+    }
+
+    // Test 2: Matrix multiplication.
+    {
+        std::vector<Matrix4> lhs(count), rhs(count), result(count);
+
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            rng.fill(&lhs[i][0][0], 16, -2.0f, 2.0f);
+            rng.fill(&rhs[i][0][0], 16, -2.0f, 2.0f);
+        }
+
+        Batch::multiply(&lhs[0], &rhs[0], &result[0], count);
+
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            Matrix4 expected = lhs[i] * rhs[i];
+
+            for (int j = 0; j < 16; ++j)
+            {
+                if (!isClose(result[i][j / 4][j % 4], expected[j / 4][j % 4]))
+                    throw std::runtime_error("DoBatchTest() : Test 2 Part A failed");
+            }
+        }
+
+        // The result may overwrite either input.
+        std::vector<Matrix4> copy(lhs);
+
+        Batch::multiply(&copy[0], &rhs[0], &copy[0], count);
+
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            if (memcmp(&copy[i], &result[i], sizeof(Matrix4)) != 0)
+                throw std::runtime_error("DoBatchTest() : Test 2 Part B failed");
+        }
+
+        copy = rhs;
+        Batch::multiply(&lhs[0], &copy[0], &copy[0], count);
+
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            if (memcmp(&copy[i], &result[i], sizeof(Matrix4)) != 0)
+                throw std::runtime_error("DoBatchTest() : Test 2 Part C failed");
+        }
+
+        // Double precision matrices, in place.
+        std::vector<Matrix4d> lhsd(count), rhsd(count), resultd(count);
+
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            lhsd[i] = Matrix4d(lhs[i]) * 1.0e6;
+            rhsd[i] = Matrix4d(rhs[i]);
+        }
+
+        resultd = lhsd;
+        Batch::multiply(&resultd[0], &rhsd[0], &resultd[0], count);
+
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            Matrix4d expected = lhsd[i] * rhsd[i];
+
+            for (int j = 0; j < 16; ++j)
+            {
+                double e = expected[j / 4][j % 4];
+
+                if (fabs(resultd[i][j / 4][j % 4] - e) > 1e-13 * (1.0e6 + fabs(e)))
+                    throw std::runtime_error("DoBatchTest() : Test 2 Part D failed");
+            }
+        }
+    }
+
+    // Test 3: Point transformation.
+    {
+        Vector3 axis(1.0f, 2.0f, 3.0f);
+
+        axis.normalize();
+
+        Matrix4 m = Matrix4::createRotate(axis, 37.0f)
+            * Matrix4::createScale(2.0f, 0.5f, 3.0f)
+            * Matrix4::createTranslate(4.0f, -5.0f, 6.0f);
+        std::vector<Vector3> points(count), result(count + 1);
+
+        for (unsigned int i = 0; i < count; ++i)
+            points[i] = rng.inBox(Vector3(-100.0f, -100.0f, -100.0f), Vector3(100.0f, 100.0f, 100.0f));
+
+        // The element past the end must not be written to.
+        result[count].set(7.0f, 7.0f, 7.0f);
+
+        Batch::transformPoints(m, &points[0], &result[0], count);
+
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            Vector3 expected = points[i] * m + Vector3(m[3][0], m[3][1], m[3][2]);
+
+            if (!isClose(result[i].x, expected.x) || !isClose(result[i].y, expected.y)
+                || !isClose(result[i].z, expected.z))
+                throw std::runtime_error("DoBatchTest() : Test 3 Part A failed");
+        }
+
+        if (result[count].x != 7.0f || result[count].y != 7.0f || result[count].z != 7.0f)
+            throw std::runtime_error("DoBatchTest() : Test 3 Part B failed");
+    }
+
+    // Boxes scattered around a frustum-like volume containing the origin.
+    Frustum frustum;
+    std::vector<BoundingBox> boxes(count);
+
+    for (int i = 0; i < 6; ++i)
+    {
+        Vector3 n = rng.onSphere(1.0f);
+        frustum.planes[i] = Plane(n * -30.0f, n);
+    }
+
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        Vector3 center = rng.inBox(Vector3(-50.0f, -50.0f, -50.0f), Vector3(50.0f, 50.0f, 50.0f));
+        Vector3 extent = rng.inBox(Vector3(0.5f, 0.5f, 0.5f), Vector3(5.0f, 5.0f, 5.0f));
+
+        boxes[i] = BoundingBox(center - extent, center + extent);
+    }
+
+    // Test 4: Frustum culling.
+    {
+        bool visible[count];
+        unsigned int visibleCount = 0;
+
+        Batch::cullBoxes(frustum, &boxes[0], visible, count);
+
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            if (visible[i] != frustum.boxInFrustum(boxes[i]))
+                throw std::runtime_error("DoBatchTest() : Test 4 Part A failed");
+
+            if (visible[i])
+                ++visibleCount;
+        }
+
+        // Make sure the test exercised both outcomes.
+        if (visibleCount == 0 || visibleCount == count)
+            throw std::runtime_error("DoBatchTest() : Test 4 Part B failed");
+    }
+
+    // Test 5: Ray vs bounding box.
+    {
+        bool hit[count];
+        unsigned int hitCount = 0;
+
+        for (int pass = 0; pass < 8; ++pass)
+        {
+            Ray ray(rng.inBox(Vector3(-10.0f, -10.0f, -10.0f), Vector3(10.0f, 10.0f, 10.0f)),
+                rng.onSphere(1.0f));
+
+            Batch::rayIntersectsBoxes(ray, &boxes[0], hit, count);
+
+            for (unsigned int i = 0; i < count; ++i)
+            {
+                if (hit[i] != ray.hasIntersected(boxes[i]))
+                    throw std::runtime_error("DoBatchTest() : Test 5 Part A failed");
+
+                if (hit[i])
+                    ++hitCount;
+            }
+        }
+
+        if (hitCount == 0 || hitCount == 8 * count)
+            throw std::runtime_error("DoBatchTest() : Test 5 Part B failed");
+    }
+
+    // Double precision positions far from the world origin, around an
+    // origin that is just as far away. The differences are small, so they
+    // must survive the conversion to float with sub-millimetre precision.
+    Vector3d origin(12345678.125, -23456789.5, 34567890.25);
+    std::vector<Vector3d> positions(count);
+
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        Vector3 offset = rng.inBox(Vector3(-1000.0f, -1000.0f, -1000.0f), Vector3(1000.0f, 1000.0f, 1000.0f));
+        positions[i] = origin + Vector3d(offset) + Vector3d(0.0001, 0.0002, 0.0003);
+    }
+
+    // Test 6: Rebasing points.
+    {
+        std::vector<Vector3> result(count + 1);
+
+        // The element past the end must not be written to.
+        result[count].set(7.0f, 7.0f, 7.0f);
+
+        Batch::rebasePoints(origin, &positions[0], &result[0], count);
+
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            Vector3 expected(positions[i] - origin);
+
+            if (result[i].x != expected.x || result[i].y != expected.y || result[i].z != expected.z)
+                throw std::runtime_error("DoBatchTest() : Test 6 Part A failed");
+
+            if (fabs(result[i].x - (positions[i].x - origin.x)) > 1e-4)
+                throw std::runtime_error("DoBatchTest() : Test 6 Part B failed");
+        }
+
+        if (result[count].x != 7.0f || result[count].y != 7.0f || result[count].z != 7.0f)
+            throw std::runtime_error("DoBatchTest() : Test 6 Part C failed");
+    }
+
+    // Test 7: Rebasing matrices.
+    {
+        std::vector<Matrix4> matrices(count), result(count + 1);
+
+        for (unsigned int i = 0; i < count; ++i)
+            rng.fill(&matrices[i][0][0], 16, -2.0f, 2.0f);
+
+        // The element past the end must not be written to.
+        result[count] = Matrix4::IDENTITY;
+
+        Batch::rebaseMatrices(origin, &matrices[0], &positions[0], &result[0], count);
+
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            Matrix4 expected(matrices[i]);
+
+            expected[3][0] = static_cast<float>(matrices[i][3][0] + (positions[i].x - origin.x));
+            expected[3][1] = static_cast<float>(matrices[i][3][1] + (positions[i].y - origin.y));
+            expected[3][2] = static_cast<float>(matrices[i][3][2] + (positions[i].z - origin.z));
+
+            if (memcmp(&result[i], &expected, sizeof(Matrix4)) != 0)
+                throw std::runtime_error("DoBatchTest() : Test 7 Part A failed");
+        }
+
+        if (result[count] != Matrix4::IDENTITY)
+            throw std::runtime_error("DoBatchTest() : Test 7 Part B failed");
+
+        // The result may overwrite the input.
+        Batch::rebaseMatrices(origin, &matrices[0], &positions[0], &matrices[0], count);
+
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            if (memcmp(&matrices[i], &result[i], sizeof(Matrix4)) != 0)
+                throw std::runtime_error("DoBatchTest() : Test 7 Part C failed");
+        }
+    }
+
+    // Test 8: Culling against several frustums in one pass. Every frustum
+    // slot is used so that the top bit of the masks is tested too.
+    {
+        Frustum frustums[Batch::MAX_CULL_FRUSTUMS];
+        std::vector<BoundingSphere> spheres(count);
+        std::vector<unsigned int> masks(count + 1);
+
+        frustums[0] = frustum;
+
+        for (unsigned int f = 1; f < Batch::MAX_CULL_FRUSTUMS; ++f)
+        {
+            for (int i = 0; i < 6; ++i)
+            {
+                Vector3 n = rng.onSphere(1.0f);
+                frustums[f].planes[i] = Plane(n * -rng.nextFloat(10.0f, 40.0f), n);
+            }
+        }
+
+        for (unsigned int i = 0; i < count; ++i)
+            spheres[i] = BoundingSphere(boxes[i].getCenter(), boxes[i].getRadius());
+
+        // The element past the end must not be written to.
+        masks[count] = 0xdeadbeef;
+
+        if (!Batch::cullBoxes(frustums, Batch::MAX_CULL_FRUSTUMS, &boxes[0], &masks[0], count))
+            throw std::runtime_error("DoBatchTest() : Test 8 Part A failed");
+
+        unsigned int anyMask = 0;
+
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            for (unsigned int f = 0; f < Batch::MAX_CULL_FRUSTUMS; ++f)
+            {
+                if (((masks[i] >> f) & 1) != (frustums[f].boxInFrustum(boxes[i]) ? 1u : 0u))
+                    throw std::runtime_error("DoBatchTest() : Test 8 Part B failed");
+            }
+
+            anyMask |= masks[i];
+        }
+
+        if (masks[count] != 0xdeadbeef || (anyMask >> 31) == 0)
+            throw std::runtime_error("DoBatchTest() : Test 8 Part C failed");
+
+        if (!Batch::cullSpheres(frustums, Batch::MAX_CULL_FRUSTUMS, &spheres[0], &masks[0], count))
+            throw std::runtime_error("DoBatchTest() : Test 8 Part D failed");
+
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            for (unsigned int f = 0; f < Batch::MAX_CULL_FRUSTUMS; ++f)
+            {
+                if (((masks[i] >> f) & 1) != (frustums[f].sphereInFrustum(spheres[i]) ? 1u : 0u))
+                    throw std::runtime_error("DoBatchTest() : Test 8 Part E failed");
+            }
+        }
+
+        // Fewer frustums leave the upper bits clear, and too many are
+        // rejected.
+        Batch::cullBoxes(frustums, 3, &boxes[0], &masks[0], count);
+
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            if ((masks[i] >> 3) != 0)
+                throw std::runtime_error("DoBatchTest() : Test 8 Part F failed");
+        }
+
+        if (Batch::cullSpheres(frustums, Batch::MAX_CULL_FRUSTUMS + 1, &spheres[0], &masks[0], count))
+            throw std::runtime_error("DoBatchTest() : Test 8 Part G failed");
+    }
+
+    // Test 9: Culling object space boxes against model-view-projection
+    // matrices. The expected result transforms the box center and half
+    // extents to clip space the same way, with the library's types.
+    {
+        const Matrix4 proj = Matrix4::createPerspective(60.0f, 1.5f, 0.1f, 100.0f);
+
+        std::vector<Matrix4> mvps(count);
+        std::vector<BoundingBox> localBoxes(count);
+        std::vector<bool> expected(count);
+        bool visible[count];
+        unsigned int visibleCount = 0;
+
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            Vector3 position = rng.inBox(Vector3(-80.0f, -80.0f, -120.0f), Vector3(80.0f, 80.0f, 20.0f));
+            Vector3 extent = rng.inBox(Vector3(0.5f, 0.5f, 0.5f), Vector3(5.0f, 5.0f, 5.0f));
+
+            mvps[i] = rng.unitQuaternion().toMatrix4()
+                * Matrix4::createTranslate(position.x, position.y, position.z) * proj;
+            localBoxes[i] = BoundingBox(-extent, extent * 2.0f);
+        }
+
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            const Matrix4 &m = mvps[i];
+            Vector3 center = localBoxes[i].getCenter();
+            Vector3 extent = (localBoxes[i].max - localBoxes[i].min) * 0.5f;
+            Vector4 c = Vector4(center, 1.0f) * m;
+            float e[4];
+
+            for (int k = 0; k < 4; ++k)
+                e[k] = extent.x * fabsf(m[0][k]) + extent.y * fabsf(m[1][k]) + extent.z * fabsf(m[2][k]);
+
+            float w = c.w + e[3];
+
+            expected[i] = c.x + e[0] + w > 0.0f && w + e[0] - c.x > 0.0f
+                && c.y + e[1] + w > 0.0f && w + e[1] - c.y > 0.0f
+                && c.z + e[2] + w > 0.0f && w + e[2] - c.z > 0.0f;
+        }
+
+        Batch::cullBoxesClipSpace(&mvps[0], &localBoxes[0], visible, count);
+
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            if (visible[i] != expected[i])
+                throw std::runtime_error("DoBatchTest() : Test 9 Part A failed");
+
+            visibleCount += visible[i] ? 1 : 0;
+        }
+
+        if (visibleCount == 0 || visibleCount == count)
+            throw std::runtime_error("DoBatchTest() : Test 9 Part B failed");
+
+        // The test is conservative: a box with a corner inside the clip
+        // volume is visible.
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            for (int k = 0; k < 8 && !visible[i]; ++k)
+            {
+                const BoundingBox &b = localBoxes[i];
+                Vector3 corner((k & 1) ? b.max.x : b.min.x, (k & 2) ? b.max.y : b.min.y, (k & 4) ? b.max.z : b.min.z);
+                Vector4 clip = Vector4(corner, 1.0f) * mvps[i];
+
+                if (fabsf(clip.x) < clip.w && fabsf(clip.y) < clip.w && fabsf(clip.z) < clip.w)
+                    throw std::runtime_error("DoBatchTest() : Test 9 Part C failed");
+            }
+        }
+
+        // One box shared by every instance.
+        std::vector<BoundingBox> copies(count, localBoxes[0]);
+        bool shared[count];
+
+        Batch::cullBoxesClipSpace(&mvps[0], localBoxes[0], shared, count);
+        Batch::cullBoxesClipSpace(&mvps[0], &copies[0], visible, count);
+
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            if (shared[i] != visible[i])
+                throw std::runtime_error("DoBatchTest() : Test 9 Part D failed");
+        }
+    }
+
+    // Test 10: Screen space projection of spheres and boxes, compared with
+    // projecting one object at a time with Vector4 * Matrix4.
+    {
+        const Matrix4 proj = Matrix4::createPerspective(60.0f, 1.5f, 0.1f, 100.0f);
+
+        Matrix4 view = Matrix4::createRotate(Vector3(0.0f, 1.0f, 0.0f), 20.0f) * Matrix4::createTranslate(1.0f, -2.0f, -3.0f);
+        Matrix4 viewProj = view * proj;
+        std::vector<BoundingSphere> spheres(count);
+        std::vector<float> depths(count + 1), radii(count + 1);
+        std::vector<Vector4> rects(count + 1);
+        unsigned int behindCount = 0;
+
+        for (unsigned int i = 0; i < count; ++i)
+            spheres[i] = BoundingSphere(boxes[i].getCenter(), boxes[i].getRadius());
+
+        // The elements past the end must not be written to.
+        depths[count] = radii[count] = 7.0f;
+        rects[count].set(7.0f, 7.0f, 7.0f, 7.0f);
+
+        Batch::projectSpheres(view, proj, &spheres[0], &depths[0], &radii[0], count);
+
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            Vector4 v = Vector4(spheres[i].center, 1.0f) * view;
+            float d = -v.z, r = spheres[i].radius;
+
+            if (!isClose(depths[i], d))
+                throw std::runtime_error("DoBatchTest() : Test 10 Part A failed");
+
+            if (d > r)
+            {
+                if (!isClose(radii[i], r * proj[1][1] / sqrtf(d * d - r * r)))
+                    throw std::runtime_error("DoBatchTest() : Test 10 Part B failed");
+            }
+            else if (radii[i] != FLT_MAX)
+            {
+                throw std::runtime_error("DoBatchTest() : Test 10 Part C failed");
+            }
+        }
+
+        Batch::projectBoxes(viewProj, &boxes[0], &rects[0], &depths[0], count);
+
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            const BoundingBox &b = boxes[i];
+            Vector4 expected(FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX);
+            float nearest = FLT_MAX;
+
+            for (int k = 0; k < 8; ++k)
+            {
+                Vector3 corner((k & 1) ? b.max.x : b.min.x, (k & 2) ? b.max.y : b.min.y, (k & 4) ? b.max.z : b.min.z);
+                Vector4 clip = Vector4(corner, 1.0f) * viewProj;
+
+                nearest = std::min(nearest, clip.w);
+                expected.x = std::min(expected.x, clip.x / clip.w);
+                expected.y = std::min(expected.y, clip.y / clip.w);
+                expected.z = std::max(expected.z, clip.x / clip.w);
+                expected.w = std::max(expected.w, clip.y / clip.w);
+            }
+
+            if (!isClose(depths[i], nearest))
+                throw std::runtime_error("DoBatchTest() : Test 10 Part D failed");
+
+            if (nearest <= 0.0f)
+            {
+                expected.set(-1.0f, -1.0f, 1.0f, 1.0f);
+                ++behindCount;
+            }
+
+            // Corners close to the camera plane project far off screen, so
+            // the tolerance is relative.
+            if (!isClose(rects[i].x, expected.x) || !isClose(rects[i].y, expected.y)
+                || !isClose(rects[i].z, expected.z) || !isClose(rects[i].w, expected.w))
+                throw std::runtime_error("DoBatchTest() : Test 10 Part E failed");
+        }
+
+        if (behindCount == 0 || behindCount == count)
+            throw std::runtime_error("DoBatchTest() : Test 10 Part F failed");
+
+        if (depths[count] != 7.0f || radii[count] != 7.0f || rects[count].x != 7.0f || rects[count].w != 7.0f)
+            throw std::runtime_error("DoBatchTest() : Test 10 Part G failed");
+    }
+
+    // Test 11: LOD selection from per-object thresholds.
+    {
+        const unsigned int thresholdCount = 3;
+        std::vector<float> sizes(count), thresholds(count * thresholdCount);
+        std::vector<unsigned int> lods(count + 1);
+        unsigned int lodCounts[thresholdCount + 1] = { 0 };
+
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            float scale = rng.nextFloat(0.5f, 2.0f);
+
+            sizes[i] = rng.nextFloat(0.0f, 1.0f);
+            thresholds[i * thresholdCount + 0] = 0.4f * scale;
+            thresholds[i * thresholdCount + 1] = 0.2f * scale;
+            thresholds[i * thresholdCount + 2] = 0.1f * scale;
+        }
+
+        // Sizes equal to a threshold select that threshold's level.
+        sizes[5] = thresholds[5 * thresholdCount + 1];
+
+        // The element past the end must not be written to.
+        lods[count] = 0xdeadbeef;
+
+        Batch::selectLods(&sizes[0], &thresholds[0], thresholdCount, &lods[0], count);
+
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            const float *t = &thresholds[i * thresholdCount];
+            unsigned int expected = (sizes[i] >= t[0]) ? 0 : (sizes[i] >= t[1]) ? 1 : (sizes[i] >= t[2]) ? 2 : 3;
+
+            if (lods[i] != expected)
+                throw std::runtime_error("DoBatchTest() : Test 11 Part A failed");
+
+            ++lodCounts[lods[i]];
+        }
+
+        if (lods[5] != 1 || lods[count] != 0xdeadbeef)
+            throw std::runtime_error("DoBatchTest() : Test 11 Part B failed");
+
+        for (unsigned int k = 0; k <= thresholdCount; ++k)
+        {
+            if (lodCounts[k] == 0)
+                throw std::runtime_error("DoBatchTest() : Test 11 Part C failed");
+        }
+
+        // Without thresholds every object gets level 0.
+        Batch::selectLods(&sizes[0], &thresholds[0], 0, &lods[0], count);
+
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            if (lods[i] != 0)
+                throw std::runtime_error("DoBatchTest() : Test 11 Part D failed");
+        }
+    }
+
+    // Test 12: Culling against convex volumes with different plane counts,
+    // so that partly filled groups of planes are tested too.
+    {
+        std::vector<BoundingSphere> spheres(count);
+        bool visible[count + 1];
+
+        for (unsigned int i = 0; i < count; ++i)
+            spheres[i] = BoundingSphere(boxes[i].getCenter(), boxes[i].getRadius());
+
+        for (unsigned int planeCount = 4; planeCount <= 20; planeCount += 3)
+        {
+            ConvexVolume volume;
+            unsigned int boxCount = 0, sphereCount = 0;
+
+            for (unsigned int i = 0; i < planeCount; ++i)
+            {
+                Vector3 n = rng.onSphere(1.0f);
+                volume.addPlane(Plane(n * -rng.nextFloat(20.0f, 40.0f), n));
+            }
+
+            // The element past the end must not be written to.
+            visible[count] = true;
+
+            Batch::cullBoxes(volume, &boxes[0], visible, count);
+
+            for (unsigned int i = 0; i < count; ++i)
+            {
+                if (visible[i] != volume.boxInVolume(boxes[i]))
+                    throw std::runtime_error("DoBatchTest() : Test 12 Part A failed");
+
+                boxCount += visible[i] ? 1 : 0;
+            }
+
+            Batch::cullSpheres(volume, &spheres[0], visible, count);
+
+            for (unsigned int i = 0; i < count; ++i)
+            {
+                if (visible[i] != volume.sphereInVolume(spheres[i]))
+                    throw std::runtime_error("DoBatchTest() : Test 12 Part B failed");
+
+                sphereCount += visible[i] ? 1 : 0;
+            }
+
+            if (!visible[count] || boxCount == 0 || boxCount == count || sphereCount == 0 || sphereCount == count)
+                throw std::runtime_error("DoBatchTest() : Test 12 Part C failed");
+        }
+
+    }
+
+    // Test 13: Clipping triangles to a frustum, compared with clipping each
+    // triangle with Frustum::clipPolygon(). Vertices close to a plane can be
+    // classified differently by the fused multiply-add variant, so the
+    // clipped areas are compared rather than the vertices.
+    {
+        std::vector<Vector3> triangles(count * 3);
+        std::vector<Vector3> result(count * 7 + 1);
+        std::vector<Vector3> resumed(count * 7);
+        Vector3 polygon[Frustum::MAX_CLIP_VERTICES];
+        double area = 0.0, expectedArea = 0.0;
+        unsigned int expectedCount = 0, consumed = 0;
+
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            Vector3 center = rng.inBox(Vector3(-50.0f, -50.0f, -50.0f), Vector3(50.0f, 50.0f, 50.0f));
+
+            for (int k = 0; k < 3; ++k)
+                triangles[i * 3 + k] = center + rng.inBox(Vector3(-20.0f, -20.0f, -20.0f), Vector3(20.0f, 20.0f, 20.0f));
+
+            unsigned int n = frustum.clipPolygon(&triangles[i * 3], 3, polygon);
+
+            for (unsigned int k = 1; k + 1 < n; ++k)
+                expectedArea += Vector3::cross(polygon[k] - polygon[0], polygon[k + 1] - polygon[0]).magnitude();
+
+            expectedCount += (n >= 3) ? n - 2 : 0;
+        }
+
+        // The element past the end must not be written to.
+        result[count * 7] = Vector3(7.0f, 7.0f, 7.0f);
+
+        unsigned int written = Batch::clipTriangles(frustum, &triangles[0], count, &result[0], count * 7, &consumed);
+
+        if (consumed != count || written == 0 || written > expectedCount + 8 || written + 8 < expectedCount
+            || result[count * 7] != Vector3(7.0f, 7.0f, 7.0f))
+            throw std::runtime_error("DoBatchTest() : Test 13 Part A failed");
+
+        for (unsigned int i = 0; i < written * 3; ++i)
+        {
+            for (int j = 0; j < 6; ++j)
+            {
+                if (Plane::dot(frustum.planes[j], result[i]) < -1e-3f)
+                    throw std::runtime_error("DoBatchTest() : Test 13 Part B failed");
+            }
+
+            if (i % 3 == 2)
+                area += Vector3::cross(result[i - 1] - result[i - 2], result[i] - result[i - 2]).magnitude();
+        }
+
+        if (fabs(area - expectedArea) > 1e-3 * expectedArea)
+            throw std::runtime_error("DoBatchTest() : Test 13 Part C failed");
+
+        // With a small output buffer the function stops early, and resuming
+        // from the consumed count produces the same triangles.
+        unsigned int total = 0, done = 0;
+
+        while (done < count)
+        {
+            unsigned int n = Batch::clipTriangles(frustum, &triangles[done * 3], count - done, &resumed[total * 3], 37, &consumed);
+
+            if (n > 37 || (consumed == 0 && n == 0))
+                throw std::runtime_error("DoBatchTest() : Test 13 Part D failed");
+
+            total += n;
+            done += consumed;
+        }
+
+        if (done != count || total != written || memcmp(&resumed[0], &result[0], written * 3 * sizeof(Vector3)) != 0)
+            throw std::runtime_error("DoBatchTest() : Test 13 Part E failed");
+    }
+
+    // Test 14: Capsule queries over arrays of capsules, compared with the
+    // Capsule, Frustum and Ray functions. Pairs that only just touch are
+    // skipped, since the variants may round them either way.
+    {
+        std::vector<float> coords(count * 7);
+        std::vector<Capsule> capsules(count);
+        Batch::CapsuleArrays arrays;
+        bool result[count];
+        unsigned int hitCount = 0, visibleCount = 0;
+
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            Vector3 a = rng.inBox(Vector3(-60.0f, -60.0f, -60.0f), Vector3(60.0f, 60.0f, 60.0f));
+            Vector3 b = a + rng.inSphere(10.0f);
+
+            // Some capsules are spheres.
+            if (i % 10 == 0)
+                b = a;
+
+            capsules[i] = Capsule(a, b, rng.nextFloat(0.5f, 4.0f));
+            coords[i] = a.x, coords[count + i] = a.y, coords[count * 2 + i] = a.z;
+            coords[count * 3 + i] = b.x, coords[count * 4 + i] = b.y, coords[count * 5 + i] = b.z;
+            coords[count * 6 + i] = capsules[i].radius;
+        }
+
+        arrays.ax = &coords[0], arrays.ay = &coords[count], arrays.az = &coords[count * 2];
+        arrays.bx = &coords[count * 3], arrays.by = &coords[count * 4], arrays.bz = &coords[count * 5];
+        arrays.radius = &coords[count * 6];
+
+        Batch::cullCapsules(frustum, arrays, result, count);
+
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            if (result[i] != frustum.capsuleInFrustum(capsules[i]))
+                throw std::runtime_error("DoBatchTest() : Test 14 Part A failed");
+
+            visibleCount += result[i] ? 1 : 0;
+        }
+
+        for (int pass = 0; pass < 8; ++pass)
+        {
+            Vector3 a = rng.inBox(Vector3(-50.0f, -50.0f, -50.0f), Vector3(50.0f, 50.0f, 50.0f));
+            Capsule capsule(a, a + rng.inSphere(20.0f), rng.nextFloat(1.0f, 10.0f));
+            BoundingSphere sphere(a, capsule.radius);
+            Ray ray(a, rng.onSphere(1.0f));
+            bool sphereHit[count], rayHit[count];
+
+            if (pass == 0)
+                capsule.b = capsule.a;
+
+            Batch::capsuleIntersectsCapsules(capsule, arrays, result, count);
+            Batch::sphereIntersectsCapsules(sphere, arrays, sphereHit, count);
+            Batch::rayIntersectsCapsules(ray, arrays, rayHit, count);
+
+            for (unsigned int i = 0; i < count; ++i)
+            {
+                const Capsule &c = capsules[i];
+                float s, u;
+                float capsuleSq = Capsule::closestPoints(c.a, c.b, capsule.a, capsule.b, s, u);
+                float sphereSq = Capsule::closestPoints(c.a, c.b, sphere.center, sphere.center, s, u);
+                float raySq = Capsule::closestPoints(c.a, c.b, ray.origin, ray.origin + ray.direction * 1000.0f, s, u);
+                float radii = c.radius + capsule.radius;
+
+                if (fabsf(sqrtf(capsuleSq) - radii) > 1e-3f && result[i] != c.hasCollided(capsule))
+                    throw std::runtime_error("DoBatchTest() : Test 14 Part B failed");
+
+                if (fabsf(sqrtf(sphereSq) - radii) > 1e-3f && sphereHit[i] != c.hasCollided(sphere))
+                    throw std::runtime_error("DoBatchTest() : Test 14 Part C failed");
+
+                if (fabsf(sqrtf(raySq) - c.radius) > 1e-3f && rayHit[i] != ray.hasIntersected(c))
+                    throw std::runtime_error("DoBatchTest() : Test 14 Part D failed");
+
+                hitCount += (result[i] ? 1 : 0) + (rayHit[i] ? 1 : 0);
+            }
+        }
+
+        // Make sure the test exercised both outcomes.
+        if (visibleCount == 0 || visibleCount == count || hitCount == 0)
+            throw std::runtime_error("DoBatchTest() : Test 14 Part E failed");
+    }
+
+    // Test 15: Swept spheres and boxes, compared with the Sweep functions.
+    // Sweeps that only just graze the obstacle are skipped: a slightly
+    // smaller shape misses it and a slightly larger one hits it.
+    {
+        const BoundingBox obstacle(Vector3(-5.0f, -4.0f, -6.0f), Vector3(5.0f, 6.0f, 4.0f));
+        const BoundingSphere ball(Vector3(1.0f, -2.0f, 0.5f), 5.0f);
+        Vector3 n = rng.onSphere(1.0f);
+        const Plane plane(n.x, n.y, n.z, rng.nextFloat(-5.0f, 5.0f));
+        std::vector<BoundingSphere> spheres(count);
+        std::vector<BoundingBox> boxes(count);
+        std::vector<Vector3> velocities(count), normals(count);
+        std::vector<float> times(count), bare(count);
+        unsigned int hitCount[4] = { 0, 0, 0, 0 };
+
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            Vector3 center = rng.inBox(Vector3(-40.0f, -40.0f, -40.0f), Vector3(40.0f, 40.0f, 40.0f));
+            Vector3 target = rng.inBox(Vector3(-9.0f, -9.0f, -9.0f), Vector3(9.0f, 9.0f, 9.0f));
+
+            spheres[i] = BoundingSphere(center, rng.nextFloat(0.5f, 3.0f));
+            boxes[i] = BoundingBox(center - rng.inBox(Vector3(0.5f, 0.5f, 0.5f), Vector3(3.0f, 3.0f, 3.0f)),
+                center + rng.inBox(Vector3(0.5f, 0.5f, 0.5f), Vector3(3.0f, 3.0f, 3.0f)));
+            velocities[i] = (target - center) * rng.nextFloat(0.3f, 1.5f);
+
+            // Some shapes don't move along an axis, or at all.
+            if (i % 7 == 0)
+                velocities[i].y = 0.0f;
+
+            if (i % 61 == 0)
+                velocities[i] = Vector3(0.0f, 0.0f, 0.0f);
+        }
+
+        for (int query = 0; query < 4; ++query)
+        {
+            switch (query)
+            {
+            case 0:
+                Batch::sweepSpheres(plane, &spheres[0], &velocities[0], &times[0], &normals[0], count);
+                Batch::sweepSpheres(plane, &spheres[0], &velocities[0], &bare[0], 0, count);
+                break;
+
+            case 1:
+                Batch::sweepSpheres(ball, &spheres[0], &velocities[0], &times[0], &normals[0], count);
+                Batch::sweepSpheres(ball, &spheres[0], &velocities[0], &bare[0], 0, count);
+                break;
+
+            case 2:
+                Batch::sweepSpheres(obstacle, &spheres[0], &velocities[0], &times[0], &normals[0], count);
+                Batch::sweepSpheres(obstacle, &spheres[0], &velocities[0], &bare[0], 0, count);
+                break;
+
+            default:
+                Batch::sweepBoxes(obstacle, &boxes[0], &velocities[0], &times[0], &normals[0], count);
+                Batch::sweepBoxes(obstacle, &boxes[0], &velocities[0], &bare[0], 0, count);
+                break;
+            }
+
+            for (unsigned int i = 0; i < count; ++i)
+            {
+                const BoundingSphere &s = spheres[i];
+                const Vector3 grow(1e-3f, 1e-3f, 1e-3f);
+                BoundingSphere smaller(s.center, s.radius - 1e-3f), larger(s.center, s.radius + 1e-3f);
+                BoundingBox smallerBox(boxes[i].min + grow, boxes[i].max - grow), largerBox(boxes[i].min - grow, boxes[i].max + grow);
+                float t = FLT_MAX, ignored;
+                Vector3 normal, unused;
+                bool inner, outer;
+
+                switch (query)
+                {
+                case 0:
+                    Sweep::timeOfImpact(s, velocities[i], plane, t, normal);
+                    inner = Sweep::timeOfImpact(smaller, velocities[i], plane, ignored, unused);
+                    outer = Sweep::timeOfImpact(larger, velocities[i], plane, ignored, unused);
+                    break;
+
+                case 1:
+                    Sweep::timeOfImpact(s, velocities[i], ball, t, normal);
+                    inner = Sweep::timeOfImpact(smaller, velocities[i], ball, ignored, unused);
+                    outer = Sweep::timeOfImpact(larger, velocities[i], ball, ignored, unused);
+                    break;
+
+                case 2:
+                    Sweep::timeOfImpact(s, velocities[i], obstacle, t, normal);
+                    inner = Sweep::timeOfImpact(smaller, velocities[i], obstacle, ignored, unused);
+                    outer = Sweep::timeOfImpact(larger, velocities[i], obstacle, ignored, unused);
+                    break;
+
+                default:
+                    Sweep::timeOfImpact(boxes[i], velocities[i], obstacle, t, normal);
+                    inner = Sweep::timeOfImpact(smallerBox, velocities[i], obstacle, ignored, unused);
+                    outer = Sweep::timeOfImpact(largerBox, velocities[i], obstacle, ignored, unused);
+                    break;
+                }
+
+                if (inner != outer)
+                    continue;
+
+                if (bare[i] != times[i] || (times[i] == FLT_MAX) != (t == FLT_MAX))
+                    throw std::runtime_error("DoBatchTest() : Test 15 Part A failed");
+
+                if (t == FLT_MAX)
+                    continue;
+
+                if (fabsf(times[i] - t) > 1e-4f || Vector3::dot(normals[i], normal) < 0.99f)
+                    throw std::runtime_error("DoBatchTest() : Test 15 Part B failed");
+
+                ++hitCount[query];
+            }
+        }
+
+        // Make sure the test exercised both outcomes.
+        for (int query = 0; query < 4; ++query)
+        {
+            if (hitCount[query] == 0 || hitCount[query] == count)
+                throw std::runtime_error("DoBatchTest() : Test 15 Part C failed");
+        }
+    }
+
+    // Test 16: The array forms of the Math::fast* functions, which use the
+    // selected variant's kernels, compared with the scalar forms.
+    {
+        std::vector<float> x(count), y(count), r1(count), r2(count);
+
+        // Values beyond |x| = 8192 are passed to sinf() and cosf(), one
+        // of them in the remainder.
+        rng.fill(&x[0], count, -100.0f, 100.0f);
+        x[5] = 3.5e9f;
+        x[count - 1] = -1.0e30f;
+        Math::fastSinCos(&x[0], &r1[0], &r2[0], count);
+
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            if (!isClose(r1[i], Math::fastSin(x[i])) || !isClose(r2[i], Math::fastCos(x[i])))
+                throw std::runtime_error("DoBatchTest() : Test 16 Part A failed");
+        }
+
+        Math::fastSin(&x[0], &r1[0], count);
+        Math::fastCos(&x[0], &r2[0], count);
+
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            if (!isClose(r1[i], Math::fastSin(x[i])) || !isClose(r2[i], Math::fastCos(x[i])))
+                throw std::runtime_error("DoBatchTest() : Test 16 Part B failed");
+        }
+
+        rng.fill(&x[0], count, -1.0f, 1.0f);
+        rng.fill(&y[0], count, -1.0f, 1.0f);
+        Math::fastAcos(&x[0], &r1[0], count);
+        Math::fastAtan2(&y[0], &x[0], &r2[0], count);
+
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            if (!isClose(r1[i], Math::fastAcos(x[i])) || !isClose(r2[i], Math::fastAtan2(y[i], x[i])))
+                throw std::runtime_error("DoBatchTest() : Test 16 Part C failed");
+        }
+
+        rng.fill(&x[0], count, -80.0f, 80.0f);
+        Math::fastExp(&x[0], &r1[0], count);
+
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            float expected = Math::fastExp(x[i]);
+
+            if (fabsf(r1[i] - expected) > 1e-6f * expected)
+                throw std::runtime_error("DoBatchTest() : Test 16 Part D failed");
+        }
+
+        rng.fill(&x[0], count, 1e-6f, 1e6f);
+        Math::fastLog(&x[0], &r1[0], count);
+        Math::fastRsqrt(&x[0], &r2[0], count);
+
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            float expected = Math::fastRsqrt(x[i]);
+
+            if (!isClose(r1[i], Math::fastLog(x[i])) || fabsf(r2[i] - expected) > 1e-6f * expected)
+                throw std::runtime_error("DoBatchTest() : Test 16 Part E failed");
+        }
+
+        // The result may overwrite the input.
+        Math::fastLog(&x[0], &x[0], count);
+
+        if (memcmp(&x[0], &r1[0], count * sizeof(float)) != 0)
+            throw std::runtime_error("DoBatchTest() : Test 16 Part F failed");
+    }
+}
@@ -20,11 +20,21 @@
 // IN THE SOFTWARE.
 //-----------------------------------------------------------------------------
 
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
 #include "test_main.h"
 
 void TestMathCollision();
+void DoCapsuleTest();
+void DoCollisionStatsTest();
+void DoConvexVolumeTest();
+void DoCylinderTest();
+void DoFrustumTest();
 void DoPlaneTest();
 void DoRayTest();
+void DoSweepTest();
 
 //-----------------------------------------------------------------------------
 // Tests all of the collision related math classes.
@@ -34,6 +44,12 @@ void TestMathCollision()
 {
     DoPlaneTest();
     DoRayTest();
+    DoFrustumTest();
+    DoConvexVolumeTest();
+    DoCapsuleTest();
+    DoCylinderTest();
+    DoSweepTest();
+    DoCollisionStatsTest();
 }
 
 //-----------------------------------------------------------------------------
@@ -111,6 +127,90 @@ void DoPlaneTest()
         if (Plane::dot(p, Vector3(0.0f, 0.0f, -1.0f)) >= 0.0f)
             throw std::runtime_error("DoPlaneTest() : Plane dot product case 3 failed");
     }
+
+    // Test 7: Double precision planes far from the origin.
+    {
+        Planed p(Vector3d(1.0e8, 0.0, 0.0), Vector3d(1.0, 0.0, 0.0));
+
+        // Case 1: Distances are exact even though the plane is far away.
+        if (Planed::dot(p, Vector3d(1.0e8 + 0.5, 3.0, 4.0)) != 0.5)
+            throw std::runtime_error("DoPlaneTest() : Double precision plane case 1 failed");
+
+        // Case 2: Conversion to float.
+        if (Plane(Planed(0.0, 1.0, 0.0, -2.0)) != Plane(0.0f, 1.0f, 0.0f, -2.0f))
+            throw std::runtime_error("DoPlaneTest() : Double precision plane case 2 failed");
+
+        // Case 3: Bounding boxes.
+        BoundingBoxd box(Vector3d(1.0e8, 0.0, 0.0), Vector3d(1.0e8 + 1.0, 2.0, 2.0));
+
+        if (box.getCenter() != Vector3d(1.0e8 + 0.5, 1.0, 1.0) || BoundingBox(box).max != Vector3(1.0e8f, 2.0f, 2.0f))
+            throw std::runtime_error("DoPlaneTest() : Double precision plane case 3 failed");
+    }
+
+    // Test 8: Distances of an array of points.
+    {
+        Vector3 normal(1.0f, -2.0f, 0.5f);
+        normal.normalize();
+
+        Plane p(Vector3(1.0f, 2.0f, 3.0f), normal);
+        Random rng(8);
+        Vector3 points[11];
+        float distances[12];
+
+        for (int i = 0; i < 11; ++i)
+            points[i] = Vector3(rng.nextFloat(-10.0f, 10.0f), rng.nextFloat(-10.0f, 10.0f), rng.nextFloat(-10.0f, 10.0f));
+
+        // The element past the end must not be written to.
+        distances[11] = 7.0f;
+        Plane::dot(p, points, distances, 11);
+
+        // Allow for the compiler contracting either form into FMAs.
+        for (int i = 0; i < 11; ++i)
+        {
+            if (fabsf(distances[i] - Plane::dot(p, points[i])) > 1e-5f)
+                throw std::runtime_error("DoPlaneTest() : Plane dot product array failed");
+        }
+
+        if (distances[11] != 7.0f)
+            throw std::runtime_error("DoPlaneTest() : Plane dot product array overrun");
+    }
+
+    // Test 9: Clipping a polygon.
+    {
+        Plane p(0.0f, 1.0f, 0.0f, -1.0f);
+        Vector3 square[4] =
+        {
+            Vector3(0.0f, 0.0f, 0.0f),
+            Vector3(2.0f, 0.0f, 0.0f),
+            Vector3(2.0f, 2.0f, 0.0f),
+            Vector3(0.0f, 2.0f, 0.0f)
+        };
+        Vector3 result[5];
+
+        // Case 1: The part above y = 1 is kept. The closing edge is walked
+        // first, so the result starts with its crossing point.
+        if (Plane::clipPolygon(p, square, 4, result) != 4
+            || result[0] != Vector3(0.0f, 1.0f, 0.0f) || result[1] != Vector3(2.0f, 1.0f, 0.0f)
+            || result[2] != Vector3(2.0f, 2.0f, 0.0f) || result[3] != Vector3(0.0f, 2.0f, 0.0f))
+            throw std::runtime_error("DoPlaneTest() : Plane clip polygon case 1 failed");
+
+        // Case 2: Entirely in front, and entirely behind.
+        if (Plane::clipPolygon(Plane(0.0f, 1.0f, 0.0f, 1.0f), square, 4, result) != 4 || result[2] != square[2]
+            || Plane::clipPolygon(Plane(0.0f, -1.0f, 0.0f, -3.0f), square, 4, result) != 0)
+            throw std::runtime_error("DoPlaneTest() : Plane clip polygon case 2 failed");
+
+        // Case 3: Cutting a corner adds a vertex.
+        if (Plane::clipPolygon(Plane(-1.0f, -1.0f, 0.0f, 3.0f), square, 4, result) != 5)
+            throw std::runtime_error("DoPlaneTest() : Plane clip polygon case 3 failed");
+
+        // Case 4: Double precision.
+        Vector3d squared[4] = { Vector3d(square[0]), Vector3d(square[1]), Vector3d(square[2]), Vector3d(square[3]) };
+        Vector3d resultd[5];
+
+        if (Planed::clipPolygon(Planed(0.0, 1.0, 0.0, -1.0), squared, 4, resultd) != 4
+            || resultd[1] != Vector3d(2.0, 1.0, 0.0))
+            throw std::runtime_error("DoPlaneTest() : Plane clip polygon case 4 failed");
+    }
 }
 
 //-----------------------------------------------------------------------------
@@ -210,4 +310,1032 @@ void DoRayTest()
         if (ray.hasIntersected(xzPlane))
             throw std::runtime_error("DoRayTest() : Test 10 failed");
     }
+}
+
+//-----------------------------------------------------------------------------
+// Unit test the Frustum class. The different ways of building a frustum are
+// checked against each other and against points around the camera.
+//-----------------------------------------------------------------------------
+
+static bool planesClose(const Plane &result, const Plane &expected)
+{
+    return fabsf(result.n.x - expected.n.x) <= 1e-4f
+        && fabsf(result.n.y - expected.n.y) <= 1e-4f
+        && fabsf(result.n.z - expected.n.z) <= 1e-4f
+        && fabsf(result.d - expected.d) <= 1e-3f * (1.0f + fabsf(expected.d));
+}
+
+void DoFrustumTest()
+{
+    // A camera at (10, 2, -5) turned 30 degrees about the y axis.
+    Matrix4 rotation = Matrix4::createRotate(Vector3(0.0f, 1.0f, 0.0f), 30.0f);
+    Matrix4 view = Matrix4::createTranslate(-10.0f, -2.0f, 5.0f) * rotation.transpose();
+    Matrix4 proj = Matrix4::createPerspective(60.0f, 16.0f / 9.0f, 0.5f, 200.0f);
+    Frustum extracted(view, proj);
+
+    // Test 1: Extracting from the combined matrix.
+    {
+        Frustum frustum(view * proj);
+
+        for (int i = 0; i < 6; ++i)
+        {
+            if (frustum.planes[i] != extracted.planes[i])
+            {
+                PrintPlanes(frustum.planes[i], extracted.planes[i]);
+                throw std::runtime_error("DoFrustumTest() : Test 1 failed");
+            }
+        }
+    }
+
+    // Test 2: Building from the perspective parameters. The side and far
+    // planes match the extracted ones. The near plane is at exactly
+    // 'znear' in front of the camera.
+    {
+        Frustum frustum(60.0f, 16.0f / 9.0f, 0.5f, 200.0f, view);
+
+        for (int i = 0; i < 6; ++i)
+        {
+            if (i != Frustum::FRUSTUM_PLANE_NEAR && !planesClose(frustum.planes[i], extracted.planes[i]))
+            {
+                PrintPlanes(frustum.planes[i], extracted.planes[i]);
+                throw std::runtime_error("DoFrustumTest() : Test 2 Part A failed");
+            }
+        }
+
+        Vector3 camera(10.0f, 2.0f, -5.0f);
+        Vector3 forward = Vector3(0.0f, 0.0f, -1.0f) * rotation;
+
+        if (!frustum.pointInFrustum(camera + forward * 0.51f)
+            || frustum.pointInFrustum(camera + forward * 0.49f))
+            throw std::runtime_error("DoFrustumTest() : Test 2 Part B failed");
+
+        if (!frustum.pointInFrustum(camera + forward * 199.0f)
+            || frustum.pointInFrustum(camera + forward * 201.0f))
+            throw std::runtime_error("DoFrustumTest() : Test 2 Part C failed");
+    }
+
+    // Test 3: Moving a view space frustum with the camera. The view space
+    // planes are extracted from the projection matrix alone, and once moved
+    // they match the planes extracted from the view-projection matrix.
+    {
+        Frustum viewSpace(proj);
+        Frustum frustum;
+
+        frustum.fromViewSpace(viewSpace, view);
+
+        for (int i = 0; i < 6; ++i)
+        {
+            if (!planesClose(frustum.planes[i], extracted.planes[i]))
+            {
+                PrintPlanes(frustum.planes[i], extracted.planes[i]);
+                throw std::runtime_error("DoFrustumTest() : Test 3 Part A failed");
+            }
+        }
+
+        // Transforming in place.
+        viewSpace.fromViewSpace(viewSpace, view);
+
+        for (int i = 0; i < 6; ++i)
+        {
+            if (viewSpace.planes[i] != frustum.planes[i])
+                throw std::runtime_error("DoFrustumTest() : Test 3 Part B failed");
+        }
+    }
+
+    // Test 4: Clipping polygons to the frustum.
+    {
+        Random rng(4);
+        Vector3 camera(10.0f, 2.0f, -5.0f);
+        Vector3 result[Frustum::MAX_CLIP_VERTICES];
+        unsigned int clippedCount = 0;
+
+        for (int i = 0; i < 200; ++i)
+        {
+            // Triangles around the camera, most of them crossing a plane.
+            Vector3 triangle[3];
+
+            for (int k = 0; k < 3; ++k)
+                triangle[k] = camera + Vector3(rng.nextFloat(-150.0f, 150.0f), rng.nextFloat(-150.0f, 150.0f), rng.nextFloat(-150.0f, 150.0f));
+
+            unsigned int n = extracted.clipPolygon(triangle, 3, result);
+
+            if (n != 0 && (n < 3 || n > 9))
+                throw std::runtime_error("DoFrustumTest() : Test 4 Part A failed");
+
+            // The result is inside the frustum (up to rounding), and its
+            // vertices are points of the triangle's plane.
+            Plane plane(triangle[0], triangle[1], triangle[2]);
+
+            for (unsigned int k = 0; k < n; ++k)
+            {
+                for (int j = 0; j < 6; ++j)
+                {
+                    if (Plane::dot(extracted.planes[j], result[k]) < -1e-3f * (1.0f + fabsf(extracted.planes[j].d)))
+                        throw std::runtime_error("DoFrustumTest() : Test 4 Part B failed");
+                }
+
+                if (fabsf(Plane::dot(plane, result[k])) > 1e-2f)
+                    throw std::runtime_error("DoFrustumTest() : Test 4 Part C failed");
+            }
+
+            if (n != 0 && n != 3)
+                ++clippedCount;
+        }
+
+        if (clippedCount == 0)
+            throw std::runtime_error("DoFrustumTest() : Test 4 Part D failed");
+
+        // A triangle inside the frustum is unchanged, and one behind the
+        // camera is removed.
+        Vector3 forward = Vector3(0.0f, 0.0f, -1.0f) * rotation;
+        Vector3 right = Vector3(1.0f, 0.0f, 0.0f) * rotation;
+        Vector3 inside[3] = { camera + forward * 10.0f, camera + forward * 10.0f + right, camera + forward * 11.0f };
+        Vector3 behind[3] = { camera - forward * 10.0f, camera - forward * 10.0f + right, camera - forward * 11.0f };
+
+        if (extracted.clipPolygon(inside, 3, result) != 3 || result[1] != inside[1]
+            || extracted.clipPolygon(behind, 3, result) != 0)
+            throw std::runtime_error("DoFrustumTest() : Test 4 Part E failed");
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Unit test the ConvexVolume class. A volume built from a frustum must agree
+// with the frustum, and a portal must narrow the volume to what can be seen
+// through it.
+//-----------------------------------------------------------------------------
+
+void DoConvexVolumeTest()
+{
+    Matrix4 rotation = Matrix4::createRotate(Vector3(0.0f, 1.0f, 0.0f), 30.0f);
+    Matrix4 view = Matrix4::createTranslate(-10.0f, -2.0f, 5.0f) * rotation.transpose();
+    Frustum frustum(view, Matrix4::createPerspective(60.0f, 16.0f / 9.0f, 0.5f, 200.0f));
+    Random rng(45);
+
+    // Test 1: A volume built from a frustum agrees with the frustum.
+    {
+        ConvexVolume volume(frustum);
+
+        if (volume.planeCount() != 6)
+            throw std::runtime_error("DoConvexVolumeTest() : Test 1 Part A failed");
+
+        for (int i = 0; i < 6; ++i)
+        {
+            if (volume.plane(i) != frustum.planes[i])
+                throw std::runtime_error("DoConvexVolumeTest() : Test 1 Part B failed");
+        }
+
+        for (int i = 0; i < 1000; ++i)
+        {
+            Vector3 center(rng.nextFloat(-150.0f, 150.0f), rng.nextFloat(-50.0f, 50.0f), rng.nextFloat(-250.0f, 50.0f));
+            Vector3 extent(rng.nextFloat(0.0f, 10.0f), rng.nextFloat(0.0f, 10.0f), rng.nextFloat(0.0f, 10.0f));
+            BoundingBox box(center - extent, center + extent);
+            BoundingSphere sphere(center, extent.x);
+
+            if (volume.pointInVolume(center) != frustum.pointInFrustum(center))
+                throw std::runtime_error("DoConvexVolumeTest() : Test 1 Part C failed");
+
+            if (volume.boxInVolume(box) != frustum.boxInFrustum(box))
+                throw std::runtime_error("DoConvexVolumeTest() : Test 1 Part D failed");
+
+            if (volume.sphereInVolume(sphere) != frustum.sphereInFrustum(sphere))
+                throw std::runtime_error("DoConvexVolumeTest() : Test 1 Part E failed");
+        }
+
+        // An empty volume contains everything.
+        volume.clear();
+
+        if (volume.planeCount() != 0 || !volume.pointInVolume(Vector3(1e6f, -1e6f, 1e6f)))
+            throw std::runtime_error("DoConvexVolumeTest() : Test 1 Part F failed");
+    }
+
+    // Test 2: Looking through a square portal 10 units in front of a camera
+    // at the origin. Only what is beyond the portal and inside the pyramid
+    // through its edges is visible.
+    {
+        Frustum viewFrustum(Matrix4::IDENTITY, Matrix4::createPerspective(90.0f, 1.0f, 0.5f, 100.0f));
+        Vector3 eye(0.0f, 0.0f, 0.0f);
+        Vector3 portal[4] =
+        {
+            Vector3(-1.0f, -1.0f, -10.0f),
+            Vector3( 1.0f, -1.0f, -10.0f),
+            Vector3( 1.0f,  1.0f, -10.0f),
+            Vector3(-1.0f,  1.0f, -10.0f)
+        };
+        ConvexVolume volume;
+
+        if (!volume.fromPortal(viewFrustum, eye, portal, 4) || volume.planeCount() != 11)
+            throw std::runtime_error("DoConvexVolumeTest() : Test 2 Part A failed");
+
+        if (!volume.pointInVolume(Vector3(0.0f, 0.0f, -20.0f))
+            || !volume.pointInVolume(Vector3(1.5f, 0.0f, -20.0f)))
+            throw std::runtime_error("DoConvexVolumeTest() : Test 2 Part B failed");
+
+        if (volume.pointInVolume(Vector3(0.0f, 0.0f, -5.0f))
+            || volume.pointInVolume(Vector3(5.0f, 0.0f, -20.0f))
+            || volume.pointInVolume(Vector3(0.0f, 0.0f, -150.0f)))
+            throw std::runtime_error("DoConvexVolumeTest() : Test 2 Part C failed");
+
+        if (!volume.sphereInVolume(BoundingSphere(Vector3(3.0f, 0.0f, -20.0f), 1.5f))
+            || volume.sphereInVolume(BoundingSphere(Vector3(3.0f, 0.0f, -20.0f), 0.5f)))
+            throw std::runtime_error("DoConvexVolumeTest() : Test 2 Part D failed");
+
+        if (!volume.boxInVolume(BoundingBox(Vector3(1.0f, 1.0f, -12.0f), Vector3(3.0f, 3.0f, -11.0f)))
+            || volume.boxInVolume(BoundingBox(Vector3(2.0f, 2.0f, -8.0f), Vector3(3.0f, 3.0f, -7.0f))))
+            throw std::runtime_error("DoConvexVolumeTest() : Test 2 Part E failed");
+
+        // The winding of the portal does not matter.
+        Vector3 reversed[4] = { portal[3], portal[2], portal[1], portal[0] };
+        ConvexVolume other;
+
+        if (!other.fromPortal(viewFrustum, eye, reversed, 4))
+            throw std::runtime_error("DoConvexVolumeTest() : Test 2 Part F failed");
+
+        for (int i = 0; i < 1000; ++i)
+        {
+            Vector3 point(rng.nextFloat(-10.0f, 10.0f), rng.nextFloat(-10.0f, 10.0f), rng.nextFloat(-30.0f, 0.0f));
+
+            if (volume.pointInVolume(point) != other.pointInVolume(point))
+                throw std::runtime_error("DoConvexVolumeTest() : Test 2 Part G failed");
+        }
+    }
+
+    // Test 3: Invalid input leaves the volume unchanged.
+    {
+        ConvexVolume volume(frustum);
+        Vector3 eye(0.0f, 0.0f, 0.0f);
+        Vector3 degenerate[3] = { Vector3(0.0f, 0.0f, -10.0f), Vector3(1.0f, 0.0f, -10.0f), Vector3(2.0f, 0.0f, -10.0f) };
+        Vector3 edgeOn[3] = { Vector3(0.0f, 1.0f, -10.0f), Vector3(0.0f, -1.0f, -10.0f), Vector3(0.0f, 0.0f, -20.0f) };
+
+        if (volume.addPortal(eye, degenerate, 3) || volume.addPortal(eye, edgeOn, 3)
+            || volume.addPortal(eye, degenerate, 2) || volume.fromPortal(frustum, eye, edgeOn, 3))
+            throw std::runtime_error("DoConvexVolumeTest() : Test 3 Part A failed");
+
+        if (volume.planeCount() != 6 || volume.plane(0) != frustum.planes[0])
+            throw std::runtime_error("DoConvexVolumeTest() : Test 3 Part B failed");
+
+        for (unsigned int i = 6; i < ConvexVolume::MAX_PLANES; ++i)
+        {
+            if (!volume.addPlane(Plane(0.0f, 1.0f, 0.0f, static_cast<float>(i))))
+                throw std::runtime_error("DoConvexVolumeTest() : Test 3 Part C failed");
+        }
+
+        if (volume.addPlane(Plane(0.0f, 1.0f, 0.0f, 0.0f)) || volume.planeCount() != ConvexVolume::MAX_PLANES)
+            throw std::runtime_error("DoConvexVolumeTest() : Test 3 Part D failed");
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Unit test the Capsule class. The closest points between segments are
+// checked against dense sampling, and each query against the distance it
+// stands for.
+//-----------------------------------------------------------------------------
+
+// The squared distance from 'point' to 'box', found without the library.
+static float boxDistanceSq(const Vector3 &point, const BoundingBox &box)
+{
+    float dx = std::max(std::max(box.min.x - point.x, point.x - box.max.x), 0.0f);
+    float dy = std::max(std::max(box.min.y - point.y, point.y - box.max.y), 0.0f);
+    float dz = std::max(std::max(box.min.z - point.z, point.z - box.max.z), 0.0f);
+
+    return dx * dx + dy * dy + dz * dz;
+}
+
+void DoCapsuleTest()
+{
+    Random rng(49);
+
+    // Test 1: Closest points of known segments.
+    {
+        float s, t;
+        float distanceSq = Capsule::closestPoints(Vector3(0.0f, 0.0f, 0.0f), Vector3(2.0f, 0.0f, 0.0f),
+            Vector3(0.5f, 1.0f, -1.0f), Vector3(0.5f, 1.0f, 1.0f), s, t);
+
+        if (!Math::closeEnough(distanceSq, 1.0f) || !Math::closeEnough(s, 0.25f) || !Math::closeEnough(t, 0.5f))
+            throw std::runtime_error("DoCapsuleTest() : Test 1 Part A failed");
+
+        // Beyond the end of the first segment.
+        distanceSq = Capsule::closestPoints(Vector3(0.0f, 0.0f, 0.0f), Vector3(1.0f, 0.0f, 0.0f),
+            Vector3(3.0f, 1.0f, 0.0f), Vector3(3.0f, 2.0f, 0.0f), s, t);
+
+        if (!Math::closeEnough(distanceSq, 5.0f) || s != 1.0f || t != 0.0f)
+            throw std::runtime_error("DoCapsuleTest() : Test 1 Part B failed");
+
+        // Parallel segments, and segments that are points.
+        distanceSq = Capsule::closestPoints(Vector3(0.0f, 0.0f, 0.0f), Vector3(1.0f, 0.0f, 0.0f),
+            Vector3(0.5f, 2.0f, 0.0f), Vector3(3.0f, 2.0f, 0.0f), s, t);
+
+        if (!Math::closeEnough(distanceSq, 4.0f))
+            throw std::runtime_error("DoCapsuleTest() : Test 1 Part C failed");
+
+        distanceSq = Capsule::closestPoints(Vector3(1.0f, 1.0f, 1.0f), Vector3(1.0f, 1.0f, 1.0f),
+            Vector3(1.0f, 3.0f, 1.0f), Vector3(1.0f, 3.0f, 1.0f), s, t);
+
+        if (!Math::closeEnough(distanceSq, 4.0f) || s != 0.0f || t != 0.0f)
+            throw std::runtime_error("DoCapsuleTest() : Test 1 Part D failed");
+    }
+
+    // Test 2: Closest points of random segments. No sampled pair of points
+    // is closer, and the points returned are as close as the closest
+    // sampled pair.
+    {
+        for (int i = 0; i < 200; ++i)
+        {
+            Vector3 p1 = rng.inSphere(4.0f), q1 = rng.inSphere(4.0f);
+            Vector3 p2 = rng.inSphere(4.0f), q2 = rng.inSphere(4.0f);
+            float s, t;
+            float distanceSq = Capsule::closestPoints(p1, q1, p2, q2, s, t);
+            float sampledSq = 1e30f;
+
+            if (s < 0.0f || s > 1.0f || t < 0.0f || t > 1.0f)
+                throw std::runtime_error("DoCapsuleTest() : Test 2 Part A failed");
+
+            Vector3 diff((p1 + (q1 - p1) * s) - (p2 + (q2 - p2) * t));
+
+            if (fabsf(Vector3::dot(diff, diff) - distanceSq) > 1e-3f)
+                throw std::runtime_error("DoCapsuleTest() : Test 2 Part B failed");
+
+            for (int j = 0; j <= 64; ++j)
+            {
+                for (int k = 0; k <= 64; ++k)
+                {
+                    Vector3 w((p1 + (q1 - p1) * (j / 64.0f)) - (p2 + (q2 - p2) * (k / 64.0f)));
+                    sampledSq = std::min(sampledSq, Vector3::dot(w, w));
+                }
+            }
+
+            if (distanceSq > sampledSq + 1e-4f || sqrtf(sampledSq) - sqrtf(distanceSq) > 0.1f)
+                throw std::runtime_error("DoCapsuleTest() : Test 2 Part C failed");
+        }
+    }
+
+    // Test 3: Capsule vs sphere, capsule and plane. Shapes that just touch
+    // collide.
+    {
+        Capsule capsule(Vector3(0.0f, 0.0f, 0.0f), Vector3(0.0f, 4.0f, 0.0f), 1.0f);
+
+        if (!capsule.hasCollided(BoundingSphere(Vector3(1.5f, 2.0f, 0.0f), 0.5f))
+            || capsule.hasCollided(BoundingSphere(Vector3(1.6f, 2.0f, 0.0f), 0.5f))
+            || !capsule.hasCollided(BoundingSphere(Vector3(0.0f, 5.5f, 0.0f), 0.6f))
+            || capsule.hasCollided(BoundingSphere(Vector3(0.0f, 5.5f, 0.0f), 0.4f)))
+            throw std::runtime_error("DoCapsuleTest() : Test 3 Part A failed");
+
+        if (!capsule.hasCollided(Capsule(Vector3(-5.0f, 2.0f, 1.5f), Vector3(5.0f, 2.0f, 1.5f), 0.5f))
+            || capsule.hasCollided(Capsule(Vector3(-5.0f, 2.0f, 1.6f), Vector3(5.0f, 2.0f, 1.6f), 0.5f))
+            || !capsule.hasCollided(Capsule(Vector3(1.0f, 5.0f, 0.0f), Vector3(3.0f, 7.0f, 0.0f), 0.5f)))
+            throw std::runtime_error("DoCapsuleTest() : Test 3 Part B failed");
+
+        if (!capsule.hasCollided(Plane(0.0f, 1.0f, 0.0f, 1.0f))
+            || capsule.hasCollided(Plane(0.0f, 1.0f, 0.0f, 1.1f))
+            || !capsule.hasCollided(Plane(0.0f, -1.0f, 0.0f, 5.0f))
+            || !capsule.hasCollided(Plane(1.0f, 0.0f, 0.0f, 0.0f)))
+            throw std::runtime_error("DoCapsuleTest() : Test 3 Part C failed");
+
+        if (!capsule.pointInCapsule(Vector3(0.0f, -1.0f, 0.0f)) || capsule.pointInCapsule(Vector3(0.8f, -0.8f, 0.0f))
+            || !capsule.pointInCapsule(Vector3(0.99f, 3.0f, 0.0f)))
+            throw std::runtime_error("DoCapsuleTest() : Test 3 Part D failed");
+    }
+
+    // Test 4: Capsule vs box. The distance from the segment to the box is
+    // convex along the segment, so a ternary search finds it.
+    {
+        BoundingBox box(Vector3(-1.0f, -2.0f, -0.5f), Vector3(1.0f, 0.5f, 2.0f));
+        int hits = 0;
+
+        for (int i = 0; i < 2000; ++i)
+        {
+            Capsule capsule(rng.inBox(Vector3(-4.0f, -4.0f, -4.0f), Vector3(4.0f, 4.0f, 4.0f)),
+                rng.inBox(Vector3(-4.0f, -4.0f, -4.0f), Vector3(4.0f, 4.0f, 4.0f)), rng.nextFloat(0.1f, 1.5f));
+            Vector3 d(capsule.b - capsule.a);
+            float lo = 0.0f, hi = 1.0f;
+
+            for (int j = 0; j < 100; ++j)
+            {
+                float m1 = lo + (hi - lo) / 3.0f;
+                float m2 = hi - (hi - lo) / 3.0f;
+
+                if (boxDistanceSq(capsule.a + d * m1, box) < boxDistanceSq(capsule.a + d * m2, box))
+                    hi = m2;
+                else
+                    lo = m1;
+            }
+
+            float distance = sqrtf(boxDistanceSq(capsule.a + d * lo, box));
+
+            if (fabsf(distance - capsule.radius) < 1e-3f)
+                continue;
+
+            bool expected = distance < capsule.radius;
+
+            if (capsule.hasCollided(box) != expected)
+                throw std::runtime_error("DoCapsuleTest() : Test 4 failed");
+
+            hits += expected ? 1 : 0;
+        }
+
+        if (hits < 200 || hits > 1800)
+            throw std::runtime_error("DoCapsuleTest() : Test 4 Part B failed");
+    }
+
+    // Test 5: Ray vs capsule. A hit is on the surface, at the distance of
+    // the closest points of the segment and the ray, and rays starting
+    // inside hit at t = 0.
+    {
+        Capsule capsule(Vector3(-1.0f, 0.5f, 0.0f), Vector3(2.0f, -0.5f, 1.0f), 0.75f);
+        int hits = 0;
+
+        for (int i = 0; i < 1000; ++i)
+        {
+            // Aimed at points around the capsule, so that about half hit.
+            Vector3 origin = rng.inSphere(6.0f);
+            Vector3 direction = rng.inSphere(2.0f) + Vector3(0.5f, 0.0f, 0.5f) - origin;
+            float t = -1.0f;
+
+            direction.normalize();
+
+            Ray ray(origin, direction);
+            bool hit = ray.hasIntersected(capsule, t);
+            float s, u;
+            float distanceSq = Capsule::closestPoints(capsule.a, capsule.b, origin, origin + direction * 100.0f, s, u);
+
+            if (fabsf(sqrtf(distanceSq) - capsule.radius) < 1e-3f)
+                continue;
+
+            if (hit != (distanceSq < capsule.radius * capsule.radius) || hit != ray.hasIntersected(capsule))
+                throw std::runtime_error("DoCapsuleTest() : Test 5 Part A failed");
+
+            if (!hit)
+                continue;
+
+            ++hits;
+
+            Vector3 point(origin + direction * t);
+            float pointSq = Capsule::closestPoints(capsule.a, capsule.b, point, point, s, u);
+
+            if (capsule.pointInCapsule(origin))
+            {
+                if (t != 0.0f)
+                    throw std::runtime_error("DoCapsuleTest() : Test 5 Part B failed");
+            }
+            else if (t < 0.0f || fabsf(sqrtf(pointSq) - capsule.radius) > 1e-3f)
+            {
+                throw std::runtime_error("DoCapsuleTest() : Test 5 Part C failed");
+            }
+        }
+
+        if (hits < 200 || hits > 800)
+            throw std::runtime_error("DoCapsuleTest() : Test 5 Part D failed");
+
+        // Along the axis, hitting the end cap.
+        float t;
+        Ray ray(Vector3(0.0f, 10.0f, 0.0f), Vector3(0.0f, -1.0f, 0.0f));
+
+        if (!ray.hasIntersected(Capsule(Vector3(0.0f, 0.0f, 0.0f), Vector3(0.0f, 4.0f, 0.0f), 1.0f), t)
+            || !Math::closeEnough(t, 5.0f))
+            throw std::runtime_error("DoCapsuleTest() : Test 5 Part E failed");
+    }
+
+    // Test 6: Capsule vs frustum. A capsule with both ends at the same point
+    // is a sphere, and a capsule is inside when a sphere along its segment
+    // is, and outside only when none of them are.
+    {
+        Matrix4 view = Matrix4::createTranslate(-10.0f, -2.0f, 5.0f);
+        Frustum frustum(view, Matrix4::createPerspective(60.0f, 16.0f / 9.0f, 0.5f, 200.0f));
+
+        for (int i = 0; i < 1000; ++i)
+        {
+            Vector3 a = Vector3(10.0f, 2.0f, -5.0f) + rng.inSphere(100.0f);
+            Vector3 b = a + rng.inSphere(30.0f);
+            float radius = rng.nextFloat(0.1f, 10.0f);
+
+            if (frustum.capsuleInFrustum(Capsule(a, a, radius)) != frustum.sphereInFrustum(BoundingSphere(a, radius)))
+                throw std::runtime_error("DoCapsuleTest() : Test 6 Part A failed");
+
+            Capsule capsule(a, b, radius);
+            bool inside = frustum.capsuleInFrustum(capsule);
+
+            for (int j = 0; j <= 16; ++j)
+            {
+                if (frustum.sphereInFrustum(BoundingSphere(a + (b - a) * (j / 16.0f), radius)) && !inside)
+                    throw std::runtime_error("DoCapsuleTest() : Test 6 Part B failed");
+            }
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Unit test the Cylinder class.
+//-----------------------------------------------------------------------------
+
+void DoCylinderTest()
+{
+    Random rng(50);
+    Cylinder cylinder(Vector3(0.0f, 0.0f, 0.0f), Vector3(0.0f, 4.0f, 0.0f), 1.0f);
+
+    // Test 1: Points inside and outside.
+    {
+        if (!cylinder.pointInCylinder(Vector3(0.0f, 0.0f, 0.0f)) || !cylinder.pointInCylinder(Vector3(0.7f, 3.9f, -0.7f))
+            || cylinder.pointInCylinder(Vector3(0.0f, -0.1f, 0.0f)) || cylinder.pointInCylinder(Vector3(0.8f, 2.0f, 0.8f)))
+            throw std::runtime_error("DoCylinderTest() : Test 1 failed");
+    }
+
+    // Test 2: Cylinder vs sphere: beside the side, above a cap, and past
+    // the rim, where only the corner of the cylinder can be reached.
+    {
+        if (!cylinder.hasCollided(BoundingSphere(Vector3(2.0f, 2.0f, 0.0f), 1.0f))
+            || cylinder.hasCollided(BoundingSphere(Vector3(2.1f, 2.0f, 0.0f), 1.0f))
+            || !cylinder.hasCollided(BoundingSphere(Vector3(0.5f, 4.5f, 0.0f), 0.5f))
+            || cylinder.hasCollided(BoundingSphere(Vector3(0.5f, 4.6f, 0.0f), 0.5f)))
+            throw std::runtime_error("DoCylinderTest() : Test 2 Part A failed");
+
+        if (!cylinder.hasCollided(BoundingSphere(Vector3(1.7f, 4.7f, 0.0f), 1.0f))
+            || cylinder.hasCollided(BoundingSphere(Vector3(1.8f, 4.8f, 0.0f), 1.0f)))
+            throw std::runtime_error("DoCylinderTest() : Test 2 Part B failed");
+    }
+
+    // Test 3: Cylinder vs plane. The tilted plane is compared with points
+    // sampled on the rims of the caps.
+    {
+        if (!cylinder.hasCollided(Plane(1.0f, 0.0f, 0.0f, 1.0f)) || cylinder.hasCollided(Plane(1.0f, 0.0f, 0.0f, 1.1f))
+            || !cylinder.hasCollided(Plane(0.0f, 1.0f, 0.0f, 0.0f)) || cylinder.hasCollided(Plane(0.0f, -1.0f, 0.0f, -4.1f)))
+            throw std::runtime_error("DoCylinderTest() : Test 3 Part A failed");
+
+        for (int i = 0; i < 200; ++i)
+        {
+            Vector3 n = rng.inSphere(1.0f);
+
+            n.normalize();
+
+            Plane plane(n.x, n.y, n.z, rng.nextFloat(-5.0f, 5.0f));
+            float lo = 1e30f, hi = -1e30f;
+
+            for (int j = 0; j < 256; ++j)
+            {
+                float angle = j * (2.0f * Math::PI / 256.0f);
+
+                for (int k = 0; k < 2; ++k)
+                {
+                    float d = Plane::dot(plane, Vector3(cosf(angle), k * 4.0f, sinf(angle)));
+
+                    lo = std::min(lo, d);
+                    hi = std::max(hi, d);
+                }
+            }
+
+            if (lo > 1e-2f || hi < -1e-2f)
+            {
+                if (cylinder.hasCollided(plane) != (lo <= 0.0f && hi >= 0.0f))
+                    throw std::runtime_error("DoCylinderTest() : Test 3 Part B failed");
+            }
+        }
+    }
+
+    // Test 4: Ray vs cylinder: the side, a cap, past the rim, and from
+    // inside.
+    {
+        float t;
+
+        if (!Ray(Vector3(5.0f, 2.0f, 0.0f), Vector3(-1.0f, 0.0f, 0.0f)).hasIntersected(cylinder, t) || !Math::closeEnough(t, 4.0f))
+            throw std::runtime_error("DoCylinderTest() : Test 4 Part A failed");
+
+        if (!Ray(Vector3(0.5f, 10.0f, 0.0f), Vector3(0.0f, -1.0f, 0.0f)).hasIntersected(cylinder, t) || !Math::closeEnough(t, 6.0f))
+            throw std::runtime_error("DoCylinderTest() : Test 4 Part B failed");
+
+        if (Ray(Vector3(1.1f, 10.0f, 0.0f), Vector3(0.0f, -1.0f, 0.0f)).hasIntersected(cylinder)
+            || Ray(Vector3(5.0f, 4.1f, 0.0f), Vector3(-1.0f, 0.0f, 0.0f)).hasIntersected(cylinder))
+            throw std::runtime_error("DoCylinderTest() : Test 4 Part C failed");
+
+        if (!Ray(Vector3(0.0f, 2.0f, 0.0f), Vector3(0.0f, 0.0f, 1.0f)).hasIntersected(cylinder, t) || t != 0.0f)
+            throw std::runtime_error("DoCylinderTest() : Test 4 Part D failed");
+
+        // Random rays: the hit is the first point inside found by marching
+        // along the ray.
+        for (int i = 0; i < 500; ++i)
+        {
+            Vector3 origin = Vector3(0.0f, 2.0f, 0.0f) + rng.inSphere(6.0f);
+            Vector3 direction = rng.inSphere(1.0f);
+
+            direction.normalize();
+
+            float first = -1.0f;
+
+            for (int j = 0; j < 1200 && first < 0.0f; ++j)
+            {
+                if (cylinder.pointInCylinder(origin + direction * (j * 0.01f)))
+                    first = j * 0.01f;
+            }
+
+            bool hit = Ray(origin, direction).hasIntersected(cylinder, t);
+
+            if (first >= 0.0f && (!hit || t > first + 1e-3f || t < first - 0.011f))
+                throw std::runtime_error("DoCylinderTest() : Test 4 Part E failed");
+
+            if (hit && first < 0.0f && !cylinder.pointInCylinder(origin + direction * (t + 1e-3f))
+                && !cylinder.pointInCylinder(origin + direction * t))
+            {
+                // A graze between two samples; the point hit is still on
+                // the surface.
+                Vector3 point(origin + direction * t);
+                float radial = sqrtf(point.x * point.x + point.z * point.z);
+
+                if (radial > 1.001f || point.y < -1e-3f || point.y > 4.001f)
+                    throw std::runtime_error("DoCylinderTest() : Test 4 Part F failed");
+            }
+        }
+    }
+
+    // Test 5: Cylinder vs frustum. Each point of the cylinder inside the
+    // frustum means the cylinder is.
+    {
+        Frustum frustum(Matrix4::IDENTITY, Matrix4::createPerspective(60.0f, 1.0f, 0.5f, 50.0f));
+
+        if (!frustum.cylinderInFrustum(Cylinder(Vector3(0.0f, 0.0f, -10.0f), Vector3(0.0f, 1.0f, -10.0f), 1.0f))
+            || frustum.cylinderInFrustum(Cylinder(Vector3(0.0f, 0.0f, 10.0f), Vector3(0.0f, 1.0f, 10.0f), 1.0f)))
+            throw std::runtime_error("DoCylinderTest() : Test 5 Part A failed");
+
+        for (int i = 0; i < 500; ++i)
+        {
+            Vector3 a = Vector3(0.0f, 0.0f, -25.0f) + rng.inSphere(30.0f);
+            Cylinder c(a, a + rng.inSphere(10.0f), rng.nextFloat(0.1f, 5.0f));
+            bool inside = frustum.cylinderInFrustum(c);
+
+            for (int j = 0; j < 200 && inside == false; ++j)
+            {
+                Vector3 point(c.a + (c.b - c.a) * rng.nextFloat() + rng.inSphere(c.radius));
+
+                if (c.pointInCylinder(point) && frustum.pointInFrustum(point))
+                    throw std::runtime_error("DoCylinderTest() : Test 5 Part B failed");
+            }
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Unit test the Sweep class. Known cases are checked exactly, and random
+// sweeps against the first time at which the shapes overlap, found by
+// sampling the step finely with distances computed without the class.
+//-----------------------------------------------------------------------------
+
+// The distance from 'point' to a triangle, from the plane of the triangle
+// when the point is above it and from the nearest edge otherwise.
+static float triangleDistance(const Vector3 &point, const Vector3 *triangle)
+{
+    Vector3 normal = Vector3::cross(triangle[1] - triangle[0], triangle[2] - triangle[0]);
+    bool above = true;
+
+    for (int i = 0; i < 3; ++i)
+    {
+        const Vector3 &a = triangle[i];
+        const Vector3 &b = triangle[(i + 1) % 3];
+
+        if (Vector3::dot(Vector3::cross(b - a, point - a), normal) < 0.0f)
+            above = false;
+    }
+
+    if (above)
+        return fabsf(Vector3::dot(point - triangle[0], normal)) / normal.magnitude();
+
+    float best = 1e30f;
+
+    for (int i = 0; i < 3; ++i)
+    {
+        float s, t;
+
+        best = std::min(best, Capsule::closestPoints(point, point, triangle[i], triangle[(i + 1) % 3], s, t));
+    }
+
+    return sqrtf(best);
+}
+
+// How far apart two boxes are along the axis that separates them most;
+// 0 or less when they overlap.
+static float boxGap(const BoundingBox &box, const BoundingBox &other)
+{
+    float gap = -1e30f;
+
+    for (int i = 0; i < 3; ++i)
+    {
+        gap = std::max(gap, (&other.min.x)[i] - (&box.max.x)[i]);
+        gap = std::max(gap, (&box.min.x)[i] - (&other.max.x)[i]);
+    }
+
+    return gap;
+}
+
+// Checks a sweep against 'clearance', the distance between the shapes at
+// time t (0 or less once they touch), sampled over the step. Sweeps that
+// come within 'graze' of just touching the other shape are skipped, and
+// the time may be up to 'early' before the first sample of overlap.
+template <typename Clearance>
+static bool sweepMatches(Clearance clearance, bool hit, float t, float graze, float early)
+{
+    const int steps = 2000;
+    float nearest = 1e30f;
+    int first = -1;
+
+    for (int j = 0; j <= steps; ++j)
+    {
+        float c = clearance(j / float(steps));
+
+        nearest = std::min(nearest, c);
+
+        if (first < 0 && c <= 0.0f)
+            first = j;
+    }
+
+    if (nearest > graze)
+        return !hit;
+
+    if (nearest > -graze)
+        return true;
+
+    float time = first / float(steps);
+    return hit && t <= time + 1e-4f && t >= time - 1.0f / steps - early;
+}
+
+void DoSweepTest()
+{
+    Random rng(50);
+    const BoundingBox box(Vector3(-1.0f, -1.0f, -1.0f), Vector3(1.0f, 1.0f, 1.0f));
+    const Vector3 triangle[3] = { Vector3(-1.0f, 0.0f, -1.0f), Vector3(1.0f, 0.0f, -1.0f), Vector3(0.0f, 0.0f, 1.0f) };
+
+    // Test 1: Known sweeps against spheres, planes and boxes.
+    {
+        float t = -1.0f;
+        Vector3 normal;
+
+        if (!Sweep::timeOfImpact(BoundingSphere(Vector3(-5.0f, 0.0f, 0.0f), 1.0f), Vector3(10.0f, 0.0f, 0.0f),
+                BoundingSphere(Vector3(0.0f, 0.0f, 0.0f), 1.0f), t, normal)
+            || !Math::closeEnough(t, 0.3f) || !Math::closeEnough(normal.x, -1.0f))
+            throw std::runtime_error("DoSweepTest() : Test 1 Part A failed");
+
+        if (!Sweep::timeOfImpact(BoundingSphere(Vector3(0.0f, 5.0f, 0.0f), 1.0f), Vector3(0.0f, -8.0f, 0.0f),
+                Plane(0.0f, 1.0f, 0.0f, 0.0f), t, normal)
+            || !Math::closeEnough(t, 0.5f) || !Math::closeEnough(normal.y, 1.0f))
+            throw std::runtime_error("DoSweepTest() : Test 1 Part B failed");
+
+        if (!Sweep::timeOfImpact(BoundingSphere(Vector3(-5.0f, 0.0f, 0.0f), 1.0f), Vector3(8.0f, 0.0f, 0.0f), box, t, normal)
+            || !Math::closeEnough(t, 0.375f) || !Math::closeEnough(normal.x, -1.0f))
+            throw std::runtime_error("DoSweepTest() : Test 1 Part C failed");
+
+        // Towards the edge of the box, which is reached later than the
+        // corner of the box grown by the radius.
+        if (!Sweep::timeOfImpact(BoundingSphere(Vector3(-3.0f, -3.0f, 0.0f), 1.0f), Vector3(4.0f, 4.0f, 0.0f), box, t, normal)
+            || !Math::closeEnough(t, (2.0f - 1.0f / sqrtf(2.0f)) / 4.0f)
+            || !Math::closeEnough(normal.x, -1.0f / sqrtf(2.0f)) || !Math::closeEnough(normal.y, -1.0f / sqrtf(2.0f)))
+            throw std::runtime_error("DoSweepTest() : Test 1 Part D failed");
+
+        if (!Sweep::timeOfImpact(BoundingBox(Vector3(-5.0f, -1.0f, -1.0f), Vector3(-3.0f, 1.0f, 1.0f)), Vector3(4.0f, 0.5f, 0.0f),
+                box, t, normal)
+            || !Math::closeEnough(t, 0.5f) || !Math::closeEnough(normal.x, -1.0f))
+            throw std::runtime_error("DoSweepTest() : Test 1 Part E failed");
+
+        // Both sides of the triangle.
+        if (!Sweep::timeOfImpact(BoundingSphere(Vector3(0.0f, 3.0f, 0.0f), 1.0f), Vector3(0.0f, -4.0f, 0.0f), triangle, t, normal)
+            || !Math::closeEnough(t, 0.5f) || !Math::closeEnough(normal.y, 1.0f))
+            throw std::runtime_error("DoSweepTest() : Test 1 Part F failed");
+
+        if (!Sweep::timeOfImpact(BoundingSphere(Vector3(0.0f, -3.0f, 0.0f), 1.0f), Vector3(0.0f, 4.0f, 0.0f), triangle, t, normal)
+            || !Math::closeEnough(t, 0.5f) || !Math::closeEnough(normal.y, -1.0f))
+            throw std::runtime_error("DoSweepTest() : Test 1 Part G failed");
+
+        Capsule capsule(Vector3(-5.0f, 0.0f, 0.0f), Vector3(-5.0f, 2.0f, 0.0f), 0.5f);
+
+        if (!Sweep::timeOfImpact(capsule, Vector3(8.0f, 0.0f, 0.0f), Capsule(Vector3(0.0f, -1.0f, 0.0f), Vector3(0.0f, 1.0f, 0.0f), 0.5f), t, normal)
+            || t > 0.5f || t < 0.499f || !Math::closeEnough(normal.x, -1.0f))
+            throw std::runtime_error("DoSweepTest() : Test 1 Part H failed");
+    }
+
+    // Test 2: Misses leave the outputs unchanged, and shapes that start
+    // overlapping hit at time 0.
+    {
+        float t = -1.0f;
+        Vector3 normal(2.0f, 2.0f, 2.0f);
+
+        if (Sweep::timeOfImpact(BoundingSphere(Vector3(0.0f, 5.0f, 0.0f), 1.0f), Vector3(0.0f, 8.0f, 0.0f), Plane(0.0f, 1.0f, 0.0f, 0.0f), t, normal)
+            || Sweep::timeOfImpact(BoundingSphere(Vector3(-5.0f, 0.0f, 0.0f), 1.0f), Vector3(2.5f, 0.0f, 0.0f), box, t, normal)
+            || Sweep::timeOfImpact(BoundingSphere(Vector3(-5.0f, 3.0f, 0.0f), 1.0f), Vector3(10.0f, 0.0f, 0.0f), box, t, normal)
+            || Sweep::timeOfImpact(BoundingBox(Vector3(-5.0f, 2.0f, -1.0f), Vector3(-3.0f, 3.0f, 1.0f)), Vector3(10.0f, 0.0f, 0.0f), box, t, normal)
+            || Sweep::timeOfImpact(BoundingSphere(Vector3(3.0f, 0.5f, 0.0f), 0.4f), Vector3(0.0f, 0.0f, 5.0f), triangle, t, normal)
+            || t != -1.0f || normal.x != 2.0f)
+            throw std::runtime_error("DoSweepTest() : Test 2 Part A failed");
+
+        if (!Sweep::timeOfImpact(BoundingSphere(Vector3(1.5f, 0.0f, 0.0f), 1.0f), Vector3(5.0f, 0.0f, 0.0f), box, t, normal)
+            || t != 0.0f || !Math::closeEnough(normal.x, 1.0f))
+            throw std::runtime_error("DoSweepTest() : Test 2 Part B failed");
+
+        if (!Sweep::timeOfImpact(BoundingSphere(Vector3(0.0f, 0.5f, 0.0f), 1.0f), Vector3(5.0f, 5.0f, 0.0f), triangle, t, normal)
+            || t != 0.0f || !Math::closeEnough(normal.y, 1.0f))
+            throw std::runtime_error("DoSweepTest() : Test 2 Part C failed");
+    }
+
+    // Test 3: Random sweeps aimed near the other shape, against the first
+    // sampled time of overlap. The normals must be unit length and face
+    // the moving shape's approach.
+    {
+        for (int i = 0; i < 300; ++i)
+        {
+            BoundingSphere sphere(rng.inSphere(6.0f), rng.nextFloat(0.1f, 1.0f));
+            Vector3 velocity = (rng.inSphere(2.0f) - sphere.center) * rng.nextFloat(0.5f, 1.5f);
+            Vector3 tri[3] = { rng.inSphere(2.0f), rng.inSphere(2.0f), rng.inSphere(2.0f) };
+            BoundingBox moving(sphere.center - Vector3(0.5f, 0.3f, 0.8f), sphere.center + Vector3(0.4f, 0.9f, 0.2f));
+            Capsule capsule(sphere.center, sphere.center + rng.inSphere(1.5f), sphere.radius);
+            Capsule other(rng.inSphere(1.5f), rng.inSphere(1.5f), 0.5f);
+            float t = -1.0f;
+            Vector3 normal;
+
+            bool hit = Sweep::timeOfImpact(sphere, velocity, box, t, normal);
+
+            if (!sweepMatches([&](float time) { return sqrtf(boxDistanceSq(sphere.center + velocity * time, box)) - sphere.radius; }, hit, t, 2e-3f, 0.0f)
+                || (hit && (!Math::closeEnough(normal.magnitude(), 1.0f) || (t > 0.0f && Vector3::dot(normal, velocity) > 1e-3f))))
+                throw std::runtime_error("DoSweepTest() : Test 3 Part A failed");
+
+            hit = Sweep::timeOfImpact(sphere, velocity, tri, t, normal);
+
+            if (!sweepMatches([&](float time) { return triangleDistance(sphere.center + velocity * time, tri) - sphere.radius; }, hit, t, 2e-3f, 0.0f)
+                || (hit && (!Math::closeEnough(normal.magnitude(), 1.0f) || (t > 0.0f && Vector3::dot(normal, velocity) > 1e-3f))))
+                throw std::runtime_error("DoSweepTest() : Test 3 Part B failed");
+
+            hit = Sweep::timeOfImpact(moving, velocity, box, t, normal);
+
+            if (!sweepMatches([&](float time) { return boxGap(BoundingBox(moving.min + velocity * time, moving.max + velocity * time), box); }, hit, t, 2e-3f, 0.0f)
+                || (hit && (!Math::closeEnough(normal.magnitude(), 1.0f) || (t > 0.0f && Vector3::dot(normal, velocity) > 1e-3f))))
+                throw std::runtime_error("DoSweepTest() : Test 3 Part C failed");
+
+            // Conservative advancement stops within its tolerance of the
+            // contact, so it may be slightly early, and on sweeps that
+            // barely overlap the other capsule that can be well before the
+            // first sampled overlap.
+            hit = Sweep::timeOfImpact(capsule, velocity, other, t, normal);
+
+            auto capsuleClearance = [&](float time)
+            {
+                float s, u;
+                Vector3 offset = velocity * time;
+
+                return sqrtf(Capsule::closestPoints(capsule.a + offset, capsule.b + offset, other.a, other.b, s, u)) - capsule.radius - other.radius;
+            };
+
+            if (!sweepMatches(capsuleClearance, hit, t, 5e-3f, 1e-3f) || (hit && !Math::closeEnough(normal.magnitude(), 1.0f)))
+                throw std::runtime_error("DoSweepTest() : Test 3 Part D failed");
+        }
+    }
+
+    // Test 4: advance() on a caller's distance function, for two spheres,
+    // against the exact time of impact.
+    {
+        for (int i = 0; i < 100; ++i)
+        {
+            BoundingSphere sphere(rng.inSphere(6.0f), rng.nextFloat(0.1f, 1.0f));
+            BoundingSphere other(rng.inSphere(1.0f), rng.nextFloat(0.1f, 1.0f));
+            Vector3 velocity = (rng.inSphere(1.0f) - sphere.center) * rng.nextFloat(0.5f, 1.5f);
+            float exact = -1.0f, t = -1.0f;
+            Vector3 exactNormal, normal;
+
+            Sweep::DistanceFunction distance = [&](float time, Vector3 &n)
+            {
+                n = sphere.center + velocity * time - other.center;
+
+                float length = n.magnitude();
+
+                n.normalize();
+                return length - sphere.radius - other.radius;
+            };
+
+            bool expected = Sweep::timeOfImpact(sphere, velocity, other, exact, exactNormal);
+            bool hit = Sweep::advance(distance, velocity.magnitude(), 1e-5f, t, normal);
+
+            if (expected != hit || (hit && (t > exact + 1e-5f || t < exact - 1e-3f || Vector3::dot(normal, exactNormal) < 0.999f)))
+                throw std::runtime_error("DoSweepTest() : Test 4 failed");
+        }
+    }
+
+    // Test 5: Capsules that pass each other with a small gap miss, and ones
+    // that just overlap hit. Both take more than MAX_ADVANCE_STEPS steps of
+    // conservative advancement.
+    {
+        Capsule other(Vector3(0.0f, -1.0f, 0.0f), Vector3(0.0f, 1.0f, 0.0f), 0.5f);
+        float gaps[3] = { 2e-3f, 1e-2f, 5e-2f };
+
+        for (int i = 0; i < 3; ++i)
+        {
+            Capsule capsule(Vector3(-5.0f, 0.0f, 1.0f + gaps[i]), Vector3(-5.0f, 2.0f, 1.0f + gaps[i]), 0.5f);
+            float t = -1.0f;
+            Vector3 normal;
+
+            if (Sweep::timeOfImpact(capsule, Vector3(10.0f, 0.0f, 0.0f), other, t, normal) || t != -1.0f)
+                throw std::runtime_error("DoSweepTest() : Test 5 Part A failed");
+
+            // The same gap closed to an overlap: the capsules first touch
+            // where sqrt(x^2 + z^2) = 1.
+            float z = 1.0f - gaps[i];
+            float exact = (5.0f - sqrtf(1.0f - z * z)) / 10.0f;
+
+            capsule = Capsule(Vector3(-5.0f, 0.0f, z), Vector3(-5.0f, 2.0f, z), 0.5f);
+
+            if (!Sweep::timeOfImpact(capsule, Vector3(10.0f, 0.0f, 0.0f), other, t, normal)
+                || t > exact + 1e-5f || t < exact - 2e-3f || !Math::closeEnough(normal.magnitude(), 1.0f))
+                throw std::runtime_error("DoSweepTest() : Test 5 Part B failed");
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Unit test the CollisionStats class. The counts are only checked when the
+// library was built with MATHLIB_COLLISION_STATS defined.
+//-----------------------------------------------------------------------------
+
+void DoCollisionStatsTest()
+{
+    // A cube shaped frustum: the planes face inwards at distance 1 from the
+    // origin, in the order -x, +x, -y, +y, -z, +z.
+    Frustum frustum;
+
+    frustum.planes[0].set(1.0f, 0.0f, 0.0f, 1.0f);
+    frustum.planes[1].set(-1.0f, 0.0f, 0.0f, 1.0f);
+    frustum.planes[2].set(0.0f, 1.0f, 0.0f, 1.0f);
+    frustum.planes[3].set(0.0f, -1.0f, 0.0f, 1.0f);
+    frustum.planes[4].set(0.0f, 0.0f, 1.0f, 1.0f);
+    frustum.planes[5].set(0.0f, 0.0f, -1.0f, 1.0f);
+
+    CollisionStats::reset();
+
+    // Test 1: Disabled instrumentation reports nothing.
+    if (!CollisionStats::enabled())
+    {
+        frustum.pointInFrustum(Vector3(0.0f, 5.0f, 0.0f));
+
+        CollisionStats stats = CollisionStats::snapshot();
+
+        if (stats.calls[CollisionStats::QUERY_FRUSTUM_POINT] != 0 || stats.planeRejections[3] != 0)
+            throw std::runtime_error("DoCollisionStatsTest() : Test 1 failed");
+
+        return;
+    }
+
+    // Test 2: Calls and rejecting planes are counted.
+    {
+        for (int i = 0; i < 1000; ++i)
+        {
+            frustum.pointInFrustum(Vector3(0.0f, 5.0f, 0.0f));
+            frustum.sphereInFrustum(BoundingSphere(Vector3(0.0f, 0.0f, -5.0f), 1.0f));
+        }
+
+        frustum.boxInFrustum(BoundingBox(Vector3(-0.5f, -0.5f, -0.5f), Vector3(0.5f, 0.5f, 0.5f)));
+
+        CollisionStats stats = CollisionStats::snapshot();
+
+        if (stats.calls[CollisionStats::QUERY_FRUSTUM_POINT] != 1000
+            || stats.calls[CollisionStats::QUERY_FRUSTUM_SPHERE] != 1000
+            || stats.calls[CollisionStats::QUERY_FRUSTUM_BOX] != 1)
+            throw std::runtime_error("DoCollisionStatsTest() : Test 2 Part A failed");
+
+        if (stats.planeRejections[3] != 1000 || stats.planeRejections[4] != 1000
+            || stats.planeRejections[0] != 0)
+            throw std::runtime_error("DoCollisionStatsTest() : Test 2 Part B failed");
+
+        if (stats.nanoseconds[CollisionStats::QUERY_FRUSTUM_POINT] == 0)
+            throw std::runtime_error("DoCollisionStatsTest() : Test 2 Part C failed");
+    }
+
+    // Test 3: Ray vs box octants. Nested queries are counted too.
+    {
+        BoundingVolume volume;
+        Ray ray(Vector3(-5.0f, 5.0f, -5.0f), Vector3(1.0f, -1.0f, 1.0f));
+
+        volume.box = BoundingBox(Vector3(-1.0f, -1.0f, -1.0f), Vector3(1.0f, 1.0f, 1.0f));
+        volume.sphere = BoundingSphere(Vector3(0.0f, 0.0f, 0.0f), 2.0f);
+
+        CollisionStats::reset();
+        ray.hasIntersected(volume);
+
+        CollisionStats stats = CollisionStats::snapshot();
+
+        // Case PMP: +x, -y, +z.
+        if (stats.rayBoxOctants[5] != 1 || stats.calls[CollisionStats::QUERY_RAY_VOLUME] != 1
+            || stats.calls[CollisionStats::QUERY_RAY_SPHERE] != 1
+            || stats.calls[CollisionStats::QUERY_RAY_BOX] != 1)
+            throw std::runtime_error("DoCollisionStatsTest() : Test 3 failed");
+    }
+
+    // Test 4: Counts from other threads are included, even after the
+    // thread has exited.
+    {
+        CollisionStats::reset();
+
+        std::thread worker([&frustum]()
+        {
+            for (int i = 0; i < 100; ++i)
+                frustum.pointInFrustum(Vector3(0.0f, 0.0f, 0.0f));
+        });
+
+        worker.join();
+        frustum.pointInFrustum(Vector3(0.0f, 0.0f, 0.0f));
+
+        CollisionStats stats = CollisionStats::snapshot();
+
+        if (stats.calls[CollisionStats::QUERY_FRUSTUM_POINT] != 101)
+            throw std::runtime_error("DoCollisionStatsTest() : Test 4 failed");
+    }
+
+    CollisionStats::reset();
 }
\ No newline at end of file
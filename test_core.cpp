@@ -20,10 +20,14 @@
 // IN THE SOFTWARE.
 //-----------------------------------------------------------------------------
 
+#include <limits>
+#include <vector>
+
 #include "test_main.h"
 
 void TestMathCore();
 void DoCommonTest();
+void DoFastMathTest();
 void DoVector2Test();
 void DoVector3Test();
 void DoVector4Test();
@@ -31,6 +35,10 @@ void DoMatrix3Test();
 void DoMatrix4Test();
 void DoQuaternionTest();
 void DoMatrixStackTest();
+void DoInlineMatrixStackTest();
+void DoRandomTest();
+void DoDoublePrecisionTest();
+void DoConstexprTest();
 
 //-----------------------------------------------------------------------------
 // Tests all of the core math classes.
@@ -39,6 +47,7 @@ void DoMatrixStackTest();
 void TestMathCore()
 {
     DoCommonTest();
+    DoFastMathTest();
     DoVector2Test();
     DoVector3Test();
     DoVector4Test();
@@ -46,6 +55,10 @@ void TestMathCore()
     DoMatrix4Test();
     DoQuaternionTest();
 	DoMatrixStackTest();
+    DoInlineMatrixStackTest();
+    DoRandomTest();
+    DoDoublePrecisionTest();
+    DoConstexprTest();
 }
 
 //-----------------------------------------------------------------------------
@@ -134,6 +147,183 @@ void DoCommonTest()
     }
 }
 
+//-----------------------------------------------------------------------------
+// Test the fast math approximations against their documented error bounds.
+// Both the scalar forms and the (SIMD) array forms are checked. The
+// reference results are computed in double precision.
+//-----------------------------------------------------------------------------
+
+void DoFastMathTest()
+{
+    const unsigned int samples = 1 << 20;
+    std::vector<float> x(samples), y(samples), r1(samples), r2(samples);
+
+    // Test 1: fastSin(), fastCos() and fastSinCos() for |x| <= 8192.
+    {
+        for (unsigned int i = 0; i < samples; ++i)
+            x[i] = -8192.0f + 16384.0f * (static_cast<float>(i) / static_cast<float>(samples - 1));
+
+        Math::fastSinCos(&x[0], &r1[0], &r2[0], samples);
+
+        for (unsigned int i = 0; i < samples; ++i)
+        {
+            double s = sin(static_cast<double>(x[i]));
+            double c = cos(static_cast<double>(x[i]));
+
+            if (fabs(r1[i] - s) > 1e-7 || fabs(r2[i] - c) > 1e-7)
+                throw std::runtime_error("DoFastMathTest() : Test 1 Part A failed");
+
+            if (fabs(Math::fastSin(x[i]) - s) > 1e-7 || fabs(Math::fastCos(x[i]) - c) > 1e-7)
+                throw std::runtime_error("DoFastMathTest() : Test 1 Part B failed");
+        }
+
+        Math::fastSin(&x[0], &r1[0], samples);
+        Math::fastCos(&x[0], &r2[0], samples);
+
+        for (unsigned int i = 0; i < samples; ++i)
+        {
+            if (fabs(r1[i] - sin(static_cast<double>(x[i]))) > 1e-7
+                || fabs(r2[i] - cos(static_cast<double>(x[i]))) > 1e-7)
+                throw std::runtime_error("DoFastMathTest() : Test 1 Part C failed");
+        }
+
+        // The ends of the range, and values beyond it, which are passed to
+        // sinf() and cosf(). The last three are in the remainder of the
+        // SIMD loop.
+        static const float ends[] =
+        {
+            8192.0f, -8192.0f, 8192.001f, -8192.001f, 1.0e5f, 3.5e9f, -3.5e9f,
+            1.0e30f, -1.0e38f, 3.402823466e+38f, -3.402823466e+38f
+        };
+
+        const unsigned int count = sizeof(ends) / sizeof(ends[0]);
+
+        Math::fastSinCos(ends, &r1[0], &r2[0], count);
+
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            double s = sin(static_cast<double>(ends[i]));
+            double c = cos(static_cast<double>(ends[i]));
+
+            if (fabs(r1[i] - s) > 1e-7 || fabs(r2[i] - c) > 1e-7)
+                throw std::runtime_error("DoFastMathTest() : Test 1 Part D failed");
+
+            if (fabs(Math::fastSin(ends[i]) - s) > 1e-7 || fabs(Math::fastCos(ends[i]) - c) > 1e-7)
+                throw std::runtime_error("DoFastMathTest() : Test 1 Part E failed");
+        }
+
+        // Infinities and NaNs give NaNs, as from sinf() and cosf().
+        x[0] = std::numeric_limits<float>::infinity();
+        x[1] = -x[0];
+        x[2] = std::numeric_limits<float>::quiet_NaN();
+        x[3] = 0.5f;
+        Math::fastSinCos(&x[0], &r1[0], &r2[0], 4);
+
+        for (unsigned int i = 0; i < 3; ++i)
+        {
+            if (r1[i] == r1[i] || r2[i] == r2[i])
+                throw std::runtime_error("DoFastMathTest() : Test 1 Part F failed");
+        }
+
+        if (fabs(r1[3] - sin(0.5)) > 1e-7 || fabs(r2[3] - cos(0.5)) > 1e-7)
+            throw std::runtime_error("DoFastMathTest() : Test 1 Part G failed");
+    }
+
+    // Test 2: fastAcos() for x in [-1,1].
+    {
+        for (unsigned int i = 0; i < samples; ++i)
+            x[i] = -1.0f + 2.0f * (static_cast<float>(i) / static_cast<float>(samples - 1));
+
+        Math::fastAcos(&x[0], &r1[0], samples);
+
+        for (unsigned int i = 0; i < samples; ++i)
+        {
+            double ref = acos(static_cast<double>(x[i]));
+
+            if (fabs(r1[i] - ref) > 3e-7 || fabs(Math::fastAcos(x[i]) - ref) > 3e-7)
+                throw std::runtime_error("DoFastMathTest() : Test 2 failed");
+        }
+    }
+
+    // Test 3: fastAtan2() around the circle at radii from 1e-6 to 1e6.
+    {
+        for (unsigned int i = 0; i < samples; ++i)
+        {
+            double angle = -3.14159265358979 + 6.28318530717958 * (static_cast<double>(i) / samples);
+            double radius = pow(10.0, static_cast<double>(i % 13) - 6.0);
+
+            y[i] = static_cast<float>(radius * sin(angle));
+            x[i] = static_cast<float>(radius * cos(angle));
+        }
+
+        Math::fastAtan2(&y[0], &x[0], &r1[0], samples);
+
+        for (unsigned int i = 0; i < samples; ++i)
+        {
+            double ref = atan2(static_cast<double>(y[i]), static_cast<double>(x[i]));
+
+            if (fabs(r1[i] - ref) > 3e-7 || fabs(Math::fastAtan2(y[i], x[i]) - ref) > 3e-7)
+                throw std::runtime_error("DoFastMathTest() : Test 3 failed");
+        }
+
+        if (Math::fastAtan2(0.0f, 0.0f) != 0.0f)
+            throw std::runtime_error("DoFastMathTest() : Test 3 Part B failed");
+    }
+
+    // Test 4: fastExp() for x in [-87.3,88].
+    {
+        for (unsigned int i = 0; i < samples; ++i)
+            x[i] = -87.3f + 175.3f * (static_cast<float>(i) / static_cast<float>(samples - 1));
+
+        Math::fastExp(&x[0], &r1[0], samples);
+
+        for (unsigned int i = 0; i < samples; ++i)
+        {
+            double ref = exp(static_cast<double>(x[i]));
+
+            if (fabs(r1[i] - ref) > 1e-7 * ref || fabs(Math::fastExp(x[i]) - ref) > 1e-7 * ref)
+                throw std::runtime_error("DoFastMathTest() : Test 4 failed");
+        }
+    }
+
+    // Test 5: fastLog() and fastRsqrt() over all positive finite numbers.
+    // The ends of the normal range and of the denormal range come first,
+    // and the rest of the bit patterns are sampled with an odd stride so
+    // that every exponent and a spread of mantissas are covered.
+    {
+        static const unsigned int edges[] =
+        {
+            0x00000001, 0x00000002, 0x00000003, 0x000fffff, 0x00400000, 0x007fffff,
+            0x00800000, 0x00800001, 0x00ffffff, 0x7f000000, 0x7f7ffffe, 0x7f7fffff
+        };
+
+        unsigned int count = 0;
+
+        for (unsigned int i = 0; i < sizeof(edges) / sizeof(edges[0]); ++i)
+            memcpy(&x[count++], &edges[i], sizeof(float));
+
+        for (unsigned int bits = 1; bits < 0x7f800000 && count < samples; bits += 2053)
+            memcpy(&x[count++], &bits, sizeof(float));
+
+        Math::fastLog(&x[0], &r1[0], count);
+        Math::fastRsqrt(&x[0], &r2[0], count);
+
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            double ref = log(static_cast<double>(x[i]));
+            double tolerance = 1e-7 * ((fabs(ref) > 1.0) ? fabs(ref) : 1.0);
+
+            if (fabs(r1[i] - ref) > tolerance || fabs(Math::fastLog(x[i]) - ref) > tolerance)
+                throw std::runtime_error("DoFastMathTest() : Test 5 Part A failed");
+
+            ref = 1.0 / sqrt(static_cast<double>(x[i]));
+
+            if (fabs(r2[i] - ref) > 3e-7 * ref || fabs(Math::fastRsqrt(x[i]) - ref) > 3e-7 * ref)
+                throw std::runtime_error("DoFastMathTest() : Test 5 Part B failed");
+        }
+    }
+}
+
 //-----------------------------------------------------------------------------
 // Unit test the Vector2 class. This is not an exhaustive test of the
 // Vector2 class. However it will test most of the important functions.
@@ -1027,6 +1217,75 @@ void DoMatrix4Test()
         if (m * m.inverse() != Matrix4::IDENTITY)
             throw std::runtime_error("DoMatrix4Test() : Test 13 failed");
     }
+
+    // Test 14: Rigid body matrix inverse.
+    {
+        Matrix4 m;
+        m.fromHeadPitchRoll(10.0f, 20.0f, 30.0f);
+        m[3][0] = 1.0f, m[3][1] = -2.0f, m[3][2] = 3.0f;
+
+        if (m.inverseRigid() != m.inverse())
+            throw std::runtime_error("DoMatrix4Test() : Test 14 failed");
+    }
+
+    // Test 15: Affine matrix inverse.
+    {
+        Matrix4 m = Matrix4::createScale(2.0f, 3.0f, 4.0f)
+            * Matrix4::createRotate(Vector3(0.0f, 1.0f, 0.0f), 30.0f)
+            * Matrix4::createTranslate(5.0f, 6.0f, 7.0f);
+        Matrix4 result;
+
+        // Case 1: Invertible matrix.
+        if (!m.inverseAffine(result) || m * result != Matrix4::IDENTITY)
+            throw std::runtime_error("DoMatrix4Test() : Test 15 Case 1 failed");
+
+        // Case 2: Singular matrix is reported and 'result' is untouched.
+        result = Matrix4::IDENTITY;
+
+        if (Matrix4::createScale(1.0f, 0.0f, 1.0f).inverseAffine(result) || result != Matrix4::IDENTITY)
+            throw std::runtime_error("DoMatrix4Test() : Test 15 Case 2 failed");
+    }
+
+    // Test 16: General matrix inverse.
+    {
+        Matrix4 m(
+            2.0f, 1.0f, 0.0f, 3.0f,
+            0.0f, 1.0f, 4.0f, 1.0f,
+            1.0f, 0.0f, 2.0f, 0.0f,
+            3.0f, 1.0f, 1.0f, 2.0f);
+        Matrix4 result;
+
+        // Case 1: Invertible projective matrix.
+        if (!m.inverseGeneral(result) || result != m.inverse())
+            throw std::runtime_error("DoMatrix4Test() : Test 16 Case 1 failed");
+
+        // Case 2: Singular matrix.
+        Matrix4 singular(
+            1.0f, 2.0f, 3.0f, 4.0f,
+            2.0f, 4.0f, 6.0f, 8.0f,
+            1.0f, 0.0f, 1.0f, 0.0f,
+            0.0f, 1.0f, 0.0f, 1.0f);
+
+        if (singular.inverseGeneral(result))
+            throw std::runtime_error("DoMatrix4Test() : Test 16 Case 2 failed");
+    }
+
+    // Test 17: Perspective projection. The corners of the view volume map
+    // to the corners of the normalized device cube.
+    {
+        Matrix4 proj = Matrix4::createPerspective(90.0f, 2.0f, 0.5f, 100.0f);
+        const float depths[2] = { 0.5f, 100.0f };
+
+        for (int i = 0; i < 2; ++i)
+        {
+            Vector4 clip = Vector4(2.0f * depths[i], depths[i], -depths[i], 1.0f) * proj;
+            Vector3 ndc(clip.x / clip.w, clip.y / clip.w, clip.z / clip.w);
+            float z = (i == 0) ? -1.0f : 1.0f;
+
+            if (fabsf(clip.w - depths[i]) > 1e-5f || (ndc - Vector3(1.0f, 1.0f, z)).magnitude() > 1e-5f)
+                throw std::runtime_error("DoMatrix4Test() : Test 17 failed");
+        }
+    }
 }
 
 //-----------------------------------------------------------------------------
@@ -1383,4 +1642,433 @@ void DoMatrixStackTest()
 		if (ms.currentMatrix() != m1)
 			throw std::runtime_error("DoMatrixStackTest() : Test 8b failed");
 	}
-}
\ No newline at end of file
+}
+
+//-----------------------------------------------------------------------------
+// Unit test the InlineMatrixStack class template. This is not an exhaustive
+// test of the InlineMatrixStack class template. However it will test most of
+// the important functions.
+//-----------------------------------------------------------------------------
+
+void DoInlineMatrixStackTest()
+{
+    // Test 1: A new stack holds the identity matrix in its inline storage.
+    {
+        InlineMatrixStack<4> ms;
+
+        if (ms.currentMatrix() != Matrix4::IDENTITY || !ms.isInline() || ms.capacity() != 4)
+            throw std::runtime_error("DoInlineMatrixStackTest() : Test 1 failed");
+    }
+
+    // Test 2: Stack underflow error.
+    {
+        InlineMatrixStack<4> ms;
+
+        ms.popMatrix();
+
+        if (ms.lastError() != MatrixStack::ERROR_MATRIX_STACK_UNDERFLOW)
+            throw std::runtime_error("DoInlineMatrixStackTest() : Test 2 failed");
+    }
+
+    // Test 3: Pushing past the inline capacity grows onto the heap.
+    {
+        InlineMatrixStack<4> ms;
+
+        ms.loadMatrix(Matrix4::createTranslate(1.0f, 2.0f, 3.0f));
+
+        for (int i = 0; i < 100; ++i)
+        {
+            ms.pushMatrix();
+            ms.multMatrix(Matrix4::createTranslate(1.0f, 0.0f, 0.0f));
+        }
+
+        // (a) No overflow and the matrices were carried over.
+        if (ms.lastError() != MatrixStack::ERROR_OK || ms.currentDepth() != 100 || ms.isInline())
+            throw std::runtime_error("DoInlineMatrixStackTest() : Test 3a failed");
+
+        if (ms.currentMatrix() != Matrix4::createTranslate(101.0f, 2.0f, 3.0f))
+            throw std::runtime_error("DoInlineMatrixStackTest() : Test 3b failed");
+
+        // (b) Popping restores the earlier matrices.
+        for (int i = 0; i < 100; ++i)
+            ms.popMatrix();
+
+        if (ms.currentMatrix() != Matrix4::createTranslate(1.0f, 2.0f, 3.0f))
+            throw std::runtime_error("DoInlineMatrixStackTest() : Test 3c failed");
+    }
+
+    // Test 4: Growing into an arena, and overflowing when it is exhausted.
+    {
+        MatrixArena arena(8);
+        InlineMatrixStack<2> ms(&arena);
+
+        // (a) Capacity 2 -> 4 comes from the arena.
+        ms.pushMatrix();
+        ms.pushMatrix();
+
+        if (ms.lastError() != MatrixStack::ERROR_OK || ms.capacity() != 4 || arena.used() != 4)
+            throw std::runtime_error("DoInlineMatrixStackTest() : Test 4a failed");
+
+        // (b) Capacity 4 -> 8 doesn't fit in the remaining arena space.
+        ms.pushMatrix();
+        ms.pushMatrix();
+
+        if (ms.lastError() != MatrixStack::ERROR_MATRIX_STACK_OVERFLOW || ms.currentDepth() != 3)
+            throw std::runtime_error("DoInlineMatrixStackTest() : Test 4b failed");
+    }
+
+    // Test 5: Cached inverse and inverse-transpose of the top most matrix.
+    {
+        InlineMatrixStack<4> ms;
+        Matrix4 m = Matrix4::createScale(2.0f, 4.0f, 8.0f) * Matrix4::createTranslate(1.0f, 2.0f, 3.0f);
+
+        ms.loadMatrix(m);
+
+        // (a) Inverse of the top most matrix.
+        if (ms.inverseMatrix() != m.inverse())
+            throw std::runtime_error("DoInlineMatrixStackTest() : Test 5a failed");
+
+        if (ms.inverseTransposeMatrix() != m.inverse().transpose())
+            throw std::runtime_error("DoInlineMatrixStackTest() : Test 5b failed");
+
+        // (b) Changing the top most matrix invalidates the cache.
+        ms.pushMatrix();
+        ms.loadIdentity();
+
+        if (ms.inverseMatrix() != Matrix4::IDENTITY)
+            throw std::runtime_error("DoInlineMatrixStackTest() : Test 5c failed");
+
+        ms.popMatrix();
+
+        if (ms.inverseMatrix() != m.inverse())
+            throw std::runtime_error("DoInlineMatrixStackTest() : Test 5d failed");
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Unit test the Random class.
+//-----------------------------------------------------------------------------
+
+void DoRandomTest()
+{
+    // Test 1: Generators with the same seed produce the same sequence.
+    {
+        Random a(1234), b(1234), c(4321);
+        bool different = false;
+
+        for (int i = 0; i < 100; ++i)
+        {
+            unsigned int x = a.nextUInt();
+
+            if (x != b.nextUInt())
+                throw std::runtime_error("DoRandomTest() : Test 1 Part A failed");
+
+            if (x != c.nextUInt())
+                different = true;
+        }
+
+        if (!different)
+            throw std::runtime_error("DoRandomTest() : Test 1 Part B failed");
+    }
+
+    // Test 2: nextFloat() stays in range [min,max) and is roughly uniform.
+    {
+        Random rng;
+        double sum = 0.0;
+
+        for (int i = 0; i < 100000; ++i)
+        {
+            float f = rng.nextFloat(-2.0f, 6.0f);
+
+            if (f < -2.0f || f >= 6.0f)
+                throw std::runtime_error("DoRandomTest() : Test 2 Part A failed");
+
+            sum += f;
+        }
+
+        if (fabs(sum / 100000.0 - 2.0) > 0.05)
+            throw std::runtime_error("DoRandomTest() : Test 2 Part B failed");
+    }
+
+    // Test 3: fill() is reproducible, stays in range and handles partial
+    // blocks at the end of the buffer.
+    {
+        Random a(99), b(99);
+        std::vector<float> x(1003), y(1003);
+        double sum = 0.0;
+
+        a.fill(&x[0], 1003, 1.0f, 3.0f);
+        b.fill(&y[0], 1003, 1.0f, 3.0f);
+
+        for (size_t i = 0; i < x.size(); ++i)
+        {
+            if (x[i] != y[i] || x[i] < 1.0f || x[i] >= 3.0f)
+                throw std::runtime_error("DoRandomTest() : Test 3 Part A failed");
+
+            sum += x[i];
+        }
+
+        if (fabs(sum / 1003.0 - 2.0) > 0.1)
+            throw std::runtime_error("DoRandomTest() : Test 3 Part B failed");
+
+        // The first values of a fill() don't depend on the buffer length.
+        Random c(99);
+        float first[3];
+
+        c.fill(first, 3, 1.0f, 3.0f);
+
+        if (first[0] != x[0] || first[1] != x[1] || first[2] != x[2])
+            throw std::runtime_error("DoRandomTest() : Test 3 Part C failed");
+    }
+
+    // Test 4: Geometric sampling.
+    {
+        Random rng;
+        Vector3 min(-1.0f, 2.0f, 3.0f), max(1.0f, 4.0f, 7.0f);
+
+        for (int i = 0; i < 1000; ++i)
+        {
+            Vector3 p = rng.inBox(min, max);
+
+            if (p.x < min.x || p.y < min.y || p.z < min.z || p.x >= max.x || p.y >= max.y || p.z >= max.z)
+                throw std::runtime_error("DoRandomTest() : Test 4 Part A failed");
+
+            if (rng.inSphere(5.0f).magnitude() > 5.0f)
+                throw std::runtime_error("DoRandomTest() : Test 4 Part B failed");
+
+            if (fabsf(rng.onSphere(5.0f).magnitude() - 5.0f) > 1e-5f)
+                throw std::runtime_error("DoRandomTest() : Test 4 Part C failed");
+
+            if (fabsf(rng.unitQuaternion().magnitude() - 1.0f) > 1e-5f)
+                throw std::runtime_error("DoRandomTest() : Test 4 Part D failed");
+        }
+    }
+
+    // Test 5: jump() moves to a different part of the sequence.
+    {
+        Random a(7), b(7);
+
+        b.jump();
+
+        if (a.nextUInt() == b.nextUInt() && a.nextUInt() == b.nextUInt())
+            throw std::runtime_error("DoRandomTest() : Test 5 failed");
+    }
+
+    // Test 6: Math::random() stays in range.
+    {
+        for (int i = 0; i < 1000; ++i)
+        {
+            float f = Math::random(10.0f, 20.0f);
+
+            if (f < 10.0f || f >= 20.0f)
+                throw std::runtime_error("DoRandomTest() : Test 6 failed");
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Unit test the double precision versions of the core math classes. Most of
+// their code is shared with the float versions, so this concentrates on the
+// precision itself, the conversions and the double specific code paths.
+//-----------------------------------------------------------------------------
+
+void DoDoublePrecisionTest()
+{
+    // Test 1: Positions far from the origin keep their fractional part.
+    {
+        Vector3d origin(1.0e7, -2.0e7, 3.0e7);
+        Vector3d p = origin + Vector3d(0.25, 0.5, 0.125);
+        Vector3d d = p - origin;
+
+        if (d.x != 0.25 || d.y != 0.5 || d.z != 0.125)
+            throw std::runtime_error("DoDoublePrecisionTest() : Test 1 Part A failed");
+
+        // The camera relative offset converts to float without any loss.
+        Vector3 offset(d);
+
+        if (offset.x != 0.25f || offset.y != 0.5f || offset.z != 0.125f)
+            throw std::runtime_error("DoDoublePrecisionTest() : Test 1 Part B failed");
+    }
+
+    // Test 2: Conversions between float and double.
+    {
+        Vector2 v2(1.5f, -2.0f);
+        Vector4 v4(1.0f, 2.0f, 3.0f, 4.0f);
+        Matrix3 m3 = Matrix3::createRotate(Vector3(0.0f, 1.0f, 0.0f), 30.0f);
+        Matrix4 m4 = Matrix4::createRotate(Vector3(1.0f, 0.0f, 0.0f), 45.0f)
+            * Matrix4::createTranslate(1.0f, 2.0f, 3.0f);
+        Quaternion q(Vector3(0.0f, 0.0f, 1.0f), 60.0f);
+
+        if (Vector2(Vector2d(v2)) != v2 || Vector4(Vector4d(v4)) != v4)
+            throw std::runtime_error("DoDoublePrecisionTest() : Test 2 Part A failed");
+
+        if (Matrix3(Matrix3d(m3)) != m3 || Matrix4(Matrix4d(m4)) != m4)
+            throw std::runtime_error("DoDoublePrecisionTest() : Test 2 Part B failed");
+
+        if (Quaternion(Quaterniond(q)) != q)
+            throw std::runtime_error("DoDoublePrecisionTest() : Test 2 Part C failed");
+    }
+
+    // Test 3: Matrix concatenation and vector transformation agree with the
+    // float versions.
+    {
+        Matrix4 a = Matrix4::createRotate(Vector3(0.0f, 1.0f, 0.0f), 30.0f)
+            * Matrix4::createTranslate(4.0f, -5.0f, 6.0f);
+        Matrix4 b = Matrix4::createScale(2.0f, 3.0f, 4.0f)
+            * Matrix4::createRotate(Vector3(1.0f, 0.0f, 0.0f), -60.0f);
+        Vector4 v(1.0f, -2.0f, 3.0f, 1.0f);
+
+        Matrix4d ad(a), bd(b);
+        Matrix4d product = ad * bd;
+
+        if (Matrix4(product) != a * b)
+            throw std::runtime_error("DoDoublePrecisionTest() : Test 3 Part A failed");
+
+        if (Vector4(Vector4d(v) * ad) != v * a)
+            throw std::runtime_error("DoDoublePrecisionTest() : Test 3 Part B failed");
+
+        ad *= bd;
+
+        if (ad != product)
+            throw std::runtime_error("DoDoublePrecisionTest() : Test 3 Part C failed");
+    }
+
+    // Test 4: Matrix inversion.
+    {
+        Matrix4d m = Matrix4d::createRotate(Vector3d(0.0, 0.0, 1.0), 40.0)
+            * Matrix4d::createTranslate(1.0e6, 2.0e6, -3.0e6);
+        Matrix4d inverse;
+
+        if (!m.inverseGeneral(inverse))
+            throw std::runtime_error("DoDoublePrecisionTest() : Test 4 Part A failed");
+
+        Vector4d p(1.0e6 + 0.5, 2.0e6 - 0.25, -3.0e6, 1.0);
+        Vector4d q = p * m * inverse;
+
+        if (!ScalarMath<double>::closeEnough(q.x, p.x)
+            || !ScalarMath<double>::closeEnough(q.y, p.y)
+            || !ScalarMath<double>::closeEnough(q.z, p.z))
+            throw std::runtime_error("DoDoublePrecisionTest() : Test 4 Part B failed");
+
+        if (inverse != m.inverseRigid())
+            throw std::runtime_error("DoDoublePrecisionTest() : Test 4 Part C failed");
+
+        if (m * Matrix4d::IDENTITY != m)
+            throw std::runtime_error("DoDoublePrecisionTest() : Test 4 Part D failed");
+    }
+
+    // Test 5: Quaternions.
+    {
+        Quaterniond a(Vector3d(0.0, 1.0, 0.0), 0.0);
+        Quaterniond b(Vector3d(0.0, 1.0, 0.0), 90.0);
+        Quaterniond c = Quaterniond::slerp(a, b, 0.5);
+
+        if (c != Quaterniond(Vector3d(0.0, 1.0, 0.0), 45.0))
+            throw std::runtime_error("DoDoublePrecisionTest() : Test 5 Part A failed");
+
+        if (Quaterniond(Vector3d(0.0, 1.0, 0.0), 60.0).toMatrix4() != Matrix4d::createRotate(Vector3d(0.0, 1.0, 0.0), 60.0))
+            throw std::runtime_error("DoDoublePrecisionTest() : Test 5 Part B failed");
+
+        Vector3d axis;
+        double degrees = 0.0;
+
+        b.toAxisAngle(axis, degrees);
+
+        if (axis != Vector3d(0.0, 1.0, 0.0) || !ScalarMath<double>::closeEnough(degrees, 90.0))
+            throw std::runtime_error("DoDoublePrecisionTest() : Test 5 Part C failed");
+    }
+
+    // Test 6: A scalar of another type on the left converts to the scalar
+    // type of the vector or quaternion, as it does on the right.
+    {
+        Vector2 v2(1.0f, -2.0f);
+        Vector3 v3(1.0f, -2.0f, 4.0f);
+        Vector4 v4(1.0f, -2.0f, 4.0f, 8.0f);
+        Vector3d v3d(1.0, -2.0, 4.0);
+        Quaternion q(1.0f, 2.0f, 3.0f, 4.0f);
+
+        if (2 * v2 != v2 * 2.0f || 0.5 * v2 != v2 * 0.5f)
+            throw std::runtime_error("DoDoublePrecisionTest() : Test 6 Part A failed");
+
+        if (2 * v3 != v3 * 2.0f || 0.5 * v3 != v3 * 0.5f || 0.5f * v3d != v3d * 0.5)
+            throw std::runtime_error("DoDoublePrecisionTest() : Test 6 Part B failed");
+
+        if (2 * v4 != v4 * 2.0f || 0.5 * v4 != v4 * 0.5f)
+            throw std::runtime_error("DoDoublePrecisionTest() : Test 6 Part C failed");
+
+        if (2 * q != q * 2.0f || 0.5 * q != q * 0.5f)
+            throw std::runtime_error("DoDoublePrecisionTest() : Test 6 Part D failed");
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Unit test the constexpr parts of the core math classes. The static_asserts
+// fail the build if an expression can no longer be evaluated at compile
+// time. The run time checks make sure the compile time results agree with
+// the results of the non-constexpr code.
+//-----------------------------------------------------------------------------
+
+void DoConstexprTest()
+{
+    // Test 1: Constants and vectors.
+    {
+        constexpr float halfPi = Math::HALF_PI;
+        constexpr Vector3 a(1.0f, 2.0f, 3.0f);
+        constexpr Vector3 b(4.0f, 5.0f, 6.0f);
+        constexpr Vector3 c = Vector3::cross(a, b) + 2.0f * -a;
+        constexpr Vector4 d = Vector4::lerp(Vector4(a, 1.0f), Vector4(b, 1.0f), 0.5f);
+
+        static_assert(halfPi == Math::PI / 2.0f, "HALF_PI");
+        static_assert(Vector3::dot(a, b) == 32.0f, "Vector3::dot");
+        static_assert(c.x == -5.0f && c.y == 2.0f && c.z == -9.0f, "Vector3::cross");
+        static_assert(d.toVector3().y == 3.5f, "Vector4::lerp");
+        static_assert(Vector2(3.0f, 4.0f).magnitudeSq() == 25.0f, "Vector2::magnitudeSq");
+
+        if (Math::degreesToRadians(180.0f) != Math::PI || Vector3::cross(a, b) != Vector3(-3.0f, 6.0f, -3.0f))
+            throw std::runtime_error("DoConstexprTest() : Test 1 failed");
+    }
+
+    // Test 2: Matrices.
+    {
+        constexpr Matrix4 t = Matrix4::createTranslate(1.0f, 2.0f, 3.0f);
+        constexpr Matrix4 s = Matrix4::createScale(2.0f, 2.0f, 2.0f);
+        constexpr Matrix4 m = s * t * Matrix4::IDENTITY;
+        constexpr Vector3 p = Vector3(1.0f, 1.0f, 1.0f) * m;
+        constexpr Matrix4 mt = m.transpose();
+        constexpr Matrix3 r(0.0f, 1.0f, 0.0f,
+                            -1.0f, 0.0f, 0.0f,
+                            0.0f, 0.0f, 1.0f);
+        constexpr Matrix3 rr = r * r.transpose();
+
+        static_assert(m[3][0] == 1.0f && m[0][0] == 2.0f, "Matrix4::operator*");
+        static_assert(p.x == 2.0f && p.y == 2.0f && p.z == 2.0f, "Vector3 * Matrix4");
+        static_assert(mt[0][3] == 1.0f, "Matrix4::transpose");
+        static_assert(m.determinant() == 8.0f, "Matrix4::determinant");
+        static_assert(r.determinant() == 1.0f && rr[1][1] == 1.0f, "Matrix3");
+        static_assert(Matrix3d::IDENTITY[2][2] == 1.0, "Matrix3d::IDENTITY");
+
+        Matrix4 runtime;
+
+        runtime.scale(2.0f, 2.0f, 2.0f);
+        runtime *= Matrix4::createTranslate(1.0f, 2.0f, 3.0f);
+
+        if (runtime != m || Matrix4(Matrix4d(m)) != m)
+            throw std::runtime_error("DoConstexprTest() : Test 2 failed");
+    }
+
+    // Test 3: Quaternions.
+    {
+        constexpr Quaternion a(0.0f, 1.0f, 0.0f, 0.0f);
+        constexpr Quaternion b = a * a.conjugate() + Quaternion::IDENTITY * 0.5f;
+
+        static_assert(b.w == 1.5f && b.x == 0.0f, "Quaternion::operator*");
+
+        Quaternion q(Vector3(0.0f, 1.0f, 0.0f), 30.0f);
+        Quaternion expected = q;
+
+        expected *= Quaternion::IDENTITY;
+
+        if (q * Quaternion::IDENTITY != expected || q * q.conjugate() != Quaternion::IDENTITY)
+            throw std::runtime_error("DoConstexprTest() : Test 3 failed");
+    }
+}
@@ -20,6 +20,8 @@
 // IN THE SOFTWARE.
 //-----------------------------------------------------------------------------
 
+#include <cstring>
+
 #include "test_main.h"
 
 void PrintVector(const char *label, const Vector2 &v);
@@ -36,10 +38,22 @@ void PrintPlanes(const Plane &result, const Plane &expected);
 //-----------------------------------------------------------------------------
 // This application will test the math library.
 // Testing will stop when the first error is encountered.
+//
+// The exit code is 1 if a test failed. Pass --no-pause to exit without
+// waiting for the enter key (e.g., when run by ctest).
 //-----------------------------------------------------------------------------
 
-int main()
+int main(int argc, char *argv[])
 {
+    bool pause = true;
+    int exitCode = 0;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--no-pause") == 0)
+            pause = false;
+    }
+
     std::cout.setf(std::ios_base::fixed, std::ios_base::floatfield);
     std::cout << std::setprecision(12);
 
@@ -47,18 +61,26 @@ int main()
     {
         TestMathCore();
         TestMathCollision();
+        TestMathTransform();
+        TestMathBatch();
+        TestMathOcclusion();
+        TestMathVecExpr();
 
         std::cout << "mathlib: all tests passed" << std::endl;
     }
     catch (std::runtime_error &e)
     {
         std::cout << "mathlib: " << e.what() << std::endl;
+        exitCode = 1;
     }
 
-    std::cout << "Press enter to continue";
-    std::cin.get();
+    if (pause)
+    {
+        std::cout << "Press enter to continue";
+        std::cin.get();
+    }
 
-    return 0;
+    return exitCode;
 }
 
 //-----------------------------------------------------------------------------
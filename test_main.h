@@ -43,5 +43,9 @@ extern void PrintPlanes(const Plane &result, const Plane &expected);
 
 extern void TestMathCore();
 extern void TestMathCollision();
+extern void TestMathTransform();
+extern void TestMathBatch();
+extern void TestMathOcclusion();
+extern void TestMathVecExpr();
 
 #endif
\ No newline at end of file
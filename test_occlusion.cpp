@@ -0,0 +1,919 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2026 dhpoware. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include <cfloat>
+#include <cmath>
+#include <vector>
+
+#include "test_main.h"
+#include "bsptree.h"
+#include "occlusion.h"
+#include "threadpool.h"
+
+void TestMathOcclusion();
+void DoOcclusionCullerTest();
+void DoHiZPyramidTest();
+void DoPortalGraphTest();
+void DoBspTreeTest();
+
+//-----------------------------------------------------------------------------
+// Tests the occlusion culling classes.
+//-----------------------------------------------------------------------------
+
+void TestMathOcclusion()
+{
+    DoOcclusionCullerTest();
+    DoHiZPyramidTest();
+    DoPortalGraphTest();
+    DoBspTreeTest();
+}
+
+//-----------------------------------------------------------------------------
+// Unit test the OcclusionCuller class. The camera is at the origin looking
+// down the -z axis, and a wall facing the camera is the occluder.
+//-----------------------------------------------------------------------------
+
+static void addWall(OcclusionCuller &culler, float minX, float minY, float maxX, float maxY, float z)
+{
+    // A rectangle in the plane z = 'z', as two triangles.
+
+    Vector3 vertices[4] =
+    {
+        Vector3(minX, minY, z), Vector3(maxX, minY, z),
+        Vector3(maxX, maxY, z), Vector3(minX, maxY, z)
+    };
+    unsigned int indices[6] = { 0, 1, 2, 0, 2, 3 };
+
+    culler.addOccluder(vertices, indices, 2);
+}
+
+static BoundingBox boxAt(float x, float y, float z, float extent)
+{
+    Vector3 e(extent, extent, extent);
+    return BoundingBox(Vector3(x, y, z) - e, Vector3(x, y, z) + e);
+}
+
+void DoOcclusionCullerTest()
+{
+    Matrix4 viewProj = Matrix4::createPerspective(90.0f, 2.0f, 0.1f, 1000.0f);
+    OcclusionCuller culler(128, 64);
+
+    // Test 1: Without occluders everything on screen is visible.
+    {
+        culler.beginFrame(viewProj);
+        culler.rasterize();
+
+        if (!culler.isVisible(boxAt(0.0f, 0.0f, -20.0f, 1.0f)))
+            throw std::runtime_error("DoOcclusionCullerTest() : Test 1 Part A failed");
+
+        if (culler.width() != 128 || culler.height() != 64 || culler.depth(64, 32) != 0.0f)
+            throw std::runtime_error("DoOcclusionCullerTest() : Test 1 Part B failed");
+    }
+
+    // Test 2: A wall 10 units away hides what is behind it.
+    {
+        culler.beginFrame(viewProj);
+        addWall(culler, -5.0f, -5.0f, 5.0f, 5.0f, -10.0f);
+        culler.rasterize();
+
+        // The depth buffer holds 1 / w = 1 / 10 behind the wall.
+        if (fabsf(culler.depth(64, 32) - 0.1f) > 1e-5f || culler.depth(2, 2) != 0.0f)
+            throw std::runtime_error("DoOcclusionCullerTest() : Test 2 Part A failed");
+
+        if (culler.isVisible(boxAt(0.0f, 0.0f, -20.0f, 1.0f)))
+            throw std::runtime_error("DoOcclusionCullerTest() : Test 2 Part B failed");
+
+        // In front of the wall, poking out from behind it, beside it, and
+        // crossing the camera plane.
+        if (!culler.isVisible(boxAt(0.0f, 0.0f, -5.0f, 1.0f))
+            || !culler.isVisible(boxAt(9.0f, 0.0f, -20.0f, 1.0f))
+            || !culler.isVisible(boxAt(-30.0f, 0.0f, -20.0f, 1.0f))
+            || !culler.isVisible(boxAt(0.0f, 0.0f, 0.0f, 1.0f)))
+            throw std::runtime_error("DoOcclusionCullerTest() : Test 2 Part C failed");
+
+        // A box that straddles the wall's depth is visible.
+        if (!culler.isVisible(BoundingBox(Vector3(-1.0f, -1.0f, -11.0f), Vector3(1.0f, 1.0f, -9.0f))))
+            throw std::runtime_error("DoOcclusionCullerTest() : Test 2 Part D failed");
+
+        if (culler.testedCount() != 6 || culler.culledCount() != 1)
+            throw std::runtime_error("DoOcclusionCullerTest() : Test 2 Part E failed");
+    }
+
+    // Test 3: Occluders that cross the camera plane are clipped, and the
+    // winding doesn't matter.
+    {
+        Vector3 vertices[3] =
+        {
+            Vector3(-100.0f, -1.0f, -100.0f), Vector3(0.0f, -1.0f, 50.0f), Vector3(100.0f, -1.0f, -100.0f)
+        };
+        unsigned int indices[3] = { 0, 2, 1 };
+
+        culler.beginFrame(viewProj);
+        culler.addOccluder(vertices, indices, 1);
+        culler.rasterize();
+
+        // The floor 1 unit below the camera hides a box under it. Clipped
+        // to the camera plane and the guard band, the triangle became a
+        // polygon of 6 vertices (4 triangles).
+        if (culler.triangleCount() != 4)
+            throw std::runtime_error("DoOcclusionCullerTest() : Test 3 Part A failed");
+
+        if (culler.isVisible(boxAt(0.0f, -5.0f, -20.0f, 1.0f))
+            || !culler.isVisible(boxAt(0.0f, 2.0f, -20.0f, 1.0f)))
+            throw std::runtime_error("DoOcclusionCullerTest() : Test 3 Part B failed");
+    }
+
+    // Test 4: Rasterizing with a thread pool gives the same depth buffer,
+    // and model matrices place the occluders.
+    {
+        Random rng(41);
+        std::vector<Vector3> vertices;
+        std::vector<unsigned int> indices;
+
+        for (unsigned int i = 0; i < 200; ++i)
+        {
+            Vector3 center = rng.inBox(Vector3(-40.0f, -20.0f, -60.0f), Vector3(40.0f, 20.0f, -5.0f));
+
+            for (int k = 0; k < 3; ++k)
+            {
+                indices.push_back(static_cast<unsigned int>(vertices.size()));
+                vertices.push_back(center + rng.inSphere(4.0f));
+            }
+        }
+
+        Matrix4 model = Matrix4::createTranslate(1.0f, 0.5f, -2.0f);
+        OcclusionCuller parallel(128, 64);
+        ThreadPool pool(4);
+
+        culler.beginFrame(viewProj);
+        culler.addOccluder(model, &vertices[0], &indices[0], 200);
+        culler.rasterize();
+
+        parallel.beginFrame(viewProj);
+        parallel.addOccluder(model, &vertices[0], &indices[0], 200);
+        parallel.rasterize(pool);
+
+        for (unsigned int y = 0; y < 64; ++y)
+        {
+            for (unsigned int x = 0; x < 128; ++x)
+            {
+                if (culler.depth(x, y) != parallel.depth(x, y))
+                    throw std::runtime_error("DoOcclusionCullerTest() : Test 4 Part A failed");
+            }
+        }
+
+        // Moving the vertices instead of using the model matrix.
+        for (size_t i = 0; i < vertices.size(); ++i)
+            vertices[i] += Vector3(1.0f, 0.5f, -2.0f);
+
+        parallel.beginFrame(viewProj);
+        parallel.addOccluder(&vertices[0], &indices[0], 200);
+        parallel.rasterize(pool);
+
+        for (unsigned int y = 0; y < 64; ++y)
+        {
+            for (unsigned int x = 0; x < 128; ++x)
+            {
+                if (fabsf(culler.depth(x, y) - parallel.depth(x, y)) > 1e-5f)
+                    throw std::runtime_error("DoOcclusionCullerTest() : Test 4 Part B failed");
+            }
+        }
+
+        // The batch test matches the single box test.
+        std::vector<BoundingBox> boxes(100);
+        bool visible[100];
+
+        for (unsigned int i = 0; i < 100; ++i)
+        {
+            Vector3 c = rng.inBox(Vector3(-40.0f, -20.0f, -90.0f), Vector3(40.0f, 20.0f, -5.0f));
+            boxes[i] = boxAt(c.x, c.y, c.z, 0.5f);
+        }
+
+        culler.testBoxes(&boxes[0], visible, 100);
+
+        for (unsigned int i = 0; i < 100; ++i)
+        {
+            if (visible[i] != culler.isVisible(boxes[i]))
+                throw std::runtime_error("DoOcclusionCullerTest() : Test 4 Part C failed");
+        }
+
+        // Each box was tested twice, except those off screen.
+        unsigned int tested = culler.testedCount();
+
+        if ((tested & 1) || tested == 0 || tested == 200 || culler.culledCount() == 0 || culler.culledCount() == tested)
+            throw std::runtime_error("DoOcclusionCullerTest() : Test 4 Part D failed");
+    }
+
+    // Test 5: Boxes off screen are not visible and not counted, and boxes
+    // whose screen rectangle has no area still test a pixel.
+    {
+        culler.beginFrame(viewProj);
+        addWall(culler, -5.0f, -5.0f, 5.0f, 5.0f, -10.0f);
+        culler.rasterize();
+
+        if (culler.isVisible(boxAt(100.0f, 0.0f, -20.0f, 1.0f))
+            || culler.isVisible(boxAt(0.0f, -50.0f, -20.0f, 1.0f)))
+            throw std::runtime_error("DoOcclusionCullerTest() : Test 5 Part A failed");
+
+        if (culler.testedCount() != 0 || culler.culledCount() != 0)
+            throw std::runtime_error("DoOcclusionCullerTest() : Test 5 Part B failed");
+
+        // Points on the center of the screen, which is a pixel corner, in
+        // front of and behind the wall, and a box seen edge on beside it.
+        if (!culler.isVisible(boxAt(0.0f, 0.0f, -5.0f, 0.0f))
+            || !culler.isVisible(BoundingBox(Vector3(10.0f, 0.0f, -30.0f), Vector3(15.0f, 0.0f, -20.0f))))
+            throw std::runtime_error("DoOcclusionCullerTest() : Test 5 Part C failed");
+
+        if (culler.isVisible(boxAt(0.0f, 0.0f, -20.0f, 0.0f)))
+            throw std::runtime_error("DoOcclusionCullerTest() : Test 5 Part D failed");
+
+        if (culler.testedCount() != 3 || culler.culledCount() != 1)
+            throw std::runtime_error("DoOcclusionCullerTest() : Test 5 Part E failed");
+    }
+
+    // Test 6: A ground plane 1 unit below the camera, up to 100 km across,
+    // fills the lower half of the screen. Its triangles cross the camera
+    // plane, so they project to screen coordinates far outside the buffer.
+    {
+        OcclusionCuller ground(256, 128);
+        Matrix4 proj = Matrix4::createPerspective(90.0f, 2.0f, 0.1f, 1000.0f);
+        float sizes[3] = { 1000.0f, 10000.0f, 50000.0f };
+
+        for (int i = 0; i < 3; ++i)
+        {
+            float s = sizes[i];
+            Vector3 vertices[4] =
+            {
+                Vector3(-s, -1.0f, -s), Vector3(s, -1.0f, -s),
+                Vector3(s, -1.0f, s), Vector3(-s, -1.0f, s)
+            };
+            unsigned int indices[6] = { 0, 1, 2, 0, 2, 3 };
+            unsigned int covered = 0;
+
+            ground.beginFrame(proj);
+            ground.addOccluder(vertices, indices, 2);
+            ground.rasterize();
+
+            for (unsigned int y = 0; y < 128; ++y)
+            {
+                for (unsigned int x = 0; x < 256; ++x)
+                {
+                    if (ground.depth(x, y) > 0.0f)
+                        ++covered;
+                }
+            }
+
+            if (covered != 256 * 64)
+                throw std::runtime_error("DoOcclusionCullerTest() : Test 6 Part A failed");
+
+            // A box under the ground is hidden, and one above it visible.
+            if (ground.isVisible(boxAt(0.0f, -3.0f, -20.0f, 1.0f)) || !ground.isVisible(boxAt(0.0f, 0.0f, -20.0f, 1.0f)))
+                throw std::runtime_error("DoOcclusionCullerTest() : Test 6 Part B failed");
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Unit test the HiZPyramid class. The depth buffers hold the same wall as
+// the OcclusionCuller tests, drawn by an OcclusionCuller or filled in as a
+// renderer would for each depth convention.
+//-----------------------------------------------------------------------------
+
+static void fillWallDepth(std::vector<float> &depth, unsigned int width, unsigned int height,
+    const Matrix4 &viewProj, float wallDepth, float clearDepth)
+{
+    // The wall from (-5, -5, -10) to (5, 5, -10), as a renderer would draw
+    // it: each pixel whose center is inside the wall gets 'wallDepth'.
+
+    Vector4 lo = Vector4(-5.0f, -5.0f, -10.0f, 1.0f) * viewProj;
+    Vector4 hi = Vector4(5.0f, 5.0f, -10.0f, 1.0f) * viewProj;
+    float x0 = (lo.x / lo.w * 0.5f + 0.5f) * width, x1 = (hi.x / hi.w * 0.5f + 0.5f) * width;
+    float y0 = (0.5f - hi.y / hi.w * 0.5f) * height, y1 = (0.5f - lo.y / lo.w * 0.5f) * height;
+
+    depth.assign(width * height, clearDepth);
+
+    for (unsigned int y = 0; y < height; ++y)
+    {
+        for (unsigned int x = 0; x < width; ++x)
+        {
+            float cx = x + 0.5f, cy = y + 0.5f;
+
+            if (cx >= x0 && cx <= x1 && cy >= y0 && cy <= y1)
+                depth[y * width + x] = wallDepth;
+        }
+    }
+}
+
+void DoHiZPyramidTest()
+{
+    Matrix4 viewProj = Matrix4::createPerspective(90.0f, 2.0f, 0.1f, 1000.0f);
+    HiZPyramid pyramid;
+
+    // Test 1: The levels halve in size, rounding up, and hold the farthest
+    // depth of the texels below them.
+    {
+        // Without a depth buffer everything is visible.
+        if (pyramid.levelCount() != 0 || !pyramid.isVisible(viewProj, boxAt(0.0f, 0.0f, -20.0f, 1.0f)))
+            throw std::runtime_error("DoHiZPyramidTest() : Test 1 Part A failed");
+
+        float depth[15] =
+        {
+            0.1f, 0.2f, 0.3f, 0.4f, 0.5f,
+            0.6f, 0.7f, 0.8f, 0.9f, 0.5f,
+            0.2f, 0.2f, 0.2f, 0.2f, 0.95f
+        };
+
+        pyramid.build(depth, 5, 3, HiZPyramid::DEPTH_NEG_ONE_TO_ONE);
+
+        if (pyramid.levelCount() != 4
+            || pyramid.width(1) != 3 || pyramid.height(1) != 2
+            || pyramid.width(2) != 2 || pyramid.height(2) != 1
+            || pyramid.width(3) != 1 || pyramid.height(3) != 1)
+            throw std::runtime_error("DoHiZPyramidTest() : Test 1 Part B failed");
+
+        if (pyramid.farthestDepth(0, 3, 1) != 0.9f
+            || pyramid.farthestDepth(1, 0, 0) != 0.7f
+            || pyramid.farthestDepth(1, 2, 0) != 0.5f
+            || pyramid.farthestDepth(1, 2, 1) != 0.95f
+            || pyramid.farthestDepth(1, 0, 1) != 0.2f
+            || pyramid.farthestDepth(3, 0, 0) != 0.95f)
+            throw std::runtime_error("DoHiZPyramidTest() : Test 1 Part C failed");
+
+        // For the nearer-is-larger conventions the farthest depth is the
+        // smallest value.
+        pyramid.build(depth, 5, 3, HiZPyramid::DEPTH_REVERSED);
+
+        if (pyramid.farthestDepth(1, 0, 0) != 0.1f || pyramid.farthestDepth(3, 0, 0) != 0.1f)
+            throw std::runtime_error("DoHiZPyramidTest() : Test 1 Part D failed");
+    }
+
+    // Test 2: A pyramid built from an OcclusionCuller's depth buffer culls
+    // like the OcclusionCuller, only more conservatively.
+    {
+        OcclusionCuller culler(128, 64);
+
+        culler.beginFrame(viewProj);
+        addWall(culler, -5.0f, -5.0f, 5.0f, 5.0f, -10.0f);
+        culler.rasterize();
+        pyramid.build(culler);
+
+        if (pyramid.convention() != HiZPyramid::DEPTH_INVERSE_W || pyramid.levelCount() != 8
+            || fabsf(pyramid.farthestDepth(0, 64, 32) - 0.1f) > 1e-5f || pyramid.farthestDepth(7, 0, 0) != 0.0f)
+            throw std::runtime_error("DoHiZPyramidTest() : Test 2 Part A failed");
+
+        if (pyramid.isVisible(viewProj, boxAt(0.0f, 0.0f, -20.0f, 1.0f))
+            || pyramid.isVisible(viewProj, BoundingSphere(Vector3(0.0f, 0.0f, -30.0f), 2.0f)))
+            throw std::runtime_error("DoHiZPyramidTest() : Test 2 Part B failed");
+
+        if (!pyramid.isVisible(viewProj, boxAt(0.0f, 0.0f, -5.0f, 1.0f))
+            || !pyramid.isVisible(viewProj, boxAt(9.0f, 0.0f, -20.0f, 1.0f))
+            || !pyramid.isVisible(viewProj, boxAt(0.0f, 0.0f, 0.0f, 1.0f))
+            || !pyramid.isVisible(viewProj, BoundingSphere(Vector3(0.0f, 0.0f, -5.0f), 1.0f)))
+            throw std::runtime_error("DoHiZPyramidTest() : Test 2 Part C failed");
+
+        // Nothing the OcclusionCuller sees is culled by the pyramid.
+        Random rng(42);
+        std::vector<BoundingBox> boxes(200);
+        bool visible[200];
+        unsigned int hidden = 0;
+
+        for (unsigned int i = 0; i < 200; ++i)
+        {
+            Vector3 c = rng.inBox(Vector3(-20.0f, -10.0f, -60.0f), Vector3(20.0f, 10.0f, -12.0f));
+            boxes[i] = boxAt(c.x, c.y, c.z, rng.nextFloat() * 2.0f);
+            visible[i] = true;
+        }
+
+        pyramid.testBoxes(viewProj, &boxes[0], visible, 200);
+
+        for (unsigned int i = 0; i < 200; ++i)
+        {
+            if (!visible[i] && culler.isVisible(boxes[i]))
+                throw std::runtime_error("DoHiZPyramidTest() : Test 2 Part D failed");
+
+            if (visible[i] != pyramid.isVisible(viewProj, boxes[i]))
+                throw std::runtime_error("DoHiZPyramidTest() : Test 2 Part E failed");
+
+            hidden += visible[i] ? 0 : 1;
+        }
+
+        if (hidden == 0)
+            throw std::runtime_error("DoHiZPyramidTest() : Test 2 Part F failed");
+    }
+
+    // Test 3: The batch tests chain with frustum culling. Objects already
+    // rejected are left alone, and only the given mask bit is cleared.
+    {
+        BoundingBox boxes[3] = { boxAt(0.0f, 0.0f, -20.0f, 1.0f), boxAt(0.0f, 0.0f, -5.0f, 1.0f), boxAt(0.0f, 0.0f, -20.0f, 1.0f) };
+        BoundingSphere spheres[3];
+        bool visible[3] = { true, true, false };
+        unsigned int masks[3] = { 0x5u, 0x5u, 0x1u };
+
+        for (int i = 0; i < 3; ++i)
+            spheres[i] = BoundingSphere(boxes[i].getCenter(), 1.0f);
+
+        pyramid.testBoxes(viewProj, boxes, visible, 3);
+
+        if (visible[0] || !visible[1] || visible[2])
+            throw std::runtime_error("DoHiZPyramidTest() : Test 3 Part A failed");
+
+        pyramid.testBoxes(viewProj, boxes, masks, 2, 3);
+
+        if (masks[0] != 0x1u || masks[1] != 0x5u || masks[2] != 0x1u)
+            throw std::runtime_error("DoHiZPyramidTest() : Test 3 Part B failed");
+
+        bool sphereVisible[3] = { true, true, true };
+        unsigned int sphereMasks[3] = { 0x2u, 0x2u, 0x0u };
+
+        pyramid.testSpheres(viewProj, spheres, sphereVisible, 3);
+        pyramid.testSpheres(viewProj, spheres, sphereMasks, 1, 3);
+
+        if (sphereVisible[0] || !sphereVisible[1] || sphereVisible[2]
+            || sphereMasks[0] != 0x0u || sphereMasks[1] != 0x2u || sphereMasks[2] != 0x0u)
+            throw std::runtime_error("DoHiZPyramidTest() : Test 3 Part C failed");
+    }
+
+    // Test 4: Renderer depth buffers in each convention, each with its
+    // projection.
+    {
+        const float n = 0.1f, f = 1000.0f;
+        Matrix4 projs[3] = { viewProj, viewProj, viewProj };
+
+        // Direct3D style, z in [0, w].
+        projs[1][2][2] = f / (n - f);
+        projs[1][3][2] = n * f / (n - f);
+
+        // Reversed Z with an infinite far plane, z = n.
+        projs[2][2][2] = 0.0f;
+        projs[2][3][2] = n;
+
+        const HiZPyramid::DepthConvention conventions[3] =
+        {
+            HiZPyramid::DEPTH_NEG_ONE_TO_ONE, HiZPyramid::DEPTH_ZERO_TO_ONE, HiZPyramid::DEPTH_REVERSED
+        };
+        const float clearDepths[3] = { 1.0f, 1.0f, 0.0f };
+
+        for (int i = 0; i < 3; ++i)
+        {
+            Vector4 wall = Vector4(0.0f, 0.0f, -10.0f, 1.0f) * projs[i];
+            float ndcZ = wall.z / wall.w;
+            float wallDepth = (i == 0) ? ndcZ * 0.5f + 0.5f : ndcZ;
+            std::vector<float> depth;
+
+            fillWallDepth(depth, 160, 90, projs[i], wallDepth, clearDepths[i]);
+            pyramid.build(&depth[0], 160, 90, conventions[i]);
+
+            if (pyramid.convention() != conventions[i] || pyramid.levelCount() != 9)
+                throw std::runtime_error("DoHiZPyramidTest() : Test 4 Part A failed");
+
+            if (pyramid.isVisible(projs[i], boxAt(0.0f, 0.0f, -20.0f, 1.0f))
+                || pyramid.isVisible(projs[i], BoundingSphere(Vector3(1.0f, 1.0f, -15.0f), 1.0f)))
+                throw std::runtime_error("DoHiZPyramidTest() : Test 4 Part B failed");
+
+            if (!pyramid.isVisible(projs[i], boxAt(0.0f, 0.0f, -5.0f, 1.0f))
+                || !pyramid.isVisible(projs[i], boxAt(9.0f, 0.0f, -20.0f, 1.0f))
+                || !pyramid.isVisible(projs[i], boxAt(-30.0f, 0.0f, -20.0f, 1.0f))
+                || !pyramid.isVisible(projs[i], BoundingBox(Vector3(-1.0f, -1.0f, -11.0f), Vector3(1.0f, 1.0f, -9.0f))))
+                throw std::runtime_error("DoHiZPyramidTest() : Test 4 Part C failed");
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Unit test the PortalGraph class. Cell 0 is the room the camera is in,
+// joined by a doorway to the corridor in cell 1, which has a doorway
+// straight ahead into cell 3 and one off to the side into cell 2.
+//-----------------------------------------------------------------------------
+
+static void addDoorway(PortalGraph &graph, int cellA, int cellB, float minX, float maxX, float z)
+{
+    Vector3 vertices[4] =
+    {
+        Vector3(minX, 0.0f, z),
+        Vector3(maxX, 0.0f, z),
+        Vector3(maxX, 3.0f, z),
+        Vector3(minX, 3.0f, z)
+    };
+
+    if (graph.addPortal(cellA, cellB, vertices, 4) == PortalGraph::NO_PORTAL)
+        throw std::runtime_error("DoPortalGraphTest() : addDoorway() failed");
+}
+
+static Frustum portalFrustum(const Vector3 &eye, float yaw)
+{
+    Matrix4 rotation = Matrix4::createRotate(Vector3(0.0f, 1.0f, 0.0f), yaw);
+    Matrix4 view = Matrix4::createTranslate(-eye.x, -eye.y, -eye.z) * rotation.transpose();
+
+    return Frustum(view, Matrix4::createPerspective(90.0f, 1.0f, 0.1f, 100.0f));
+}
+
+void DoPortalGraphTest()
+{
+    PortalGraph graph;
+    PortalQuery query;
+    Vector3 eye(0.0f, 1.5f, -2.0f);
+    Frustum frustum = portalFrustum(eye, 0.0f);
+
+    graph.addCell(BoundingBox(Vector3(-5.0f, 0.0f, -10.0f), Vector3(5.0f, 4.0f, 0.0f)));
+    graph.addCell(BoundingBox(Vector3(-5.0f, 0.0f, -20.0f), Vector3(5.0f, 4.0f, -10.0f)));
+    graph.addCell(BoundingBox(Vector3(2.0f, 0.0f, -30.0f), Vector3(10.0f, 4.0f, -20.0f)));
+    graph.addCell(BoundingBox(Vector3(-2.0f, 0.0f, -30.0f), Vector3(2.0f, 4.0f, -20.0f)));
+
+    // The doorway into cell 2 is out of sight through the first doorway.
+    addDoorway(graph, 0, 1, -1.0f, 1.0f, -10.0f);
+    addDoorway(graph, 1, 2, 3.0f, 4.0f, -20.0f);
+    addDoorway(graph, 1, 3, -2.0f, 2.0f, -20.0f);
+
+    // Test 1: Building the graph.
+    {
+        Vector3 vertices[PortalGraph::MAX_PORTAL_VERTICES + 1];
+
+        for (unsigned int i = 0; i <= PortalGraph::MAX_PORTAL_VERTICES; ++i)
+            vertices[i] = Vector3(cosf(i * 0.3f), sinf(i * 0.3f), -10.0f);
+
+        if (graph.cellCount() != 4 || graph.portalCount() != 3 || graph.portalVertexCount(1) != 4
+            || graph.portalVertices(1)[2] != Vector3(4.0f, 3.0f, -20.0f))
+            throw std::runtime_error("DoPortalGraphTest() : Test 1 Part A failed");
+
+        if (graph.addPortal(0, 0, vertices, 4) != PortalGraph::NO_PORTAL
+            || graph.addPortal(0, 4, vertices, 4) != PortalGraph::NO_PORTAL
+            || graph.addPortal(0, 1, vertices, 2) != PortalGraph::NO_PORTAL
+            || graph.addPortal(0, 1, vertices, PortalGraph::MAX_PORTAL_VERTICES + 1) != PortalGraph::NO_PORTAL
+            || graph.portalCount() != 3)
+            throw std::runtime_error("DoPortalGraphTest() : Test 1 Part B failed");
+
+        if (graph.findCell(eye) != 0 || graph.findCell(Vector3(0.0f, 1.0f, -25.0f)) != 3
+            || graph.findCell(Vector3(0.0f, 10.0f, 0.0f)) != PortalGraph::NO_CELL)
+            throw std::runtime_error("DoPortalGraphTest() : Test 1 Part C failed");
+    }
+
+    // Test 2: Looking down the corridor.
+    {
+        if (!graph.findVisibleCells(query, eye, frustum, 0))
+            throw std::runtime_error("DoPortalGraphTest() : Test 2 Part A failed");
+
+        if (query.visibleCellCount() != 3 || query.viewCount() != 3 || query.visibleCell(0) != 0
+            || !query.isCellVisible(1) || query.isCellVisible(2) || !query.isCellVisible(3))
+            throw std::runtime_error("DoPortalGraphTest() : Test 2 Part B failed");
+
+        // The corridor is seen through the first doorway only.
+        for (unsigned int i = 0; i < query.viewCount(); ++i)
+        {
+            if (query.viewCell(i) != 1)
+                continue;
+
+            const ConvexVolume &volume = query.viewVolume(i);
+
+            if (!volume.pointInVolume(Vector3(0.0f, 1.5f, -12.0f))
+                || volume.pointInVolume(Vector3(1.9f, 1.5f, -12.0f))
+                || volume.pointInVolume(Vector3(0.0f, 1.5f, -8.0f)))
+                throw std::runtime_error("DoPortalGraphTest() : Test 2 Part C failed");
+        }
+
+        // Turned around, only the camera's cell is visible.
+        if (!graph.findVisibleCells(query, eye, portalFrustum(eye, 180.0f), 0)
+            || query.visibleCellCount() != 1 || query.viewCount() != 1 || query.isCellVisible(1))
+            throw std::runtime_error("DoPortalGraphTest() : Test 2 Part D failed");
+    }
+
+    // Test 3: A doorway from cell 3 into cell 2 makes a loop in the graph,
+    // and cell 2 is visible through it.
+    {
+        Vector3 vertices[4] =
+        {
+            Vector3(2.0f, 0.0f, -22.0f),
+            Vector3(2.0f, 0.0f, -28.0f),
+            Vector3(2.0f, 3.0f, -28.0f),
+            Vector3(2.0f, 3.0f, -22.0f)
+        };
+
+        graph.addPortal(3, 2, vertices, 4);
+
+        if (!graph.findVisibleCells(query, eye, frustum, 0))
+            throw std::runtime_error("DoPortalGraphTest() : Test 3 Part A failed");
+
+        if (query.visibleCellCount() != 4 || query.viewCount() != 4)
+            throw std::runtime_error("DoPortalGraphTest() : Test 3 Part B failed");
+    }
+
+    // Test 4: Standing in the first doorway, with the eye in its plane.
+    {
+        Vector3 doorway(0.0f, 1.5f, -10.0f);
+
+        if (!graph.findVisibleCells(query, doorway, portalFrustum(doorway, 0.0f), 0)
+            || !query.isCellVisible(1) || !query.isCellVisible(3))
+            throw std::runtime_error("DoPortalGraphTest() : Test 4 failed");
+    }
+
+    // Test 5: Running out of views or depth, and invalid queries.
+    {
+        PortalQuery fewViews(2, PortalQuery::DEFAULT_MAX_DEPTH);
+        PortalQuery shallow(PortalQuery::DEFAULT_MAX_VIEWS, 1);
+
+        if (graph.findVisibleCells(fewViews, eye, frustum, 0) || fewViews.viewCount() != 2)
+            throw std::runtime_error("DoPortalGraphTest() : Test 5 Part A failed");
+
+        if (graph.findVisibleCells(shallow, eye, frustum, 0) || shallow.visibleCellCount() != 2
+            || shallow.maxDepth() != 1)
+            throw std::runtime_error("DoPortalGraphTest() : Test 5 Part B failed");
+
+        if (graph.findVisibleCells(query, eye, frustum, PortalGraph::NO_CELL)
+            || query.visibleCellCount() != 0 || query.viewCount() != 0 || query.isCellVisible(0))
+            throw std::runtime_error("DoPortalGraphTest() : Test 5 Part C failed");
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Unit test the BspTree class. The queries are compared with brute force
+// tests of every polygon, on a closed box and on a soup of triangles.
+//-----------------------------------------------------------------------------
+
+static bool rayHitsPolygon(const Ray &ray, const Vector3 *vertices, unsigned int count, float &t)
+{
+    // Tests the triangles of the polygon's fan (Moller-Trumbore).
+
+    for (unsigned int i = 1; i + 1 < count; ++i)
+    {
+        Vector3 edge1 = vertices[i] - vertices[0];
+        Vector3 edge2 = vertices[i + 1] - vertices[0];
+        Vector3 p = Vector3::cross(ray.direction, edge2);
+        float det = Vector3::dot(edge1, p);
+
+        if (fabsf(det) < 1e-8f)
+            continue;
+
+        Vector3 s = ray.origin - vertices[0];
+        float u = Vector3::dot(s, p) / det;
+        Vector3 q = Vector3::cross(s, edge1);
+        float v = Vector3::dot(ray.direction, q) / det;
+
+        if (u < 0.0f || v < 0.0f || u + v > 1.0f)
+            continue;
+
+        t = Vector3::dot(edge2, q) / det;
+        return t >= 0.0f;
+    }
+
+    return false;
+}
+
+static float polygonArea(const Vector3 *vertices, unsigned int count)
+{
+    Vector3 normal(0.0f, 0.0f, 0.0f);
+
+    for (unsigned int i = 0; i < count; ++i)
+        normal += Vector3::cross(vertices[i], vertices[(i + 1) % count]);
+
+    return normal.magnitude() * 0.5f;
+}
+
+void DoBspTreeTest()
+{
+    // A closed box from -2 to 2 with its faces facing out.
+    const Vector3 cube[24] =
+    {
+        Vector3( 2.0f, -2.0f, -2.0f), Vector3( 2.0f,  2.0f, -2.0f), Vector3( 2.0f,  2.0f,  2.0f), Vector3( 2.0f, -2.0f,  2.0f),
+        Vector3(-2.0f, -2.0f, -2.0f), Vector3(-2.0f, -2.0f,  2.0f), Vector3(-2.0f,  2.0f,  2.0f), Vector3(-2.0f,  2.0f, -2.0f),
+        Vector3(-2.0f,  2.0f, -2.0f), Vector3(-2.0f,  2.0f,  2.0f), Vector3( 2.0f,  2.0f,  2.0f), Vector3( 2.0f,  2.0f, -2.0f),
+        Vector3(-2.0f, -2.0f, -2.0f), Vector3( 2.0f, -2.0f, -2.0f), Vector3( 2.0f, -2.0f,  2.0f), Vector3(-2.0f, -2.0f,  2.0f),
+        Vector3(-2.0f, -2.0f,  2.0f), Vector3( 2.0f, -2.0f,  2.0f), Vector3( 2.0f,  2.0f,  2.0f), Vector3(-2.0f,  2.0f,  2.0f),
+        Vector3(-2.0f, -2.0f, -2.0f), Vector3(-2.0f,  2.0f, -2.0f), Vector3( 2.0f,  2.0f, -2.0f), Vector3( 2.0f, -2.0f, -2.0f)
+    };
+    const unsigned int cubeCounts[6] = { 4, 4, 4, 4, 4, 4 };
+
+    // Triangles up to 6 units across scattered through a 40 unit box.
+    const unsigned int triangleCount = 300;
+    std::vector<Vector3> soup(triangleCount * 3);
+    std::vector<unsigned int> soupCounts(triangleCount, 3);
+    Random rng(48);
+
+    for (unsigned int i = 0; i < triangleCount; ++i)
+    {
+        Vector3 center = rng.inBox(Vector3(-20.0f, -20.0f, -20.0f), Vector3(20.0f, 20.0f, 20.0f));
+
+        for (int k = 0; k < 3; ++k)
+            soup[i * 3 + k] = center + rng.inSphere(3.0f);
+    }
+
+    // Test 1: Empty trees and invalid input.
+    {
+        BspTree tree;
+        float t = 0.0f;
+        int polygon = BspTree::NO_POLYGON;
+        unsigned int badCounts[2] = { 4, 2 };
+
+        if (!tree.build(cube, cubeCounts, 0) || tree.nodeCount() != 0 || tree.leafCount() != 1
+            || tree.findLeaf(Vector3(1.0f, 2.0f, 3.0f)) != 0 || tree.isLeafSolid(0) || tree.depth() != 0
+            || tree.intersectRay(Ray(Vector3(0.0f, 0.0f, 0.0f), Vector3(1.0f, 0.0f, 0.0f)), t, polygon))
+            throw std::runtime_error("DoBspTreeTest() : Test 1 Part A failed");
+
+        if (tree.build(cube, badCounts, 2) || tree.nodeCount() != 0 || tree.polygonCount() != 0)
+            throw std::runtime_error("DoBspTreeTest() : Test 1 Part B failed");
+    }
+
+    // Test 2: The closed box. Its faces all lie behind each other, so none
+    // are split, and the points inside are in its one solid leaf.
+    {
+        BspTree tree;
+
+        if (!tree.build(cube, cubeCounts, 6) || tree.polygonCount() != 6 || tree.nodeCount() != 6
+            || tree.leafCount() != 7 || tree.depth() != 6)
+            throw std::runtime_error("DoBspTreeTest() : Test 2 Part A failed");
+
+        for (int i = 0; i < 1000; ++i)
+        {
+            Vector3 point = rng.inBox(Vector3(-4.0f, -4.0f, -4.0f), Vector3(4.0f, 4.0f, 4.0f));
+            bool inside = fabsf(point.x) < 2.0f && fabsf(point.y) < 2.0f && fabsf(point.z) < 2.0f;
+
+            if (tree.isLeafSolid(tree.findLeaf(point)) != inside)
+                throw std::runtime_error("DoBspTreeTest() : Test 2 Part B failed");
+        }
+
+        // From outside the nearest face is hit, and from inside the face
+        // the ray leaves through.
+        float t = 0.0f;
+        int polygon = BspTree::NO_POLYGON;
+
+        if (!tree.intersectRay(Ray(Vector3(10.0f, 0.5f, 0.5f), Vector3(-2.0f, 0.0f, 0.0f)), t, polygon)
+            || fabsf(t - 4.0f) > 1e-5f || tree.polygonSource(polygon) != 0)
+            throw std::runtime_error("DoBspTreeTest() : Test 2 Part C failed");
+
+        if (!tree.intersectRay(Ray(Vector3(0.5f, 0.5f, 0.5f), Vector3(0.0f, 0.0f, 1.0f)), t, polygon)
+            || fabsf(t - 1.5f) > 1e-5f || tree.polygonSource(polygon) != 4)
+            throw std::runtime_error("DoBspTreeTest() : Test 2 Part D failed");
+    }
+
+    BspTree tree;
+
+    if (!tree.build(&soup[0], &soupCounts[0], triangleCount))
+        throw std::runtime_error("DoBspTreeTest() : build() failed");
+
+    // Test 3: The split polygons cover their source triangles exactly.
+    {
+        std::vector<float> area(triangleCount, 0.0f);
+
+        if (tree.polygonCount() <= triangleCount || tree.leafCount() != tree.nodeCount() + 1)
+            throw std::runtime_error("DoBspTreeTest() : Test 3 Part A failed");
+
+        for (unsigned int i = 0; i < tree.polygonCount(); ++i)
+        {
+            int source = tree.polygonSource(i);
+            Plane plane(soup[source * 3], soup[source * 3 + 1], soup[source * 3 + 2]);
+
+            for (unsigned int k = 0; k < tree.polygonVertexCount(i); ++k)
+            {
+                if (fabsf(Plane::dot(plane, tree.polygonVertices(i)[k])) > 1e-3f)
+                    throw std::runtime_error("DoBspTreeTest() : Test 3 Part B failed");
+            }
+
+            area[source] += polygonArea(tree.polygonVertices(i), tree.polygonVertexCount(i));
+        }
+
+        for (unsigned int i = 0; i < triangleCount; ++i)
+        {
+            float expected = polygonArea(&soup[i * 3], 3);
+
+            if (fabsf(area[i] - expected) > 1e-3f * (1.0f + expected))
+                throw std::runtime_error("DoBspTreeTest() : Test 3 Part C failed");
+        }
+    }
+
+    // Test 4: Front to back order. Along any ray from the eye, the polygons
+    // it hits are listed in the order they are hit.
+    {
+        Vector3 eye(3.0f, -1.0f, 2.0f);
+        std::vector<int> order(tree.polygonCount() + 1, -1);
+        unsigned int hits = 0;
+
+        if (tree.sortFrontToBack(eye, &order[0], tree.polygonCount()) != tree.polygonCount()
+            || order[tree.polygonCount()] != -1)
+            throw std::runtime_error("DoBspTreeTest() : Test 4 Part A failed");
+
+        for (int i = 0; i < 200; ++i)
+        {
+            Ray ray(eye, rng.onSphere(1.0f));
+            float lastT = 0.0f;
+
+            // Taken in the listed order, the hits get farther away.
+            for (unsigned int n = 0; n < tree.polygonCount(); ++n)
+            {
+                float t = 0.0f;
+
+                if (!rayHitsPolygon(ray, tree.polygonVertices(order[n]), tree.polygonVertexCount(order[n]), t))
+                    continue;
+
+                if (t < lastT - 1e-3f)
+                    throw std::runtime_error("DoBspTreeTest() : Test 4 Part B failed");
+
+                lastT = t;
+                ++hits;
+            }
+        }
+
+        if (hits == 0 || tree.sortFrontToBack(eye, &order[0], 10) != 10)
+            throw std::runtime_error("DoBspTreeTest() : Test 4 Part C failed");
+    }
+
+    // Test 5: Ray intersection.
+    {
+        unsigned int hits = 0;
+
+        for (int i = 0; i < 500; ++i)
+        {
+            Ray ray(rng.inBox(Vector3(-25.0f, -25.0f, -25.0f), Vector3(25.0f, 25.0f, 25.0f)), rng.onSphere(2.0f));
+            float expected = FLT_MAX;
+            float t = 0.0f;
+            int polygon = BspTree::NO_POLYGON;
+
+            for (unsigned int n = 0; n < triangleCount; ++n)
+            {
+                float tn = 0.0f;
+
+                if (rayHitsPolygon(ray, &soup[n * 3], 3, tn) && tn < expected)
+                    expected = tn;
+            }
+
+            bool hit = tree.intersectRay(ray, t, polygon);
+
+            if (hit != (expected != FLT_MAX))
+                throw std::runtime_error("DoBspTreeTest() : Test 5 Part A failed");
+
+            if (hit && (fabsf(t - expected) > 1e-3f * (1.0f + expected)
+                || !rayHitsPolygon(ray, &soup[tree.polygonSource(polygon) * 3], 3, expected)))
+                throw std::runtime_error("DoBspTreeTest() : Test 5 Part B failed");
+
+            hits += hit ? 1 : 0;
+        }
+
+        if (hits == 0)
+            throw std::runtime_error("DoBspTreeTest() : Test 5 Part C failed");
+    }
+
+    // Test 6: Weighting splits trades balance for fewer split polygons.
+    {
+        BspTree balanced;
+        BspTree fewSplits;
+
+        balanced.setSplitWeight(0.0f);
+        fewSplits.setSplitWeight(100.0f);
+
+        if (fewSplits.splitWeight() != 100.0f || tree.splitWeight() != 8.0f
+            || !balanced.build(&soup[0], &soupCounts[0], triangleCount)
+            || !fewSplits.build(&soup[0], &soupCounts[0], triangleCount))
+            throw std::runtime_error("DoBspTreeTest() : Test 6 Part A failed");
+
+        if (fewSplits.polygonCount() >= balanced.polygonCount() || fewSplits.depth() <= balanced.depth())
+            throw std::runtime_error("DoBspTreeTest() : Test 6 Part B failed");
+    }
+
+    // Test 7: The parallel build builds the same tree.
+    {
+        ThreadPool pool(4);
+        BspTree parallel;
+        Vector3 eye(-5.0f, 4.0f, 1.0f);
+        std::vector<int> order(tree.polygonCount());
+        std::vector<int> parallelOrder(tree.polygonCount());
+
+        if (!parallel.build(&soup[0], &soupCounts[0], triangleCount, pool)
+            || parallel.polygonCount() != tree.polygonCount() || parallel.nodeCount() != tree.nodeCount()
+            || parallel.leafCount() != tree.leafCount() || parallel.depth() != tree.depth())
+            throw std::runtime_error("DoBspTreeTest() : Test 7 Part A failed");
+
+        tree.sortFrontToBack(eye, &order[0], tree.polygonCount());
+        parallel.sortFrontToBack(eye, &parallelOrder[0], parallel.polygonCount());
+
+        for (unsigned int i = 0; i < tree.polygonCount(); ++i)
+        {
+            if (tree.polygonSource(order[i]) != parallel.polygonSource(parallelOrder[i])
+                || tree.polygonVertexCount(order[i]) != parallel.polygonVertexCount(parallelOrder[i]))
+                throw std::runtime_error("DoBspTreeTest() : Test 7 Part B failed");
+        }
+
+        for (int i = 0; i < 500; ++i)
+        {
+            Vector3 point = rng.inBox(Vector3(-25.0f, -25.0f, -25.0f), Vector3(25.0f, 25.0f, 25.0f));
+
+            if (tree.isLeafSolid(tree.findLeaf(point)) != parallel.isLeafSolid(parallel.findLeaf(point)))
+                throw std::runtime_error("DoBspTreeTest() : Test 7 Part C failed");
+        }
+    }
+}
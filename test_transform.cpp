@@ -0,0 +1,330 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2026 dhpoware. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include <cmath>
+#include <vector>
+
+#include "test_main.h"
+#include "batch.h"
+#include "threadpool.h"
+#include "transform.h"
+
+void TestMathTransform();
+void DoCameraRelativeViewTest();
+void DoThreadPoolTest();
+void DoTransformHierarchyTest();
+
+//-----------------------------------------------------------------------------
+// Tests all of the transform hierarchy related classes.
+//-----------------------------------------------------------------------------
+
+void TestMathTransform()
+{
+    DoThreadPoolTest();
+    DoTransformHierarchyTest();
+    DoCameraRelativeViewTest();
+}
+
+//-----------------------------------------------------------------------------
+// Unit test the ThreadPool class.
+//-----------------------------------------------------------------------------
+
+void DoThreadPoolTest()
+{
+    // Test 1: Every index is visited exactly once.
+    {
+        ThreadPool pool(4);
+        std::vector<int> visits(10000, 0);
+
+        for (int pass = 0; pass < 3; ++pass)
+        {
+            pool.parallelFor(static_cast<unsigned int>(visits.size()), 64,
+                [&visits](unsigned int begin, unsigned int end)
+                {
+                    for (unsigned int i = begin; i < end; ++i)
+                        ++visits[i];
+                });
+        }
+
+        for (size_t i = 0; i < visits.size(); ++i)
+        {
+            if (visits[i] != 3)
+                throw std::runtime_error("DoThreadPoolTest() : Test 1 failed");
+        }
+    }
+
+    // Test 2: A single threaded pool runs the loop on the calling thread.
+    {
+        ThreadPool pool(1);
+        unsigned int total = 0;
+
+        pool.parallelFor(100, 10, [&total](unsigned int begin, unsigned int end)
+        {
+            total += end - begin;
+        });
+
+        if (pool.threadCount() != 1 || total != 100)
+            throw std::runtime_error("DoThreadPoolTest() : Test 2 failed");
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Unit test the TransformHierarchy class. This is not an exhaustive test of
+// the TransformHierarchy class. However it will test most of the important
+// functions.
+//-----------------------------------------------------------------------------
+
+void DoTransformHierarchyTest()
+{
+    // Test 1: Adding nodes.
+    {
+        TransformHierarchy h(2);
+
+        int root = h.addNode(TransformHierarchy::NO_PARENT);
+        int child = h.addNode(root);
+
+        // Case 1: Nodes are added in order.
+        if (root != 0 || child != 1 || h.nodeCount() != 2 || h.parent(child) != root)
+            throw std::runtime_error("DoTransformHierarchyTest() : Test 1 Case 1 failed");
+
+        // Case 2: The hierarchy is full.
+        if (h.addNode(root) != TransformHierarchy::NO_PARENT)
+            throw std::runtime_error("DoTransformHierarchyTest() : Test 1 Case 2 failed");
+    }
+
+    // Test 2: Parents must be added before their children.
+    {
+        TransformHierarchy h;
+
+        if (h.addNode(0) != TransformHierarchy::NO_PARENT)
+            throw std::runtime_error("DoTransformHierarchyTest() : Test 2 failed");
+    }
+
+    // Test 3: World matrices are concatenated from the root down.
+    {
+        TransformHierarchy h;
+        Quaternion rotation(Vector3(0.0f, 1.0f, 0.0f), 90.0f);
+
+        int root = h.addNode(TransformHierarchy::NO_PARENT);
+        int child = h.addNode(root);
+        int grandChild = h.addNode(child);
+
+        h.setLocal(root, Vector3(10.0f, 0.0f, 0.0f), rotation, Vector3(2.0f, 2.0f, 2.0f));
+        h.setLocalTranslation(child, Vector3(0.0f, 0.0f, 1.0f));
+        h.setLocalScale(grandChild, Vector3(3.0f, 3.0f, 3.0f));
+        h.updateWorldMatrices();
+
+        Matrix4 rootWorld = Matrix4::createScale(2.0f, 2.0f, 2.0f)
+            * rotation.toMatrix4() * Matrix4::createTranslate(10.0f, 0.0f, 0.0f);
+        Matrix4 childWorld = Matrix4::createTranslate(0.0f, 0.0f, 1.0f) * rootWorld;
+        Matrix4 grandChildWorld = Matrix4::createScale(3.0f, 3.0f, 3.0f) * childWorld;
+
+        if (h.worldMatrix(root) != rootWorld)
+            throw std::runtime_error("DoTransformHierarchyTest() : Test 3 Part A failed");
+
+        if (h.worldMatrix(child) != childWorld)
+            throw std::runtime_error("DoTransformHierarchyTest() : Test 3 Part B failed");
+
+        if (h.worldMatrix(grandChild) != grandChildWorld)
+            throw std::runtime_error("DoTransformHierarchyTest() : Test 3 Part C failed");
+
+        if (h.isDirty(root) || h.isDirty(child) || h.isDirty(grandChild))
+            throw std::runtime_error("DoTransformHierarchyTest() : Test 3 Part D failed");
+    }
+
+    // Test 4: Only dirty subtrees are recomputed.
+    {
+        TransformHierarchy h;
+
+        int rootA = h.addNode(TransformHierarchy::NO_PARENT);
+        int rootB = h.addNode(TransformHierarchy::NO_PARENT);
+        int childA = h.addNode(rootA);
+        int childB = h.addNode(rootB);
+
+        h.updateWorldMatrices();
+
+        // (a) Moving root B moves its child but leaves subtree A alone.
+        h.setLocalTranslation(rootB, Vector3(0.0f, 5.0f, 0.0f));
+
+        if (!h.isDirty(rootB) || h.isDirty(childB))
+            throw std::runtime_error("DoTransformHierarchyTest() : Test 4a failed");
+
+        h.updateWorldMatrices();
+
+        if (h.worldMatrix(childB) != Matrix4::createTranslate(0.0f, 5.0f, 0.0f))
+            throw std::runtime_error("DoTransformHierarchyTest() : Test 4b failed");
+
+        if (h.worldMatrix(childA) != Matrix4::IDENTITY)
+            throw std::runtime_error("DoTransformHierarchyTest() : Test 4c failed");
+
+        // (b) A later update of an unrelated node keeps the earlier result.
+        h.setLocalTranslation(childA, Vector3(1.0f, 0.0f, 0.0f));
+        h.updateWorldMatrices();
+
+        if (h.worldMatrix(childB) != Matrix4::createTranslate(0.0f, 5.0f, 0.0f))
+            throw std::runtime_error("DoTransformHierarchyTest() : Test 4d failed");
+
+        if (h.worldMatrix(childA) != Matrix4::createTranslate(1.0f, 0.0f, 0.0f))
+            throw std::runtime_error("DoTransformHierarchyTest() : Test 4e failed");
+    }
+
+    // Test 5: The parallel update matches the sequential update.
+    {
+        const unsigned int nodeCount = 5000;
+        TransformHierarchy sequential(nodeCount);
+        TransformHierarchy parallel(nodeCount);
+        ThreadPool pool(4);
+
+        // A wide tree: four roots and a branching factor of 8. Node i is
+        // parented to node (i - 4) / 8.
+        for (unsigned int i = 0; i < nodeCount; ++i)
+        {
+            int p = (i < 4) ? TransformHierarchy::NO_PARENT : static_cast<int>((i - 4) / 8);
+            Vector3 t(static_cast<float>(i % 7), 0.5f, -static_cast<float>(i % 3));
+            Quaternion r(Vector3(0.0f, 0.0f, 1.0f), static_cast<float>(i % 45));
+            Vector3 s(1.0f, 1.0f + 0.001f * static_cast<float>(i % 5), 1.0f);
+
+            sequential.addNode(p);
+            parallel.addNode(p);
+            sequential.setLocal(static_cast<int>(i), t, r, s);
+            parallel.setLocal(static_cast<int>(i), t, r, s);
+        }
+
+        for (int pass = 0; pass < 2; ++pass)
+        {
+            sequential.updateWorldMatrices();
+            parallel.updateWorldMatrices(pool);
+
+            for (unsigned int i = 0; i < nodeCount; ++i)
+            {
+                if (sequential.worldMatrix(static_cast<int>(i)) != parallel.worldMatrix(static_cast<int>(i)))
+                    throw std::runtime_error("DoTransformHierarchyTest() : Test 5 failed");
+            }
+
+            // Move a node in the middle of the tree for the second pass.
+            sequential.setLocalTranslation(9, Vector3(3.0f, 2.0f, 1.0f));
+            parallel.setLocalTranslation(9, Vector3(3.0f, 2.0f, 1.0f));
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Unit test the CameraRelativeView class. The camera is placed far from the
+// world origin, where float coordinates are spaced 2 units apart, and the
+// scene is made of objects much smaller than that.
+//-----------------------------------------------------------------------------
+
+void DoCameraRelativeViewTest()
+{
+    Vector3d camera(30000000.0, 1000.0, -20000000.0);
+    Matrix4d rotation = Matrix4d::createRotate(Vector3d(0.0, 1.0, 0.0), 30.0);
+    Matrix4d view = Matrix4d::createTranslate(-camera.x, -camera.y, -camera.z)
+        * rotation.transpose();
+
+    // 90 degree field of view, square aspect ratio, looking down the -z
+    // axis.
+    Matrix4 proj = Matrix4::createPerspective(90.0f, 1.0f, 1.0f, 100.0f);
+
+    CameraRelativeView crv(camera, view, proj);
+
+    // Test 1: The camera relative view matrix is the camera's rotation.
+    {
+        Matrix4 expected(rotation.transpose());
+
+        for (int i = 0; i < 4; ++i)
+        {
+            for (int j = 0; j < 4; ++j)
+            {
+                if (fabsf(crv.viewMatrix()[i][j] - expected[i][j]) > 1e-6f)
+                    throw std::runtime_error("DoCameraRelativeViewTest() : Test 1 Part A failed");
+            }
+        }
+
+        if (crv.viewProjMatrix() != crv.viewMatrix() * proj)
+            throw std::runtime_error("DoCameraRelativeViewTest() : Test 1 Part B failed");
+    }
+
+    // Test 2: Points keep their sub-unit offsets from the camera.
+    {
+        Vector3d position = camera + Vector3d(0.25, -0.125, 0.0625);
+        Vector3 relative = crv.toCameraRelative(position);
+
+        if (relative.x != 0.25f || relative.y != -0.125f || relative.z != 0.0625f)
+            throw std::runtime_error("DoCameraRelativeViewTest() : Test 2 failed");
+    }
+
+    // Test 3: Culling small boxes in camera space. A box 5 units in front
+    // of the camera is visible, and the same box 5 units behind it or just
+    // outside the 45 degree left edge is not.
+    {
+        Vector3d forward = Vector3d(0.0, 0.0, -1.0) * rotation;
+        Vector3d left = Vector3d(-1.0, 0.0, 0.0) * rotation;
+        Vector3d extent(0.05, 0.05, 0.05);
+        Vector3d centers[3] =
+        {
+            camera + forward * 5.0,
+            camera - forward * 5.0,
+            camera + forward * 5.0 + left * 5.2
+        };
+        BoundingBoxd boxes[3];
+        BoundingBox relative[3];
+        bool visible[3];
+
+        for (int i = 0; i < 3; ++i)
+            boxes[i] = BoundingBoxd(centers[i] - extent, centers[i] + extent);
+
+        crv.toCameraRelative(boxes, relative, 3);
+        Batch::cullBoxes(crv.frustum(), relative, visible, 3);
+
+        if (!visible[0] || visible[1] || visible[2])
+            throw std::runtime_error("DoCameraRelativeViewTest() : Test 3 Part A failed");
+
+        for (int i = 0; i < 3; ++i)
+        {
+            BoundingBox expected = crv.toCameraRelative(boxes[i]);
+
+            if (relative[i].min != expected.min || relative[i].max != expected.max)
+                throw std::runtime_error("DoCameraRelativeViewTest() : Test 3 Part B failed");
+        }
+    }
+
+    // Test 4: Object transforms. Rendering a rebased object with the camera
+    // relative view matrix puts it in the same place in view space as the
+    // full double precision pipeline does.
+    {
+        Matrix4 local = Matrix4::createRotate(Vector3(0.0f, 0.0f, 1.0f), 45.0f)
+            * Matrix4::createTranslate(0.5f, 0.0f, 0.0f);
+        Vector3d position = camera + Vector3d(1.5, 2.25, -10.75);
+        Matrix4 world;
+
+        crv.toCameraRelative(&local, &position, &world, 1);
+
+        Vector3d corner(0.25, 0.25, 0.25);
+        Vector4d expected = Vector4d(corner.x, corner.y, corner.z, 1.0)
+            * (Matrix4d(local) * Matrix4d::createTranslate(position.x, position.y, position.z) * view);
+        Vector4 result = Vector4(0.25f, 0.25f, 0.25f, 1.0f) * (world * crv.viewMatrix());
+
+        if (fabs(result.x - expected.x) > 1e-4 || fabs(result.y - expected.y) > 1e-4
+            || fabs(result.z - expected.z) > 1e-4)
+            throw std::runtime_error("DoCameraRelativeViewTest() : Test 4 failed");
+    }
+}
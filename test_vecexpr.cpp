@@ -0,0 +1,218 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2026 dhpoware. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include <cmath>
+#include <vector>
+
+#include "test_main.h"
+#include "vecexpr.h"
+
+void TestMathVecExpr();
+void DoVecExprTest();
+
+//-----------------------------------------------------------------------------
+// Tests the Vector3 array expression templates.
+//-----------------------------------------------------------------------------
+
+void TestMathVecExpr()
+{
+    DoVecExprTest();
+}
+
+//-----------------------------------------------------------------------------
+// Unit test the Vector3 array expressions. Each expression is compared
+// against the same computation done one Vector3 at a time.
+//-----------------------------------------------------------------------------
+
+static bool isClose(const Vector3 &result, const Vector3 &expected)
+{
+    // The compiler may contract the fused expressions into multiply-adds,
+    // so allow for differences in the last bits.
+    return fabsf(result.x - expected.x) <= 1e-5f * (1.0f + fabsf(expected.x))
+        && fabsf(result.y - expected.y) <= 1e-5f * (1.0f + fabsf(expected.y))
+        && fabsf(result.z - expected.z) <= 1e-5f * (1.0f + fabsf(expected.z));
+}
+
+void DoVecExprTest()
+{
+    const unsigned int count = 257;
+    Random rng(38);
+    std::vector<Vector3> a(count), b(count), c(count), result(count);
+    std::vector<float> w(count);
+
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        a[i] = rng.inBox(Vector3(-10.0f, -10.0f, -10.0f), Vector3(10.0f, 10.0f, 10.0f));
+        b[i] = rng.inBox(Vector3(-10.0f, -10.0f, -10.0f), Vector3(10.0f, 10.0f, 10.0f));
+        c[i] = rng.inBox(Vector3(-10.0f, -10.0f, -10.0f), Vector3(10.0f, 10.0f, 10.0f));
+        w[i] = rng.nextFloat();
+    }
+
+    ConstVector3Array<float> va(&a[0]), vb(&b[0]), vc(&c[0]);
+    ScalarArray<float> sw(&w[0]);
+    Vector3Array<float> r(&result[0], count);
+
+    // Test 1: Sums, differences and negation.
+    {
+        r = va + vb - vc;
+
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            if (!isClose(result[i], a[i] + b[i] - c[i]))
+            {
+                PrintVectors(result[i], a[i] + b[i] - c[i]);
+                throw std::runtime_error("DoVecExprTest() : Test 1 Part A failed");
+            }
+        }
+
+        Vector3 offset(1.0f, -2.0f, 3.0f);
+        r = -(offset - va) + offset;
+
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            if (!isClose(result[i], -(offset - a[i]) + offset))
+                throw std::runtime_error("DoVecExprTest() : Test 1 Part B failed");
+        }
+    }
+
+    // Test 2: Scaling by a scalar and by per-element scalars.
+    {
+        r = va * 0.5f + 2.0f * vb;
+
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            if (!isClose(result[i], a[i] * 0.5f + 2.0f * b[i]))
+                throw std::runtime_error("DoVecExprTest() : Test 2 Part A failed");
+        }
+
+        // Blending with per-element weights.
+        std::vector<float> w1(count);
+
+        for (unsigned int i = 0; i < count; ++i)
+            w1[i] = 1.0f - w[i];
+
+        r = va * sw + ScalarArray<float>(&w1[0]) * vb;
+
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            if (!isClose(result[i], a[i] * w[i] + b[i] * w1[i]))
+                throw std::runtime_error("DoVecExprTest() : Test 2 Part B failed");
+        }
+    }
+
+    // Test 3: Updating in place.
+    {
+        std::vector<Vector3> positions(a), velocities(b);
+        Vector3Array<float> p(&positions[0], count);
+        ConstVector3Array<float> v(&velocities[0]);
+        Vector3 gravity(0.0f, -9.8f, 0.0f);
+        float dt = 1.0f / 60.0f;
+
+        p += v * dt + gravity * (0.5f * dt * dt);
+
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            if (!isClose(positions[i], a[i] + (b[i] * dt + gravity * (0.5f * dt * dt))))
+                throw std::runtime_error("DoVecExprTest() : Test 3 Part A failed");
+        }
+
+        // The destination as an operand.
+        p = (p - va) * 2.0f;
+        p -= vb;
+        p *= sw;
+
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            Vector3 expected = ((b[i] * dt + gravity * (0.5f * dt * dt)) * 2.0f - b[i]) * w[i];
+
+            if (!isClose(positions[i], expected))
+            {
+                PrintVectors(positions[i], expected);
+                throw std::runtime_error("DoVecExprTest() : Test 3 Part B failed");
+            }
+        }
+
+        // Only the first count() elements are written.
+        Vector3Array<float> partial(&positions[0], 10);
+        partial = Vector3Array<float>(&positions[0], 10) * 0.0f + Vector3(1.0f, 1.0f, 1.0f);
+
+        if (positions[9] != Vector3(1.0f, 1.0f, 1.0f) || positions[10] == Vector3(1.0f, 1.0f, 1.0f))
+            throw std::runtime_error("DoVecExprTest() : Test 3 Part C failed");
+    }
+
+    // Test 4: Transforming by matrices.
+    {
+        Matrix4 m = Matrix4::createScale(2.0f, 3.0f, 4.0f) * Matrix4::createTranslate(1.0f, 2.0f, 3.0f);
+        Matrix3 m3 = Matrix3::createScale(2.0f, 3.0f, 4.0f);
+
+        r = va * m;
+
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            if (!isClose(result[i], a[i] * m))
+                throw std::runtime_error("DoVecExprTest() : Test 4 Part A failed");
+        }
+
+        r = (va + vb) * m3;
+
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            if (!isClose(result[i], (a[i] + b[i]) * m3))
+                throw std::runtime_error("DoVecExprTest() : Test 4 Part B failed");
+        }
+
+        // transformPoints() applies the translation.
+        r = transformPoints(m, va) * sw + transformPoints(m, vb) * 0.25f;
+
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            Vector3 pa(a[i].x * 2.0f + 1.0f, a[i].y * 3.0f + 2.0f, a[i].z * 4.0f + 3.0f);
+            Vector3 pb(b[i].x * 2.0f + 1.0f, b[i].y * 3.0f + 2.0f, b[i].z * 4.0f + 3.0f);
+
+            if (!isClose(result[i], pa * w[i] + pb * 0.25f))
+            {
+                PrintVectors(result[i], pa * w[i] + pb * 0.25f);
+                throw std::runtime_error("DoVecExprTest() : Test 4 Part C failed");
+            }
+        }
+    }
+
+    // Test 5: Assigning one array to another copies the elements into the
+    // target's own buffer.
+    {
+        std::vector<Vector3> copy(count);
+        Vector3Array<float> target(&copy[0], count), source(&b[0], count);
+
+        target = source;
+
+        if (target.data() != &copy[0] || source.data() != &b[0] || copy != b)
+            throw std::runtime_error("DoVecExprTest() : Test 5 Part A failed");
+
+        // Changing the source afterwards leaves the copy alone.
+        Vector3 first = b[0];
+
+        b[0] = b[0] + Vector3(1.0f, 1.0f, 1.0f);
+
+        if (copy[0] != first)
+            throw std::runtime_error("DoVecExprTest() : Test 5 Part B failed");
+    }
+}
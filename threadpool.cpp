@@ -0,0 +1,149 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2026 dhpoware. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "threadpool.h"
+
+//-----------------------------------------------------------------------------
+// ThreadPool.
+
+ThreadPool::ThreadPool()
+{
+    // One thread per hardware thread. The calling thread counts as one.
+    unsigned int threads = std::thread::hardware_concurrency();
+    init((threads > 0) ? threads : 1);
+}
+
+ThreadPool::ThreadPool(unsigned int threadCount)
+{
+    init((threadCount > 0) ? threadCount : 1);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_quit = true;
+    }
+
+    m_wake.notify_all();
+
+    for (size_t i = 0; i < m_workers.size(); ++i)
+        m_workers[i].join();
+}
+
+void ThreadPool::parallelFor(unsigned int count, unsigned int grainSize, const RangeFunction &fn)
+{
+    if (count == 0)
+        return;
+
+    if (grainSize == 0)
+        grainSize = 1;
+
+    if (m_workers.empty() || count <= grainSize)
+    {
+        fn(0, count);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        m_pJob = &fn;
+        m_count = count;
+        m_grainSize = grainSize;
+        m_next.store(0);
+        m_active = static_cast<unsigned int>(m_workers.size());
+        ++m_generation;
+    }
+
+    m_wake.notify_all();
+    runChunks();
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    while (m_active != 0)
+        m_done.wait(lock);
+
+    m_pJob = 0;
+}
+
+unsigned int ThreadPool::threadCount() const
+{
+    return static_cast<unsigned int>(m_workers.size()) + 1;
+}
+
+void ThreadPool::init(unsigned int threadCount)
+{
+    m_next.store(0);
+    m_pJob = 0;
+    m_count = 0;
+    m_grainSize = 1;
+    m_active = 0;
+    m_generation = 0;
+    m_quit = false;
+
+    for (unsigned int i = 1; i < threadCount; ++i)
+        m_workers.push_back(std::thread(&ThreadPool::workerMain, this));
+}
+
+void ThreadPool::runChunks()
+{
+    for (;;)
+    {
+        unsigned int begin = m_next.fetch_add(m_grainSize);
+
+        if (begin >= m_count)
+            break;
+
+        unsigned int end = (m_count - begin > m_grainSize) ? begin + m_grainSize : m_count;
+        (*m_pJob)(begin, end);
+    }
+}
+
+void ThreadPool::workerMain()
+{
+    unsigned int generation = 0;
+
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+
+            while (!m_quit && m_generation == generation)
+                m_wake.wait(lock);
+
+            if (m_quit)
+                return;
+
+            generation = m_generation;
+        }
+
+        runChunks();
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            if (--m_active == 0)
+                m_done.notify_one();
+        }
+    }
+}
@@ -0,0 +1,82 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2026 dhpoware. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#if !defined(THREADPOOL_H)
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//-----------------------------------------------------------------------------
+// The ThreadPool utility class keeps a fixed set of worker threads alive so
+// that data parallel loops don't pay for thread creation.
+//
+// parallelFor() splits the index range [0,count) into chunks of 'grainSize'
+// indices and calls 'fn(begin, end)' once per chunk. The calling thread
+// works on chunks too, and parallelFor() returns once every chunk has been
+// processed. Ranges no larger than one chunk run directly on the calling
+// thread. parallelFor() must not be called from more than one thread at a
+// time, nor from inside 'fn'.
+//
+// threadCount() returns the number of threads that take part in a
+// parallelFor() call, including the calling thread.
+
+class ThreadPool
+{
+public:
+    typedef std::function<void(unsigned int begin, unsigned int end)> RangeFunction;
+
+    ThreadPool();
+    ThreadPool(unsigned int threadCount);
+    ~ThreadPool();
+
+    void parallelFor(unsigned int count, unsigned int grainSize, const RangeFunction &fn);
+    unsigned int threadCount() const;
+
+private:
+    ThreadPool(const ThreadPool &);
+    ThreadPool &operator=(const ThreadPool &);
+
+    void init(unsigned int threadCount);
+    void runChunks();
+    void workerMain();
+
+    std::vector<std::thread> m_workers;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    std::atomic<unsigned int> m_next;
+    const RangeFunction *m_pJob;
+    unsigned int m_count;
+    unsigned int m_grainSize;
+    unsigned int m_active;
+    unsigned int m_generation;
+    bool m_quit;
+};
+
+//-----------------------------------------------------------------------------
+
+#endif
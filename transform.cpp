@@ -0,0 +1,429 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2026 dhpoware. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "batch.h"
+#include "threadpool.h"
+#include "transform.h"
+
+#if defined(MATHLIB_SSE)
+#include <xmmintrin.h>
+#endif
+
+static void multiply(const Matrix4 &lhs, const Matrix4 &rhs, Matrix4 &result)
+{
+    // result = lhs * rhs. Each row of the result is a linear combination of
+    // the rows of 'rhs', which maps directly onto 4-wide SIMD operations.
+    // 'result' must not alias 'rhs'.
+
+#if defined(MATHLIB_SSE)
+    __m128 r0 = _mm_loadu_ps(rhs[0]);
+    __m128 r1 = _mm_loadu_ps(rhs[1]);
+    __m128 r2 = _mm_loadu_ps(rhs[2]);
+    __m128 r3 = _mm_loadu_ps(rhs[3]);
+
+    for (int i = 0; i < 4; ++i)
+    {
+        const float *row = lhs[i];
+        __m128 v = _mm_mul_ps(_mm_set1_ps(row[0]), r0);
+
+        v = _mm_add_ps(v, _mm_mul_ps(_mm_set1_ps(row[1]), r1));
+        v = _mm_add_ps(v, _mm_mul_ps(_mm_set1_ps(row[2]), r2));
+        v = _mm_add_ps(v, _mm_mul_ps(_mm_set1_ps(row[3]), r3));
+        _mm_storeu_ps(result[i], v);
+    }
+#else
+    result = lhs * rhs;
+#endif
+}
+
+static void composeTRS(const Vector3 &t, const Quaternion &r, const Vector3 &s, Matrix4 &m)
+{
+    // Builds the local transform matrix M = S * R * T. Vectors are
+    // multiplied to the left of the matrix, so the scale is applied
+    // first, then the rotation, then the translation.
+    //
+    //     | sx * R0      0 |
+    // M = | sy * R1      0 |
+    //     | sz * R2      0 |
+    //     | tx  ty  tz   1 |
+
+    m = r.toMatrix4();
+
+    m[0][0] *= s.x, m[0][1] *= s.x, m[0][2] *= s.x;
+    m[1][0] *= s.y, m[1][1] *= s.y, m[1][2] *= s.y;
+    m[2][0] *= s.z, m[2][1] *= s.z, m[2][2] *= s.z;
+    m[3][0] = t.x,  m[3][1] = t.y,  m[3][2] = t.z;
+}
+
+//-----------------------------------------------------------------------------
+// CameraRelativeView.
+
+CameraRelativeView::CameraRelativeView()
+{
+    set(Vector3d(0.0, 0.0, 0.0), Matrix4d::IDENTITY, Matrix4::IDENTITY);
+}
+
+CameraRelativeView::CameraRelativeView(const Vector3d &cameraPosition, const Matrix4d &viewMatrix, const Matrix4 &projMatrix)
+{
+    set(cameraPosition, viewMatrix, projMatrix);
+}
+
+CameraRelativeView::~CameraRelativeView()
+{
+}
+
+const Vector3d &CameraRelativeView::cameraPosition() const
+{
+    return m_cameraPosition;
+}
+
+const Frustum &CameraRelativeView::frustum() const
+{
+    return m_frustum;
+}
+
+const Matrix4 &CameraRelativeView::projMatrix() const
+{
+    return m_projMatrix;
+}
+
+void CameraRelativeView::set(const Vector3d &cameraPosition, const Matrix4d &viewMatrix, const Matrix4 &projMatrix)
+{
+    // Translating by the camera position first and then applying the world
+    // space view matrix gives the view matrix of a camera at the origin.
+    // The large translations cancel in double precision, so the float
+    // result is as precise as if the whole world were near the origin.
+
+    Matrix4d relativeView = Matrix4d::createTranslate(cameraPosition.x,
+        cameraPosition.y, cameraPosition.z) * viewMatrix;
+
+    m_cameraPosition = cameraPosition;
+    m_viewMatrix = Matrix4(relativeView);
+    m_projMatrix = projMatrix;
+    m_viewProjMatrix = m_viewMatrix * m_projMatrix;
+    m_frustum.extractPlanes(m_viewProjMatrix);
+}
+
+Vector3 CameraRelativeView::toCameraRelative(const Vector3d &position) const
+{
+    return Vector3(position - m_cameraPosition);
+}
+
+BoundingBox CameraRelativeView::toCameraRelative(const BoundingBoxd &box) const
+{
+    return BoundingBox(toCameraRelative(box.min), toCameraRelative(box.max));
+}
+
+void CameraRelativeView::toCameraRelative(const BoundingBoxd *boxes, BoundingBox *result, unsigned int count) const
+{
+    // A box is a pair of points, min followed by max, so the arrays of
+    // boxes are rebased as arrays of twice as many points.
+
+    static_assert(sizeof(BoundingBoxd) == 6 * sizeof(double), "BoundingBoxd must be 6 packed doubles");
+    static_assert(sizeof(BoundingBox) == 6 * sizeof(float), "BoundingBox must be 6 packed floats");
+
+    Batch::rebasePoints(m_cameraPosition, &boxes[0].min,
+        &result[0].min, count * 2);
+}
+
+void CameraRelativeView::toCameraRelative(const Matrix4 *matrices, const Vector3d *positions, Matrix4 *result, unsigned int count) const
+{
+    Batch::rebaseMatrices(m_cameraPosition, matrices, positions, result, count);
+}
+
+const Matrix4 &CameraRelativeView::viewMatrix() const
+{
+    return m_viewMatrix;
+}
+
+const Matrix4 &CameraRelativeView::viewProjMatrix() const
+{
+    return m_viewProjMatrix;
+}
+
+//-----------------------------------------------------------------------------
+// TransformHierarchy.
+
+TransformHierarchy::TransformHierarchy()
+{
+    init(DEFAULT_MAX_NODES);
+}
+
+TransformHierarchy::TransformHierarchy(unsigned int maxNodes)
+{
+    init(maxNodes);
+}
+
+TransformHierarchy::~TransformHierarchy()
+{
+    delete [] m_pParents;
+    delete [] m_pTranslations;
+    delete [] m_pRotations;
+    delete [] m_pScales;
+    delete [] m_pWorld;
+    delete [] m_pFlags;
+    delete [] m_pDepths;
+    delete [] m_pLevelOrder;
+    delete [] m_pLevelStart;
+}
+
+int TransformHierarchy::addNode(int parent)
+{
+    if (m_count >= m_maxNodes)
+        return NO_PARENT;
+
+    if (parent != NO_PARENT && (parent < 0 || parent >= static_cast<int>(m_count)))
+        return NO_PARENT;
+
+    int node = static_cast<int>(m_count++);
+
+    m_pParents[node] = parent;
+    m_pTranslations[node].set(0.0f, 0.0f, 0.0f);
+    m_pRotations[node].identity();
+    m_pScales[node].set(1.0f, 1.0f, 1.0f);
+    m_pWorld[node].identity();
+    m_pFlags[node] = 0;
+    markDirty(node);
+    m_levelsValid = false;
+
+    return node;
+}
+
+void TransformHierarchy::clear()
+{
+    m_count = 0;
+    m_firstDirty = m_maxNodes;
+    m_levelsValid = false;
+}
+
+bool TransformHierarchy::isDirty(int node) const
+{
+    return (m_pFlags[node] & FLAG_DIRTY) != 0;
+}
+
+const Quaternion &TransformHierarchy::localRotation(int node) const
+{
+    return m_pRotations[node];
+}
+
+const Vector3 &TransformHierarchy::localScale(int node) const
+{
+    return m_pScales[node];
+}
+
+const Vector3 &TransformHierarchy::localTranslation(int node) const
+{
+    return m_pTranslations[node];
+}
+
+unsigned int TransformHierarchy::maxNodes() const
+{
+    return m_maxNodes;
+}
+
+unsigned int TransformHierarchy::nodeCount() const
+{
+    return m_count;
+}
+
+int TransformHierarchy::parent(int node) const
+{
+    return m_pParents[node];
+}
+
+void TransformHierarchy::setLocal(int node, const Vector3 &translation, const Quaternion &rotation, const Vector3 &scale)
+{
+    m_pTranslations[node] = translation;
+    m_pRotations[node] = rotation;
+    m_pScales[node] = scale;
+    markDirty(node);
+}
+
+void TransformHierarchy::setLocalRotation(int node, const Quaternion &rotation)
+{
+    m_pRotations[node] = rotation;
+    markDirty(node);
+}
+
+void TransformHierarchy::setLocalScale(int node, const Vector3 &scale)
+{
+    m_pScales[node] = scale;
+    markDirty(node);
+}
+
+void TransformHierarchy::setLocalTranslation(int node, const Vector3 &translation)
+{
+    m_pTranslations[node] = translation;
+    markDirty(node);
+}
+
+void TransformHierarchy::updateWorldMatrices()
+{
+    // Because parents always precede their children a single forward pass
+    // is enough to propagate changes down the tree. A node's world matrix
+    // is recomputed when the node itself is dirty or when its parent's
+    // world matrix was recomputed earlier in this pass. The pass starts at
+    // the first dirty node since nothing before it can have changed.
+
+    unsigned int first = m_firstDirty;
+
+    for (unsigned int i = first; i < m_count; ++i)
+        updateNode(i, first);
+
+    m_firstDirty = m_maxNodes;
+}
+
+void TransformHierarchy::updateWorldMatrices(ThreadPool &pool)
+{
+    // Every node of a level depends only on nodes of the previous level, so
+    // the nodes within a level can be updated in any order and on any
+    // thread. parallelFor() returns once the whole level is done, which
+    // makes the parent results visible to the next level.
+
+    unsigned int first = m_firstDirty;
+
+    if (first >= m_count)
+        return;
+
+    if (!m_levelsValid)
+        buildLevels();
+
+    for (unsigned int level = 0; level < m_levelCount; ++level)
+    {
+        const unsigned int *pNodes = m_pLevelOrder + m_pLevelStart[level];
+        unsigned int count = m_pLevelStart[level + 1] - m_pLevelStart[level];
+
+        pool.parallelFor(count, PARALLEL_GRAIN_SIZE,
+            [this, pNodes, first](unsigned int begin, unsigned int end)
+            {
+                for (unsigned int i = begin; i < end; ++i)
+                    updateNode(pNodes[i], first);
+            });
+    }
+
+    m_firstDirty = m_maxNodes;
+}
+
+const Matrix4 &TransformHierarchy::worldMatrix(int node) const
+{
+    return m_pWorld[node];
+}
+
+const Matrix4 *TransformHierarchy::worldMatrices() const
+{
+    return m_pWorld;
+}
+
+void TransformHierarchy::buildLevels()
+{
+    // Sorts the node indices by depth using a counting sort. Parents
+    // precede their children so the depths can be found in one pass.
+
+    m_levelCount = 0;
+
+    for (unsigned int i = 0; i < m_count; ++i)
+    {
+        int p = m_pParents[i];
+        m_pDepths[i] = (p == NO_PARENT) ? 0 : m_pDepths[p] + 1;
+
+        if (m_pDepths[i] + 1 > m_levelCount)
+            m_levelCount = m_pDepths[i] + 1;
+    }
+
+    for (unsigned int level = 0; level <= m_levelCount; ++level)
+        m_pLevelStart[level] = 0;
+
+    for (unsigned int i = 0; i < m_count; ++i)
+        ++m_pLevelStart[m_pDepths[i] + 1];
+
+    for (unsigned int level = 1; level <= m_levelCount; ++level)
+        m_pLevelStart[level] += m_pLevelStart[level - 1];
+
+    // Use the level start offsets as insertion cursors, then shift them
+    // back into place afterwards.
+
+    for (unsigned int i = 0; i < m_count; ++i)
+        m_pLevelOrder[m_pLevelStart[m_pDepths[i]]++] = i;
+
+    for (unsigned int level = m_levelCount; level > 0; --level)
+        m_pLevelStart[level] = m_pLevelStart[level - 1];
+
+    m_pLevelStart[0] = 0;
+    m_levelsValid = true;
+}
+
+void TransformHierarchy::init(unsigned int maxNodes)
+{
+    m_maxNodes = maxNodes;
+    m_count = 0;
+    m_firstDirty = maxNodes;
+    m_levelCount = 0;
+    m_levelsValid = false;
+
+    m_pParents = new int[maxNodes];
+    m_pTranslations = new Vector3[maxNodes];
+    m_pRotations = new Quaternion[maxNodes];
+    m_pScales = new Vector3[maxNodes];
+    m_pWorld = new Matrix4[maxNodes];
+    m_pFlags = new unsigned char[maxNodes];
+    m_pDepths = new unsigned int[maxNodes];
+    m_pLevelOrder = new unsigned int[maxNodes];
+    m_pLevelStart = new unsigned int[maxNodes + 1];
+}
+
+void TransformHierarchy::markDirty(int node)
+{
+    m_pFlags[node] |= FLAG_DIRTY;
+
+    if (static_cast<unsigned int>(node) < m_firstDirty)
+        m_firstDirty = static_cast<unsigned int>(node);
+}
+
+void TransformHierarchy::updateNode(unsigned int node, unsigned int firstDirty)
+{
+    // Recomputes the world matrix of 'node' if the node is dirty or if its
+    // parent's world matrix was recomputed during the current update.
+    // Parents with an index below 'firstDirty' cannot have changed during
+    // the current update, and their FLAG_WORLD_CHANGED bit may be left over
+    // from an earlier one, so it is not consulted.
+
+    int p = m_pParents[node];
+    bool parentChanged = (p >= static_cast<int>(firstDirty))
+        && (m_pFlags[p] & FLAG_WORLD_CHANGED);
+
+    if ((m_pFlags[node] & FLAG_DIRTY) || parentChanged)
+    {
+        Matrix4 local;
+        composeTRS(m_pTranslations[node], m_pRotations[node], m_pScales[node], local);
+
+        if (p == NO_PARENT)
+            m_pWorld[node] = local;
+        else
+            multiply(local, m_pWorld[p], m_pWorld[node]);
+
+        m_pFlags[node] = FLAG_WORLD_CHANGED;
+    }
+    else
+    {
+        m_pFlags[node] = 0;
+    }
+}
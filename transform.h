@@ -0,0 +1,164 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2026 dhpoware. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#if !defined(TRANSFORM_H)
+#define TRANSFORM_H
+
+#include "mathlib.h"
+#include "collision.h"
+
+class ThreadPool;
+
+//-----------------------------------------------------------------------------
+// The CameraRelativeView class keeps float culling and rendering precise in
+// worlds that are too large for float coordinates. Far from the origin the
+// spacing between floats grows (about 1 unit at 1.6e7), so positions jitter
+// and the frustum planes lose the precision needed to cull reliably.
+//
+// The camera and the object positions are stored in double precision
+// (Vector3d). Everything that reaches the float code is first rebased onto
+// the camera position, so its coordinates stay small near the viewer:
+//
+//  - viewMatrix() is the view matrix with the camera moved to the origin,
+//    computed in double precision from the world space view matrix.
+//  - frustum() holds the frustum planes extracted from that view matrix, so
+//    they are in camera relative space.
+//  - toCameraRelative() rebases double precision points, boxes and object
+//    transforms to camera relative floats. The array versions use the Batch
+//    kernels since they run for every object each frame.
+//
+// A typical frame rebases the world space boxes of the objects, culls them
+// against frustum() with Batch::cullBoxes(), and then rebases the transforms
+// of the visible objects for rendering with viewMatrix() and projMatrix().
+
+class CameraRelativeView
+{
+public:
+    CameraRelativeView();
+    CameraRelativeView(const Vector3d &cameraPosition, const Matrix4d &viewMatrix, const Matrix4 &projMatrix);
+    ~CameraRelativeView();
+
+    const Vector3d &cameraPosition() const;
+    const Frustum &frustum() const;
+    const Matrix4 &projMatrix() const;
+    void set(const Vector3d &cameraPosition, const Matrix4d &viewMatrix, const Matrix4 &projMatrix);
+    Vector3 toCameraRelative(const Vector3d &position) const;
+    BoundingBox toCameraRelative(const BoundingBoxd &box) const;
+    void toCameraRelative(const BoundingBoxd *boxes, BoundingBox *result, unsigned int count) const;
+    void toCameraRelative(const Matrix4 *matrices, const Vector3d *positions, Matrix4 *result, unsigned int count) const;
+    const Matrix4 &viewMatrix() const;
+    const Matrix4 &viewProjMatrix() const;
+
+private:
+    Vector3d m_cameraPosition;
+    Matrix4 m_viewMatrix;
+    Matrix4 m_projMatrix;
+    Matrix4 m_viewProjMatrix;
+    Frustum m_frustum;
+};
+
+//-----------------------------------------------------------------------------
+// The TransformHierarchy class stores a tree of transforms in flat arrays.
+// Nodes are kept in parent-index order: a node's parent is always added
+// before the node itself, so every parent index is less than the index of
+// its children. Each node has a local translation, rotation and scale (TRS)
+// and a cached world matrix.
+//
+// Changing a node's local transform marks the node dirty.
+// updateWorldMatrices() recomputes the world matrices of the dirty nodes and
+// all of their descendants in a single linear pass over the arrays. Nodes in
+// clean subtrees keep their cached world matrix.
+//
+// updateWorldMatrices(pool) produces the same result using a ThreadPool. The
+// nodes are grouped by depth (breadth order) and each depth level is split
+// into chunks that are updated in parallel, one level after another. This
+// scales with the width of the levels, so it pays off for wide hierarchies
+// such as many objects parented to a few roots. The grouping is cached and
+// only rebuilt after nodes have been added or the hierarchy cleared.
+//
+// addNode() returns the index of the new node, or NO_PARENT if the node
+// could not be added (the hierarchy is full or the parent index is invalid).
+
+class TransformHierarchy
+{
+public:
+    static const int NO_PARENT = -1;
+    static const unsigned int DEFAULT_MAX_NODES = 1024;
+
+    TransformHierarchy();
+    TransformHierarchy(unsigned int maxNodes);
+    ~TransformHierarchy();
+
+    int addNode(int parent);
+    void clear();
+    bool isDirty(int node) const;
+    const Quaternion &localRotation(int node) const;
+    const Vector3 &localScale(int node) const;
+    const Vector3 &localTranslation(int node) const;
+    unsigned int maxNodes() const;
+    unsigned int nodeCount() const;
+    int parent(int node) const;
+    void setLocal(int node, const Vector3 &translation, const Quaternion &rotation, const Vector3 &scale);
+    void setLocalRotation(int node, const Quaternion &rotation);
+    void setLocalScale(int node, const Vector3 &scale);
+    void setLocalTranslation(int node, const Vector3 &translation);
+    void updateWorldMatrices();
+    void updateWorldMatrices(ThreadPool &pool);
+    const Matrix4 &worldMatrix(int node) const;
+    const Matrix4 *worldMatrices() const;
+
+private:
+    enum
+    {
+        FLAG_DIRTY         = 1,
+        FLAG_WORLD_CHANGED = 2
+    };
+
+    static const unsigned int PARALLEL_GRAIN_SIZE = 256;
+
+    TransformHierarchy(const TransformHierarchy &);
+    TransformHierarchy &operator=(const TransformHierarchy &);
+
+    void buildLevels();
+    void init(unsigned int maxNodes);
+    void markDirty(int node);
+    void updateNode(unsigned int node, unsigned int firstDirty);
+
+    int *m_pParents;
+    Vector3 *m_pTranslations;
+    Quaternion *m_pRotations;
+    Vector3 *m_pScales;
+    Matrix4 *m_pWorld;
+    unsigned char *m_pFlags;
+    unsigned int *m_pDepths;
+    unsigned int *m_pLevelOrder;
+    unsigned int *m_pLevelStart;
+    unsigned int m_count;
+    unsigned int m_maxNodes;
+    unsigned int m_firstDirty;
+    unsigned int m_levelCount;
+    bool m_levelsValid;
+};
+
+//-----------------------------------------------------------------------------
+
+#endif
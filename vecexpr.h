@@ -0,0 +1,435 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2026 dhpoware. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#if !defined(VECEXPR_H)
+#define VECEXPR_H
+
+#include "mathlib.h"
+
+//-----------------------------------------------------------------------------
+// Expression templates for arrays of Vector3.
+//
+// Writing an array operation one Vector3 operator at a time, e.g.
+//
+//  for each i: tmp[i] = velocities[i] * dt;
+//  for each i: positions[i] = positions[i] + tmp[i];
+//
+// stores every intermediate result in a whole array and reads it back. With
+// the classes below the operators build an expression object instead, and
+// nothing is computed until the expression is assigned to a Vector3Array.
+// The assignment then runs a single loop that evaluates the whole expression
+// for one element at a time, so intermediates stay in registers and each
+// component becomes one multiply-add chain the compiler can vectorize and
+// contract into fused multiply-adds where it is allowed to:
+//
+//  Vector3Array<float> p(positions, count);
+//  ConstVector3Array<float> v(velocities);
+//
+//  p += v * dt;                                    // particle update
+//  p = ConstVector3Array<float>(a) * ScalarArray<float>(w0)
+//    + ConstVector3Array<float>(b) * ScalarArray<float>(w1);   // blending
+//
+// The expressions support +, - and unary - between expressions and single
+// Vector3s, * by a scalar or by a ScalarArray of per-element scalars, * by a
+// Matrix3 or Matrix4 (as Vector3 * Matrix4, so the translation is ignored)
+// and transformPoints() (which applies the translation, as the Batch
+// version does).
+//
+// The operand arrays are not sized: only the destination knows the element
+// count, and every operand must hold at least that many elements. Element i
+// of the result only depends on element i of the operands, so the
+// destination may also appear as an operand. Expressions hold copies of
+// their operands (the array classes are just pointers), so they can be
+// stored and assigned later, as long as the arrays still exist.
+//
+// This header is optional. The library itself doesn't use it.
+
+template <typename T, typename E>
+class Vector3Expr
+{
+public:
+    const E &self() const;
+};
+
+template <typename T, typename E>
+inline const E &Vector3Expr<T, E>::self() const
+{
+    return static_cast<const E &>(*this);
+}
+
+//-----------------------------------------------------------------------------
+// Operand arrays.
+
+template <typename T>
+class ConstVector3Array : public Vector3Expr<T, ConstVector3Array<T> >
+{
+public:
+    explicit ConstVector3Array(const Vector3T<T> *pVectors);
+
+    const Vector3T<T> &operator[](unsigned int i) const;
+
+private:
+    const Vector3T<T> *m_pVectors;
+};
+
+template <typename T>
+inline ConstVector3Array<T>::ConstVector3Array(const Vector3T<T> *pVectors) : m_pVectors(pVectors)
+{
+}
+
+template <typename T>
+inline const Vector3T<T> &ConstVector3Array<T>::operator[](unsigned int i) const
+{
+    return m_pVectors[i];
+}
+
+//-----------------------------------------------------------------------------
+
+template <typename T>
+class ScalarArray
+{
+public:
+    explicit ScalarArray(const T *pScalars);
+
+    T operator[](unsigned int i) const;
+
+private:
+    const T *m_pScalars;
+};
+
+template <typename T>
+inline ScalarArray<T>::ScalarArray(const T *pScalars) : m_pScalars(pScalars)
+{
+}
+
+template <typename T>
+inline T ScalarArray<T>::operator[](unsigned int i) const
+{
+    return m_pScalars[i];
+}
+
+//-----------------------------------------------------------------------------
+// Destination array. Assigning an expression evaluates it for elements
+// 0 to count() - 1. A Vector3Array can be an operand too. Assigning one
+// Vector3Array to another copies the elements; copy construction makes a
+// second view of the same vectors.
+
+template <typename T>
+class Vector3Array : public Vector3Expr<T, Vector3Array<T> >
+{
+public:
+    Vector3Array(Vector3T<T> *pVectors, unsigned int count);
+    Vector3Array(const Vector3Array &other);
+
+    Vector3Array &operator=(const Vector3Array &rhs);
+    template <typename E> Vector3Array &operator=(const Vector3Expr<T, E> &expr);
+    template <typename E> Vector3Array &operator+=(const Vector3Expr<T, E> &expr);
+    template <typename E> Vector3Array &operator-=(const Vector3Expr<T, E> &expr);
+    template <typename E> Vector3Array &operator*=(const E &scalar);
+
+    const Vector3T<T> &operator[](unsigned int i) const;
+
+    unsigned int count() const;
+    Vector3T<T> *data() const;
+
+private:
+    Vector3T<T> *m_pVectors;
+    unsigned int m_count;
+};
+
+template <typename T>
+inline Vector3Array<T>::Vector3Array(Vector3T<T> *pVectors, unsigned int count)
+    : m_pVectors(pVectors), m_count(count)
+{
+}
+
+template <typename T>
+inline Vector3Array<T>::Vector3Array(const Vector3Array &other)
+    : Vector3Expr<T, Vector3Array<T> >(), m_pVectors(other.m_pVectors), m_count(other.m_count)
+{
+}
+
+template <typename T>
+inline Vector3Array<T> &Vector3Array<T>::operator=(const Vector3Array &rhs)
+{
+    return *this = static_cast<const Vector3Expr<T, Vector3Array<T> > &>(rhs);
+}
+
+template <typename T>
+template <typename E>
+inline Vector3Array<T> &Vector3Array<T>::operator=(const Vector3Expr<T, E> &expr)
+{
+    const E &e = expr.self();
+
+    for (unsigned int i = 0; i < m_count; ++i)
+        m_pVectors[i] = e[i];
+
+    return *this;
+}
+
+template <typename T>
+template <typename E>
+inline Vector3Array<T> &Vector3Array<T>::operator+=(const Vector3Expr<T, E> &expr)
+{
+    const E &e = expr.self();
+
+    for (unsigned int i = 0; i < m_count; ++i)
+        m_pVectors[i] = m_pVectors[i] + e[i];
+
+    return *this;
+}
+
+template <typename T>
+template <typename E>
+inline Vector3Array<T> &Vector3Array<T>::operator-=(const Vector3Expr<T, E> &expr)
+{
+    const E &e = expr.self();
+
+    for (unsigned int i = 0; i < m_count; ++i)
+        m_pVectors[i] = m_pVectors[i] - e[i];
+
+    return *this;
+}
+
+template <typename T>
+template <typename E>
+inline Vector3Array<T> &Vector3Array<T>::operator*=(const E &scalar)
+{
+    // 'scalar' is either a T or a ScalarArray<T>.
+    return *this = *this * scalar;
+}
+
+template <typename T>
+inline const Vector3T<T> &Vector3Array<T>::operator[](unsigned int i) const
+{
+    return m_pVectors[i];
+}
+
+template <typename T>
+inline unsigned int Vector3Array<T>::count() const
+{
+    return m_count;
+}
+
+template <typename T>
+inline Vector3T<T> *Vector3Array<T>::data() const
+{
+    return m_pVectors;
+}
+
+//-----------------------------------------------------------------------------
+// Expression nodes. These are created by the operators below and are not
+// meant to be named directly.
+
+template <typename T>
+class Vector3ExprSplat : public Vector3Expr<T, Vector3ExprSplat<T> >
+{
+public:
+    explicit Vector3ExprSplat(const Vector3T<T> &v) : m_v(v) {}
+    const Vector3T<T> &operator[](unsigned int) const { return m_v; }
+
+private:
+    Vector3T<T> m_v;
+};
+
+template <typename T>
+class ScalarExprSplat
+{
+public:
+    explicit ScalarExprSplat(T s) : m_s(s) {}
+    T operator[](unsigned int) const { return m_s; }
+
+private:
+    T m_s;
+};
+
+template <typename T, typename L, typename R>
+class Vector3ExprAdd : public Vector3Expr<T, Vector3ExprAdd<T, L, R> >
+{
+public:
+    Vector3ExprAdd(const L &lhs, const R &rhs) : m_lhs(lhs), m_rhs(rhs) {}
+    Vector3T<T> operator[](unsigned int i) const { return m_lhs[i] + m_rhs[i]; }
+
+private:
+    L m_lhs;
+    R m_rhs;
+};
+
+template <typename T, typename L, typename R>
+class Vector3ExprSub : public Vector3Expr<T, Vector3ExprSub<T, L, R> >
+{
+public:
+    Vector3ExprSub(const L &lhs, const R &rhs) : m_lhs(lhs), m_rhs(rhs) {}
+    Vector3T<T> operator[](unsigned int i) const { return m_lhs[i] - m_rhs[i]; }
+
+private:
+    L m_lhs;
+    R m_rhs;
+};
+
+template <typename T, typename E>
+class Vector3ExprNegate : public Vector3Expr<T, Vector3ExprNegate<T, E> >
+{
+public:
+    explicit Vector3ExprNegate(const E &expr) : m_expr(expr) {}
+    Vector3T<T> operator[](unsigned int i) const { return -m_expr[i]; }
+
+private:
+    E m_expr;
+};
+
+template <typename T, typename E, typename S>
+class Vector3ExprScale : public Vector3Expr<T, Vector3ExprScale<T, E, S> >
+{
+public:
+    Vector3ExprScale(const E &expr, const S &scalar) : m_expr(expr), m_scalar(scalar) {}
+    Vector3T<T> operator[](unsigned int i) const { return m_expr[i] * m_scalar[i]; }
+
+private:
+    E m_expr;
+    S m_scalar;
+};
+
+template <typename T, typename E, typename M>
+class Vector3ExprTransform : public Vector3Expr<T, Vector3ExprTransform<T, E, M> >
+{
+public:
+    Vector3ExprTransform(const E &expr, const M &m) : m_expr(expr), m_m(m) {}
+    Vector3T<T> operator[](unsigned int i) const { return m_expr[i] * m_m; }
+
+private:
+    E m_expr;
+    M m_m;
+};
+
+template <typename T, typename E>
+class Vector3ExprTransformPoint : public Vector3Expr<T, Vector3ExprTransformPoint<T, E> >
+{
+public:
+    Vector3ExprTransformPoint(const Matrix4T<T> &m, const E &expr) : m_m(m), m_expr(expr) {}
+
+    Vector3T<T> operator[](unsigned int i) const
+    {
+        Vector3T<T> p(m_expr[i]);
+
+        return Vector3T<T>((p.x * m_m[0][0]) + (p.y * m_m[1][0]) + (p.z * m_m[2][0]) + m_m[3][0],
+            (p.x * m_m[0][1]) + (p.y * m_m[1][1]) + (p.z * m_m[2][1]) + m_m[3][1],
+            (p.x * m_m[0][2]) + (p.y * m_m[1][2]) + (p.z * m_m[2][2]) + m_m[3][2]);
+    }
+
+private:
+    Matrix4T<T> m_m;
+    E m_expr;
+};
+
+//-----------------------------------------------------------------------------
+// Operators.
+
+template <typename T, typename L, typename R>
+inline Vector3ExprAdd<T, L, R> operator+(const Vector3Expr<T, L> &lhs, const Vector3Expr<T, R> &rhs)
+{
+    return Vector3ExprAdd<T, L, R>(lhs.self(), rhs.self());
+}
+
+template <typename T, typename L>
+inline Vector3ExprAdd<T, L, Vector3ExprSplat<T> > operator+(const Vector3Expr<T, L> &lhs, const Vector3T<T> &rhs)
+{
+    return Vector3ExprAdd<T, L, Vector3ExprSplat<T> >(lhs.self(), Vector3ExprSplat<T>(rhs));
+}
+
+template <typename T, typename R>
+inline Vector3ExprAdd<T, Vector3ExprSplat<T>, R> operator+(const Vector3T<T> &lhs, const Vector3Expr<T, R> &rhs)
+{
+    return Vector3ExprAdd<T, Vector3ExprSplat<T>, R>(Vector3ExprSplat<T>(lhs), rhs.self());
+}
+
+template <typename T, typename L, typename R>
+inline Vector3ExprSub<T, L, R> operator-(const Vector3Expr<T, L> &lhs, const Vector3Expr<T, R> &rhs)
+{
+    return Vector3ExprSub<T, L, R>(lhs.self(), rhs.self());
+}
+
+template <typename T, typename L>
+inline Vector3ExprSub<T, L, Vector3ExprSplat<T> > operator-(const Vector3Expr<T, L> &lhs, const Vector3T<T> &rhs)
+{
+    return Vector3ExprSub<T, L, Vector3ExprSplat<T> >(lhs.self(), Vector3ExprSplat<T>(rhs));
+}
+
+template <typename T, typename R>
+inline Vector3ExprSub<T, Vector3ExprSplat<T>, R> operator-(const Vector3T<T> &lhs, const Vector3Expr<T, R> &rhs)
+{
+    return Vector3ExprSub<T, Vector3ExprSplat<T>, R>(Vector3ExprSplat<T>(lhs), rhs.self());
+}
+
+template <typename T, typename E>
+inline Vector3ExprNegate<T, E> operator-(const Vector3Expr<T, E> &expr)
+{
+    return Vector3ExprNegate<T, E>(expr.self());
+}
+
+template <typename T, typename E>
+inline Vector3ExprScale<T, E, ScalarExprSplat<T> > operator*(const Vector3Expr<T, E> &lhs, T rhs)
+{
+    return Vector3ExprScale<T, E, ScalarExprSplat<T> >(lhs.self(), ScalarExprSplat<T>(rhs));
+}
+
+template <typename T, typename E>
+inline Vector3ExprScale<T, E, ScalarExprSplat<T> > operator*(T lhs, const Vector3Expr<T, E> &rhs)
+{
+    return Vector3ExprScale<T, E, ScalarExprSplat<T> >(rhs.self(), ScalarExprSplat<T>(lhs));
+}
+
+template <typename T, typename E>
+inline Vector3ExprScale<T, E, ScalarArray<T> > operator*(const Vector3Expr<T, E> &lhs, const ScalarArray<T> &rhs)
+{
+    return Vector3ExprScale<T, E, ScalarArray<T> >(lhs.self(), rhs);
+}
+
+template <typename T, typename E>
+inline Vector3ExprScale<T, E, ScalarArray<T> > operator*(const ScalarArray<T> &lhs, const Vector3Expr<T, E> &rhs)
+{
+    return Vector3ExprScale<T, E, ScalarArray<T> >(rhs.self(), lhs);
+}
+
+template <typename T, typename E>
+inline Vector3ExprTransform<T, E, Matrix3T<T> > operator*(const Vector3Expr<T, E> &lhs, const Matrix3T<T> &rhs)
+{
+    return Vector3ExprTransform<T, E, Matrix3T<T> >(lhs.self(), rhs);
+}
+
+template <typename T, typename E>
+inline Vector3ExprTransform<T, E, Matrix4T<T> > operator*(const Vector3Expr<T, E> &lhs, const Matrix4T<T> &rhs)
+{
+    return Vector3ExprTransform<T, E, Matrix4T<T> >(lhs.self(), rhs);
+}
+
+template <typename T, typename E>
+inline Vector3ExprTransformPoint<T, E> transformPoints(const Matrix4T<T> &m, const Vector3Expr<T, E> &points)
+{
+    // Transforms the points as positions (w = 1), so unlike operator* the
+    // translation in row 3 of 'm' is applied.
+    return Vector3ExprTransformPoint<T, E>(m, points.self());
+}
+
+//-----------------------------------------------------------------------------
+
+#endif